@@ -0,0 +1,111 @@
+#include "Atomic.h"
+#include "sync.h"
+
+#include <limits.h>
+
+namespace atomic_wait
+{
+	// Waiters of all addresses hashing to the slot sleep on its epoch, which is bumped by every notification
+	struct alignas(64) slot
+	{
+		atomic_t<u32> epoch{0};
+		atomic_t<u32> waiters{0};
+	};
+
+	static constexpr u32 s_slot_count = 1024;
+
+	static slot s_slots[s_slot_count];
+
+	static slot& get_slot(const void* data)
+	{
+		// Drop the low bits, neighbouring atomics of one object land in the same cache line anyway
+		const u64 ptr = reinterpret_cast<u64>(data);
+		return s_slots[((ptr >> 3) ^ (ptr >> 13) ^ (ptr >> 23)) % s_slot_count];
+	}
+
+#ifdef _WIN32
+	// Windows 8+ only, the futex emulation is used otherwise
+	static utils::dynamic_import<BOOL(volatile VOID*, PVOID, SIZE_T, DWORD)> s_wait_on_address("KernelBase.dll", "WaitOnAddress");
+	static utils::dynamic_import<VOID(PVOID)> s_wake_by_address_all("KernelBase.dll", "WakeByAddressAll");
+#endif
+
+	// Sleep while the epoch is unchanged (spurious wakeups are allowed)
+	static void sleep(slot& s, u32 epoch, u64 usec_timeout)
+	{
+#ifdef _WIN32
+		if (s_wait_on_address)
+		{
+			const DWORD ms = usec_timeout == -1 ? INFINITE : static_cast<DWORD>(std::min<u64>((usec_timeout + 999) / 1000, INFINITE - 1));
+			s_wait_on_address(&s.epoch.raw(), &epoch, sizeof(epoch), ms);
+			return;
+		}
+#endif
+		timespec timeout;
+		timeout.tv_sec  = usec_timeout / 1000000;
+		timeout.tv_nsec = (usec_timeout % 1000000) * 1000;
+
+		futex(reinterpret_cast<int*>(&s.epoch.raw()), FUTEX_WAIT_PRIVATE, epoch, usec_timeout == -1 ? nullptr : &timeout, nullptr, 0);
+	}
+}
+
+bool atomic_wait::wait(const void* data, bool(*check)(const void* data, const void* old), const void* old, u64 usec_timeout)
+{
+	slot& s = get_slot(data);
+
+	const auto start = usec_timeout == -1 ? std::chrono::steady_clock::time_point{} : std::chrono::steady_clock::now();
+
+	// Register first: a notifier which misses the registration must have changed the value before the check below
+	s.waiters++;
+
+	while (true)
+	{
+		const u32 epoch = s.epoch;
+
+		if (!check(data, old))
+		{
+			break;
+		}
+
+		u64 remaining = -1;
+
+		if (usec_timeout != -1)
+		{
+			const u64 passed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+			if (passed >= usec_timeout)
+			{
+				s.waiters--;
+				return false;
+			}
+
+			remaining = usec_timeout - passed;
+		}
+
+		sleep(s, epoch, remaining);
+	}
+
+	s.waiters--;
+	return true;
+}
+
+void atomic_wait::notify_all(const void* data)
+{
+	slot& s = get_slot(data);
+
+	// Cheap when nobody waits, which is the common case
+	if (!s.waiters)
+	{
+		return;
+	}
+
+	s.epoch++;
+
+#ifdef _WIN32
+	if (s_wake_by_address_all)
+	{
+		s_wake_by_address_all(&s.epoch.raw());
+		return;
+	}
+#endif
+	futex(reinterpret_cast<int*>(&s.epoch.raw()), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
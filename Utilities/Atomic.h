@@ -2,6 +2,8 @@
 
 #include "types.h"
 
+#include <cstring>
+
 // Helper class, provides access to compiler-specific atomic intrinsics
 template<typename T, std::size_t Size>
 struct atomic_storage
@@ -758,6 +760,16 @@ struct atomic_test_and_complement<T1, T2, std::enable_if_t<std::is_integral<T1>:
 	static constexpr auto atomic_op = &atomic_storage<T1>::test_and_complement;
 };
 
+// Address-based waiting (futex-like), waiters are kept in a fixed hashed table so any address can be waited on
+namespace atomic_wait
+{
+	// Block while check(data, old) returns true, until notified or until the timeout (in microseconds) expires. Returns false on timeout.
+	bool wait(const void* data, bool(*check)(const void* data, const void* old), const void* old, u64 usec_timeout);
+
+	// Wake the threads waiting on data (waiters of other addresses sharing the slot may wake up spuriously)
+	void notify_all(const void* data);
+}
+
 // Atomic type with lock-free and standard layout guarantees (and appropriate limitations)
 template<typename T>
 class atomic_t
@@ -1039,6 +1051,28 @@ public:
 		return atomic_op(atomic_test_and_complement<type, T2>{}, rhs);
 	}
 
+	// Block until the value is not equal to old_value (compared bitwise) or the timeout expires, returns false on timeout
+	bool wait(const type& old_value, u64 usec_timeout = -1) const
+	{
+		return atomic_wait::wait(&m_data, [](const void* data, const void* old)
+		{
+			const type value = atomic_storage<type>::load(*static_cast<const type*>(data));
+			return std::memcmp(&value, old, sizeof(type)) == 0;
+		}, &old_value, usec_timeout);
+	}
+
+	// Wake at least one thread waiting on this object (all of them currently, callers must not rely on it)
+	void notify_one()
+	{
+		atomic_wait::notify_all(&m_data);
+	}
+
+	// Wake all threads waiting on this object
+	void notify_all()
+	{
+		atomic_wait::notify_all(&m_data);
+	}
+
 	// Minimal pointer support (TODO: must forward operator ->())
 	type operator ->() const
 	{
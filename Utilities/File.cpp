@@ -8,6 +8,7 @@
 #include <algorithm>
 #include <cstring>
 #include <cerrno>
+#include <climits>
 #include <typeinfo>
 
 using namespace std::literals::string_literals;
@@ -124,6 +125,7 @@ static fs::error to_error(DWORD e)
 #include <sys/types.h>
 #include <sys/statvfs.h>
 #include <sys/file.h>
+#include <sys/uio.h>
 #include <dirent.h>
 #include <fcntl.h>
 #include <libgen.h>
@@ -191,6 +193,52 @@ namespace fs
 		// Do notning
 	}
 
+	u64 file_base::read_at(u64 offset, void* buffer, u64 size)
+	{
+		const u64 old_pos = seek(0, seek_cur);
+		seek(offset, seek_set);
+		const u64 result = read(buffer, size);
+		seek(old_pos, seek_set);
+		return result;
+	}
+
+	u64 file_base::write_at(u64 offset, const void* buffer, u64 size)
+	{
+		const u64 old_pos = seek(0, seek_cur);
+		seek(offset, seek_set);
+		const u64 result = write(buffer, size);
+		seek(old_pos, seek_set);
+		return result;
+	}
+
+	bool file_base::is_positional()
+	{
+		return false;
+	}
+
+	u64 file_base::read_v(u64 offset, const io_buffer* buffers, std::size_t count)
+	{
+		u64 result = 0;
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			const u64 nread = read_at(offset + result, buffers[i].data, buffers[i].size);
+			result += nread;
+
+			if (nread < buffers[i].size)
+			{
+				break;
+			}
+		}
+
+		return result;
+	}
+
+	const void* file_base::view(u64 offset, u64 size)
+	{
+		return nullptr;
+	}
+
 	dir_base::~dir_base()
 	{
 	}
@@ -1048,6 +1096,48 @@ fs::file::file(const std::string& path, bs_t<open_mode> mode)
 			return result;
 		}
 
+		u64 read_at(u64 offset, void* buffer, u64 count) override
+		{
+			const auto result = ::pread(m_fd, buffer, count, offset);
+			verify("file::read_at" HERE), result != -1;
+
+			return result;
+		}
+
+		u64 write_at(u64 offset, const void* buffer, u64 count) override
+		{
+			const auto result = ::pwrite(m_fd, buffer, count, offset);
+			verify("file::write_at" HERE), result != -1;
+
+			return result;
+		}
+
+		u64 read_v(u64 offset, const io_buffer* buffers, std::size_t count) override
+		{
+			if (count > IOV_MAX)
+			{
+				return file_base::read_v(offset, buffers, count);
+			}
+
+			std::vector<::iovec> vec(count);
+
+			for (std::size_t i = 0; i < count; i++)
+			{
+				vec[i].iov_base = buffers[i].data;
+				vec[i].iov_len = buffers[i].size;
+			}
+
+			const auto result = ::preadv(m_fd, vec.data(), static_cast<int>(count), offset);
+			verify("file::read_v" HERE), result != -1;
+
+			return result;
+		}
+
+		bool is_positional() override
+		{
+			return true;
+		}
+
 		u64 seek(s64 offset, seek_mode whence) override
 		{
 			const int mode =
@@ -1083,6 +1173,262 @@ fs::file::file(const std::string& path, bs_t<open_mode> mode)
 
 	m_file = std::make_unique<unix_file>(fd);
 #endif
+
+	if (test(mode & fs::mapped) && !test(mode & fs::write))
+	{
+		map_all();
+	}
+}
+
+void fs::file::map_all()
+{
+	const auto getter = dynamic_cast<get_native_handle*>(m_file.get());
+
+	if (!getter)
+	{
+		return;
+	}
+
+	const u64 size = m_file->size();
+
+	if (size == 0 || size != static_cast<std::size_t>(size))
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	const HANDLE mapping = CreateFileMappingW(getter->get(), NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if (!mapping)
+	{
+		return;
+	}
+
+	// The view keeps the mapping object alive
+	const auto ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+
+	if (!ptr)
+	{
+		return;
+	}
+#else
+	const auto ptr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, getter->get(), 0);
+
+	if (ptr == MAP_FAILED)
+	{
+		return;
+	}
+#endif
+
+	// Read-only view over the mapping, the original handle is kept for stat() and get()
+	class mapped_file final : public file_base, public get_native_handle
+	{
+		const std::unique_ptr<file_base> m_base;
+
+		const char* const m_ptr;
+		const u64 m_size;
+
+		u64 m_pos{};
+
+	public:
+		mapped_file(std::unique_ptr<file_base>&& base, const void* ptr, u64 size)
+			: m_base(std::move(base))
+			, m_ptr(static_cast<const char*>(ptr))
+			, m_size(size)
+		{
+		}
+
+		~mapped_file() override
+		{
+#ifdef _WIN32
+			UnmapViewOfFile(m_ptr);
+#else
+			::munmap(const_cast<char*>(m_ptr), m_size);
+#endif
+		}
+
+		stat_t stat() override
+		{
+			return m_base->stat();
+		}
+
+		bool trunc(u64 length) override
+		{
+			return false;
+		}
+
+		u64 read(void* buffer, u64 count) override
+		{
+			if (m_pos < m_size)
+			{
+				// Get readable size
+				if (const u64 result = std::min<u64>(count, m_size - m_pos))
+				{
+					std::memcpy(buffer, m_ptr + m_pos, result);
+					m_pos += result;
+					return result;
+				}
+			}
+
+			return 0;
+		}
+
+		u64 write(const void* buffer, u64 count) override
+		{
+			return 0;
+		}
+
+		u64 read_at(u64 offset, void* buffer, u64 count) override
+		{
+			if (offset < m_size)
+			{
+				const u64 result = std::min<u64>(count, m_size - offset);
+				std::memcpy(buffer, m_ptr + offset, result);
+				return result;
+			}
+
+			return 0;
+		}
+
+		u64 write_at(u64 offset, const void* buffer, u64 count) override
+		{
+			return 0;
+		}
+
+		bool is_positional() override
+		{
+			return true;
+		}
+
+		const void* view(u64 offset, u64 size) override
+		{
+			return offset <= m_size && size <= m_size - offset ? m_ptr + offset : nullptr;
+		}
+
+		u64 seek(s64 offset, fs::seek_mode whence) override
+		{
+			const s64 new_pos =
+				whence == fs::seek_set ? offset :
+				whence == fs::seek_cur ? offset + m_pos :
+				whence == fs::seek_end ? offset + size() :
+				(fmt::raw_error("fs::file::mapped_file::seek(): invalid whence"), 0);
+
+			if (new_pos < 0)
+			{
+				fs::g_tls_error = fs::error::inval;
+				return -1;
+			}
+
+			m_pos = new_pos;
+			return m_pos;
+		}
+
+		u64 size() override
+		{
+			return m_size;
+		}
+
+		native_handle get() override
+		{
+			return dynamic_cast<get_native_handle&>(*m_base).get();
+		}
+	};
+
+	// Preserve the current position of the handle
+	const u64 pos = m_file->seek(0, seek_cur);
+	m_file = std::make_unique<mapped_file>(std::move(m_file), ptr, size);
+	m_file->seek(pos, seek_set);
+}
+
+void fs::file_view::release()
+{
+	if (m_map)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_map);
+#else
+		::munmap(m_map, m_map_size);
+#endif
+		m_map = nullptr;
+	}
+
+	m_copy.reset();
+	m_ptr = nullptr;
+	m_size = 0;
+}
+
+fs::file_view fs::file::map(u64 offset, u64 size) const
+{
+	if (!m_file) xnull();
+
+	file_view result;
+
+	const u64 file_size = m_file->size();
+
+	if (offset >= file_size)
+	{
+		return result;
+	}
+
+	size = std::min<u64>(size, file_size - offset);
+
+	if (!size || size != static_cast<std::size_t>(size))
+	{
+		return result;
+	}
+
+	if (const auto ptr = m_file->view(offset, size))
+	{
+		result.m_ptr = ptr;
+		result.m_size = size;
+		return result;
+	}
+
+	if (const auto getter = dynamic_cast<get_native_handle*>(m_file.get()))
+	{
+#ifdef _WIN32
+		::SYSTEM_INFO info;
+		::GetSystemInfo(&info);
+		const u64 start = offset - offset % info.dwAllocationGranularity;
+
+		if (const HANDLE mapping = CreateFileMappingW(getter->get(), NULL, PAGE_READONLY, 0, 0, NULL))
+		{
+			// The view keeps the mapping object alive
+			const auto ptr = MapViewOfFile(mapping, FILE_MAP_READ, static_cast<DWORD>(start >> 32), static_cast<DWORD>(start), static_cast<std::size_t>(offset - start + size));
+			CloseHandle(mapping);
+
+			if (ptr)
+			{
+				result.m_map = ptr;
+				result.m_map_size = offset - start + size;
+				result.m_ptr = static_cast<const u8*>(ptr) + (offset - start);
+				result.m_size = size;
+				return result;
+			}
+		}
+#else
+		static const u64 s_page_size = ::sysconf(_SC_PAGE_SIZE);
+		const u64 start = offset - offset % s_page_size;
+
+		const auto ptr = ::mmap(nullptr, offset - start + size, PROT_READ, MAP_PRIVATE, getter->get(), start);
+
+		if (ptr != MAP_FAILED)
+		{
+			result.m_map = ptr;
+			result.m_map_size = offset - start + size;
+			result.m_ptr = static_cast<const u8*>(ptr) + (offset - start);
+			result.m_size = size;
+			return result;
+		}
+#endif
+	}
+
+	// Fall back to a copy
+	result.m_copy.reset(new u8[size]);
+	result.m_size = m_file->read_at(offset, result.m_copy.get(), size);
+	result.m_ptr = result.m_copy.get();
+	return result;
 }
 
 fs::file::file(const void* ptr, std::size_t size)
@@ -1127,6 +1473,11 @@ fs::file::file(const void* ptr, std::size_t size)
 			return 0;
 		}
 
+		const void* view(u64 offset, u64 size) override
+		{
+			return offset <= m_size && size <= m_size - offset ? m_ptr + offset : nullptr;
+		}
+
 		u64 seek(s64 offset, fs::seek_mode whence) override
 		{
 			const s64 new_pos =
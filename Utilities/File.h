@@ -27,6 +27,7 @@ namespace fs
 		excl,
 		lock,
 		unread,
+		mapped,
 
 		__bitset_enum_max
 	};
@@ -39,6 +40,7 @@ namespace fs
 	constexpr auto excl    = +open_mode::excl; // Failure if the file already exists (used with `create`)
 	constexpr auto lock    = +open_mode::lock; // Prevent opening the file more than once
 	constexpr auto unread  = +open_mode::unread; // Aggressively prevent reading the opened file (do not use)
+	constexpr auto mapped  = +open_mode::mapped; // Serve reads from a memory mapping of the file (read-only, ignored otherwise)
 
 	constexpr auto rewrite = open_mode::write + open_mode::create + open_mode::trunc;
 
@@ -65,6 +67,13 @@ namespace fs
 		s64 ctime;
 	};
 
+	// Destination buffer of a vectored read
+	struct io_buffer
+	{
+		void* data;
+		u64 size;
+	};
+
 	// Native handle getter
 	struct get_native_handle
 	{
@@ -83,6 +92,19 @@ namespace fs
 		virtual u64 write(const void* buffer, u64 size) = 0;
 		virtual u64 seek(s64 offset, seek_mode whence) = 0;
 		virtual u64 size() = 0;
+
+		// Positional I/O, the default implementation goes through seek() and needs external synchronization
+		virtual u64 read_at(u64 offset, void* buffer, u64 size);
+		virtual u64 write_at(u64 offset, const void* buffer, u64 size);
+
+		// Check whether read_at/write_at leave the file position alone and may be called concurrently
+		virtual bool is_positional();
+
+		// Read consecutive data at specified offset into several buffers, the default implementation calls read_at()
+		virtual u64 read_v(u64 offset, const io_buffer* buffers, std::size_t count);
+
+		// Get pointer to the file contents if they are already in memory (nullptr otherwise)
+		virtual const void* view(u64 offset, u64 size);
 	};
 
 	// Directory entry (TODO)
@@ -175,6 +197,74 @@ namespace fs
 	// Set file access/modification time
 	bool utime(const std::string& path, s64 atime, s64 mtime);
 
+	// Read-only view of a file range: borrowed from an in-memory file, a memory mapping or a copy as the last resort
+	class file_view final
+	{
+		const void* m_ptr = nullptr;
+		u64 m_size = 0;
+
+		// Own mapping (start of the mapped range and its size)
+		void* m_map = nullptr;
+		u64 m_map_size = 0;
+
+		std::unique_ptr<u8[]> m_copy;
+
+		friend class file;
+
+		void release();
+
+	public:
+		file_view() = default;
+
+		file_view(file_view&& other)
+			: m_ptr(other.m_ptr)
+			, m_size(other.m_size)
+			, m_map(other.m_map)
+			, m_map_size(other.m_map_size)
+			, m_copy(std::move(other.m_copy))
+		{
+			other.m_ptr = nullptr;
+			other.m_map = nullptr;
+		}
+
+		file_view& operator=(file_view&& other)
+		{
+			if (this != &other)
+			{
+				release();
+				m_ptr = other.m_ptr;
+				m_size = other.m_size;
+				m_map = other.m_map;
+				m_map_size = other.m_map_size;
+				m_copy = std::move(other.m_copy);
+				other.m_ptr = nullptr;
+				other.m_map = nullptr;
+			}
+
+			return *this;
+		}
+
+		~file_view()
+		{
+			release();
+		}
+
+		explicit operator bool() const
+		{
+			return m_ptr != nullptr;
+		}
+
+		const u8* data() const
+		{
+			return static_cast<const u8*>(m_ptr);
+		}
+
+		u64 size() const
+		{
+			return m_size;
+		}
+	};
+
 	class file final
 	{
 		std::unique_ptr<file_base> m_file;
@@ -182,6 +272,9 @@ namespace fs
 		[[noreturn]] void xnull() const;
 		[[noreturn]] void xfail() const;
 
+		// Replace the opened handle with a memory-mapped view if possible
+		void map_all();
+
 	public:
 		// Default constructor
 		file() = default;
@@ -257,6 +350,38 @@ namespace fs
 			return m_file->write(buffer, count);
 		}
 
+		// Read the data at specified offset, the file position is preserved
+		u64 read_at(u64 offset, void* buffer, u64 count) const
+		{
+			if (!m_file) xnull();
+			return m_file->read_at(offset, buffer, count);
+		}
+
+		// Write the data at specified offset, the file position is preserved
+		u64 write_at(u64 offset, const void* buffer, u64 count) const
+		{
+			if (!m_file) xnull();
+			return m_file->write_at(offset, buffer, count);
+		}
+
+		// Read consecutive data at specified offset into several buffers, the file position is preserved
+		u64 read_v(u64 offset, const io_buffer* buffers, std::size_t count) const
+		{
+			if (!m_file) xnull();
+			return m_file->read_v(offset, buffers, count);
+		}
+
+		// Get read-only view of the range (clamped to the file size), the file must outlive views borrowed from it.
+		// Views of regular files are mapped without touching the file position, so they're thread-safe.
+		file_view map(u64 offset, u64 size) const;
+
+		// Check whether positional I/O is thread-safe for this file
+		bool is_positional() const
+		{
+			if (!m_file) xnull();
+			return m_file->is_positional();
+		}
+
 		// Change current position, returns resulting position
 		u64 seek(s64 offset, seek_mode whence = seek_set) const
 		{
@@ -603,6 +728,12 @@ namespace fs
 		{
 			return obj.size();
 		}
+
+		const void* view(u64 offset, u64 size) override
+		{
+			// Contiguous containers only
+			return offset <= obj.size() && size <= obj.size() - offset ? obj.data() + offset : nullptr;
+		}
 	};
 
 	template <typename T>
@@ -21,6 +21,9 @@ extern void ppu_remove_breakpoint(u32 addr);
 
 logs::channel gdbDebugServer("gdbDebugServer");
 
+//advertised in qSupported, bounds the packets client sends and the data it asks for
+static const u32 max_packet_size = 0x20000;
+
 int sock_init(void)
 {
 #ifdef _WIN32
@@ -156,12 +159,14 @@ int GDBDebugServer::read(void * buf, int cnt)
 
 char GDBDebugServer::read_char()
 {
-	char result;
-	int cnt = read(&result, 1);
-	if (!cnt) {
-		fmt::throw_exception("Tried to read char, but no data was available" HERE);
+	if (recv_pos == recv_len) {
+		recv_pos = 0;
+		recv_len = read(recv_buf, sizeof(recv_buf));
+		if (!recv_len) {
+			fmt::throw_exception("Tried to read char, but no data was available" HERE);
+		}
 	}
-	return result;
+	return recv_buf[recv_pos++];
 }
 
 u8 GDBDebugServer::read_hexbyte()
@@ -203,10 +208,11 @@ void GDBDebugServer::try_read_cmd(gdb_cmd & out_cmd)
 			break;
 		}
 		checksum = (checksum + reinterpret_cast<u8&>(c)) % 256;
-		//escaped char
+		//escaped char, checksum covers the escaped form
 		if (c == '}') {
-			c = read_char() ^ 0x20;
+			c = read_char();
 			checksum = (checksum + reinterpret_cast<u8&>(c)) % 256;
+			c ^= 0x20;
 		}
 		//cmd-data splitters
 		if (cmd_part && ((c == ':') || (c == '.') || (c == ';'))) {
@@ -249,7 +255,7 @@ bool GDBDebugServer::read_cmd(gdb_cmd & out_cmd)
 void GDBDebugServer::send(const char * buf, int cnt)
 {
 	gdbDebugServer.trace("Sending %s (%d bytes)", buf, cnt);
-	while (!stop) {
+	while (!stop && cnt) {
 		int res = ::send(client_socket, buf, cnt, 0);
 		if (res == SOCKET_ERROR) {
 			if (check_errno_again()) {
@@ -259,7 +265,9 @@ void GDBDebugServer::send(const char * buf, int cnt)
 			gdbDebugServer.error("Failed sending %d bytes", cnt);
 			return;
 		}
-		return;
+		//large packets may be sent in parts
+		buf += res;
+		cnt -= res;
 	}
 }
 
@@ -306,7 +314,8 @@ bool GDBDebugServer::send_cmd_ack(const std::string & cmd)
 u8 GDBDebugServer::append_encoded_char(char c, std::string & str)
 {
 	u8 checksum = 0;
-	if (UNLIKELY((c == '#') || (c == '$') || (c == '}'))) {
+	//'*' starts run-length encoding in replies
+	if (UNLIKELY((c == '#') || (c == '$') || (c == '}') || (c == '*'))) {
 		str += '}';
 		c ^= 0x20;
 		checksum = '}';
@@ -431,6 +440,11 @@ bool GDBDebugServer::send_reason()
 
 void GDBDebugServer::wait_with_interrupts() {
 	char c;
+	while (!paused && recv_pos < recv_len) {
+		if (recv_buf[recv_pos++] == 0x03) {
+			paused = true;
+		}
+	}
 	while (!paused) {
 		int result = recv(client_socket, &c, 1, 0);
 
@@ -460,7 +474,8 @@ bool GDBDebugServer::cmd_reason(gdb_cmd & cmd)
 
 bool GDBDebugServer::cmd_supported(gdb_cmd & cmd)
 {
-	return send_cmd_ack("PacketSize=1200");
+	binary_upload = cmd.data.find("binary-upload+") != std::string::npos;
+	return send_cmd_ack(fmt::format("PacketSize=%x;binary-upload+", max_packet_size));
 }
 
 bool GDBDebugServer::cmd_thread_info(gdb_cmd & cmd)
@@ -533,25 +548,60 @@ bool GDBDebugServer::cmd_write_register(gdb_cmd & cmd)
 	return send_cmd_ack("");
 }
 
+void GDBDebugServer::read_memory(u32 addr, u32 len, std::string& out)
+{
+	//threads may write memory while emulation runs
+	const bool use_cache = Emu.IsPaused();
+	if (!use_cache) {
+		read_cache.clear();
+	}
+	while (len) {
+		const u32 page = addr & ~0xfff;
+		const u32 offset = addr - page;
+		const u32 size = std::min<u32>(len, 0x1000 - offset);
+		const u8* src;
+		if (use_cache) {
+			auto& data = read_cache[page];
+			if (!data) {
+				if (!vm::check_addr(page, 0x1000, vm::page_allocated | vm::page_readable)) {
+					read_cache.erase(page);
+					return;
+				}
+				data = std::make_unique<u8[]>(0x1000);
+				std::memcpy(data.get(), vm::base(page), 0x1000);
+			}
+			src = data.get() + offset;
+		} else {
+			if (!vm::check_addr(addr, size, vm::page_allocated | vm::page_readable)) {
+				return;
+			}
+			src = vm::_ptr<u8>(addr);
+		}
+		out.append(reinterpret_cast<const char*>(src), size);
+		addr += size;
+		len -= size;
+	}
+}
+
 bool GDBDebugServer::cmd_read_memory(gdb_cmd & cmd)
 {
 	size_t s = cmd.data.find(',');
 	u32 addr = hex_to_u32(cmd.data.substr(0, s));
-	u32 len = hex_to_u32(cmd.data.substr(s + 1));
-	std::string result;
-	result.reserve(len * 2);
-	for (u32 i = 0; i < len; ++i) {
-		if (vm::check_addr(addr, 1, vm::page_allocated | vm::page_readable)) {
-			result += to_hexbyte(vm::read8(addr + i));
-		} else {
-			break;
-			//result += "xx";
-		}
-	}
-	if (len && !result.length()) {
+	u32 len = std::min(hex_to_u32(cmd.data.substr(s + 1)), max_packet_size / 2);
+	std::string data;
+	data.reserve(len);
+	read_memory(addr, len, data);
+	if (len && !data.length()) {
 		//nothing read
 		return send_cmd_ack("E01");
 	}
+	static const char hex_digits[] = "0123456789abcdef";
+	std::string result(data.length() * 2, '0');
+	for (size_t i = 0; i < data.length(); ++i) {
+		const u8 v = data[i];
+		result[i * 2] = hex_digits[v >> 4];
+		result[i * 2 + 1] = hex_digits[v & 0xf];
+	}
 	return send_cmd_ack(result);
 }
 
@@ -566,6 +616,7 @@ bool GDBDebugServer::cmd_write_memory(gdb_cmd & cmd)
 	u32 addr = hex_to_u32(cmd.data.substr(0, s));
 	u32 len = hex_to_u32(cmd.data.substr(s + 1, s2 - s - 1));
 	const char* data_ptr = (cmd.data.c_str()) + s2 + 1;
+	read_cache.clear();
 	for (u32 i = 0; i < len; ++i) {
 		if (vm::check_addr(addr + i, 1, vm::page_allocated | vm::page_writable)) {
 			u8 val;
@@ -583,6 +634,49 @@ bool GDBDebugServer::cmd_write_memory(gdb_cmd & cmd)
 	return send_cmd_ack("OK");
 }
 
+bool GDBDebugServer::cmd_read_memory_binary(gdb_cmd & cmd)
+{
+	size_t s = cmd.data.find(',');
+	if (s == std::string::npos) {
+		gdbDebugServer.warning("Malformed binary read memory request received: %s", cmd.data.c_str());
+		return send_cmd_ack("E01");
+	}
+	u32 addr = hex_to_u32(cmd.data.substr(0, s));
+	//escaping may double reply size
+	u32 len = std::min(hex_to_u32(cmd.data.substr(s + 1)), max_packet_size / 2);
+	std::string result = binary_upload ? "b" : "";
+	result.reserve(len + 1);
+	read_memory(addr, len, result);
+	if (len && result.length() == (binary_upload ? 1 : 0)) {
+		//nothing read
+		return send_cmd_ack("E01");
+	}
+	return send_cmd_ack(result);
+}
+
+bool GDBDebugServer::cmd_write_memory_binary(gdb_cmd & cmd)
+{
+	size_t s = cmd.data.find(',');
+	size_t s2 = cmd.data.find(':');
+	if ((s == std::string::npos) || (s2 == std::string::npos)) {
+		gdbDebugServer.warning("Malformed binary write memory request received");
+		return send_cmd_ack("E01");
+	}
+	u32 addr = hex_to_u32(cmd.data.substr(0, s));
+	u32 len = hex_to_u32(cmd.data.substr(s + 1, s2 - s - 1));
+	if (cmd.data.length() - s2 - 1 != len) {
+		gdbDebugServer.warning("Binary write memory request has %d bytes of data, expected %d", cmd.data.length() - s2 - 1, len);
+		return send_cmd_ack("E02");
+	}
+	//zero length write is used by client to probe support
+	if (len && !vm::check_addr(addr, len, vm::page_allocated | vm::page_writable)) {
+		return send_cmd_ack("E03");
+	}
+	read_cache.clear();
+	std::memcpy(vm::base(addr), cmd.data.data() + s2 + 1, len);
+	return send_cmd_ack("OK");
+}
+
 bool GDBDebugServer::cmd_read_all_registers(gdb_cmd & cmd)
 {
 	std::string result;
@@ -645,6 +739,7 @@ bool GDBDebugServer::cmd_attached_to_what(gdb_cmd & cmd)
 
 bool GDBDebugServer::cmd_kill(gdb_cmd & cmd)
 {
+	read_cache.clear();
 	Emu.Stop();
 	return true;
 }
@@ -662,6 +757,7 @@ bool GDBDebugServer::cmd_vcont(gdb_cmd & cmd)
 		select_thread(continue_ops_thread_id);
 		auto ppu = std::static_pointer_cast<ppu_thread>(selected_thread.lock());
 		paused = false;
+		read_cache.clear();
 		if (cmd.data[1] == 's') {
 			ppu->state += cpu_flag::dbg_step;
 		}
@@ -753,6 +849,10 @@ void GDBDebugServer::on_task()
 			gdbDebugServer.error("Could not establish new connection\n");
 			return;
 		}
+		recv_pos = 0;
+		recv_len = 0;
+		binary_upload = false;
+		read_cache.clear();
 		//stop immediately
 		if (Emu.IsRunning()) {
 			Emu.Pause();
@@ -779,6 +879,8 @@ void GDBDebugServer::on_task()
 				PROCESS_CMD("P", cmd_write_register);
 				PROCESS_CMD("m", cmd_read_memory);
 				PROCESS_CMD("M", cmd_write_memory);
+				PROCESS_CMD("x", cmd_read_memory_binary);
+				PROCESS_CMD("X", cmd_write_memory_binary);
 				PROCESS_CMD("g", cmd_read_all_registers);
 				PROCESS_CMD("G", cmd_write_all_registers);
 				PROCESS_CMD("H", cmd_set_thread_ops);
@@ -7,6 +7,8 @@
 #include "Emu/CPU/CPUThread.h"
 #include "Emu/Cell/PPUThread.h"
 
+#include <unordered_map>
+
 #ifdef _WIN32
 #include <winsock2.h>
 #include <WS2tcpip.h>
@@ -47,6 +49,16 @@ class GDBDebugServer : public named_thread {
 	std::weak_ptr<cpu_thread> selected_thread;
 	u64 continue_ops_thread_id = ANY_THREAD;
 	u64 general_ops_thread_id = ANY_THREAD;
+	//client understands 'b' prefixed replies to x packets
+	bool binary_upload = false;
+
+	//received bytes not consumed yet
+	char recv_buf[4096];
+	int recv_pos = 0;
+	int recv_len = 0;
+
+	//snapshots of guest pages by address, only valid while emulation is paused
+	std::unordered_map<u32, std::unique_ptr<u8[]>> read_cache;
 
 	//initialize server socket and start listening
 	void start_server();
@@ -70,6 +82,8 @@ class GDBDebugServer : public named_thread {
 	void send_char(char c);
 	//acknowledge packet, either as accepted or declined
 	void ack(bool accepted);
+	//appends up to len bytes of guest memory at addr to out, stops at the first unreadable page
+	void read_memory(u32 addr, u32 len, std::string& out);
 	//sends command body cmd to client
 	void send_cmd(const std::string & cmd);
 	//sends command to client until receives positive acknowledgement
@@ -102,6 +116,8 @@ class GDBDebugServer : public named_thread {
 	bool cmd_write_register(gdb_cmd& cmd);
 	bool cmd_read_memory(gdb_cmd& cmd);
 	bool cmd_write_memory(gdb_cmd& cmd);
+	bool cmd_read_memory_binary(gdb_cmd& cmd);
+	bool cmd_write_memory_binary(gdb_cmd& cmd);
 	bool cmd_read_all_registers(gdb_cmd& cmd);
 	bool cmd_write_all_registers(gdb_cmd& cmd);
 	bool cmd_set_thread_ops(gdb_cmd& cmd);
@@ -43,8 +43,11 @@ void asmjit::build_transaction_abort(asmjit::X86Assembler& c, unsigned char code
 #include "Log.h"
 #include "mutex.h"
 #include "sysinfo.h"
+#include "hash.h"
 #include "VirtualMemory.h"
 
+#include <zlib.h>
+
 #ifdef _MSC_VER
 #pragma warning(push, 0)
 #endif
@@ -127,6 +130,7 @@ extern void jit_finalize()
 
 	utils::memory_decommit(s_memory, s_memory_size);
 
+	utils::memory_account(utils::memory_class::jit_code, -static_cast<s64>((u64)s_next - (u64)s_memory));
 	s_next = s_memory;
 }
 
@@ -180,6 +184,7 @@ struct MemoryManager : llvm::RTDyldMemoryManager
 			{
 				m_tramps = reinterpret_cast<decltype(m_tramps)>(s_next);
 				utils::memory_commit(s_next, 4096, utils::protection::wx);
+				utils::memory_account(utils::memory_class::jit_code, 4096);
 				s_next = (u8*)((u64)s_next + 4096);
 			}
 
@@ -221,6 +226,7 @@ struct MemoryManager : llvm::RTDyldMemoryManager
 		}
 
 		utils::memory_commit(s_next, size, utils::protection::wx);
+		utils::memory_account(utils::memory_class::jit_code, next - (u64)s_next);
 		m_code_addr = (u8*)s_next;
 
 		LOG_NOTICE(GENERAL, "LLVM: Code section %u '%s' allocated -> %p (size=0x%llx, aligned 0x%x)", sec_id, sec_name.data(), s_next, size, align);
@@ -247,6 +253,7 @@ struct MemoryManager : llvm::RTDyldMemoryManager
 		}
 
 		utils::memory_commit(s_next, size);
+		utils::memory_account(utils::memory_class::jit_code, next - (u64)s_next);
 
 		LOG_NOTICE(GENERAL, "LLVM: Data section %u '%s' allocated -> %p (size=0x%llx, aligned 0x%x, %s)", sec_id, sec_name.data(), s_next, size, align, is_ro ? "ro" : "rw");
 		return (u8*)std::exchange(s_next, (void*)next);
@@ -442,6 +449,25 @@ struct EventListener : llvm::JITEventListener
 	}
 };
 
+// Compress newly written objects (set on boot from the config)
+static atomic_t<bool> s_compress_objects{false};
+
+extern void jit_set_object_compression(bool enable)
+{
+	s_compress_objects = enable;
+}
+
+// Header of a compressed object file (uncompressed objects are stored as is)
+struct object_header
+{
+	char magic[8]; // "RPCSZOBJ"
+	u64 size; // Uncompressed size
+	u32 crc; // CRC-32C of the uncompressed object
+	u32 reserved;
+};
+
+static const char s_object_magic[8]{'R', 'P', 'C', 'S', 'Z', 'O', 'B', 'J'};
+
 // Helper class
 class ObjectCache final : public llvm::ObjectCache
 {
@@ -459,20 +485,87 @@ public:
 	{
 		std::string name = m_path;
 		name.append(module->getName());
-		fs::file(name, fs::rewrite).write(obj.getBufferStart(), obj.getBufferSize());
+
+		if (!save(name, obj.getBufferStart(), obj.getBufferSize()))
+		{
+			LOG_ERROR(GENERAL, "LLVM: Failed to save module: %s (%s)", module->getName().data(), fs::g_tls_error);
+			return;
+		}
+
 		LOG_NOTICE(GENERAL, "LLVM: Created module: %s", module->getName().data());
 	}
 
+	static bool save(const std::string& path, const char* data, std::size_t size)
+	{
+		std::vector<u8> packed;
+
+		if (s_compress_objects)
+		{
+			uLongf bound = ::compressBound(static_cast<uLong>(size));
+			packed.resize(sizeof(object_header) + bound);
+
+			if (::compress2(packed.data() + sizeof(object_header), &bound, reinterpret_cast<const Bytef*>(data), static_cast<uLong>(size), Z_BEST_SPEED) == Z_OK &&
+				sizeof(object_header) + bound < size)
+			{
+				object_header header{};
+				std::memcpy(header.magic, s_object_magic, sizeof(s_object_magic));
+				header.size = size;
+				header.crc = rpcs3::crc32c(data, size);
+				std::memcpy(packed.data(), &header, sizeof(header));
+				packed.resize(sizeof(object_header) + bound);
+				data = reinterpret_cast<const char*>(packed.data());
+				size = packed.size();
+			}
+		}
+
+		// Write to a temporary file first so that an interrupted write never leaves a truncated object behind
+		const std::string tmp = path + ".tmp";
+
+		fs::file file(tmp, fs::rewrite);
+
+		if (!file || file.write(data, size) != size)
+		{
+			file.close();
+			fs::remove_file(tmp);
+			return false;
+		}
+
+		file.close();
+		return fs::rename(tmp, path, true);
+	}
+
 	static std::unique_ptr<llvm::MemoryBuffer> load(const std::string& path)
 	{
-		if (fs::file cached{path, fs::read})
+		// Let LLVM map the file in memory where possible (no null terminator required)
+		auto file = llvm::MemoryBuffer::getFile(path, -1, false);
+
+		if (!file)
+		{
+			return nullptr;
+		}
+
+		std::unique_ptr<llvm::MemoryBuffer> buf = std::move(file.get());
+
+		if (buf->getBufferSize() < sizeof(object_header) || std::memcmp(buf->getBufferStart(), s_object_magic, sizeof(s_object_magic)) != 0)
 		{
-			auto buf = llvm::WritableMemoryBuffer::getNewUninitMemBuffer(cached.size());
-			cached.read(buf->getBufferStart(), buf->getBufferSize());
 			return buf;
 		}
 
-		return nullptr;
+		object_header header;
+		std::memcpy(&header, buf->getBufferStart(), sizeof(header));
+
+		auto out = llvm::WritableMemoryBuffer::getNewUninitMemBuffer(header.size);
+		uLongf size = static_cast<uLongf>(header.size);
+
+		if (::uncompress(reinterpret_cast<Bytef*>(out->getBufferStart()), &size, reinterpret_cast<const Bytef*>(buf->getBufferStart()) + sizeof(header), static_cast<uLong>(buf->getBufferSize() - sizeof(header))) != Z_OK ||
+			size != header.size ||
+			rpcs3::crc32c(out->getBufferStart(), size) != header.crc)
+		{
+			LOG_ERROR(GENERAL, "LLVM: Corrupted object file: %s", path);
+			return nullptr;
+		}
+
+		return out;
 	}
 
 	std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* module) override
@@ -529,7 +622,7 @@ std::string jit_compiler::cpu(const std::string& _cpu)
 	return m_cpu;
 }
 
-jit_compiler::jit_compiler(const std::unordered_map<std::string, u64>& _link, const std::string& _cpu, bool large)
+jit_compiler::jit_compiler(const std::unordered_map<std::string, u64>& _link, const std::string& _cpu, bool large, u32 opt_level)
 	: m_link(_link)
 	, m_cpu(cpu(_cpu))
 {
@@ -542,7 +635,7 @@ jit_compiler::jit_compiler(const std::unordered_map<std::string, u64>& _link, co
 			.setErrorStr(&result)
 			.setEngineKind(llvm::EngineKind::JIT)
 			.setMCJITMemoryManager(std::make_unique<MemoryManager2>())
-			.setOptLevel(llvm::CodeGenOpt::Aggressive)
+			.setOptLevel(static_cast<llvm::CodeGenOpt::Level>(std::min<u32>(opt_level, llvm::CodeGenOpt::Aggressive)))
 			.setCodeModel(large ? llvm::CodeModel::Large : llvm::CodeModel::Small)
 			.setMCPU(m_cpu)
 			.create());
@@ -557,7 +650,7 @@ jit_compiler::jit_compiler(const std::unordered_map<std::string, u64>& _link, co
 			.setErrorStr(&result)
 			.setEngineKind(llvm::EngineKind::JIT)
 			.setMCJITMemoryManager(std::move(mem))
-			.setOptLevel(llvm::CodeGenOpt::Aggressive)
+			.setOptLevel(static_cast<llvm::CodeGenOpt::Level>(std::min<u32>(opt_level, llvm::CodeGenOpt::Aggressive)))
 			.setCodeModel(large ? llvm::CodeModel::Large : llvm::CodeModel::Small)
 			.setMCPU(m_cpu)
 			.create());
@@ -597,6 +690,19 @@ bool jit_compiler::has_ssse3() const
 	return true;
 }
 
+bool jit_compiler::has_avx512vbmi() const
+{
+	if (m_cpu == "cannonlake" ||
+		m_cpu == "icelake" ||
+		m_cpu == "icelake-client" ||
+		m_cpu == "icelake-server")
+	{
+		return true;
+	}
+
+	return false;
+}
+
 void jit_compiler::add(std::unique_ptr<llvm::Module> module, const std::string& path)
 {
 	ObjectCache cache{path};
@@ -629,7 +735,14 @@ void jit_compiler::add(std::unique_ptr<llvm::Module> module)
 
 void jit_compiler::add(const std::string& path)
 {
-	m_engine->addObjectFile(std::move(llvm::object::ObjectFile::createObjectFile(*ObjectCache::load(path)).get()));
+	auto buf = ObjectCache::load(path);
+
+	if (!buf)
+	{
+		fmt::throw_exception("LLVM: Failed to load object file: %s" HERE, path);
+	}
+
+	m_engine->addObjectFile(std::move(llvm::object::ObjectFile::createObjectFile(*buf).get()));
 }
 
 void jit_compiler::fin()
@@ -657,6 +770,7 @@ std::unordered_map<std::string, u64> jit_compiler::add(std::unordered_map<std::s
 	}
 
 	utils::memory_commit(s_next, size, utils::protection::wx);
+	utils::memory_account(utils::memory_class::jit_code, ::align(size, 4096));
 	std::memset(s_next, 0xc3, ::align(size, 4096));
 
 	for (auto&& pair : data)
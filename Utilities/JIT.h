@@ -97,7 +97,7 @@ class jit_compiler final
 	std::string m_cpu;
 
 public:
-	jit_compiler(const std::unordered_map<std::string, u64>& _link, const std::string& _cpu, bool large = false);
+	jit_compiler(const std::unordered_map<std::string, u64>& _link, const std::string& _cpu, bool large = false, u32 opt_level = 3);
 	~jit_compiler();
 
 	// Get LLVM context
@@ -114,6 +114,9 @@ public:
 	// Test SSSE3 feature
 	bool has_ssse3() const;
 
+	// Test AVX-512 VBMI feature (and AVX-512 VL)
+	bool has_avx512vbmi() const;
+
 	// Add module (path to obj cache dir)
 	void add(std::unique_ptr<llvm::Module> module, const std::string& path);
 
@@ -8,6 +8,8 @@
 #include "rpcs3_version.h"
 #include <string>
 #include <unordered_map>
+#include <algorithm>
+#include <cstring>
 #include <thread>
 #include <chrono>
 
@@ -79,9 +81,19 @@ namespace logs
 
 		uchar m_zout[65536];
 
+		// Formatted deferred message
+		std::string m_text;
+		std::vector<u64> m_args;
+
 		// Write buffered logs immediately
 		bool flush(u64 bufv);
 
+		// Copy data from the buffer (handles wrapping)
+		void read(u64 pos, void* dst, std::size_t size) const;
+
+		// Format deferred message into m_text, return its size in the buffer
+		u64 decode(u64 pos);
+
 	public:
 		file_writer(const std::string& name);
 
@@ -89,8 +101,27 @@ namespace logs
 
 		// Append raw data
 		void log(logs::level sev, const char* text, std::size_t size);
+
+		// Change compression level of the .gz log
+		void set_compression(int level);
 	};
 
+	// Deferred message, followed by arguments and thread prefix (the format string and type info are static)
+	struct deferred_record
+	{
+		u8 marker; // Always 0, which never occurs in text
+		u8 sev;
+		u16 prefix_size;
+		u32 argc;
+		u64 stamp;
+		channel* ch;
+		fmt::format_desc fmt;
+		const fmt_type_info* sup;
+	};
+
+	// Encode level, current thread name, channel name and message text
+	static void append_line(std::string& text, u64 stamp, const message& msg, const std::string& prefix, const std::string& str);
+
 	struct channel_info
 	{
 		channel* pointer = nullptr;
@@ -124,6 +155,9 @@ namespace logs
 		// Encode level, current thread name, channel name and write log message
 		virtual void log(u64 stamp, const message& msg, const std::string& prefix, const std::string& text) override;
 
+		// Store message with plain arguments, it will be formatted by the writer
+		void log_deferred(u64 stamp, const message& msg, const std::string& prefix, const fmt::format_desc& fmt, const fmt_type_info* sup, const u64* args, u32 argc);
+
 		// Channel registry
 		std::unordered_map<std::string, channel_info> channels;
 
@@ -185,6 +219,9 @@ namespace logs
 	// Must be set to true in main()
 	atomic_t<bool> g_init{false};
 
+	// Deferred formatting of messages only written to the log file
+	atomic_t<bool> g_deferred{false};
+
 	void reset()
 	{
 		semaphore_lock lock(g_mutex);
@@ -202,6 +239,16 @@ namespace logs
 		get_logger()->channels[ch_name].set_level(value);
 	}
 
+	void set_deferred(bool value)
+	{
+		g_deferred = value;
+	}
+
+	void set_compression(int value)
+	{
+		get_logger()->set_compression(value);
+	}
+
 	// Must be called in main() to stop accumulating messages in g_messages
 	void set_init()
 	{
@@ -238,7 +285,7 @@ void logs::listener::add(logs::listener* _new)
 	}
 }
 
-void logs::message::broadcast(const char* fmt, const fmt_type_info* sup, const u64* args)
+void logs::message::broadcast(const fmt::format_desc& fmt, const fmt_type_info* sup, const u64* args)
 {
 	// Get timestamp
 	const u64 stamp = get_stamp();
@@ -267,14 +314,39 @@ void logs::message::broadcast(const char* fmt, const fmt_type_info* sup, const u
 		}
 	}
 
-	// Get text
-	thread_local std::string text; text.clear();
-	fmt::raw_append(text, fmt, sup, args);
 	std::string prefix = g_tls_log_prefix();
 
 	// Get first (main) listener
 	listener* lis = get_logger();
 
+	if (g_deferred && g_init)
+	{
+		u32 argc = 0;
+
+		while (sup[argc].fmt_string && sup[argc].by_value)
+		{
+			argc++;
+		}
+
+		// Only defer when all arguments are plain values and nothing else needs the text now
+		bool used = !argc || sup[argc].fmt_string;
+
+		for (listener* next = lis->m_next; !used && next; next = next->m_next)
+		{
+			used = next->accepts(*this);
+		}
+
+		if (!used)
+		{
+			get_logger()->log_deferred(stamp, *this, prefix, fmt, sup, args, argc);
+			return;
+		}
+	}
+
+	// Get text
+	thread_local std::string text; text.clear();
+	fmt::raw_append(text, fmt, sup, args);
+
 	if (!g_init)
 	{
 		semaphore_lock lock(g_mutex);
@@ -475,10 +547,28 @@ bool logs::file_writer::flush(u64 bufv)
 	if (end > st)
 	{
 		// Avoid writing too big fragments
-		const u64 size = std::min<u64>(end - st, sizeof(m_zout) / 2);
+		u64 size = std::min<u64>(end - st, sizeof(m_zout) / 2);
+
+		const uchar* data = m_fptr + st % s_log_size;
+		u64 out_size = size;
+
+		if (const auto rec = static_cast<const uchar*>(std::memchr(data, 0, size)))
+		{
+			if (rec != data)
+			{
+				// Write text preceding the deferred message
+				size = out_size = rec - data;
+			}
+			else
+			{
+				size = decode(st);
+				data = reinterpret_cast<const uchar*>(m_text.data());
+				out_size = m_text.size();
+			}
+		}
 
 		// Write uncompressed
-		if (m_fout && st < m_max_size && m_fout.write(m_fptr + st % s_log_size, size) != size)
+		if (m_fout && st < m_max_size && m_fout.write(data, out_size) != out_size)
 		{
 			m_fout.close();
 		}
@@ -486,8 +576,8 @@ bool logs::file_writer::flush(u64 bufv)
 		// Write compressed
 		if (m_fout2 && st < m_max_size)
 		{
-			m_zs.avail_in = size;
-			m_zs.next_in  = m_fptr + st % s_log_size;
+			m_zs.avail_in = out_size;
+			m_zs.next_in  = const_cast<uchar*>(data);
 
 			do
 			{
@@ -511,6 +601,55 @@ bool logs::file_writer::flush(u64 bufv)
 	return false;
 }
 
+void logs::file_writer::read(u64 pos, void* dst, std::size_t size) const
+{
+	const u64 off  = pos % s_log_size;
+	const u64 frag = std::min<u64>(size, s_log_size - off);
+	std::memcpy(dst, m_fptr + off, frag);
+	std::memcpy(static_cast<uchar*>(dst) + frag, m_fptr, size - frag);
+}
+
+u64 logs::file_writer::decode(u64 pos)
+{
+	deferred_record rec;
+	read(pos, &rec, sizeof(rec));
+
+	m_args.resize(rec.argc + 1);
+	read(pos + sizeof(rec), m_args.data(), rec.argc * sizeof(u64));
+	m_args[rec.argc] = 0;
+
+	std::string prefix(rec.prefix_size, '\0');
+	read(pos + sizeof(rec) + rec.argc * sizeof(u64), &prefix[0], rec.prefix_size);
+
+	thread_local std::string text; text.clear();
+	fmt::raw_append(text, rec.fmt, rec.sup, m_args.data());
+
+	m_text.clear();
+	append_line(m_text, rec.stamp, message{rec.ch, static_cast<level>(rec.sev)}, prefix, text);
+
+	return sizeof(rec) + rec.argc * sizeof(u64) + rec.prefix_size;
+}
+
+void logs::file_writer::set_compression(int level)
+{
+	semaphore_lock lock(m_m);
+
+	if (!m_fout2)
+	{
+		return;
+	}
+
+	m_zs.avail_out = sizeof(m_zout);
+	m_zs.next_out  = m_zout;
+
+	// May emit pending output compressed with the previous parameters
+	if (deflateParams(&m_zs, level, Z_DEFAULT_STRATEGY) == Z_STREAM_ERROR || m_fout2.write(m_zout, sizeof(m_zout) - m_zs.avail_out) != sizeof(m_zout) - m_zs.avail_out)
+	{
+		deflateEnd(&m_zs);
+		m_fout2.close();
+	}
+}
+
 void logs::file_writer::log(logs::level sev, const char* text, std::size_t size)
 {
 	if (!m_fptr)
@@ -588,22 +727,20 @@ logs::file_listener::file_listener(const std::string& name)
 	messages.emplace_back(std::move(ver));
 }
 
-void logs::file_listener::log(u64 stamp, const logs::message& msg, const std::string& prefix, const std::string& _text)
+void logs::append_line(std::string& text, u64 stamp, const message& msg, const std::string& prefix, const std::string& str)
 {
-	thread_local std::string text;
-
 	// Used character: U+00B7 (Middle Dot)
 	switch (msg.sev)
 	{
-	case level::always:  text = u8"·A "; break;
-	case level::fatal:   text = u8"·F "; break;
-	case level::error:   text = u8"·E "; break;
-	case level::todo:    text = u8"·U "; break;
-	case level::success: text = u8"·S "; break;
-	case level::warning: text = u8"·W "; break;
-	case level::notice:  text = u8"·! "; break;
-	case level::trace:   text = u8"·T "; break;
-	case level::_uninit: text = u8"·  "; break;
+	case level::always:  text += u8"·A "; break;
+	case level::fatal:   text += u8"·F "; break;
+	case level::error:   text += u8"·E "; break;
+	case level::todo:    text += u8"·U "; break;
+	case level::success: text += u8"·S "; break;
+	case level::warning: text += u8"·W "; break;
+	case level::notice:  text += u8"·! "; break;
+	case level::trace:   text += u8"·T "; break;
+	case level::_uninit: text += u8"·  "; break;
 	}
 
 	// Print µs timestamp
@@ -630,8 +767,38 @@ void logs::file_listener::log(u64 stamp, const logs::message& msg, const std::st
 		text += "TODO: ";
 	}
 
-	text += _text;
+	text += str;
 	text += '\n';
 
+	// Zero bytes mark deferred messages in the buffer
+	std::replace(text.end() - str.size() - 1, text.end(), '\0', ' ');
+}
+
+void logs::file_listener::log(u64 stamp, const logs::message& msg, const std::string& prefix, const std::string& _text)
+{
+	thread_local std::string text; text.clear();
+
+	append_line(text, stamp, msg, prefix, _text);
+
 	file_writer::log(msg.sev, text.data(), text.size());
 }
+
+void logs::file_listener::log_deferred(u64 stamp, const logs::message& msg, const std::string& prefix, const fmt::format_desc& fmt, const fmt_type_info* sup, const u64* args, u32 argc)
+{
+	thread_local std::string data;
+
+	deferred_record rec{};
+	rec.sev         = static_cast<u8>(msg.sev);
+	rec.prefix_size = static_cast<u16>(std::min<std::size_t>(prefix.size(), 0xffff));
+	rec.argc        = argc;
+	rec.stamp       = stamp;
+	rec.ch          = msg.ch;
+	rec.fmt         = fmt;
+	rec.sup         = sup;
+
+	data.assign(reinterpret_cast<const char*>(&rec), sizeof(rec));
+	data.append(reinterpret_cast<const char*>(args), argc * sizeof(u64));
+	data.append(prefix, 0, rec.prefix_size);
+
+	file_writer::log(msg.sev, data.data(), data.size());
+}
@@ -21,6 +21,13 @@ namespace logs
 		_uninit = UINT_MAX, // Special value for delayed initialization
 	};
 
+#ifndef LOG_LEVEL_FLOOR
+#define LOG_LEVEL_FLOOR trace
+#endif
+
+	// Lowest severity compiled in, messages below it are removed at build time (set with LOG_LEVEL_FLOOR)
+	constexpr level max_level = level::LOG_LEVEL_FLOOR;
+
 	struct channel;
 
 	// Message information (temporary data)
@@ -30,7 +37,7 @@ namespace logs
 		level sev;
 
 		// Send log message to global logger instance
-		void broadcast(const char*, const fmt_type_info*, const u64*);
+		void broadcast(const fmt::format_desc&, const fmt_type_info*, const u64*);
 	};
 
 	class listener
@@ -48,6 +55,12 @@ namespace logs
 		// Process log message
 		virtual void log(u64 stamp, const message& msg, const std::string& prefix, const std::string& text) = 0;
 
+		// Check if the message would be used (messages no other listener accepts may be formatted later)
+		virtual bool accepts(const message& msg) const
+		{
+			return true;
+		}
+
 		// Add new listener
 		static void add(listener*);
 	};
@@ -71,7 +84,17 @@ namespace logs
 		template<typename... Args>
 		SAFE_BUFFERS FORCE_INLINE void format(level sev, const char* fmt, const Args&... args)
 		{
-			if (UNLIKELY(sev <= enabled))
+			if (sev <= max_level && UNLIKELY(sev <= enabled))
+			{
+				message{this, sev}.broadcast({fmt, nullptr}, fmt::get_type_info<fmt_unveil_t<Args>...>(), fmt_args_t<Args...>{fmt_unveil<Args>::get(args)...});
+			}
+		}
+
+		// Formatting function (format string parsed at compile time)
+		template<typename... Args>
+		SAFE_BUFFERS FORCE_INLINE void format(level sev, const fmt::format_desc& fmt, const Args&... args)
+		{
+			if (sev <= max_level && UNLIKELY(sev <= enabled))
 			{
 				message{this, sev}.broadcast(fmt, fmt::get_type_info<fmt_unveil_t<Args>...>(), fmt_args_t<Args...>{fmt_unveil<Args>::get(args)...});
 			}
@@ -80,6 +103,11 @@ namespace logs
 #define GEN_LOG_METHOD(_sev)\
 		template<typename... Args>\
 		SAFE_BUFFERS void _sev(const char* fmt, const Args&... args)\
+		{\
+			return format<Args...>(level::_sev, fmt, args...);\
+		}\
+		template<typename... Args>\
+		SAFE_BUFFERS void _sev(const fmt::format_desc& fmt, const Args&... args)\
 		{\
 			return format<Args...>(level::_sev, fmt, args...);\
 		}
@@ -110,14 +138,23 @@ namespace logs
 
 	// Log level control: register channel if necessary, set channel level
 	void set_level(const std::string&, level);
+
+	// Log file control: format messages with plain arguments on the writer thread
+	void set_deferred(bool);
+
+	// Log file control: set compression level of the .gz log (0..9)
+	void set_compression(int);
 }
 
+// Log message to the channel object, arguments are not evaluated if the level is disabled
+#define LOG_CHANNEL_MSG(ch, sev, fmt, ...) do { if (logs::level::sev <= logs::max_level && UNLIKELY(logs::level::sev <= (ch).enabled)) (ch).sev(FMT_PARSE(fmt), ##__VA_ARGS__); } while (0)
+
 // Legacy:
 
-#define LOG_SUCCESS(ch, fmt, ...) logs::ch.success("" fmt, ##__VA_ARGS__)
-#define LOG_NOTICE(ch, fmt, ...)  logs::ch.notice ("" fmt, ##__VA_ARGS__)
-#define LOG_WARNING(ch, fmt, ...) logs::ch.warning("" fmt, ##__VA_ARGS__)
-#define LOG_ERROR(ch, fmt, ...)   logs::ch.error  ("" fmt, ##__VA_ARGS__)
-#define LOG_TODO(ch, fmt, ...)    logs::ch.todo   ("" fmt, ##__VA_ARGS__)
-#define LOG_TRACE(ch, fmt, ...)   logs::ch.trace  ("" fmt, ##__VA_ARGS__)
-#define LOG_FATAL(ch, fmt, ...)   logs::ch.fatal  ("" fmt, ##__VA_ARGS__)
+#define LOG_SUCCESS(ch, fmt, ...) LOG_CHANNEL_MSG(logs::ch, success, fmt, ##__VA_ARGS__)
+#define LOG_NOTICE(ch, fmt, ...)  LOG_CHANNEL_MSG(logs::ch, notice,  fmt, ##__VA_ARGS__)
+#define LOG_WARNING(ch, fmt, ...) LOG_CHANNEL_MSG(logs::ch, warning, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(ch, fmt, ...)   LOG_CHANNEL_MSG(logs::ch, error,   fmt, ##__VA_ARGS__)
+#define LOG_TODO(ch, fmt, ...)    LOG_CHANNEL_MSG(logs::ch, todo,    fmt, ##__VA_ARGS__)
+#define LOG_TRACE(ch, fmt, ...)   LOG_CHANNEL_MSG(logs::ch, trace,   fmt, ##__VA_ARGS__)
+#define LOG_FATAL(ch, fmt, ...)   LOG_CHANNEL_MSG(logs::ch, fatal,   fmt, ##__VA_ARGS__)
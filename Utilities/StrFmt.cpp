@@ -350,6 +350,56 @@ void fmt::raw_append(std::string& out, const char* fmt, const fmt_type_info* sup
 	cfmt_append(out, fmt, cfmt_src{sup, args});
 }
 
+void fmt::raw_append(std::string& out, const format_desc& fmt, const fmt_type_info* sup, const u64* args) noexcept
+{
+	if (!fmt.segs)
+	{
+		return raw_append(out, fmt.str, sup, args);
+	}
+
+	// Arguments are consumed by each conversion in turn
+	cfmt_src src{sup, args};
+
+	const char* str = fmt.str;
+
+	for (u32 i = 0; i < fmt.segs[0]; i++)
+	{
+		const u32 text = fmt.segs[i * 2 + 1];
+		const u32 conv = fmt.segs[i * 2 + 2];
+
+		out.append(str, text);
+		str += text;
+
+		if (!conv)
+		{
+			continue;
+		}
+
+		char buf[64];
+
+		if (conv >= sizeof(buf))
+		{
+			// Unusually long conversion, format the rest as usual
+			cfmt_append(out, str, src);
+			return;
+		}
+
+		std::memcpy(buf, str, conv);
+		buf[conv] = '\0';
+
+		const u64* arg = src.args;
+		cfmt_append(out, +buf, src);
+		str += conv;
+
+		// Invalid sequence was written untouched, stop further formatting as cfmt_append does
+		if (src.args == arg && !(conv == 2 && buf[1] == '%'))
+		{
+			out += str;
+			return;
+		}
+	}
+}
+
 std::string fmt::replace_first(const std::string& src, const std::string& from, const std::string& to)
 {
 	auto pos = src.find(from);
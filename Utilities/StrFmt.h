@@ -234,12 +234,16 @@ struct fmt_type_info
 {
 	decltype(&fmt_class_string<int>::format) fmt_string;
 
+	// Argument is passed by value (not a pointer to temporary data)
+	bool by_value;
+
 	template <typename T>
 	static constexpr fmt_type_info make()
 	{
 		return fmt_type_info
 		{
 			&fmt_class_string<T>::format,
+			std::is_arithmetic<T>::value || std::is_enum<T>::value,
 		};
 	}
 };
@@ -270,6 +274,83 @@ namespace fmt
 		}
 	};
 
+	// Format string with its literal text and conversions located (see FMT_PARSE)
+	struct format_desc
+	{
+		const char* str;
+
+		// Number of segments followed by pairs of literal text length and conversion length, nullptr if not parsed
+		const u32* segs;
+	};
+
+	// Length of conversion flags, width, precision and size (after '%')
+	constexpr std::size_t skip_conversion(const char* str, std::size_t pos)
+	{
+		while (str[pos] == '-' || str[pos] == '+' || str[pos] == ' ' || str[pos] == '#' || str[pos] == '.' || str[pos] == '*' ||
+			(str[pos] >= '0' && str[pos] <= '9') ||
+			str[pos] == 'h' || str[pos] == 'l' || str[pos] == 'z' || str[pos] == 'j' || str[pos] == 't')
+		{
+			pos++;
+		}
+
+		// Include conversion character
+		return str[pos] ? pos + 1 : pos;
+	}
+
+	// Number of segments (literal text followed by a conversion, which may be empty)
+	constexpr u32 count_segments(const char* str)
+	{
+		u32 result = 1;
+
+		for (std::size_t pos = 0; str[pos];)
+		{
+			if (str[pos] == '%')
+			{
+				pos = skip_conversion(str, pos + 1);
+				result++;
+			}
+			else
+			{
+				pos++;
+			}
+		}
+
+		return result;
+	}
+
+	template <u32 N>
+	struct format_segments
+	{
+		u32 data[N * 2 + 1];
+
+		constexpr format_segments(const char* str)
+			: data{}
+		{
+			data[0] = N;
+
+			for (std::size_t i = 0, pos = 0; i < N; i++)
+			{
+				const std::size_t start = pos;
+
+				while (str[pos] && str[pos] != '%')
+				{
+					pos++;
+				}
+
+				data[i * 2 + 1] = static_cast<u32>(pos - start);
+
+				const std::size_t conv = pos;
+
+				if (str[pos])
+				{
+					pos = skip_conversion(str, pos + 1);
+				}
+
+				data[i * 2 + 2] = static_cast<u32>(pos - conv);
+			}
+		}
+	};
+
 	template <typename... Args>
 	SAFE_BUFFERS FORCE_INLINE const fmt_type_info* get_type_info()
 	{
@@ -282,6 +363,9 @@ namespace fmt
 	// Internal formatting function
 	void raw_append(std::string& out, const char*, const fmt_type_info*, const u64*) noexcept;
 
+	// Internal formatting function (literal text is copied as is, only conversions are parsed)
+	void raw_append(std::string& out, const format_desc&, const fmt_type_info*, const u64*) noexcept;
+
 	// Formatting function
 	template <typename... Args>
 	SAFE_BUFFERS FORCE_INLINE void append(std::string& out, const char* fmt, const Args&... args)
@@ -289,6 +373,13 @@ namespace fmt
 		raw_append(out, fmt, fmt::get_type_info<fmt_unveil_t<Args>...>(), fmt_args_t<Args...>{fmt_unveil<Args>::get(args)...});
 	}
 
+	// Formatting function
+	template <typename... Args>
+	SAFE_BUFFERS FORCE_INLINE void append(std::string& out, const format_desc& fmt, const Args&... args)
+	{
+		raw_append(out, fmt, fmt::get_type_info<fmt_unveil_t<Args>...>(), fmt_args_t<Args...>{fmt_unveil<Args>::get(args)...});
+	}
+
 	// Formatting function
 	template <typename... Args>
 	SAFE_BUFFERS FORCE_INLINE std::string format(const char* fmt, const Args&... args)
@@ -298,6 +389,15 @@ namespace fmt
 		return result;
 	}
 
+	// Formatting function
+	template <typename... Args>
+	SAFE_BUFFERS FORCE_INLINE std::string format(const format_desc& fmt, const Args&... args)
+	{
+		std::string result;
+		append<Args...>(result, fmt, args...);
+		return result;
+	}
+
 	// Internal exception message formatting template, must be explicitly specialized or instantiated in cpp to minimize code bloat
 	template <typename T>
 	[[noreturn]] void raw_throw_exception(const char*, const fmt_type_info*, const u64*);
@@ -309,3 +409,10 @@ namespace fmt
 		raw_throw_exception<T>(fmt, fmt::get_type_info<fmt_unveil_t<Args>...>(), fmt_args_t<Args...>{fmt_unveil<Args>::get(args)...});
 	}
 }
+
+// Format string literal parsed at compile time, e.g. fmt::format(FMT_PARSE("%s/%u"), a, b)
+#define FMT_PARSE(str) ([]() -> ::fmt::format_desc\
+{\
+	static constexpr ::fmt::format_segments<::fmt::count_segments("" str)> s_segs("" str);\
+	return {"" str, s_segs.data};\
+}())
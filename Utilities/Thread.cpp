@@ -9,6 +9,11 @@
 #include "sysinfo.h"
 #include <typeinfo>
 #include <thread>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <algorithm>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -1089,16 +1094,28 @@ bool handle_access_violation(u32 addr, bool is_writing, x64_context* context)
 
 	const auto cpu = get_current_cpu_thread();
 
-	if (rsx::g_access_violation_handler && rsx::g_access_violation_handler(addr, is_writing))
+	// Dispatch straight to the subsystem that protected the page; unowned pages skip the callbacks
+	switch (const auto owner = vm::get_page_owner(addr))
 	{
-		g_tls_fault_rsx++;
-
-		if (cpu)
+	case vm::page_owner::rsx_texture_cache:
+	case vm::page_owner::rsx_framebuffer:
+	{
+		if (rsx::g_access_violation_handler && rsx::g_access_violation_handler(addr, is_writing))
 		{
-			cpu->test_state();
+			g_tls_fault_rsx++;
+			vm::on_owner_fault(owner);
+
+			if (cpu)
+			{
+				cpu->test_state();
+			}
+
+			return true;
 		}
 
-		return true;
+		break;
+	}
+	default: break;
 	}
 
 	auto code = (const u8*)RIP(context);
@@ -1899,11 +1916,125 @@ void thread_ctrl::test()
 	}
 }
 
+namespace
+{
+	// Masks handed out for native_core_arrangement::topology
+	struct thread_placement
+	{
+		u64 all = 0;
+		u64 emulation = 0; // PPU, SPU and RSX threads, which talk to each other all the time
+		u64 llvm = 0; // Compiler workers, kept off the processors above where possible
+	};
+
+	thread_placement s_thread_placement;
+
+	u32 count_cpus(u64 mask)
+	{
+		u32 result = 0;
+		for (; mask; mask &= mask - 1)
+			result++;
+
+		return result;
+	}
+
+	std::string format_cpu_mask(u64 mask)
+	{
+		std::string result;
+
+		for (u32 n = 0; n < 64; n++)
+		{
+			if (!(mask & (1ull << n)))
+				continue;
+
+			u32 last = n;
+			while (last < 63 && (mask & (1ull << (last + 1))))
+				last++;
+
+			fmt::append(result, result.empty() ? "%u" : ",%u", n);
+			if (last != n)
+				fmt::append(result, "-%u", last);
+
+			n = last;
+		}
+
+		return result.empty() ? "none" : result;
+	}
+
+	bool build_thread_placement(const std::vector<utils::logical_cpu>& cpus, thread_placement& out)
+	{
+		if (cpus.empty())
+			return false;
+
+		u32 best_efficiency = 0;
+		for (const auto& cpu : cpus)
+			best_efficiency = std::max(best_efficiency, cpu.efficiency);
+
+		// Fast processors grouped by the last level cache they share
+		std::map<u32, u64> domains;
+		u64 fast = 0;
+
+		for (const auto& cpu : cpus)
+		{
+			out.all |= 1ull << cpu.index;
+
+			if (cpu.efficiency == best_efficiency)
+			{
+				domains[cpu.cache_domain] |= 1ull << cpu.index;
+				fast |= 1ull << cpu.index;
+			}
+		}
+
+		std::vector<std::pair<u32, u64>> order(domains.begin(), domains.end());
+
+		// Largest domains first. Among equals the upper ones, some system code sticks to the lower processors
+		std::stable_sort(order.begin(), order.end(), [](const std::pair<u32, u64>& a, const std::pair<u32, u64>& b)
+		{
+			const u32 ca = count_cpus(a.second), cb = count_cpus(b.second);
+			return ca != cb ? ca > cb : a.first > b.first;
+		});
+
+		// A PPU, six SPUs and the RSX want about eight processors, spill into the next domain only below that
+		for (const auto& domain : order)
+		{
+			if (count_cpus(out.emulation) >= 8)
+				break;
+
+			out.emulation |= domain.second;
+		}
+
+		out.llvm = out.all & ~out.emulation;
+		if (!out.llvm)
+			out.llvm = out.all;
+
+		LOG_NOTICE(GENERAL, "Host topology: %u processor(s), %u fast cache domain(s)", cpus.size(), order.size());
+
+		for (const auto& domain : domains)
+		{
+			LOG_NOTICE(GENERAL, "- Cache domain %u: processors %s", domain.first, format_cpu_mask(domain.second));
+		}
+
+		if (out.all != fast)
+		{
+			LOG_NOTICE(GENERAL, "- Efficiency processors: %s", format_cpu_mask(out.all & ~fast));
+		}
+
+		LOG_NOTICE(GENERAL, "Thread placement: PPU/SPU/RSX on %s, LLVM on %s", format_cpu_mask(out.emulation), format_cpu_mask(out.llvm));
+		return true;
+	}
+}
+
 void thread_ctrl::detect_cpu_layout()
 {
 	if (!g_native_core_layout.compare_and_swap_test(native_core_arrangement::undefined, native_core_arrangement::generic))
 		return;
 
+	// The masks are written before the layout is published
+	if (build_thread_placement(utils::get_cpu_topology(), s_thread_placement))
+	{
+		g_native_core_layout.store(native_core_arrangement::topology);
+		return;
+	}
+
 	const auto system_id = utils::get_system_info();
 	if (system_id.find("Ryzen") != std::string::npos)
 	{
@@ -1913,13 +2044,13 @@ void thread_ctrl::detect_cpu_layout()
 	// TODO: Detect hyperthreaded intel CPUs
 }
 
-u16 thread_ctrl::get_affinity_mask(thread_class group)
+u64 thread_ctrl::get_affinity_mask(thread_class group)
 {
 	detect_cpu_layout();
 
 	if (const auto thread_count = std::thread::hardware_concurrency())
 	{
-		const u16 all_cores_mask = thread_count < 16 ? (u16)(~(UINT16_MAX << thread_count)): UINT16_MAX;
+		const u64 all_cores_mask = thread_count < 64 ? ~(UINT64_MAX << thread_count) : UINT64_MAX;
 
 		switch (g_native_core_layout)
 		{
@@ -1928,6 +2059,20 @@ u16 thread_ctrl::get_affinity_mask(thread_class group)
 		{
 			return all_cores_mask;
 		}
+		case native_core_arrangement::topology:
+		{
+			switch (group)
+			{
+			case thread_class::rsx:
+			case thread_class::ppu:
+			case thread_class::spu:
+				return s_thread_placement.emulation;
+			case thread_class::llvm:
+				return s_thread_placement.llvm;
+			default:
+				return s_thread_placement.all;
+			}
+		}
 		case native_core_arrangement::amd_ccx:
 		{
 			u16 spu_mask, ppu_mask, rsx_mask;
@@ -1986,7 +2131,7 @@ u16 thread_ctrl::get_affinity_mask(thread_class group)
 		}
 	}
 
-	return UINT16_MAX;
+	return UINT64_MAX;
 }
 
 void thread_ctrl::set_native_priority(int priority)
@@ -2022,7 +2167,7 @@ void thread_ctrl::set_native_priority(int priority)
 #endif
 }
 
-void thread_ctrl::set_thread_affinity_mask(u16 mask)
+void thread_ctrl::set_thread_affinity_mask(u64 mask)
 {
 #ifdef _WIN32
 	HANDLE _this_thread = GetCurrentThread();
@@ -2035,9 +2180,9 @@ void thread_ctrl::set_thread_affinity_mask(u16 mask)
 	cpu_set_t cs;
 	CPU_ZERO(&cs);
 
-	for (u32 core = 0; core < 16u; ++core)
+	for (u32 core = 0; core < 64u; ++core)
 	{
-		if ((u32)mask & (1u << core))
+		if (mask & (1ull << core))
 		{
 			CPU_SET(core, &cs);
 		}
@@ -2088,3 +2233,234 @@ void named_thread::start_thread(const std::shared_ptr<void>& _this)
 task_stack::task_base::~task_base()
 {
 }
+
+namespace
+{
+	struct pool_job
+	{
+		std::function<void()> func;
+		thread_class group;
+	};
+
+	struct pool_worker
+	{
+		std::mutex mutex;
+		std::deque<pool_job> jobs;
+		std::thread thread;
+	};
+
+	class pool_impl
+	{
+		std::vector<std::unique_ptr<pool_worker>> m_workers;
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		atomic_t<u64> m_queued{0};
+		atomic_t<u32> m_next{0};
+		bool m_exit = false;
+
+		static thread_local pool_worker* g_tls_worker;
+
+		// Take a job from the own queue (newest first), then steal from others (oldest first)
+		bool pop(std::size_t index, pool_job& out)
+		{
+			for (std::size_t i = 0; i < m_workers.size(); i++)
+			{
+				auto& w = *m_workers[(index + i) % m_workers.size()];
+
+				std::lock_guard<std::mutex> lock(w.mutex);
+
+				if (!w.jobs.empty())
+				{
+					if (i == 0)
+					{
+						out = std::move(w.jobs.back());
+						w.jobs.pop_back();
+					}
+					else
+					{
+						out = std::move(w.jobs.front());
+						w.jobs.pop_front();
+					}
+
+					m_queued--;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		void run(std::size_t index)
+		{
+			g_tls_worker = m_workers[index].get();
+
+			g_tls_log_prefix = []
+			{
+				return std::string{"Pool Worker"};
+			};
+
+			thread_class current = thread_class::general;
+			thread_ctrl::set_thread_affinity_mask(thread_ctrl::get_affinity_mask(current));
+
+			while (true)
+			{
+				pool_job job;
+
+				if (!pop(index, job))
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+
+					if (m_exit && !m_queued)
+					{
+						return;
+					}
+
+					m_cv.wait(lock, [&] { return m_exit || m_queued; });
+					continue;
+				}
+
+				if (job.group != current)
+				{
+					current = job.group;
+					thread_ctrl::set_thread_affinity_mask(thread_ctrl::get_affinity_mask(current));
+				}
+
+				try
+				{
+					job.func();
+				}
+				catch (...)
+				{
+					catch_all_exceptions();
+				}
+			}
+		}
+
+	public:
+		pool_impl()
+		{
+			const u32 count = std::max<u32>(std::thread::hardware_concurrency(), 2) - 1;
+
+			for (u32 i = 0; i < count; i++)
+			{
+				m_workers.emplace_back(std::make_unique<pool_worker>());
+			}
+
+			for (u32 i = 0; i < count; i++)
+			{
+				m_workers[i]->thread = std::thread([this, i] { run(i); });
+			}
+		}
+
+		~pool_impl()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_exit = true;
+			}
+
+			m_cv.notify_all();
+
+			for (auto& w : m_workers)
+			{
+				w->thread.join();
+			}
+		}
+
+		void push(pool_job job)
+		{
+			// Workers queue their own jobs locally, other threads spread them
+			pool_worker* w = g_tls_worker;
+
+			if (!w)
+			{
+				w = m_workers[m_next++ % m_workers.size()].get();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(w->mutex);
+				w->jobs.emplace_back(std::move(job));
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_queued++;
+			}
+
+			m_cv.notify_one();
+		}
+
+		u32 size() const
+		{
+			return ::size32(m_workers);
+		}
+	};
+
+	thread_local pool_worker* pool_impl::g_tls_worker = nullptr;
+
+	pool_impl& get_pool()
+	{
+		static pool_impl pool;
+		return pool;
+	}
+}
+
+void thread_pool::push(std::function<void()> job, thread_class group)
+{
+	get_pool().push(pool_job{std::move(job), group});
+}
+
+void thread_pool::parallel_for(u32 num_tasks, const std::function<void(u32)>& func, thread_class group, u32 max_threads)
+{
+	if (num_tasks <= 1 || max_threads <= 1)
+	{
+		for (u32 i = 0; i < num_tasks; i++)
+		{
+			func(i);
+		}
+
+		return;
+	}
+
+	struct state_t
+	{
+		atomic_t<u32> next{0};
+		atomic_t<u32> done{0};
+		std::mutex mutex;
+		std::condition_variable cv;
+	};
+
+	// Helpers may start after all tasks are taken, they only use func while there is a task left
+	const auto state = std::make_shared<state_t>();
+
+	const auto work = [state, f = &func, num_tasks]()
+	{
+		for (u32 i; (i = state->next++) < num_tasks;)
+		{
+			(*f)(i);
+
+			if (++state->done == num_tasks)
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->cv.notify_all();
+			}
+		}
+	};
+
+	const u32 helpers = std::min({num_tasks, max_threads, get_thread_count()}) - 1;
+
+	for (u32 i = 0; i < helpers; i++)
+	{
+		push(work, group);
+	}
+
+	work();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->cv.wait(lock, [&] { return state->done == num_tasks; });
+}
+
+u32 thread_pool::get_thread_count()
+{
+	return get_pool().size() + 1;
+}
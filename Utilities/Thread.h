@@ -6,6 +6,7 @@
 #include <exception>
 #include <string>
 #include <memory>
+#include <functional>
 
 #include "sema.h"
 #include "cond.h"
@@ -22,7 +23,8 @@ enum class native_core_arrangement : u32
 	undefined,
 	generic,
 	intel_ht,
-	amd_ccx
+	amd_ccx,
+	topology // Placement derived from the core and cache hierarchy reported by the OS
 };
 
 enum class thread_class : u32
@@ -30,7 +32,8 @@ enum class thread_class : u32
 	general,
 	rsx,
 	spu,
-	ppu
+	ppu,
+	llvm
 };
 
 // Simple list of void() functors
@@ -270,13 +273,13 @@ public:
 	static void detect_cpu_layout();
 
 	// Returns a core affinity mask. Set whether to generate the high priority set or not
-	static u16 get_affinity_mask(thread_class group);
+	static u64 get_affinity_mask(thread_class group);
 
 	// Sets the native thread priority
 	static void set_native_priority(int priority);
 
 	// Sets the preferred affinity mask for this thread
-	static void set_thread_affinity_mask(u16 mask);
+	static void set_thread_affinity_mask(u64 mask);
 };
 
 class named_thread
@@ -365,3 +368,17 @@ public:
 		return m_thread.get();
 	}
 };
+
+// Shared pool of host worker threads for background jobs (compilation, decoding, I/O), so they don't oversubscribe the host
+class thread_pool final
+{
+public:
+	// Queue a job, workers steal queued jobs from each other; the worker takes the affinity mask of the job's thread class
+	static void push(std::function<void()> job, thread_class group = thread_class::general);
+
+	// Run func(0) .. func(num_tasks - 1) using up to max_threads threads, the calling thread helps. Returns once all tasks are done.
+	static void parallel_for(u32 num_tasks, const std::function<void(u32)>& func, thread_class group = thread_class::general, u32 max_threads = UINT32_MAX);
+
+	// Number of worker threads plus the caller
+	static u32 get_thread_count();
+};
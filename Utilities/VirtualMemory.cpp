@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "Utilities/Log.h"
 #include "VirtualMemory.h"
+#include <map>
 #ifdef _WIN32
 #include <Windows.h>
 #else
@@ -125,6 +126,136 @@ namespace utils
 #endif
 	}
 
+	void memory_advise_huge_pages(void* pointer, std::size_t size)
+	{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+		// Transparent huge pages; also applies to memfd mappings when shmem THP is set to "advise"
+		if (::madvise(pointer, size, MADV_HUGEPAGE) == -1)
+		{
+			LOG_WARNING(GENERAL, "madvise(MADV_HUGEPAGE) failed (%p, 0x%x, errno=%d)", pointer, size, errno);
+		}
+#else
+		// Windows large pages must be locked, committed at reservation time and cannot be reprotected per 4K page,
+		// which rules them out for memory mapped through shm views or tracked with page protection
+#endif
+	}
+
+	struct memory_class_stats
+	{
+		atomic_t<u64> current;
+		atomic_t<u64> peak;
+	};
+
+	static std::array<memory_class_stats, static_cast<u32>(memory_class::count)> s_memory_stats{};
+
+	void memory_account(memory_class cls, s64 bytes)
+	{
+		auto& stats = s_memory_stats[static_cast<u32>(cls)];
+		const u64 value = stats.current += bytes;
+
+		for (u64 peak = stats.peak; peak < value && !stats.peak.compare_and_swap_test(peak, value); peak = stats.peak)
+		{
+		}
+	}
+
+	std::pair<u64, u64> get_memory_usage(memory_class cls)
+	{
+		const auto& stats = s_memory_stats[static_cast<u32>(cls)];
+		return { stats.current.load(), stats.peak.load() };
+	}
+
+	const char* get_memory_class_name(memory_class cls)
+	{
+		switch (cls)
+		{
+		case memory_class::guest_main: return "Guest main memory";
+		case memory_class::guest_user: return "Guest user memory";
+		case memory_class::guest_video: return "Guest video memory";
+		case memory_class::guest_stack: return "Guest stack memory";
+		case memory_class::guest_spu: return "Guest SPU memory";
+		case memory_class::texture_cache: return "Texture cache";
+		case memory_class::gpu_heaps: return "GPU heaps";
+		case memory_class::jit_code: return "JIT code";
+		case memory_class::spu_functions: return "SPU functions";
+		case memory_class::count: break;
+		}
+
+		return "Unknown";
+	}
+
+	std::string format_memory_usage()
+	{
+		std::string out;
+		u64 total = 0;
+
+		for (u32 i = 0; i < static_cast<u32>(memory_class::count); i++)
+		{
+			const auto usage = get_memory_usage(static_cast<memory_class>(i));
+
+			if (usage.first || usage.second)
+			{
+				fmt::append(out, "\n%s: %.2f MB (peak %.2f MB)", get_memory_class_name(static_cast<memory_class>(i)), usage.first / 1048576., usage.second / 1048576.);
+				total += usage.first;
+			}
+		}
+
+		fmt::append(out, "\nTotal: %.2f MB", total / 1048576.);
+		return out;
+	}
+
+	void protection_batch::add(void* pointer, std::size_t size, protection prot)
+	{
+		if (!size)
+		{
+			return;
+		}
+
+		const u64 begin = (u64)pointer & -4096;
+		const u64 end = ::align((u64)pointer + size, 4096);
+		m_requests.push_back({ begin, end, prot });
+	}
+
+	void protection_batch::apply()
+	{
+		if (m_requests.empty())
+		{
+			return;
+		}
+
+		// Resolve the final protection of every touched page, in request order
+		std::map<u64, protection> pages;
+
+		for (const auto& req : m_requests)
+		{
+			for (u64 page = req.begin; page < req.end; page += 4096)
+			{
+				pages[page] = req.prot;
+			}
+		}
+
+		m_requests.clear();
+
+		// Emit one call per run of adjacent pages sharing the same protection
+		u64 run_begin = pages.begin()->first;
+		u64 run_end = run_begin;
+		protection run_prot = pages.begin()->second;
+
+		for (const auto& page : pages)
+		{
+			if (page.first != run_end || page.second != run_prot)
+			{
+				memory_protect((void*)run_begin, run_end - run_begin, run_prot);
+
+				run_begin = page.first;
+				run_prot = page.second;
+			}
+
+			run_end = page.first + 4096;
+		}
+
+		memory_protect((void*)run_begin, run_end - run_begin, run_prot);
+	}
+
 	shm::shm(u32 size)
 		: m_size(::align(size, 0x10000))
 		, m_ptr(nullptr)
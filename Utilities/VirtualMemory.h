@@ -36,6 +36,107 @@ namespace utils
 	// Set memory protection
 	void memory_protect(void* pointer, std::size_t size, protection prot);
 
+	/**
+	* Hint that committed or mapped memory should be backed by huge pages where the host allows it.
+	* Protection stays page-granular: the host splits a huge page when a part of it is reprotected.
+	*/
+	void memory_advise_huge_pages(void* pointer, std::size_t size);
+
+	// Host memory accounting classes
+	enum class memory_class : u32
+	{
+		guest_main, // vm main and main extend blocks
+		guest_user, // vm user space block
+		guest_video, // vm video (RSX local memory) block
+		guest_stack, // vm stack block
+		guest_spu, // vm SPU block (RawSPU LS and SPU thread mappings)
+		texture_cache, // Texture cache sections
+		gpu_heaps, // Renderer ring heaps
+		jit_code, // LLVM code and data sections
+		spu_functions, // SPU function bodies kept by the recompiler runtime
+
+		count
+	};
+
+	// Adjust the host memory attributed to a class
+	void memory_account(memory_class cls, s64 bytes);
+
+	// Get host memory attributed to a class: current and peak value
+	std::pair<u64, u64> get_memory_usage(memory_class cls);
+
+	const char* get_memory_class_name(memory_class cls);
+
+	// One line per class with non-zero usage
+	std::string format_memory_usage();
+
+	// Reports an absolute amount to the accounting registry (for owners that only know their current total)
+	class memory_gauge
+	{
+		const memory_class m_class;
+		u64 m_value = 0;
+
+	public:
+		explicit memory_gauge(memory_class cls)
+			: m_class(cls)
+		{
+		}
+
+		memory_gauge(const memory_gauge&) = delete;
+
+		~memory_gauge()
+		{
+			set(0);
+		}
+
+		void set(u64 value)
+		{
+			if (value != m_value)
+			{
+				memory_account(m_class, static_cast<s64>(value - m_value));
+				m_value = value;
+			}
+		}
+
+		void add(u64 bytes)
+		{
+			set(m_value + bytes);
+		}
+	};
+
+	// Collects protection changes and applies them as coalesced page runs, one host call per run
+	class protection_batch
+	{
+		struct request
+		{
+			u64 begin;
+			u64 end;
+			protection prot;
+		};
+
+		std::vector<request> m_requests;
+
+	public:
+		protection_batch() = default;
+
+		protection_batch(const protection_batch&) = delete;
+
+		~protection_batch()
+		{
+			apply();
+		}
+
+		// Queue a change; later requests win where ranges overlap
+		void add(void* pointer, std::size_t size, protection prot);
+
+		// Apply and clear all queued changes
+		void apply();
+
+		bool empty() const
+		{
+			return m_requests.empty();
+		}
+	};
+
 	// Shared memory handle
 	class shm
 	{
@@ -2,6 +2,9 @@
 #include <yaml-cpp/yaml.h>
 #include "File.h"
 #include "Config.h"
+#include "hash.h"
+
+#include <cstring>
 
 template <>
 void fmt_class_string<patch_type>::format(std::string& out, u64 arg)
@@ -28,148 +31,309 @@ void fmt_class_string<patch_type>::format(std::string& out, u64 arg)
 	});
 }
 
-void patch_engine::append(const std::string& patch)
+namespace
 {
-	if (fs::file f{patch})
+	struct compiled_header
 	{
-		YAML::Node root;
+		char magic[8]; // "RPCSPTCH"
+		u32 version;
+		u32 count; // Number of named sequences
+		u64 hash; // Hash of the source file
+	};
 
-		try
-		{
-			root = YAML::Load(f.to_string());
-		}
-		catch (const std::exception& e)
+	// Followed by the name and the entries
+	struct compiled_sequence
+	{
+		u32 name_size;
+		u32 count;
+	};
+
+	// Followed by the loaded sequence name if load_size is not zero
+	struct compiled_op
+	{
+		u32 offset;
+		u32 size;
+		u8 data[8];
+		u32 load_size;
+	};
+
+	const char s_compiled_magic[8]{'R', 'P', 'C', 'S', 'P', 'T', 'C', 'H'};
+
+	constexpr u32 s_compiled_version = 1;
+
+	template <typename T, typename P>
+	void set_value(P& patch, const T& value)
+	{
+		static_assert(sizeof(T) <= sizeof(patch.data), "Patch value too big");
+		patch.size = sizeof(T);
+		std::memcpy(patch.data, &value, sizeof(T));
+	}
+
+	template <typename T>
+	T float_bits(std::conditional_t<sizeof(T) == 4, f32, f64> value)
+	{
+		T result;
+		std::memcpy(&result, &value, sizeof(T));
+		return result;
+	}
+}
+
+void patch_engine::append(const std::string& path)
+{
+	const fs::file f{path};
+
+	if (!f)
+	{
+		return;
+	}
+
+	const std::string text = f.to_string();
+	const u64 hash = rpcs3::hash64(text.data(), text.size());
+	const std::string compiled_path = path + ".bin";
+
+	patch_list list;
+
+	if (!load_compiled(compiled_path, hash, list))
+	{
+		list.clear();
+
+		if (!parse(path, text, list))
 		{
-			LOG_FATAL(GENERAL, "Failed to load patch file %s\n%s thrown: %s", patch, typeid(e).name(), e.what());
 			return;
 		}
 
-		for (auto pair : root)
+		save_compiled(compiled_path, hash, list);
+	}
+
+	for (const auto& pair : list)
+	{
+		auto& data = m_map[pair.first];
+
+		for (const auto& op : pair.second)
 		{
-			auto& name = pair.first.Scalar();
-			auto& data = m_map[name];
+			if (op.load.empty())
+			{
+				data.emplace_back(op.info);
+				continue;
+			}
 
-			for (auto patch : pair.second)
+			// Special syntax: copy named sequence (must be loaded before)
+			const auto found = m_map.find(op.load);
+
+			if (found == m_map.end())
 			{
-				u64 type64 = 0;
-				cfg::try_to_enum_value(&type64, &fmt_class_string<patch_type>::format, patch[0].Scalar());
-
-				struct patch info{};
-				info.type   = static_cast<patch_type>(type64);
-				info.offset = patch[1].as<u32>(0);
-
-				switch (info.type)
-				{
-				case patch_type::load:
-				{
-					// Special syntax: copy named sequence (must be loaded before)
-					const auto found = m_map.find(patch[1].Scalar());
-
-					if (found != m_map.end())
-					{
-						// Address modifier (optional)
-						const u32 mod = patch[2].as<u32>(0);
-
-						for (const auto& rd : found->second)
-						{
-							info = rd;
-							info.offset += mod;
-							data.emplace_back(info);
-						}
-
-						continue;
-					}
-
-					// TODO: error
-					break;
-				}
-				case patch_type::bef32:
-				case patch_type::lef32:
-				{
-					info.value_as<f32>() = patch[2].as<f32>();
-					break;
-				}
-				case patch_type::bef64:
-				case patch_type::lef64:
-				{
-					info.value_as<f64>() = patch[2].as<f64>();
-					break;
-				}
-				default:
-				{
-					info.value = patch[2].as<u64>();
-					break;
-				}
-				}
+				// TODO: error
+				continue;
+			}
 
+			// Copy first, the sequence may be the one being extended
+			const std::vector<patch> seq = found->second;
+
+			for (patch info : seq)
+			{
+				// Address modifier
+				info.offset += op.info.offset;
 				data.emplace_back(info);
 			}
 		}
 	}
 }
 
-std::size_t patch_engine::apply(const std::string& name, u8* dst) const
+bool patch_engine::parse(const std::string& path, const std::string& text, patch_list& out)
 {
-	const auto found = m_map.find(name);
+	YAML::Node root;
 
-	if (found == m_map.cend())
+	try
 	{
-		return 0;
+		root = YAML::Load(text);
+	}
+	catch (const std::exception& e)
+	{
+		LOG_FATAL(GENERAL, "Failed to load patch file %s\n%s thrown: %s", path, typeid(e).name(), e.what());
+		return false;
 	}
 
-	// Apply modifications sequentially
-	for (const auto& p : found->second)
+	for (auto pair : root)
 	{
-		auto ptr = dst + p.offset;
+		out.emplace_back(pair.first.Scalar(), std::vector<patch_op>{});
+		auto& data = out.back().second;
 
-		switch (p.type)
+		for (auto patch : pair.second)
 		{
-		case patch_type::load:
-		{
-			// Invalid in this context
-			break;
-		}
-		case patch_type::byte:
-		{
-			*ptr = static_cast<u8>(p.value);
-			break;
-		}
-		case patch_type::le16:
-		{
-			*reinterpret_cast<le_t<u16, 1>*>(ptr) = static_cast<u16>(p.value);
-			break;
-		}
-		case patch_type::le32:
-		case patch_type::lef32:
-		{
-			*reinterpret_cast<le_t<u32, 1>*>(ptr) = static_cast<u32>(p.value);
-			break;
+			u64 type64 = 0;
+			cfg::try_to_enum_value(&type64, &fmt_class_string<patch_type>::format, patch[0].Scalar());
+
+			patch_op op{};
+			auto& info = op.info;
+			info.offset = patch[1].as<u32>(0);
+
+			switch (static_cast<patch_type>(type64))
+			{
+			case patch_type::load:
+			{
+				// Sequence name and optional address modifier
+				op.load = patch[1].Scalar();
+				info.offset = patch[2].as<u32>(0);
+				break;
+			}
+			case patch_type::byte: set_value(info, static_cast<u8>(patch[2].as<u64>())); break;
+			case patch_type::le16: set_value(info, le_t<u16, 1>{static_cast<u16>(patch[2].as<u64>())}); break;
+			case patch_type::le32: set_value(info, le_t<u32, 1>{static_cast<u32>(patch[2].as<u64>())}); break;
+			case patch_type::le64: set_value(info, le_t<u64, 1>{patch[2].as<u64>()}); break;
+			case patch_type::lef32: set_value(info, le_t<u32, 1>{float_bits<u32>(patch[2].as<f32>())}); break;
+			case patch_type::lef64: set_value(info, le_t<u64, 1>{float_bits<u64>(patch[2].as<f64>())}); break;
+			case patch_type::be16: set_value(info, be_t<u16, 1>{static_cast<u16>(patch[2].as<u64>())}); break;
+			case patch_type::be32: set_value(info, be_t<u32, 1>{static_cast<u32>(patch[2].as<u64>())}); break;
+			case patch_type::be64: set_value(info, be_t<u64, 1>{patch[2].as<u64>()}); break;
+			case patch_type::bef32: set_value(info, be_t<u32, 1>{float_bits<u32>(patch[2].as<f32>())}); break;
+			case patch_type::bef64: set_value(info, be_t<u64, 1>{float_bits<u64>(patch[2].as<f64>())}); break;
+			}
+
+			if (op.load.empty() && !info.size)
+			{
+				// Unknown type, or load without a name
+				continue;
+			}
+
+			data.emplace_back(std::move(op));
 		}
-		case patch_type::le64:
-		case patch_type::lef64:
+	}
+
+	return true;
+}
+
+bool patch_engine::load_compiled(const std::string& path, u64 hash, patch_list& out)
+{
+	const fs::file f{path};
+
+	if (!f)
+	{
+		return false;
+	}
+
+	const auto view = f.map(0, f.size());
+	const u8* const ptr = view.data();
+	const u64 size = view.size();
+
+	compiled_header header;
+
+	if (size < sizeof(header))
+	{
+		return false;
+	}
+
+	std::memcpy(&header, ptr, sizeof(header));
+
+	if (std::memcmp(header.magic, s_compiled_magic, sizeof(s_compiled_magic)) != 0 || header.version != s_compiled_version || header.hash != hash)
+	{
+		return false;
+	}
+
+	u64 pos = sizeof(header);
+
+	for (u32 i = 0; i < header.count; i++)
+	{
+		compiled_sequence seq;
+
+		if (size - pos < sizeof(seq))
 		{
-			*reinterpret_cast<le_t<u64, 1>*>(ptr) = static_cast<u64>(p.value);
-			break;
+			return false;
 		}
-		case patch_type::be16:
+
+		std::memcpy(&seq, ptr + pos, sizeof(seq));
+		pos += sizeof(seq);
+
+		if (size - pos < seq.name_size)
 		{
-			*reinterpret_cast<be_t<u16, 1>*>(ptr) = static_cast<u16>(p.value);
-			break;
+			return false;
 		}
-		case patch_type::be32:
-		case patch_type::bef32:
+
+		out.emplace_back(std::string(reinterpret_cast<const char*>(ptr + pos), seq.name_size), std::vector<patch_op>(seq.count));
+		pos += seq.name_size;
+
+		for (auto& op : out.back().second)
 		{
-			*reinterpret_cast<be_t<u32, 1>*>(ptr) = static_cast<u32>(p.value);
-			break;
+			compiled_op data;
+
+			if (size - pos < sizeof(data))
+			{
+				return false;
+			}
+
+			std::memcpy(&data, ptr + pos, sizeof(data));
+			pos += sizeof(data);
+
+			if (size - pos < data.load_size || data.size > sizeof(op.info.data))
+			{
+				return false;
+			}
+
+			op.info.offset = data.offset;
+			op.info.size = data.size;
+			std::memcpy(op.info.data, data.data, sizeof(data.data));
+			op.load.assign(reinterpret_cast<const char*>(ptr + pos), data.load_size);
+			pos += data.load_size;
 		}
-		case patch_type::be64:
-		case patch_type::bef64:
+	}
+
+	return pos == size;
+}
+
+void patch_engine::save_compiled(const std::string& path, u64 hash, const patch_list& list)
+{
+	std::string out;
+
+	compiled_header header{};
+	std::memcpy(header.magic, s_compiled_magic, sizeof(s_compiled_magic));
+	header.version = s_compiled_version;
+	header.count = ::size32(list);
+	header.hash = hash;
+	out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	for (const auto& pair : list)
+	{
+		const compiled_sequence seq{::size32(pair.first), ::size32(pair.second)};
+		out.append(reinterpret_cast<const char*>(&seq), sizeof(seq));
+		out += pair.first;
+
+		for (const auto& op : pair.second)
 		{
-			*reinterpret_cast<be_t<u64, 1>*>(ptr) = static_cast<u64>(p.value);
-			break;
-		}
+			compiled_op data{};
+			data.offset = op.info.offset;
+			data.size = op.info.size;
+			std::memcpy(data.data, op.info.data, sizeof(data.data));
+			data.load_size = ::size32(op.load);
+			out.append(reinterpret_cast<const char*>(&data), sizeof(data));
+			out += op.load;
 		}
 	}
 
+	// Write atomically, an interrupted write mustn't leave a truncated file
+	const std::string tmp = path + ".tmp";
+
+	fs::file f(tmp, fs::rewrite);
+
+	if (!f || f.write(out.data(), out.size()) != out.size() || (f.close(), !fs::rename(tmp, path, true)))
+	{
+		LOG_ERROR(GENERAL, "Failed to save compiled patch file %s (%s)", path, fs::g_tls_error);
+		fs::remove_file(tmp);
+	}
+}
+
+std::size_t patch_engine::apply(const std::string& name, u8* dst) const
+{
+	const auto found = m_map.find(name);
+
+	if (found == m_map.cend())
+	{
+		return 0;
+	}
+
+	// Apply modifications sequentially
+	for (const auto& p : found->second)
+	{
+		std::memcpy(dst + p.offset, p.data, p.size);
+	}
+
 	return found->second.size();
 }
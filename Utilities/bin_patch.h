@@ -23,24 +23,37 @@ enum class patch_type
 
 class patch_engine
 {
+	// Patch entry with the value already encoded in the target byte order
 	struct patch
 	{
-		patch_type type;
 		u32 offset;
-		u64 value;
+		u32 size;
+		u8 data[8];
+	};
 
-		template <typename T>
-		T& value_as()
-		{
-			return *reinterpret_cast<T*>(reinterpret_cast<char*>(&value));
-		}
+	// Parsed patch file entry: patch, or copy of the named sequence ("load") if the name is not empty
+	struct patch_op
+	{
+		patch info;
+		std::string load;
 	};
 
+	using patch_list = std::vector<std::pair<std::string, std::vector<patch_op>>>;
+
 	// Database
 	std::unordered_map<std::string, std::vector<patch>> m_map;
 
+	// Parse patch file
+	static bool parse(const std::string& path, const std::string& text, patch_list& out);
+
+	// Load compiled patch file
+	static bool load_compiled(const std::string& path, u64 hash, patch_list& out);
+
+	// Save compiled patch file
+	static void save_compiled(const std::string& path, u64 hash, const patch_list& list);
+
 public:
-	// Load from file
+	// Load from file (the parsed result is cached in a compiled file next to it)
 	void append(const std::string& path);
 
 	// Apply patch (returns the number of entries applied)
@@ -0,0 +1,218 @@
+#include "hash.h"
+#include "types.h"
+#include "sysinfo.h"
+
+#include <cstring>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+static const bool s_use_sse42 =
+#ifdef _MSC_VER
+	utils::has_sse42();
+#elif __SSE4_2__
+	true;
+#else
+	false;
+#endif
+
+static const bool s_use_avx2 =
+#ifdef _MSC_VER
+	utils::has_avx2();
+#elif __AVX2__
+	true;
+#else
+	false;
+#endif
+
+namespace
+{
+	// Reflected CRC-32C polynomial
+	constexpr u32 crc32c_poly = 0x82f63b78;
+
+	struct crc32c_table
+	{
+		u32 data[256];
+
+		crc32c_table()
+		{
+			for (u32 i = 0; i < 256; i++)
+			{
+				u32 crc = i;
+
+				for (u32 j = 0; j < 8; j++)
+				{
+					crc = crc & 1 ? (crc >> 1) ^ crc32c_poly : crc >> 1;
+				}
+
+				data[i] = crc;
+			}
+		}
+	};
+
+	const crc32c_table s_crc32c_table;
+
+	constexpr u64 hash_prime1 = 0x9E3779B185EBCA87ULL;
+	constexpr u64 hash_prime2 = 0xC2B2AE3D27D4EB4FULL;
+	constexpr u64 hash_prime3 = 0x165667B19E3779F9ULL;
+	constexpr u64 hash_prime4 = 0x85EBCA77C2B2AE63ULL;
+
+	// Lane keys mixed into the data before the 32x32 bit multiplication
+	constexpr u64 hash_keys[4] = { 0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL, 0x1f67b3b7a4a44072ULL };
+
+	inline u64 rol64(u64 x, u32 n)
+	{
+		return (x << n) | (x >> (64 - n));
+	}
+
+	// Process 32-byte stripes into 4 accumulator lanes:
+	// acc[i] = rol(acc[i] + data[i ^ 1] + lo32(data[i] ^ key[i]) * hi32(data[i] ^ key[i]), 23)
+	void hash_stripes_scalar(u64* acc, const u8* src, size_t stripes)
+	{
+		for (size_t n = 0; n < stripes; n++, src += 32)
+		{
+			u64 data[4];
+			std::memcpy(data, src, 32);
+
+			for (u32 i = 0; i < 4; i++)
+			{
+				const u64 value = data[i] ^ hash_keys[i];
+				acc[i] = rol64(acc[i] + data[i ^ 1] + (value & 0xffffffff) * (value >> 32), 23);
+			}
+		}
+	}
+
+	void hash_stripes(u64* acc, const u8* src, size_t stripes)
+	{
+#if defined(_MSC_VER) || defined(__AVX2__)
+		if (s_use_avx2)
+		{
+			const __m256i key = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hash_keys));
+			__m256i vacc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc));
+
+			for (size_t n = 0; n < stripes; n++, src += 32)
+			{
+				const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+				const __m256i value = _mm256_xor_si256(data, key);
+				const __m256i product = _mm256_mul_epu32(value, _mm256_srli_epi64(value, 32));
+				const __m256i swapped = _mm256_shuffle_epi32(data, 0x4e);
+				vacc = _mm256_add_epi64(vacc, _mm256_add_epi64(product, swapped));
+				vacc = _mm256_or_si256(_mm256_slli_epi64(vacc, 23), _mm256_srli_epi64(vacc, 41));
+			}
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(acc), vacc);
+			return;
+		}
+#endif
+
+		hash_stripes_scalar(acc, src, stripes);
+	}
+
+	u64 avalanche(u64 hash)
+	{
+		hash ^= hash >> 33;
+		hash *= hash_prime2;
+		hash ^= hash >> 29;
+		hash *= hash_prime3;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	u64 merge_lane(u64 hash, u64 lane)
+	{
+		hash ^= rol64(lane * hash_prime2, 31) * hash_prime1;
+		return hash * hash_prime1 + hash_prime4;
+	}
+
+	void hash_accumulate(u64* acc, const void* data, size_t size, u64 seed)
+	{
+		acc[0] = seed + hash_prime1 + hash_prime2;
+		acc[1] = seed + hash_prime2;
+		acc[2] = seed;
+		acc[3] = seed - hash_prime1;
+
+		const u8* src = static_cast<const u8*>(data);
+
+		hash_stripes(acc, src, size / 32);
+
+		if (const size_t tail = size % 32)
+		{
+			// Zero-padded last stripe, the size is folded in when the lanes are merged
+			u8 last[32]{};
+			std::memcpy(last, src + size - tail, tail);
+			hash_stripes_scalar(acc, last, 1);
+		}
+	}
+}
+
+u32 rpcs3::crc32c(const void* data, size_t size, u32 crc)
+{
+	const u8* src = static_cast<const u8*>(data);
+
+	crc = ~crc;
+
+#if defined(_MSC_VER) || defined(__SSE4_2__)
+	if (s_use_sse42)
+	{
+		u64 crc64 = crc;
+
+		for (; size >= 8; size -= 8, src += 8)
+		{
+			u64 value;
+			std::memcpy(&value, src, 8);
+			crc64 = _mm_crc32_u64(crc64, value);
+		}
+
+		crc = static_cast<u32>(crc64);
+
+		for (; size; size--, src++)
+		{
+			crc = _mm_crc32_u8(crc, *src);
+		}
+
+		return ~crc;
+	}
+#endif
+
+	for (; size; size--, src++)
+	{
+		crc = s_crc32c_table.data[(crc ^ *src) & 0xff] ^ (crc >> 8);
+	}
+
+	return ~crc;
+}
+
+u64 rpcs3::hash64(const void* data, size_t size, u64 seed)
+{
+	u64 acc[4];
+	hash_accumulate(acc, data, size, seed);
+
+	u64 hash = size * hash_prime1;
+
+	for (u32 i = 0; i < 4; i++)
+	{
+		hash = merge_lane(hash, acc[i]);
+	}
+
+	return avalanche(hash);
+}
+
+rpcs3::hash128 rpcs3::hash128_of(const void* data, size_t size, u64 seed)
+{
+	u64 acc[4];
+	hash_accumulate(acc, data, size, seed);
+
+	u64 lo = size * hash_prime1;
+	u64 hi = size * hash_prime3 + hash_prime4;
+
+	for (u32 i = 0; i < 4; i++)
+	{
+		lo = merge_lane(lo, acc[i]);
+		hi = merge_lane(hi, acc[3 - i] ^ hash_prime3);
+	}
+
+	return { avalanche(lo), avalanche(hi) };
+}
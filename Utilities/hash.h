@@ -1,27 +1,53 @@
-#pragma once
-#include <stdint.h>
-
-namespace rpcs3
-{
-	template<typename T>
-	static size_t hash_base(T value)
-	{
-		return static_cast<size_t>(value);
-	}
-
-	template<typename T>
-	static size_t hash_struct(const T& value)
-	{
-		// FNV 64-bit
-		size_t result = 14695981039346656037ull;
-		const unsigned char *bytes = reinterpret_cast<const unsigned char*>(&value);
-
-		for (size_t n = 0; n < sizeof(T); ++n)
-		{
-			result ^= bytes[n];
-			result *= 1099511628211ull;
-		}
-
-		return result;
-	}
-}
\ No newline at end of file
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+namespace rpcs3
+{
+	template<typename T>
+	static size_t hash_base(T value)
+	{
+		return static_cast<size_t>(value);
+	}
+
+	template<typename T>
+	static size_t hash_struct(const T& value)
+	{
+		// FNV 64-bit
+		size_t result = 14695981039346656037ull;
+		const unsigned char *bytes = reinterpret_cast<const unsigned char*>(&value);
+
+		for (size_t n = 0; n < sizeof(T); ++n)
+		{
+			result ^= bytes[n];
+			result *= 1099511628211ull;
+		}
+
+		return result;
+	}
+
+	struct hash128
+	{
+		uint64_t lo;
+		uint64_t hi;
+
+		bool operator ==(const hash128& rhs) const
+		{
+			return lo == rhs.lo && hi == rhs.hi;
+		}
+
+		bool operator !=(const hash128& rhs) const
+		{
+			return lo != rhs.lo || hi != rhs.hi;
+		}
+	};
+
+	// CRC-32C (Castagnoli) of the data, continued from the previous result (uses the SSE4.2 CRC32 instruction if available)
+	uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+	// Fast non-cryptographic hash of the data (uses AVX2 if available, the result doesn't depend on the instruction set)
+	uint64_t hash64(const void* data, size_t size, uint64_t seed = 0);
+
+	// Same as hash64 with a 128-bit result, for keys which aren't compared with the original data
+	hash128 hash128_of(const void* data, size_t size, uint64_t seed = 0);
+}
@@ -1,29 +1,107 @@
 #include "mutex.h"
 #include "sync.h"
 
+#include "Log.h"
+#include "File.h"
+
 #include <climits>
 #include <vector>
 #include <algorithm>
+#include <chrono>
 
 // TLS variable for tracking owned mutexes
 thread_local std::vector<shared_mutex*> g_tls_locks;
 
-void shared_mutex::imp_lock_shared(s64 _old)
+static atomic_t<bool> g_lock_stats{false};
+
+// List of lock classes with counters
+static atomic_t<lock_class*> g_lock_classes{nullptr};
+
+static u64 get_lock_time()
 {
-	verify("shared_mutex overflow" HERE), _old <= c_max;
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-	for (int i = 0; i < 10; i++)
+u64 lock_class::begin_wait()
+{
+	return g_lock_stats ? get_lock_time() : 0;
+}
+
+void lock_class::end_wait(u64 start, bool slept)
+{
+	if (!start)
 	{
-		busy_wait();
+		return;
+	}
 
-		const s64 value = m_value.load();
+	const u64 time = get_lock_time() - start;
+
+	waits++;
+	wait_time += time;
+	hist[std::min<u64>(time >> 8 ? 64 - cntlz64(time >> 8) : 0, 15)]++;
+
+	if (slept)
+	{
+		sleeps++;
+	}
+
+	if (!listed.exchange(true))
+	{
+		next = g_lock_classes.exchange(this);
+	}
+}
 
-		if (value >= c_min && m_value.compare_and_swap_test(value, value - c_min))
+void lock_class::enable_stats(bool enable)
+{
+	g_lock_stats = enable;
+}
+
+lock_class* lock_class::get_first()
+{
+	return g_lock_classes;
+}
+
+void lock_class::report(const std::string& path)
+{
+	std::string dump;
+
+	for (lock_class* cls = g_lock_classes; cls; cls = cls->next)
+	{
+		LOG_NOTICE(GENERAL, "Lock %s: %u contended, %u slept, %.3f ms waited, spin %u/%u", cls->name, +cls->waits, +cls->sleeps, cls->wait_time / 1000000., cls->spin8 / 8, cls->max_spin);
+
+		fmt::append(dump, "%s: %u contended, %u slept, %.3f ms waited\n", cls->name, +cls->waits, +cls->sleeps, cls->wait_time / 1000000.);
+
+		for (u32 i = 0; i < 16; i++)
 		{
-			return;
+			if (const u64 count = cls->hist[i])
+			{
+				fmt::append(dump, "\t%s%u ns: %u\n", i == 15 ? ">= " : "< ", i == 15 ? 256u << 14 : 256u << i, count);
+			}
 		}
 	}
 
+	if (!path.empty() && !dump.empty())
+	{
+		fs::file(path, fs::rewrite).write(dump);
+	}
+}
+
+void shared_mutex::imp_lock_shared(s64 _old)
+{
+	verify("shared_mutex overflow" HERE), _old <= c_max;
+
+	lock_class::wait_scope scope(m_class);
+
+	if (lock_class::spin(m_class, [&]
+	{
+		const s64 value = m_value.load();
+		return value >= c_min && m_value.compare_and_swap_test(value, value - c_min);
+	}))
+	{
+		scope.slept = false;
+		return;
+	}
+
 #ifdef _WIN32
 	// Acquire writer lock
 	imp_wait(m_value.load());
@@ -171,16 +249,15 @@ void shared_mutex::imp_lock(s64 _old)
 {
 	verify("shared_mutex overflow" HERE), _old <= c_max;
 
-	for (int i = 0; i < 10; i++)
-	{
-		busy_wait();
-
-		const s64 value = m_value.load();
+	lock_class::wait_scope scope(m_class);
 
-		if (value == c_one && m_value.compare_and_swap_test(c_one, 0))
-		{
-			return;
-		}
+	if (lock_class::spin(m_class, [&]
+	{
+		return m_value.load() == c_one && m_value.compare_and_swap_test(c_one, 0);
+	}))
+	{
+		scope.slept = false;
+		return;
 	}
 
 	imp_wait(m_value.load());
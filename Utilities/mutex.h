@@ -2,6 +2,7 @@
 
 #include "types.h"
 #include "Atomic.h"
+#include "sema.h"
 
 // Shared mutex.
 class shared_mutex final
@@ -16,6 +17,8 @@ class shared_mutex final
 
 	atomic_t<s64> m_value{c_one}; // Semaphore-alike counter
 
+	lock_class* m_class = nullptr; // Spinning parameters (optional)
+
 	void imp_lock_shared(s64 _old);
 	void imp_unlock_shared(s64 _old);
 	void imp_wait(s64 _old);
@@ -28,6 +31,11 @@ class shared_mutex final
 public:
 	constexpr shared_mutex() = default;
 
+	constexpr explicit shared_mutex(lock_class& _class)
+		: m_class(&_class)
+	{
+	}
+
 	bool try_lock_shared();
 
 	void lock_shared()
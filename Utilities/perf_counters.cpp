@@ -0,0 +1,245 @@
+#include "perf_counters.h"
+#include "StrFmt.h"
+#include "Log.h"
+
+#include <thread>
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <WS2tcpip.h>
+#else
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+namespace perf
+{
+	static atomic_t<metric*> s_metrics{nullptr};
+
+	static atomic_t<u32> s_next_shard{0};
+
+	static atomic_t<bool> s_server_started{false};
+
+	counter rsx_flips{"rsx_flips_total", "Frames presented by the RSX"};
+	counter rsx_draw_calls{"rsx_draw_calls_total", "Draw calls issued to the backend"};
+	histogram rsx_draws_per_frame{"rsx_draws_per_frame", "Draw calls issued to the backend between two flips"};
+	histogram rsx_frame_time_us{"rsx_frame_time_us", "Time between two flips in microseconds"};
+	counter rsx_texture_cache_hits{"rsx_texture_cache_hits_total", "Sampled textures found in the texture or surface cache"};
+	counter rsx_texture_cache_misses{"rsx_texture_cache_misses_total", "Sampled textures uploaded from guest memory"};
+	counter rsx_pipelines_compiled{"rsx_pipelines_compiled_total", "Backend pipelines built by the program cache"};
+	counter ppu_objects_compiled{"ppu_objects_compiled_total", "PPU LLVM objects compiled or loaded from the cache"};
+	counter spu_functions_compiled{"spu_functions_compiled_total", "SPU functions compiled, including the SPU cache build"};
+	gauge spu_compile_queue{"spu_compile_queue", "SPU functions waiting for or being compiled"};
+	counter lv2_syscalls{"lv2_syscalls_total", "LV2 syscalls executed by PPU threads"};
+	counter ppu_reservation_failures{"ppu_reservation_failures_total", "Failed PPU conditional stores (stwcx, stdcx)"};
+	counter spu_reservation_failures{"spu_reservation_failures_total", "Failed SPU conditional stores (putllc)"};
+	counter fs_read_bytes{"fs_read_bytes_total", "Bytes read by sys_fs_read"};
+	counter fs_write_bytes{"fs_write_bytes_total", "Bytes written by sys_fs_write"};
+}
+
+perf::metric::metric(const char* name, const char* help, metric_type type)
+	: m_next(s_metrics)
+	, m_name(name)
+	, m_help(help)
+	, m_type(type)
+{
+	while (!s_metrics.compare_and_swap_test(m_next, this))
+	{
+		m_next = s_metrics;
+	}
+}
+
+u32 perf::get_shard_index()
+{
+	return s_next_shard++;
+}
+
+u64 perf::counter::get() const
+{
+	u64 result = 0;
+
+	for (const shard& s : m_shards)
+	{
+		result += s.value.load();
+	}
+
+	return result;
+}
+
+void perf::counter::append_samples(std::string& out) const
+{
+	fmt::append(out, "rpcs3_%s %llu\n", m_name, get());
+}
+
+void perf::gauge::append_samples(std::string& out) const
+{
+	fmt::append(out, "rpcs3_%s %lld\n", m_name, get());
+}
+
+void perf::histogram::append_samples(std::string& out) const
+{
+	u64 buckets[bucket_count];
+	u32 used = 0;
+
+	for (u32 i = 0; i < bucket_count; i++)
+	{
+		buckets[i] = m_buckets[i].load();
+
+		if (buckets[i])
+		{
+			used = i + 1;
+		}
+	}
+
+	// Buckets are cumulative, bucket i holds the values up to 2^i - 1
+	u64 count = 0;
+
+	for (u32 i = 0; i < used; i++)
+	{
+		count += buckets[i];
+		fmt::append(out, "rpcs3_%s_bucket{le=\"%llu\"} %llu\n", m_name, (1ull << i) - 1, count);
+	}
+
+	fmt::append(out, "rpcs3_%s_bucket{le=\"+Inf\"} %llu\n", m_name, count);
+	fmt::append(out, "rpcs3_%s_sum %llu\n", m_name, m_sum.load());
+	fmt::append(out, "rpcs3_%s_count %llu\n", m_name, count);
+}
+
+std::string perf::collect()
+{
+	static const char* const s_type_names[] = { "counter", "gauge", "histogram" };
+
+	std::string out;
+
+	for (const metric* m = s_metrics; m; m = m->m_next)
+	{
+		fmt::append(out, "# HELP rpcs3_%s %s\n", m->m_name, m->m_help);
+		fmt::append(out, "# TYPE rpcs3_%s %s\n", m->m_name, s_type_names[static_cast<u8>(m->m_type)]);
+		m->append_samples(out);
+	}
+
+	return out;
+}
+
+void perf::start_server(u16 port)
+{
+	if (!port || s_server_started.exchange(true))
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	using socket_t = SOCKET;
+	const auto close_socket = [](socket_t s) { ::closesocket(s); };
+
+	WSADATA wsa_data;
+	::WSAStartup(MAKEWORD(2, 2), &wsa_data);
+#else
+	using socket_t = int;
+	const socket_t INVALID_SOCKET = -1;
+	const auto close_socket = [](socket_t s) { ::close(s); };
+#endif
+
+	const socket_t server = ::socket(AF_INET, SOCK_STREAM, 0);
+
+	if (server == INVALID_SOCKET)
+	{
+		LOG_ERROR(GENERAL, "Performance counters: failed to create the server socket");
+		return;
+	}
+
+	const int reuse = 1;
+	::setsockopt(server, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+	// Only local clients may connect, the counters are not meant to be exposed to the network
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if (::bind(server, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(server, 4) != 0)
+	{
+		LOG_ERROR(GENERAL, "Performance counters: failed to listen on port %u", port);
+		close_socket(server);
+		return;
+	}
+
+	LOG_SUCCESS(GENERAL, "Performance counters are served on http://127.0.0.1:%u/metrics", port);
+
+	std::thread([=]()
+	{
+		while (true)
+		{
+			const socket_t client = ::accept(server, nullptr, nullptr);
+
+			if (client == INVALID_SOCKET)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				continue;
+			}
+
+			// Don't let a stalled client block the other scrapers
+#ifdef _WIN32
+			const DWORD timeout = 1000;
+#else
+			const timeval timeout{1, 0};
+#endif
+			::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+			::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+
+			// The request itself is ignored, every path returns the metrics. Read it up to the end of the headers so the client doesn't see a reset.
+			char request[1024];
+			std::size_t size = 0;
+
+			while (size < sizeof(request) - 1)
+			{
+				const auto result = ::recv(client, request + size, static_cast<int>(sizeof(request) - 1 - size), 0);
+
+				if (result <= 0)
+				{
+					break;
+				}
+
+				size += result;
+				request[size] = '\0';
+
+				if (std::strstr(request, "\r\n\r\n") || std::strstr(request, "\n\n"))
+				{
+					break;
+				}
+			}
+
+			const std::string body = collect();
+			std::string response = fmt::format("HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %u\r\nConnection: close\r\n\r\n", body.size());
+			response += body;
+
+#ifdef MSG_NOSIGNAL
+			// A client hanging up early must not raise SIGPIPE
+			const int send_flags = MSG_NOSIGNAL;
+#else
+			const int send_flags = 0;
+#endif
+
+			for (std::size_t pos = 0; pos < response.size();)
+			{
+				const auto result = ::send(client, response.data() + pos, static_cast<int>(response.size() - pos), send_flags);
+
+				if (result <= 0)
+				{
+					break;
+				}
+
+				pos += result;
+			}
+
+			close_socket(client);
+		}
+	}).detach();
+}
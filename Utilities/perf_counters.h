@@ -0,0 +1,154 @@
+#pragma once
+
+#include "types.h"
+#include "Atomic.h"
+
+#include <string>
+#include <algorithm>
+
+// Runtime performance counters, cheap enough to stay always on.
+// All metrics register themselves in a process-wide list which can be scraped over a local socket (Prometheus text format).
+namespace perf
+{
+	enum class metric_type : u8
+	{
+		counter,
+		gauge,
+		histogram,
+	};
+
+	class metric
+	{
+		// Intrusive list of all metrics (metrics are static objects and are never unregistered)
+		metric* m_next;
+
+		friend std::string collect();
+
+	protected:
+		const char* const m_name;
+		const char* const m_help;
+		const metric_type m_type;
+
+		// Name and help must be string literals, the name gets the rpcs3_ prefix on export
+		metric(const char* name, const char* help, metric_type type);
+
+		metric(const metric&) = delete;
+
+		// Append sample lines in text exposition format
+		virtual void append_samples(std::string& out) const = 0;
+	};
+
+	// Get the counter shard of the calling thread
+	u32 get_shard_index();
+
+	// Monotonically increasing value, sharded so that hot paths of different threads don't share a cache line.
+	// Rates (per second) are left to the scraper.
+	class counter final : public metric
+	{
+		static constexpr u32 shard_count = 16;
+
+		struct alignas(64) shard
+		{
+			atomic_t<u64> value{0};
+		};
+
+		shard m_shards[shard_count];
+
+		void append_samples(std::string& out) const override;
+
+	public:
+		counter(const char* name, const char* help)
+			: metric(name, help, metric_type::counter)
+		{
+		}
+
+		void add(u64 value = 1)
+		{
+			static thread_local const u32 index = get_shard_index() % shard_count;
+			m_shards[index].value += value;
+		}
+
+		u64 get() const;
+	};
+
+	// Value which can go up and down (queue depths, sizes)
+	class gauge final : public metric
+	{
+		atomic_t<s64> m_value{0};
+
+		void append_samples(std::string& out) const override;
+
+	public:
+		gauge(const char* name, const char* help)
+			: metric(name, help, metric_type::gauge)
+		{
+		}
+
+		void add(s64 value = 1)
+		{
+			m_value += value;
+		}
+
+		void sub(s64 value = 1)
+		{
+			m_value -= value;
+		}
+
+		void set(s64 value)
+		{
+			m_value = value;
+		}
+
+		s64 get() const
+		{
+			return m_value;
+		}
+	};
+
+	// Distribution of non-negative integers in power of two buckets (bucket i holds the values with bit length i).
+	// Not sharded, meant for per-frame or per-compile events rather than hot paths.
+	class histogram final : public metric
+	{
+		static constexpr u32 bucket_count = 41;
+
+		atomic_t<u64> m_buckets[bucket_count]{};
+		atomic_t<u64> m_sum{0};
+
+		void append_samples(std::string& out) const override;
+
+	public:
+		histogram(const char* name, const char* help)
+			: metric(name, help, metric_type::histogram)
+		{
+		}
+
+		void observe(u64 value)
+		{
+			m_buckets[std::min<u64>(64 - cntlz64(value), bucket_count - 1)]++;
+			m_sum += value;
+		}
+	};
+
+	// Well-known metrics of the emulator
+	extern counter rsx_flips;
+	extern counter rsx_draw_calls;
+	extern histogram rsx_draws_per_frame;
+	extern histogram rsx_frame_time_us;
+	extern counter rsx_texture_cache_hits;
+	extern counter rsx_texture_cache_misses;
+	extern counter rsx_pipelines_compiled;
+	extern counter ppu_objects_compiled;
+	extern counter spu_functions_compiled;
+	extern gauge spu_compile_queue;
+	extern counter lv2_syscalls;
+	extern counter ppu_reservation_failures;
+	extern counter spu_reservation_failures;
+	extern counter fs_read_bytes;
+	extern counter fs_write_bytes;
+
+	// Format all registered metrics
+	std::string collect();
+
+	// Serve collect() over HTTP on 127.0.0.1:port from a background thread (once per process, 0 does nothing)
+	void start_server(u16 port);
+}
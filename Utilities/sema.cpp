@@ -3,16 +3,16 @@
 
 void semaphore_base::imp_wait()
 {
-	for (int i = 0; i < 10; i++)
-	{
-		busy_wait();
+	lock_class::wait_scope scope(m_class);
 
+	if (lock_class::spin(m_class, [&]
+	{
 		const s32 value = m_value.load();
-
-		if (value > 0 && m_value.compare_and_swap_test(value, value - 1))
-		{
-			return;
-		}
+		return value > 0 && m_value.compare_and_swap_test(value, value - 1);
+	}))
+	{
+		scope.slept = false;
+		return;
 	}
 
 #ifdef _WIN32
@@ -3,12 +3,109 @@
 #include "types.h"
 #include "Atomic.h"
 
+#include <string>
+#include <algorithm>
+
+// Lock class: spinning limit and optional contention counters shared by a group of locks
+struct lock_class
+{
+	const char* const name;
+	const u32 max_spin; // Max busy wait rounds before sleeping
+
+	atomic_t<u32> spin8; // Adaptive spin count estimate (fixed point, 1/8)
+	atomic_t<u64> waits{0}; // Contended acquisitions
+	atomic_t<u64> sleeps{0}; // Contended acquisitions which had to sleep
+	atomic_t<u64> wait_time{0}; // Total time of contended acquisitions (ns)
+	atomic_t<u64> hist[16]{}; // Contended acquisition latency histogram (bucket 0: < 256 ns, each next bucket doubles)
+	atomic_t<lock_class*> next{nullptr}; // Next class with counters (contended classes are listed on demand)
+	atomic_t<bool> listed{false};
+
+	constexpr lock_class(const char* name, u32 max_spin = 10)
+		: name(name)
+		, max_spin(max_spin)
+		, spin8(max_spin * 8)
+	{
+	}
+
+	// Spin with PAUSE backoff until try_acquire() succeeds, return false if the caller should sleep
+	template <typename F>
+	static bool spin(lock_class* _class, F&& try_acquire)
+	{
+		// Locks without class keep a fixed spin count, classes adapt it to how long their locks are usually held
+		const u32 limit = _class ? std::min<u32>(_class->max_spin, _class->spin8 / 4 + 1) : 10;
+
+		u32 count = 0;
+		bool result = false;
+
+		for (u32 cycles = 300; count < limit; cycles = std::min<u32>(cycles * 2, 3000))
+		{
+			busy_wait(cycles);
+			count++;
+
+			if (try_acquire())
+			{
+				result = true;
+				break;
+			}
+		}
+
+		if (_class)
+		{
+			// Running average (racy updates are harmless)
+			const u32 spin8 = _class->spin8;
+			_class->spin8 = spin8 + count - spin8 / 8;
+		}
+
+		return result;
+	}
+
+	// Start measuring contended acquisition (returns 0 if counters are disabled)
+	static u64 begin_wait();
+
+	// Finish measuring contended acquisition
+	void end_wait(u64 start, bool slept);
+
+	// Measures contended acquisition in its scope
+	struct wait_scope
+	{
+		lock_class* const cls;
+		const u64 start;
+		bool slept = true;
+
+		wait_scope(lock_class* _class)
+			: cls(_class)
+			, start(_class ? begin_wait() : 0)
+		{
+		}
+
+		~wait_scope()
+		{
+			if (start)
+			{
+				cls->end_wait(start, slept);
+			}
+		}
+	};
+
+	// Enable contention counters
+	static void enable_stats(bool enable);
+
+	// Get first listed lock class
+	static lock_class* get_first();
+
+	// Log counters of all listed lock classes, write histograms to the file if the path is not empty
+	static void report(const std::string& path);
+};
+
 // Lightweight semaphore helper class
 class semaphore_base
 {
 	// Semaphore value
 	atomic_t<s32> m_value;
 
+	// Spinning parameters (optional)
+	lock_class* m_class = nullptr;
+
 	void imp_wait();
 
 	void imp_post(s32 _old);
@@ -21,6 +118,12 @@ protected:
 	{
 	}
 
+	constexpr semaphore_base(s32 value, lock_class* _class)
+		: m_value{value}
+		, m_class(_class)
+	{
+	}
+
 	void wait()
 	{
 		// Load value
@@ -83,6 +186,12 @@ public:
 	{
 	}
 
+	// Constructor with lock class
+	explicit constexpr semaphore(lock_class& _class)
+		: base{Def, &_class}
+	{
+	}
+
 	// Obtain a semaphore
 	void wait()
 	{
@@ -5,8 +5,11 @@
 #include "windows.h"
 #else
 #include <unistd.h>
+#include <fstream>
 #endif
 
+#include <algorithm>
+
 bool utils::has_ssse3()
 {
 	static const bool g_value = get_cpuid(0, 0)[0] >= 0x1 && get_cpuid(1, 0)[2] & 0x200;
@@ -19,6 +22,32 @@ bool utils::has_sse41()
 	return g_value;
 }
 
+bool utils::has_sse42()
+{
+	static const bool g_value = get_cpuid(0, 0)[0] >= 0x1 && get_cpuid(1, 0)[2] & 0x100000;
+	return g_value;
+}
+
+bool utils::has_aes()
+{
+	static const bool g_value = get_cpuid(0, 0)[0] >= 0x1 && get_cpuid(1, 0)[2] & 0x2000000;
+	return g_value;
+}
+
+bool utils::has_vaes()
+{
+	// VAES with 256-bit registers (requires AVX2 for the surrounding code)
+	static const bool g_value = has_avx2() && get_cpuid(7, 0)[2] & 0x200;
+	return g_value;
+}
+
+bool utils::has_sha()
+{
+	// SHA extensions (the SHA-1 code also uses SSSE3 and SSE4.1)
+	static const bool g_value = has_sse41() && get_cpuid(0, 0)[0] >= 0x7 && get_cpuid(7, 0)[1] & 0x20000000;
+	return g_value;
+}
+
 bool utils::has_avx()
 {
 	static const bool g_value = get_cpuid(0, 0)[0] >= 0x1 && get_cpuid(1, 0)[2] & 0x10000000 && (get_cpuid(1, 0)[2] & 0x0C000000) == 0x0C000000 && (get_xgetbv(0) & 0x6) == 0x6;
@@ -31,6 +60,12 @@ bool utils::has_avx2()
 	return g_value;
 }
 
+bool utils::has_fma3()
+{
+	static const bool g_value = has_avx() && get_cpuid(1, 0)[2] & 0x1000;
+	return g_value;
+}
+
 bool utils::has_rtm()
 {
 	static const bool g_value = get_cpuid(0, 0)[0] >= 0x7 && (get_cpuid(7, 0)[1] & 0x800) == 0x800;
@@ -50,6 +85,13 @@ bool utils::has_512()
 	return g_value;
 }
 
+bool utils::has_vbmi()
+{
+	// AVX512_VBMI (byte permutes, Cannon Lake and Ice Lake)
+	static const bool g_value = has_512() && get_cpuid(7, 0)[2] & 0x2;
+	return g_value;
+}
+
 bool utils::has_xop()
 {
 	static const bool g_value = has_avx() && get_cpuid(0x80000001, 0)[2] & 0x800;
@@ -127,3 +169,175 @@ std::string utils::get_system_info()
 
 	return result;
 }
+
+#ifdef __linux__
+namespace
+{
+	bool read_sysfs(const std::string& path, std::string& out)
+	{
+		std::ifstream file(path);
+		return static_cast<bool>(std::getline(file, out));
+	}
+
+	// Parses processor lists such as "0-3,8,10-11"
+	std::vector<u32> parse_cpu_list(const std::string& list)
+	{
+		std::vector<u32> result;
+
+		for (std::size_t pos = 0; pos < list.size();)
+		{
+			std::size_t end = list.find(',', pos);
+			if (end == std::string::npos)
+				end = list.size();
+
+			const std::string range = list.substr(pos, end - pos);
+			const std::size_t dash = range.find('-');
+
+			if (!range.empty())
+			{
+				const u32 first = std::stoul(range.substr(0, dash));
+				const u32 last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+
+				for (u32 n = first; n <= last; n++)
+					result.push_back(n);
+			}
+
+			pos = end + 1;
+		}
+
+		return result;
+	}
+}
+#endif
+
+const std::vector<utils::logical_cpu>& utils::get_cpu_topology()
+{
+	static const std::vector<logical_cpu> g_value = []()
+	{
+		std::vector<logical_cpu> result;
+
+#ifdef _WIN32
+		DWORD length = 0;
+		::GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+
+		if (::GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+			return result;
+
+		std::vector<u8> buffer(length);
+		if (!::GetLogicalProcessorInformationEx(RelationAll, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length))
+			return result;
+
+		// Only processor group 0 fits the affinity masks
+		logical_cpu cpus[64] = {};
+		u64 present = 0;
+		u32 cache_level[64] = {};
+		u32 core_count = 0;
+
+		for (DWORD offset = 0; offset < length;)
+		{
+			const auto info = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data() + offset);
+
+			if (info->Relationship == RelationProcessorCore && info->Processor.GroupMask[0].Group == 0)
+			{
+				const u64 mask = info->Processor.GroupMask[0].Mask;
+
+				for (u32 n = 0; n < 64; n++)
+				{
+					if (mask & (1ull << n))
+					{
+						cpus[n].index = n;
+						cpus[n].core = core_count;
+						cpus[n].efficiency = info->Processor.EfficiencyClass;
+						present |= 1ull << n;
+					}
+				}
+
+				core_count++;
+			}
+			else if (info->Relationship == RelationCache && info->Cache.GroupMask.Group == 0 &&
+				(info->Cache.Type == CacheUnified || info->Cache.Type == CacheData))
+			{
+				const u64 mask = info->Cache.GroupMask.Mask;
+				const u32 first = mask ? static_cast<u32>(cnttz64(mask, true)) : 0;
+
+				for (u32 n = 0; n < 64; n++)
+				{
+					if ((mask & (1ull << n)) && info->Cache.Level >= cache_level[n])
+					{
+						cache_level[n] = info->Cache.Level;
+						cpus[n].cache_domain = first;
+					}
+				}
+			}
+
+			offset += info->Size;
+		}
+
+		for (u32 n = 0; n < 64; n++)
+		{
+			if (present & (1ull << n))
+				result.push_back(cpus[n]);
+		}
+#elif defined(__linux__)
+		const std::string base = "/sys/devices/system/cpu/cpu";
+
+		// Hybrid Intel parts list their efficiency cores separately
+		std::vector<u32> atom_cpus;
+		std::string line;
+
+		if (read_sysfs("/sys/devices/cpu_atom/cpus", line))
+			atom_cpus = parse_cpu_list(line);
+
+		const u32 count = std::min<u32>(::sysconf(_SC_NPROCESSORS_CONF), 64);
+
+		for (u32 n = 0; n < count; n++)
+		{
+			const std::string dir = base + std::to_string(n);
+
+			std::string package, core;
+			if (!read_sysfs(dir + "/topology/physical_package_id", package) || !read_sysfs(dir + "/topology/core_id", core))
+				continue;
+
+			logical_cpu cpu{};
+			cpu.index = n;
+			cpu.core = (std::stoul(package) << 16) | std::stoul(core);
+			cpu.cache_domain = n;
+
+			// The highest cache level wins
+			u32 best_level = 0;
+			for (u32 index = 0;; index++)
+			{
+				const std::string cache = dir + "/cache/index" + std::to_string(index);
+
+				std::string level, type, shared;
+				if (!read_sysfs(cache + "/level", level))
+					break;
+
+				if (!read_sysfs(cache + "/type", type) || type == "Instruction" || !read_sysfs(cache + "/shared_cpu_list", shared))
+					continue;
+
+				const auto sharing = parse_cpu_list(shared);
+				if (std::stoul(level) >= best_level && !sharing.empty())
+				{
+					best_level = std::stoul(level);
+					cpu.cache_domain = sharing[0];
+				}
+			}
+
+			if (!atom_cpus.empty())
+			{
+				cpu.efficiency = std::count(atom_cpus.begin(), atom_cpus.end(), n) ? 0 : 1;
+			}
+			else if (read_sysfs(dir + "/cpu_capacity", line))
+			{
+				cpu.efficiency = std::stoul(line);
+			}
+
+			result.push_back(cpu);
+		}
+#endif
+		return result;
+	}();
+
+	return g_value;
+}
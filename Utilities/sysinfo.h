@@ -2,6 +2,7 @@
 
 #include "types.h"
 #include <string>
+#include <vector>
 
 namespace utils
 {
@@ -31,17 +32,41 @@ namespace utils
 
 	bool has_sse41();
 
+	bool has_sse42();
+
+	bool has_aes();
+
+	bool has_vaes();
+
+	bool has_sha();
+
 	bool has_avx();
 
 	bool has_avx2();
 
+	bool has_fma3();
+
 	bool has_rtm();
 
 	bool has_mpx();
 
 	bool has_512();
 
+	bool has_vbmi();
+
 	bool has_xop();
 
 	std::string get_system_info();
+
+	// Logical processor as reported by the OS
+	struct logical_cpu
+	{
+		u32 index; // OS processor number, bit in the affinity mask
+		u32 core; // Physical core, shared by SMT siblings
+		u32 cache_domain; // Lowest processor number sharing the last level cache
+		u32 efficiency; // Higher is faster, the same for all processors of non-hybrid parts
+	};
+
+	// Core and cache hierarchy of the host (first 64 processors), empty if the OS doesn't expose it
+	const std::vector<logical_cpu>& get_cpu_topology();
 }
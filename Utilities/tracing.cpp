@@ -0,0 +1,234 @@
+#include "tracing.h"
+#include "StrFmt.h"
+#include "File.h"
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+extern thread_local std::string(*g_tls_log_prefix)();
+
+namespace tracing
+{
+	atomic_t<bool> g_enabled{false};
+
+	struct event
+	{
+		u64 start;
+		u64 end;
+		const char* name;
+		const char* arg_names;
+		u64 args[3];
+		u32 tid;
+		category cat;
+	};
+
+	// Event ring of a single thread (one writer; read on export when the emulator threads are stopped)
+	struct ring
+	{
+		std::array<event, 0x2000> events;
+		atomic_t<u64> pos{0};
+		std::string name;
+		u32 tid;
+	};
+
+	static const char* const s_category_names[] = { "ppu_jit", "spu_jit", "rsx", "lv2", "fs", "shader" };
+
+	static std::mutex s_mutex;
+
+	// All rings ever created (rings of finished threads are removed when recording restarts)
+	static std::vector<std::shared_ptr<ring>> s_rings;
+
+	static std::unordered_map<u32, std::string> s_guest_names;
+
+	static u32 s_next_tid = 1;
+
+	static thread_local std::shared_ptr<ring> g_tls_ring;
+}
+
+u64 tracing::get_time()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void tracing::record(category cat, const char* name, u64 start, u64 end, u32 tid, const char* arg_names, u64 a0, u64 a1, u64 a2)
+{
+	if (UNLIKELY(!g_tls_ring))
+	{
+		auto r = std::make_shared<ring>();
+		r->name = g_tls_log_prefix();
+
+		std::lock_guard<std::mutex> lock(s_mutex);
+		r->tid = s_next_tid++;
+
+		if (r->name.empty())
+		{
+			r->name = fmt::format("Thread %u", r->tid);
+		}
+
+		s_rings.emplace_back(r);
+		g_tls_ring = std::move(r);
+	}
+
+	auto& r = *g_tls_ring;
+	const u64 pos = r.pos;
+	auto& e = r.events[pos % r.events.size()];
+	e.start = start;
+	e.end = end;
+	e.name = name;
+	e.arg_names = arg_names;
+	e.args[0] = a0;
+	e.args[1] = a1;
+	e.args[2] = a2;
+	e.tid = tid;
+	e.cat = cat;
+	r.pos = pos + 1;
+}
+
+void tracing::set_enabled(bool enabled)
+{
+	if (enabled)
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+
+		s_rings.erase(std::remove_if(s_rings.begin(), s_rings.end(), [](const std::shared_ptr<ring>& r)
+		{
+			return r.use_count() == 1;
+		}), s_rings.end());
+
+		for (auto& r : s_rings)
+		{
+			r->pos = 0;
+		}
+
+		s_guest_names.clear();
+	}
+
+	g_enabled = enabled;
+}
+
+void tracing::set_guest_thread_name(u32 tid, const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	s_guest_names[tid] = name;
+}
+
+static std::string escape_json(const std::string& str)
+{
+	std::string result;
+
+	for (char c : str)
+	{
+		if (c == '"' || c == '\\')
+		{
+			result += '\\';
+			result += c;
+		}
+		else if (static_cast<u8>(c) >= 0x20)
+		{
+			result += c;
+		}
+	}
+
+	return result;
+}
+
+u64 tracing::export_json(const std::string& path)
+{
+	std::vector<std::pair<const event*, u32>> events;
+
+	std::string out = "{\"traceEvents\":[\n"
+		"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Host\"}},\n"
+		"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"Guest\"}},\n";
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	for (const auto& r : s_rings)
+	{
+		const u64 pos = r->pos;
+		const u64 count = std::min<u64>(pos, r->events.size());
+
+		if (!count)
+		{
+			continue;
+		}
+
+		fmt::append(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}},\n", r->tid, escape_json(r->name));
+
+		for (u64 i = pos - count; i < pos; i++)
+		{
+			events.emplace_back(&r->events[i % r->events.size()], r->tid);
+		}
+	}
+
+	if (events.empty())
+	{
+		return 0;
+	}
+
+	for (const auto& pair : s_guest_names)
+	{
+		fmt::append(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":2,\"tid\":%u,\"args\":{\"name\":\"%s\"}},\n", pair.first, escape_json(pair.second));
+	}
+
+	std::stable_sort(events.begin(), events.end(), [](const std::pair<const event*, u32>& a, const std::pair<const event*, u32>& b)
+	{
+		return a.first->start < b.first->start;
+	});
+
+	const u64 base_time = events[0].first->start;
+
+	for (const auto& pair : events)
+	{
+		const event& e = *pair.first;
+		const u32 pid = e.tid ? 2 : 1;
+		const u32 tid = e.tid ? e.tid : pair.second;
+
+		fmt::append(out, "{\"name\":\"%s\",\"cat\":\"%s\",\"ts\":%llu,\"pid\":%u,\"tid\":%u,", e.name, s_category_names[static_cast<u8>(e.cat)], e.start - base_time, pid, tid);
+
+		if (e.end > e.start)
+		{
+			fmt::append(out, "\"ph\":\"X\",\"dur\":%llu", e.end - e.start);
+		}
+		else
+		{
+			out += "\"ph\":\"i\",\"s\":\"t\"";
+		}
+
+		if (e.arg_names)
+		{
+			out += ",\"args\":{";
+
+			const char* name = e.arg_names;
+
+			for (u32 i = 0; i < 3 && *name; i++)
+			{
+				const char* next = std::strchr(name, ',');
+				const std::size_t size = next ? next - name : std::strlen(name);
+
+				fmt::append(out, "%s\"%s\":%llu", i ? "," : "", std::string(name, size), e.args[i]);
+
+				name = next ? next + 1 : name + size;
+			}
+
+			out += '}';
+		}
+
+		out += "},\n";
+	}
+
+	// Replace the trailing comma
+	out.resize(out.size() - 2);
+	out += "\n]}\n";
+
+	if (!fs::file(path, fs::rewrite).write(out))
+	{
+		return 0;
+	}
+
+	return events.size();
+}
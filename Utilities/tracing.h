@@ -0,0 +1,94 @@
+#pragma once
+
+#include "types.h"
+#include "Atomic.h"
+
+#include <string>
+#include <algorithm>
+
+// Emulator-wide event trace, exported in Chrome trace event format (also readable by Perfetto)
+namespace tracing
+{
+	enum class category : u8
+	{
+		ppu_jit,
+		spu_jit,
+		rsx,
+		lv2,
+		fs,
+		shader,
+	};
+
+	extern atomic_t<bool> g_enabled;
+
+	// Current trace time (us)
+	u64 get_time();
+
+	// Record an event in the ring of the calling thread (name and arg_names must be string literals).
+	// Events with non-zero tid are attributed to the guest thread with this ID instead of the host thread.
+	// arg_names is a comma separated list of up to 3 names for a0..a2.
+	void record(category cat, const char* name, u64 start, u64 end, u32 tid = 0, const char* arg_names = nullptr, u64 a0 = 0, u64 a1 = 0, u64 a2 = 0);
+
+	// Record a point event
+	inline void instant(category cat, const char* name, u32 tid = 0, const char* arg_names = nullptr, u64 a0 = 0, u64 a1 = 0, u64 a2 = 0)
+	{
+		if (UNLIKELY(g_enabled))
+		{
+			const u64 now = get_time();
+			record(cat, name, now, now, tid, arg_names, a0, a1, a2);
+		}
+	}
+
+	// Record a span which started at the given time
+	inline void span(category cat, const char* name, u64 start, u32 tid = 0, const char* arg_names = nullptr, u64 a0 = 0, u64 a1 = 0, u64 a2 = 0)
+	{
+		if (UNLIKELY(g_enabled))
+		{
+			record(cat, name, start, std::max<u64>(get_time(), start + 1), tid, arg_names, a0, a1, a2);
+		}
+	}
+
+	// Record a span covering the lifetime of the object
+	class scope
+	{
+		const category m_cat;
+		const char* const m_name;
+		const char* m_arg_name = nullptr;
+		u64 m_arg = 0;
+		const u64 m_start;
+
+	public:
+		scope(category cat, const char* name)
+			: m_cat(cat)
+			, m_name(name)
+			, m_start(g_enabled ? get_time() : 0)
+		{
+		}
+
+		scope(const scope&) = delete;
+
+		// Set single argument (name must be a string literal)
+		void set_arg(const char* name, u64 value)
+		{
+			m_arg_name = name;
+			m_arg = value;
+		}
+
+		~scope()
+		{
+			if (m_start)
+			{
+				span(m_cat, m_name, m_start, 0, m_arg_name, m_arg);
+			}
+		}
+	};
+
+	// Enable or disable recording (enabling discards previously recorded events)
+	void set_enabled(bool enabled);
+
+	// Set name shown for the guest thread with this ID
+	void set_guest_thread_name(u32 tid, const std::string& name);
+
+	// Write all recorded events, return the number of events written
+	u64 export_json(const std::string& path);
+}
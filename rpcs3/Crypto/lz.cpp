@@ -4,126 +4,100 @@
 
 #include "lz.h"
 
-void decode_range(unsigned int *range, unsigned int *code, unsigned char **src)
+namespace
 {
-	if (!((*range) >> 24)) 
+	// Range decoder, the state is kept in local variables (registers) by the decoding loop
+	struct lz_decoder
 	{
-		(*range) <<= 8;
-		*code = ((*code) << 8) + (*src)++[5];
-	}
-}
-
-int decode_bit(unsigned int *range, unsigned int *code, int *index, unsigned char **src, unsigned char *c)
-{
-	decode_range(range, code, src);
-	
-	unsigned int val = ((*range) >> 8) * (*c);
-
-	*c -= ((*c) >> 3);
-	if (index) (*index) <<= 1;
-
-	if (*code < val)
-	{
-		*range = val;
-		*c += 31;
-		if (index) (*index)++;
-		return 1;
-	}
-	else
-	{
-		*code -= val;
-		*range -= val;
-		return 0;
-	}
-}
-
-int decode_number(unsigned char *ptr, int index, int *bit_flag, unsigned int *range, unsigned int *code, unsigned char **src)
-{
-	int i = 1;
+		unsigned int range;
+		unsigned int code;
+		const unsigned char* src;
 
-	if (index >= 3) 
-	{
-		decode_bit(range, code, &i, src, ptr + 0x18);
-		if (index >= 4) 
+		void normalize()
 		{
-			decode_bit(range, code, &i, src, ptr + 0x18);
-			if (index >= 5)
+			if (!(range >> 24))
 			{
-				decode_range(range, code, src);
-				for (; index >= 5; index--)
-				{
-					i <<= 1;
-					(*range) >>= 1;
-					if (*code < *range) 
-						i++; 
-					else
-						(*code) -= *range;
-				}
+				range <<= 8;
+				code = (code << 8) + *src++;
 			}
 		}
-	}
 
-	*bit_flag = decode_bit(range, code, &i, src, ptr);
+		// Decode a bit using the adaptive probability c (without branching on the result)
+		int bit(unsigned char& c)
+		{
+			normalize();
+
+			const unsigned int val = (range >> 8) * c;
+			const unsigned int mask = 0u - (code < val);
 
-	if (index >= 1) 
-	{
-		decode_bit(range, code, &i, src, ptr + 0x8);
-		if (index >= 2) 
+			c = c - (c >> 3) + (31 & mask);
+			code -= val & ~mask;
+			range = (val & mask) | ((range - val) & ~mask);
+			return mask & 1;
+		}
+
+		// Same, and shift the bit into index
+		int bit(unsigned char& c, int& index)
 		{
-			decode_bit(range, code, &i, src, ptr + 0x10);
+			const int result = bit(c);
+			index = (index << 1) + result;
+			return result;
 		}
-	}	
 
-	return i;
-}
+		// Decode fixed probability bits into index
+		void direct_bits(int& index, int count)
+		{
+			normalize();
 
-int decode_word(unsigned char *ptr, int index, int *bit_flag, unsigned int *range, unsigned int *code, unsigned char **src)
-{
-	int i = 1;
-	index /= 8;
+			for (; count > 0; count--)
+			{
+				range >>= 1;
 
-	if (index >= 3) 
-	{
-		decode_bit(range, code, &i, src, ptr + 4);
-		if (index >= 4) 
+				const unsigned int mask = 0u - (code < range);
+				index = (index << 1) + (mask & 1);
+				code -= range & ~mask;
+			}
+		}
+
+		// Decode a number with the probabilities at ptr, ptr + step, ptr + step * 2 and ptr + high
+		int number(unsigned char* ptr, int index, int& bit_flag, int step, int high)
 		{
-			decode_bit(range, code, &i, src, ptr + 4);
-			if (index >= 5)
+			int i = 1;
+
+			if (index >= 3)
 			{
-				decode_range(range, code, src);
-				for (; index >= 5; index--)
+				bit(ptr[high], i);
+
+				if (index >= 4)
 				{
-					i <<= 1;
-					(*range) >>= 1;
-					if (*code < *range) 
-						i++; 
-					else
-						(*code) -= *range;
+					bit(ptr[high], i);
+
+					if (index >= 5)
+					{
+						direct_bits(i, index - 4);
+					}
 				}
 			}
-		}
-	}
 
-	*bit_flag = decode_bit(range, code, &i, src, ptr);
+			bit_flag = bit(ptr[0], i);
 
-	if (index >= 1) 
-	{
-		decode_bit(range, code, &i, src, ptr + 1);
-		if (index >= 2) 
-		{
-			decode_bit(range, code, &i, src, ptr + 2);
-		}
-	}	
+			if (index >= 1)
+			{
+				bit(ptr[step], i);
+
+				if (index >= 2)
+				{
+					bit(ptr[step * 2], i);
+				}
+			}
 
-	return i;
+			return i;
+		}
+	};
 }
 
 int decompress(unsigned char *out, unsigned char *in, unsigned int size)
 {
-	int result;
-
-	unsigned char *tmp = new unsigned char[0xCC8];
-
 	int offset = 0;
 	int bit_flag = 0;
 	int data_length = 0;
@@ -137,147 +111,153 @@ int decompress(unsigned char *out, unsigned char *in, unsigned int size)
 	unsigned char *end = (out + size);
 	unsigned char head = in[0];
 
-	unsigned int range = 0xFFFFFFFF;
-	unsigned int code = (in[1] << 24) | (in[2] << 16) | (in[3] << 8) | in[4];
+	lz_decoder dec;
+	dec.range = 0xFFFFFFFF;
+	dec.code = (in[1] << 24) | (in[2] << 16) | (in[3] << 8) | in[4];
+	dec.src = in + 5;
 
 	if (head > 0x80) // Check if we have a valid starting byte.
 	{
 		// The dictionary header is invalid, the data is not compressed.
-		result = -1;
-		if (code <= size)
+		if (dec.code <= size)
 		{
-			memcpy(out, (const void *)(in + 5), code);
-			result = (start - out);
+			memcpy(out, (const void *)(in + 5), dec.code);
+			return (start - out);
 		}
+
+		return -1;
 	}
-	else
+
+	// Set up a temporary buffer (sliding window).
+	unsigned char tmp[0xCC8];
+	memset(tmp, 0x80, 0xCA8);
+
+	while (1)
 	{
-		// Set up a temporary buffer (sliding window).
-		memset(tmp, 0x80, 0xCA8);
-		while (1)
+		// Start reading at 0xB68.
+		tmp_sect1 = tmp + offset + 0xB68;
+		if (!dec.bit(*tmp_sect1))  // Raw char.
 		{
-			// Start reading at 0xB68.
-			tmp_sect1 = tmp + offset + 0xB68;
-			if (!decode_bit(&range, &code, 0, &in, tmp_sect1))  // Raw char.
-			{
-				// Adjust offset and check for stream end.
-				if (offset > 0) offset--;
-				if (start == end) return (start - out);
-
-				// Locate first section.
-				int sect = (((((((int)(start - out)) & 7) << 8) + prev) >> head) & 7) * 0xFF - 1;
-				tmp_sect1 = tmp + sect;
-				int index = 1;
+			// Adjust offset and check for stream end.
+			if (offset > 0) offset--;
+			if (start == end) return (start - out);
 
-				// Read, decode and write back.
-				do
-				{
-					decode_bit(&range, &code, &index, &in, tmp_sect1 + index);
-				} while ((index >> 8) == 0);
+			// Locate first section.
+			int sect = (((((((int)(start - out)) & 7) << 8) + prev) >> head) & 7) * 0xFF - 1;
+			tmp_sect1 = tmp + sect;
+			int index = 1;
 
-				// Save index.
-				*start++ = index;
-			}
-			else  // Compressed char stream.
+			// Read, decode and write back.
+			do
 			{
-				int index = -1;
+				dec.bit(tmp_sect1[index], index);
+			} while ((index >> 8) == 0);
 
-				// Identify the data length bit field.
-				do
-				{
-					tmp_sect1 += 8; 
-					bit_flag = decode_bit(&range, &code, 0, &in, tmp_sect1);
-					index += bit_flag;
-				} while ((bit_flag != 0) && (index < 6));
+			// Save index.
+			*start++ = index;
+		}
+		else  // Compressed char stream.
+		{
+			int index = -1;
 
-				// Default block size is 0x160.
-				int b_size = 0x160;
-				tmp_sect2 = tmp + index + 0x7F1;
+			// Identify the data length bit field.
+			do
+			{
+				tmp_sect1 += 8;
+				bit_flag = dec.bit(*tmp_sect1);
+				index += bit_flag;
+			} while ((bit_flag != 0) && (index < 6));
 
-				// If the data length was found, parse it as a number.
-				if ((index >= 0) || (bit_flag != 0)) 
-				{
-					// Locate next section.
-					int sect = (index << 5) | (((((int)(start - out)) << index) & 3) << 3) | (offset & 7);
-					tmp_sect1 = tmp + 0xBA8 + sect;
+			// Default block size is 0x160.
+			int b_size = 0x160;
+			tmp_sect2 = tmp + index + 0x7F1;
 
-					// Decode the data length (8 bit fields).
-					data_length = decode_number(tmp_sect1, index, &bit_flag, &range, &code, &in);
-					if (data_length == 0xFF) return (start - out);  // End of stream.		
-				}
-				else 
-				{
-					// Assume one byte of advance.
-					data_length = 1;
-				}
+			// If the data length was found, parse it as a number.
+			if ((index >= 0) || (bit_flag != 0))
+			{
+				// Locate next section.
+				int sect = (index << 5) | (((((int)(start - out)) << index) & 3) << 3) | (offset & 7);
+				tmp_sect1 = tmp + 0xBA8 + sect;
 
-				// If we got valid parameters, seek to find data offset.
-				if ((data_length <= 2))
-				{
-					tmp_sect2 += 0xF8;
-					b_size = 0x40;  // Block size is now 0x40.
-				}
+				// Decode the data length (8 bit fields).
+				data_length = dec.number(tmp_sect1, index, bit_flag, 8, 0x18);
+				if (data_length == 0xFF) return (start - out);  // End of stream.
+			}
+			else
+			{
+				// Assume one byte of advance.
+				data_length = 1;
+			}
 
-				int diff = 0;
-				int shift = 1;
+			// If we got valid parameters, seek to find data offset.
+			if ((data_length <= 2))
+			{
+				tmp_sect2 += 0xF8;
+				b_size = 0x40;  // Block size is now 0x40.
+			}
 
-				// Identify the data offset bit field.
-				do
-				{
-					diff = (shift << 4) - b_size;
-					bit_flag = decode_bit(&range, &code, &shift, &in, tmp_sect2 + (shift << 3));
-				} while (diff < 0);
+			int diff = 0;
+			int shift = 1;
 
-				// If the data offset was found, parse it as a number.
-				if ((diff > 0) || (bit_flag != 0)) 
-				{
-					// Adjust diff if needed.
-					if (bit_flag == 0) diff -= 8;
+			// Identify the data offset bit field.
+			do
+			{
+				diff = (shift << 4) - b_size;
+				bit_flag = dec.bit(tmp_sect2[shift << 3], shift);
+			} while (diff < 0);
 
-					// Locate section.
-					tmp_sect3 = tmp + 0x928 + diff;
+			// If the data offset was found, parse it as a number.
+			if ((diff > 0) || (bit_flag != 0))
+			{
+				// Adjust diff if needed.
+				if (bit_flag == 0) diff -= 8;
 
-					// Decode the data offset (1 bit fields).
-					data_offset = decode_word(tmp_sect3, diff, &bit_flag, &range, &code, &in);
-				}
-				else
-				{
-					// Assume one byte of advance.
-					data_offset = 1;
-				}
+				// Locate section.
+				tmp_sect3 = tmp + 0x928 + diff;
 
-				// Set buffer start/end.
-				buf_start = start - data_offset;
-				buf_end = start + data_length + 1;
+				// Decode the data offset (1 bit fields).
+				data_offset = dec.number(tmp_sect3, diff / 8, bit_flag, 1, 4);
+			}
+			else
+			{
+				// Assume one byte of advance.
+				data_offset = 1;
+			}
 
-				// Underflow.
-				if (buf_start < out)
-				{
-					delete[] tmp;
-					return -1;
-				}
+			// Set buffer start/end.
+			buf_start = start - data_offset;
+			buf_end = start + data_length + 1;
 
-				// Overflow.
-				if (buf_end > end)
-				{
-					delete[] tmp;
-					return -1;
-				}
+			// Underflow (corrupted data may also produce a negative offset).
+			if (data_offset <= 0 || buf_start < out)
+			{
+				return -1;
+			}
+
+			// Overflow.
+			if (data_length < 0 || buf_end > end)
+			{
+				return -1;
+			}
 
-				// Update offset.
-				offset = ((((int)(buf_end - out)) + 1) & 1) + 6;
+			// Update offset.
+			offset = ((((int)(buf_end - out)) + 1) & 1) + 6;
 
-				// Copy data.
+			// Copy data (byte by byte if the source overlaps the destination).
+			if (buf_end - start <= data_offset)
+			{
+				memcpy(start, buf_start, buf_end - start);
+				start = buf_end;
+			}
+			else
+			{
 				do
 				{
 					*start++ = *buf_start++;
 				} while (start < buf_end);
-
 			}
-			prev = *(start - 1);
 		}
-		result = (start - out);
+
+		prev = *(start - 1);
 	}
-	delete[] tmp;
-	return result;
 }
@@ -4,13 +4,17 @@
 #include "sha1.h"
 #include "key_vault.h"
 #include "Utilities/StrFmt.h"
+#include "Utilities/Thread.h"
 #include "Emu/System.h"
 #include "Emu/VFS.h"
 #include "unpkg.h"
 
+#include <deque>
+#include <mutex>
+
 bool pkg_install(const std::string& path, atomic_t<double>& sync)
 {
-	const std::size_t BUF_SIZE = 8192 * 1024; // 8 MB
+	const std::size_t BUF_SIZE = 1024 * 1024; // 1 MB (per chunk)
 
 	std::vector<fs::file> filelist;
 	filelist.emplace_back(fs::file{path});
@@ -65,6 +69,34 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 		return num_read;
 	};
 
+	// Positional read across the split files, the current position is left alone
+	auto archive_read_at = [&](const u64 offset, void* data_ptr, const u64 num_bytes)
+	{
+		u64 done = 0;
+		u64 _offset = 0;
+
+		for (const auto& file : filelist)
+		{
+			const u64 file_size = file.size();
+
+			if (offset + done < _offset + file_size)
+			{
+				const u64 chunk = std::min<u64>(num_bytes - done, _offset + file_size - (offset + done));
+				const u64 num_read = file.read_at(offset + done - _offset, static_cast<u8*>(data_ptr) + done, chunk);
+				done += num_read;
+
+				if (done == num_bytes || num_read < chunk)
+				{
+					break;
+				}
+			}
+
+			_offset += file_size;
+		}
+
+		return done;
+	};
+
 	// Get basic PKG information
 	PKGHeader header;
 
@@ -216,16 +248,14 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 		}
 	}
 
-	// Allocate buffer with BUF_SIZE size or more if required
+	// Allocate buffer for the entry table and the names
 	const std::unique_ptr<u128[]> buf(new u128[std::max<u64>(BUF_SIZE, sizeof(PKGEntry) * header.file_count) / sizeof(u128)]);
 
-	// Define decryption subfunction (`psp` arg selects the key for specific block)
-	auto decrypt = [&](u64 offset, u64 size, const uchar* key) -> u64
+	// Define decryption subfunction (`psp` arg selects the key for specific block), may be called concurrently with different buffers
+	auto decrypt = [&](u64 offset, u64 size, const uchar* key, u128* data) -> u64
 	{
-		archive_seek(header.data_offset + offset);
-
 		// Read the data and set available size
-		const u64 read = archive_read(buf.get(), size);
+		const u64 read = archive_read_at(header.data_offset + offset, data, size);
 
 		// Get block count
 		const u64 blocks = (read + 15) / 16;
@@ -254,7 +284,7 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 				
 				sha1(reinterpret_cast<const u8*>(input), sizeof(input), hash.data);
 
-				buf[i] ^= hash._v128;
+				data[i] ^= hash._v128;
 			}
 		}
 
@@ -265,21 +295,16 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 			// Set encryption key for stream cipher
 			aes_setkey_enc(&ctx, key, 128);
 
-			// Initialize stream cipher for start position
+			// Initialize stream cipher for start position (the counter is incremented for every block)
 			be_t<u128> input = header.klicensee.value() + offset / 16;
 
-			// Increment stream position for every block
-			for (u64 i = 0; i < blocks; i++, input++)
-			{
-				u128 key;
+			u8 stream_block[16];
+			size_t stream_off = 0;
 
-				aes_crypt_ecb(&ctx, AES_ENCRYPT, reinterpret_cast<const u8*>(&input), reinterpret_cast<u8*>(&key));
-
-				buf[i] ^= key;
-			}
+			aes_crypt_ctr(&ctx, blocks * 16, &stream_off, reinterpret_cast<u8*>(&input), stream_block, reinterpret_cast<const u8*>(data), reinterpret_cast<u8*>(data));
 		}
 
-		// Return the amount of data written in buf
+		// Return the amount of data written in data
 		return read;
 	};
 
@@ -294,18 +319,41 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 		aes_context ctx;
 		aes_setkey_enc(&ctx, content_type == 0x15 ? psp2t1 : content_type == 0x16 ? psp2t2 : psp2t3, 128);
 		aes_crypt_ecb(&ctx, AES_ENCRYPT, reinterpret_cast<const uchar*>(&header.klicensee), dec_key.data());
-		decrypt(0, header.file_count * sizeof(PKGEntry), dec_key.data());
+		decrypt(0, header.file_count * sizeof(PKGEntry), dec_key.data(), buf.get());
 	}
 	else
 	{
 		std::memcpy(dec_key.data(), PKG_AES_KEY, dec_key.size());
-		decrypt(0, header.file_count * sizeof(PKGEntry), header.pkg_platform == PKG_PLATFORM_TYPE_PSP ? PKG_AES_KEY2 : dec_key.data());
+		decrypt(0, header.file_count * sizeof(PKGEntry), header.pkg_platform == PKG_PLATFORM_TYPE_PSP ? PKG_AES_KEY2 : dec_key.data(), buf.get());
 	}
 
 	std::vector<PKGEntry> entries(header.file_count);
 
 	std::memcpy(entries.data(), buf.get(), entries.size() * sizeof(PKGEntry));
 
+	// File extraction state
+	struct extract_job
+	{
+		std::string path;
+		std::string name;
+		u64 offset;
+		u64 size;
+		const uchar* key;
+		bool did_overwrite;
+		u32 chunks;
+
+		std::mutex mutex;
+		fs::file out;
+		atomic_t<bool> failed{false};
+		atomic_t<u32> done{0};
+	};
+
+	// Not moved when new jobs are added
+	std::deque<extract_job> jobs;
+
+	// File contents are extracted in independent chunks (job index, position in the file)
+	std::vector<std::pair<u32, u64>> chunks;
+
 	for (const auto& entry : entries)
 	{
 		const bool is_psp = (entry.type & PKG_FILE_ENTRY_PSP) != 0;
@@ -316,7 +364,7 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 			continue;
 		}
 
-		decrypt(entry.name_offset, entry.name_size, is_psp ? PKG_AES_KEY2 : dec_key.data());
+		decrypt(entry.name_offset, entry.name_size, is_psp ? PKG_AES_KEY2 : dec_key.data(), buf.get());
 
 		std::string name{reinterpret_cast<char*>(buf.get()), entry.name_size};
 
@@ -346,51 +394,21 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 				break;
 			}
 
-			if (fs::file out{path, fs::rewrite})
-			{
-				for (u64 pos = 0; pos < entry.file_size; pos += BUF_SIZE)
-				{
-					const u64 block_size = std::min<u64>(BUF_SIZE, entry.file_size - pos);
+			// Extracted later, the directories are created first
+			jobs.emplace_back();
 
-					if (decrypt(entry.file_offset + pos, block_size, is_psp ? PKG_AES_KEY2 : dec_key.data()) != block_size)
-					{
-						LOG_ERROR(LOADER, "Failed to extract file %s", path);
-						break;
-					}
-
-					if (out.write(buf.get(), block_size) != block_size)
-					{
-						LOG_ERROR(LOADER, "Failed to write file %s", path);
-						break;
-					}
-
-					if (sync.fetch_add((block_size + 0.0) / header.data_size) < 0.)
-					{
-						if (was_null)
-						{
-							LOG_ERROR(LOADER, "Package installation cancelled: %s", dir);
-							out.close();
-							fs::remove_all(dir, true);
-							return false;
-						}
-
-						// Cannot cancel the installation
-						sync += 1.;
-					}
-				}
+			extract_job& job = jobs.back();
+			job.path = path;
+			job.name = std::move(name);
+			job.offset = entry.file_offset;
+			job.size = entry.file_size;
+			job.key = is_psp ? PKG_AES_KEY2 : dec_key.data();
+			job.did_overwrite = did_overwrite;
+			job.chunks = static_cast<u32>(std::max<u64>((entry.file_size + BUF_SIZE - 1) / BUF_SIZE, 1));
 
-				if (did_overwrite)
-				{
-					LOG_WARNING(LOADER, "Overwritten file %s", name);
-				}
-				else
-				{
-					LOG_NOTICE(LOADER, "Created file %s", name);
-				}
-			}
-			else
+			for (u32 i = 0; i < job.chunks; i++)
 			{
-				LOG_ERROR(LOADER, "Failed to create file %s", path);
+				chunks.emplace_back(::size32(jobs) - 1, i * BUF_SIZE);
 			}
 
 			break;
@@ -424,6 +442,112 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 		}
 	}
 
+	// Decrypt and write the chunks in parallel: every worker reads, decrypts and writes its own chunk,
+	// so the I/O of different chunks and files overlaps. Chunks are taken in order, only a few files are open at once.
+	std::mutex pool_mutex;
+	std::vector<std::unique_ptr<u128[]>> pool;
+
+	atomic_t<bool> cancelled{false};
+
+	const bool positional = std::all_of(filelist.begin(), filelist.end(), [](const fs::file& file) { return file.is_positional(); });
+
+	thread_pool::parallel_for(::size32(chunks), [&](u32 index)
+	{
+		extract_job& job = jobs[chunks[index].first];
+		const u64 pos = chunks[index].second;
+		const u64 block_size = std::min<u64>(BUF_SIZE, job.size - pos);
+
+		if (!cancelled && !job.failed)
+		{
+			{
+				// Open the output file with the first chunk which arrives
+				std::lock_guard<std::mutex> lock(job.mutex);
+
+				if (!job.out && !job.failed && !job.out.open(job.path, fs::rewrite))
+				{
+					LOG_ERROR(LOADER, "Failed to create file %s", job.path);
+					job.failed = true;
+				}
+			}
+
+			std::unique_ptr<u128[]> data;
+			{
+				std::lock_guard<std::mutex> lock(pool_mutex);
+
+				if (!pool.empty())
+				{
+					data = std::move(pool.back());
+					pool.pop_back();
+				}
+			}
+
+			if (!data)
+			{
+				data.reset(new u128[BUF_SIZE / sizeof(u128)]);
+			}
+
+			if (!job.failed && block_size)
+			{
+				if (decrypt(job.offset + pos, block_size, job.key, data.get()) != block_size)
+				{
+					if (!job.failed.exchange(true))
+					{
+						LOG_ERROR(LOADER, "Failed to extract file %s", job.path);
+					}
+				}
+				else if (job.out.write_at(pos, data.get(), block_size) != block_size)
+				{
+					if (!job.failed.exchange(true))
+					{
+						LOG_ERROR(LOADER, "Failed to write file %s", job.path);
+					}
+				}
+				else if (sync.fetch_add((block_size + 0.0) / header.data_size) < 0.)
+				{
+					if (was_null)
+					{
+						if (!cancelled.exchange(true))
+						{
+							LOG_ERROR(LOADER, "Package installation cancelled: %s", dir);
+						}
+					}
+					else
+					{
+						// Cannot cancel the installation
+						sync += 1.;
+					}
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			pool.emplace_back(std::move(data));
+		}
+
+		if (++job.done == job.chunks)
+		{
+			std::lock_guard<std::mutex> lock(job.mutex);
+			job.out.close();
+
+			if (!job.failed && !cancelled)
+			{
+				if (job.did_overwrite)
+				{
+					LOG_WARNING(LOADER, "Overwritten file %s", job.name);
+				}
+				else
+				{
+					LOG_NOTICE(LOADER, "Created file %s", job.name);
+				}
+			}
+		}
+	}, thread_class::general, positional ? UINT32_MAX : 1);
+
+	if (cancelled)
+	{
+		fs::remove_all(dir, true);
+		return false;
+	}
+
 	LOG_SUCCESS(LOADER, "Package successfully installed to %s", dir);
 	return true;
 }
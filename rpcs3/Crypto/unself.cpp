@@ -4,6 +4,9 @@
 #include "utils.h"
 #include "unself.h"
 #include "Emu/VFS.h"
+#include "Emu/System.h"
+#include "Utilities/hash.h"
+#include "Utilities/Thread.h"
 
 #include <algorithm>
 #include <zlib.h>
@@ -771,30 +774,21 @@ bool SCEDecrypter::DecryptData()
 				memcpy(data_key, data_keys.get() + meta_shdr[i].key_idx * 0x10, 0x10);
 				memcpy(data_iv, data_keys.get() + meta_shdr[i].iv_idx * 0x10, 0x10);
 
-				// Allocate a buffer to hold the data.
-				auto buf = std::make_unique<u8[]>(meta_shdr[i].data_size);
-
-				// Seek to the section data offset and read the encrypted data.
-				sce_f.seek(meta_shdr[i].data_offset);
-				sce_f.read(buf.get(), meta_shdr[i].data_size);
+				// Read the encrypted data in place.
+				u8* const buf = data_buf.get() + data_buf_offset;
+				sce_f.read_at(meta_shdr[i].data_offset, buf, meta_shdr[i].data_size);
 
 				// Zero out our ctr nonce.
 				memset(ctr_stream_block, 0, sizeof(ctr_stream_block));
 
 				// Perform AES-CTR encryption on the data blocks.
 				aes_setkey_enc(&aes, data_key, 128);
-				aes_crypt_ctr(&aes, meta_shdr[i].data_size, &ctr_nc_off, data_iv, ctr_stream_block, buf.get(), buf.get());
-
-				// Copy the decrypted data.
-				memcpy(data_buf.get() + data_buf_offset, buf.get(), meta_shdr[i].data_size);
+				aes_crypt_ctr(&aes, meta_shdr[i].data_size, &ctr_nc_off, data_iv, ctr_stream_block, buf, buf);
 			}
 		}
 		else
 		{
-			auto buf = std::make_unique<u8[]>(meta_shdr[i].data_size);
-			sce_f.seek(meta_shdr[i].data_offset);
-			sce_f.read(buf.get(), meta_shdr[i].data_size);
-			memcpy(data_buf.get() + data_buf_offset, buf.get(), meta_shdr[i].data_size);
+			sce_f.read_at(meta_shdr[i].data_offset, data_buf.get() + data_buf_offset, meta_shdr[i].data_size);
 		}
 
 		// Advance the buffer's offset.
@@ -1207,83 +1201,129 @@ bool SELFDecrypter::LoadMetadata(u8* klic_key)
 
 bool SELFDecrypter::DecryptData()
 {
-	aes_context aes;
+	// Calculate the total data size and the offset of every section.
+	std::vector<u64> offsets(meta_hdr.section_count);
 
-	// Calculate the total data size.
 	for (unsigned int i = 0; i < meta_hdr.section_count; i++)
 	{
 		if (meta_shdr[i].encrypted == 3)
 		{
 			if ((meta_shdr[i].key_idx <= meta_hdr.key_count - 1) && (meta_shdr[i].iv_idx <= meta_hdr.key_count))
+			{
+				offsets[i] = data_buf_length;
 				data_buf_length += meta_shdr[i].data_size;
+			}
 		}
 	}
 
 	// Allocate a buffer to store decrypted data.
 	data_buf = std::make_unique<u8[]>(data_buf_length);
 
-	// Set initial offset.
-	u32 data_buf_offset = 0;
+	// Split the encrypted sections into chunks, AES-CTR can start at any block so they are decrypted in parallel.
+	const u64 chunk_size = 0x100000;
+
+	std::vector<std::pair<u32, u64>> chunks;
 
-	// Parse the metadata section headers to find the offsets of encrypted data.
 	for (unsigned int i = 0; i < meta_hdr.section_count; i++)
 	{
-		size_t ctr_nc_off = 0;
-		u8 ctr_stream_block[0x10];
-		u8 data_key[0x10];
-		u8 data_iv[0x10];
-
-		// Check if this is an encrypted section.
-		if (meta_shdr[i].encrypted == 3)
+		// Check if this is an encrypted section and make sure the key and iv are not out of boundaries.
+		if (meta_shdr[i].encrypted == 3 && (meta_shdr[i].key_idx <= meta_hdr.key_count - 1) && (meta_shdr[i].iv_idx <= meta_hdr.key_count))
 		{
-			// Make sure the key and iv are not out of boundaries.
-			if((meta_shdr[i].key_idx <= meta_hdr.key_count - 1) && (meta_shdr[i].iv_idx <= meta_hdr.key_count))
+			for (u64 pos = 0; pos < meta_shdr[i].data_size; pos += chunk_size)
 			{
-				// Get the key and iv from the previously stored key buffer.
-				memcpy(data_key, data_keys.get() + meta_shdr[i].key_idx * 0x10, 0x10);
-				memcpy(data_iv, data_keys.get() + meta_shdr[i].iv_idx * 0x10, 0x10);
+				chunks.emplace_back(i, pos);
+			}
+		}
+	}
 
-				// Allocate a buffer to hold the data.
-				auto buf = std::make_unique<u8[]>(meta_shdr[i].data_size);
+	thread_pool::parallel_for(::size32(chunks), [&](u32 index)
+	{
+		const auto& shdr = meta_shdr[chunks[index].first];
+		const u64 pos = chunks[index].second;
+		const u64 size = std::min<u64>(chunk_size, shdr.data_size - pos);
 
-				// Seek to the section data offset and read the encrypted data.
-				self_f.seek(meta_shdr[i].data_offset);
-				self_f.read(buf.get(), meta_shdr[i].data_size);
+		size_t ctr_nc_off = 0;
+		u8 ctr_stream_block[0x10]{};
+		be_t<u128> data_iv;
 
-				// Zero out our ctr nonce.
-				memset(ctr_stream_block, 0, sizeof(ctr_stream_block));
+		// Get the iv from the previously stored key buffer and advance the counter to the chunk.
+		memcpy(&data_iv, data_keys.get() + shdr.iv_idx * 0x10, 0x10);
+		data_iv = data_iv.value() + pos / 0x10;
 
-				// Perform AES-CTR encryption on the data blocks.
-				aes_setkey_enc(&aes, data_key, 128);
-				aes_crypt_ctr(&aes, meta_shdr[i].data_size, &ctr_nc_off, data_iv, ctr_stream_block, buf.get(), buf.get());
+		// Read the encrypted data in place.
+		u8* const buf = data_buf.get() + offsets[chunks[index].first] + pos;
+		self_f.read_at(shdr.data_offset + pos, buf, size);
 
-				// Copy the decrypted data.
-				memcpy(data_buf.get() + data_buf_offset, buf.get(), meta_shdr[i].data_size);
+		// Perform AES-CTR encryption on the data blocks.
+		aes_context aes;
+		aes_setkey_enc(&aes, data_keys.get() + shdr.key_idx * 0x10, 128);
+		aes_crypt_ctr(&aes, size, &ctr_nc_off, reinterpret_cast<u8*>(&data_iv), ctr_stream_block, buf, buf);
+	}, thread_class::general, self_f.is_positional() ? UINT32_MAX : 1);
 
-				// Advance the buffer's offset.
-				data_buf_offset += meta_shdr[i].data_size;
+	return true;
+}
+
+std::vector<u8> SELFDecrypter::ExtractSegments(const std::vector<u8>& headers, const std::vector<segment_info>& segments, u64 size)
+{
+	std::vector<u8> image(size);
+	std::memcpy(image.data(), headers.data(), headers.size());
+
+	// Segments are written in order if their file ranges overlap
+	std::vector<std::pair<u64, u64>> ranges;
+
+	for (const auto& seg : segments)
+	{
+		ranges.emplace_back(seg.file_offset, seg.file_offset + seg.file_size);
+	}
+
+	std::sort(ranges.begin(), ranges.end());
+
+	bool overlap = false;
+
+	for (std::size_t i = 1; i < ranges.size(); i++)
+	{
+		overlap |= ranges[i].first < ranges[i - 1].second;
+	}
+
+	thread_pool::parallel_for(::size32(segments), [&](u32 index)
+	{
+		const segment_info& seg = segments[index];
+
+		if (seg.compressed)
+		{
+			uLongf decomp_buf_length = ::narrow<uLongf>(seg.file_size);
+
+			// Use zlib uncompress directly into the image.
+			// decomp_buf_length changes inside the call to uncompress
+			int rv = uncompress(image.data() + seg.file_offset, &decomp_buf_length, data_buf.get() + seg.data_offset, ::narrow<uLong>(seg.data_size));
+
+			// Check for errors (TODO: Probably safe to remove this once these changes have passed testing.)
+			switch (rv)
+			{
+			case Z_MEM_ERROR: LOG_ERROR(LOADER, "MakeELF encountered a Z_MEM_ERROR!"); break;
+			case Z_BUF_ERROR: LOG_ERROR(LOADER, "MakeELF encountered a Z_BUF_ERROR!"); break;
+			case Z_DATA_ERROR: LOG_ERROR(LOADER, "MakeELF encountered a Z_DATA_ERROR!"); break;
+			default: break;
 			}
 		}
-	}
+		else
+		{
+			std::memcpy(image.data() + seg.file_offset, data_buf.get() + seg.data_offset, seg.data_size);
+		}
+	}, thread_class::general, overlap ? 1 : UINT32_MAX);
 
-	return true;
+	return image;
 }
 
 fs::file SELFDecrypter::MakeElf(bool isElf32)
 {
 	// Create a new ELF file.
-	fs::file e = fs::make_stream<std::vector<u8>>();
-
 	if (isElf32)
 	{
-		WriteElf(e, elf32_hdr, shdr32_arr, phdr32_arr);
-	}
-	else
-	{
-		WriteElf(e, elf64_hdr, shdr64_arr, phdr64_arr);
+		return WriteElf(elf32_hdr, shdr32_arr, phdr32_arr);
 	}
 
-	return e;
+	return WriteElf(elf64_hdr, shdr64_arr, phdr64_arr);
 }
 
 bool SELFDecrypter::GetKeyFromRap(u8* content_id, u8* npdrm_key)
@@ -1375,6 +1415,114 @@ static bool CheckDebugSelf(fs::file& s)
 	return false;
 }
 
+// Decrypted SELF cache file header, followed by the ELF image
+struct self_cache_header
+{
+	char magic[8]; // "RPCSSELF"
+	u32 version;
+	u32 reserved;
+	u64 size; // Size of the image
+	u64 hash; // Hash of the image
+};
+
+static const char s_self_cache_magic[8]{'R', 'P', 'C', 'S', 'S', 'E', 'L', 'F'};
+
+static constexpr u32 s_self_cache_version = 1;
+
+// Get cache file path from SHA-1 of the klic and the whole encrypted file
+static std::string get_self_cache_path(const fs::file& self, const u8* klic_key)
+{
+	sha1_context ctx;
+	sha1_starts(&ctx);
+
+	// The same file decrypted with different klic is stored separately
+	const u8 has_klic = klic_key != nullptr;
+	sha1_update(&ctx, &has_klic, 1);
+
+	if (klic_key)
+	{
+		sha1_update(&ctx, klic_key, 0x10);
+	}
+
+	std::vector<u8> buf(0x100000);
+
+	for (u64 pos = 0, read; (read = self.read_at(pos, buf.data(), buf.size())) != 0; pos += read)
+	{
+		sha1_update(&ctx, buf.data(), read);
+	}
+
+	u8 hash[20];
+	sha1_finish(&ctx, hash);
+
+	std::string path = Emu.GetCachePath() + "self/";
+
+	for (u8 byte : hash)
+	{
+		fmt::append(path, "%02x", byte);
+	}
+
+	return path + ".elf";
+}
+
+static fs::file load_self_cache(const std::string& path)
+{
+	fs::file f(path);
+
+	if (!f)
+	{
+		return fs::file{};
+	}
+
+	self_cache_header header;
+
+	if (!f.read(header) || std::memcmp(header.magic, s_self_cache_magic, sizeof(header.magic)) != 0 || header.version != s_self_cache_version || header.size != f.size() - sizeof(header))
+	{
+		LOG_WARNING(LOADER, "SELF: Invalid cached image %s", path);
+		f.close();
+		fs::remove_file(path);
+		return fs::file{};
+	}
+
+	std::vector<u8> image(header.size);
+
+	// Verify the contents, a damaged file is decrypted again
+	if (f.read(image.data(), image.size()) != image.size() || rpcs3::hash64(image.data(), image.size()) != header.hash)
+	{
+		LOG_WARNING(LOADER, "SELF: Damaged cached image %s", path);
+		f.close();
+		fs::remove_file(path);
+		return fs::file{};
+	}
+
+	LOG_NOTICE(LOADER, "SELF: Loaded decrypted image from cache: %s", path);
+	return fs::make_stream(std::move(image));
+}
+
+static void save_self_cache(const std::string& path, const fs::file& elf)
+{
+	const std::vector<u8> image = elf.to_vector<u8>();
+
+	self_cache_header header{};
+	std::memcpy(header.magic, s_self_cache_magic, sizeof(header.magic));
+	header.version = s_self_cache_version;
+	header.size = image.size();
+	header.hash = rpcs3::hash64(image.data(), image.size());
+
+	fs::create_path(path.substr(0, path.find_last_of('/')));
+
+	// Write atomically, an interrupted write mustn't leave a truncated file
+	const std::string tmp = path + ".tmp";
+
+	fs::file f(tmp, fs::rewrite);
+
+	if (!f || f.write(&header, sizeof(header)) != sizeof(header) || f.write(image.data(), image.size()) != image.size() || (f.close(), !fs::rename(tmp, path, true)))
+	{
+		LOG_ERROR(LOADER, "SELF: Failed to write cached image %s", path);
+		f.close();
+		fs::remove_file(tmp);
+	}
+}
+
 extern fs::file decrypt_self(fs::file elf_or_self, u8* klic_key)
 {	
 	if (!elf_or_self) 
@@ -1387,6 +1535,19 @@ extern fs::file decrypt_self(fs::file elf_or_self, u8* klic_key)
 	// Check SELF header first. Check for a debug SELF.
 	if (elf_or_self.size() >= 4 && elf_or_self.read<u32>() == "SCE\0"_u32 && !CheckDebugSelf(elf_or_self))
 	{
+		// Try the decrypted image cache.
+		std::string cache_path;
+
+		if (g_cfg.core.self_cache && !Emu.GetCachePath().empty())
+		{
+			cache_path = get_self_cache_path(elf_or_self, klic_key);
+
+			if (fs::file cached = load_self_cache(cache_path))
+			{
+				return cached;
+			}
+		}
+
 		// Check the ELF file class (32 or 64 bit).
 		bool isElf32 = IsSelfElf32(elf_or_self);
 
@@ -1415,7 +1576,14 @@ extern fs::file decrypt_self(fs::file elf_or_self, u8* klic_key)
 		}
 		
 		// Make a new ELF file from this SELF.
-		return self_dec.MakeElf(isElf32);
+		fs::file elf = self_dec.MakeElf(isElf32);
+
+		if (!cache_path.empty())
+		{
+			save_self_cache(cache_path, elf);
+		}
+
+		return elf;
 	}
 
 	return elf_or_self;
@@ -157,3 +157,16 @@ void OpenALThread::AddData(const void* src, int size)
 
 	Play();
 }
+
+u64 OpenALThread::GetLatency()
+{
+	ALint queued, processed;
+
+	alGetSourcei(m_source, AL_BUFFERS_QUEUED, &queued);
+	alGetSourcei(m_source, AL_BUFFERS_PROCESSED, &processed);
+	checkForAlError("OpenALThread::GetLatency -> alGetSourcei");
+
+	const u32 frame_size = (g_cfg.audio.convert_to_u16 ? 2 : 4) * (g_cfg.audio.downmix_to_2ch ? 2 : 8);
+
+	return std::max<ALint>(queued - processed, 0) * (u64)(m_buffer_size / frame_size) * 1000000 / 48000;
+}
@@ -21,4 +21,5 @@ public:
 	virtual void Close() override;
 	virtual void Stop() override;
 	virtual void AddData(const void* src, int size) override;
+	virtual u64 GetLatency() override;
 };
@@ -166,4 +166,16 @@ void ALSAThread::AddData(const void* src, int size)
 	}
 }
 
+u64 ALSAThread::GetLatency()
+{
+	snd_pcm_sframes_t delay;
+
+	if (!s_tls_handle || snd_pcm_delay(s_tls_handle, &delay) < 0 || delay < 0)
+	{
+		return 0;
+	}
+
+	return delay * 1000000ull / 48000;
+}
+
 #endif
@@ -15,6 +15,7 @@ public:
 	virtual void Close() override;
 	virtual void Stop() override;
 	virtual void AddData(const void* src, int size) override;
+	virtual u64 GetLatency() override;
 };
 
 #endif
@@ -1,7 +1,18 @@
 #include "stdafx.h"
+#include "Emu/System.h"
+#include "Utilities/Thread.h"
 #include "AudioDumper.h"
 #include "AudioThread.h"
 
+extern "C"
+{
+#include "libavcodec/avcodec.h"
+}
+
+#include <mutex>
+
+extern std::mutex g_mutex_avcodec_open2;
+
 AudioThread::~AudioThread()
 {
 }
@@ -11,8 +22,36 @@ AudioDumper::AudioDumper(u16 ch)
 {
 	if (GetCh())
 	{
-		m_output.open(fs::get_config_dir() + "audio.wav", fs::rewrite);
-		m_output.write(m_header); // write initial file header
+		if (!g_cfg.audio.dump_to_flac || !open_flac())
+		{
+			m_output.open(fs::get_config_dir() + "audio.wav", fs::rewrite);
+			m_output.write(m_header); // write initial file header
+		}
+
+		m_queue = std::make_unique<lf_spsc<block, 512>>();
+
+		m_writer = std::thread([this]()
+		{
+			thread_ctrl::set_native_priority(-1);
+
+			while (true)
+			{
+				if (m_queue->size())
+				{
+					write_block((*m_queue)[0]);
+					m_queue->end_pop();
+					continue;
+				}
+
+				// Everything pushed before the stop request is written
+				if (m_stop)
+				{
+					break;
+				}
+
+				std::this_thread::sleep_for(2ms);
+			}
+		});
 	}
 }
 
@@ -20,8 +59,23 @@ AudioDumper::~AudioDumper()
 {
 	if (GetCh())
 	{
-		m_output.seek(0);
-		m_output.write(m_header); // rewrite file header
+		m_stop = true;
+		m_writer.join();
+
+		if (m_ctx)
+		{
+			close_flac();
+		}
+		else
+		{
+			m_output.seek(0);
+			m_output.write(m_header); // rewrite file header
+		}
+
+		if (m_dropped)
+		{
+			LOG_ERROR(GENERAL, "AudioDumper: %llu blocks dropped, the disk couldn't keep up", m_dropped);
+		}
 	}
 }
 
@@ -29,8 +83,159 @@ void AudioDumper::WriteData(const void* buffer, u32 size)
 {
 	if (GetCh())
 	{
-		verify(HERE), size, m_output.write(buffer, size) == size;
-		m_header.Size += size;
-		m_header.RIFF.Size += size;
+		verify(HERE), size, size <= sizeof(block::data);
+
+		// Never wait for the writer
+		if (block* data = *m_queue)
+		{
+			data->size = size;
+			std::memcpy(data->data, buffer, size);
+			m_queue->end_push();
+		}
+		else
+		{
+			m_dropped++;
+		}
+	}
+}
+
+void AudioDumper::write_block(const block& data)
+{
+	if (!m_ctx)
+	{
+		verify(HERE), m_output.write(data.data, data.size) == data.size;
+		m_header.Size += data.size;
+		m_header.RIFF.Size += data.size;
+		return;
+	}
+
+	// Float samples to 24-bit (in the upper bits of S32), split into encoder frames
+	const u32 count = data.size / sizeof(float);
+
+	for (u32 i = 0; i < count;)
+	{
+		const u32 avail = (m_frame->nb_samples - m_frame_pos) * GetCh();
+		const u32 num = std::min(avail, count - i);
+		s32* dst = reinterpret_cast<s32*>(m_frame->data[0]) + m_frame_pos * GetCh();
+
+		for (u32 j = 0; j < num; j++)
+		{
+			dst[j] = static_cast<s32>(std::clamp(data.data[i + j], -1.f, 1.f) * 8388607.f) * 256;
+		}
+
+		i += num;
+		m_frame_pos += num / GetCh();
+
+		if (m_frame_pos == m_frame->nb_samples)
+		{
+			encode_frame(false);
+		}
+	}
+}
+
+bool AudioDumper::open_flac()
+{
+	avcodec_register_all();
+
+	AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_FLAC);
+
+	if (!codec || !(m_ctx = avcodec_alloc_context3(codec)))
+	{
+		LOG_ERROR(GENERAL, "AudioDumper: FLAC encoder not available, writing WAV");
+		return false;
+	}
+
+	m_ctx->sample_rate = 48000;
+	m_ctx->channels = GetCh();
+	m_ctx->channel_layout = av_get_default_channel_layout(GetCh());
+	m_ctx->sample_fmt = AV_SAMPLE_FMT_S32;
+	m_ctx->bits_per_raw_sample = 24;
+
+	int err;
+	{
+		std::lock_guard<std::mutex> lock(g_mutex_avcodec_open2);
+		err = avcodec_open2(m_ctx, codec, nullptr);
+	}
+
+	if (err < 0 || m_ctx->extradata_size != 34 || !(m_frame = av_frame_alloc()) || !(m_packet = av_packet_alloc()))
+	{
+		LOG_ERROR(GENERAL, "AudioDumper: failed to initialize the FLAC encoder (err=0x%x), writing WAV", err);
+		av_packet_free(&m_packet);
+		av_frame_free(&m_frame);
+		avcodec_free_context(&m_ctx);
+		return false;
+	}
+
+	m_frame->format = AV_SAMPLE_FMT_S32;
+	m_frame->channel_layout = m_ctx->channel_layout;
+	m_frame->nb_samples = m_ctx->frame_size ? m_ctx->frame_size : 4096;
+
+	if (av_frame_get_buffer(m_frame, 0) < 0)
+	{
+		LOG_ERROR(GENERAL, "AudioDumper: av_frame_get_buffer() failed, writing WAV");
+		av_packet_free(&m_packet);
+		av_frame_free(&m_frame);
+		avcodec_free_context(&m_ctx);
+		return false;
+	}
+
+	// Stream marker and the STREAMINFO block (the only metadata block), updated when the encoder is flushed
+	const u8 marker[8] = { 'f', 'L', 'a', 'C', 0x80, 0, 0, 34 };
+
+	m_output.open(fs::get_config_dir() + "audio.flac", fs::rewrite);
+	m_output.write(marker, sizeof(marker));
+	m_output.write(m_ctx->extradata, 34);
+	return true;
+}
+
+void AudioDumper::encode_frame(bool flush)
+{
+	if (m_frame_pos)
+	{
+		m_frame->nb_samples = m_frame_pos;
+		avcodec_send_frame(m_ctx, m_frame);
+		m_frame_pos = 0;
 	}
+
+	if (flush)
+	{
+		avcodec_send_frame(m_ctx, nullptr);
+	}
+
+	while (avcodec_receive_packet(m_ctx, m_packet) == 0)
+	{
+		m_output.write(m_packet->data, m_packet->size);
+
+		int size = 0;
+
+		// Final STREAMINFO (sample count and MD5)
+		if (const u8* info = av_packet_get_side_data(m_packet, AV_PKT_DATA_NEW_EXTRADATA, &size))
+		{
+			if (size == 34)
+			{
+				const u64 pos = m_output.pos();
+				m_output.seek(8);
+				m_output.write(info, 34);
+				m_output.seek(pos);
+			}
+		}
+
+		av_packet_unref(m_packet);
+	}
+
+	// The encoder may still reference the sent buffer
+	if (!flush)
+	{
+		m_frame->nb_samples = m_ctx->frame_size ? m_ctx->frame_size : 4096;
+		av_frame_make_writable(m_frame);
+	}
+}
+
+void AudioDumper::close_flac()
+{
+	encode_frame(true);
+
+	av_packet_free(&m_packet);
+	av_frame_free(&m_frame);
+	avcodec_free_context(&m_ctx);
 }
@@ -1,5 +1,12 @@
 #pragma once
 
+#include "Utilities/lockless.h"
+#include <thread>
+
+struct AVCodecContext;
+struct AVFrame;
+struct AVPacket;
+
 struct WAVHeader
 {
 	struct RIFFHeader
@@ -58,11 +65,36 @@ struct WAVHeader
 	}
 };
 
+// Writes the mixed audio from a background thread, the audio thread only copies it to the queue
 class AudioDumper
 {
+	// Mixed data of a single audio block (256 samples, up to 8 channels)
+	struct block
+	{
+		u32 size;
+		float data[8 * 256];
+	};
+
 	WAVHeader m_header;
 	fs::file m_output;
-	
+
+	// About 2.7 seconds of audio
+	std::unique_ptr<lf_spsc<block, 512>> m_queue;
+	std::thread m_writer;
+	atomic_t<bool> m_stop{false};
+	u64 m_dropped = 0;
+
+	// FLAC encoder (optional)
+	AVCodecContext* m_ctx = nullptr;
+	AVFrame* m_frame = nullptr;
+	AVPacket* m_packet = nullptr;
+	u32 m_frame_pos = 0;
+
+	bool open_flac();
+	void write_block(const block& data);
+	void encode_frame(bool flush);
+	void close_flac();
+
 public:
 	AudioDumper(u16 ch);
 	~AudioDumper();
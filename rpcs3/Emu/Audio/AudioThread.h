@@ -10,4 +10,7 @@ public:
 	virtual void Close() = 0;
 	virtual void Stop() = 0;
 	virtual void AddData(const void* src, int size) = 0;
+
+	// Duration of the data queued but not yet played (in microseconds), 0 if unknown
+	virtual u64 GetLatency() { return 0; }
 };
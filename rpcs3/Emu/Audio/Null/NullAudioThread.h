@@ -15,4 +15,5 @@ public:
 	virtual void Close() {}
 	virtual void Stop() {}
 	virtual void AddData(const void* src, int size) {}
+	virtual u64 GetLatency() { return 0; }
 };
@@ -57,4 +57,17 @@ void PulseThread::AddData(const void* src, int size)
 	}
 }
 
+u64 PulseThread::GetLatency()
+{
+	if(this->connection) {
+		int err;
+		const pa_usec_t latency = pa_simple_get_latency(this->connection, &err);
+		if(latency != (pa_usec_t)-1) {
+			return latency;
+		}
+	}
+
+	return 0;
+}
+
 #endif
@@ -87,6 +87,15 @@ void XAudio2Thread::xa27_flush()
 	}
 }
 
+u64 XAudio2Thread::xa27_latency()
+{
+	XAUDIO2_VOICE_STATE state;
+	s_tls_source_voice->GetState(&state);
+
+	// Every submitted buffer holds 256 samples
+	return state.BuffersQueued * 256ull * 1000000 / 48000;
+}
+
 void XAudio2Thread::xa27_stop()
 {
 	HRESULT hr = s_tls_source_voice->Stop();
@@ -24,6 +24,7 @@ XAudio2Thread::XAudio2Thread()
 		m_funcs.stop    = &xa28_stop;
 		m_funcs.open    = &xa28_open;
 		m_funcs.add     = &xa28_add;
+		m_funcs.latency = &xa28_latency;
 
 		LOG_SUCCESS(GENERAL, "XAudio 2.9 initialized");
 		return;
@@ -39,6 +40,7 @@ XAudio2Thread::XAudio2Thread()
 		m_funcs.stop    = &xa27_stop;
 		m_funcs.open    = &xa27_open;
 		m_funcs.add     = &xa27_add;
+		m_funcs.latency = &xa27_latency;
 
 		LOG_SUCCESS(GENERAL, "XAudio 2.7 initialized");
 		return;
@@ -54,6 +56,7 @@ XAudio2Thread::XAudio2Thread()
 		m_funcs.stop    = &xa28_stop;
 		m_funcs.open    = &xa28_open;
 		m_funcs.add     = &xa28_add;
+		m_funcs.latency = &xa28_latency;
 
 		LOG_SUCCESS(GENERAL, "XAudio 2.8 initialized");
 		return;
@@ -95,4 +98,9 @@ void XAudio2Thread::AddData(const void* src, int size)
 	m_funcs.add(src, size);
 }
 
+u64 XAudio2Thread::GetLatency()
+{
+	return m_funcs.latency();
+}
+
 #endif
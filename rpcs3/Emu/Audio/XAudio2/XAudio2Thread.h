@@ -14,6 +14,7 @@ class XAudio2Thread : public AudioThread
 		void(*stop)();
 		void(*open)();
 		void(*add)(const void*, int);
+		u64(*latency)();
 	};
 
 	vtable m_funcs;
@@ -25,6 +26,7 @@ class XAudio2Thread : public AudioThread
 	static void xa27_stop();
 	static void xa27_open();
 	static void xa27_add(const void*, int);
+	static u64 xa27_latency();
 
 	static void xa28_init(void*);
 	static void xa28_destroy();
@@ -33,6 +35,7 @@ class XAudio2Thread : public AudioThread
 	static void xa28_stop();
 	static void xa28_open();
 	static void xa28_add(const void*, int);
+	static u64 xa28_latency();
 
 public:
 	XAudio2Thread();
@@ -43,6 +46,7 @@ public:
 	virtual void Close() override;
 	virtual void Stop() override;
 	virtual void AddData(const void* src, int size) override;
+	virtual u64 GetLatency() override;
 };
 
 #endif
@@ -106,6 +106,7 @@ bool cpu_thread::check_state()
 #endif
 
 	bool cpu_sleep_called = false;
+	bool cpu_slept = false;
 	bool cpu_flag_memory = false;
 
 	while (true)
@@ -144,12 +145,18 @@ bool cpu_thread::check_state()
 		{
 			cpu_sleep();
 			cpu_sleep_called = true;
+			cpu_slept = true;
 			continue;
 		}
 
 		thread_ctrl::wait();
 	}
 
+	if (cpu_slept)
+	{
+		cpu_wake();
+	}
+
 	const auto state_ = state.load();
 
 	if (test(state_, cpu_flag::ret + cpu_flag::stop))
@@ -66,6 +66,9 @@ public:
 	// Callback for cpu_flag::suspend
 	virtual void cpu_sleep() {}
 
+	// Callback for leaving cpu_flag::suspend
+	virtual void cpu_wake() {}
+
 	// Callback for cpu_flag::memory
 	virtual void cpu_mem() {}
 
@@ -70,6 +70,47 @@ public:
 	u32 sample_rate;
 	bool use_ats_headers;
 
+	// Frames returned by cellAdecGetPcm, reused instead of allocating one per decoded frame
+	std::mutex frame_pool_mutex;
+	std::vector<AVFrame*> frame_pool;
+
+	// Decoding statistics
+	u64 decode_time = 0;
+	u64 decoded_aus = 0;
+
+	AVFrame* alloc_frame()
+	{
+		{
+			std::lock_guard<std::mutex> lock(frame_pool_mutex);
+
+			if (!frame_pool.empty())
+			{
+				AVFrame* frame = frame_pool.back();
+				frame_pool.pop_back();
+				return frame;
+			}
+		}
+
+		return av_frame_alloc();
+	}
+
+	void free_frame(AVFrame* frame)
+	{
+		av_frame_unref(frame);
+
+		{
+			std::lock_guard<std::mutex> lock(frame_pool_mutex);
+
+			if (frame_pool.size() < 16)
+			{
+				frame_pool.push_back(frame);
+				return;
+			}
+		}
+
+		av_frame_free(&frame);
+	}
+
 	AudioDecoder(s32 type, u32 addr, u32 size, vm::ptr<CellAdecCbMsg> func, u32 arg)
 		: ppu_thread("HLE Audio Decoder")
 		, type(type)
@@ -143,6 +184,10 @@ public:
 			av_frame_unref(af.data);
 			av_frame_free(&af.data);
 		}
+		for (AVFrame* frame : frame_pool)
+		{
+			av_frame_free(&frame);
+		}
 		if (ctx)
 		{
 			avcodec_close(ctx);
@@ -293,6 +338,8 @@ public:
 
 				bool last_frame = false;
 
+				u64 au_time = 0;
+
 				while (true)
 				{
 					if (Emu.IsStopped() || is_closed)
@@ -312,21 +359,23 @@ public:
 
 					struct AdecFrameHolder : AdecFrame
 					{
-						AdecFrameHolder()
+						AudioDecoder& adec;
+
+						AdecFrameHolder(AudioDecoder& adec)
+							: adec(adec)
 						{
-							data = av_frame_alloc();
+							data = adec.alloc_frame();
 						}
 
 						~AdecFrameHolder()
 						{
 							if (data)
 							{
-								av_frame_unref(data);
-								av_frame_free(&data);
+								adec.free_frame(data);
 							}
 						}
 
-					} frame;
+					} frame(*this);
 
 					if (!frame.data)
 					{
@@ -335,8 +384,12 @@ public:
 
 					int got_frame = 0;
 
+					const u64 decode_start = get_system_time();
+
 					int decode = avcodec_decode_audio4(ctx, frame.data, &got_frame, &au);
 
+					au_time += get_system_time() - decode_start;
+
 					if (decode <= 0)
 					{
 						if (decode < 0)
@@ -384,6 +437,11 @@ public:
 					}
 				}
 
+				decode_time += au_time;
+				decoded_aus++;
+
+				cellAdec.trace("AU decoded (time=%llu us, average=%llu us, count=%llu)", au_time, decode_time / decoded_aus, decoded_aus);
+
 				cbFunc(*this, id, CELL_ADEC_MSG_TYPE_AUDONE, task.au.auInfo_addr, cbArg);
 				lv2_obj::sleep(*this);
 				break;
@@ -730,11 +788,12 @@ s32 cellAdecGetPcm(u32 handle, vm::ptr<float> outBuffer)
 		return CELL_ADEC_ERROR_EMPTY;
 	}
 
-	std::unique_ptr<AVFrame, void(*)(AVFrame*)> frame(af.data, [](AVFrame* frame)
+	auto release = [&](AVFrame* frame)
 	{
-		av_frame_unref(frame);
-		av_frame_free(&frame);
-	});
+		adec->free_frame(frame);
+	};
+
+	std::unique_ptr<AVFrame, decltype(release)> frame(af.data, release);
 
 	if (outBuffer)
 	{
@@ -40,6 +40,15 @@ void fmt_class_string<CellAudioError>::format(std::string& out, u64 arg)
 	});
 }
 
+// Load four big-endian floats (SSE2)
+static inline __m128 audio_load_be(const void* ptr)
+{
+	__m128i v = _mm_loadu_si128(static_cast<const __m128i*>(ptr));
+	v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+	v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xb1), 0xb1);
+	return _mm_castsi128_ps(v);
+}
+
 void audio_config::on_init(const std::shared_ptr<void>& _this)
 {
 	m_buffer.set(vm::alloc(AUDIO_PORT_OFFSET * AUDIO_PORT_COUNT, vm::main));
@@ -61,8 +70,8 @@ void audio_config::on_task()
 
 	AudioDumper m_dump(g_cfg.audio.dump_to_file ? 2 : 0); // Init AudioDumper for 2 channels if enabled
 
-	float buf2ch[2 * BUFFER_SIZE]{}; // intermediate buffer for 2 channels
-	float buf8ch[8 * BUFFER_SIZE]{}; // intermediate buffer for 8 channels
+	alignas(16) float buf2ch[2 * BUFFER_SIZE]{}; // intermediate buffer for 2 channels
+	alignas(16) float buf8ch[8 * BUFFER_SIZE]{}; // intermediate buffer for 8 channels
 
 	const u32 buf_sz = BUFFER_SIZE * (g_cfg.audio.convert_to_u16 ? 2 : 4) * (g_cfg.audio.downmix_to_2ch ? 2 : 8);
 
@@ -104,6 +113,10 @@ void audio_config::on_task()
 
 		bool first_mix = true;
 
+		// Only build the layouts which are actually consumed (output or dump)
+		const bool need_2ch = g_cfg.audio.downmix_to_2ch || m_dump.GetCh() == 2;
+		const bool need_8ch = !g_cfg.audio.downmix_to_2ch || m_dump.GetCh() == 8;
+
 		// mixing:
 		for (auto& port : ports)
 		{
@@ -115,10 +128,23 @@ void audio_config::on_task()
 
 			auto buf = vm::_ptr<f32>(buf_addr);
 
-			static const float k = 1.0f; // may be 1.0f
-			const float& m = port.level;
+			if (port.channel != 2 && port.channel != 8)
+			{
+				fmt::throw_exception("Unknown channel count (port=%u, channel=%d)" HERE, port.number, port.channel);
+			}
+
+			if (first_mix)
+			{
+				// Accumulate all ports into cleared buffers
+				if (need_2ch) std::memset(buf2ch, 0, sizeof(buf2ch));
+				if (need_8ch) std::memset(buf8ch, 0, sizeof(buf8ch));
+				first_mix = false;
+			}
+
+			// Level of each sample (part of cellAudioSetPortLevel functionality)
+			alignas(16) float levels[BUFFER_SIZE];
 
-			auto step_volume = [](audio_port& port) // part of cellAudioSetPortLevel functionality
+			for (u32 i = 0; i < BUFFER_SIZE; i++)
 			{
 				const auto param = port.level_set.load();
 
@@ -133,143 +159,97 @@ void audio_config::on_task()
 						port.level_set.compare_and_swap(param, { param.value, 0.0f });
 					}
 				}
-			};
+
+				levels[i] = port.level;
+			}
 
 			if (port.channel == 2)
 			{
-				if (first_mix)
+				for (u32 i = 0; i < BUFFER_SIZE; i += 2)
 				{
-					for (u32 i = 0; i < (sizeof(buf2ch) / sizeof(float)); i += 2)
+					// Two stereo samples per vector
+					const __m128 level = _mm_unpacklo_ps(_mm_load_ss(levels + i), _mm_load_ss(levels + i + 1));
+					const __m128 data = _mm_mul_ps(audio_load_be(buf + i * 2), _mm_unpacklo_ps(level, level));
+
+					if (need_2ch)
 					{
-						step_volume(port);
-
-						// reverse byte order
-						const float left = buf[i + 0] * m;
-						const float right = buf[i + 1] * m;
-
-						buf2ch[i + 0] = left;
-						buf2ch[i + 1] = right;
-
-						buf8ch[i * 4 + 0] = left;
-						buf8ch[i * 4 + 1] = right;
-						buf8ch[i * 4 + 2] = 0.0f;
-						buf8ch[i * 4 + 3] = 0.0f;
-						buf8ch[i * 4 + 4] = 0.0f;
-						buf8ch[i * 4 + 5] = 0.0f;
-						buf8ch[i * 4 + 6] = 0.0f;
-						buf8ch[i * 4 + 7] = 0.0f;
+						_mm_store_ps(buf2ch + i * 2, _mm_add_ps(_mm_load_ps(buf2ch + i * 2), data));
 					}
-					first_mix = false;
-				}
-				else
-				{
-					for (u32 i = 0; i < (sizeof(buf2ch) / sizeof(float)); i += 2)
-					{
-						step_volume(port);
 
-						const float left = buf[i + 0] * m;
-						const float right = buf[i + 1] * m;
-
-						buf2ch[i + 0] += left;
-						buf2ch[i + 1] += right;
-
-						buf8ch[i * 4 + 0] += left;
-						buf8ch[i * 4 + 1] += right;
+					if (need_8ch)
+					{
+						float* out0 = buf8ch + i * 8;
+						float* out1 = buf8ch + i * 8 + 8;
+						_mm_storel_pi(reinterpret_cast<__m64*>(out0), _mm_add_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(out0)), data));
+						_mm_storel_pi(reinterpret_cast<__m64*>(out1), _mm_add_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(out1)), _mm_movehl_ps(data, data)));
 					}
 				}
 			}
-			else if (port.channel == 8)
+			else
 			{
-				if (first_mix)
+				const __m128 mid_scale = _mm_set1_ps(0.708f);
+
+				for (u32 i = 0; i < BUFFER_SIZE; i++)
 				{
-					for (u32 i = 0; i < (sizeof(buf2ch) / sizeof(float)); i += 2)
+					const __m128 level = _mm_set1_ps(levels[i]);
+
+					// left, right, center, low_freq / rear_left, rear_right, side_left, side_right
+					const __m128 front = _mm_mul_ps(audio_load_be(buf + i * 8 + 0), level);
+					const __m128 back = _mm_mul_ps(audio_load_be(buf + i * 8 + 4), level);
+
+					if (need_2ch)
 					{
-						step_volume(port);
-
-						const float left = buf[i * 4 + 0] * m;
-						const float right = buf[i * 4 + 1] * m;
-						const float center = buf[i * 4 + 2] * m;
-						const float low_freq = buf[i * 4 + 3] * m;
-						const float rear_left = buf[i * 4 + 4] * m;
-						const float rear_right = buf[i * 4 + 5] * m;
-						const float side_left = buf[i * 4 + 6] * m;
-						const float side_right = buf[i * 4 + 7] * m;
-
-						const float mid = (center + low_freq) * 0.708f;
-						buf2ch[i + 0] = (left + rear_left + side_left + mid) * k;
-						buf2ch[i + 1] = (right + rear_right + side_right + mid) * k;
-
-						buf8ch[i * 4 + 0] = left;
-						buf8ch[i * 4 + 1] = right;
-						buf8ch[i * 4 + 2] = center;
-						buf8ch[i * 4 + 3] = low_freq;
-						buf8ch[i * 4 + 4] = rear_left;
-						buf8ch[i * 4 + 5] = rear_right;
-						buf8ch[i * 4 + 6] = side_left;
-						buf8ch[i * 4 + 7] = side_right;
+						// mid = (center + low_freq) * 0.708
+						const __m128 cl = _mm_movehl_ps(front, front);
+						const __m128 mid = _mm_mul_ps(_mm_add_ps(cl, _mm_shuffle_ps(cl, cl, _MM_SHUFFLE(0, 0, 0, 1))), mid_scale);
+						const __m128 sides = _mm_add_ps(back, _mm_movehl_ps(back, back));
+						const __m128 lr = _mm_add_ps(_mm_add_ps(front, sides), _mm_shuffle_ps(mid, mid, _MM_SHUFFLE(0, 0, 0, 0)));
+
+						float* out = buf2ch + i * 2;
+						_mm_storel_pi(reinterpret_cast<__m64*>(out), _mm_add_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(out)), lr));
 					}
-					first_mix = false;
-				}
-				else
-				{
-					for (u32 i = 0; i < (sizeof(buf2ch) / sizeof(float)); i += 2)
+
+					if (need_8ch)
 					{
-						step_volume(port);
-
-						const float left = buf[i * 4 + 0] * m;
-						const float right = buf[i * 4 + 1] * m;
-						const float center = buf[i * 4 + 2] * m;
-						const float low_freq = buf[i * 4 + 3] * m;
-						const float rear_left = buf[i * 4 + 4] * m;
-						const float rear_right = buf[i * 4 + 5] * m;
-						const float side_left = buf[i * 4 + 6] * m;
-						const float side_right = buf[i * 4 + 7] * m;
-
-						const float mid = (center + low_freq) * 0.708f;
-						buf2ch[i + 0] += (left + rear_left + side_left + mid) * k;
-						buf2ch[i + 1] += (right + rear_right + side_right + mid) * k;
-
-						buf8ch[i * 4 + 0] += left;
-						buf8ch[i * 4 + 1] += right;
-						buf8ch[i * 4 + 2] += center;
-						buf8ch[i * 4 + 3] += low_freq;
-						buf8ch[i * 4 + 4] += rear_left;
-						buf8ch[i * 4 + 5] += rear_right;
-						buf8ch[i * 4 + 6] += side_left;
-						buf8ch[i * 4 + 7] += side_right;
+						_mm_store_ps(buf8ch + i * 8 + 0, _mm_add_ps(_mm_load_ps(buf8ch + i * 8 + 0), front));
+						_mm_store_ps(buf8ch + i * 8 + 4, _mm_add_ps(_mm_load_ps(buf8ch + i * 8 + 4), back));
 					}
 				}
 			}
-			else
-			{
-				fmt::throw_exception("Unknown channel count (port=%u, channel=%d)" HERE, port.number, port.channel);
-			}
 
 			memset(buf, 0, block_size * sizeof(float));
 		}
 
-
 		if (!first_mix)
 		{
 			// Copy output data (2ch or 8ch)
 			if (g_cfg.audio.downmix_to_2ch)
 			{
-				for (u32 i = 0; i < (sizeof(buf2ch) / sizeof(float)); i++)
-				{
-					out_buffer[out_pos][i] = buf2ch[i];
-				}
+				std::memcpy(out_buffer[out_pos].get(), buf2ch, sizeof(buf2ch));
 			}
 			else
 			{
-				for (u32 i = 0; i < (sizeof(buf8ch) / sizeof(float)); i++)
-				{
-					out_buffer[out_pos][i] = buf8ch[i];
-				}
+				std::memcpy(out_buffer[out_pos].get(), buf8ch, sizeof(buf8ch));
 			}
 		}
 
 		const u64 stamp1 = get_system_time();
 
+		// Measure the data still queued in the backend (0 may also mean it can't be reported)
+		const u64 queued = audio->GetLatency();
+
+		if (queued)
+		{
+			m_latency_known = true;
+		}
+		else if (m_latency_known)
+		{
+			underruns++;
+			cellAudio.warning("Audio underrun (count=%llu, buffers=%d)", underruns.load(), g_cfg.audio.frames);
+		}
+
+		latency = queued;
+
 		if (first_mix)
 		{
 			std::memset(out_buffer[out_pos].get(), 0, 8 * BUFFER_SIZE * sizeof(float));
@@ -339,8 +319,8 @@ void audio_config::on_task()
 		case 8: m_dump.WriteData(&buf8ch, sizeof(buf8ch)); break; // write file data (8 ch)
 		}
 
-		cellAudio.trace("Audio perf: (access=%d, AddData=%d, events=%d, dump=%d)",
-			stamp1 - stamp0, stamp2 - stamp1, stamp3 - stamp2, get_system_time() - stamp3);
+		cellAudio.trace("Audio perf: (access=%d, AddData=%d, events=%d, dump=%d, latency=%d)",
+			stamp1 - stamp0, stamp2 - stamp1, stamp3 - stamp2, get_system_time() - stamp3, queued);
 	}
 }
 
@@ -130,6 +130,8 @@ class audio_config final : public named_thread
 
 	u64 m_counter{};
 
+	bool m_latency_known = false;
+
 public:
 	void on_init(const std::shared_ptr<void>&) override;
 
@@ -141,6 +143,12 @@ public:
 
 	semaphore<> mutex;
 
+	// Output latency measured before the last block was submitted (in microseconds)
+	atomic_t<u64> latency{0};
+
+	// Number of times the backend ran out of data
+	atomic_t<u64> underruns{0};
+
 	audio_config() = default;
 
 	~audio_config()
@@ -66,6 +66,40 @@ struct DemuxerStream
 		return count <= size;
 	}
 
+	// Skip to the next 00 00 01 prefix after the current position (or to the end if there is none)
+	void skip_to_start_code()
+	{
+		const u8* const data = vm::_ptr<u8>(addr);
+
+		u32 pos = 1;
+
+		// Compare 16 candidate third bytes at once, then check the two zero bytes before each match
+		for (; pos + 18 <= size; pos += 16)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 2));
+
+			for (u32 mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(1))); mask; mask &= mask - 1)
+			{
+				const u32 i = pos + cnttz32(mask, true);
+
+				if (data[i] == 0 && data[i + 1] == 0 && i + 4 <= size)
+				{
+					return skip(i);
+				}
+			}
+		}
+
+		for (; pos + 4 <= size; pos++)
+		{
+			if (data[pos] == 0 && data[pos + 1] == 0 && data[pos + 2] == 1)
+			{
+				return skip(pos);
+			}
+		}
+
+		skip(size);
+	}
+
 	u64 get_ts(u8 c)
 	{
 		u8 v[4]; get((u32&)v); 
@@ -494,7 +528,7 @@ public:
 					}
 
 					// search
-					stream.skip(1);
+					stream.skip_to_start_code();
 				}
 				}
 
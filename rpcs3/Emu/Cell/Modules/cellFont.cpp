@@ -1,5 +1,6 @@
 ﻿#include "stdafx.h"
 #include "Emu/System.h"
+#include "Emu/IdManager.h"
 #include "Emu/Cell/PPUModule.h"
 
 // Defines STB_TRUETYPE_IMPLEMENTATION *once* before including stb_truetype.h (as noted in stb_truetype.h's comments)
@@ -8,8 +9,88 @@
 
 #include "cellFont.h"
 
+#include <list>
+#include <map>
+#include <tuple>
+
 logs::channel cellFont("cellFont");
 
+// Rasterized glyphs, reused while the same font, size and code point are rendered again
+struct font_glyph_cache
+{
+	static const u32 max_glyphs = 1024;
+
+	struct glyph
+	{
+		std::vector<u8> bitmap;
+		s32 width, height, xoff, yoff;
+	};
+
+	// Font data address, pixel height (float bits), code point
+	using key_type = std::tuple<u32, u32, u32>;
+
+	semaphore<> mutex;
+
+	// Most recently used first
+	std::list<std::pair<key_type, glyph>> lru;
+	std::map<key_type, std::list<std::pair<key_type, glyph>>::iterator> glyphs;
+
+	const glyph& get(stbtt_fontinfo* info, u32 font_addr, float pixel_height, u32 code)
+	{
+		const auto key = std::make_tuple(font_addr, (u32&)pixel_height, code);
+
+		const auto found = glyphs.find(key);
+
+		if (found != glyphs.end())
+		{
+			lru.splice(lru.begin(), lru, found->second);
+			return found->second->second;
+		}
+
+		glyph result{};
+
+		const float scale = stbtt_ScaleForPixelHeight(info, pixel_height);
+
+		if (unsigned char* box = stbtt_GetCodepointBitmap(info, scale, scale, code, &result.width, &result.height, &result.xoff, &result.yoff))
+		{
+			result.bitmap.assign(box, box + result.width * result.height);
+			stbtt_FreeBitmap(box, 0);
+		}
+		else
+		{
+			result.width = 0;
+			result.height = 0;
+		}
+
+		lru.emplace_front(key, std::move(result));
+		glyphs.emplace(key, lru.begin());
+
+		if (lru.size() > max_glyphs)
+		{
+			glyphs.erase(lru.back().first);
+			lru.pop_back();
+		}
+
+		return lru.front().second;
+	}
+
+	void erase_font(u32 font_addr)
+	{
+		for (auto it = lru.begin(); it != lru.end();)
+		{
+			if (std::get<0>(it->first) == font_addr)
+			{
+				glyphs.erase(it->first);
+				it = lru.erase(it);
+			}
+			else
+			{
+				it++;
+			}
+		}
+	}
+};
+
 // Functions
 s32 cellFontInitializeWithRevision(u64 revisionFlags, vm::ptr<CellFontConfig> config)
 {
@@ -307,12 +388,17 @@ s32 cellFontRenderCharGlyphImage(vm::ptr<CellFont> font, u32 code, vm::ptr<CellF
 		return CELL_FONT_ERROR_RENDERER_UNBIND;
 	}
 
-	// Render the character
-	s32 width, height, xoff, yoff;
-	float scale = stbtt_ScaleForPixelHeight(font->stbfont, font->scale_y);
-	unsigned char* box = stbtt_GetCodepointBitmap(font->stbfont, scale, scale, code, &width, &height, &xoff, &yoff);
+	// Render the character (or reuse the cached bitmap)
+	const auto cache = fxm::get_always<font_glyph_cache>();
 
-	if (!box)
+	semaphore_lock lock(cache->mutex);
+
+	const float pixel_height = font->scale_y;
+	const auto& glyph = cache->get(font->stbfont, font->fontdata_addr, pixel_height, code);
+
+	const s32 width = glyph.width, height = glyph.height, yoff = glyph.yoff;
+
+	if (!width || !height)
 	{
 		return CELL_OK;
 	}
@@ -320,26 +406,23 @@ s32 cellFontRenderCharGlyphImage(vm::ptr<CellFont> font, u32 code, vm::ptr<CellF
 	// Get the baseLineY value
 	s32 baseLineY;
 	s32 ascent, descent, lineGap;
+	float scale = stbtt_ScaleForPixelHeight(font->stbfont, pixel_height);
 	stbtt_GetFontVMetrics(font->stbfont, &ascent, &descent, &lineGap);
 	baseLineY = (int)((float)ascent * scale); // ???
 
-	// Move the rendered character to the surface
+	// Move the rendered character to the surface, one clipped row at a time
+	const u32 row_size = (u32)x >= (u32)surface->width ? 0 : std::min<u32>(width, (u32)surface->width - (u32)x);
+
 	unsigned char* buffer = vm::_ptr<unsigned char>(surface->buffer.addr());
-	for (u32 ypos = 0; ypos < (u32)height; ypos++)
+	for (u32 ypos = 0; ypos < (u32)height && row_size; ypos++)
 	{
 		if ((u32)y + ypos + yoff + baseLineY >= (u32)surface->height)
 			break;
 
-		for (u32 xpos = 0; xpos < (u32)width; xpos++)
-		{
-			if ((u32)x + xpos >= (u32)surface->width)
-				break;
-
-			// TODO: There are some oddities in the position of the character in the final buffer
-			buffer[((s32)y + ypos + yoff + baseLineY)*surface->width + (s32)x + xpos] = box[ypos * width + xpos];
-		}
+		// TODO: There are some oddities in the position of the character in the final buffer
+		std::memcpy(&buffer[((s32)y + ypos + yoff + baseLineY)*surface->width + (s32)x], &glyph.bitmap[ypos * width], row_size);
 	}
-	stbtt_FreeBitmap(box, 0);
+
 	return CELL_OK;
 }
 
@@ -391,6 +474,12 @@ s32 cellFontCloseFont(vm::ptr<CellFont> font)
 		vm::dealloc(font->fontdata_addr, vm::main);
 	}
 
+	if (const auto cache = fxm::get<font_glyph_cache>())
+	{
+		semaphore_lock lock(cache->mutex);
+		cache->erase_font(font->fontdata_addr);
+	}
+
 	return CELL_OK;
 }
 
@@ -891,15 +891,17 @@ struct fs_aio_thread : ppu_thread
 			}
 			else
 			{
-				std::lock_guard<std::mutex> lock(file->mp->mutex);
+				// Positional host I/O lets the workers run requests concurrently
+				std::unique_lock<std::mutex> lock(file->mp->mutex, std::defer_lock);
 
-				const auto old_pos = file->file.pos(); file->file.seek(aio->offset);
+				if (!file->file.is_positional())
+				{
+					lock.lock();
+				}
 
 				result = type == 2
-					? file->op_write(aio->buf, aio->size)
-					: file->op_read(aio->buf, aio->size);
-
-				file->file.seek(old_pos);
+					? file->op_write_at(aio->offset, aio->buf, aio->size)
+					: file->op_read_at(aio->offset, aio->buf, aio->size);
 			}
 
 			func(*this, aio, error, xid, result);
@@ -910,7 +912,15 @@ struct fs_aio_thread : ppu_thread
 
 struct fs_aio_manager
 {
-	std::shared_ptr<fs_aio_thread> thread;
+	// Worker threads, requests are distributed in round-robin order
+	std::array<std::shared_ptr<fs_aio_thread>, 4> threads;
+
+	atomic_t<u32> next{0};
+
+	const std::shared_ptr<fs_aio_thread>& get_thread()
+	{
+		return threads[next++ % threads.size()];
+	}
 };
 
 s32 cellFsAioInit(vm::cptr<char> mount_point)
@@ -922,8 +932,11 @@ s32 cellFsAioInit(vm::cptr<char> mount_point)
 
 	if (m)
 	{
-		m->thread = idm::make_ptr<ppu_thread, fs_aio_thread>("FS AIO Thread", 500);
-		m->thread->run();
+		for (u32 i = 0; i < m->threads.size(); i++)
+		{
+			m->threads[i] = idm::make_ptr<ppu_thread, fs_aio_thread>(fmt::format("FS AIO Thread %u", i), 500);
+			m->threads[i]->run();
+		}
 	}
 
 	return CELL_OK;
@@ -955,13 +968,15 @@ s32 cellFsAioRead(vm::ptr<CellFsAio> aio, vm::ptr<s32> id, fs_aio_cb_t func)
 
 	const s32 xid = (*id = ++g_fs_aio_id);
 
-	m->thread->cmd_list
+	const auto& thread = m->get_thread();
+
+	thread->cmd_list
 	({
 		{ 1, xid },
 		{ aio, func },
 	});
 
-	m->thread->notify();
+	thread->notify();
 
 	return CELL_OK;
 }
@@ -981,13 +996,15 @@ s32 cellFsAioWrite(vm::ptr<CellFsAio> aio, vm::ptr<s32> id, fs_aio_cb_t func)
 
 	const s32 xid = (*id = ++g_fs_aio_id);
 
-	m->thread->cmd_list
+	const auto& thread = m->get_thread();
+
+	thread->cmd_list
 	({
 		{ 2, xid },
 		{ aio, func },
 	});
 
-	m->thread->notify();
+	thread->notify();
 
 	return CELL_OK;
 }
@@ -163,7 +163,7 @@ s32 cellHddGameCheck(ppu_thread& ppu, u32 version, vm::cptr<char> dirName, u32 e
 	else
 	{
 		// TODO: Is cellHddGameCheck really responsible for writing the information in get->getParam ? (If not, delete this else)
-		const auto& psf = psf::load_object(fs::file(local_dir +"/PARAM.SFO"));
+		const auto& psf = psf::load_cached(local_dir +"/PARAM.SFO");
 
 		// Some following fields may be zero in old FW 1.00 version PARAM.SFO
 		if (psf.count("PARENTAL_LEVEL") != 0) get->getParam.parentalLevel = psf.at("PARENTAL_LEVEL").as_integer();
@@ -280,7 +280,7 @@ error_code cellGameBootCheck(vm::ptr<u32> type, vm::ptr<u32> attributes, vm::ptr
 		*attributes = 0; // TODO
 		// TODO: dirName might be a read only string when BootCheck is called on a disc game. (e.g. Ben 10 Ultimate Alien: Cosmic Destruction)
 
-		if (!fxm::make<content_permission>("", psf::load_object(fs::file(vfs::get("/dev_bdvd/PS3_GAME/PARAM.SFO")))))
+		if (!fxm::make<content_permission>("", psf::load_cached(vfs::get("/dev_bdvd/PS3_GAME/PARAM.SFO"))))
 		{
 			return CELL_GAME_ERROR_BUSY;
 		}
@@ -291,7 +291,7 @@ error_code cellGameBootCheck(vm::ptr<u32> type, vm::ptr<u32> attributes, vm::ptr
 		*attributes = CELL_GAME_ATTRIBUTE_PATCH; // TODO
 		if (dirName) strcpy_trunc(*dirName, Emu.GetTitleID()); // ???
 
-		if (!fxm::make<content_permission>("", psf::load_object(fs::file(vfs::get(Emu.GetDir() + "PARAM.SFO")))))
+		if (!fxm::make<content_permission>("", psf::load_cached(vfs::get(Emu.GetDir() + "PARAM.SFO"))))
 		{
 			return CELL_GAME_ERROR_BUSY;
 		}
@@ -302,7 +302,7 @@ error_code cellGameBootCheck(vm::ptr<u32> type, vm::ptr<u32> attributes, vm::ptr
 		*attributes = 0; // TODO
 		if (dirName) strcpy_trunc(*dirName, Emu.GetTitleID());
 
-		if (!fxm::make<content_permission>(Emu.GetTitleID(), psf::load_object(fs::file(vfs::get(Emu.GetDir() + "PARAM.SFO")))))
+		if (!fxm::make<content_permission>(Emu.GetTitleID(), psf::load_cached(vfs::get(Emu.GetDir() + "PARAM.SFO"))))
 		{
 			return CELL_GAME_ERROR_BUSY;
 		}
@@ -330,7 +330,7 @@ error_code cellGamePatchCheck(vm::ptr<CellGameContentSize> size, vm::ptr<void> r
 		return CELL_GAME_ERROR_NOTPATCH;
 	}
 
-	if (!fxm::make<content_permission>(Emu.GetTitleID(), psf::load_object(fs::file(vfs::get(Emu.GetDir() + "PARAM.SFO")))))
+	if (!fxm::make<content_permission>(Emu.GetTitleID(), psf::load_cached(vfs::get(Emu.GetDir() + "PARAM.SFO"))))
 	{
 		return CELL_GAME_ERROR_BUSY;
 	}
@@ -378,7 +378,7 @@ error_code cellGameDataCheck(u32 type, vm::cptr<char> dirName, vm::ptr<CellGameC
 		return not_an_error(CELL_GAME_RET_NONE);
 	}
 
-	prm->sfo = psf::load_object(fs::file(vfs::get(dir + "/PARAM.SFO")));
+	prm->sfo = psf::load_cached(vfs::get(dir + "/PARAM.SFO"));
 	return CELL_OK;
 }
 
@@ -427,7 +427,7 @@ error_code cellGameContentPermit(vm::ptr<char[CELL_GAME_PATH_MAX]> contentInfoPa
 		}
 
 		// Create PARAM.SFO
-		psf::save_object(fs::file(vdir + "/PARAM.SFO", fs::rewrite), prm->sfo);
+		psf::save_cached(vdir + "/PARAM.SFO", prm->sfo);
 
 		// Disable deletion
 		prm->temp.clear();
@@ -477,7 +477,7 @@ error_code cellGameDataCheckCreate2(ppu_thread& ppu, u32 version, vm::cptr<char>
 	cbGet->sizeKB = CELL_GAMEDATA_SIZEKB_NOTCALC;
 	cbGet->sysSizeKB = 0;
 
-	psf::registry sfo = psf::load_object(fs::file(vfs::get(dir + "/PARAM.SFO")));
+	psf::registry sfo = psf::load_cached(vfs::get(dir + "/PARAM.SFO"));
 
 	cbGet->getParam.attribute = CELL_GAMEDATA_ATTR_NORMAL;
 	cbGet->getParam.parentalLevel = psf::get_integer(sfo, "PARENTAL_LEVEL", 0);
@@ -540,7 +540,7 @@ error_code cellGameDataCheckCreate2(ppu_thread& ppu, u32 version, vm::cptr<char>
 				return {CELL_GAME_ERROR_INTERNAL, dir};
 			}
 
-			psf::save_object(fs::file(vdir + "/PARAM.SFO", fs::rewrite), sfo);
+			psf::save_cached(vdir + "/PARAM.SFO", sfo);
 		}
 
 		return CELL_OK;
@@ -888,7 +888,7 @@ s32 cellDiscGameGetBootDiscInfo(vm::ptr<CellDiscGameSystemFileParam> getParam)
 		return CELL_DISCGAME_ERROR_NOT_DISCBOOT;
 	}
 
-	const auto& psf = psf::load_object(fs::file(vfs::get(dir + "/PARAM.SFO")));
+	const auto& psf = psf::load_cached(vfs::get(dir + "/PARAM.SFO"));
 
 	if (psf.count("PARENTAL_LEVEL") != 0) getParam->parentalLevel = psf.at("PARENTAL_LEVEL").as_integer();
 	if (psf.count("TITLE_ID") != 0) strcpy_trunc(getParam->titleId, psf.at("TITLE_ID").as_string());
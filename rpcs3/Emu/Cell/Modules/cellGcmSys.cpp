@@ -550,6 +550,7 @@ s32 cellGcmSetPrepareFlip(ppu_thread& ppu, vm::ptr<CellGcmContextData> ctxt, u32
 	if (ctxt.addr() == m_config->gcm_info.context_addr)
 	{
 		vm::_ref<CellGcmControl>(m_config->gcm_info.control_addr).put += cmd_size;
+		rsx::get_current_renderer()->fifo_wake();
 	}
 
 	return id;
@@ -1369,6 +1370,7 @@ s32 cellGcmCallback(ppu_thread& ppu, vm::ptr<CellGcmContextData> context, u32 co
 
 	// Flush command buffer (ie allow RSX to read up to context->current)
 	ctrl.put.exchange(getOffsetFromAddress(context->current.addr()));
+	rsx::get_current_renderer()->fifo_wake();
 
 	std::pair<u32, u32> newCommandBuffer = getNextCommandBufferBeginEnd(context->current.addr());
 	u32 offset = getOffsetFromAddress(newCommandBuffer.first);
@@ -341,9 +341,59 @@ s32 cellGemConvertVideoFinish()
 	return CELL_OK;
 }
 
+// Converts a 640x480 Bayer camera frame (assumed GRBG: G R on even rows, B G on odd rows) straight into the guest output buffer
+static void gem_convert_video(const CellGemVideoConvertAttribute& vc, const u8* src, u8* dst)
+{
+	// Gains are applied through per channel lookup tables
+	const f32 gains[3] = { vc.gain * vc.red_gain, vc.gain * vc.green_gain, vc.gain * vc.blue_gain };
+	u8 lut[3][256];
+
+	for (u32 c = 0; c < 3; c++)
+	{
+		for (u32 i = 0; i < 256; i++)
+		{
+			lut[c][i] = static_cast<u8>(std::clamp(i * gains[c] + 0.5f, 0.0f, 255.0f));
+		}
+	}
+
+	const bool half = vc.output_format == CELL_GEM_RGBA_320x240;
+	const u32 out_width = half ? 320 : 640;
+
+	// Each 2x2 Bayer cell produces one RGBA pixel, which is replicated to the cell at full resolution
+	for (u32 y = 0; y < 480; y += 2)
+	{
+		const u8* row0 = src + y * 640;
+		const u8* row1 = row0 + 640;
+		u8* out0 = dst + (half ? y / 2 : y) * out_width * 4;
+		u8* out1 = out0 + out_width * 4;
+
+		for (u32 x = 0; x < 640; x += 2)
+		{
+			const u8 pixel[4] =
+			{
+				lut[0][row0[x + 1]],
+				lut[1][(row0[x] + row1[x + 1]) / 2],
+				lut[2][row1[x]],
+				vc.alpha,
+			};
+
+			if (half)
+			{
+				std::memcpy(out0 + x * 2, pixel, 4);
+				continue;
+			}
+
+			std::memcpy(out0 + x * 4, pixel, 4);
+			std::memcpy(out0 + x * 4 + 4, pixel, 4);
+			std::memcpy(out1 + x * 4, pixel, 4);
+			std::memcpy(out1 + x * 4 + 4, pixel, 4);
+		}
+	}
+}
+
 s32 cellGemConvertVideoStart(vm::cptr<void> video_frame)
 {
-	cellGem.todo("cellGemConvertVideoStart(video_frame=*0x%x)", video_frame);
+	cellGem.trace("cellGemConvertVideoStart(video_frame=*0x%x)", video_frame);
 	const auto gem = fxm::get<gem_t>();
 
 	if (!gem)
@@ -351,6 +401,37 @@ s32 cellGemConvertVideoStart(vm::cptr<void> video_frame)
 		return CELL_GEM_ERROR_UNINITIALIZED;
 	}
 
+	if (!video_frame)
+	{
+		return CELL_GEM_ERROR_INVALID_PARAMETER;
+	}
+
+	const auto& vc = gem->vc_attribute;
+
+	switch (vc.output_format)
+	{
+	case CELL_GEM_RGBA_640x480:
+	case CELL_GEM_RGBA_320x240:
+	{
+		// The conversion is done synchronously, cellGemConvertVideoFinish has nothing left to wait for
+		if (vc.video_data_out)
+		{
+			gem_convert_video(vc, static_cast<const u8*>(video_frame.get_ptr()), vm::_ptr<u8>(vc.video_data_out));
+		}
+
+		break;
+	}
+	case CELL_GEM_NO_VIDEO_OUTPUT:
+	{
+		break;
+	}
+	default:
+	{
+		cellGem.todo("cellGemConvertVideoStart(): unsupported output format %d", vc.output_format);
+		break;
+	}
+	}
+
 	return CELL_OK;
 }
 
@@ -11,6 +11,26 @@
 
 logs::channel cellJpgDec("cellJpgDec");
 
+// Convert RGBA pixels to ARGB (rotate every pixel by one byte)
+static void jpgDecRgbaToArgb(u8* dst, const u8* src, u32 pixels)
+{
+	u32 i = 0;
+
+	for (; i + 4 <= pixels; i += 4)
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(_mm_srli_epi32(v, 24), _mm_slli_epi32(v, 8)));
+	}
+
+	for (; i < pixels; i++)
+	{
+		dst[i * 4 + 0] = src[i * 4 + 3];
+		dst[i * 4 + 1] = src[i * 4 + 0];
+		dst[i * 4 + 2] = src[i * 4 + 1];
+		dst[i * 4 + 3] = src[i * 4 + 2];
+	}
+}
+
 s32 cellJpgDecCreate(u32 mainHandle, u32 threadInParam, u32 threadOutParam)
 {
 	UNIMPLEMENTED_FUNC(cellJpgDec);
@@ -178,29 +198,35 @@ s32 cellJpgDecDecodeData(u32 mainHandle, u32 subHandle, vm::ptr<u8> data, vm::cp
 	const u64& fileSize = subHandle_data->fileSize;
 	const CellJpgDecOutParam& current_outParam = subHandle_data->outParam; 
 
-	//Copy the JPG file to a buffer
-	std::unique_ptr<u8[]> jpg(new u8[fileSize]);
+	//Copy the JPG file to a buffer (a guest buffer is decoded in place)
+	std::unique_ptr<u8[]> jpg;
+	const u8* jpg_data = nullptr;
 
 	switch (subHandle_data->src.srcSelect)
 	{
 	case CELL_JPGDEC_BUFFER:
-		std::memcpy(jpg.get(), vm::base(subHandle_data->src.streamPtr), fileSize);
+		jpg_data = vm::_ptr<u8>(subHandle_data->src.streamPtr);
 		break;
 
 	case CELL_JPGDEC_FILE:
 	{
+		jpg.reset(new u8[fileSize]);
 		auto file = idm::get<lv2_fs_object, lv2_file>(fd);
 		file->file.seek(0);
 		file->file.read(jpg.get(), fileSize);
+		jpg_data = jpg.get();
 		break;
 	}
 	}
 
+	// Let the decoder produce the output component count directly (RGB has no alpha)
+	const int req_components = current_outParam.outputColorSpace == CELL_JPG_RGB ? 3 : 4;
+
 	//Decode JPG file. (TODO: Is there any faster alternative? Can we do it without external libraries?)
 	int width, height, actual_components;
 	auto image = std::unique_ptr<unsigned char,decltype(&::free)>
 		(
-			stbi_load_from_memory(jpg.get(), (s32)fileSize, &width, &height, &actual_components, 4),
+			stbi_load_from_memory(jpg_data, (s32)fileSize, &width, &height, &actual_components, req_components),
 			&::free
 		);
 
@@ -241,38 +267,17 @@ s32 cellJpgDecDecodeData(u32 mainHandle, u32 subHandle, vm::ptr<u8> data, vm::cp
 		image_size *= nComponents;
 		if (bytesPerLine > width * nComponents || flip) //check if we need padding
 		{
-			//TODO: Find out if we can't do padding without an extra copy
 			const int linesize = std::min(bytesPerLine, width * nComponents);
-			char *output = (char *) malloc(linesize);
 			for (int i = 0; i < height; i++)
 			{
 				const int dstOffset = i * bytesPerLine;
 				const int srcOffset = width * nComponents * (flip ? height - i - 1 : i);
-				for (int j = 0; j < linesize; j += nComponents)
-				{
-					output[j + 0] = image.get()[srcOffset + j + 3];
-					output[j + 1] = image.get()[srcOffset + j + 0];
-					output[j + 2] = image.get()[srcOffset + j + 1];
-					output[j + 3] = image.get()[srcOffset + j + 2];
-				}
-				memcpy(&data[dstOffset], output, linesize);
+				jpgDecRgbaToArgb(&data[dstOffset], &image.get()[srcOffset], linesize / nComponents);
 			}
-			free(output);
 		}
 		else
 		{
-			uint* img = (uint*)new char[image_size];
-			uint* source_current = (uint*)&(image.get()[0]);
-			uint* dest_current = img;
-			for (uint i = 0; i < image_size / nComponents; i++) 
-			{
-				uint val = *source_current;
-				*dest_current = (val >> 24) | (val << 8); // set alpha (A8) as leftmost byte
-				source_current++;
-				dest_current++;
-			}
-			memcpy(data.get_ptr(), img, image_size); 
-			delete[] img;
+			jpgDecRgbaToArgb(data.get_ptr(), image.get(), width * height);
 		}
 	}
 	break;
@@ -205,8 +205,264 @@ std::string _OemToOem(HostCode src_code, HostCode dst_code, const std::string& s
 
 #endif
 
+// Unicode encodings are transcoded natively (big endian without BOM, as on the PS3) instead of through host code pages
+static bool _L10nIsUnicode(s32 code)
+{
+	return code == L10N_UTF8 || code == L10N_UTF16 || code == L10N_UTF32 || code == L10N_UCS2 || code == L10N_UCS4;
+}
+
+static s32 _ConvertUnicode(s32 src_code, const u8* src, u32 src_len, s32 dst_code, u8* dst, s32* dst_len, bool allowIncomplete)
+{
+	const u32 dst_max = dst ? *dst_len : UINT32_MAX;
+	const bool src_wide = src_code == L10N_UTF16 || src_code == L10N_UCS2;
+	const bool dst_wide = dst_code == L10N_UTF16 || dst_code == L10N_UCS2;
+
+	s32 result = ConversionOK;
+	u32 s = 0, d = 0;
+
+	while (s < src_len)
+	{
+		// Fast path for runs of 16 ASCII characters (8 for UTF-16 sources)
+		if (src_code == L10N_UTF8 && dst_wide && src_len - s >= 16 && dst_max - d >= 32)
+		{
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + s));
+
+			if (_mm_movemask_epi8(bytes) == 0)
+			{
+				if (dst)
+				{
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + d), _mm_unpacklo_epi8(_mm_setzero_si128(), bytes));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + d + 16), _mm_unpackhi_epi8(_mm_setzero_si128(), bytes));
+				}
+
+				s += 16;
+				d += 32;
+				continue;
+			}
+		}
+		else if (src_wide && dst_code == L10N_UTF8 && src_len - s >= 16 && dst_max - d >= 8)
+		{
+			// Big endian characters below 0x80 have the high byte clear and bit 7 of the low byte clear
+			const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + s));
+
+			if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(chars, _mm_set1_epi16(0x80ff)), _mm_setzero_si128())) == 0xffff)
+			{
+				if (dst)
+				{
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + d), _mm_packus_epi16(_mm_srli_epi16(chars, 8), _mm_setzero_si128()));
+				}
+
+				s += 16;
+				d += 8;
+				continue;
+			}
+		}
+
+		u32 cp = 0, len = 0;
+		bool illegal = false;
+
+		switch (src_code)
+		{
+		case L10N_UTF8:
+		{
+			const u8 c = src[s];
+			len = c < 0x80 ? 1 : c < 0xc2 ? 0 : c < 0xe0 ? 2 : c < 0xf0 ? 3 : c < 0xf5 ? 4 : 0;
+
+			if (len == 0)
+			{
+				illegal = true;
+				break;
+			}
+
+			cp = len == 1 ? c : c & (0x7f >> len);
+
+			for (u32 i = 1; i < len && !illegal; i++)
+			{
+				if (s + i >= src_len)
+				{
+					break;
+				}
+
+				illegal = (src[s + i] & 0xc0) != 0x80;
+				cp = cp << 6 | (src[s + i] & 0x3f);
+			}
+
+			if (!illegal && s + len <= src_len)
+			{
+				illegal = (len == 3 && cp < 0x800) || (len == 4 && (cp < 0x10000 || cp > 0x10ffff)) || (cp >= 0xd800 && cp < 0xe000);
+			}
+
+			break;
+		}
+		case L10N_UTF16:
+		case L10N_UCS2:
+		{
+			len = 2;
+
+			if (s + 2 > src_len)
+			{
+				break;
+			}
+
+			cp = src[s] << 8 | src[s + 1];
+
+			if (cp >= 0xd800 && cp < 0xdc00 && src_code == L10N_UTF16)
+			{
+				len = 4;
+
+				if (s + 4 > src_len)
+				{
+					break;
+				}
+
+				const u32 low = src[s + 2] << 8 | src[s + 3];
+				illegal = low < 0xdc00 || low >= 0xe000;
+				cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+			}
+			else
+			{
+				illegal = cp >= 0xd800 && cp < 0xe000;
+			}
+
+			break;
+		}
+		default:
+		{
+			len = 4;
+
+			if (s + 4 > src_len)
+			{
+				break;
+			}
+
+			cp = src[s] << 24 | src[s + 1] << 16 | src[s + 2] << 8 | src[s + 3];
+			illegal = cp > 0x10ffff || (cp >= 0xd800 && cp < 0xe000);
+			break;
+		}
+		}
+
+		if (illegal)
+		{
+			result = SRCIllegal;
+			break;
+		}
+
+		if (s + len > src_len)
+		{
+			// Incomplete sequence at the end of the source
+			if (allowIncomplete)
+			{
+				*dst_len = -1;  // TODO: correct value?
+				return result;
+			}
+
+			result = SRCIllegal;
+			break;
+		}
+
+		u8 buf[4];
+		u32 out;
+
+		switch (dst_code)
+		{
+		case L10N_UTF8:
+		{
+			if (cp < 0x80)
+			{
+				buf[0] = cp;
+				out = 1;
+			}
+			else if (cp < 0x800)
+			{
+				buf[0] = 0xc0 | cp >> 6;
+				buf[1] = 0x80 | (cp & 0x3f);
+				out = 2;
+			}
+			else if (cp < 0x10000)
+			{
+				buf[0] = 0xe0 | cp >> 12;
+				buf[1] = 0x80 | (cp >> 6 & 0x3f);
+				buf[2] = 0x80 | (cp & 0x3f);
+				out = 3;
+			}
+			else
+			{
+				buf[0] = 0xf0 | cp >> 18;
+				buf[1] = 0x80 | (cp >> 12 & 0x3f);
+				buf[2] = 0x80 | (cp >> 6 & 0x3f);
+				buf[3] = 0x80 | (cp & 0x3f);
+				out = 4;
+			}
+
+			break;
+		}
+		case L10N_UTF16:
+		case L10N_UCS2:
+		{
+			if (cp < 0x10000)
+			{
+				buf[0] = cp >> 8;
+				buf[1] = cp;
+				out = 2;
+			}
+			else
+			{
+				const u32 high = 0xd800 + ((cp - 0x10000) >> 10);
+				const u32 low = 0xdc00 + ((cp - 0x10000) & 0x3ff);
+				buf[0] = high >> 8;
+				buf[1] = high;
+				buf[2] = low >> 8;
+				buf[3] = low;
+				out = 4;
+			}
+
+			illegal = out > 2 && dst_code == L10N_UCS2;
+			break;
+		}
+		default:
+		{
+			buf[0] = cp >> 24;
+			buf[1] = cp >> 16;
+			buf[2] = cp >> 8;
+			buf[3] = cp;
+			out = 4;
+			break;
+		}
+		}
+
+		if (illegal)
+		{
+			// Not representable in UCS-2
+			result = SRCIllegal;
+			break;
+		}
+
+		if (out > dst_max - d)
+		{
+			result = DSTExhausted;
+			break;
+		}
+
+		if (dst)
+		{
+			std::memcpy(dst + d, buf, out);
+		}
+
+		s += len;
+		d += out;
+	}
+
+	*dst_len = d;
+	return result;
+}
+
 s32 _ConvertStr(s32 src_code, const void *src, s32 src_len, s32 dst_code, void *dst, s32 *dst_len, bool allowIncomplete)
 {
+	if (_L10nIsUnicode(src_code) && _L10nIsUnicode(dst_code))
+	{
+		return _ConvertUnicode(src_code, static_cast<const u8*>(src), src_len, dst_code, static_cast<u8*>(dst), dst_len, allowIncomplete);
+	}
+
 	HostCode srcCode = 0, dstCode = 0;	//OEM code pages
 	bool src_page_converted = _L10nCodeParse(src_code, srcCode);	//Check if code is in list.
 	bool dst_page_converted = _L10nCodeParse(dst_code, dstCode);
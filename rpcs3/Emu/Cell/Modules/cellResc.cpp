@@ -3,40 +3,127 @@
 #include "Emu/IdManager.h"
 #include "Emu/Cell/PPUModule.h"
 
-#include "Emu/RSX/GCM.h"
+#include "Emu/RSX/GSRender.h"
 #include "cellResc.h"
+#include "cellVideoOut.h"
 
 logs::channel cellResc("cellResc");
 
+extern s32 cellGcmSetDisplayBuffer(u8 id, u32 offset, u32 pitch, u32 width, u32 height);
+extern s32 cellGcmSetPrepareFlip(ppu_thread& ppu, vm::ptr<CellGcmContextData> ctxt, u32 id);
+
+// Resc is emulated by flipping the source buffers directly: the backend scales the display buffer to the output when presenting it
+struct resc_config
+{
+	CellRescInitConfig init_config;
+	CellRescDsts dsts[4]{};
+	u32 display_mode = 0;
+	CellRescSrc src[SRC_BUFFER_NUM]{};
+};
+
+// Index of a single CellRescBufferMode bit (-1 if invalid)
+static s32 resc_buffer_mode_index(u32 mode)
+{
+	switch (mode)
+	{
+	case CELL_RESC_720x480: return 0;
+	case CELL_RESC_720x576: return 1;
+	case CELL_RESC_1280x720: return 2;
+	case CELL_RESC_1920x1080: return 3;
+	}
+
+	return -1;
+}
+
 s32 cellRescInit(vm::ptr<CellRescInitConfig> initConfig)
 {
-	cellResc.todo("cellRescInit(initConfig=*0x%x)", initConfig);
+	cellResc.warning("cellRescInit(initConfig=*0x%x)", initConfig);
+
+	if (!initConfig || initConfig->size > sizeof(CellRescInitConfig))
+	{
+		return CELL_RESC_ERROR_BAD_ARGUMENT;
+	}
+
+	const auto resc = fxm::make<resc_config>();
+
+	if (!resc)
+	{
+		return CELL_RESC_ERROR_REINITIALIZED;
+	}
+
+	resc->init_config = *initConfig;
 
 	return CELL_OK;
 }
 
 void cellRescExit()
 {
-	cellResc.todo("cellRescExit()");
+	cellResc.warning("cellRescExit()");
+
+	fxm::remove<resc_config>();
 }
 
 s32 cellRescVideoOutResolutionId2RescBufferMode(u32 resolutionId, vm::ptr<u32> bufferMode)
 {
-	cellResc.todo("cellRescVideoOutResolutionId2RescBufferMode(resolutionId=%d, bufferMode=*0x%x)", resolutionId, bufferMode);
+	cellResc.trace("cellRescVideoOutResolutionId2RescBufferMode(resolutionId=%d, bufferMode=*0x%x)", resolutionId, bufferMode);
+
+	if (!bufferMode)
+	{
+		return CELL_RESC_ERROR_BAD_ARGUMENT;
+	}
+
+	switch (resolutionId)
+	{
+	case CELL_VIDEO_OUT_RESOLUTION_1080: *bufferMode = CELL_RESC_1920x1080; break;
+	case CELL_VIDEO_OUT_RESOLUTION_720: *bufferMode = CELL_RESC_1280x720; break;
+	case CELL_VIDEO_OUT_RESOLUTION_480: *bufferMode = CELL_RESC_720x480; break;
+	case CELL_VIDEO_OUT_RESOLUTION_576: *bufferMode = CELL_RESC_720x576; break;
+	default: return CELL_RESC_ERROR_BAD_ARGUMENT;
+	}
 
 	return CELL_OK;
 }
 
 s32 cellRescSetDsts(u32 dstsMode, vm::ptr<CellRescDsts> dsts)
 {
-	cellResc.todo("cellRescSetDsts(dstsMode=%d, dsts=*0x%x)", dstsMode, dsts);
+	cellResc.warning("cellRescSetDsts(dstsMode=%d, dsts=*0x%x)", dstsMode, dsts);
+
+	const auto resc = fxm::get<resc_config>();
+
+	if (!resc)
+	{
+		return CELL_RESC_ERROR_NOT_INITIALIZED;
+	}
+
+	const s32 index = resc_buffer_mode_index(dstsMode);
+
+	if (index < 0 || !dsts)
+	{
+		return CELL_RESC_ERROR_BAD_ARGUMENT;
+	}
+
+	resc->dsts[index] = *dsts;
 
 	return CELL_OK;
 }
 
 s32 cellRescSetDisplayMode(u32 displayMode)
 {
-	cellResc.todo("cellRescSetDisplayMode(displayMode=%d)", displayMode);
+	cellResc.warning("cellRescSetDisplayMode(displayMode=%d)", displayMode);
+
+	const auto resc = fxm::get<resc_config>();
+
+	if (!resc)
+	{
+		return CELL_RESC_ERROR_NOT_INITIALIZED;
+	}
+
+	if (resc_buffer_mode_index(displayMode) < 0 || !(resc->init_config.supportModes & displayMode))
+	{
+		return CELL_RESC_ERROR_BAD_ARGUMENT;
+	}
+
+	resc->display_mode = displayMode;
 
 	return CELL_OK;
 }
@@ -64,28 +151,85 @@ s32 cellRescGetBufferSize(vm::ptr<u32> colorBuffers, vm::ptr<u32> vertexArray, v
 
 s32 cellRescGetNumColorBuffers(u32 dstMode, u32 palTemporalMode, u32 reserved)
 {
-	cellResc.todo("cellRescGetNumColorBuffers(dstMode=%d, palTemporalMode=%d, reserved=%d)", dstMode, palTemporalMode, reserved);
+	cellResc.warning("cellRescGetNumColorBuffers(dstMode=%d, palTemporalMode=%d, reserved=%d)", dstMode, palTemporalMode, reserved);
+
+	if (dstMode != CELL_RESC_720x576)
+	{
+		return 2;
+	}
+
+	switch (palTemporalMode)
+	{
+	case CELL_RESC_PAL_60_DROP: return 3;
+	case CELL_RESC_PAL_60_INTERPOLATE:
+	case CELL_RESC_PAL_60_INTERPOLATE_30_DROP:
+	case CELL_RESC_PAL_60_INTERPOLATE_DROP_FLEXIBLE: return 6;
+	}
 
 	return 2;
 }
 
 s32 cellRescGcmSurface2RescSrc(vm::ptr<CellGcmSurface> gcmSurface, vm::ptr<CellRescSrc> rescSrc)
 {
-	cellResc.todo("cellRescGcmSurface2RescSrc(gcmSurface=*0x%x, rescSrc=*0x%x)", gcmSurface, rescSrc);
+	cellResc.trace("cellRescGcmSurface2RescSrc(gcmSurface=*0x%x, rescSrc=*0x%x)", gcmSurface, rescSrc);
+
+	if (!gcmSurface || !rescSrc)
+	{
+		return CELL_RESC_ERROR_BAD_ARGUMENT;
+	}
+
+	rescSrc->format = gcmSurface->colorFormat;
+	rescSrc->pitch = gcmSurface->colorPitch[0];
+	rescSrc->width = gcmSurface->width;
+	rescSrc->height = gcmSurface->height;
+	rescSrc->offset = gcmSurface->colorOffset[0];
 
 	return CELL_OK;
 }
 
 s32 cellRescSetSrc(s32 idx, vm::ptr<CellRescSrc> src)
 {
-	cellResc.todo("cellRescSetSrc(idx=0x%x, src=*0x%x)", idx, src);
+	cellResc.trace("cellRescSetSrc(idx=0x%x, src=*0x%x)", idx, src);
 
-	return CELL_OK;
+	const auto resc = fxm::get<resc_config>();
+
+	if (!resc)
+	{
+		return CELL_RESC_ERROR_NOT_INITIALIZED;
+	}
+
+	if (idx < 0 || idx >= SRC_BUFFER_NUM || !src || !src->width || !src->height)
+	{
+		return CELL_RESC_ERROR_BAD_ARGUMENT;
+	}
+
+	resc->src[idx] = *src;
+
+	// Source buffers are flipped as-is
+	return cellGcmSetDisplayBuffer(idx, src->offset, src->pitch, src->width, src->height);
 }
 
 s32 cellRescSetConvertAndFlip(ppu_thread& ppu, vm::ptr<CellGcmContextData> cntxt, s32 idx)
 {
-	cellResc.todo("cellRescSetConvertAndFlip(cntxt=*0x%x, idx=0x%x)", cntxt, idx);
+	cellResc.trace("cellRescSetConvertAndFlip(cntxt=*0x%x, idx=0x%x)", cntxt, idx);
+
+	const auto resc = fxm::get<resc_config>();
+
+	if (!resc)
+	{
+		return CELL_RESC_ERROR_NOT_INITIALIZED;
+	}
+
+	if (idx < 0 || idx >= SRC_BUFFER_NUM)
+	{
+		return CELL_RESC_ERROR_BAD_ARGUMENT;
+	}
+
+	// No conversion pass is recorded, the scaling to the display mode happens when the backend presents the buffer
+	if (cellGcmSetPrepareFlip(ppu, cntxt, idx) < 0)
+	{
+		return CELL_RESC_ERROR_GCM_FLIP_QUE_FULL;
+	}
 
 	return CELL_OK;
 }
@@ -106,19 +250,23 @@ s32 cellRescSetBufferAddress(vm::ptr<u32> colorBuffers, vm::ptr<u32> vertexArray
 
 void cellRescSetFlipHandler(vm::ptr<void(u32)> handler)
 {
-	cellResc.todo("cellRescSetFlipHandler(handler=*0x%x)", handler);
+	cellResc.warning("cellRescSetFlipHandler(handler=*0x%x)", handler);
+
+	rsx::get_current_renderer()->flip_handler = handler;
 }
 
 void cellRescResetFlipStatus()
 {
-	cellResc.todo("cellRescResetFlipStatus()");
+	cellResc.trace("cellRescResetFlipStatus()");
+
+	rsx::get_current_renderer()->flip_status = CELL_GCM_DISPLAY_FLIP_STATUS_WAITING;
 }
 
 s32 cellRescGetFlipStatus()
 {
-	cellResc.todo("cellRescGetFlipStatus()");
+	cellResc.trace("cellRescGetFlipStatus()");
 
-	return 0;
+	return rsx::get_current_renderer()->flip_status;
 }
 
 s32 cellRescGetRegisterCount()
@@ -129,9 +277,9 @@ s32 cellRescGetRegisterCount()
 
 u64 cellRescGetLastFlipTime()
 {
-	cellResc.todo("cellRescGetLastFlipTime()");
+	cellResc.trace("cellRescGetLastFlipTime()");
 
-	return 0;
+	return rsx::get_current_renderer()->last_flip_time;
 }
 
 void cellRescSetRegisterCount(s32 regCount)
@@ -141,7 +289,9 @@ void cellRescSetRegisterCount(s32 regCount)
 
 void cellRescSetVBlankHandler(vm::ptr<void(u32)> handler)
 {
-	cellResc.todo("cellRescSetVBlankHandler(handler=*0x%x)", handler);
+	cellResc.warning("cellRescSetVBlankHandler(handler=*0x%x)", handler);
+
+	rsx::get_current_renderer()->vblank_handler = handler;
 }
 
 s32 cellRescCreateInterlaceTable(u32 ea_addr, f32 srcH, CellRescTableElement depth, s32 length)
@@ -806,11 +806,18 @@ s32 cellSailPlayerCreateDescriptor(vm::ptr<CellSailPlayer> pSelf, s32 streamType
 			{
 				if (fs::file f{ vfs::get(uri.substr(12)) })
 				{
-					u64 size = f.size();
-					u32 buffer = vm::alloc(size, vm::main);
+					const u64 size = f.size();
+
+					// Only the PAMF header is needed by the reader, the stream data itself is read on demand
+					PamfHeader header{};
+					f.read(header);
+					const u32 header_size = static_cast<u32>(std::min<u64>(std::max<u64>(u64{header.data_offset} << 11, sizeof(PamfHeader)), size));
+
+					u32 buffer = vm::alloc(std::max<u32>(header_size, sizeof(PamfHeader)), vm::main);
 					auto bufPtr = vm::cptr<PamfHeader>::make(buffer);
 					PamfHeader *buf = const_cast<PamfHeader*>(bufPtr.get_ptr());
-					verify(HERE), f.read(buf, size) == size;
+					f.seek(0);
+					verify(HERE), f.read(buf, header_size) == header_size;
 					u32 sp_ = vm::alloc(sizeof(CellPamfReader), vm::main);
 					auto sp = vm::ptr<CellPamfReader>::make(sp_);
 					u32 reader = cellPamfReaderInitialize(sp, bufPtr, size, 0);
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "Emu/System.h"
+#include "Emu/IdManager.h"
 #include "Emu/Cell/PPUModule.h"
 #include "Emu/Cell/Modules/cellSysutil.h"
 
@@ -9,6 +10,9 @@
 #include "Utilities/StrUtil.h"
 
 #include <mutex>
+#include <deque>
+#include <functional>
+#include <unordered_map>
 #include <algorithm>
 
 logs::channel cellSaveData("cellSaveData");
@@ -55,12 +59,88 @@ namespace
 		CellSaveDataFileSet  fileSet;
 		CellSaveDataDoneGet  doneGet;
 	};
+
+	// Performs savedata writes in submission order, off the calling PPU thread
+	class savedata_io_thread final : public named_thread
+	{
+		semaphore<> m_mutex;
+		std::deque<std::function<void()>> m_queue;
+		atomic_t<u32> m_pending{0};
+
+		void on_task() override
+		{
+			while (true)
+			{
+				std::function<void()> job;
+
+				{
+					semaphore_lock lock(m_mutex);
+
+					if (!m_queue.empty())
+					{
+						job = std::move(m_queue.front());
+						m_queue.pop_front();
+					}
+				}
+
+				if (job)
+				{
+					job();
+					m_pending--;
+					continue;
+				}
+
+				// Only exit once everything queued has been written
+				if (!fxm::check<savedata_io_thread>() || Emu.IsStopped())
+				{
+					break;
+				}
+
+				thread_ctrl::wait_for(1000);
+			}
+		}
+
+		std::string get_name() const override { return "Savedata I/O Thread"; }
+
+	public:
+		void push(std::function<void()> job)
+		{
+			{
+				semaphore_lock lock(m_mutex);
+				m_queue.emplace_back(std::move(job));
+				m_pending++;
+			}
+
+			notify();
+		}
+
+		// Wait for all queued operations to complete
+		void flush()
+		{
+			while (m_pending && !Emu.IsStopped())
+			{
+				thread_ctrl::wait_for(100);
+			}
+		}
+	};
+
+	// Parsed savedata directory (PARAM.SFO, icon and size) for list operations
+	struct savedata_cache_entry
+	{
+		s64 dir_mtime;
+		s64 sfo_mtime;
+		u64 sfo_size;
+		SaveDataEntry entry;
+	};
 }
 
 vm::gvar<savedata_context> g_savedata_context;
 
 std::mutex g_savedata_mutex;
 
+// Protected by g_savedata_mutex, entries are reloaded when the directory or its PARAM.SFO timestamps change
+static std::unordered_map<std::string, savedata_cache_entry> g_savedata_cache;
+
 static NEVER_INLINE s32 savedata_op(ppu_thread& ppu, u32 operation, u32 version, vm::cptr<char> dirName,
 	u32 errDialog, PSetList setList, PSetBuf setBuf, PFuncList funcList, PFuncFixed funcFixed, PFuncStat funcStat,
 	PFuncFile funcFile, u32 container, u32 unknown, vm::ptr<void> userdata, u32 userId, PFuncDone funcDone)
@@ -73,6 +153,11 @@ static NEVER_INLINE s32 savedata_op(ppu_thread& ppu, u32 operation, u32 version,
 		return CELL_SAVEDATA_ERROR_BUSY;
 	}
 
+	const auto io = fxm::get_always<savedata_io_thread>();
+
+	// Make all previously queued writes visible
+	io->flush();
+
 	*g_savedata_context = {};
 
 	vm::ptr<CellSaveDataCBResult> result   = g_savedata_context.ptr(&savedata_context::result);
@@ -125,11 +210,30 @@ static NEVER_INLINE s32 savedata_op(ppu_thread& ppu, u32 operation, u32 version,
 					{
 						listGet->dirListNum++; // number of directories in list
 
+						const std::string entry_path = base_dir + entry.name;
+
+						fs::stat_t sfo_info{};
+						if (!fs::stat(entry_path + "/PARAM.SFO", sfo_info))
+						{
+							break;
+						}
+
+						auto found = g_savedata_cache.find(entry_path);
+
+						if (found != g_savedata_cache.end() && found->second.dir_mtime == entry.mtime && found->second.sfo_mtime == sfo_info.mtime && found->second.sfo_size == sfo_info.size)
+						{
+							save_entries.emplace_back(found->second.entry);
+							save_entries.back().atime = entry.atime;
+							save_entries.back().ctime = entry.ctime;
+							break;
+						}
+
 						// PSF parameters
-						const psf::registry psf = psf::load_object(fs::file(base_dir + entry.name + "/PARAM.SFO"));
+						const psf::registry psf = psf::load_object(fs::file(entry_path + "/PARAM.SFO"));
 
 						if (psf.empty())
 						{
+							g_savedata_cache.erase(entry_path);
 							break;
 						}
 
@@ -154,6 +258,7 @@ static NEVER_INLINE s32 savedata_op(ppu_thread& ppu, u32 operation, u32 version,
 							save_entry2.iconBuf = icon.to_vector<uchar>();
 						save_entry2.isNew = false;
 						save_entries.emplace_back(save_entry2);
+						g_savedata_cache[entry_path] = {entry.mtime, sfo_info.mtime, sfo_info.size, std::move(save_entry2)};
 					}
 
 					break;
@@ -319,6 +424,8 @@ static NEVER_INLINE s32 savedata_op(ppu_thread& ppu, u32 operation, u32 version,
 			doneGet->excResult     = CELL_OK;
 			std::memset(doneGet->reserved, 0, sizeof(doneGet->reserved));
 
+			g_savedata_cache.erase(del_path.substr(0, del_path.size() - 1));
+
 			const fs::dir _dir{del_path};
 
 			for (auto&& file : _dir)
@@ -471,6 +578,9 @@ static NEVER_INLINE s32 savedata_op(ppu_thread& ppu, u32 operation, u32 version,
 	std::string dir_path = base_dir + save_entry.dirName + "/";
 	std::string sfo_path = dir_path + "PARAM.SFO";
 
+	// The directory may be modified below, the next list operation must reload it
+	g_savedata_cache.erase(base_dir + save_entry.dirName);
+
 	psf::registry psf = psf::load_object(fs::file(sfo_path));
 
 	// Get save stats
@@ -515,7 +625,7 @@ static NEVER_INLINE s32 savedata_op(ppu_thread& ppu, u32 operation, u32 version,
 			// only files, system files ignored, fileNum is limited by setBuf->fileListMax
 			if (!entry.is_directory)
 			{
-				if (entry.name == "PARAM.SFO" || entry.name == "PARAM.PFD")
+				if (entry.name == "PARAM.SFO" || entry.name == "PARAM.PFD" || entry.name == "PARAM.SFO.tmp")
 				{
 					continue; // system files are not included in the file list
 				}
@@ -749,6 +859,9 @@ static NEVER_INLINE s32 savedata_op(ppu_thread& ppu, u32 operation, u32 version,
 		{
 		case CELL_SAVEDATA_FILEOP_READ:
 		{
+			// Writes queued by this operation must complete first
+			io->flush();
+
 			fs::file file(dir_path + file_path, fs::read);
 			if (!file)
 			{
@@ -781,40 +894,42 @@ static NEVER_INLINE s32 savedata_op(ppu_thread& ppu, u32 operation, u32 version,
 		}
 
 		case CELL_SAVEDATA_FILEOP_WRITE:
+		case CELL_SAVEDATA_FILEOP_WRITE_NOTRUNC:
 		{
-			fs::file file(dir_path + file_path, fs::write + fs::create);
-			if (!file)
-			{
-				fmt::throw_exception("Failed to open file. The file might be read-only: %s%s" HERE, dir_path, file_path);
-			}
-
-			file.seek(fileSet->fileOffset);
+			// The guest buffer is copied, the write itself is done by the I/O thread
 			const auto start = static_cast<uchar*>(fileSet->fileBuf.get_ptr());
 			std::vector<uchar> buf(start, start + std::min<u32>(fileSet->fileSize, fileSet->fileBufSize));
-			fileGet->excSize = ::narrow<u32>(file.write(buf.data(), buf.size()));
-			file.trunc(file.pos()); // truncate
-			break;
-		}
+			fileGet->excSize = ::size32(buf);
+
+			io->push([path = dir_path + file_path, offset = u64{fileSet->fileOffset}, buf = std::move(buf), trunc = op == CELL_SAVEDATA_FILEOP_WRITE]()
+			{
+				fs::file file(path, fs::write + fs::create);
+				if (!file)
+				{
+					cellSaveData.error("Failed to open file. The file might be read-only: %s", path);
+					return;
+				}
+
+				file.seek(offset);
+				file.write(buf.data(), buf.size());
+
+				if (trunc)
+				{
+					file.trunc(file.pos());
+				}
+			});
 
-		case CELL_SAVEDATA_FILEOP_DELETE:
-		{
-			fs::remove_file(dir_path + file_path);
-			fileGet->excSize = 0;
 			break;
 		}
 
-		case CELL_SAVEDATA_FILEOP_WRITE_NOTRUNC:
+		case CELL_SAVEDATA_FILEOP_DELETE:
 		{
-			fs::file file(dir_path + file_path, fs::write + fs::create);
-			if (!file)
+			io->push([path = dir_path + file_path]()
 			{
-				fmt::throw_exception("Failed to open file. The file might be read-only: %s%s" HERE, dir_path, file_path);
-			}
+				fs::remove_file(path);
+			});
 
-			file.seek(fileSet->fileOffset);
-			const auto start = static_cast<uchar*>(fileSet->fileBuf.get_ptr());
-			std::vector<uchar> buf(start, start + std::min<u32>(fileSet->fileSize, fileSet->fileBufSize));
-			fileGet->excSize = ::narrow<u32>(file.write(buf.data(), buf.size()));
+			fileGet->excSize = 0;
 			break;
 		}
 
@@ -829,7 +944,18 @@ static NEVER_INLINE s32 savedata_op(ppu_thread& ppu, u32 operation, u32 version,
 	// Write PARAM.SFO
 	if (psf.size())
 	{
-		psf::save_object(fs::file(sfo_path, fs::rewrite), psf);
+		io->push([sfo_path, psf = std::move(psf)]()
+		{
+			// Commit through a temporary file so that an interrupted write can't leave a broken PARAM.SFO
+			const std::string tmp_path = sfo_path + ".tmp";
+
+			psf::save_object(fs::file(tmp_path, fs::rewrite), psf);
+
+			if (!fs::rename(tmp_path, sfo_path, true))
+			{
+				cellSaveData.error("savedata_op(): failed to commit %s (%s)", sfo_path, fs::g_tls_error);
+			}
+		});
 	}
 
 	return CELL_OK;
@@ -845,6 +971,11 @@ static NEVER_INLINE s32 savedata_get_list_item(vm::cptr<char> dirName, vm::ptr<C
 	std::string save_path = vfs::get(fmt::format("/dev_hdd0/home/%08u/savedata/%s/", userId, dirName.get_ptr()));
 	std::string sfo = save_path + "PARAM.SFO";
 
+	if (const auto io = fxm::get<savedata_io_thread>())
+	{
+		io->flush();
+	}
+
 	if (!fs::is_dir(save_path) && !fs::is_file(sfo))
 	{
 		cellSaveData.error("cellSaveDataGetListItem(): Savedata at %s does not exist", dirName);
@@ -47,6 +47,9 @@ namespace _spurs
 	// Check whether libprof is loaded
 	bool is_libprof_loaded();
 
+	// Wake SPURS kernels waiting for the lock line reservation of the modified field to be lost
+	void notify_kernel(vm::ptr<CellSpurs> spurs, u32 offset);
+
 	// Create an LV2 event queue and attach it to the SPURS instance
 	s32 create_lv2_eq(ppu_thread& ppu, vm::ptr<CellSpurs> spurs, vm::ptr<u32> queueId, vm::ptr<u8> port, s32 size, const sys_event_queue_attribute_t& name);
 
@@ -367,6 +370,12 @@ bool _spurs::is_libprof_loaded()
 	return false;
 }
 
+void _spurs::notify_kernel(vm::ptr<CellSpurs> spurs, u32 offset)
+{
+	// HLE updates are plain host atomics which don't signal the reservation, so idle kernels would only notice them on the next poll
+	vm::reservation_notifier(spurs.addr() + offset, 128).notify_all();
+}
+
 //----------------------------------------------------------------------------
 // SPURS core functions
 //----------------------------------------------------------------------------
@@ -1682,6 +1691,7 @@ s32 cellSpursSetPriorities(vm::ptr<CellSpurs> spurs, u32 wid, vm::cptr<u8> prior
 
 	spurs->sysSrvMsgUpdateWorkload = 0xff;
 	spurs->sysSrvMessage = 0xff;
+	_spurs::notify_kernel(spurs, offset32(&CellSpurs::sysSrvMessage));
 	return CELL_OK;
 }
 
@@ -1829,6 +1839,7 @@ void _spurs::trace_status_update(ppu_thread& ppu, vm::ptr<CellSpurs> spurs)
 	if (init)
 	{
 		spurs->sysSrvMessage = 0xff;
+		_spurs::notify_kernel(spurs, offset32(&CellSpurs::sysSrvMessage));
 		CHECK_SUCCESS(sys_semaphore_wait(ppu, (u32)spurs->semPrv, 0));
 	}
 }
@@ -2262,6 +2273,8 @@ s32 _spurs::add_workload(vm::ptr<CellSpurs> spurs, vm::ptr<u32> wid, vm::cptr<vo
 	spurs->wklState(wnum).exchange(2);
 	spurs->sysSrvMsgUpdateWorkload.exchange(0xff);
 	spurs->sysSrvMessage.exchange(0xff);
+	_spurs::notify_kernel(spurs, wnum < CELL_SPURS_MAX_WORKLOAD ? offset32(&CellSpurs::wklState1) : offset32(&CellSpurs::wklState2));
+	_spurs::notify_kernel(spurs, offset32(&CellSpurs::sysSrvMessage));
 	return CELL_OK;
 }
 
@@ -2391,10 +2404,12 @@ s32 cellSpursSendWorkloadSignal(vm::ptr<CellSpurs> spurs, u32 wid)
 	if (wid >= CELL_SPURS_MAX_WORKLOAD)
 	{
 		spurs->wklSignal2 |= 0x8000 >> (wid & 0x0F);
+		_spurs::notify_kernel(spurs, offset32(&CellSpurs::wklSignal2));
 	}
 	else
 	{
 		spurs->wklSignal1 |= 0x8000 >> wid;
+		_spurs::notify_kernel(spurs, offset32(&CellSpurs::wklSignal1));
 	}
 
 	return CELL_OK;
@@ -2452,10 +2467,12 @@ s32 cellSpursReadyCountStore(vm::ptr<CellSpurs> spurs, u32 wid, u32 value)
 	if (wid < CELL_SPURS_MAX_WORKLOAD)
 	{
 		spurs->wklReadyCount1[wid].exchange((u8)value);
+		_spurs::notify_kernel(spurs, offset32(&CellSpurs::wklReadyCount1));
 	}
 	else
 	{
 		spurs->wklIdleSpuCountOrReadyCount2[wid].exchange((u8)value);
+		_spurs::notify_kernel(spurs, offset32(&CellSpurs::wklIdleSpuCountOrReadyCount2));
 	}
 
 	return CELL_OK;
@@ -2617,6 +2634,7 @@ s32 _cellSpursWorkloadFlagReceiver(vm::ptr<CellSpurs> spurs, u32 wid, u32 is_set
 			}
 		}
 	});
+	_spurs::notify_kernel(spurs, offset32(&CellSpurs::wklFlagReceiver));
 	return CELL_OK;
 }
 
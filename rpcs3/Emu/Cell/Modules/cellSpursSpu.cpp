@@ -2042,7 +2042,7 @@ s32 spursTasksetLoadElf(SPUThread& spu, u32* entryPoint, u32* lowestLoadAddr, u6
 		{
 			if (skipWriteableSegments == false || (prog.p_flags & 2) == 0)
 			{
-				std::memcpy(vm::base(spu.offset + prog.p_vaddr), prog.bin.data(), prog.p_filesz);
+				std::memcpy(vm::base(spu.offset + prog.p_vaddr), prog.data(), prog.p_filesz);
 			}
 		}
 	}
@@ -6,8 +6,40 @@
 #include "Emu/Cell/lv2/sys_process.h"
 #include "cellSync.h"
 
+#include <shared_mutex>
+
 logs::channel cellSync("cellSync");
 
+// Wait until pred() returns true, parking on the reservation notifier of the primitive's line between checks
+template <typename F>
+static void sync_wait(ppu_thread& ppu, u32 addr, F&& pred)
+{
+	if (pred())
+	{
+		return;
+	}
+
+	// Notifications are received while the pseudo-lock is held; if it can't be taken, fall back to spinning
+	std::shared_lock<notifier> pseudo_lock(vm::reservation_notifier(addr, 128), std::try_to_lock);
+
+	while (!pred())
+	{
+		ppu.test_state();
+
+		if (pseudo_lock)
+		{
+			// SPU and PPU reservation stores notify, plain stores are only noticed on timeout
+			pseudo_lock.mutex()->wait(100);
+		}
+	}
+}
+
+// Wake threads waiting in sync_wait() on the primitive
+static void sync_notify(u32 addr)
+{
+	vm::reservation_notifier(addr, 128).notify_all();
+}
+
 template<>
 void fmt_class_string<CellSyncError>::format(std::string& out, u64 arg)
 {
@@ -77,10 +109,10 @@ error_code cellSyncMutexLock(ppu_thread& ppu, vm::ptr<CellSyncMutex> mutex)
 	const auto order = mutex->ctrl.atomic_op(&CellSyncMutex::lock_begin);
 
 	// Wait until rel value is equal to old acq value
-	while (mutex->ctrl.load().rel != order)
+	sync_wait(ppu, mutex.addr(), [&]
 	{
-		ppu.test_state();
-	}
+		return mutex->ctrl.load().rel == order;
+	});
 
 	_mm_mfence();
 
@@ -125,6 +157,8 @@ error_code cellSyncMutexUnlock(vm::ptr<CellSyncMutex> mutex)
 
 	mutex->ctrl.atomic_op(&CellSyncMutex::unlock);
 
+	sync_notify(mutex.addr());
+
 	return CELL_OK;
 }
 
@@ -167,10 +201,12 @@ error_code cellSyncBarrierNotify(ppu_thread& ppu, vm::ptr<CellSyncBarrier> barri
 		return CELL_SYNC_ERROR_ALIGN;
 	}
 
-	while (!barrier->ctrl.atomic_op(&CellSyncBarrier::try_notify))
+	sync_wait(ppu, barrier.addr(), [&]
 	{
-		ppu.test_state();
-	}
+		return barrier->ctrl.atomic_op(&CellSyncBarrier::try_notify);
+	});
+
+	sync_notify(barrier.addr());
 
 	return CELL_OK;
 }
@@ -196,6 +232,8 @@ error_code cellSyncBarrierTryNotify(vm::ptr<CellSyncBarrier> barrier)
 		return not_an_error(CELL_SYNC_ERROR_BUSY);
 	}
 
+	sync_notify(barrier.addr());
+
 	return CELL_OK;
 }
 
@@ -215,10 +253,12 @@ error_code cellSyncBarrierWait(ppu_thread& ppu, vm::ptr<CellSyncBarrier> barrier
 
 	_mm_mfence();
 
-	while (!barrier->ctrl.atomic_op(&CellSyncBarrier::try_wait))
+	sync_wait(ppu, barrier.addr(), [&]
 	{
-		ppu.test_state();
-	}
+		return barrier->ctrl.atomic_op(&CellSyncBarrier::try_wait);
+	});
+
+	sync_notify(barrier.addr());
 
 	return CELL_OK;
 }
@@ -244,6 +284,8 @@ error_code cellSyncBarrierTryWait(vm::ptr<CellSyncBarrier> barrier)
 		return not_an_error(CELL_SYNC_ERROR_BUSY);
 	}
 
+	sync_notify(barrier.addr());
+
 	return CELL_OK;
 }
 
@@ -291,10 +333,10 @@ error_code cellSyncRwmRead(ppu_thread& ppu, vm::ptr<CellSyncRwm> rwm, vm::ptr<vo
 	}
 
 	// wait until `writers` is zero, increase `readers`
-	while (!rwm->ctrl.atomic_op(&CellSyncRwm::try_read_begin))
+	sync_wait(ppu, rwm.addr(), [&]
 	{
-		ppu.test_state();
-	}
+		return rwm->ctrl.atomic_op(&CellSyncRwm::try_read_begin);
+	});
 
 	// copy data to buffer
 	std::memcpy(buffer.get_ptr(), rwm->buffer.get_ptr(), rwm->size);
@@ -305,6 +347,8 @@ error_code cellSyncRwmRead(ppu_thread& ppu, vm::ptr<CellSyncRwm> rwm, vm::ptr<vo
 		return CELL_SYNC_ERROR_ABORT;
 	}
 
+	sync_notify(rwm.addr());
+
 	return CELL_OK;
 }
 
@@ -337,6 +381,8 @@ error_code cellSyncRwmTryRead(vm::ptr<CellSyncRwm> rwm, vm::ptr<void> buffer)
 		return CELL_SYNC_ERROR_ABORT;
 	}
 
+	sync_notify(rwm.addr());
+
 	return CELL_OK;
 }
 
@@ -355,16 +401,16 @@ error_code cellSyncRwmWrite(ppu_thread& ppu, vm::ptr<CellSyncRwm> rwm, vm::cptr<
 	}
 
 	// wait until `writers` is zero, set to 1
-	while (!rwm->ctrl.atomic_op(&CellSyncRwm::try_write_begin))
+	sync_wait(ppu, rwm.addr(), [&]
 	{
-		ppu.test_state();
-	}
+		return rwm->ctrl.atomic_op(&CellSyncRwm::try_write_begin);
+	});
 
 	// wait until `readers` is zero
-	while (rwm->ctrl.load().readers != 0)
+	sync_wait(ppu, rwm.addr(), [&]
 	{
-		ppu.test_state();
-	}
+		return rwm->ctrl.load().readers == 0;
+	});
 
 	// copy data from buffer
 	std::memcpy(rwm->buffer.get_ptr(), buffer.get_ptr(), rwm->size);
@@ -372,6 +418,8 @@ error_code cellSyncRwmWrite(ppu_thread& ppu, vm::ptr<CellSyncRwm> rwm, vm::cptr<
 	// sync and clear `readers` and `writers`
 	rwm->ctrl.exchange({ 0, 0 });
 
+	sync_notify(rwm.addr());
+
 	return CELL_OK;
 }
 
@@ -401,6 +449,8 @@ error_code cellSyncRwmTryWrite(vm::ptr<CellSyncRwm> rwm, vm::cptr<void> buffer)
 	// sync and clear `readers` and `writers`
 	rwm->ctrl.exchange({ 0, 0 });
 
+	sync_notify(rwm.addr());
+
 	return CELL_OK;
 }
 
@@ -457,16 +507,18 @@ error_code cellSyncQueuePush(ppu_thread& ppu, vm::ptr<CellSyncQueue> queue, vm::
 
 	u32 position;
 
-	while (!queue->ctrl.atomic_op(&CellSyncQueue::try_push_begin, depth, &position))
+	sync_wait(ppu, queue.addr(), [&]
 	{
-		ppu.test_state();
-	}
+		return queue->ctrl.atomic_op(&CellSyncQueue::try_push_begin, depth, &position);
+	});
 
 	// copy data from the buffer at the position
 	std::memcpy(&queue->buffer[position * queue->size], buffer.get_ptr(), queue->size);
 
 	queue->ctrl.atomic_op(&CellSyncQueue::push_end);
 
+	sync_notify(queue.addr());
+
 	return CELL_OK;
 }
 
@@ -498,6 +550,8 @@ error_code cellSyncQueueTryPush(vm::ptr<CellSyncQueue> queue, vm::cptr<void> buf
 
 	queue->ctrl.atomic_op(&CellSyncQueue::push_end);
 
+	sync_notify(queue.addr());
+
 	return CELL_OK;
 }
 
@@ -519,16 +573,18 @@ error_code cellSyncQueuePop(ppu_thread& ppu, vm::ptr<CellSyncQueue> queue, vm::p
 	
 	u32 position;
 
-	while (!queue->ctrl.atomic_op(&CellSyncQueue::try_pop_begin, depth, &position))
+	sync_wait(ppu, queue.addr(), [&]
 	{
-		ppu.test_state();
-	}
+		return queue->ctrl.atomic_op(&CellSyncQueue::try_pop_begin, depth, &position);
+	});
 
 	// copy data at the position to the buffer
 	std::memcpy(buffer.get_ptr(), &queue->buffer[position % depth * queue->size], queue->size);
 
 	queue->ctrl.atomic_op(&CellSyncQueue::pop_end);
 
+	sync_notify(queue.addr());
+
 	return CELL_OK;
 }
 
@@ -560,6 +616,8 @@ error_code cellSyncQueueTryPop(vm::ptr<CellSyncQueue> queue, vm::ptr<void> buffe
 
 	queue->ctrl.atomic_op(&CellSyncQueue::pop_end);
 
+	sync_notify(queue.addr());
+
 	return CELL_OK;
 }
 
@@ -581,16 +639,18 @@ error_code cellSyncQueuePeek(ppu_thread& ppu, vm::ptr<CellSyncQueue> queue, vm::
 
 	u32 position;
 
-	while (!queue->ctrl.atomic_op(&CellSyncQueue::try_peek_begin, depth, &position))
+	sync_wait(ppu, queue.addr(), [&]
 	{
-		ppu.test_state();
-	}
+		return queue->ctrl.atomic_op(&CellSyncQueue::try_peek_begin, depth, &position);
+	});
 
 	// copy data at the position to the buffer
 	std::memcpy(buffer.get_ptr(), &queue->buffer[position % depth * queue->size], queue->size);
 
 	queue->ctrl.atomic_op(&CellSyncQueue::pop_end);
 
+	sync_notify(queue.addr());
+
 	return CELL_OK;
 }
 
@@ -622,6 +682,8 @@ error_code cellSyncQueueTryPeek(vm::ptr<CellSyncQueue> queue, vm::ptr<void> buff
 
 	queue->ctrl.atomic_op(&CellSyncQueue::pop_end);
 
+	sync_notify(queue.addr());
+
 	return CELL_OK;
 }
 
@@ -660,18 +722,20 @@ error_code cellSyncQueueClear(ppu_thread& ppu, vm::ptr<CellSyncQueue> queue)
 
 	const u32 depth = queue->check_depth();
 
-	while (!queue->ctrl.atomic_op(&CellSyncQueue::try_clear_begin_1))
+	sync_wait(ppu, queue.addr(), [&]
 	{
-		ppu.test_state();
-	}
+		return queue->ctrl.atomic_op(&CellSyncQueue::try_clear_begin_1);
+	});
 
-	while (!queue->ctrl.atomic_op(&CellSyncQueue::try_clear_begin_2))
+	sync_wait(ppu, queue.addr(), [&]
 	{
-		ppu.test_state();
-	}
+		return queue->ctrl.atomic_op(&CellSyncQueue::try_clear_begin_2);
+	});
 
 	queue->ctrl.exchange({ 0, 0 });
 
+	sync_notify(queue.addr());
+
 	return CELL_OK;
 }
 
@@ -1082,10 +1146,10 @@ error_code _cellSyncLFQueuePushBody(ppu_thread& ppu, vm::ptr<CellSyncLFQueue> qu
 
 	vm::var<s32> position;
 
-	while (true)
-	{
-		s32 res;
+	s32 res;
 
+	sync_wait(ppu, queue.addr(), [&]
+	{
 		if (queue->m_direction != CELL_SYNC_QUEUE_ANY2ANY)
 		{
 			res = _cellSyncLFQueueGetPushPointer(ppu, queue, position, isBlocking, 0);
@@ -1095,14 +1159,12 @@ error_code _cellSyncLFQueuePushBody(ppu_thread& ppu, vm::ptr<CellSyncLFQueue> qu
 			res = _cellSyncLFQueueGetPushPointer2(ppu, queue, position, isBlocking, 0);
 		}
 
-		if (!isBlocking || res != CELL_SYNC_ERROR_AGAIN)
-		{
-			if (res) return not_an_error(res);
-
-			break;
-		}
+		return !isBlocking || res != CELL_SYNC_ERROR_AGAIN;
+	});
 
-		ppu.test_state();
+	if (res)
+	{
+		return not_an_error(res);
 	}
 
 	const s32 depth = queue->m_depth;
@@ -1111,14 +1173,20 @@ error_code _cellSyncLFQueuePushBody(ppu_thread& ppu, vm::ptr<CellSyncLFQueue> qu
 	const u32 addr = vm::cast((u64)((queue->m_buffer.addr() & ~1ull) + size * (pos >= depth ? pos - depth : pos)), HERE);
 	std::memcpy(vm::base(addr), buffer.get_ptr(), size);
 
+	error_code result;
+
 	if (queue->m_direction != CELL_SYNC_QUEUE_ANY2ANY)
 	{
-		return _cellSyncLFQueueCompletePushPointer(ppu, queue, pos, vm::null);
+		result = _cellSyncLFQueueCompletePushPointer(ppu, queue, pos, vm::null);
 	}
 	else
 	{
-		return _cellSyncLFQueueCompletePushPointer2(ppu, queue, pos, vm::null);
+		result = _cellSyncLFQueueCompletePushPointer2(ppu, queue, pos, vm::null);
 	}
+
+	sync_notify(queue.addr());
+
+	return result;
 }
 
 error_code _cellSyncLFQueueGetPopPointer(ppu_thread& ppu, vm::ptr<CellSyncLFQueue> queue, vm::ptr<s32> pointer, u32 isBlocking, u32 arg4, u32 useEventQueue)
@@ -1377,10 +1445,10 @@ error_code _cellSyncLFQueuePopBody(ppu_thread& ppu, vm::ptr<CellSyncLFQueue> que
 
 	vm::var<s32> position;
 
-	while (true)
-	{
-		s32 res;
+	s32 res;
 
+	sync_wait(ppu, queue.addr(), [&]
+	{
 		if (queue->m_direction != CELL_SYNC_QUEUE_ANY2ANY)
 		{
 			res = _cellSyncLFQueueGetPopPointer(ppu, queue, position, isBlocking, 0, 0);
@@ -1390,14 +1458,12 @@ error_code _cellSyncLFQueuePopBody(ppu_thread& ppu, vm::ptr<CellSyncLFQueue> que
 			res = _cellSyncLFQueueGetPopPointer2(ppu, queue, position, isBlocking, 0);
 		}
 
-		if (!isBlocking || res != CELL_SYNC_ERROR_AGAIN)
-		{
-			if (res) return not_an_error(res);
-
-			break;
-		}
+		return !isBlocking || res != CELL_SYNC_ERROR_AGAIN;
+	});
 
-		ppu.test_state();
+	if (res)
+	{
+		return not_an_error(res);
 	}
 
 	const s32 depth = queue->m_depth;
@@ -1406,14 +1472,20 @@ error_code _cellSyncLFQueuePopBody(ppu_thread& ppu, vm::ptr<CellSyncLFQueue> que
 	const u32 addr = vm::cast((u64)((queue->m_buffer.addr() & ~1) + size * (pos >= depth ? pos - depth : pos)), HERE);
 	std::memcpy(buffer.get_ptr(), vm::base(addr), size);
 
+	error_code result;
+
 	if (queue->m_direction != CELL_SYNC_QUEUE_ANY2ANY)
 	{
-		return _cellSyncLFQueueCompletePopPointer(ppu, queue, pos, vm::null, 0);
+		result = _cellSyncLFQueueCompletePopPointer(ppu, queue, pos, vm::null, 0);
 	}
 	else
 	{
-		return _cellSyncLFQueueCompletePopPointer2(ppu, queue, pos, vm::null, 0);
+		result = _cellSyncLFQueueCompletePopPointer2(ppu, queue, pos, vm::null, 0);
 	}
+
+	sync_notify(queue.addr());
+
+	return result;
 }
 
 error_code cellSyncLFQueueClear(vm::ptr<CellSyncLFQueue> queue)
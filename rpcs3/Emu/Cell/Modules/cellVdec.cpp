@@ -18,6 +18,7 @@ extern "C"
 
 #include <mutex>
 #include <queue>
+#include <thread>
 #include <cmath>
 
 std::mutex g_mutex_avcodec_open2;
@@ -66,6 +67,11 @@ struct vdec_thread : ppu_thread
 	AVCodecContext* ctx{};
 	SwsContext* sws{};
 
+	// Constant alpha plane for RGB output, rebuilt only when the size or the value changes
+	std::unique_ptr<u8[]> alpha_plane;
+	u32 alpha_size{};
+	u8 alpha_value{};
+
 	const s32 type;
 	const u32 profile;
 	const u32 mem_addr;
@@ -131,6 +137,10 @@ struct vdec_thread : ppu_thread
 			fmt::throw_exception("avcodec_alloc_context3() failed (type=0x%x)" HERE, type);
 		}
 
+		// Slice threading only: frame threading delays pictures, which end_seq doesn't drain
+		ctx->thread_type = FF_THREAD_SLICE;
+		ctx->thread_count = std::min<u32>(std::thread::hardware_concurrency(), 8);
+
 		AVDictionary* opts{};
 		av_dict_set(&opts, "refcounted_frames", "1", 0);
 
@@ -241,8 +251,12 @@ struct vdec_thread : ppu_thread
 
 					int got_picture = 0;
 
+					const u64 decode_start = get_system_time();
+
 					int decode = avcodec_decode_video2(ctx, frame.avf.get(), &got_picture, &packet);
 
+					const u64 decode_time = get_system_time() - decode_start;
+
 					if (decode < 0)
 					{
 						char av_error[AV_ERROR_MAX_STRING_SIZE];
@@ -347,7 +361,7 @@ struct vdec_thread : ppu_thread
 								fmt::throw_exception("Unsupported time_base.num (%d/%d, tpf=%d)" HERE, ctx->time_base.den, ctx->time_base.num, ctx->ticks_per_frame);
 						}
 
-						cellVdec.trace("Got picture (pts=0x%llx[0x%llx], dts=0x%llx[0x%llx])", frame.pts, frame->pkt_pts, frame.dts, frame->pkt_dts);
+						cellVdec.trace("Got picture (pts=0x%llx[0x%llx], dts=0x%llx[0x%llx], time=%llu us)", frame.pts, frame->pkt_pts, frame.dts, frame->pkt_dts, decode_time);
 
 						std::lock_guard<std::mutex>{mutex}, out.push(std::move(frame));
 
@@ -604,12 +618,12 @@ s32 cellVdecGetPicture(u32 handle, vm::cptr<CellVdecPicFormat> format, vm::ptr<u
 
 		AVPixelFormat out_f = AV_PIX_FMT_YUV420P;
 
-		std::unique_ptr<u8[]> alpha_plane;
+		bool use_alpha = false;
 
 		switch (const u32 type = format->formatType)
 		{
-		case CELL_VDEC_PICFMT_ARGB32_ILV: out_f = AV_PIX_FMT_ARGB; alpha_plane.reset(new u8[w * h]); break;
-		case CELL_VDEC_PICFMT_RGBA32_ILV: out_f = AV_PIX_FMT_RGBA; alpha_plane.reset(new u8[w * h]); break;
+		case CELL_VDEC_PICFMT_ARGB32_ILV: out_f = AV_PIX_FMT_ARGB; use_alpha = true; break;
+		case CELL_VDEC_PICFMT_RGBA32_ILV: out_f = AV_PIX_FMT_RGBA; use_alpha = true; break;
 		case CELL_VDEC_PICFMT_UYVY422_ILV: out_f = AV_PIX_FMT_UYVY422; break;
 		case CELL_VDEC_PICFMT_YUV420_PLANAR: out_f = AV_PIX_FMT_YUV420P; break;
 
@@ -625,11 +639,20 @@ s32 cellVdecGetPicture(u32 handle, vm::cptr<CellVdecPicFormat> format, vm::ptr<u
 			fmt::throw_exception("Unknown colorMatrixType (%d)" HERE, format->colorMatrixType);
 		}
 
-		if (alpha_plane)
+		if (use_alpha && (vdec->alpha_size != w * h || vdec->alpha_value != format->alpha))
 		{
-			std::memset(alpha_plane.get(), format->alpha, w * h);
+			if (vdec->alpha_size != w * h)
+			{
+				vdec->alpha_plane.reset(new u8[w * h]);
+				vdec->alpha_size = w * h;
+			}
+
+			vdec->alpha_value = format->alpha;
+			std::memset(vdec->alpha_plane.get(), vdec->alpha_value, w * h);
 		}
 
+		u8* const alpha_plane = use_alpha ? vdec->alpha_plane.get() : nullptr;
+
 		AVPixelFormat in_f = AV_PIX_FMT_YUV420P;
 
 		switch (frame->format)
@@ -642,9 +665,30 @@ s32 cellVdecGetPicture(u32 handle, vm::cptr<CellVdecPicFormat> format, vm::ptr<u
 		}
 		}
 
+		if (in_f == out_f)
+		{
+			// Same layout: copy the planes directly, without a conversion pass
+			u8* out = outBuff.get_ptr();
+
+			for (int p = 0; p < 3; p++)
+			{
+				const int pw = p ? w / 2 : w;
+				const int ph = p ? h / 2 : h;
+
+				for (int y = 0; y < ph; y++)
+				{
+					std::memcpy(out + y * pw, frame->data[p] + y * frame->linesize[p], pw);
+				}
+
+				out += pw * ph;
+			}
+
+			return CELL_OK;
+		}
+
 		vdec->sws = sws_getCachedContext(vdec->sws, w, h, in_f, w, h, out_f, SWS_POINT, NULL, NULL, NULL);
 
-		u8* in_data[4] = { frame->data[0], frame->data[1], frame->data[2], alpha_plane.get() };
+		u8* in_data[4] = { frame->data[0], frame->data[1], frame->data[2], alpha_plane };
 		int in_line[4] = { frame->linesize[0], frame->linesize[1], frame->linesize[2], w * 1 };
 		u8* out_data[4] = { outBuff.get_ptr() };
 		int out_line[4] = { w * 4 };
@@ -13,6 +13,10 @@
 #include "sceNpTrophy.h"
 
 #include "Utilities/StrUtil.h"
+#include "Utilities/Thread.h"
+
+#include <unordered_map>
+#include <condition_variable>
 
 logs::channel sceNpTrophy("sceNpTrophy");
 
@@ -20,6 +24,14 @@ TrophyNotificationBase::~TrophyNotificationBase()
 {
 }
 
+// Completion state of the background installation of the trophy icons
+struct trophy_install_t
+{
+	std::mutex mutex;
+	std::condition_variable cv;
+	bool done = false;
+};
+
 struct trophy_context_t
 {
 	static const u32 id_base = 1;
@@ -29,6 +41,52 @@ struct trophy_context_t
 	std::string trp_name;
 	fs::file trp_stream;
 	std::unique_ptr<TROPUSRLoader> tropusr;
+
+	std::mutex mutex;
+	std::shared_ptr<trophy_install_t> install;
+
+	// Icons read from the installed trophy directory (name -> PNG data, entries are never removed)
+	std::unordered_map<std::string, std::vector<uchar>> icons;
+
+	// Wait for the background installation (the TRP stream is in use until it's done)
+	void wait_install()
+	{
+		std::shared_ptr<trophy_install_t> task;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			task = install;
+		}
+
+		if (task)
+		{
+			std::unique_lock<std::mutex> lock(task->mutex);
+			task->cv.wait(lock, [&] { return task->done; });
+		}
+	}
+
+	// Get the PNG data of an icon, it's only read from the disk once
+	const std::vector<uchar>* get_icon(const std::string& name)
+	{
+		wait_install();
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		const auto found = icons.find(name);
+
+		if (found != icons.end())
+		{
+			return &found->second;
+		}
+
+		const fs::file icon_file(vfs::get("/dev_hdd0/home/00000001/trophy/" + trp_name + '/' + name));
+
+		if (!icon_file)
+		{
+			return nullptr;
+		}
+
+		return &(icons[name] = icon_file.to_vector<uchar>());
+	}
 };
 
 struct trophy_handle_t
@@ -258,6 +316,9 @@ error_code sceNpTrophyRegisterContext(ppu_thread& ppu, u32 context, u32 handle,
 		return SCE_NP_TROPHY_ERROR_UNKNOWN_HANDLE;
 	}
 
+	// The stream may still be used by the previous registration
+	ctxt->wait_install();
+
 	TRPLoader trp(ctxt->trp_stream);
 	if (!trp.LoadHeader())
 	{
@@ -296,13 +357,38 @@ error_code sceNpTrophyRegisterContext(ppu_thread& ppu, u32 context, u32 handle,
 		}
 	}
 
+	const auto is_icon = [](const TRPEntry& entry)
+	{
+		const std::size_t len = strnlen(entry.name, sizeof(entry.name));
+		return len >= 4 && !memcmp(entry.name + len - 4, ".PNG", 4);
+	};
+
 	// TODO: Get the path of the current user
 	std::string trophyPath = "/dev_hdd0/home/00000001/trophy/" + ctxt->trp_name;
-	if (!trp.Install(trophyPath))
+	if (!trp.Install(trophyPath, false, [&](const TRPEntry& entry) { return !is_icon(entry); }))
 	{
 		return SCE_NP_TROPHY_ERROR_ILLEGAL_UPDATE;
 	}
 
+	// Install the icons in the background, only their users wait for them
+	const auto task = std::make_shared<trophy_install_t>();
+	{
+		std::lock_guard<std::mutex> lock(ctxt->mutex);
+		ctxt->install = task;
+	}
+
+	thread_pool::push([ctxt, task, trp, trophyPath, is_icon]()
+	{
+		if (!trp.Install(trophyPath, false, is_icon))
+		{
+			sceNpTrophy.error("Failed to install the trophy icons of %s", ctxt->trp_name);
+		}
+
+		std::lock_guard<std::mutex> lock(task->mutex);
+		task->done = true;
+		task->cv.notify_all();
+	});
+
 	TROPUSRLoader* tropusr = new TROPUSRLoader();
 	std::string trophyUsrPath = trophyPath + "/TROPUSR.DAT";
 	std::string trophyConfPath = trophyPath + "/TROPCONF.SFM";
@@ -348,6 +434,8 @@ error_code sceNpTrophyGetRequiredDiskSpace(u32 context, u32 handle, vm::ptr<u64>
 
 	if (!fs::is_dir(vfs::get("/dev_hdd0/home/00000001/trophy/" + ctxt->trp_name)))
 	{
+		ctxt->wait_install();
+
 		TRPLoader trp(ctxt->trp_stream);
 
 		if (trp.LoadHeader())
@@ -515,23 +603,9 @@ error_code sceNpTrophyUnlockTrophy(u32 context, u32 handle, s32 trophyId, vm::pt
 
 	if (g_cfg.misc.show_trophy_popups)
 	{
-		// Figure out how many zeros are needed for padding.  (either 0, 1, or 2)
-		std::string padding = "";
-		if (trophyId < 10)
-		{
-			padding = "00";
-		}
-		else if (trophyId < 100)
-		{
-			padding = "0";
-		}
-
 		// Get icon for the notification.
-		std::string trophyIconPath = "/dev_hdd0/home/00000001/trophy/" + ctxt->trp_name + "/TROP" + padding + std::to_string(trophyId) + ".PNG";
-		fs::file trophyIconFile = fs::file(vfs::get(trophyIconPath));
-		size_t iconSize = trophyIconFile.size();
-		std::vector<uchar> trophyIconData;
-		trophyIconFile.read(trophyIconData, iconSize);
+		const auto trophyIcon = ctxt->get_icon(fmt::format("TROP%03d.PNG", trophyId));
+		const std::vector<uchar> trophyIconData = trophyIcon ? *trophyIcon : std::vector<uchar>{};
 
 		vm::ptr<SceNpTrophyDetails> details = vm::make_var(SceNpTrophyDetails());
 		vm::ptr<SceNpTrophyData> _ = vm::make_var(SceNpTrophyData());
@@ -756,18 +830,18 @@ error_code sceNpTrophyGetGameIcon(u32 context, u32 handle, vm::ptr<void> buffer,
 		return SCE_NP_TROPHY_ERROR_UNKNOWN_HANDLE;
 	}
 
-	fs::file icon_file(vfs::get("/dev_hdd0/home/00000001/trophy/" + ctxt->trp_name + "/ICON0.PNG"));
+	const auto icon = ctxt->get_icon("ICON0.PNG");
 
-	if (!icon_file)
+	if (!icon)
 	{
 		return SCE_NP_TROPHY_ERROR_UNKNOWN_FILE;
 	}
 
-	const u32 icon_size = ::size32(icon_file);
+	const u32 icon_size = ::size32(*icon);
 
 	if (buffer && *size >= icon_size)
 	{
-		icon_file.read(buffer.get_ptr(), icon_size);
+		std::memcpy(buffer.get_ptr(), icon->data(), icon_size);
 	}
 
 	*size = icon_size;
@@ -809,18 +883,18 @@ error_code sceNpTrophyGetTrophyIcon(u32 context, u32 handle, s32 trophyId, vm::p
 		return hidden ? SCE_NP_TROPHY_ERROR_HIDDEN : SCE_NP_TROPHY_ERROR_LOCKED;
 	}
 
-	fs::file icon_file(vfs::get("/dev_hdd0/home/00000001/trophy/" + ctxt->trp_name + fmt::format("/TROP%03d.PNG", trophyId)));
+	const auto icon = ctxt->get_icon(fmt::format("TROP%03d.PNG", trophyId));
 
-	if (!icon_file)
+	if (!icon)
 	{
 		return SCE_NP_TROPHY_ERROR_UNKNOWN_FILE;
 	}
 
-	const u32 icon_size = ::size32(icon_file);
+	const u32 icon_size = ::size32(*icon);
 
 	if (buffer && *size >= icon_size)
 	{
-		icon_file.read(buffer.get_ptr(), icon_size);
+		std::memcpy(buffer.get_ptr(), icon->data(), icon_size);
 	}
 
 	*size = icon_size;
@@ -141,7 +141,11 @@ error_code sys_lwmutex_lock(ppu_thread& ppu, vm::ptr<sys_lwmutex_t> lwmutex, u64
 		return CELL_EINVAL;
 	}
 
-	for (u32 i = 0; i < 10; i++)
+	// Spin adaptively before sleeping, the limit follows the recent history of this mutex
+	const auto sleep_queue = idm::get<lv2_obj, lv2_lwmutex>(lwmutex->sleep_queue);
+	const u32 spin_limit = sleep_queue ? sleep_queue->get_spin_limit() : 10;
+
+	for (u32 i = 0; i < spin_limit; i++)
 	{
 		busy_wait();
 
@@ -150,11 +154,21 @@ error_code sys_lwmutex_lock(ppu_thread& ppu, vm::ptr<sys_lwmutex_t> lwmutex, u64
 			if (lwmutex->vars.owner.compare_and_swap_test(lwmutex_free, tid))
 			{
 				// locking succeeded
+				if (sleep_queue)
+				{
+					sleep_queue->update_spin(i + 1, true);
+				}
+
 				return CELL_OK;
 			}
 		}
 	}
 
+	if (sleep_queue)
+	{
+		sleep_queue->update_spin(spin_limit, false);
+	}
+
 	// atomically increment waiter value using 64 bit op
 	lwmutex->all_info++;
 
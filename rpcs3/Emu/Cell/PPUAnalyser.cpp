@@ -2,6 +2,7 @@
 #include "PPUOpcodes.h"
 #include "PPUModule.h"
 #include "PPUAnalyser.h"
+#include "Crypto/sha1.h"
 
 #include <unordered_set>
 
@@ -11,6 +12,9 @@
 
 const ppu_decoder<ppu_itype> s_ppu_itype;
 
+// Increment when analyse() results change, invalidates analyser cache
+constexpr u32 s_ppu_analyser_version = 1;
+
 template<>
 void fmt_class_string<ppu_attr>::format(std::string& out, u64 arg)
 {
@@ -1434,6 +1438,137 @@ void ppu_module::analyse(u32 lib_toc, u32 entry)
 	LOG_NOTICE(PPU, "Function analysis: %zu functions (%zu enqueued)", funcs.size(), func_queue.size());
 }
 
+void ppu_module::analyse_cached(u32 lib_toc, u32 entry)
+{
+	// Hash analyser version, arguments and memory contents (patches and relocations are already applied)
+	sha1_context ctx;
+	u8 output[20];
+	sha1_starts(&ctx);
+
+	const u32 args[3]{s_ppu_analyser_version, lib_toc, entry};
+	sha1_update(&ctx, reinterpret_cast<const u8*>(args), sizeof(args));
+
+	for (const auto& seg : segs)
+	{
+		sha1_update(&ctx, reinterpret_cast<const u8*>(&seg), sizeof(seg));
+
+		if (seg.size)
+		{
+			sha1_update(&ctx, vm::_ptr<const u8>(seg.addr), seg.size);
+		}
+	}
+
+	for (const auto& sec : secs)
+	{
+		sha1_update(&ctx, reinterpret_cast<const u8*>(&sec), sizeof(sec));
+	}
+
+	sha1_finish(&ctx, output);
+
+	const std::string dir = fs::get_config_dir() + "data/ppu_analysis/";
+	const std::string path = dir + fmt::format("%s.dat", fmt::base57(output));
+
+	if (const fs::file cache{path})
+	{
+		// Format: function count, then for each function: addr, toc, size, attr, stack_frame, trampoline,
+		// block count and (addr, size) pairs, callee count and addresses, caller count and addresses
+		const std::vector<u32> data = cache.to_vector<u32>();
+
+		std::size_t pos = 0;
+		bool ok = true;
+
+		auto next = [&]() -> u32
+		{
+			if (pos >= data.size())
+			{
+				ok = false;
+				return 0;
+			}
+
+			return data[pos++];
+		};
+
+		// Each function takes at least 9 words
+		const u32 count = next();
+		std::vector<ppu_function> result(count <= data.size() / 9 ? count : 0);
+		ok = ok && result.size() == count;
+
+		for (auto& func : result)
+		{
+			func.addr = next();
+			func.toc = next();
+			func.size = next();
+			func.attr = static_cast<bs_t<ppu_attr>>(next());
+			func.stack_frame = next();
+			func.trampoline = next();
+			func.name = fmt::format("__0x%x", func.addr);
+
+			for (u32 i = 0, count = next(); ok && i < count; i++)
+			{
+				const u32 addr = next();
+				func.blocks.emplace(addr, next());
+			}
+
+			for (u32 i = 0, count = next(); ok && i < count; i++)
+			{
+				func.calls.emplace(next());
+			}
+
+			for (u32 i = 0, count = next(); ok && i < count; i++)
+			{
+				func.callers.emplace(next());
+			}
+
+			if (!ok)
+			{
+				break;
+			}
+		}
+
+		if (ok && pos == data.size())
+		{
+			funcs = std::move(result);
+			LOG_NOTICE(PPU, "Function analysis: %zu functions (cached)", funcs.size());
+			return;
+		}
+
+		LOG_ERROR(PPU, "Invalid analyser cache: %s", path);
+	}
+
+	analyse(lib_toc, entry);
+
+	std::vector<u32> data;
+	data.push_back(::size32(funcs));
+
+	for (const auto& func : funcs)
+	{
+		data.insert(data.end(), {func.addr, func.toc, func.size, static_cast<u32>(func.attr), func.stack_frame, func.trampoline});
+
+		data.push_back(::size32(func.blocks));
+
+		for (const auto& block : func.blocks)
+		{
+			data.push_back(block.first);
+			data.push_back(block.second);
+		}
+
+		data.push_back(::size32(func.calls));
+		data.insert(data.end(), func.calls.begin(), func.calls.end());
+		data.push_back(::size32(func.callers));
+		data.insert(data.end(), func.callers.begin(), func.callers.end());
+	}
+
+	fs::file out;
+
+	if (!fs::create_path(dir) || !out.open(path, fs::rewrite))
+	{
+		LOG_ERROR(PPU, "Failed to write analyser cache: %s (%s)", path, fs::g_tls_error);
+		return;
+	}
+
+	out.write(data);
+}
+
 void ppu_acontext::UNK(ppu_opcode_t op)
 {
 	std::fill_n(gpr, 32, spec_gpr{});
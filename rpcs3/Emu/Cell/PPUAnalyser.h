@@ -89,6 +89,7 @@ struct ppu_module
 	}
 
 	void analyse(u32 lib_toc, u32 entry);
+	void analyse_cached(u32 lib_toc, u32 entry);
 	void validate(u32 reloc);
 };
 
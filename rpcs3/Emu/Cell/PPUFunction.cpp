@@ -2477,11 +2477,29 @@ std::vector<ppu_function_t>& ppu_function_manager::access()
 	return list;
 }
 
-u32 ppu_function_manager::add_function(ppu_function_t function)
+std::vector<ppu_function_t>& ppu_function_manager::access_profiled()
 {
+	// Built-in entries are not profiled
+	static std::vector<ppu_function_t> list = access();
+
+	return list;
+}
+
+std::deque<ppu_function_manager::stats_t>& ppu_function_manager::access_stats()
+{
+	static std::deque<stats_t> list(2);
+
+	return list;
+}
+
+u32 ppu_function_manager::add_function(ppu_function_t function, ppu_function_t profiled)
+{
+	auto& profiled_list = access_profiled();
 	auto& list = access();
 
 	list.push_back(function);
+	profiled_list.push_back(profiled);
+	access_stats().emplace_back();
 
 	return ::size32(list) - 1;
 }
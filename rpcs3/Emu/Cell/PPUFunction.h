@@ -2,6 +2,9 @@
 
 #include "PPUThread.h"
 
+#include <chrono>
+#include <deque>
+
 using ppu_function_t = bool(*)(ppu_thread&);
 
 // BIND_FUNC macro "converts" any appropriate HLE function to ppu_function_t, binding it to PPU thread context.
@@ -249,19 +252,50 @@ class ppu_function_manager
 	struct registered
 	{
 		static u32 index;
+		static ppu_function_t func;
+	};
+
+public:
+	// Call statistics for a registered function
+	struct stats_t
+	{
+		atomic_t<u64> calls{0};
+		atomic_t<u64> time{0}; // Host time in nanoseconds
 	};
 
+private:
 	// Access global function list
 	static std::vector<ppu_function_t>& access();
 
-	static u32 add_function(ppu_function_t function);
+	// Access the list of profiled entry points (indexed like the function list)
+	static std::vector<ppu_function_t>& access_profiled();
+
+	// Access call statistics (indexed like the function list)
+	static std::deque<stats_t>& access_stats();
+
+	static u32 add_function(ppu_function_t function, ppu_function_t profiled);
+
+	// Entry point which also counts calls and host time spent in the function
+	template<typename T, T Func>
+	static bool profiled_call(ppu_thread& ppu)
+	{
+		auto& stats = access_stats()[registered<T, Func>::index];
+
+		const auto start = std::chrono::steady_clock::now();
+		const bool result = registered<T, Func>::func(ppu);
+
+		stats.time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		stats.calls++;
+		return result;
+	}
 
 public:
 	// Register function (shall only be called during global initialization)
 	template<typename T, T Func>
 	static inline u32 register_function(ppu_function_t func)
 	{
-		return registered<T, Func>::index = add_function(func);
+		registered<T, Func>::func = func;
+		return registered<T, Func>::index = add_function(func, &profiled_call<T, Func>);
 	}
 
 	// Get function index
@@ -277,6 +311,18 @@ public:
 		return access();
 	}
 
+	// Read all profiled entry points
+	static inline const auto& get_profiled()
+	{
+		return access_profiled();
+	}
+
+	// Read call statistics (only collected through the profiled entry points)
+	static inline const auto& get_stats()
+	{
+		return access_stats();
+	}
+
 	// Allocation address
 	static u32 addr;
 };
@@ -284,4 +330,7 @@ public:
 template<typename T, T Func>
 u32 ppu_function_manager::registered<T, Func>::index = 0;
 
+template<typename T, T Func>
+ppu_function_t ppu_function_manager::registered<T, Func>::func = nullptr;
+
 #define FIND_FUNC(func) ppu_function_manager::get_index<decltype(&func), &func>()
@@ -2,6 +2,7 @@
 #include "Emu/System.h"
 #include "PPUThread.h"
 #include "PPUInterpreter.h"
+#include "RawSPUThread.h"
 
 #include <cmath>
 
@@ -32,6 +33,28 @@ inline void ppu_cr_set(ppu_thread& ppu, u32 field, const T& a, const T& b)
 	ppu_cr_set(ppu, field, a < b, a > b, a == b, ppu.xer.so);
 }
 
+// Word load, RawSPU problem state registers are read directly instead of faulting into the access violation handler
+inline u32 ppu_read32(u32 addr)
+{
+	if (UNLIKELY(RawSPUThread::is_mmio(addr)))
+	{
+		return RawSPUThread::mmio_read32(addr);
+	}
+
+	return vm::read32(addr);
+}
+
+// Word store, see ppu_read32
+inline void ppu_write32(u32 addr, u32 value)
+{
+	if (UNLIKELY(RawSPUThread::is_mmio(addr)))
+	{
+		return RawSPUThread::mmio_write32(addr, value);
+	}
+
+	vm::write32(addr, value);
+}
+
 // Set XER.OV bit (overflow)
 inline void ppu_ov_set(ppu_thread& ppu, bool bit)
 {
@@ -3261,7 +3284,7 @@ bool ppu_interpreter::LDX(ppu_thread& ppu, ppu_opcode_t op)
 bool ppu_interpreter::LWZX(ppu_thread& ppu, ppu_opcode_t op)
 {
 	const u64 addr = op.ra ? ppu.gpr[op.ra] + ppu.gpr[op.rb] : ppu.gpr[op.rb];
-	ppu.gpr[op.rd] = vm::read32(vm::cast(addr, HERE));
+	ppu.gpr[op.rd] = ppu_read32(vm::cast(addr, HERE));
 	return true;
 }
 
@@ -3347,7 +3370,7 @@ bool ppu_interpreter::DCBST(ppu_thread& ppu, ppu_opcode_t op)
 bool ppu_interpreter::LWZUX(ppu_thread& ppu, ppu_opcode_t op)
 {
 	const u64 addr = ppu.gpr[op.ra] + ppu.gpr[op.rb];
-	ppu.gpr[op.rd] = vm::read32(vm::cast(addr, HERE));
+	ppu.gpr[op.rd] = ppu_read32(vm::cast(addr, HERE));
 	ppu.gpr[op.ra] = addr;
 	return true;
 }
@@ -3555,7 +3578,7 @@ bool ppu_interpreter::STWCX(ppu_thread& ppu, ppu_opcode_t op)
 bool ppu_interpreter::STWX(ppu_thread& ppu, ppu_opcode_t op)
 {
 	const u64 addr = op.ra ? ppu.gpr[op.ra] + ppu.gpr[op.rb] : ppu.gpr[op.rb];
-	vm::write32(vm::cast(addr, HERE), (u32)ppu.gpr[op.rs]);
+	ppu_write32(vm::cast(addr, HERE), (u32)ppu.gpr[op.rs]);
 	return true;
 }
 
@@ -3578,7 +3601,7 @@ bool ppu_interpreter::STDUX(ppu_thread& ppu, ppu_opcode_t op)
 bool ppu_interpreter::STWUX(ppu_thread& ppu, ppu_opcode_t op)
 {
 	const u64 addr = ppu.gpr[op.ra] + ppu.gpr[op.rb];
-	vm::write32(vm::cast(addr, HERE), (u32)ppu.gpr[op.rs]);
+	ppu_write32(vm::cast(addr, HERE), (u32)ppu.gpr[op.rs]);
 	ppu.gpr[op.ra] = addr;
 	return true;
 }
@@ -4375,14 +4398,14 @@ bool ppu_interpreter::DCBZ(ppu_thread& ppu, ppu_opcode_t op)
 bool ppu_interpreter::LWZ(ppu_thread& ppu, ppu_opcode_t op)
 {
 	const u64 addr = op.ra ? ppu.gpr[op.ra] + op.simm16 : op.simm16;
-	ppu.gpr[op.rd] = vm::read32(vm::cast(addr, HERE));
+	ppu.gpr[op.rd] = ppu_read32(vm::cast(addr, HERE));
 	return true;
 }
 
 bool ppu_interpreter::LWZU(ppu_thread& ppu, ppu_opcode_t op)
 {
 	const u64 addr = ppu.gpr[op.ra] + op.simm16;
-	ppu.gpr[op.rd] = vm::read32(vm::cast(addr, HERE));
+	ppu.gpr[op.rd] = ppu_read32(vm::cast(addr, HERE));
 	ppu.gpr[op.ra] = addr;
 	return true;
 }
@@ -4406,7 +4429,7 @@ bool ppu_interpreter::STW(ppu_thread& ppu, ppu_opcode_t op)
 {
 	const u64 addr = op.ra ? ppu.gpr[op.ra] + op.simm16 : op.simm16;
 	const u32 value = (u32)ppu.gpr[op.rs];
-	vm::write32(vm::cast(addr, HERE), value);
+	ppu_write32(vm::cast(addr, HERE), value);
 
 	//Insomniac engine v3 & v4 (newer R&C, Fuse, Resitance 3)
 	if (UNLIKELY(value == 0xAAAAAAAA))
@@ -4420,7 +4443,7 @@ bool ppu_interpreter::STW(ppu_thread& ppu, ppu_opcode_t op)
 bool ppu_interpreter::STWU(ppu_thread& ppu, ppu_opcode_t op)
 {
 	const u64 addr = ppu.gpr[op.ra] + op.simm16;
-	vm::write32(vm::cast(addr, HERE), (u32)ppu.gpr[op.rs]);
+	ppu_write32(vm::cast(addr, HERE), (u32)ppu.gpr[op.rs]);
 	ppu.gpr[op.ra] = addr;
 	return true;
 }
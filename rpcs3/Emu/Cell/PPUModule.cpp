@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #include "Utilities/VirtualMemory.h"
 #include "Utilities/bin_patch.h"
+#include "Utilities/Thread.h"
+#include "Utilities/Timer.h"
 #include "Crypto/sha1.h"
 #include "Crypto/unself.h"
 #include "Loader/ELF.h"
@@ -16,6 +18,7 @@
 #include <map>
 #include <set>
 #include <algorithm>
+#include <future>
 
 
 
@@ -259,6 +262,9 @@ static void ppu_initialize_modules(const std::shared_ptr<ppu_linkage_info>& link
 	// Initialize double-purpose fake OPD array for HLE functions
 	const auto& hle_funcs = ppu_function_manager::get();
 
+	// The PPU profiler also collects HLE call statistics
+	const auto& hle_entries = g_cfg.core.ppu_profiler ? ppu_function_manager::get_profiled() : hle_funcs;
+
 	// Allocate memory for the array (must be called after fixed allocations)
 	ppu_function_manager::addr = vm::alloc(::size32(hle_funcs) * 8, vm::main);
 
@@ -273,7 +279,7 @@ static void ppu_initialize_modules(const std::shared_ptr<ppu_linkage_info>& link
 		vm::write32(addr + 4, ppu_instructions::BLR());
 
 		// Register the HLE function directly
-		ppu_register_function_at(addr + 0, 4, hle_funcs[index]);
+		ppu_register_function_at(addr + 0, 4, hle_entries[index]);
 		ppu_register_function_at(addr + 4, 4, nullptr);
 	}
 
@@ -747,14 +753,11 @@ std::shared_ptr<lv2_prx> ppu_load_prx(const ppu_prx_object& elf, const std::stri
 					fmt::throw_exception("vm::alloc() failed (size=0x%x)", mem_size);
 				}
 
-				// Copy segment data
-				std::memcpy(vm::base(addr), prog.bin.data(), file_size);
-				LOG_WARNING(LOADER, "**** Loaded to 0x%x (size=0x%x)", addr, mem_size);
-
-				// Hash segment
+				// Copy and hash segment data in one pass
 				sha1_update(&sha, (uchar*)&prog.p_vaddr, sizeof(prog.p_vaddr));
 				sha1_update(&sha, (uchar*)&prog.p_memsz, sizeof(prog.p_memsz));
-				sha1_update(&sha, prog.bin.data(), prog.bin.size());
+				sha1_update_copy(&sha, vm::_ptr<u8>(addr), prog.data(), file_size);
+				LOG_WARNING(LOADER, "**** Loaded to 0x%x (size=0x%x)", addr, mem_size);
 
 				// Initialize executable code if necessary
 				if (prog.p_flags & 0x1)
@@ -828,7 +831,7 @@ std::shared_ptr<lv2_prx> ppu_load_prx(const ppu_prx_object& elf, const std::stri
 
 			for (uint i = 0; i < prog.p_filesz; i += sizeof(ppu_prx_relocation_info))
 			{
-				const auto& rel = reinterpret_cast<const ppu_prx_relocation_info&>(prog.bin[i]);
+				const auto& rel = reinterpret_cast<const ppu_prx_relocation_info&>(prog.data()[i]);
 
 				ppu_reloc _rel;
 				const u32 raddr = _rel.addr = vm::cast(prx->segs.at(rel.index_addr).addr + rel.offset, HERE);
@@ -943,7 +946,7 @@ std::shared_ptr<lv2_prx> ppu_load_prx(const ppu_prx_object& elf, const std::stri
 		prx->specials = ppu_load_exports(link, lib_info->exports_start, lib_info->exports_end);
 		prx->imports = ppu_load_imports(prx->relocs, link, lib_info->imports_start, lib_info->imports_end);
 		std::stable_sort(prx->relocs.begin(), prx->relocs.end());
-		prx->analyse(lib_info->toc, 0);
+		prx->analyse_cached(lib_info->toc, 0);
 	}
 	else
 	{
@@ -1065,17 +1068,16 @@ void ppu_load_exec(const ppu_exec_object& elf)
 
 		if (type == 0x1 /* LOAD */ && prog.p_memsz)
 		{
-			if (prog.bin.size() > size || prog.bin.size() != prog.p_filesz)
-				fmt::throw_exception("Invalid binary size (0x%llx, memsz=0x%x)", prog.bin.size(), size);
+			if (prog.p_filesz > size)
+				fmt::throw_exception("Invalid binary size (0x%llx, memsz=0x%x)", prog.p_filesz, size);
 
 			if (!vm::falloc(addr, size))
 				fmt::throw_exception("vm::falloc() failed (addr=0x%x, memsz=0x%x)", addr, size);
 
-			// Copy segment data, hash it
-			std::memcpy(vm::base(addr), prog.bin.data(), prog.bin.size());
+			// Copy segment data, hash it in the same pass
 			sha1_update(&sha, (uchar*)&prog.p_vaddr, sizeof(prog.p_vaddr));
 			sha1_update(&sha, (uchar*)&prog.p_memsz, sizeof(prog.p_memsz));
-			sha1_update(&sha, prog.bin.data(), prog.bin.size());
+			sha1_update_copy(&sha, vm::_ptr<u8>(addr), prog.data(), prog.p_filesz);
 
 			// Initialize executable code if necessary
 			if (prog.p_flags & 0x1)
@@ -1393,9 +1395,29 @@ void ppu_load_exec(const ppu_exec_object& elf)
 				"\nVisit https://rpcs3.net/ for Quickstart Guide and more information.");
 		}
 
-		for (const auto& name : load_libs)
+		// Decrypt and parse all modules on the thread pool, each module is loaded and linked in order as soon as it's ready
+		const std::vector<std::string> names(load_libs.begin(), load_libs.end());
+		std::vector<std::future<ppu_prx_object>> objs;
+		objs.reserve(names.size());
+
+		Timer timer;
+		timer.Start();
+
+		for (const auto& name : names)
+		{
+			auto task = std::make_shared<std::packaged_task<ppu_prx_object()>>([path = lle_dir + name]()
+			{
+				return ppu_prx_object(decrypt_self(fs::file(path)));
+			});
+
+			objs.emplace_back(task->get_future());
+			thread_pool::push([task]() { (*task)(); });
+		}
+
+		for (std::size_t i = 0; i < names.size(); i++)
 		{
-			const ppu_prx_object obj = decrypt_self(fs::file(lle_dir + name));
+			const auto& name = names[i];
+			const ppu_prx_object obj = objs[i].get();
 
 			if (obj == elf_error::ok)
 			{
@@ -1420,6 +1442,8 @@ void ppu_load_exec(const ppu_exec_object& elf)
 				fmt::throw_exception("Failed to load /dev_flash/sys/external/%s: %s", name, obj.get_error());
 			}
 		}
+
+		LOG_NOTICE(LOADER, "Boot stage: firmware libraries loaded in %.3f ms (%u modules)", timer.GetElapsedTimeInMilliSec(), names.size());
 	}
 
 	// Set path (TODO)
@@ -1427,7 +1451,7 @@ void ppu_load_exec(const ppu_exec_object& elf)
 	_main->path = vfs::get(Emu.argv[0]);
 
 	// Analyse executable (TODO)
-	_main->analyse(0, static_cast<u32>(elf.header.e_entry));
+	_main->analyse_cached(0, static_cast<u32>(elf.header.e_entry));
 
 	// Validate analyser results (not required)
 	_main->validate(0);
@@ -2,6 +2,9 @@
 #include "Utilities/VirtualMemory.h"
 #include "Utilities/sysinfo.h"
 #include "Utilities/JIT.h"
+#include "Utilities/tracing.h"
+#include "Utilities/Timer.h"
+#include "Utilities/perf_counters.h"
 #include "Crypto/sha1.h"
 #include "Emu/Memory/Memory.h"
 #include "Emu/System.h"
@@ -11,6 +14,7 @@
 #include "PPUAnalyser.h"
 #include "PPUModule.h"
 #include "SPURecompiler.h"
+#include "RawSPUThread.h"
 #include "lv2/sys_sync.h"
 #include "lv2/sys_prx.h"
 #include "Utilities/GDBDebugServer.h"
@@ -42,6 +46,9 @@
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/Vectorize.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Target/TargetMachine.h"
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif
@@ -51,6 +58,7 @@
 #endif
 
 #include <thread>
+#include <future>
 #include <cfenv>
 #include "Utilities/GSL.h"
 
@@ -165,7 +173,7 @@ extern const ppu_decoder<ppu_interpreter_fast> g_ppu_interpreter_fast([](auto& t
 
 extern void ppu_initialize();
 extern void ppu_initialize(const ppu_module& info);
-static void ppu_initialize2(class jit_compiler& jit, const ppu_module& module_part, const std::string& cache_path, const std::string& obj_name);
+static void ppu_initialize2(class jit_compiler& jit, const ppu_module& module_part, const std::string& cache_path, const std::string& obj_name, llvm_opt_tier tier);
 extern void ppu_execute_syscall(ppu_thread& ppu, u64 code);
 
 // Get pointer to executable cache
@@ -186,6 +194,14 @@ static u32 ppu_cache(u32 addr)
 	return ::narrow<u32>(reinterpret_cast<std::uintptr_t>(table[ppu_decode(vm::read32(addr))]));
 }
 
+// Bumped when interpreter cache entries change, pre-decoded blocks are dropped when a thread sees a new value
+static atomic_t<u32> s_ppu_block_gen{0};
+
+static void ppu_invalidate_blocks()
+{
+	s_ppu_block_gen++;
+}
+
 static bool ppu_fallback(ppu_thread& ppu, ppu_opcode_t op)
 {
 	if (g_cfg.core.ppu_decoder == ppu_decoder_type::llvm)
@@ -203,6 +219,82 @@ static bool ppu_fallback(ppu_thread& ppu, ppu_opcode_t op)
 	return false;
 }
 
+// Interpret PPU code until a registered function is reached (LLVM background compilation)
+static bool ppu_interpreter_entry(ppu_thread& ppu)
+{
+	const u32 entry = ::narrow<u32>(reinterpret_cast<std::uintptr_t>(&ppu_interpreter_entry));
+	const u32 fallback = ::narrow<u32>(reinterpret_cast<std::uintptr_t>(&ppu_fallback));
+
+	do
+	{
+		if (UNLIKELY(test(ppu.state)) && ppu.check_state())
+		{
+			return false;
+		}
+
+		const u32 op = vm::read32(ppu.cia);
+
+		if (g_ppu_interpreter_fast.decode(op)(ppu, {op}))
+		{
+			ppu.cia += 4;
+		}
+	}
+	while (ppu_ref(ppu.cia) == entry || ppu_ref(ppu.cia) == fallback);
+
+	return false;
+}
+
+// Set if the current thread compiles PPU modules in background
+static thread_local bool s_ppu_background = false;
+
+// Set if the current thread recompiles PPU modules with the highest optimization tier
+static thread_local bool s_ppu_upgrade = false;
+
+// Get LLVM optimization tier used by the current thread
+static llvm_opt_tier ppu_opt_tier()
+{
+	const llvm_opt_tier tier = g_cfg.core.llvm_tier;
+
+	if (tier == llvm_opt_tier::upgrade)
+	{
+		return s_ppu_upgrade ? llvm_opt_tier::full : llvm_opt_tier::fast;
+	}
+
+	return tier;
+}
+
+// Object file name suffix, so objects of different tiers can coexist in cache
+static const char* ppu_opt_suffix(llvm_opt_tier tier)
+{
+	switch (tier)
+	{
+	case llvm_opt_tier::fast: return "-O1";
+	case llvm_opt_tier::full: return "-O3";
+	default: return "";
+	}
+}
+
+// Background PPU compilation threads (joined on emulation stop)
+struct ppu_jit_background
+{
+	std::mutex mutex;
+	std::vector<std::thread> threads;
+
+	~ppu_jit_background()
+	{
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+};
+
+// Get HLE function range for compiled code (size << 32 | address)
+static u64 ppu_hle_range()
+{
+	return u64{::size32(ppu_function_manager::get()) * 8} << 32 | ppu_function_manager::addr;
+}
+
 static std::unordered_map<u32, u32>* s_ppu_toc;
 
 static bool ppu_check_toc(ppu_thread& ppu, ppu_opcode_t op)
@@ -249,6 +341,8 @@ extern void ppu_register_range(u32 addr, u32 size)
 		addr += 4;
 		size -= 4;
 	}
+
+	ppu_invalidate_blocks();
 }
 
 extern void ppu_register_function_at(u32 addr, u32 size, ppu_function_t ptr)
@@ -257,6 +351,7 @@ extern void ppu_register_function_at(u32 addr, u32 size, ppu_function_t ptr)
 	if (ptr)
 	{
 		ppu_ref(addr) = ::narrow<u32>(reinterpret_cast<std::uintptr_t>(ptr));
+		ppu_invalidate_blocks();
 		return;
 	}
 
@@ -288,6 +383,8 @@ extern void ppu_register_function_at(u32 addr, u32 size, ppu_function_t ptr)
 		addr += 4;
 		size -= 4;
 	}
+
+	ppu_invalidate_blocks();
 }
 
 // Breakpoint entry point
@@ -332,6 +429,8 @@ extern void ppu_breakpoint(u32 addr, bool isAdding)
 		// Remove breakpoint
 		ppu_ref(addr) = ppu_cache(addr);
 	}
+
+	ppu_invalidate_blocks();
 }
 
 void ppu_thread::on_spawn()
@@ -378,6 +477,7 @@ extern void ppu_set_breakpoint(u32 addr)
 	if (ppu_ref(addr) != _break)
 	{
 		ppu_ref(addr) = _break;
+		ppu_invalidate_blocks();
 	}
 }
 
@@ -394,6 +494,7 @@ extern void ppu_remove_breakpoint(u32 addr)
 	if (ppu_ref(addr) == _break)
 	{
 		ppu_ref(addr) = ppu_cache(addr);
+		ppu_invalidate_blocks();
 	}
 }
 
@@ -424,6 +525,8 @@ extern bool ppu_patch(u32 addr, u32 value)
 		ppu_ref(addr) = ppu_cache(addr);
 	}
 
+	// The opcode is part of the pre-decoded blocks too
+	ppu_invalidate_blocks();
 	return true;
 }
 
@@ -567,6 +670,14 @@ void ppu_thread::cpu_task()
 		case ppu_cmd::initialize:
 		{
 			cmd_pop(), ppu_initialize();
+
+			if (Emu.IsPrecompiling() && !Emu.IsStopped())
+			{
+				// Only the caches were requested, don't run the title
+				state += cpu_flag::dbg_pause;
+				Emu.CallAfter([]() { Emu.PrecompileNext(); });
+			}
+
 			break;
 		}
 		case ppu_cmd::sleep:
@@ -603,6 +714,108 @@ void ppu_thread::cpu_unmem()
 	state.test_and_set(cpu_flag::memory);
 }
 
+const ppu_decoder<ppu_itype> s_ppu_itype;
+
+// Straight-line runs of interpreter handlers with their opcodes, decoded once per thread
+struct ppu_block_cache
+{
+	using func_t = decltype(&ppu_interpreter::UNK);
+
+	struct op_record
+	{
+		func_t func;
+		u32 op;
+	};
+
+	using block = std::vector<op_record>;
+
+	static constexpr u32 max_block_size = 64;
+	static constexpr u32 max_blocks = 0x10000;
+
+	std::unordered_map<u32, block> blocks;
+
+	// Direct-mapped lookup in front of the map (elements of the map are never moved)
+	std::array<std::pair<u32, const block*>, 4096> recent{};
+
+	u32 gen = 0;
+	u32 depth = 0; // Nested exec_task() calls (HLE callbacks), blocks of the outer calls stay alive
+
+	// Stops at the end of the page (the next one may not be registered), before unregistered instructions and after jumps and syscalls
+	static block decode(u32 addr)
+	{
+		const u32 fallback = ::narrow<u32>(reinterpret_cast<std::uintptr_t>(&ppu_fallback));
+
+		block result;
+
+		for (u32 n = std::min<u32>(max_block_size, (0x1000 - addr % 0x1000) / 4); n; n--, addr += 4)
+		{
+			const u32 func = ppu_ref(addr);
+
+			if (func == fallback)
+			{
+				break;
+			}
+
+			const u32 op = vm::read32(addr);
+			result.push_back({reinterpret_cast<func_t>(std::uintptr_t{func}), op});
+
+			const auto type = s_ppu_itype.decode(op);
+
+			if (type == ppu_itype::B || type == ppu_itype::BCLR || type == ppu_itype::BCCTR || type == ppu_itype::SC)
+			{
+				break;
+			}
+		}
+
+		return result;
+	}
+
+	void clear()
+	{
+		blocks.clear();
+		recent.fill({});
+	}
+
+	// Block starting at addr, nullptr if it can't be used now
+	const block* get(u32 addr)
+	{
+		const u32 new_gen = s_ppu_block_gen;
+
+		if (UNLIKELY(new_gen != gen))
+		{
+			if (depth > 1)
+			{
+				return nullptr;
+			}
+
+			clear();
+			gen = new_gen;
+		}
+
+		auto& slot = recent[addr / 4 % recent.size()];
+
+		if (LIKELY(slot.second && slot.first == addr))
+		{
+			return slot.second;
+		}
+
+		if (UNLIKELY(blocks.size() >= max_blocks) && depth == 1)
+		{
+			clear();
+		}
+
+		auto found = blocks.find(addr);
+
+		if (found == blocks.end())
+		{
+			found = blocks.emplace(addr, decode(addr)).first;
+		}
+
+		slot = {addr, &found->second};
+		return slot.second;
+	}
+};
+
 void ppu_thread::exec_task()
 {
 	if (g_cfg.core.ppu_decoder == ppu_decoder_type::llvm)
@@ -617,10 +830,60 @@ void ppu_thread::exec_task()
 
 	const auto base = vm::_ptr<const u8>(0);
 	const auto cache = vm::g_exec_addr;
+
+	using func_t = decltype(&ppu_interpreter::UNK);
+
+	if (g_cfg.core.ppu_block_cache)
+	{
+		if (!block_cache)
+		{
+			block_cache = std::make_unique<ppu_block_cache>();
+		}
+
+		ppu_block_cache& blocks = *block_cache;
+		blocks.depth++;
+
+		auto at_ret = gsl::finally([&]()
+		{
+			blocks.depth--;
+		});
+
+		while (true)
+		{
+			const ppu_block_cache::block* block = nullptr;
+
+			if (UNLIKELY(test(state)))
+			{
+				if (check_state()) return;
+			}
+			else
+			{
+				block = blocks.get(cia);
+			}
+
+			if (UNLIKELY(!block || block->empty()))
+			{
+				// Decode single instruction (may be step)
+				const u32 op = *reinterpret_cast<const be_t<u32>*>(base + cia);
+				if (reinterpret_cast<func_t>((std::uintptr_t)ppu_ref(cia))(*this, {op})) { cia += 4; }
+				continue;
+			}
+
+			for (const auto& rec : *block)
+			{
+				if (UNLIKELY(!rec.func(*this, {rec.op})))
+				{
+					break;
+				}
+
+				cia += 4;
+			}
+		}
+	}
+
 	const auto bswap4 = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
 
 	v128 _op;
-	using func_t = decltype(&ppu_interpreter::UNK);
 	func_t func0, func1, func2, func3, func4, func5;
 
 	while (true)
@@ -895,8 +1158,6 @@ void ppu_thread::stack_pop_verbose(u32 addr, u32 size) noexcept
 	LOG_ERROR(PPU, "Invalid thread" HERE);
 }
 
-const ppu_decoder<ppu_itype> s_ppu_itype;
-
 extern u64 get_timebased_time();
 extern ppu_function_t ppu_get_syscall(u64 code);
 
@@ -1013,6 +1274,19 @@ extern u64 ppu_ldarx(ppu_thread& ppu, u32 addr)
 	return ppu_load_acquire_reservation<u64>(ppu, addr);
 }
 
+static inline void ppu_reservation_stat(u32 addr, vm::reservation_event event)
+{
+	if (event == vm::reservation_event::fail)
+	{
+		perf::ppu_reservation_failures.add();
+	}
+
+	if (UNLIKELY(g_cfg.core.reservation_stats))
+	{
+		vm::reservation_stat(addr, event);
+	}
+}
+
 const auto ppu_stwcx_tx = build_function_asm<bool(*)(u32 raddr, u64 rtime, u64 rdata, u32 value)>([](asmjit::X86Assembler& c, auto& args)
 {
 	using namespace asmjit;
@@ -1067,6 +1341,7 @@ extern bool ppu_stwcx(ppu_thread& ppu, u32 addr, u32 reg_value)
 	if (ppu.raddr != addr || ppu.rdata != data.load() || ppu.rtime != vm::reservation_acquire(addr, sizeof(u32)))
 	{
 		ppu.raddr = 0;
+		ppu_reservation_stat(addr, vm::reservation_event::fail);
 		return false;
 	}
 
@@ -1081,11 +1356,15 @@ extern bool ppu_stwcx(ppu_thread& ppu, u32 addr, u32 reg_value)
 
 		// Reservation lost
 		ppu.raddr = 0;
+		ppu_reservation_stat(addr, vm::reservation_event::tx_fail);
+		ppu_reservation_stat(addr, vm::reservation_event::fail);
 		return false;
 	}
 
 	vm::temporary_unlock(ppu);
 
+	ppu_reservation_stat(addr, vm::reservation_event::lock);
+
 	auto& res = vm::reservation_lock(addr, sizeof(u32));
 
 	const bool result = ppu.rtime == (res & ~1ull) && data.compare_and_swap_test(static_cast<u32>(ppu.rdata), reg_value);
@@ -1098,6 +1377,7 @@ extern bool ppu_stwcx(ppu_thread& ppu, u32 addr, u32 reg_value)
 	else
 	{
 		res &= ~1ull;
+		ppu_reservation_stat(addr, vm::reservation_event::fail);
 	}
 
 	ppu.cpu_mem();
@@ -1159,6 +1439,7 @@ extern bool ppu_stdcx(ppu_thread& ppu, u32 addr, u64 reg_value)
 	if (ppu.raddr != addr || ppu.rdata != data.load() || ppu.rtime != vm::reservation_acquire(addr, sizeof(u64)))
 	{
 		ppu.raddr = 0;
+		ppu_reservation_stat(addr, vm::reservation_event::fail);
 		return false;
 	}
 
@@ -1173,11 +1454,15 @@ extern bool ppu_stdcx(ppu_thread& ppu, u32 addr, u64 reg_value)
 
 		// Reservation lost
 		ppu.raddr = 0;
+		ppu_reservation_stat(addr, vm::reservation_event::tx_fail);
+		ppu_reservation_stat(addr, vm::reservation_event::fail);
 		return false;
 	}
 
 	vm::temporary_unlock(ppu);
 
+	ppu_reservation_stat(addr, vm::reservation_event::lock);
+
 	auto& res = vm::reservation_lock(addr, sizeof(u64));
 
 	const bool result = ppu.rtime == (res & ~1ull) && data.compare_and_swap_test(ppu.rdata, reg_value);
@@ -1190,6 +1475,7 @@ extern bool ppu_stdcx(ppu_thread& ppu, u32 addr, u64 reg_value)
 	else
 	{
 		res &= ~1ull;
+		ppu_reservation_stat(addr, vm::reservation_event::fail);
 	}
 
 	ppu.cpu_mem();
@@ -1208,6 +1494,189 @@ static bool adde_carry(u64 a, u64 b, bool c)
 #endif
 }
 
+// PPU sampling profiler (writes ppu_profile.log and ppu_profile.folded to the executable cache)
+class ppu_profiler final : public named_thread
+{
+	std::string get_name() const override { return "PPU Profiler"; }
+
+	void on_task() override;
+};
+
+void ppu_profiler::on_task()
+{
+	const u64 period = 1000000 / g_cfg.core.ppu_profiler;
+	const std::string path = fxm::get<ppu_module>()->cache;
+
+	// Function address -> (module name, function size)
+	std::map<u32, std::pair<std::string, u32>> symbols;
+	u32 symbols_modules = -1;
+
+	// Call stacks (innermost first) and HLE function or syscall active on top of them
+	std::map<std::pair<std::vector<u32>, const char*>, u64> samples;
+	u64 total = 0;
+
+	const auto add_symbols = [&](const ppu_module& module, const std::string& name)
+	{
+		for (const auto& func : module.funcs)
+		{
+			symbols[func.addr] = std::make_pair(name, func.size);
+		}
+	};
+
+	while (!Emu.IsStopped())
+	{
+		thread_ctrl::wait_for(period);
+
+		if (Emu.IsPaused())
+		{
+			continue;
+		}
+
+		// Update symbols if the list of modules changed
+		u32 modules = 0;
+		idm::select<lv2_obj, lv2_prx>([&](u32, lv2_prx&) { modules++; });
+
+		if (modules != symbols_modules)
+		{
+			symbols.clear();
+			symbols_modules = modules;
+
+			if (const auto _main = fxm::get<ppu_module>())
+			{
+				add_symbols(*_main, _main->path.substr(_main->path.find_last_of('/') + 1));
+			}
+
+			idm::select<lv2_obj, lv2_prx>([&](u32, lv2_prx& prx)
+			{
+				add_symbols(prx, prx.name);
+			});
+		}
+
+		idm::select<ppu_thread>([&](u32, ppu_thread& ppu)
+		{
+			// Skip sleeping threads
+			if (test(ppu.state, cpu_state_pause))
+			{
+				return;
+			}
+
+			std::vector<u32> stack{ppu.cia};
+
+			// Walk the back chain (as in ppu_thread::dump)
+			u64 sp = static_cast<u32>(ppu.gpr[1]);
+
+			while (stack.size() < 32 && sp && sp < 0x100000000 && vm::check_addr(static_cast<u32>(sp), 8) && (sp = vm::read64(static_cast<u32>(sp))))
+			{
+				if (sp >= 0x100000000 || !vm::check_addr(static_cast<u32>(sp + 16), 8))
+				{
+					break;
+				}
+
+				stack.push_back(static_cast<u32>(vm::read64(static_cast<u32>(sp + 16))));
+			}
+
+			samples[std::make_pair(std::move(stack), ppu.last_function)]++;
+			total++;
+		});
+	}
+
+	if (!total)
+	{
+		return;
+	}
+
+	const auto get_name = [&](u32 addr) -> std::string
+	{
+		auto found = symbols.upper_bound(addr);
+
+		if (found != symbols.begin() && (--found, !found->second.second || addr - found->first < found->second.second))
+		{
+			return fmt::format("%s!__0x%x", found->second.first, found->first);
+		}
+
+		return fmt::format("0x%x", addr);
+	};
+
+	// Flat profile (by innermost function or HLE function) and folded stacks for flamegraphs
+	std::map<std::string, u64> flat;
+	std::string folded;
+
+	for (const auto& sample : samples)
+	{
+		const auto& stack = sample.first.first;
+		const char* hle = sample.first.second;
+
+		const std::string leaf = get_name(stack[0]);
+
+		flat[hle ? fmt::format("%s (HLE, from %s)", hle, leaf) : leaf] += sample.second;
+
+		for (auto it = stack.rbegin(); it != stack.rend(); ++it)
+		{
+			folded += get_name(*it);
+			folded += ';';
+		}
+
+		if (hle)
+		{
+			folded += hle;
+		}
+		else
+		{
+			folded.pop_back();
+		}
+
+		fmt::append(folded, " %llu\n", sample.second);
+	}
+
+	std::multimap<u64, std::string, std::greater<u64>> sorted;
+
+	for (auto& entry : flat)
+	{
+		sorted.emplace(entry.second, std::move(entry.first));
+	}
+
+	std::string log = fmt::format("PPU Profile: %llu samples (%u Hz)\n\n", total, g_cfg.core.ppu_profiler);
+
+	for (const auto& entry : sorted)
+	{
+		fmt::append(log, "%6.2f%% %8llu %s\n", entry.first * 100. / total, entry.first, entry.second);
+	}
+
+	// HLE function calls, by total host time
+	extern std::vector<std::string> g_ppu_function_names;
+
+	const auto& hle_stats = ppu_function_manager::get_stats();
+	std::multimap<u64, u32, std::greater<u64>> hle_sorted;
+
+	for (u32 i = 0; i < hle_stats.size() && i < g_ppu_function_names.size(); i++)
+	{
+		if (hle_stats[i].calls)
+		{
+			hle_sorted.emplace(hle_stats[i].time, i);
+		}
+	}
+
+	fmt::append(log, "\nHLE calls: %u functions\n\n", ::size32(hle_sorted));
+
+	for (const auto& entry : hle_sorted)
+	{
+		const u64 calls = hle_stats[entry.second].calls;
+		fmt::append(log, "%10.3f ms %10llu calls %8.3f us/call %s\n", entry.first / 1e6, calls, entry.first / 1e3 / calls, g_ppu_function_names[entry.second]);
+	}
+
+	if (fs::file f{path + "ppu_profile.log", fs::rewrite})
+	{
+		f.write(log);
+	}
+
+	if (fs::file f{path + "ppu_profile.folded", fs::rewrite})
+	{
+		f.write(folded);
+	}
+
+	LOG_SUCCESS(PPU, "Profile saved: %sppu_profile.log", path);
+}
+
 extern void ppu_initialize()
 {
 	const auto _main = fxm::get<ppu_module>();
@@ -1239,6 +1708,26 @@ extern void ppu_initialize()
 		return;
 	}
 
+	if (g_cfg.core.ppu_profiler)
+	{
+		fxm::get_always<ppu_profiler>();
+	}
+
+	// Initialize SPU cache on the thread pool while PPU modules are compiled, it only depends on the cache path
+	const auto spu_task = std::make_shared<std::packaged_task<void()>>([]()
+	{
+		Timer timer;
+		timer.Start();
+		spu_cache::initialize();
+		LOG_NOTICE(LOADER, "Boot stage: SPU cache initialized in %.3f ms", timer.GetElapsedTimeInMilliSec());
+	});
+
+	auto spu_done = spu_task->get_future();
+	thread_pool::push([spu_task]() { (*spu_task)(); });
+
+	Timer timer;
+	timer.Start();
+
 	// Initialize main module
 	ppu_initialize(*_main);
 
@@ -1255,8 +1744,10 @@ extern void ppu_initialize()
 		ppu_initialize(*ptr);
 	}
 
-	// Initialize SPU cache
-	spu_cache::initialize();
+	LOG_NOTICE(LOADER, "Boot stage: PPU modules initialized in %.3f ms (%u libraries)", timer.GetElapsedTimeInMilliSec(), prx_list.size());
+
+	// SPU threads may only start once the shared runtime is ready
+	spu_done.get();
 }
 
 extern void ppu_initialize(const ppu_module& info)
@@ -1277,6 +1768,7 @@ extern void ppu_initialize(const ppu_module& info)
 			{
 				s_ppu_toc->emplace(func.addr, func.toc);
 				ppu_ref(func.addr) = ::narrow<u32>(reinterpret_cast<std::uintptr_t>(&ppu_check_toc));
+				ppu_invalidate_blocks();
 			}
 		}
 
@@ -1310,6 +1802,8 @@ extern void ppu_initialize(const ppu_module& info)
 			{ "__stvlx", s_use_ssse3 ? (u64)&sse_cellbe_stvlx : (u64)&sse_cellbe_stvlx_v0 },
 			{ "__stvrx", s_use_ssse3 ? (u64)&sse_cellbe_stvrx : (u64)&sse_cellbe_stvrx_v0 },
 			{ "__resupdate", (u64)&vm::reservation_update },
+			{ "__mmio_read32", (u64)&RawSPUThread::mmio_read32 },
+			{ "__mmio_write32", (u64)&RawSPUThread::mmio_write32 },
 		};
 
 		for (u64 index = 0; index < 1024; index++)
@@ -1332,22 +1826,61 @@ extern void ppu_initialize(const ppu_module& info)
 	}
 	else
 	{
+		// Firmware modules are shared between titles, keyed by module hash (object names contain LLVM CPU)
+		const std::string fw_path = fmt::format("%sdata/ppu-firmware/%s-%s/", fs::get_config_dir(), fmt::base57(info.sha1), info.name);
+
 		cache_path = vfs::get("/dev_flash/");
 
-		if (info.path.compare(0, cache_path.size(), cache_path) == 0)
+		if (info.path.compare(0, cache_path.size(), cache_path) == 0 || fs::is_dir(fw_path))
 		{
-			// Remove prefix for dev_flash files
-			cache_path.clear();
+			// Also used for identical copies of firmware modules shipped with titles
+			cache_path = fw_path;
+
+			if (!fs::create_path(cache_path))
+			{
+				fmt::throw_exception("Failed to create cache directory: %s (%s)", cache_path, fs::g_tls_error);
+			}
 		}
 		else
 		{
-			cache_path = Emu.GetTitleID();
+			cache_path = fs::get_data_dir(Emu.GetTitleID(), info.path);
 		}
-
-		cache_path = fs::get_data_dir(cache_path, info.path);
 	}
 
 #ifdef LLVM_AVAILABLE
+	if (g_cfg.core.llvm_background && get_current_cpu_thread())
+	{
+		// Start on the interpreter, compiled functions are installed when the module is linked
+		const u32 entry = ::narrow<u32>(reinterpret_cast<std::uintptr_t>(&ppu_interpreter_entry));
+		const u32 fallback = ::narrow<u32>(reinterpret_cast<std::uintptr_t>(&ppu_fallback));
+
+		for (const auto& func : info.funcs)
+		{
+			for (const auto& block : func.blocks)
+			{
+				for (u32 addr = block.first; addr < block.first + block.second; addr += 4)
+				{
+					if (ppu_ref(addr) == fallback)
+					{
+						ppu_ref(addr) = entry;
+					}
+				}
+			}
+		}
+
+		const auto bg = fxm::get_always<ppu_jit_background>();
+
+		std::lock_guard<std::mutex> lock(bg->mutex);
+
+		bg->threads.emplace_back([module = ppu_module(info)]()
+		{
+			s_ppu_background = true;
+			ppu_initialize(module);
+		});
+
+		return;
+	}
+
 	// Initialize progress dialog
 	g_progr = "Compiling PPU modules...";
 
@@ -1368,15 +1901,25 @@ extern void ppu_initialize(const ppu_module& info)
 		}
 	};
 
-	// Permanently loaded compiled PPU modules (name -> data)
-	jit_module& jit_mod = fxm::get_always<std::unordered_map<std::string, jit_module>>()->emplace(cache_path + info.name, jit_module{}).first->second;
+	// Compiler mutex (global)
+	static semaphore<> jmutex;
+
+	// Optimization tier
+	const llvm_opt_tier tier = ppu_opt_tier();
+
+	// Set if all objects are available at the highest tier (no upgrade necessary)
+	bool upgraded = true;
+
+	// Permanently loaded compiled PPU modules (name -> data), may be accessed from background threads
+	jit_module& jit_mod = [&]() -> jit_module&
+	{
+		semaphore_lock lock(jmutex);
+		return fxm::get_always<std::unordered_map<std::string, jit_module>>()->emplace(cache_path + info.name + ppu_opt_suffix(tier), jit_module{}).first->second;
+	}();
 
 	// Compiler instance (deferred initialization)
 	std::shared_ptr<jit_compiler> jit;
 
-	// Compiler mutex (global)
-	static semaphore<> jmutex;
-
 	// Initialize global semaphore with the max number of threads
 	u32 max_threads = static_cast<u32>(g_cfg.core.llvm_threads);
 	s32 thread_count = max_threads > 0 ? std::min(max_threads, std::thread::hardware_concurrency()) : std::thread::hardware_concurrency();
@@ -1397,7 +1940,7 @@ extern void ppu_initialize(const ppu_module& info)
 	while (jit_mod.vars.empty() && fpos < info.funcs.size())
 	{
 		// Initialize compiler instance
-		if (!jit && get_current_cpu_thread())
+		if (!jit && (get_current_cpu_thread() || s_ppu_background))
 		{
 			jit = std::make_shared<jit_compiler>(s_link_table, g_cfg.core.llvm_cpu);
 		}
@@ -1442,7 +1985,7 @@ extern void ppu_initialize(const ppu_module& info)
 		}
 
 		// Version, module name and hash: vX-liblv2.sprx-0123456789ABCDEF.obj
-		std::string obj_name = "v2";
+		std::string obj_name = "v4";
 
 		if (info.name.size())
 		{
@@ -1523,7 +2066,20 @@ extern void ppu_initialize(const ppu_module& info)
 			}
 
 			sha1_finish(&ctx, output);
-			fmt::append(obj_name, "-%016X-%s.obj", reinterpret_cast<be_t<u64>&>(output), jit_compiler::cpu(g_cfg.core.llvm_cpu));
+			fmt::append(obj_name, "-%016X-%s", reinterpret_cast<be_t<u64>&>(output), jit_compiler::cpu(g_cfg.core.llvm_cpu));
+		}
+
+		// Prefer the upgraded object if it's already available
+		const std::string full_name = obj_name + ppu_opt_suffix(llvm_opt_tier::full) + ".obj";
+
+		if (g_cfg.core.llvm_tier == llvm_opt_tier::upgrade && fs::is_file(cache_path + full_name))
+		{
+			obj_name = full_name;
+		}
+		else
+		{
+			obj_name = obj_name + ppu_opt_suffix(tier) + ".obj";
+			upgraded = upgraded && tier == llvm_opt_tier::full;
 		}
 
 		if (Emu.IsStopped())
@@ -1533,6 +2089,7 @@ extern void ppu_initialize(const ppu_module& info)
 
 		globals.emplace_back(fmt::format("__mptr%x", suffix), (u64)vm::g_base_addr);
 		globals.emplace_back(fmt::format("__cptr%x", suffix), (u64)vm::g_exec_addr);
+		globals.emplace_back(fmt::format("__hle%x", suffix), ppu_hle_range());
 
 		// Initialize segments for relocations
 		for (u32 i = 0; i < info.segs.size(); i++)
@@ -1560,10 +2117,11 @@ extern void ppu_initialize(const ppu_module& info)
 		g_progr_ptotal++;
 
 		// Create worker thread for compilation
-		jthreads.emplace_back([&jit, obj_name = obj_name, part = std::move(part), &cache_path, jcores]()
+		jthreads.emplace_back([&jit, obj_name = obj_name, part = std::move(part), &cache_path, jcores, tier]()
 		{
-			// Set low priority
+			// Set low priority, away from the emulation threads
 			thread_ctrl::set_native_priority(-1);
+			thread_ctrl::set_thread_affinity_mask(thread_ctrl::get_affinity_mask(thread_class::llvm));
 
 			// Allocate "core"
 			{
@@ -1572,8 +2130,11 @@ extern void ppu_initialize(const ppu_module& info)
 				if (!Emu.IsStopped())
 				{
 					// Use another JIT instance
-					jit_compiler jit2({}, g_cfg.core.llvm_cpu);
-					ppu_initialize2(jit2, part, cache_path, obj_name);
+					tracing::scope trace(tracing::category::ppu_jit, "PPU LLVM compile");
+					trace.set_arg("functions", part.funcs.size());
+
+					jit_compiler jit2({}, g_cfg.core.llvm_cpu, false, tier == llvm_opt_tier::fast ? 1 : 3);
+					ppu_initialize2(jit2, part, cache_path, obj_name, tier);
 				}
 
 				g_progr_pdone++;
@@ -1596,7 +2157,7 @@ extern void ppu_initialize(const ppu_module& info)
 		thread.join();
 	}
 
-	if (Emu.IsStopped() || !get_current_cpu_thread())
+	if (Emu.IsStopped() || !(get_current_cpu_thread() || s_ppu_background))
 	{
 		return;
 	}
@@ -1661,6 +2222,7 @@ extern void ppu_initialize(const ppu_module& info)
 		{
 			*jit_mod.vars[index++] = (u64)vm::g_base_addr;
 			*jit_mod.vars[index++] = (u64)vm::g_exec_addr;
+			*jit_mod.vars[index++] = ppu_hle_range();
 
 			for (const auto& seg : info.segs)
 			{
@@ -1668,16 +2230,33 @@ extern void ppu_initialize(const ppu_module& info)
 			}
 		}
 	}
+
+	// Recompile main executable with the highest tier in background, replace functions when linked
+	if (g_cfg.core.llvm_tier == llvm_opt_tier::upgrade && !s_ppu_upgrade && !upgraded && info.name.empty())
+	{
+		const auto bg = fxm::get_always<ppu_jit_background>();
+
+		std::lock_guard<std::mutex> lock(bg->mutex);
+
+		bg->threads.emplace_back([module = ppu_module(info)]()
+		{
+			s_ppu_background = true;
+			s_ppu_upgrade = true;
+			ppu_initialize(module);
+		});
+	}
 #else
 	fmt::throw_exception("LLVM is not available in this build.");
 #endif
 }
 
-static void ppu_initialize2(jit_compiler& jit, const ppu_module& module_part, const std::string& cache_path, const std::string& obj_name)
+static void ppu_initialize2(jit_compiler& jit, const ppu_module& module_part, const std::string& cache_path, const std::string& obj_name, llvm_opt_tier tier)
 {
 #ifdef LLVM_AVAILABLE
 	using namespace llvm;
 
+	perf::ppu_objects_compiled.add();
+
 	// Create LLVM module
 	std::unique_ptr<Module> module = std::make_unique<Module>(obj_name, jit.get_context());
 
@@ -1685,7 +2264,7 @@ static void ppu_initialize2(jit_compiler& jit, const ppu_module& module_part, co
 	module->setTargetTriple(Triple::normalize(sys::getProcessTriple()));
 
 	// Initialize translator
-	PPUTranslator translator(jit.get_context(), module.get(), module_part);
+	PPUTranslator translator(jit.get_context(), module.get(), module_part, jit);
 
 	// Define some types
 	const auto _void = Type::getVoidTy(jit.get_context());
@@ -1704,24 +2283,33 @@ static void ppu_initialize2(jit_compiler& jit, const ppu_module& module_part, co
 	{
 		legacy::FunctionPassManager pm(module.get());
 
-		// Basic optimizations
-		//pm.add(createCFGSimplificationPass());
-		//pm.add(createPromoteMemoryToRegisterPass());
-		pm.add(createEarlyCSEPass());
-		//pm.add(createTailCallEliminationPass());
-		//pm.add(createInstructionCombiningPass());
-		//pm.add(createBasicAAWrapperPass());
-		//pm.add(new MemoryDependenceAnalysis());
-		//pm.add(createLICMPass());
-		//pm.add(createLoopInstSimplifyPass());
-		//pm.add(createNewGVNPass());
-		pm.add(createDeadStoreEliminationPass());
-		//pm.add(createSCCPPass());
-		//pm.add(createReassociatePass());
-		//pm.add(createInstructionCombiningPass());
-		//pm.add(createInstructionSimplifierPass());
-		//pm.add(createAggressiveDCEPass());
-		//pm.add(createCFGSimplificationPass());
+		if (tier == llvm_opt_tier::fast)
+		{
+			// Minimal optimizations
+			pm.add(createEarlyCSEPass());
+		}
+		else
+		{
+			// Basic optimizations
+			//pm.add(createCFGSimplificationPass());
+			//pm.add(createPromoteMemoryToRegisterPass());
+			pm.add(createEarlyCSEPass());
+			//pm.add(createTailCallEliminationPass());
+			//pm.add(createInstructionCombiningPass());
+			//pm.add(createBasicAAWrapperPass());
+			//pm.add(new MemoryDependenceAnalysis());
+			//pm.add(createLICMPass());
+			//pm.add(createLoopInstSimplifyPass());
+			//pm.add(createNewGVNPass());
+			pm.add(createDeadStoreEliminationPass());
+			//pm.add(createSCCPPass());
+			//pm.add(createReassociatePass());
+			//pm.add(createInstructionCombiningPass());
+			//pm.add(createInstructionSimplifierPass());
+			//pm.add(createAggressiveDCEPass());
+			//pm.add(createCFGSimplificationPass());
+		}
+
 		//pm.add(createLintPass()); // Check
 
 		// Translate functions
@@ -1757,6 +2345,21 @@ static void ppu_initialize2(jit_compiler& jit, const ppu_module& module_part, co
 		//mpm.add(createDeadInstEliminationPass());
 		//mpm.run(*module);
 
+		if (tier == llvm_opt_tier::full)
+		{
+			// Full optimizations (-O3 with vectorizers)
+			PassManagerBuilder pmb;
+			pmb.OptLevel = 3;
+			pmb.LoopVectorize = true;
+			pmb.SLPVectorize = true;
+
+			// Inline small functions of the same part into their callers (tail calls between guest blocks and functions)
+			pmb.Inliner = createFunctionInliningPass(50);
+			mpm.add(createTargetTransformInfoWrapperPass(jit.get_engine().getTargetMachine()->getTargetIRAnalysis()));
+			pmb.populateModulePassManager(mpm);
+			mpm.run(*module);
+		}
+
 		std::string result;
 		raw_string_ostream out(result);
 
@@ -153,6 +153,8 @@ public:
 	u64 start_time{0}; // Sleep start timepoint
 	const char* last_function{}; // Last function name for diagnosis, optimized for speed.
 
+	std::unique_ptr<struct ppu_block_cache> block_cache; // Pre-decoded blocks of the interpreters, created on first use
+
 	const std::string m_name; // Thread name
 
 	be_t<u64>* get_stack_arg(s32 i, u64 align = alignof(u64));
@@ -3,6 +3,9 @@
 #include "PPUTranslator.h"
 #include "PPUThread.h"
 #include "PPUInterpreter.h"
+#include "RawSPUThread.h"
+#include "../Utilities/JIT.h"
+#include "llvm/Config/llvm-config.h"
 
 #include "../Utilities/Log.h"
 #include <algorithm>
@@ -11,9 +14,11 @@ using namespace llvm;
 
 const ppu_decoder<PPUTranslator> s_ppu_decoder;
 
-PPUTranslator::PPUTranslator(LLVMContext& context, Module* module, const ppu_module& info)
+PPUTranslator::PPUTranslator(LLVMContext& context, Module* module, const ppu_module& info, const jit_compiler& jit)
 	: cpu_translator(module, false)
 	, m_info(info)
+	, m_use_ssse3(jit.has_ssse3())
+	, m_use_vbmi(jit.has_avx512vbmi())
 	, m_pure_attr(AttributeList::get(m_context, AttributeList::FunctionIndex, {Attribute::NoUnwind, Attribute::ReadNone}))
 {
 	// Bind context
@@ -52,6 +57,11 @@ PPUTranslator::PPUTranslator(LLVMContext& context, Module* module, const ppu_mod
 	m_call->setInitializer(ConstantPointerNull::get(cast<PointerType>(m_call->getType()->getPointerElementType())));
 	m_call->setExternallyInitialized(true);
 
+	// HLE functions
+	m_hle = new GlobalVariable(*module, GetType<u64>(), true, GlobalValue::ExternalLinkage, 0, fmt::format("__hle%x", gsuffix));
+	m_hle->setInitializer(ConstantInt::get(GetType<u64>(), 0));
+	m_hle->setExternallyInitialized(true);
+
 	const auto md_name = MDString::get(m_context, "branch_weights");
 	const auto md_low = ValueAsMetadata::get(ConstantInt::get(GetType<u32>(), 1));
 	const auto md_high = ValueAsMetadata::get(ConstantInt::get(GetType<u32>(), 666));
@@ -258,6 +268,26 @@ void PPUTranslator::CallFunction(u64 target, Value* indirect)
 	const auto type = FunctionType::get(GetType<void>(), {m_thread_type->getPointerTo()}, false);
 	const auto block = m_ir->GetInsertBlock();
 
+	// Link known targets of indirect branches directly (CTR loaded with an immediate in the same block is constant-folded).
+	// Only functions already present in the module are used, they are defined in this part or resolved from other parts on link.
+	if (indirect && !m_reloc)
+	{
+		if (const auto _const = dyn_cast<ConstantInt>(indirect))
+		{
+			if (m_module->getFunction(fmt::format("__0x%llx", _const->getZExtValue())))
+			{
+				target = _const->getZExtValue();
+				indirect = nullptr;
+			}
+		}
+	}
+
+	// Target address
+	Value* addr = indirect;
+
+	// Indirect call (may be an HLE function)
+	const bool is_indirect = indirect != nullptr;
+
 	if (!indirect)
 	{
 		if ((!m_reloc && target < 0x10000) || target >= -0x10000)
@@ -266,6 +296,7 @@ void PPUTranslator::CallFunction(u64 target, Value* indirect)
 			return;
 		}
 
+		addr = GetAddr(target - m_addr);
 		indirect = m_module->getOrInsertFunction(fmt::format("__0x%llx", target), type);
 	}
 	else
@@ -285,6 +316,42 @@ void PPUTranslator::CallFunction(u64 target, Value* indirect)
 	}
 
 	m_ir->SetInsertPoint(block);
+
+	// Set CIA (the callee may be interpreted, see ppu_interpreter_entry)
+	const auto cia_ptr = m_ir->CreateStructGEP(nullptr, m_thread, &m_cia - m_locals);
+	m_ir->CreateStore(Trunc(addr), cia_ptr);
+
+	if (is_indirect)
+	{
+		// Call HLE function directly (arguments are already in the context) and return to LR without leaving compiled code
+		const auto range = m_ir->CreateLoad(m_hle);
+		const auto cia = m_ir->CreateTrunc(addr, GetType<u32>());
+		const auto pos = m_ir->CreateSub(cia, m_ir->CreateTrunc(range, GetType<u32>()));
+		const auto _hle = BasicBlock::Create(m_context, "__hle", m_function);
+		const auto _ret = BasicBlock::Create(m_context, "__hle_ret", m_function);
+		const auto _exit = BasicBlock::Create(m_context, "__hle_exit", m_function);
+		const auto _tail = BasicBlock::Create(m_context, "__tail", m_function);
+		m_ir->CreateCondBr(m_ir->CreateICmpULT(pos, m_ir->CreateTrunc(m_ir->CreateLShr(range, 32), GetType<u32>())), _hle, _tail, m_md_unlikely);
+		m_ir->SetInsertPoint(_hle);
+		m_ir->CreateCall(indirect, {m_thread});
+
+		// Fall back to the dispatcher if the function didn't return normally (CIA changed or state set)
+		const auto vstate = m_ir->CreateLoad(m_ir->CreateStructGEP(nullptr, m_thread, 1), true);
+		const auto normal = m_ir->CreateICmpEQ(m_ir->CreateLoad(cia_ptr), m_ir->CreateAdd(cia, m_ir->getInt32(4)));
+		m_ir->CreateCondBr(m_ir->CreateAnd(normal, m_ir->CreateIsNull(vstate)), _ret, _exit, m_md_likely);
+		m_ir->SetInsertPoint(_exit);
+		m_ir->CreateRetVoid();
+
+		// Execute BLR
+		m_ir->SetInsertPoint(_ret);
+		const auto lr = m_ir->CreateTrunc(m_ir->CreateLoad(m_ir->CreateStructGEP(nullptr, m_thread, &m_lr - m_locals)), GetType<u32>());
+		const auto ptr = m_ir->CreateGEP(m_ir->CreateLoad(m_call), {m_ir->getInt64(0), m_ir->CreateLShr(m_ir->CreateZExt(lr, GetType<u64>()), 2, "", true)});
+		m_ir->CreateStore(lr, cia_ptr);
+		m_ir->CreateCall(m_ir->CreateIntToPtr(m_ir->CreateLoad(ptr), type->getPointerTo()), {m_thread})->setTailCallKind(llvm::CallInst::TCK_Tail);
+		m_ir->CreateRetVoid();
+		m_ir->SetInsertPoint(_tail);
+	}
+
 	m_ir->CreateCall(indirect, {m_thread})->setTailCallKind(llvm::CallInst::TCK_Tail);
 	m_ir->CreateRetVoid();
 }
@@ -527,10 +594,33 @@ llvm::Value* PPUTranslator::GetMemory(llvm::Value* addr, llvm::Type* type)
 	return m_ir->CreateBitCast(m_ir->CreateGEP(m_base_loaded, {m_ir->getInt64(0), addr}), type->getPointerTo());
 }
 
+u32 PPUTranslator::GetMmioAddr(Value* addr, Type* type)
+{
+	// Only word accesses at addresses known at compile time (a base loaded with lis in the same block), others still fault
+	if (const auto _const = dyn_cast<ConstantInt>(addr))
+	{
+		const u32 ea = static_cast<u32>(_const->getZExtValue());
+
+		if (type->isIntegerTy(32) && RawSPUThread::is_mmio(ea))
+		{
+			return ea;
+		}
+	}
+
+	return 0;
+}
+
 Value* PPUTranslator::ReadMemory(Value* addr, Type* type, bool is_be, u32 align)
 {
 	const auto size = type->getPrimitiveSizeInBits();
 
+	if (const auto mmio = GetMmioAddr(addr, type))
+	{
+		// Read the register directly, the value is what a big-endian load returns
+		const auto value = Call(GetType<u32>(), "__mmio_read32", m_ir->getInt32(mmio));
+		return is_be ? value : Call(GetType<u32>(), "llvm.bswap.i32", value);
+	}
+
 	if (is_be ^ m_is_be && size > 8)
 	{
 		// Read, byteswap, bitcast
@@ -548,6 +638,12 @@ void PPUTranslator::WriteMemory(Value* addr, Value* value, bool is_be, u32 align
 	const auto type = value->getType();
 	const auto size = type->getPrimitiveSizeInBits();
 
+	if (const auto mmio = GetMmioAddr(addr, type))
+	{
+		Call(GetType<void>(), "__mmio_write32", m_ir->getInt32(mmio), is_be ? value : Call(GetType<u32>(), "llvm.bswap.i32", value));
+		return;
+	}
+
 	if (is_be ^ m_is_be && size > 8)
 	{
 		// Bitcast, byteswap
@@ -1194,7 +1290,28 @@ void PPUTranslator::VOR(ppu_opcode_t op)
 void PPUTranslator::VPERM(ppu_opcode_t op)
 {
 	const auto abc = GetVrs(VrType::vi8, op.va, op.vb, op.vc);
-	SetVr(op.vd, Call(GetType<u8[16]>(), m_pure_attr, "__vperm", abc[0], abc[1], abc[2]));
+
+	if (!m_use_ssse3)
+	{
+		SetVr(op.vd, Call(GetType<u8[16]>(), m_pure_attr, "__vperm", abc[0], abc[1], abc[2]));
+		return;
+	}
+
+	// Byte index in reversed element order (see sse_altivec_vperm)
+	const auto index = m_ir->CreateAnd(m_ir->CreateNot(abc[2]), 0x1f);
+
+#if LLVM_VERSION_MAJOR >= 7
+	if (m_use_vbmi)
+	{
+		// Single VPERMI2B: indices 0..15 select from VB, 16..31 from VA
+		SetVr(op.vd, m_ir->CreateCall(get_intrinsic(Intrinsic::x86_avx512_vpermi2var_qi_128), {abc[1], index, abc[0]}));
+		return;
+	}
+#endif
+
+	const auto sa = m_ir->CreateCall(get_intrinsic(Intrinsic::x86_ssse3_pshuf_b_128), {abc[0], index});
+	const auto sb = m_ir->CreateCall(get_intrinsic(Intrinsic::x86_ssse3_pshuf_b_128), {abc[1], index});
+	SetVr(op.vd, m_ir->CreateSelect(m_ir->CreateICmpUGT(index, ConstantInt::get(GetType<u8[16]>(), 0xf)), sa, sb));
 }
 
 void PPUTranslator::VPKPX(ppu_opcode_t op)
@@ -6,11 +6,17 @@
 #include "../rpcs3/Emu/Cell/PPUOpcodes.h"
 #include "../rpcs3/Emu/Cell/PPUAnalyser.h"
 
+class jit_compiler;
+
 class PPUTranslator final : public cpu_translator
 {
 	// PPU Module
 	const ppu_module& m_info;
 
+	// Host features (depend on LLVM CPU)
+	const bool m_use_ssse3;
+	const bool m_use_vbmi;
+
 	// Relevant relocations
 	std::map<u64, const ppu_reloc*> m_relocs;
 
@@ -47,6 +53,9 @@ class PPUTranslator final : public cpu_translator
 	// Callable functions
 	llvm::GlobalVariable* m_call;
 
+	// HLE function range (size << 32 | address)
+	llvm::GlobalVariable* m_hle;
+
 	// Main block
 	llvm::BasicBlock* m_body;
 	llvm::BasicBlock* m_entry;
@@ -282,6 +291,9 @@ public:
 	// Get memory pointer
 	llvm::Value* GetMemory(llvm::Value* addr, llvm::Type* type);
 
+	// Get the address of a RawSPU MMIO register accessed with the given type (0 if not a constant MMIO address)
+	u32 GetMmioAddr(llvm::Value* addr, llvm::Type* type);
+
 	// Read from memory
 	llvm::Value* ReadMemory(llvm::Value* addr, llvm::Type* type, bool is_be = true, u32 align = 1);
 
@@ -313,7 +325,7 @@ public:
 	// Handle compilation errors
 	void CompilationError(const std::string& error);
 
-	PPUTranslator(llvm::LLVMContext& context, llvm::Module* module, const ppu_module& info);
+	PPUTranslator(llvm::LLVMContext& context, llvm::Module* module, const ppu_module& info, const jit_compiler& jit);
 	~PPUTranslator();
 
 	// Get thread context struct type
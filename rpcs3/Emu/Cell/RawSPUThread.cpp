@@ -41,6 +41,34 @@ RawSPUThread::RawSPUThread(const std::string& name)
 {
 }
 
+u32 RawSPUThread::mmio_read32(u32 addr)
+{
+	u32 value;
+
+	if (const auto thread = idm::get<RawSPUThread>((addr - RAW_SPU_BASE_ADDR) / RAW_SPU_OFFSET))
+	{
+		if (thread->read_reg(addr, value))
+		{
+			return value;
+		}
+	}
+
+	fmt::throw_exception("Invalid RawSPU MMIO read (addr=0x%x)" HERE, addr);
+}
+
+void RawSPUThread::mmio_write32(u32 addr, u32 value)
+{
+	if (const auto thread = idm::get<RawSPUThread>((addr - RAW_SPU_BASE_ADDR) / RAW_SPU_OFFSET))
+	{
+		if (thread->write_reg(addr, value))
+		{
+			return;
+		}
+	}
+
+	fmt::throw_exception("Invalid RawSPU MMIO write (addr=0x%x, value=0x%x)" HERE, addr, value);
+}
+
 bool RawSPUThread::read_reg(const u32 addr, u32& value)
 {
 	const u32 offset = addr - RAW_SPU_BASE_ADDR - index * RAW_SPU_OFFSET - RAW_SPU_PROB_OFFSET;
@@ -297,7 +325,7 @@ void spu_load_exec(const spu_exec_object& elf)
 	{
 		if (prog.p_type == 0x1 /* LOAD */ && prog.p_memsz)
 		{
-			std::memcpy(vm::base(spu->offset + prog.p_vaddr), prog.bin.data(), prog.p_filesz);
+			std::memcpy(vm::base(spu->offset + prog.p_vaddr), prog.data(), prog.p_filesz);
 		}
 	}
 
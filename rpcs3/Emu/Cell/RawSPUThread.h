@@ -17,4 +17,14 @@ public:
 
 	bool read_reg(const u32 addr, u32& value);
 	bool write_reg(const u32 addr, const u32 value);
+
+	// Check if the address is in the problem state area of a RawSPU (not backed by memory)
+	static bool is_mmio(u32 addr)
+	{
+		return addr - RAW_SPU_BASE_ADDR < id_count * RAW_SPU_OFFSET && addr % RAW_SPU_OFFSET >= RAW_SPU_PROB_OFFSET;
+	}
+
+	// Direct 32-bit MMIO access for the PPU (instead of the access violation handler), throws on invalid access
+	static u32 mmio_read32(u32 addr);
+	static void mmio_write32(u32 addr, u32 value);
 };
@@ -2,6 +2,7 @@
 #include "Emu/Memory/Memory.h"
 #include "Emu/System.h"
 #include "Emu/IdManager.h"
+#include "Utilities/tracing.h"
 
 #include "SPUDisAsm.h"
 #include "SPUThread.h"
@@ -52,6 +53,74 @@ spu_runtime::spu_runtime()
 	m_map[std::vector<u32>()] = &spu_recompiler_base::dispatch;
 }
 
+void spu_tier_thread::on_task()
+{
+	// Keep the runtime alive
+	const auto spurt = fxm::get<spu_runtime>();
+
+	// LLVM recompiler instance (hot functions use the highest tier if upgrade is enabled)
+	const auto compiler = spu_recompiler_base::make_llvm_recompiler(false, true);
+	compiler->init();
+
+	// Fake LS
+	std::vector<be_t<u32>> ls(0x10000);
+
+	while (!Emu.IsStopped())
+	{
+		spu_runtime::tier_entry* entry;
+
+		if (!queue.try_pop(entry))
+		{
+			thread_ctrl::wait_for(10000);
+			continue;
+		}
+
+		const std::vector<u32>& func = *entry->func;
+		const u32 start = func[0] * (g_cfg.core.spu_block_size != spu_block_size_type::giga);
+
+		// Reuse the analyser results of the first tier, otherwise initialize LS with function data only and call analyser
+		const bool restored = compiler->restore(func);
+
+		if (!restored)
+		{
+			for (u32 i = 1, pos = start; i < func.size(); i++, pos += 4)
+			{
+				ls[pos / 4] = se_storage<u32>::swap(func[i]);
+			}
+
+			compiler->block(ls.data(), func[0]);
+		}
+
+		const auto fn = compiler->compile(std::vector<u32>(func));
+
+		for (u32 i = 1, pos = start; !restored && i < func.size(); i++, pos += 4)
+		{
+			ls[pos / 4] = 0;
+		}
+
+		// Redirect ASMJIT function and replace the dispatcher entry if it isn't a trampoline
+		entry->target = fn;
+		spurt->m_dispatcher[func[0] / 4].compare_and_swap_test(entry->fn, fn);
+
+		LOG_NOTICE(SPU, "[0x%05x] Tier-up: %p -> %p", func[0], entry->fn, fn);
+	}
+}
+
+void spu_recompiler::tier_up(SPUThread& spu, void*, u8* entry)
+{
+	const auto tier = reinterpret_cast<spu_runtime::tier_entry*>(entry);
+	const auto thread = fxm::get_always<spu_tier_thread>();
+
+	if (!thread->queue.try_push(tier))
+	{
+		// Queue is full, try again later
+		tier->counter = g_cfg.core.spu_tier_threshold;
+		return;
+	}
+
+	thread->notify();
+}
+
 spu_recompiler::spu_recompiler()
 {
 	if (!g_cfg.core.spu_shared_runtime)
@@ -67,6 +136,11 @@ void spu_recompiler::init()
 	{
 		m_cache = fxm::get<spu_cache>();
 		m_spurt = fxm::get_always<spu_runtime>();
+
+		if (g_cfg.core.spu_profiler)
+		{
+			m_profiler = fxm::get_always<spu_profiler>();
+		}
 	}
 }
 
@@ -82,6 +156,14 @@ spu_function_t spu_recompiler::compile(std::vector<u32>&& func_rv)
 {
 	init();
 
+	// Try to find existing function without locking
+	const u64 func_hash = spu_function_table::hash(func_rv);
+
+	if (const auto fn = m_spurt->m_table.find(func_hash, func_rv))
+	{
+		return fn;
+	}
+
 	// Don't lock without shared runtime
 	std::unique_lock<shared_mutex> lock(m_spurt->m_mutex, std::defer_lock);
 
@@ -93,6 +175,11 @@ spu_function_t spu_recompiler::compile(std::vector<u32>&& func_rv)
 	// Try to find existing function, register new one if necessary
 	const auto fn_info = m_spurt->m_map.emplace(std::move(func_rv), nullptr);
 
+	if (fn_info.second)
+	{
+		m_spurt->m_map_memory.add(fn_info.first->first.size() * 4);
+	}
+
 	auto& fn_location = fn_info.first->second;
 
 	if (fn_location)
@@ -102,6 +189,20 @@ spu_function_t spu_recompiler::compile(std::vector<u32>&& func_rv)
 
 	auto& func = fn_info.first->first;
 
+	tracing::scope trace(tracing::category::spu_jit, "SPU ASMJIT compile");
+	trace.set_arg("size", func.size() * 4 - 4);
+
+	spu_runtime::tier_entry* tier = nullptr;
+
+#ifdef LLVM_AVAILABLE
+	if (g_cfg.core.spu_tiered && g_cfg.core.spu_shared_runtime)
+	{
+		// Allocate tiered compilation info
+		m_spurt->m_tier.emplace_back();
+		tier = &m_spurt->m_tier.back();
+	}
+#endif
+
 	using namespace asmjit;
 
 	SPUDisAsm dis_asm(CPUDisAsm_InterpreterMode);
@@ -194,6 +295,23 @@ spu_function_t spu_recompiler::compile(std::vector<u32>&& func_rv)
 	c->cmp(SPU_OFF_32(state), 0);
 	c->jnz(label_stop);
 
+	if (tier)
+	{
+		// Jump to the LLVM function if it's already compiled
+		Label label_llvm = c->newLabel();
+		c->mov(x86::rax, imm_ptr(&tier->target));
+		c->mov(x86::rax, x86::qword_ptr(x86::rax));
+		c->test(x86::rax, x86::rax);
+		c->jnz(label_llvm);
+
+		after.emplace_back([=]
+		{
+			c->align(kAlignCode, 16);
+			c->bind(label_llvm);
+			c->jmp(x86::rax);
+		});
+	}
+
 	if (utils::has_avx())
 	{
 		// How to check dirty AVX state
@@ -219,6 +337,27 @@ spu_function_t spu_recompiler::compile(std::vector<u32>&& func_rv)
 		return result;
 	};
 
+	// Write tracking: skip the check if all lines are still tagged by this function
+	const bool track = g_cfg.core.spu_verification && g_cfg.core.spu_write_tracking && m_size > 8;
+	const u32 vtag = track ? make_tag() : 0;
+	const u32 line_beg = start / 128;
+	const u32 line_end = (end + 127) / 128;
+	Label label_verified = c->newLabel();
+
+	if (track)
+	{
+		Label label_verify = c->newLabel();
+
+		for (u32 i = line_beg; i < line_end; i++)
+		{
+			c->cmp(SPU_OFF_32(ls_owner, i), vtag);
+			c->jne(label_verify);
+		}
+
+		c->jmp(label_verified);
+		c->bind(label_verify);
+	}
+
 	// Check code
 	if (!g_cfg.core.spu_verification)
 	{
@@ -708,9 +847,63 @@ spu_function_t spu_recompiler::compile(std::vector<u32>&& func_rv)
 		c->vzeroupper();
 	}
 
+	if (track)
+	{
+		// Tag verified lines (except for RawSPU, its LS may be written directly)
+		c->cmp(SPU_OFF_32(offset), RAW_SPU_BASE_ADDR);
+		c->jae(label_verified);
+
+		for (u32 i = line_beg; i < line_end; i++)
+		{
+			c->mov(SPU_OFF_32(ls_owner, i), vtag);
+		}
+
+		c->bind(label_verified);
+	}
+
 	// Acknowledge success and add statistics
 	c->add(SPU_OFF_64(block_counter), ::size32(words) / (words_align / 4));
 
+	if (m_profiler)
+	{
+		// Attribute elapsed cycles to the previous function, count execution (rdx is preserved)
+		const auto prof = m_profiler->add(func);
+		Label label_first = c->newLabel();
+		c->mov(x86::r11, x86::rdx);
+		c->rdtsc();
+		c->shl(x86::rdx, 32);
+		c->or_(x86::rdx, x86::rax);
+		c->mov(x86::rax, SPU_OFF_64(prof_last));
+		c->test(x86::rax, x86::rax);
+		c->jz(label_first);
+		c->mov(x86::r10, x86::rdx);
+		c->sub(x86::r10, SPU_OFF_64(prof_tsc));
+		c->lock().add(x86::qword_ptr(x86::rax, offset32(&spu_profile_entry::cycles)), x86::r10);
+		c->bind(label_first);
+		c->mov(SPU_OFF_64(prof_tsc), x86::rdx);
+		c->mov(x86::rax, imm_ptr(prof));
+		c->mov(SPU_OFF_64(prof_last), x86::rax);
+		c->lock().inc(x86::qword_ptr(x86::rax, offset32(&spu_profile_entry::hits)));
+		c->mov(x86::rdx, x86::r11);
+	}
+
+	if (tier)
+	{
+		// Count executions and queue the function for LLVM when it becomes hot
+		Label label_tier = c->newLabel();
+		c->mov(x86::rax, imm_ptr(&tier->counter));
+		c->sub(x86::dword_ptr(x86::rax), 1);
+		c->jz(label_tier);
+
+		after.emplace_back([=]
+		{
+			c->align(kAlignCode, 16);
+			c->bind(label_tier);
+			c->mov(*qw0, imm_ptr(tier));
+			c->jmp(imm_ptr(&tier_up));
+		});
+	}
+
 	if (g_cfg.core.spu_block_size == spu_block_size_type::giga && m_pos != start)
 	{
 		// Jump to the entry point if necessary
@@ -868,6 +1061,13 @@ spu_function_t spu_recompiler::compile(std::vector<u32>&& func_rv)
 	// Register function
 	fn_location = fn;
 
+	if (tier)
+	{
+		tier->counter = g_cfg.core.spu_tier_threshold;
+		tier->fn = fn;
+		tier->func = &func;
+	}
+
 	if (g_cfg.core.spu_debug)
 	{
 		// Add ASMJIT logs
@@ -1117,6 +1317,9 @@ spu_function_t spu_recompiler::compile(std::vector<u32>&& func_rv)
 		m_spurt->m_dispatcher[func[0] / 4] = tr;
 	}
 
+	// Publish for lock-free lookup after the dispatcher is updated
+	m_spurt->m_table.add(func_hash, func, fn);
+
 	return fn;
 }
 
@@ -1428,9 +1631,13 @@ void spu_recompiler::get_events()
 		Label fail = c->newLabel();
 		c->bind(rcheck);
 		c->mov(qw1->r32(), *addr);
-		c->mov(*qw0, imm_ptr(vm::g_reservations));
 		c->shr(qw1->r32(), 4);
-		c->mov(*qw0, x86::qword_ptr(*qw0, *qw1));
+		c->mov(qw0->r32(), *addr);
+		c->shl(qw0->r32(), 2);
+		c->and_(qw0->r32(), 0xe00);
+		c->xor_(qw1->r32(), qw0->r32());
+		c->mov(*qw0, imm_ptr(vm::g_reservations));
+		c->mov(*qw0, x86::qword_ptr(*qw0, *qw1)); // vm::reservation_offset
 		c->cmp(*qw0, SPU_OFF_64(rtime));
 		c->jne(fail);
 		c->mov(*qw0, imm_ptr(vm::g_base_addr));
@@ -2908,6 +3115,13 @@ void spu_recompiler::STQX(spu_opcode_t op)
 		c->mov(asmjit::x86::qword_ptr(*ls, addr->r64(), 0, 0), *qw1);
 		c->mov(asmjit::x86::qword_ptr(*ls, addr->r64(), 0, 8), *qw0);
 	}
+
+	if (g_cfg.core.spu_verification && g_cfg.core.spu_write_tracking)
+	{
+		// Invalidate verified code
+		c->shr(*addr, 7);
+		c->mov(asmjit::x86::dword_ptr(*cpu, addr->r64(), 2, offset32(&SPUThread::ls_owner)), 0);
+	}
 }
 
 void spu_recompiler::BI(spu_opcode_t op)
@@ -4310,6 +4524,12 @@ void spu_recompiler::STQA(spu_opcode_t op)
 		c->mov(asmjit::x86::qword_ptr(*ls, spu_ls_target(0, op.i16) + 0), *qw1);
 		c->mov(asmjit::x86::qword_ptr(*ls, spu_ls_target(0, op.i16) + 8), *qw0);
 	}
+
+	if (g_cfg.core.spu_verification && g_cfg.core.spu_write_tracking)
+	{
+		// Invalidate verified code
+		c->mov(SPU_OFF_32(ls_owner, spu_ls_target(0, op.i16) / 128), 0);
+	}
 }
 
 void spu_recompiler::BRNZ(spu_opcode_t op)
@@ -4392,6 +4612,12 @@ void spu_recompiler::STQR(spu_opcode_t op)
 		c->mov(asmjit::x86::qword_ptr(*ls, spu_ls_target(m_pos, op.i16) + 0), *qw1);
 		c->mov(asmjit::x86::qword_ptr(*ls, spu_ls_target(m_pos, op.i16) + 8), *qw0);
 	}
+
+	if (g_cfg.core.spu_verification && g_cfg.core.spu_write_tracking)
+	{
+		// Invalidate verified code
+		c->mov(SPU_OFF_32(ls_owner, spu_ls_target(m_pos, op.i16) / 128), 0);
+	}
 }
 
 void spu_recompiler::BRA(spu_opcode_t op)
@@ -4622,6 +4848,13 @@ void spu_recompiler::STQD(spu_opcode_t op)
 		c->mov(asmjit::x86::qword_ptr(*ls, addr->r64(), 0, 0), *qw1);
 		c->mov(asmjit::x86::qword_ptr(*ls, addr->r64(), 0, 8), *qw0);
 	}
+
+	if (g_cfg.core.spu_verification && g_cfg.core.spu_write_tracking)
+	{
+		// Invalidate verified code
+		c->shr(*addr, 7);
+		c->mov(asmjit::x86::dword_ptr(*cpu, addr->r64(), 2, offset32(&SPUThread::ls_owner)), 0);
+	}
 }
 
 void spu_recompiler::LQD(spu_opcode_t op)
@@ -4879,6 +5112,23 @@ void spu_recompiler::SHUFB(spu_opcode_t op)
 		return;
 	}
 
+	if (utils::has_vbmi())
+	{
+		// Select from the 32-byte table directly, the constants for 0x80+ indices are looked up by the high nibble
+		const XmmLink& va = XmmGet(op.ra, XmmType::Int);
+		const XmmLink& vb = XmmGet(op.rb, XmmType::Int);
+		const XmmLink& vc = XmmGet(op.rc, XmmType::Int);
+		const XmmLink& vt = XmmAlloc();
+		const XmmLink& vm = XmmAlloc();
+		c->vpxor(vt, vc, XmmConst(_mm_set1_epi8(0xf)));
+		c->vpermi2b(vt, va, vb);
+		c->vpsrlw(vm, vc, 4);
+		c->vpermb(vm, vm, XmmConst(_mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, -1, -0x80, -0x80)));
+		c->vpblendvb(vt, vt, vm, vc);
+		c->movdqa(SPU_OFF_128(gpr, op.rt4), vt);
+		return;
+	}
+
 	if (!utils::has_ssse3())
 	{
 		return fall(op);
@@ -4960,6 +5210,13 @@ void spu_recompiler::FNMS(spu_opcode_t op)
 	c->andps(va, v1); // va = ra & ~ra_extended
 	c->andps(vb, v2); // vb = rb & ~rb_extended
 
+	if (utils::has_fma3())
+	{
+		c->vfnmadd213ps(va, vb, SPU_OFF_128(gpr, op.rc));
+		c->movaps(SPU_OFF_128(gpr, op.rt4), va);
+		return;
+	}
+
 	c->mulps(va, vb);
 	c->movaps(vb, SPU_OFF_128(gpr, op.rc));
 	c->subps(vb, va);
@@ -4983,6 +5240,14 @@ void spu_recompiler::FMA(spu_opcode_t op)
 	c->andps(va, v1); // va = ra & ~ra_extended
 	c->andps(vb, v2); // vb = rb & ~rb_extended
 
+	if (utils::has_fma3())
+	{
+		// Fused like the SPU and the precise interpreter
+		c->vfmadd213ps(va, vb, SPU_OFF_128(gpr, op.rc));
+		c->movaps(SPU_OFF_128(gpr, op.rt4), va);
+		return;
+	}
+
 	c->mulps(va, vb);
 	c->addps(va, SPU_OFF_128(gpr, op.rc));
 	c->movaps(SPU_OFF_128(gpr, op.rt4), va);
@@ -5005,6 +5270,13 @@ void spu_recompiler::FMS(spu_opcode_t op)
 	c->andps(va, v1); // va = ra & ~ra_extended
 	c->andps(vb, v2); // vb = rb & ~rb_extended
 
+	if (utils::has_fma3())
+	{
+		c->vfmsub213ps(va, vb, SPU_OFF_128(gpr, op.rc));
+		c->movaps(SPU_OFF_128(gpr, op.rt4), va);
+		return;
+	}
+
 	c->mulps(va, vb);
 	c->subps(va, SPU_OFF_128(gpr, op.rc));
 	c->movaps(SPU_OFF_128(gpr, op.rt4), va);
@@ -2,13 +2,35 @@
 
 #include "Utilities/JIT.h"
 #include "Utilities/mutex.h"
+#include "Utilities/lockless.h"
+#include "Utilities/VirtualMemory.h"
+#include "Utilities/Thread.h"
 #include "SPURecompiler.h"
 
 #include <functional>
+#include <deque>
 
 // SPU ASMJIT Runtime object (global)
 class spu_runtime
 {
+public:
+	// Tiered compilation info (one per ASMJIT function if enabled)
+	struct tier_entry
+	{
+		// Remaining executions before the function is queued for LLVM
+		u32 counter;
+
+		// ASMJIT function
+		spu_function_t fn{};
+
+		// LLVM function (set by the tier-up thread)
+		atomic_t<spu_function_t> target{};
+
+		// Function data (key in m_map)
+		const std::vector<u32>* func{};
+	};
+
+private:
 	shared_mutex m_mutex;
 
 	asmjit::JitRuntime m_jitrt;
@@ -16,18 +38,40 @@ class spu_runtime
 	// All functions
 	std::map<std::vector<u32>, spu_function_t> m_map;
 
+	// Lock-free lookup of the compiled functions in m_map
+	spu_function_table m_table;
+
 	// All dispatchers
 	std::array<atomic_t<spu_function_t>, 0x10000> m_dispatcher;
 
 	// Debug module output location
 	std::string m_cache_path;
 
+	// Tiered compilation info (stable addresses)
+	std::deque<tier_entry> m_tier;
+
+	// Host memory held by the function bodies in m_map
+	utils::memory_gauge m_map_memory{utils::memory_class::spu_functions};
+
 	friend class spu_recompiler;
+	friend class spu_tier_thread;
 
 public:
 	spu_runtime();
 };
 
+// SPU tier-up thread (recompiles hot ASMJIT functions with LLVM)
+class spu_tier_thread final : public named_thread
+{
+	std::string get_name() const override { return "SPU Tier-up Thread"; }
+
+	void on_task() override;
+
+public:
+	// Hot functions
+	lf_mpsc<spu_runtime::tier_entry*, 4096> queue;
+};
+
 // SPU ASMJIT Recompiler
 class spu_recompiler : public spu_recompiler_base
 {
@@ -42,6 +86,9 @@ public:
 
 	virtual spu_function_t compile(std::vector<u32>&&) override;
 
+	// Queue hot function for LLVM recompilation (third arg is spu_runtime::tier_entry*)
+	static void tier_up(SPUThread&, void*, u8* entry);
+
 private:
 	// emitter:
 	asmjit::X86Assembler* c;
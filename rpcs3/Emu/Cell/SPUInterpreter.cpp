@@ -454,7 +454,9 @@ bool spu_interpreter::STOPD(SPUThread& spu, spu_opcode_t op)
 
 bool spu_interpreter::STQX(SPUThread& spu, spu_opcode_t op)
 {
-	spu._ref<v128>((spu.gpr[op.ra]._u32[3] + spu.gpr[op.rb]._u32[3]) & 0x3fff0) = spu.gpr[op.rt];
+	const u32 lsa = (spu.gpr[op.ra]._u32[3] + spu.gpr[op.rb]._u32[3]) & 0x3fff0;
+	spu._ref<v128>(lsa) = spu.gpr[op.rt];
+	spu.ls_written(lsa, 16);
 	return true;
 }
 
@@ -1321,7 +1323,9 @@ bool spu_interpreter::BRZ(SPUThread& spu, spu_opcode_t op)
 
 bool spu_interpreter::STQA(SPUThread& spu, spu_opcode_t op)
 {
-	spu._ref<v128>(spu_ls_target(0, op.i16)) = spu.gpr[op.rt];
+	const u32 lsa = spu_ls_target(0, op.i16);
+	spu._ref<v128>(lsa) = spu.gpr[op.rt];
+	spu.ls_written(lsa, 16);
 	return true;
 }
 
@@ -1357,7 +1361,9 @@ bool spu_interpreter::BRHNZ(SPUThread& spu, spu_opcode_t op)
 
 bool spu_interpreter::STQR(SPUThread& spu, spu_opcode_t op)
 {
-	spu._ref<v128>(spu_ls_target(spu.pc, op.i16)) = spu.gpr[op.rt];
+	const u32 lsa = spu_ls_target(spu.pc, op.i16);
+	spu._ref<v128>(lsa) = spu.gpr[op.rt];
+	spu.ls_written(lsa, 16);
 	return true;
 }
 
@@ -1497,7 +1503,9 @@ bool spu_interpreter::AHI(SPUThread& spu, spu_opcode_t op)
 
 bool spu_interpreter::STQD(SPUThread& spu, spu_opcode_t op)
 {
-	spu._ref<v128>((spu.gpr[op.ra]._s32[3] + (op.si10 << 4)) & 0x3fff0) = spu.gpr[op.rt];
+	const u32 lsa = (spu.gpr[op.ra]._s32[3] + (op.si10 << 4)) & 0x3fff0;
+	spu._ref<v128>(lsa) = spu.gpr[op.rt];
+	spu.ls_written(lsa, 16);
 	return true;
 }
 
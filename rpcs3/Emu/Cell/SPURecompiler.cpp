@@ -4,6 +4,9 @@
 #include "Emu/Memory/Memory.h"
 #include "Crypto/sha1.h"
 #include "Utilities/StrUtil.h"
+#include "Utilities/tracing.h"
+#include "Utilities/perf_counters.h"
+#include "Utilities/hash.h"
 
 #include "SPUThread.h"
 #include "SPUAnalyser.h"
@@ -21,6 +24,167 @@ extern atomic_t<u64> g_progr_pdone;
 
 const spu_decoder<spu_itype> s_spu_itype;
 
+extern const spu_decoder<spu_interpreter_fast> g_spu_interpreter_fast;
+
+void spu_block_analysis::save(std::vector<u32>& out) const
+{
+	const u32 size = ::size32(func) - 1;
+
+	out.push_back(lsa);
+	out.push_back(::size32(blocks));
+	out.insert(out.end(), blocks.begin(), blocks.end());
+	out.push_back(::size32(entries));
+	out.insert(out.end(), entries.begin(), entries.end());
+
+	// Packed per-instruction data
+	const std::size_t pos = out.size();
+	out.resize(pos + (size + 3) / 4 + (size + 1) / 2);
+	std::memcpy(out.data() + pos, regmod.data(), size);
+	std::memcpy(out.data() + pos + (size + 3) / 4, entry_map.data(), size * 2);
+
+	for (const auto* list : {&targets, &preds})
+	{
+		out.push_back(::size32(*list));
+
+		for (const auto& pair : *list)
+		{
+			out.push_back(pair.first);
+			out.push_back(::size32(pair.second));
+			out.insert(out.end(), pair.second.begin(), pair.second.end());
+		}
+	}
+}
+
+bool spu_block_analysis::load(const u32* data, std::size_t size)
+{
+	const u32 count = ::size32(func) - 1;
+	const u32* const end = data + size;
+
+	if (size < 1 || data[0] % 4 || data[0] / 4 + count > 0x10000)
+	{
+		return false;
+	}
+
+	lsa = *data++;
+
+	// Read the count followed by the addresses (all of them must be valid LS addresses)
+	const auto read_list = [&](auto& list)
+	{
+		if (data == end || *data > std::size_t(end - data - 1))
+		{
+			return false;
+		}
+
+		const u32 n = *data++;
+		list.assign(data, data + n);
+		data += n;
+
+		return std::all_of(list.begin(), list.end(), [](u32 addr) { return addr < 0x40000 && addr % 4 == 0; });
+	};
+
+	if (!read_list(blocks) || !read_list(entries))
+	{
+		return false;
+	}
+
+	if (std::size_t(end - data) < (count + 3) / 4 + (count + 1) / 2)
+	{
+		return false;
+	}
+
+	regmod.resize(count);
+	entry_map.resize(count);
+	std::memcpy(regmod.data(), data, count);
+	std::memcpy(entry_map.data(), data + (count + 3) / 4, count * 2);
+	data += (count + 3) / 4 + (count + 1) / 2;
+
+	for (auto* list : {&targets, &preds})
+	{
+		if (data == end)
+		{
+			return false;
+		}
+
+		list->resize(*data++);
+
+		for (auto& pair : *list)
+		{
+			std::vector<u32> addrs;
+
+			if (data == end)
+			{
+				return false;
+			}
+
+			pair.first = *data++;
+
+			if (pair.first >= 0x40000 || !read_list(addrs))
+			{
+				return false;
+			}
+
+			pair.second.assign(addrs.begin(), addrs.end());
+		}
+	}
+
+	return data == end;
+}
+
+std::shared_ptr<const spu_block_analysis> spu_analysis_cache::find(const std::vector<u32>& func) const
+{
+	const u64 hash = spu_function_table::hash(func);
+
+	reader_lock lock(m_mutex);
+
+	for (auto range = m_funcs.equal_range(hash); range.first != range.second; range.first++)
+	{
+		if (range.first->second->func == func)
+		{
+			return range.first->second;
+		}
+	}
+
+	return nullptr;
+}
+
+std::shared_ptr<const spu_block_analysis> spu_analysis_cache::find(const rpcs3::hash128& image) const
+{
+	reader_lock lock(m_mutex);
+
+	const auto found = m_images.find(image.lo);
+
+	if (found != m_images.end() && found->second.first == image.hi)
+	{
+		return found->second.second;
+	}
+
+	return nullptr;
+}
+
+void spu_analysis_cache::add(const std::shared_ptr<const spu_block_analysis>& info, const rpcs3::hash128* image)
+{
+	const u64 hash = spu_function_table::hash(info->func);
+
+	writer_lock lock(m_mutex);
+
+	bool found = false;
+
+	for (auto range = m_funcs.equal_range(hash); range.first != range.second; range.first++)
+	{
+		found = found || range.first->second->func == info->func;
+	}
+
+	if (!found)
+	{
+		m_funcs.emplace(hash, info);
+	}
+
+	if (image)
+	{
+		m_images[image->lo] = std::make_pair(image->hi, info);
+	}
+}
+
 spu_cache::spu_cache(const std::string& loc)
 	: m_file(loc, fs::read + fs::write + fs::create)
 {
@@ -61,6 +225,37 @@ std::vector<std::vector<u32>> spu_cache::get()
 			break;
 		}
 
+		// Analyser results (may be absent)
+		be_t<u32> info_size;
+		std::vector<u32> info_data;
+
+		if (!m_file.read(info_size))
+		{
+			break;
+		}
+
+		info_data.resize(info_size);
+
+		if (m_file.read(info_data.data(), info_data.size() * 4) != info_data.size() * 4)
+		{
+			break;
+		}
+
+		if (info_size && size)
+		{
+			auto info = std::make_shared<spu_block_analysis>();
+			info->func = func;
+
+			if (info->load(info_data.data(), info_data.size()))
+			{
+				fxm::get_always<spu_analysis_cache>()->add(info);
+			}
+			else
+			{
+				LOG_ERROR(SPU, "[0x%05x] SPU cache: ignored corrupted analyser data", addr);
+			}
+		}
+
 		result.emplace_back(std::move(func));
 	}
 
@@ -74,11 +269,21 @@ void spu_cache::add(const std::vector<u32>& func)
 		return;
 	}
 
+	std::vector<u32> info_data;
+
+	if (const auto info = fxm::get_always<spu_analysis_cache>()->find(func))
+	{
+		info->save(info_data);
+	}
+
 	be_t<u32> size = ::size32(func) - 1;
 	be_t<u32> addr = func[0];
+	be_t<u32> info_size = ::size32(info_data);
 	m_file.write(size);
 	m_file.write(addr);
 	m_file.write(func.data() + 1, func.size() * 4 - 4);
+	m_file.write(info_size);
+	m_file.write(info_data.data(), info_data.size() * 4);
 }
 
 void spu_cache::initialize()
@@ -91,7 +296,7 @@ void spu_cache::initialize()
 	}
 
 	// SPU cache file (version + block size type)
-	const std::string loc = _main->cache + u8"spu-§" + fmt::to_lower(g_cfg.core.spu_block_size.to_string()) + "-v4.dat";
+	const std::string loc = _main->cache + u8"spu-§" + fmt::to_lower(g_cfg.core.spu_block_size.to_string()) + "-v5.dat";
 
 	auto cache = std::make_shared<spu_cache>(loc);
 
@@ -104,84 +309,152 @@ void spu_cache::initialize()
 	// Read cache
 	auto func_list = cache->get();
 
-	// Recompiler instance for cache initialization
-	std::unique_ptr<spu_recompiler_base> compiler;
+	// Recompiler instance factory for cache initialization
+	std::function<std::unique_ptr<spu_recompiler_base>(bool)> make_compiler;
 
 	if (g_cfg.core.spu_decoder == spu_decoder_type::asmjit)
 	{
-		compiler = spu_recompiler_base::make_asmjit_recompiler();
+		make_compiler = [](bool precompile) { return precompile ? nullptr : spu_recompiler_base::make_asmjit_recompiler(); };
 	}
 
 	if (g_cfg.core.spu_decoder == spu_decoder_type::llvm)
 	{
-		compiler = spu_recompiler_base::make_llvm_recompiler();
+		// Precompiler instances use private runtimes and only fill the object cache
+		make_compiler = [](bool precompile) { return precompile && !g_cfg.core.spu_cache ? nullptr : spu_recompiler_base::make_llvm_recompiler(precompile); };
 	}
 
-	if (compiler)
+	if (make_compiler)
 	{
-		compiler->init();
+		// Initialize shared runtime
+		make_compiler(false)->init();
 	}
 
-	if (compiler && !func_list.empty())
+	if (make_compiler && !func_list.empty())
 	{
-		// Fake LS
-		std::vector<be_t<u32>> ls(0x10000);
-
-		// Initialize progress dialog (wait for previous progress done)
-		while (g_progr_ptotal)
-		{
-			std::this_thread::sleep_for(5ms);
-		}
-
+		// Initialize progress dialog (shared with PPU compilation running at the same time)
 		g_progr = "Building SPU cache...";
 		g_progr_ptotal += func_list.size();
+		perf::spu_compile_queue.add(func_list.size());
+
+		// Initialize the number of worker threads
+		const u32 max_threads = static_cast<u32>(g_cfg.core.llvm_threads);
+		const u32 thread_count = std::max<u32>(max_threads > 0 ? std::min(max_threads, std::thread::hardware_concurrency()) : std::thread::hardware_concurrency(), 1);
+
+		// Next function to build
+		atomic_t<std::size_t> fnext{0};
 
 		// Build functions
-		for (auto&& func : func_list)
+		const auto worker = [&]()
 		{
-			if (Emu.IsStopped())
-			{
-				g_progr_pdone++;
-				continue;
-			}
+			// Set low priority, away from the emulation threads
+			thread_ctrl::set_native_priority(-1);
+			thread_ctrl::set_thread_affinity_mask(thread_ctrl::get_affinity_mask(thread_class::llvm));
+
+			// Compiler instance (shared runtime) and optional precompiler instance (private runtime)
+			const auto compiler = make_compiler(false);
+			const auto precompiler = make_compiler(true);
 
-			// Get data start
-			const u32 start = func[0] * (g_cfg.core.spu_block_size != spu_block_size_type::giga);
-			const u32 size0 = ::size32(func);
+			compiler->init();
 
-			// Initialize LS with function data only
-			for (u32 i = 1, pos = start; i < size0; i++, pos += 4)
+			if (precompiler)
 			{
-				ls[pos / 4] = se_storage<u32>::swap(func[i]);
+				precompiler->init();
 			}
 
-			// Call analyser
-			std::vector<u32> func2 = compiler->block(ls.data(), func[0]);
+			// Fake LS
+			std::vector<be_t<u32>> ls(0x10000);
 
-			if (func2.size() != size0)
+			for (std::size_t fi = fnext++; fi < func_list.size(); fi = fnext++)
 			{
-				LOG_ERROR(SPU, "[0x%05x] SPU Analyser failed, %u vs %u", func2[0], func2.size() - 1, size0 - 1);
-			}
+				auto& func = func_list[fi];
 
-			compiler->compile(std::move(func));
+				if (Emu.IsStopped())
+				{
+					g_progr_pdone++;
+					perf::spu_compile_queue.sub();
+					continue;
+				}
 
-			// Clear fake LS
-			for (u32 i = 1, pos = start; i < func2.size(); i++, pos += 4)
-			{
-				if (se_storage<u32>::swap(func2[i]) != ls[pos / 4])
+				// Get data start
+				const u32 start = func[0] * (g_cfg.core.spu_block_size != spu_block_size_type::giga);
+				const u32 size0 = ::size32(func);
+
+				// Analyser results stored with the function make the fake LS unnecessary
+				if (compiler->restore(func))
 				{
-					LOG_ERROR(SPU, "[0x%05x] SPU Analyser failed at 0x%x", func2[0], pos);
+					if (precompiler)
+					{
+						verify(HERE), precompiler->restore(func);
+						precompiler->compile(std::vector<u32>(func));
+					}
+
+					compiler->compile(std::move(func));
+					perf::spu_functions_compiled.add();
+					g_progr_pdone++;
+					perf::spu_compile_queue.sub();
+					continue;
 				}
 
-				ls[pos / 4] = 0;
-			}
+				// Initialize LS with function data only
+				for (u32 i = 1, pos = start; i < size0; i++, pos += 4)
+				{
+					ls[pos / 4] = se_storage<u32>::swap(func[i]);
+				}
 
-			if (func2.size() != size0)
-			{
-				std::memset(ls.data(), 0, 0x40000);
+				// Call analyser
+				std::vector<u32> func2 = compiler->block(ls.data(), func[0]);
+
+				if (func2.size() != size0)
+				{
+					LOG_ERROR(SPU, "[0x%05x] SPU Analyser failed, %u vs %u", func2[0], func2.size() - 1, size0 - 1);
+				}
+
+				if (precompiler)
+				{
+					// Generate the object file without holding the shared runtime (analyser state is per instance)
+					if (!precompiler->restore(func))
+					{
+						precompiler->block(ls.data(), func[0]);
+					}
+
+					precompiler->compile(std::vector<u32>(func));
+				}
+
+				compiler->compile(std::move(func));
+				perf::spu_functions_compiled.add();
+
+				// Clear fake LS
+				for (u32 i = 1, pos = start; i < func2.size(); i++, pos += 4)
+				{
+					if (se_storage<u32>::swap(func2[i]) != ls[pos / 4])
+					{
+						LOG_ERROR(SPU, "[0x%05x] SPU Analyser failed at 0x%x", func2[0], pos);
+					}
+
+					ls[pos / 4] = 0;
+				}
+
+				if (func2.size() != size0)
+				{
+					std::memset(ls.data(), 0, 0x40000);
+				}
+
+				g_progr_pdone++;
+				perf::spu_compile_queue.sub();
 			}
+		};
+
+		std::vector<std::thread> workers;
+		workers.reserve(thread_count);
 
-			g_progr_pdone++;
+		for (u32 i = 0; i < thread_count; i++)
+		{
+			workers.emplace_back(worker);
+		}
+
+		for (auto& thread : workers)
+		{
+			thread.join();
 		}
 
 		if (Emu.IsStopped())
@@ -190,7 +463,7 @@ void spu_cache::initialize()
 			return;
 		}
 
-		LOG_SUCCESS(SPU, "SPU Runtime: Built %u functions.", func_list.size());
+		LOG_SUCCESS(SPU, "SPU Runtime: Built %u functions (%u threads).", func_list.size(), thread_count);
 	}
 
 	// Register cache instance
@@ -200,6 +473,127 @@ void spu_cache::initialize()
 	});
 }
 
+u64 spu_function_table::hash(const std::vector<u32>& func)
+{
+	// Whole function data (including the start address)
+	return rpcs3::hash64(func.data(), func.size() * 4);
+}
+
+spu_function_t spu_function_table::find(u64 hash, const std::vector<u32>& func) const
+{
+	for (const entry* e = m_buckets[hash % m_buckets.size()].load(); e; e = e->next)
+	{
+		if (e->hash == hash && *e->func == func)
+		{
+			return e->fn;
+		}
+	}
+
+	return nullptr;
+}
+
+void spu_function_table::add(u64 hash, const std::vector<u32>& func, spu_function_t fn)
+{
+	auto& head = m_buckets[hash % m_buckets.size()];
+
+	m_entries.push_back({hash, &func, fn, head.load()});
+
+	// Publish fully initialized entry
+	head.store(&m_entries.back());
+}
+
+spu_profiler::spu_profiler()
+{
+	// Report is written next to spu.log
+	m_path = fxm::check_unlocked<ppu_module>()->cache;
+}
+
+spu_profiler::~spu_profiler()
+{
+	std::string out;
+	dump(out, SIZE_MAX);
+
+	if (fs::file(m_path + "spu_profile.log", fs::rewrite).write(out))
+	{
+		LOG_SUCCESS(SPU, "SPU Profiler: report written to %sspu_profile.log", m_path);
+	}
+}
+
+spu_profile_entry* spu_profiler::add(const std::vector<u32>& func)
+{
+	std::string hash;
+	{
+		sha1_context ctx;
+		u8 output[20];
+
+		sha1_starts(&ctx);
+		sha1_update(&ctx, reinterpret_cast<const u8*>(func.data() + 1), func.size() * 4 - 4);
+		sha1_finish(&ctx, output);
+
+		fmt::append(hash, "spu-0x%05x-%s", func[0], fmt::base57(output));
+	}
+
+	writer_lock lock(m_mutex);
+
+	auto& found = m_map[hash];
+
+	if (!found)
+	{
+		m_entries.emplace_back();
+		found = &m_entries.back();
+		found->addr = func[0];
+		found->size = ::size32(func) - 1;
+		found->hash = std::move(hash);
+	}
+
+	return found;
+}
+
+void spu_profiler::dump(std::string& out, std::size_t max) const
+{
+	std::vector<const spu_profile_entry*> list;
+	u64 total = 0;
+	{
+		reader_lock lock(m_mutex);
+
+		list.reserve(m_entries.size());
+
+		for (auto& e : m_entries)
+		{
+			list.emplace_back(&e);
+			total += e.cycles;
+		}
+	}
+
+	std::sort(list.begin(), list.end(), [](const spu_profile_entry* a, const spu_profile_entry* b)
+	{
+		return a->cycles > b->cycles;
+	});
+
+	fmt::append(out, "SPU Profiler: %u functions, %u cycles", list.size(), total);
+
+	for (std::size_t i = 0; i < list.size() && i < max; i++)
+	{
+		const auto e = list[i];
+		const u64 cycles = e->cycles;
+		fmt::append(out, "\n[0x%05x] %5.2f%% Cycles: %u; Hits: %u; Size: %u (%s)", e->addr, total ? cycles * 100. / total : 0., cycles, e->hits.load(), e->size, e->hash);
+	}
+}
+
+void spu_profiler::enter(SPUThread& spu, spu_profile_entry* entry)
+{
+	const u64 stamp = __rdtsc();
+
+	if (const auto last = spu.prof_last)
+	{
+		last->cycles += stamp - spu.prof_tsc;
+	}
+
+	spu.prof_last = entry;
+	spu.prof_tsc = stamp;
+	entry->hits++;
+}
+
 spu_recompiler_base::spu_recompiler_base()
 {
 }
@@ -208,6 +602,19 @@ spu_recompiler_base::~spu_recompiler_base()
 {
 }
 
+u32 spu_recompiler_base::make_tag()
+{
+	static atomic_t<u32> s_tag{0};
+
+	while (true)
+	{
+		if (const u32 tag = s_tag.fetch_add(1) + 1)
+		{
+			return tag;
+		}
+	}
+}
+
 void spu_recompiler_base::dispatch(SPUThread& spu, void*, u8* rip)
 {
 	// If code verification failed from a patched patchpoint, clear it with a single NOP
@@ -237,7 +644,10 @@ void spu_recompiler_base::dispatch(SPUThread& spu, void*, u8* rip)
 	}
 
 	// Compile
+	perf::spu_compile_queue.add();
 	verify(HERE), spu.jit->compile(spu.jit->block(spu._ptr<u32>(0), spu.pc));
+	perf::spu_compile_queue.sub();
+	perf::spu_functions_compiled.add();
 	spu.jit_dispatcher[spu.pc / 4] = spu.jit->get(spu.pc);
 
 	// Diagnostic
@@ -255,7 +665,10 @@ void spu_recompiler_base::dispatch(SPUThread& spu, void*, u8* rip)
 void spu_recompiler_base::branch(SPUThread& spu, void*, u8* rip)
 {
 	// Compile (TODO: optimize search of the existing functions)
+	perf::spu_compile_queue.add();
 	const auto func = verify(HERE, spu.jit->compile(spu.jit->block(spu._ptr<u32>(0), spu.pc)));
+	perf::spu_compile_queue.sub();
+	perf::spu_functions_compiled.add();
 	spu.jit_dispatcher[spu.pc / 4] = spu.jit->get(spu.pc);
 
 	// Overwrite jump to this function with jump to the compiled function
@@ -296,8 +709,93 @@ void spu_recompiler_base::branch(SPUThread& spu, void*, u8* rip)
 #endif
 }
 
+bool spu_recompiler_base::restore(const std::vector<u32>& func)
+{
+	if (!m_analysis)
+	{
+		m_analysis = fxm::get_always<spu_analysis_cache>();
+	}
+
+	if (const auto info = m_analysis->find(func))
+	{
+		load_analysis(*info);
+		return true;
+	}
+
+	return false;
+}
+
+std::shared_ptr<const spu_block_analysis> spu_recompiler_base::save_analysis(std::vector<u32>&& func, u32 lsa) const
+{
+	const u32 start = lsa / 4;
+	const u32 size = ::size32(func) - 1;
+
+	auto info = std::make_shared<spu_block_analysis>();
+	info->func = std::move(func);
+	info->lsa = lsa;
+	info->regmod.assign(m_regmod.begin() + start, m_regmod.begin() + start + size);
+	info->entry_map.assign(m_entry_map.begin() + start, m_entry_map.begin() + start + size);
+
+	for (u32 i = start; i < start + size; i++)
+	{
+		if (m_block_info[i])
+			info->blocks.push_back(i * 4);
+		if (m_entry_info[i])
+			info->entries.push_back(i * 4);
+	}
+
+	info->targets.assign(m_targets.begin(), m_targets.end());
+	info->preds.assign(m_preds.begin(), m_preds.end());
+	return info;
+}
+
+void spu_recompiler_base::load_analysis(const spu_block_analysis& info)
+{
+	m_block_info.reset();
+	m_entry_info.reset();
+	std::memset(m_regmod.data(), 0xff, sizeof(m_regmod));
+	std::memset(m_entry_map.data(), 0, sizeof(m_entry_map));
+	std::copy(info.regmod.begin(), info.regmod.end(), m_regmod.begin() + info.lsa / 4);
+	std::copy(info.entry_map.begin(), info.entry_map.end(), m_entry_map.begin() + info.lsa / 4);
+
+	for (u32 addr : info.blocks)
+	{
+		m_block_info.set(addr / 4);
+	}
+
+	for (u32 addr : info.entries)
+	{
+		m_entry_info.set(addr / 4);
+	}
+
+	m_targets.clear();
+	m_targets.insert(info.targets.begin(), info.targets.end());
+	m_preds.clear();
+	m_preds.insert(info.preds.begin(), info.preds.end());
+}
+
 std::vector<u32> spu_recompiler_base::block(const be_t<u32>* ls, u32 entry_point)
 {
+	if (!m_analysis)
+	{
+		m_analysis = fxm::get_always<spu_analysis_cache>();
+	}
+
+	// Giga mode analyses the whole LS, which costs more than hashing it to find the same image analysed before
+	const bool giga = g_cfg.core.spu_block_size == spu_block_size_type::giga;
+	rpcs3::hash128 image{};
+
+	if (giga)
+	{
+		image = rpcs3::hash128_of(ls, 0x40000, entry_point);
+
+		if (const auto info = m_analysis->find(image))
+		{
+			load_analysis(*info);
+			return info->func;
+		}
+	}
+
 	// Result: addr + raw instruction data
 	std::vector<u32> result;
 	result.reserve(256);
@@ -1280,6 +1778,18 @@ std::vector<u32> spu_recompiler_base::block(const be_t<u32>* ls, u32 entry_point
 		// Blocks starting from 0x0 or invalid instruction won't be compiled, may need special interpreter fallback
 		result.clear();
 	}
+	else
+	{
+		// Share the result with other instances and with the SPU cache
+		auto info = m_analysis->find(result);
+
+		if (!info)
+		{
+			info = save_analysis(std::vector<u32>(result), lsa);
+		}
+
+		m_analysis->add(info, giga ? &image : nullptr);
+	}
 
 	return result;
 }
@@ -1328,28 +1838,45 @@ void spu_recompiler_base::dump(std::string& out)
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/Vectorize.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Target/TargetMachine.h"
 #include "Utilities/JIT.h"
 
+static lock_class s_spu_llvm_lock_class{"spu_llvm_runtime", 20};
+
 class spu_llvm_runtime
 {
-	shared_mutex m_mutex;
+	shared_mutex m_mutex{s_spu_llvm_lock_class};
 
 	// All functions
 	std::map<std::vector<u32>, spu_function_t> m_map;
 
+	// Lock-free lookup of the compiled functions in m_map
+	spu_function_table m_table;
+
 	// All dispatchers
 	std::array<atomic_t<spu_function_t>, 0x10000> m_dispatcher;
 
-	// JIT instance
-	jit_compiler m_jit{{}, jit_compiler::cpu(g_cfg.core.llvm_cpu)};
+	// JIT instance (large code model: external symbols are resolved by name, see spu_llvm_recompiler::call)
+	jit_compiler m_jit{{}, jit_compiler::cpu(g_cfg.core.llvm_cpu), true};
 
-	// Debug module output location
+	// Module output location
 	std::string m_cache_path;
 
+	// Object cache location (per title or global, objects are named by the content hash)
+	std::string m_obj_path;
+
+	// Verified code tags (write tracking, referenced by name from the compiled code)
+	std::deque<u32> m_tags;
+
+	// Host memory held by the function bodies in m_map
+	utils::memory_gauge m_map_memory{utils::memory_class::spu_functions};
+
 	friend class spu_llvm_recompiler;
 
 public:
-	spu_llvm_runtime()
+	spu_llvm_runtime(bool primary = true)
 	{
 		// Initialize lookup table
 		for (auto& v : m_dispatcher)
@@ -1360,10 +1887,21 @@ public:
 		// Initialize "empty" block
 		m_map[std::vector<u32>()] = &spu_recompiler_base::dispatch;
 
-		// Clear LLVM output
+		// Initialize object cache location (compiled functions are kept between runs)
 		m_cache_path = fxm::check_unlocked<ppu_module>()->cache;
-		fs::create_dir(m_cache_path + "llvm/");
-		fs::remove_all(m_cache_path + "llvm/", false);
+		m_obj_path = g_cfg.core.spu_global_cache ? fs::get_config_dir() + "data/spu/llvm/" : m_cache_path + "llvm/";
+		fs::create_path(m_obj_path);
+
+		if (!primary)
+		{
+			// Private runtime (no cleanup)
+			return;
+		}
+
+		if (!g_cfg.core.spu_cache && !g_cfg.core.spu_global_cache)
+		{
+			fs::remove_all(m_obj_path, false);
+		}
 
 		if (g_cfg.core.spu_debug)
 		{
@@ -1715,37 +2253,50 @@ class spu_llvm_recompiler : public spu_recompiler_base, public cpu_translator
 		m_ir->CreateStore(m_ir->getInt32(m_pos), spu_ptr<u32>(&SPUThread::pc));
 	}
 
+	// Branch weights for state checks: the state is almost always clear, so the call path is moved out of the hot code
+	llvm::MDNode* get_md_likely()
+	{
+		const auto md_name = llvm::MDString::get(m_context, "branch_weights");
+		const auto md_low = llvm::ValueAsMetadata::get(m_ir->getInt32(1));
+		const auto md_high = llvm::ValueAsMetadata::get(m_ir->getInt32(666));
+		return llvm::MDTuple::get(m_context, {md_name, md_high, md_low});
+	}
+
+	// Test the state with a plain volatile load (can't be hoisted out of loops), the atomic accesses only happen in check_state
+	llvm::Value* is_state_clear()
+	{
+		return m_ir->CreateICmpEQ(m_ir->CreateLoad(spu_ptr<u32>(&SPUThread::state), true), m_ir->getInt32(0));
+	}
+
 	// Call cpu_thread::check_state if necessary and return or continue (full check)
 	void check_state(u32 addr)
 	{
-		const auto pstate = spu_ptr<u32>(&SPUThread::state);
 		const auto _body = llvm::BasicBlock::Create(m_context, "", m_function);
 		const auto check = llvm::BasicBlock::Create(m_context, "", m_function);
 		const auto stop  = llvm::BasicBlock::Create(m_context, "", m_function);
-		m_ir->CreateCondBr(m_ir->CreateICmpEQ(m_ir->CreateLoad(pstate), m_ir->getInt32(0)), _body, check);
+		m_ir->CreateCondBr(is_state_clear(), _body, check, get_md_likely());
 		m_ir->SetInsertPoint(check);
 		m_ir->CreateStore(m_ir->getInt32(addr), spu_ptr<u32>(&SPUThread::pc));
-		m_ir->CreateCondBr(call(&exec_check_state, m_thread), stop, _body);
+		m_ir->CreateCondBr(call("spu_check_state", &exec_check_state, m_thread), stop, _body);
 		m_ir->SetInsertPoint(stop);
 		m_ir->CreateRetVoid();
 		m_ir->SetInsertPoint(_body);
 	}
 
-	// Perform external call
+	// Perform external call (by symbol name registered in init(), so that the object can be cached)
 	template <typename RT, typename... FArgs, typename... Args>
-	llvm::CallInst* call(RT(*_func)(FArgs...), Args... args)
+	llvm::CallInst* call(const char* name, RT(*)(FArgs...), Args... args)
 	{
 		static_assert(sizeof...(FArgs) == sizeof...(Args), "spu_llvm_recompiler::call(): unexpected arg number");
-		const auto iptr = reinterpret_cast<std::uintptr_t>(_func);
-		const auto type = llvm::FunctionType::get(get_type<RT>(), {args->getType()...}, false)->getPointerTo();
-		return m_ir->CreateCall(m_ir->CreateIntToPtr(m_ir->getInt64(iptr), type), {args...});
+		const auto type = llvm::FunctionType::get(get_type<RT>(), {args->getType()...}, false);
+		return m_ir->CreateCall(m_module->getOrInsertFunction(name, type), {args...});
 	}
 
 	// Perform external call and return
 	template <typename RT, typename... FArgs, typename... Args>
-	void tail(RT(*_func)(FArgs...), Args... args)
+	void tail(const char* name, RT(*_func)(FArgs...), Args... args)
 	{
-		const auto inst = call(_func, args...);
+		const auto inst = call(name, _func, args...);
 		inst->setTailCall();
 
 		if (inst->getType() == get_type<void>())
@@ -1794,10 +2345,18 @@ class spu_llvm_recompiler : public spu_recompiler_base, public cpu_translator
 		return result;
 	}
 
+	// Only generate the object files (private runtime)
+	const bool m_precompile;
+
+	// Optimization tier
+	const llvm_opt_tier m_tier;
+
 public:
-	spu_llvm_recompiler()
+	spu_llvm_recompiler(bool precompile, bool upgrade)
 		: spu_recompiler_base()
 		, cpu_translator(nullptr, false)
+		, m_precompile(precompile)
+		, m_tier(g_cfg.core.llvm_tier != llvm_opt_tier::upgrade ? g_cfg.core.llvm_tier.get() : upgrade ? llvm_opt_tier::full : llvm_opt_tier::fast)
 	{
 		if (g_cfg.core.spu_shared_runtime)
 		{
@@ -1811,9 +2370,36 @@ public:
 		// Initialize if necessary
 		if (!m_spurt)
 		{
-			m_cache = fxm::get<spu_cache>();
-			m_spurt = fxm::get_always<spu_llvm_runtime>();
+			if (m_precompile)
+			{
+				m_spurt = std::make_shared<spu_llvm_runtime>(false);
+			}
+			else
+			{
+				m_cache = fxm::get<spu_cache>();
+				m_spurt = fxm::get_always<spu_llvm_runtime>();
+			}
+
+			if (g_cfg.core.spu_profiler)
+			{
+				m_profiler = fxm::get_always<spu_profiler>();
+			}
+
 			m_context = m_spurt->m_jit.get_context();
+
+			// Register external symbols (must be available before loading cached objects)
+			auto& engine = m_spurt->m_jit.get_engine();
+			engine.updateGlobalMapping("spu_dispatch", reinterpret_cast<u64>(&spu_recompiler_base::dispatch));
+			engine.updateGlobalMapping("spu_check_state", reinterpret_cast<u64>(&exec_check_state));
+			engine.updateGlobalMapping("spu_fall", reinterpret_cast<u64>(&exec_fall));
+			engine.updateGlobalMapping("spu_unknown", reinterpret_cast<u64>(&exec_unk));
+			engine.updateGlobalMapping("spu_stop", reinterpret_cast<u64>(&exec_stop));
+			engine.updateGlobalMapping("spu_rdch", reinterpret_cast<u64>(&exec_rdch));
+			engine.updateGlobalMapping("spu_rchcnt", reinterpret_cast<u64>(&exec_rchcnt));
+			engine.updateGlobalMapping("spu_wrch", reinterpret_cast<u64>(&exec_wrch));
+			engine.updateGlobalMapping("spu_check_interrupts", reinterpret_cast<u64>(&exec_check_interrupts));
+			engine.updateGlobalMapping("spu_halt_addr", reinterpret_cast<u64>(vm::base(0xffdead00)));
+			engine.updateGlobalMapping("spu_profile", reinterpret_cast<u64>(&exec_profile));
 		}
 	}
 
@@ -1829,6 +2415,14 @@ public:
 	{
 		init();
 
+		// Try to find existing function without locking
+		const u64 func_hash = spu_function_table::hash(func_rv);
+
+		if (const auto fn = m_spurt->m_table.find(func_hash, func_rv))
+		{
+			return fn;
+		}
+
 		// Don't lock without shared runtime
 		std::unique_lock<shared_mutex> lock(m_spurt->m_mutex, std::defer_lock);
 
@@ -1840,6 +2434,11 @@ public:
 		// Try to find existing function, register new one if necessary
 		const auto fn_info = m_spurt->m_map.emplace(std::move(func_rv), nullptr);
 
+		if (fn_info.second)
+		{
+			m_spurt->m_map_memory.add(fn_info.first->first.size() * 4);
+		}
+
 		auto& fn_location = fn_info.first->second;
 
 		if (fn_location)
@@ -1849,6 +2448,9 @@ public:
 
 		auto& func = fn_info.first->first;
 
+		tracing::scope trace(tracing::category::spu_jit, "SPU LLVM compile");
+		trace.set_arg("size", func.size() * 4 - 4);
+
 		std::string hash;
 		{
 			sha1_context ctx;
@@ -1861,6 +2463,41 @@ public:
 			fmt::append(hash, "spu-0x%05x-%s", func[0], fmt::base57(output));
 		}
 
+		// Object file name (also depends on the settings affecting code generation)
+		const bool track = g_cfg.core.spu_verification && g_cfg.core.spu_write_tracking;
+		const char* const tier = m_tier == llvm_opt_tier::fast ? "-O1" : m_tier == llvm_opt_tier::full ? "-O3" : "";
+		const std::string obj_name = fmt::format("%s-%s-%s%s%s%s%s.obj", hash, fmt::to_lower(g_cfg.core.spu_block_size.to_string()), jit_compiler::cpu(g_cfg.core.llvm_cpu), g_cfg.core.spu_verification ? "" : "-nv", track ? "-wt" : "", m_profiler ? "-prof" : "", tier);
+
+		if (track)
+		{
+			// Verified code tag is referenced by name (must be mapped before loading cached objects)
+			m_spurt->m_tags.push_back(make_tag());
+			m_spurt->m_jit.get_engine().updateGlobalMapping(hash + "-vtag", reinterpret_cast<u64>(&m_spurt->m_tags.back()));
+		}
+
+		if (m_profiler)
+		{
+			// Profiler statistics are referenced by name (must be mapped before loading cached objects)
+			m_spurt->m_jit.get_engine().updateGlobalMapping(hash + "-prof", reinterpret_cast<u64>(m_profiler->add(func)));
+		}
+
+		if (g_cfg.core.spu_cache && fs::is_file(m_spurt->m_obj_path + obj_name))
+		{
+			if (m_precompile)
+			{
+				// Nothing to do
+				return nullptr;
+			}
+
+			// Load compiled function from the object cache
+			m_spurt->m_jit.add(m_spurt->m_obj_path + obj_name);
+			m_spurt->m_jit.fin();
+
+			const auto fn = verify(HERE, reinterpret_cast<spu_function_t>(m_spurt->m_jit.get(hash)));
+			LOG_NOTICE(SPU, "LLVM: Loaded %s", obj_name);
+			return finalize(func_hash, func, fn_location, fn);
+		}
+
 		if (m_cache)
 		{
 			LOG_SUCCESS(SPU, "LLVM: Building %s (size %u)...", hash, func.size() - 1);
@@ -1917,7 +2554,7 @@ public:
 		using namespace llvm;
 
 		// Create LLVM module
-		std::unique_ptr<Module> module = std::make_unique<Module>(hash + ".obj", m_context);
+		std::unique_ptr<Module> module = std::make_unique<Module>(obj_name, m_context);
 		module->setTargetTriple(Triple::normalize(sys::getProcessTriple()));
 		m_module = module.get();
 
@@ -1939,27 +2576,50 @@ public:
 		const auto label_stop = BasicBlock::Create(m_context, "", m_function);
 
 		// Emit state check
-		const auto pstate = spu_ptr<u32>(&SPUThread::state);
-		m_ir->CreateCondBr(m_ir->CreateICmpNE(m_ir->CreateLoad(pstate), m_ir->getInt32(0)), label_stop, label_test);
+		m_ir->CreateCondBr(is_state_clear(), label_test, label_stop, get_md_likely());
 
 		// Emit code check
 		u32 check_iterations = 0;
 		m_ir->SetInsertPoint(label_test);
 
+		// Write tracking: skip the check if all lines are still tagged by this function
+		const bool track_lines = track && func.size() - 1 > 2;
+		const u32 line_beg = start / 128;
+		const u32 line_end = (end + 127) / 128;
+		const auto label_pass = track_lines ? BasicBlock::Create(m_context, "", m_function) : label_body;
+		llvm::Value* vtag = nullptr;
+
+		if (track_lines)
+		{
+			const auto label_verify = BasicBlock::Create(m_context, "", m_function);
+			vtag = m_ir->CreateLoad(m_module->getOrInsertGlobal(hash + "-vtag", get_type<u32>()));
+
+			llvm::Value* acc = nullptr;
+
+			for (u32 i = line_beg; i < line_end; i++)
+			{
+				const auto diff = m_ir->CreateXor(m_ir->CreateLoad(spu_ptr<u32>(&SPUThread::ls_owner, i)), vtag);
+				acc = acc ? m_ir->CreateOr(acc, diff) : diff;
+			}
+
+			m_ir->CreateCondBr(m_ir->CreateICmpEQ(acc, m_ir->getInt32(0)), label_body, label_verify);
+			m_ir->SetInsertPoint(label_verify);
+		}
+
 		if (!g_cfg.core.spu_verification)
 		{
 			// Disable check (unsafe)
-			m_ir->CreateBr(label_body);
+			m_ir->CreateBr(label_pass);
 		}
 		else if (func.size() - 1 == 1)
 		{
 			const auto cond = m_ir->CreateICmpNE(m_ir->CreateLoad(_ptr<u32>(m_lsptr, start)), m_ir->getInt32(func[1]));
-			m_ir->CreateCondBr(cond, label_diff, label_body);
+			m_ir->CreateCondBr(cond, label_diff, label_pass);
 		}
 		else if (func.size() - 1 == 2)
 		{
 			const auto cond = m_ir->CreateICmpNE(m_ir->CreateLoad(_ptr<u64>(m_lsptr, start)), m_ir->getInt64(static_cast<u64>(func[2]) << 32 | func[1]));
-			m_ir->CreateCondBr(cond, label_diff, label_body);
+			m_ir->CreateCondBr(cond, label_diff, label_pass);
 		}
 		else
 		{
@@ -2030,7 +2690,23 @@ public:
 
 			// Compare result with zero
 			const auto cond = m_ir->CreateICmpNE(elem, m_ir->getInt64(0));
-			m_ir->CreateCondBr(cond, label_diff, label_body);
+			m_ir->CreateCondBr(cond, label_diff, label_pass);
+		}
+
+		if (track_lines)
+		{
+			// Tag verified lines (except for RawSPU, its LS may be written directly)
+			const auto label_tag = BasicBlock::Create(m_context, "", m_function);
+			m_ir->SetInsertPoint(label_pass);
+			m_ir->CreateCondBr(m_ir->CreateICmpUGE(m_ir->CreateLoad(spu_ptr<u32>(&SPUThread::offset)), m_ir->getInt32(RAW_SPU_BASE_ADDR)), label_body, label_tag);
+			m_ir->SetInsertPoint(label_tag);
+
+			for (u32 i = line_beg; i < line_end; i++)
+			{
+				m_ir->CreateStore(vtag, spu_ptr<u32>(&SPUThread::ls_owner, i));
+			}
+
+			m_ir->CreateBr(label_body);
 		}
 
 		// Increase block counter with statistics
@@ -2038,6 +2714,11 @@ public:
 		const auto pbcount = spu_ptr<u64>(&SPUThread::block_counter);
 		m_ir->CreateStore(m_ir->CreateAdd(m_ir->CreateLoad(pbcount), m_ir->getInt64(check_iterations)), pbcount);
 
+		if (m_profiler)
+		{
+			call("spu_profile", &exec_profile, m_thread, m_module->getOrInsertGlobal(hash + "-prof", get_type<u8>()));
+		}
+
 		// Call the entry function chunk
 		const auto entry_chunk = add_function(m_pos);
 		m_ir->CreateCall(entry_chunk, {m_thread, m_lsptr, m_ir->getInt32(0)})->setTailCall();
@@ -2052,7 +2733,7 @@ public:
 		{
 			const auto pbfail = spu_ptr<u64>(&SPUThread::block_failure);
 			m_ir->CreateStore(m_ir->CreateAdd(m_ir->CreateLoad(pbfail), m_ir->getInt64(1)), pbfail);
-			tail(&spu_recompiler_base::dispatch, m_thread, m_ir->getInt32(0), m_ir->getInt32(0));
+			tail("spu_dispatch", &spu_recompiler_base::dispatch, m_thread, m_ir->getInt32(0), m_ir->getInt32(0));
 		}
 		else
 		{
@@ -2259,9 +2940,14 @@ public:
 
 		// Basic optimizations
 		pm.add(createEarlyCSEPass());
-		pm.add(createAggressiveDCEPass());
-		pm.add(createCFGSimplificationPass());
-		pm.add(createDeadStoreEliminationPass());
+
+		if (m_tier != llvm_opt_tier::fast)
+		{
+			pm.add(createAggressiveDCEPass());
+			pm.add(createCFGSimplificationPass());
+			pm.add(createDeadStoreEliminationPass());
+		}
+
 		//pm.add(createLintPass()); // Check
 
 		for (const auto& func : m_functions)
@@ -2269,6 +2955,19 @@ public:
 			pm.run(*func.second);
 		}
 
+		if (m_tier == llvm_opt_tier::full)
+		{
+			// Full optimizations (-O3 with vectorizers)
+			legacy::PassManager mpm;
+			PassManagerBuilder pmb;
+			pmb.OptLevel = 3;
+			pmb.LoopVectorize = true;
+			pmb.SLPVectorize = true;
+			mpm.add(createTargetTransformInfoWrapperPass(m_spurt->m_jit.get_engine().getTargetMachine()->getTargetIRAnalysis()));
+			pmb.populateModulePassManager(mpm);
+			mpm.run(*module);
+		}
+
 		// Clear context (TODO)
 		m_blocks.clear();
 		m_block_queue.clear();
@@ -2277,6 +2976,71 @@ public:
 		m_scan_queue.clear();
 		m_function_table = nullptr;
 
+		std::string log;
+
+		raw_string_ostream out(log);
+
+		if (g_cfg.core.spu_debug)
+		{
+			fmt::append(log, "LLVM IR at 0x%x:\n", func[0]);
+			out << *module; // print IR
+			out << "\n\n";
+		}
+
+		if (verifyModule(*module, &out))
+		{
+			out.flush();
+			LOG_ERROR(SPU, "LLVM: Verification failed at 0x%x:\n%s", func[0], log);
+
+			if (g_cfg.core.spu_debug)
+			{
+				fs::file(m_spurt->m_cache_path + "spu.log", fs::write + fs::append).write(log);
+			}
+
+			fmt::raw_error("Compilation failed");
+		}
+
+		if (g_cfg.core.spu_cache || g_cfg.core.spu_debug)
+		{
+			// Save object file
+			m_spurt->m_jit.add(std::move(module), m_spurt->m_obj_path);
+		}
+		else
+		{
+			m_spurt->m_jit.add(std::move(module));
+		}
+
+		m_spurt->m_jit.fin();
+		const auto fn = reinterpret_cast<spu_function_t>(m_spurt->m_jit.get_engine().getPointerToFunction(main_func));
+
+		if (g_cfg.core.spu_debug)
+		{
+			out.flush();
+			fs::file(m_spurt->m_cache_path + "spu.log", fs::write + fs::append).write(log);
+		}
+
+		if (m_precompile)
+		{
+			// Object file is saved, the function will be loaded from the shared runtime
+			fn_location = fn;
+			return fn;
+		}
+
+		return finalize(func_hash, func, fn_location, fn);
+	}
+
+	// Register compiled function, update the dispatcher and the function list
+	spu_function_t finalize(u64 func_hash, const std::vector<u32>& func, spu_function_t& fn_location, spu_function_t fn)
+	{
+		using namespace llvm;
+
+		// Register function pointer
+		fn_location = fn;
+
+		const u32 start = func[0] * (g_cfg.core.spu_block_size != spu_block_size_type::giga);
+
+		spu_function_t tr = fn;
+
 		// Generate a dispatcher (übertrampoline)
 		std::vector<u32> addrv{func[0]};
 		const auto beg = m_spurt->m_map.lower_bound(addrv);
@@ -2286,7 +3050,16 @@ public:
 
 		if (size0 > 1)
 		{
-			const auto trampoline = cast<Function>(module->getOrInsertFunction(fmt::format("spu-0x%05x-trampoline-%03u", func[0], size0), get_type<void>(), get_type<u64>(), get_type<u64>()));
+			// Trampoline module is never cached because it depends on the set of currently compiled functions
+			const std::string name = fmt::format("spu-0x%05x-trampoline-%03u", func[0], size0);
+			std::unique_ptr<Module> module = std::make_unique<Module>(name, m_context);
+			module->setTargetTriple(Triple::normalize(sys::getProcessTriple()));
+			m_module = module.get();
+
+			IRBuilder<> irb(m_context);
+			m_ir = &irb;
+
+			const auto trampoline = cast<Function>(module->getOrInsertFunction(name, get_type<void>(), get_type<u64>(), get_type<u64>()));
 			set_function(trampoline);
 
 			struct work
@@ -2359,16 +3132,8 @@ public:
 							{
 								m_ir->SetInsertPoint(b);
 
-								if (const u64 fval = reinterpret_cast<u64>(it->second))
-								{
-									const auto ptr = m_ir->CreateIntToPtr(m_ir->getInt64(fval), main_func->getType());
-									m_ir->CreateCall(ptr, {m_thread, m_lsptr})->setTailCall();
-								}
-								else
-								{
-									verify(HERE, &it->second == &fn_location);
-									m_ir->CreateCall(main_func, {m_thread, m_lsptr})->setTailCall();
-								}
+								const auto ptr = m_ir->CreateIntToPtr(m_ir->getInt64(reinterpret_cast<u64>(it->second)), trampoline->getType());
+								m_ir->CreateCall(ptr, {m_thread, m_lsptr})->setTailCall();
 
 								m_ir->CreateRetVoid();
 							}
@@ -2412,16 +3177,8 @@ public:
 					LOG_ERROR(SPU, "Trampoline simplified at 0x%x (level=%u)", func[0], w.level);
 					m_ir->SetInsertPoint(w.label);
 
-					if (const u64 fval = reinterpret_cast<u64>(w.beg->second))
-					{
-						const auto ptr = m_ir->CreateIntToPtr(m_ir->getInt64(fval), main_func->getType());
-						m_ir->CreateCall(ptr, {m_thread, m_lsptr})->setTailCall();
-					}
-					else
-					{
-						verify(HERE, &w.beg->second == &fn_location);
-						m_ir->CreateCall(main_func, {m_thread, m_lsptr})->setTailCall();
-					}
+					const auto ptr = m_ir->CreateIntToPtr(m_ir->getInt64(reinterpret_cast<u64>(w.beg->second)), trampoline->getType());
+					m_ir->CreateCall(ptr, {m_thread, m_lsptr})->setTailCall();
 
 					m_ir->CreateRetVoid();
 					continue;
@@ -2432,7 +3189,7 @@ public:
 					def = llvm::BasicBlock::Create(m_context, "", m_function);
 
 					m_ir->SetInsertPoint(def);
-					tail(&spu_recompiler_base::dispatch, m_thread, m_ir->getInt32(0), m_ir->getInt32(0));
+					tail("spu_dispatch", &spu_recompiler_base::dispatch, m_thread, m_ir->getInt32(0), m_ir->getInt32(0));
 				}
 
 				m_ir->SetInsertPoint(w.label);
@@ -2446,71 +3203,25 @@ public:
 					sw->addCase(m_ir->getInt32(pair.first), pair.second);
 				}
 			}
-		}
-
-		spu_function_t fn{}, tr{};
-
-		std::string log;
-
-		raw_string_ostream out(log);
-
-		if (g_cfg.core.spu_debug)
-		{
-			fmt::append(log, "LLVM IR at 0x%x:\n", func[0]);
-			out << *module; // print IR
-			out << "\n\n";
-		}
-
-		if (verifyModule(*module, &out))
-		{
-			out.flush();
-			LOG_ERROR(SPU, "LLVM: Verification failed at 0x%x:\n%s", func[0], log);
-
-			if (g_cfg.core.spu_debug)
-			{
-				fs::file(m_spurt->m_cache_path + "spu.log", fs::write + fs::append).write(log);
-			}
-
-			fmt::raw_error("Compilation failed");
-		}
 
-		if (g_cfg.core.spu_debug)
-		{
-			// Testing only
-			m_spurt->m_jit.add(std::move(module), m_spurt->m_cache_path + "llvm/");
-		}
-		else
-		{
 			m_spurt->m_jit.add(std::move(module));
+			m_spurt->m_jit.fin();
+			tr = reinterpret_cast<spu_function_t>(m_spurt->m_jit.get_engine().getPointerToFunction(trampoline));
 		}
 
-		m_spurt->m_jit.fin();
-		fn = reinterpret_cast<spu_function_t>(m_spurt->m_jit.get_engine().getPointerToFunction(main_func));
-		tr = fn;
-
-		if (size0 > 1)
-		{
-			tr = reinterpret_cast<spu_function_t>(m_spurt->m_jit.get_engine().getPointerToFunction(m_function));
-		}
-
-		// Register function pointer
-		fn_location = fn;
-
 		// Trampoline
 		m_spurt->m_dispatcher[func[0] / 4] = tr;
 
+		// Publish for lock-free lookup after the dispatcher is updated
+		m_spurt->m_table.add(func_hash, func, fn);
+
 		LOG_NOTICE(SPU, "[0x%x] Compiled: %p", func[0], fn);
 
 		if (tr != fn)
 			LOG_NOTICE(SPU, "[0x%x] T: %p", func[0], tr);
 
-		if (g_cfg.core.spu_debug)
-		{
-			out.flush();
-			fs::file(m_spurt->m_cache_path + "spu.log", fs::write + fs::append).write(log);
-		}
-
-		if (m_cache && g_cfg.core.spu_cache)
+		// Function list is maintained by the primary decoder (LLVM may be used as a second tier for ASMJIT)
+		if (m_cache && g_cfg.core.spu_cache && g_cfg.core.spu_decoder == spu_decoder_type::llvm)
 		{
 			m_cache->add(func);
 		}
@@ -2518,25 +3229,28 @@ public:
 		return fn;
 	}
 
+	static void exec_profile(SPUThread* _spu, u8* entry)
+	{
+		spu_profiler::enter(*_spu, reinterpret_cast<spu_profile_entry*>(entry));
+	}
+
 	static bool exec_check_state(SPUThread* _spu)
 	{
 		return _spu->check_state();
 	}
 
-	template <spu_inter_func_t F>
 	static void exec_fall(SPUThread* _spu, spu_opcode_t op)
 	{
-		if (F(*_spu, op))
+		if (g_spu_interpreter_fast.decode(op.opcode)(*_spu, op))
 		{
 			_spu->pc += 4;
 		}
 	}
 
-	template <spu_inter_func_t F>
 	void fall(spu_opcode_t op)
 	{
 		update_pc();
-		call(&exec_fall<F>, m_thread, m_ir->getInt32(op.opcode));
+		call("spu_fall", &exec_fall, m_thread, m_ir->getInt32(op.opcode));
 	}
 
 	static void exec_unk(SPUThread* _spu, u32 op)
@@ -2548,7 +3262,7 @@ public:
 	{
 		m_block->block_end = m_ir->GetInsertBlock();
 		update_pc();
-		tail(&exec_unk, m_thread, m_ir->getInt32(op_unk.opcode));
+		tail("spu_unknown", &exec_unk, m_thread, m_ir->getInt32(op_unk.opcode));
 	}
 
 	static bool exec_stop(SPUThread* _spu, u32 code)
@@ -2559,7 +3273,7 @@ public:
 	void STOP(spu_opcode_t op) //
 	{
 		update_pc();
-		const auto succ = call(&exec_stop, m_thread, m_ir->getInt32(op.opcode & 0x3fff));
+		const auto succ = call("spu_stop", &exec_stop, m_thread, m_ir->getInt32(op.opcode & 0x3fff));
 		const auto next = llvm::BasicBlock::Create(m_context, "", m_function);
 		const auto stop = llvm::BasicBlock::Create(m_context, "", m_function);
 		m_ir->CreateCondBr(succ, next, stop);
@@ -2589,7 +3303,7 @@ public:
 	{
 		update_pc();
 		value_t<s64> res;
-		res.value = call(&exec_rdch, m_thread, m_ir->getInt32(op.ra));
+		res.value = call("spu_rdch", &exec_rdch, m_thread, m_ir->getInt32(op.ra));
 		const auto next = llvm::BasicBlock::Create(m_context, "", m_function);
 		const auto stop = llvm::BasicBlock::Create(m_context, "", m_function);
 		m_ir->CreateCondBr(m_ir->CreateICmpSLT(res.value, m_ir->getInt64(0)), stop, next);
@@ -2607,7 +3321,7 @@ public:
 	void RCHCNT(spu_opcode_t op) //
 	{
 		value_t<u32> res;
-		res.value = call(&exec_rchcnt, m_thread, m_ir->getInt32(op.ra));
+		res.value = call("spu_rchcnt", &exec_rchcnt, m_thread, m_ir->getInt32(op.ra));
 		set_vr(op.rt, insert(splat<u32[4]>(0), 3, res));
 	}
 
@@ -2619,7 +3333,7 @@ public:
 	void WRCH(spu_opcode_t op) //
 	{
 		update_pc();
-		const auto succ = call(&exec_wrch, m_thread, m_ir->getInt32(op.ra), extract(get_vr(op.rt), 3).value);
+		const auto succ = call("spu_wrch", &exec_wrch, m_thread, m_ir->getInt32(op.ra), extract(get_vr(op.rt), 3).value);
 		const auto next = llvm::BasicBlock::Create(m_context, "", m_function);
 		const auto stop = llvm::BasicBlock::Create(m_context, "", m_function);
 		m_ir->CreateCondBr(succ, next, stop);
@@ -3659,9 +4373,21 @@ public:
 		set_vr(op.rt, r);
 	}
 
+	// Invalidate verified code (write tracking)
+	void ls_written(value_t<u64> addr)
+	{
+		if (g_cfg.core.spu_verification && g_cfg.core.spu_write_tracking)
+		{
+			value_t<u64> line;
+			line.value = m_ir->CreateShl(m_ir->CreateLShr(addr.value, 7), 2);
+			m_ir->CreateStore(m_ir->getInt32(0), spu_ptr<u32>(line, &SPUThread::ls_owner));
+		}
+	}
+
 	void STQX(spu_opcode_t op) //
 	{
 		value_t<u64> addr = zext<u64>((extract(get_vr(op.ra), 3) + extract(get_vr(op.rb), 3)) & 0x3fff0);
+		ls_written(addr);
 		addr.value = m_ir->CreateAdd(m_lsptr, addr.value);
 		value_t<u8[16]> r = get_vr<u8[16]>(op.rt);
 		r.value = m_ir->CreateShuffleVector(r.value, r.value, {15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0});
@@ -3681,6 +4407,7 @@ public:
 	void STQA(spu_opcode_t op) //
 	{
 		value_t<u64> addr = splat<u64>(spu_ls_target(0, op.i16));
+		ls_written(addr);
 		addr.value = m_ir->CreateAdd(m_lsptr, addr.value);
 		value_t<u8[16]> r = get_vr<u8[16]>(op.rt);
 		r.value = m_ir->CreateShuffleVector(r.value, r.value, {15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0});
@@ -3700,6 +4427,7 @@ public:
 	void STQR(spu_opcode_t op) //
 	{
 		value_t<u64> addr = splat<u64>(spu_ls_target(m_pos, op.i16));
+		ls_written(addr);
 		addr.value = m_ir->CreateAdd(m_lsptr, addr.value);
 		value_t<u8[16]> r = get_vr<u8[16]>(op.rt);
 		r.value = m_ir->CreateShuffleVector(r.value, r.value, {15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0});
@@ -3719,6 +4447,7 @@ public:
 	void STQD(spu_opcode_t op) //
 	{
 		value_t<u64> addr = zext<u64>((extract(get_vr(op.ra), 3) + (op.si10 << 4)) & 0x3fff0);
+		ls_written(addr);
 		addr.value = m_ir->CreateAdd(m_lsptr, addr.value);
 		value_t<u8[16]> r = get_vr<u8[16]>(op.rt);
 		r.value = m_ir->CreateShuffleVector(r.value, r.value, {15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0});
@@ -3740,7 +4469,7 @@ public:
 		const auto pstatus = spu_ptr<u32>(&SPUThread::status);
 		const auto chalt = m_ir->getInt32(SPU_STATUS_STOPPED_BY_HALT);
 		m_ir->CreateAtomicRMW(llvm::AtomicRMWInst::Or, pstatus, chalt, llvm::AtomicOrdering::Release)->setVolatile(true);
-		const auto ptr = m_ir->CreateIntToPtr(m_ir->getInt64(reinterpret_cast<u64>(vm::base(0xffdead00))), get_type<u32*>());
+		const auto ptr = m_module->getOrInsertGlobal("spu_halt_addr", get_type<u32>());
 		m_ir->CreateStore(m_ir->getInt32("HALT"_u32), ptr)->setVolatile(true);
 		m_ir->CreateBr(next);
 	}
@@ -3891,7 +4620,7 @@ public:
 
 		if (op.e)
 		{
-			addr.value = call(&exec_check_interrupts, m_thread, addr.value);
+			addr.value = call("spu_check_interrupts", &exec_check_interrupts, m_thread, addr.value);
 		}
 
 		if (op.d)
@@ -4161,16 +4890,16 @@ public:
 	static const spu_decoder<spu_llvm_recompiler> g_decoder;
 };
 
-std::unique_ptr<spu_recompiler_base> spu_recompiler_base::make_llvm_recompiler()
+std::unique_ptr<spu_recompiler_base> spu_recompiler_base::make_llvm_recompiler(bool precompile, bool upgrade)
 {
-	return std::make_unique<spu_llvm_recompiler>();
+	return std::make_unique<spu_llvm_recompiler>(precompile, upgrade);
 }
 
 DECLARE(spu_llvm_recompiler::g_decoder);
 
 #else
 
-std::unique_ptr<spu_recompiler_base> spu_recompiler_base::make_llvm_recompiler()
+std::unique_ptr<spu_recompiler_base> spu_recompiler_base::make_llvm_recompiler(bool precompile, bool upgrade)
 {
 	fmt::throw_exception("LLVM is not available in this build.");
 }
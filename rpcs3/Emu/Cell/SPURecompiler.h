@@ -1,11 +1,62 @@
 #pragma once
 
 #include "Utilities/File.h"
+#include "Utilities/mutex.h"
+#include "Utilities/hash.h"
 #include "SPUThread.h"
 #include <vector>
 #include <bitset>
 #include <memory>
 #include <string>
+#include <deque>
+
+// Analyser output for a single function, enough to restore the analyser state without running it again
+struct spu_block_analysis
+{
+	// Function data (addr + raw instruction data)
+	std::vector<u32> func;
+
+	// Start of the function data (0 in Giga mode)
+	u32 lsa;
+
+	// Addresses of block starts and entry points
+	std::vector<u32> blocks;
+	std::vector<u32> entries;
+
+	// m_regmod and m_entry_map for the instructions of the function
+	std::vector<u8> regmod;
+	std::vector<u16> entry_map;
+
+	// m_targets and m_preds
+	std::vector<std::pair<u32, std::basic_string<u32>>> targets;
+	std::vector<std::pair<u32, std::basic_string<u32>>> preds;
+
+	// Serialize to words (format of the SPU cache file)
+	void save(std::vector<u32>& out) const;
+
+	// Deserialize, func must be set (returns false on corrupted data)
+	bool load(const u32* data, std::size_t size);
+};
+
+// Analyser results shared by all recompiler instances
+class spu_analysis_cache
+{
+	mutable shared_mutex m_mutex;
+
+	// By function hash (as in spu_function_table)
+	std::unordered_multimap<u64, std::shared_ptr<const spu_block_analysis>> m_funcs;
+
+	// By LS image hash (the entry point is the seed), low half -> high half and result
+	std::unordered_map<u64, std::pair<u64, std::shared_ptr<const spu_block_analysis>>> m_images;
+
+public:
+	std::shared_ptr<const spu_block_analysis> find(const std::vector<u32>& func) const;
+
+	std::shared_ptr<const spu_block_analysis> find(const rpcs3::hash128& image) const;
+
+	// Image hash is optional
+	void add(const std::shared_ptr<const spu_block_analysis>& info, const rpcs3::hash128* image = nullptr);
+};
 
 // Helper class
 class spu_cache
@@ -22,13 +73,96 @@ public:
 		return m_file.operator bool();
 	}
 
+	// Also registers the analyser results stored along with the functions
 	std::vector<std::vector<u32>> get();
 
+	// Stores the analyser results as well if known
 	void add(const std::vector<u32>& func);
 
 	static void initialize();
 };
 
+// Compiled function lookup table (insert-only, readers don't need any lock)
+class spu_function_table
+{
+	struct entry
+	{
+		// Precomputed hash of the function data
+		u64 hash;
+
+		// Function data (must have stable address, e.g. key in the runtime's function map)
+		const std::vector<u32>* func;
+
+		spu_function_t fn;
+
+		// Next entry in the bucket (immutable after publishing)
+		entry* next;
+	};
+
+	// Bucket heads (new entries are prepended)
+	std::array<atomic_t<entry*>, 0x1000> m_buckets{};
+
+	// Entry storage (stable addresses)
+	std::deque<entry> m_entries;
+
+public:
+	// Compute the hash of the function data
+	static u64 hash(const std::vector<u32>& func);
+
+	// Find compiled function (lock-free, returns nullptr if not found)
+	spu_function_t find(u64 hash, const std::vector<u32>& func) const;
+
+	// Publish compiled function (writers must be serialized by the caller)
+	void add(u64 hash, const std::vector<u32>& func, spu_function_t fn);
+};
+
+// SPU profiler statistics for a single function
+struct spu_profile_entry
+{
+	// LS address and size (in instructions)
+	u32 addr;
+	u32 size;
+
+	// Function hash (as in the object cache)
+	std::string hash;
+
+	// Number of executions
+	atomic_t<u64> hits{0};
+
+	// Approximate number of TSC cycles spent until the next function was entered
+	atomic_t<u64> cycles{0};
+};
+
+// SPU block profiler (global, enabled by g_cfg.core.spu_profiler)
+class spu_profiler
+{
+	mutable shared_mutex m_mutex;
+
+	// Entry storage (stable addresses)
+	std::deque<spu_profile_entry> m_entries;
+
+	// Entries by function hash (shared by all recompilers)
+	std::unordered_map<std::string, spu_profile_entry*> m_map;
+
+	// Report location
+	std::string m_path;
+
+public:
+	spu_profiler();
+
+	// Write the report
+	~spu_profiler();
+
+	// Get or register function statistics
+	spu_profile_entry* add(const std::vector<u32>& func);
+
+	// Print hottest functions (up to max)
+	void dump(std::string& out, std::size_t max) const;
+
+	// Update statistics on function entry (attribute elapsed cycles to the previous function)
+	static void enter(SPUThread& spu, spu_profile_entry* entry);
+};
+
 // SPU Recompiler instance base class
 class spu_recompiler_base
 {
@@ -56,10 +190,22 @@ protected:
 
 	std::shared_ptr<spu_cache> m_cache;
 
+	// Analyser results (shared)
+	std::shared_ptr<spu_analysis_cache> m_analysis;
+
+	// Profiler (if enabled)
+	std::shared_ptr<spu_profiler> m_profiler;
+
 private:
 	// For private use
 	std::bitset<0x10000> m_bits;
 
+	// Capture the analyser state after block()
+	std::shared_ptr<const spu_block_analysis> save_analysis(std::vector<u32>&& func, u32 lsa) const;
+
+	// Replace the analyser state
+	void load_analysis(const spu_block_analysis& info);
+
 public:
 	spu_recompiler_base();
 
@@ -74,6 +220,9 @@ public:
 	// Compile function
 	virtual spu_function_t compile(std::vector<u32>&&) = 0;
 
+	// Get unique nonzero tag for verified code (write tracking, see SPUThread::ls_owner)
+	static u32 make_tag();
+
 	// Default dispatch function fallback (second arg is unused)
 	static void dispatch(SPUThread&, void*, u8* rip);
 
@@ -83,14 +232,17 @@ public:
 	// Get the block at specified address
 	std::vector<u32> block(const be_t<u32>* ls, u32 lsa);
 
+	// Restore the analyser state of a function analysed before instead of calling block() (returns false if unknown)
+	bool restore(const std::vector<u32>& func);
+
 	// Print analyser internal state
 	void dump(std::string& out);
 
 	// Create recompiler instance (ASMJIT)
 	static std::unique_ptr<spu_recompiler_base> make_asmjit_recompiler();
 
-	// Create recompiler instance (LLVM)
-	static std::unique_ptr<spu_recompiler_base> make_llvm_recompiler();
+	// Create recompiler instance (LLVM), precompile = only fill the object cache using private runtime, upgrade = use the highest optimization tier in upgrade mode
+	static std::unique_ptr<spu_recompiler_base> make_llvm_recompiler(bool precompile = false, bool upgrade = false);
 
 	// Max number of registers (for m_regmod)
 	static constexpr u8 s_reg_max = 128;
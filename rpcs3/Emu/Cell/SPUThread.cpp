@@ -2,6 +2,7 @@
 #include "Utilities/JIT.h"
 #include "Utilities/lockless.h"
 #include "Utilities/sysinfo.h"
+#include "Utilities/perf_counters.h"
 #include "Emu/Memory/Memory.h"
 #include "Emu/System.h"
 
@@ -35,6 +36,15 @@ const bool s_use_ssse3 =
 #define _mm_shuffle_epi8
 #endif
 
+const bool s_use_avx2 =
+#ifdef _MSC_VER
+	utils::has_avx2();
+#elif __AVX2__
+	true;
+#else
+	false;
+#endif
+
 #ifdef _MSC_VER
 bool operator ==(const u128& lhs, const u128& rhs)
 {
@@ -157,9 +167,55 @@ namespace spu
 					release_pc_address(pc);
 			}
 		};
+
+		// Hands over the host execution slot for the duration of a blocking wait
+		struct slot_handover
+		{
+			SPUThread& spu;
+			const bool held;
+
+			slot_handover(SPUThread& spu)
+				: spu(spu)
+				, held(spu.slot_time != 0)
+			{
+				spu.slot_release();
+			}
+
+			~slot_handover()
+			{
+				if (held)
+					spu.slot_acquire();
+			}
+		};
 	}
 }
 
+static inline void spu_reservation_stat(u32 addr, vm::reservation_event event)
+{
+	if (event == vm::reservation_event::fail)
+	{
+		perf::spu_reservation_failures.add();
+	}
+
+	if (UNLIKELY(g_cfg.core.reservation_stats))
+	{
+		vm::reservation_stat(addr, event);
+	}
+}
+
+// Limits the number of SPU threads executing simultaneously on the host
+struct spu_host_slots
+{
+	semaphore<INT32_MAX> sema;
+
+	atomic_t<u32> waiters{0};
+
+	spu_host_slots()
+		: sema(g_cfg.core.spu_host_threads)
+	{
+	}
+};
+
 const auto spu_putllc_tx = build_function_asm<bool(*)(u32 raddr, u64 rtime, const void* _old, const void* _new)>([](asmjit::X86Assembler& c, auto& args)
 {
 	using namespace asmjit;
@@ -426,6 +482,14 @@ std::string SPUThread::dump() const
 
 	// Print some transaction statistics
 	fmt::append(ret, "\nBlocks: %u; Fail: %u", block_counter, block_failure);
+
+	if (const auto profiler = fxm::get<spu_profiler>())
+	{
+		// Print hottest functions
+		ret += "\n";
+		profiler->dump(ret, 10);
+	}
+
 	fmt::append(ret, "\n[%s]", ch_mfc_cmd);
 	fmt::append(ret, "\nTag Mask: 0x%08x", ch_tag_mask);
 	fmt::append(ret, "\nMFC Stall: 0x%08x", ch_stall_mask);
@@ -456,6 +520,7 @@ std::string SPUThread::dump() const
 void SPUThread::cpu_init()
 {
 	gpr = {};
+	ls_owner.fill(0);
 	fpscr.Reset();
 
 	ch_mfc_cmd = {};
@@ -520,6 +585,27 @@ void SPUThread::cpu_task()
 		return fmt::format("%s [0x%05x]", cpu->get_name(), cpu->pc);
 	};
 
+	if (!host_slots && g_cfg.core.spu_host_threads)
+	{
+		host_slots = fxm::get_always<spu_host_slots>();
+	}
+
+	// Run only while holding a host execution slot (nested calls keep the outer one)
+	const bool slot_owner = slot_time == 0;
+
+	if (slot_owner)
+	{
+		slot_acquire();
+	}
+
+	auto slot_guard = gsl::finally([&]()
+	{
+		if (slot_owner)
+		{
+			slot_release();
+		}
+	});
+
 	if (jit)
 	{
 		while (LIKELY(!test(state) || !check_state()))
@@ -542,6 +628,54 @@ void SPUThread::cpu_task()
 	const auto base = vm::_ptr<const u8>(offset);
 	const auto bswap4 = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
 
+	if (offset < RAW_SPU_BASE_ADDR)
+	{
+		// Direct-threaded loop: decoded handlers are reused until the LS line is written (see ls_written)
+		// Raw SPU LS can be written by PPU directly, so it always decodes
+		constexpr u32 intrp_tag = -1;
+
+		if (!intrp_cache)
+		{
+			intrp_cache = std::make_unique<spu_decoded_op[]>(0x10000);
+		}
+
+		const auto cache = intrp_cache.get();
+
+		while (true)
+		{
+			const bool step = UNLIKELY(test(state));
+
+			if (step && check_state()) return;
+
+			pc &= 0x3fffc;
+
+			const u32 line = pc / 128;
+
+			if (UNLIKELY(ls_owner[line] != intrp_tag))
+			{
+				for (u32 i = line * 32; i < line * 32 + 32; i++)
+				{
+					const u32 op = *reinterpret_cast<const be_t<u32>*>(base + i * 4);
+					cache[i].func = table[spu_decode(op)];
+					cache[i].op = {op};
+				}
+
+				ls_owner[line] = intrp_tag;
+			}
+
+			// Execute until a branch, the end of the line or a write to it (may be step)
+			for (auto ptr = cache + pc / 4; LIKELY(ptr->func(*this, ptr->op)); ptr++)
+			{
+				pc += 4;
+
+				if (UNLIKELY(step || pc % 128 == 0 || ls_owner[line] != intrp_tag || test(state)))
+				{
+					break;
+				}
+			}
+		}
+	}
+
 	v128 _op;
 	using func_t = decltype(&spu_interpreter::UNK);
 	func_t func0, func1, func2, func3, func4, func5;
@@ -620,6 +754,61 @@ void SPUThread::cpu_unmem()
 	//state.test_and_set(cpu_flag::memory);
 }
 
+void SPUThread::cpu_sleep()
+{
+	// Suspended thread must not occupy a host execution slot
+	slot_suspended = slot_time != 0;
+	slot_release();
+}
+
+void SPUThread::cpu_wake()
+{
+	if (slot_suspended)
+	{
+		slot_suspended = false;
+		slot_acquire();
+	}
+}
+
+void SPUThread::slot_acquire()
+{
+	if (!host_slots || slot_time)
+	{
+		return;
+	}
+
+	if (!host_slots->sema.try_wait())
+	{
+		host_slots->waiters++;
+		host_slots->sema.wait();
+		host_slots->waiters--;
+	}
+
+	slot_time = get_system_time();
+}
+
+void SPUThread::slot_release()
+{
+	if (!host_slots || !slot_time)
+	{
+		return;
+	}
+
+	slot_time = 0;
+	host_slots->sema.post();
+}
+
+void SPUThread::slot_yield()
+{
+	// Hand over the slot to a waiting thread after a time slice of 1ms
+	if (host_slots && slot_time && host_slots->waiters && get_system_time() - slot_time >= 1000)
+	{
+		slot_release();
+		std::this_thread::yield();
+		slot_acquire();
+	}
+}
+
 SPUThread::~SPUThread()
 {
 	// Deallocate Local Storage
@@ -679,6 +868,11 @@ void SPUThread::do_dma_transfer(const spu_mfc_cmd& args)
 	u32 eal = args.eal;
 	u32 lsa = args.lsa & 0x3ffff;
 
+	if (is_get)
+	{
+		ls_written(lsa, args.size);
+	}
+
 	// SPU Thread Group MMIO (LS and SNR) and RawSPU MMIO
 	if (eal >= RAW_SPU_BASE_ADDR)
 	{
@@ -724,6 +918,11 @@ void SPUThread::do_dma_transfer(const spu_mfc_cmd& args)
 			if (offset + args.size - 1 < 0x40000) // LS access
 			{
 				eal = spu.offset + offset; // redirect access
+
+				if (!is_get)
+				{
+					spu.ls_written(offset, args.size);
+				}
 			}
 			else if (!is_get && args.size == 4 && (offset == SYS_SPU_THREAD_SNR1 || offset == SYS_SPU_THREAD_SNR2))
 			{
@@ -942,6 +1141,40 @@ bool SPUThread::do_dma_check(const spu_mfc_cmd& args)
 	return true;
 }
 
+// Copy 16-byte aligned DMA data (use non-temporal stores for big transfers if requested)
+static void do_dma_copy(void* dst, const void* src, u32 size, bool stream)
+{
+#if defined(_MSC_VER) || defined(__AVX2__)
+	if (stream && s_use_avx2 && size >= 0x400 && ((reinterpret_cast<u64>(dst) | reinterpret_cast<u64>(src)) % 32) == 0)
+	{
+		auto vdst = static_cast<__m256i*>(dst);
+		auto vsrc = static_cast<const __m256i*>(src);
+
+		for (u32 i = 0; i < size / 32; i++)
+		{
+			_mm256_stream_si256(vdst + i, _mm256_load_si256(vsrc + i));
+		}
+
+		if (size % 32)
+		{
+			_mm_store_si128(reinterpret_cast<__m128i*>(vdst + size / 32), _mm_load_si128(reinterpret_cast<const __m128i*>(vsrc + size / 32)));
+		}
+
+		_mm_sfence();
+		_mm256_zeroupper();
+		return;
+	}
+#endif
+
+	auto vdst = static_cast<__m128i*>(dst);
+	auto vsrc = static_cast<const __m128i*>(src);
+
+	for (u32 i = 0; i < size / 16; i++)
+	{
+		_mm_store_si128(vdst + i, _mm_load_si128(vsrc + i));
+	}
+}
+
 bool SPUThread::do_list_transfer(spu_mfc_cmd& args)
 {
 	struct list_element
@@ -951,10 +1184,41 @@ bool SPUThread::do_list_transfer(spu_mfc_cmd& args)
 		be_t<u32> ea; // External Address Low
 	} item{};
 
+	const bool is_get = (args.cmd & ~(MFC_BARRIER_MASK | MFC_FENCE_MASK | MFC_START_MASK | MFC_LIST_MASK)) == MFC_GET_CMD;
+
+	// Plain memory transfers can be merged and copied directly (PUT needs reservation locking without TSX)
+	const bool can_batch = is_get || g_use_rtm;
+
+	// Pending merged transfer
+	u32 batch_ea = 0;
+	u32 batch_lsa = 0;
+	u32 batch_size = 0;
+
+	auto flush = [&]()
+	{
+		if (batch_size)
+		{
+			void* dst = vm::base(batch_ea);
+			void* src = vm::base(offset + batch_lsa);
+
+			if (is_get)
+			{
+				std::swap(dst, src);
+				ls_written(batch_lsa, batch_size);
+			}
+
+			// Don't pollute the cache with data written to the main memory
+			do_dma_copy(dst, src, batch_size, !is_get);
+			batch_size = 0;
+		}
+	};
+
 	while (args.size)
 	{
 		if (UNLIKELY(item.sb & 0x8000))
 		{
+			flush();
+
 			ch_stall_mask |= (1u << args.tag);
 
 			if (!ch_stall_stat.get_count())
@@ -974,8 +1238,27 @@ bool SPUThread::do_list_transfer(spu_mfc_cmd& args)
 
 		LOG_TRACE(SPU, "LIST: addr=0x%x, size=0x%x, lsa=0x%05x, sb=0x%x", addr, size, args.lsa | (addr & 0xf), item.sb);
 
-		if (size)
+		if (size && can_batch && size % 16 == 0 && addr % 16 == 0 && addr < RAW_SPU_BASE_ADDR && args.lsa + size <= 0x40000)
+		{
+			if (batch_size && (batch_ea + batch_size != addr || batch_lsa + batch_size != args.lsa))
+			{
+				// Not adjacent to the pending transfer
+				flush();
+			}
+
+			if (!batch_size)
+			{
+				batch_ea = addr;
+				batch_lsa = args.lsa;
+			}
+
+			batch_size += size;
+			args.lsa += size;
+		}
+		else if (size)
 		{
+			flush();
+
 			spu_mfc_cmd transfer;
 			transfer.eal  = addr;
 			transfer.eah  = 0;
@@ -993,9 +1276,42 @@ bool SPUThread::do_list_transfer(spu_mfc_cmd& args)
 		args.size -= 8;
 	}
 
+	flush();
 	return true;
 }
 
+// Copy the reservation line without taking its lock (seqlock): retry while a reservation writer holds the line or the time changed under the copy.
+// The accurate mode also compares the copy with memory again, which rejects copies torn by plain stores. Returns false if the copy didn't settle.
+static bool spu_getll_seqlock(u32 raddr, std::array<u128, 8>& rdata, u64& rtime, bool accurate)
+{
+	const auto& data = vm::_ref<std::array<u128, 8>>(raddr);
+
+	for (u32 i = 0; i < 16; i++, busy_wait(300))
+	{
+		const u64 time0 = vm::reservation_acquire(raddr, 128);
+
+		if (time0 & 1)
+		{
+			continue;
+		}
+
+		rdata = data;
+
+		if (accurate && rdata != data)
+		{
+			continue;
+		}
+
+		if (LIKELY(vm::reservation_acquire(raddr, 128) == time0))
+		{
+			rtime = time0;
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void SPUThread::do_putlluc(const spu_mfc_cmd& args)
 {
 	if (raddr && args.eal == raddr)
@@ -1015,11 +1331,20 @@ void SPUThread::do_putlluc(const spu_mfc_cmd& args)
 
 		while (!spu_putlluc_tx(addr, to_write.data()))
 		{
-			std::this_thread::yield();
+			// Short conflicts are resolved by spinning, only yield if the line is really contended
+			if (count < 9)
+			{
+				busy_wait(300);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+
 			count += 2;
 		}
 
-		if (count > 5)
+		if (count > 9)
 		{
 			LOG_ERROR(SPU, "%s took too long: %u", args.cmd, count);
 		}
@@ -1160,9 +1485,13 @@ bool SPUThread::process_mfc_cmd(spu_mfc_cmd args)
 			return false;
 		}
 
+		spu::scheduler::slot_handover handover(*this);
 		thread_ctrl::wait();
 	}
 
+	// Time slice for M:N scheduling
+	slot_yield();
+
 	spu::scheduler::concurrent_execution_watchdog watchdog(*this);
 	LOG_TRACE(SPU, "DMAC: cmd=%s, lsa=0x%x, ea=0x%llx, tag=0x%x, size=0x%x", args.cmd, args.lsa, args.eal, args.tag, args.size);
 
@@ -1177,59 +1506,68 @@ bool SPUThread::process_mfc_cmd(spu_mfc_cmd args)
 			ch_event_stat |= SPU_EVENT_LR;
 		}
 
+		if (raddr == args.eal && rtime == vm::reservation_acquire(raddr, 128) && rdata == data)
+		{
+			// Same reservation is acquired again without changes
+			raddr_spin++;
+		}
+		else
+		{
+			raddr_spin = 0;
+		}
+
 		raddr = args.eal;
 
-		const bool is_polling = false; // TODO
+		const bool is_polling = g_cfg.core.spu_loop_detection && raddr_spin >= 16;
 
 		if (is_polling)
 		{
-			rtime = vm::reservation_acquire(raddr, 128);
+			// Park until the line is modified (woken by PUTLLC, PUTLLUC and PPU conditional stores)
+			spu::scheduler::slot_handover handover(*this);
+			std::shared_lock<notifier> pseudo_lock(vm::reservation_notifier(raddr, 128), std::try_to_lock);
 
-			while (rdata == data && vm::reservation_acquire(raddr, 128) == rtime)
+			while (pseudo_lock && rdata == data && vm::reservation_acquire(raddr, 128) == rtime)
 			{
 				if (test(state, cpu_flag::stop))
 				{
 					break;
 				}
 
-				thread_ctrl::wait_for(100);
+				// Timeout is necessary for plain stores which don't notify
+				pseudo_lock.mutex()->wait(100);
 			}
 		}
 
-		if (LIKELY(g_use_rtm))
-		{
-			u64 count = 1;
+		const bool accurate = g_cfg.core.spu_accurate_getllar.get();
 
-			while (g_cfg.core.spu_accurate_getllar && !spu_getll_tx(raddr, rdata.data(), &rtime))
-			{
-				std::this_thread::yield();
-				count += 2;
-			}
+		bool copied = false;
 
-			if (!g_cfg.core.spu_accurate_getllar)
+		if (LIKELY(g_use_rtm) && accurate)
+		{
+			// A transactional copy is atomic against plain stores as well, don't spin on it forever
+			for (u32 i = 0; i < 4; i++, busy_wait(300))
 			{
-				for (;; count++, busy_wait(300))
+				if (spu_getll_tx(raddr, rdata.data(), &rtime))
 				{
-					rtime = vm::reservation_acquire(raddr, 128);
-					rdata = data;
-
-					if (LIKELY(vm::reservation_acquire(raddr, 128) == rtime))
-					{
-						break;
-					}
+					copied = true;
+					break;
 				}
-			}
 
-			if (count > 9)
-			{
-				LOG_ERROR(SPU, "%s took too long: %u", args.cmd, count);
+				spu_reservation_stat(raddr, vm::reservation_event::tx_fail);
 			}
 		}
 		else
 		{
+			copied = spu_getll_seqlock(raddr, rdata, rtime, accurate);
+		}
+
+		if (UNLIKELY(!copied))
+		{
+			spu_reservation_stat(raddr, vm::reservation_event::lock);
+
 			auto& res = vm::reservation_lock(raddr, 128);
 
-			if (g_cfg.core.spu_accurate_getllar)
+			if (accurate)
 			{
 				vm::_ref<atomic_t<u32>>(raddr) += 0;
 
@@ -1250,6 +1588,7 @@ bool SPUThread::process_mfc_cmd(spu_mfc_cmd args)
 		}
 
 		// Copy to LS
+		ls_written(args.lsa & 0x3ff80, 128);
 		_ref<decltype(rdata)>(args.lsa & 0x3ffff) = rdata;
 		ch_atomic_stat.set_value(MFC_GETLLAR_SUCCESS);
 		return true;
@@ -1272,11 +1611,17 @@ bool SPUThread::process_mfc_cmd(spu_mfc_cmd args)
 					vm::reservation_notifier(raddr, 128).notify_all();
 					result = true;
 				}
+				else
+				{
+					spu_reservation_stat(raddr, vm::reservation_event::tx_fail);
+				}
 
 				// Don't fallback to heavyweight lock, just give up
 			}
 			else if (rdata == data)
 			{
+				spu_reservation_stat(raddr, vm::reservation_event::lock);
+
 				auto& res = vm::reservation_lock(raddr, 128);
 
 				vm::_ref<atomic_t<u32>>(raddr) += 0;
@@ -1306,6 +1651,7 @@ bool SPUThread::process_mfc_cmd(spu_mfc_cmd args)
 		else
 		{
 			ch_atomic_stat.set_value(MFC_PUTLLC_FAILURE);
+			spu_reservation_stat(args.eal, vm::reservation_event::fail);
 		}
 
 		if (raddr && !result)
@@ -1548,6 +1894,7 @@ s64 SPUThread::get_ch_value(u32 ch)
 				return -1;
 			}
 
+			spu::scheduler::slot_handover handover(*this);
 			thread_ctrl::wait();
 		}
 
@@ -1586,6 +1933,7 @@ s64 SPUThread::get_ch_value(u32 ch)
 				return -1;
 			}
 
+			spu::scheduler::slot_handover handover(*this);
 			thread_ctrl::wait();
 		}
 	}
@@ -1679,6 +2027,7 @@ s64 SPUThread::get_ch_value(u32 ch)
 				fmt::throw_exception("Not supported: event mask 0x%x" HERE, mask1);
 			}
 
+			spu::scheduler::slot_handover handover(*this);
 			std::shared_lock<notifier> pseudo_lock(vm::reservation_notifier(raddr, 128), std::try_to_lock);
 
 			verify(HERE), pseudo_lock;
@@ -1703,7 +2052,18 @@ s64 SPUThread::get_ch_value(u32 ch)
 				return -1;
 			}
 
-			thread_ctrl::wait_for(100);
+			if (mask1 & SPU_EVENT_TM)
+			{
+				// Sleep until the decrementer event (timebase frequency is 80 MHz)
+				const u32 left = ch_dec_value - static_cast<u32>(get_timebased_time() - ch_dec_start_timestamp);
+				spu::scheduler::slot_handover handover(*this);
+				thread_ctrl::wait_for(std::max<u32>(left / 80, 1));
+				continue;
+			}
+
+			// Other events are signaled by set_events()
+			spu::scheduler::slot_handover handover(*this);
+			thread_ctrl::wait();
 		}
 
 		return res;
@@ -1743,6 +2103,7 @@ bool SPUThread::set_ch_value(u32 ch, u32 value)
 					return false;
 				}
 
+				spu::scheduler::slot_handover handover(*this);
 				thread_ctrl::wait();
 			}
 
@@ -1889,6 +2250,7 @@ bool SPUThread::set_ch_value(u32 ch, u32 value)
 				return false;
 			}
 
+			spu::scheduler::slot_handover handover(*this);
 			thread_ctrl::wait();
 		}
 
@@ -2092,6 +2454,7 @@ bool SPUThread::stop_and_signal(u32 code)
 				return false;
 			}
 
+			spu::scheduler::slot_handover handover(*this);
 			thread_ctrl::wait_for(1000);
 		}
 
@@ -2100,6 +2463,7 @@ bool SPUThread::stop_and_signal(u32 code)
 
 	case 0x001:
 	{
+		spu::scheduler::slot_handover handover(*this);
 		thread_ctrl::wait_for(1000); // hack
 		return true;
 	}
@@ -2148,6 +2512,7 @@ bool SPUThread::stop_and_signal(u32 code)
 					return false;
 				}
 
+				spu::scheduler::slot_handover handover(*this);
 				thread_ctrl::wait();
 			}
 
@@ -2181,6 +2546,9 @@ bool SPUThread::stop_and_signal(u32 code)
 
 			semaphore_lock qlock(queue->mutex);
 
+			// Announce the receiver before checking, so that lock-free senders can't miss it
+			queue->waiters = queue->sq.size() + 1;
+
 			if (queue->events.empty())
 			{
 				queue->sq.emplace_back(this);
@@ -2206,6 +2574,7 @@ bool SPUThread::stop_and_signal(u32 code)
 				const auto data3 = static_cast<u32>(std::get<3>(event));
 				ch_in_mbox.set_values(4, CELL_OK, data1, data2, data3);
 				queue->events.pop_front();
+				queue->waiters = queue->sq.size();
 				return true;
 			}
 		}
@@ -2219,6 +2588,7 @@ bool SPUThread::stop_and_signal(u32 code)
 
 			if (!state.test_and_reset(cpu_flag::signal))
 			{
+				spu::scheduler::slot_handover handover(*this);
 				thread_ctrl::wait();
 			}
 			else
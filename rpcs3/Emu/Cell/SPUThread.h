@@ -10,6 +10,7 @@
 struct lv2_event_queue;
 struct lv2_spu_group;
 struct lv2_int_tag;
+struct spu_host_slots;
 
 class SPUThread;
 
@@ -500,6 +501,13 @@ public:
 	}
 };
 
+// Pre-decoded SPU instruction (interpreter)
+struct spu_decoded_op
+{
+	spu_inter_func_t func;
+	spu_opcode_t op;
+};
+
 class SPUThread : public cpu_thread
 {
 public:
@@ -510,6 +518,8 @@ public:
 	virtual void cpu_task() override;
 	virtual void cpu_mem() override;
 	virtual void cpu_unmem() override;
+	virtual void cpu_sleep() override;
+	virtual void cpu_wake() override;
 	virtual ~SPUThread() override;
 	void cpu_init();
 
@@ -539,6 +549,7 @@ public:
 	u64 rtime = 0;
 	std::array<u128, 8> rdata{};
 	u32 raddr = 0;
+	u32 raddr_spin = 0; // Number of GETLLAR repeated without changes (polling detection)
 
 	u32 srr0;
 	u32 ch_tag_upd;
@@ -586,10 +597,30 @@ public:
 	u64 block_recover = 0;
 	u64 block_failure = 0;
 
+	struct spu_profile_entry* prof_last = nullptr; // Profiler: last entered function
+	u64 prof_tsc = 0; // Profiler: TSC at the last function entry
+
 	std::array<spu_function_t, 0x10000> jit_dispatcher; // Dispatch table for indirect calls
 
+	std::array<u32, 0x40000 / 128> ls_owner{}; // Tag of the last verified function for each LS line (0 if written since)
+
 	std::array<v128, 0x4000> stack_mirror; // Return address information
 
+	std::unique_ptr<spu_decoded_op[]> intrp_cache; // Pre-decoded instructions (interpreter, valid for LS lines owned by it)
+
+	std::shared_ptr<spu_host_slots> host_slots; // Host execution slots (null if unlimited)
+	u64 slot_time = 0; // Time when the host execution slot was obtained (0 if not held)
+	bool slot_suspended = false; // Host execution slot was released by cpu_sleep()
+
+	// Invalidate verified code in LS range (write tracking)
+	void ls_written(u32 lsa, u32 size)
+	{
+		for (u32 i = lsa / 128, end = std::min<u32>((lsa + size + 127) / 128, ::size32(ls_owner)); i < end; i++)
+		{
+			ls_owner[i] = 0;
+		}
+	}
+
 	void push_snr(u32 number, u32 value);
 	void do_dma_transfer(const spu_mfc_cmd& args);
 	bool do_dma_check(const spu_mfc_cmd& args);
@@ -608,6 +639,11 @@ public:
 	bool stop_and_signal(u32 code);
 	void halt();
 
+	// Host execution slot control (see "SPU Host Threads")
+	void slot_acquire();
+	void slot_release();
+	void slot_yield();
+
 	void fast_call(u32 ls_addr);
 
 	// Convert specified SPU LS address to a pointer of specified (possibly converted to BE) type
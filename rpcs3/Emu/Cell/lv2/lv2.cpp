@@ -1,5 +1,7 @@
 #include "stdafx.h"
 #include "Emu/System.h"
+#include "Utilities/tracing.h"
+#include "Utilities/perf_counters.h"
 
 #include "Emu/Cell/PPUFunction.h"
 #include "Emu/Cell/ErrorCodes.h"
@@ -957,9 +959,24 @@ void fmt_class_string<CellError>::format(std::string& out, u64 arg)
 	});
 }
 
+// Counts the syscall for the performance counters and calls the handler with the same index
+template <u32 Index>
+static bool ppu_counted_syscall(ppu_thread& ppu)
+{
+	perf::lv2_syscalls.add();
+	return s_ppu_syscall_table[Index](ppu);
+}
+
+template <u32... Index>
+static std::array<ppu_function_t, 1024> ppu_make_counted_syscalls(std::integer_sequence<u32, Index...>)
+{
+	return {{(s_ppu_syscall_table[Index] ? &ppu_counted_syscall<Index> : nullptr)...}};
+}
+
 extern void ppu_initialize_syscalls()
 {
-	g_ppu_syscall_table = s_ppu_syscall_table;
+	// The wrappers are linked by the PPU LLVM recompiler too, so syscalls are counted with every PPU decoder
+	g_ppu_syscall_table = ppu_make_counted_syscalls(std::make_integer_sequence<u32, 1024>());
 }
 
 extern void ppu_execute_syscall(ppu_thread& ppu, u64 code)
@@ -989,7 +1006,60 @@ extern ppu_function_t ppu_get_syscall(u64 code)
 
 extern u64 get_system_time();
 
-DECLARE(lv2_obj::g_mutex);
+namespace
+{
+	enum class sched_event : u32
+	{
+		sleep,
+		awake,
+		yield,
+		suspend,
+		resume,
+		timeout,
+	};
+
+	const char* const s_sched_event_names[] = { "sleep", "awake", "yield", "suspend", "resume", "timeout" };
+
+	// Sleep start time and syscall of each sleeping thread (protected by lv2_obj::g_mutex)
+	std::unordered_map<u32, std::pair<u64, u64>> s_sched_sleep;
+}
+
+static void sched_trace(sched_event event, ppu_thread& ppu)
+{
+	if (LIKELY(!tracing::g_enabled))
+	{
+		return;
+	}
+
+	const u32 object = static_cast<u32>(ppu.gpr[3]);
+	const u32 syscall = static_cast<u32>(ppu.gpr[11]);
+
+	tracing::instant(tracing::category::lv2, s_sched_event_names[static_cast<u32>(event)], ppu.id, "prio,syscall,object", ppu.prio, syscall, object);
+
+	if (event == sched_event::sleep)
+	{
+		s_sched_sleep[ppu.id] = std::make_pair(tracing::get_time(), u64{syscall} << 32 | object);
+	}
+	else if (event == sched_event::awake || event == sched_event::timeout)
+	{
+		const auto found = s_sched_sleep.find(ppu.id);
+
+		if (found != s_sched_sleep.end())
+		{
+			tracing::span(tracing::category::lv2, "wait", found->second.first, ppu.id, "syscall,object", found->second.second >> 32, static_cast<u32>(found->second.second));
+			s_sched_sleep.erase(found);
+		}
+	}
+}
+
+u32 lv2_sleep_prio(cpu_thread* cpu)
+{
+	return cpu->id_type() == 1 ? static_cast<ppu_thread*>(cpu)->prio.load() : 0;
+}
+
+static lock_class s_lv2_lock_class{"lv2_obj::g_mutex", 20};
+
+DECLARE(lv2_obj::g_mutex){s_lv2_lock_class};
 DECLARE(lv2_obj::g_ppu);
 DECLARE(lv2_obj::g_pending);
 DECLARE(lv2_obj::g_waiting);
@@ -1023,6 +1093,8 @@ void lv2_obj::sleep_timeout(named_thread& thread, u64 timeout)
 		unqueue(g_pending, ppu);
 
 		ppu->start_time = start_time;
+
+		sched_trace(sched_event::sleep, *ppu);
 	}
 
 	if (timeout)
@@ -1030,16 +1102,17 @@ void lv2_obj::sleep_timeout(named_thread& thread, u64 timeout)
 		const u64 wait_until = start_time + timeout;
 
 		// Register timeout if necessary
-		for (auto it = g_waiting.begin(), end = g_waiting.end(); it != end; it++)
+		auto it = g_waiting.begin();
+
+		while (it != g_waiting.end() && it->first <= wait_until)
 		{
-			if (it->first > wait_until)
-			{
-				g_waiting.emplace(it, wait_until, &thread);
-				return;
-			}
+			it++;
 		}
 
-		g_waiting.emplace_back(wait_until, &thread);
+		g_waiting.emplace(it, wait_until, &thread);
+
+		// Let the timer thread wait for the new timeout
+		lv2_timer_notify();
 	}
 
 	schedule_all();
@@ -1057,16 +1130,21 @@ void lv2_obj::awake(cpu_thread& cpu, u32 prio)
 		// Yield command
 		const u64 start_time = get_system_time();
 
-		for (std::size_t i = 0, pos = -1; i < g_ppu.size(); i++)
+		for (auto it = g_ppu.begin(), end = g_ppu.end(); it != end; ++it)
 		{
-			if (g_ppu[i] == &cpu)
-			{
-				pos = i;
-				prio = g_ppu[i]->prio;
-			}
-			else if (i == pos + 1 && prio != -4 && g_ppu[i]->prio != prio)
+			if (*it == &cpu)
 			{
-				return;
+				prio = (*it)->prio;
+
+				// Nothing to yield to if the next thread has lower priority
+				const u32 _prio = it.prio();
+
+				if (++it != end && it.prio() != _prio)
+				{
+					return;
+				}
+
+				break;
 			}
 		}
 
@@ -1074,6 +1152,8 @@ void lv2_obj::awake(cpu_thread& cpu, u32 prio)
 		unqueue(g_pending, &cpu);
 
 		static_cast<ppu_thread&>(cpu).start_time = start_time;
+
+		sched_trace(sched_event::yield, static_cast<ppu_thread&>(cpu));
 	}
 
 	if (prio < INT32_MAX && !unqueue(g_ppu, &cpu))
@@ -1083,31 +1163,26 @@ void lv2_obj::awake(cpu_thread& cpu, u32 prio)
 	}
 
 	// Emplace current thread
-	for (std::size_t i = 0; i <= g_ppu.size(); i++)
+	if (g_ppu.contains(&static_cast<ppu_thread&>(cpu)))
+	{
+		LOG_TRACE(PPU, "sleep() - suspended (p=%zu)", g_pending.size());
+	}
+	else
 	{
-		if (i < g_ppu.size() && g_ppu[i] == &cpu)
-		{
-			LOG_TRACE(PPU, "sleep() - suspended (p=%zu)", g_pending.size());
-			break;
-		}
-
 		// Use priority, also preserve FIFO order
-		if (i == g_ppu.size() || g_ppu[i]->prio > static_cast<ppu_thread&>(cpu).prio)
-		{
-			LOG_TRACE(PPU, "awake(): %s", cpu.id);
-			g_ppu.insert(g_ppu.cbegin() + i, &static_cast<ppu_thread&>(cpu));
+		LOG_TRACE(PPU, "awake(): %s", cpu.id);
+		g_ppu.emplace_back(&static_cast<ppu_thread&>(cpu), static_cast<ppu_thread&>(cpu).prio);
+
+		sched_trace(sched_event::awake, static_cast<ppu_thread&>(cpu));
 
-			// Unregister timeout if necessary
-			for (auto it = g_waiting.cbegin(), end = g_waiting.cend(); it != end; it++)
+		// Unregister timeout if necessary
+		for (auto it = g_waiting.cbegin(), end = g_waiting.cend(); it != end; it++)
+		{
+			if (it->second == &cpu)
 			{
-				if (it->second == &cpu)
-				{
-					g_waiting.erase(it);
-					break;
-				}
+				g_waiting.erase(it);
+				break;
 			}
-
-			break;
 		}
 	}
 
@@ -1118,14 +1193,21 @@ void lv2_obj::awake(cpu_thread& cpu, u32 prio)
 	}
 
 	// Suspend threads if necessary
-	for (std::size_t i = g_cfg.core.ppu_threads; i < g_ppu.size(); i++)
+	std::size_t pos = 0;
+
+	for (const auto target : g_ppu)
 	{
-		const auto target = g_ppu[i];
+		if (pos++ < g_cfg.core.ppu_threads)
+		{
+			continue;
+		}
 
 		if (!target->state.test_and_set(cpu_flag::suspend))
 		{
 			LOG_TRACE(PPU, "suspend(): %s", target->id);
 			g_pending.emplace_back(target);
+
+			sched_trace(sched_event::suspend, *target);
 		}
 	}
 
@@ -1134,6 +1216,8 @@ void lv2_obj::awake(cpu_thread& cpu, u32 prio)
 
 void lv2_obj::cleanup()
 {
+	s_sched_sleep.clear();
+
 	g_ppu.clear();
 	g_pending.clear();
 	g_waiting.clear();
@@ -1144,9 +1228,14 @@ void lv2_obj::schedule_all()
 	if (g_pending.empty())
 	{
 		// Wake up threads
-		for (std::size_t i = 0, x = std::min<std::size_t>(g_cfg.core.ppu_threads, g_ppu.size()); i < x; i++)
+		std::size_t pos = 0;
+
+		for (const auto target : g_ppu)
 		{
-			const auto target = g_ppu[i];
+			if (pos++ >= g_cfg.core.ppu_threads)
+			{
+				break;
+			}
 
 			if (test(target->state, cpu_flag::suspend))
 			{
@@ -1154,6 +1243,8 @@ void lv2_obj::schedule_all()
 				target->state ^= (cpu_flag::signal + cpu_flag::suspend);
 				target->start_time = 0;
 
+				sched_trace(sched_event::resume, *target);
+
 				if (target->get() != thread_ctrl::get_current())
 				{
 					target->notify();
@@ -1162,6 +1253,18 @@ void lv2_obj::schedule_all()
 		}
 	}
 
+	notify_timeouts();
+}
+
+u64 lv2_obj::check_timeouts()
+{
+	semaphore_lock lock(g_mutex);
+
+	return notify_timeouts();
+}
+
+u64 lv2_obj::notify_timeouts()
+{
 	// Check registered timeouts
 	while (!g_waiting.empty())
 	{
@@ -1169,13 +1272,20 @@ void lv2_obj::schedule_all()
 
 		if (pair.first <= get_system_time())
 		{
+			if (auto ppu = dynamic_cast<ppu_thread*>(pair.second))
+			{
+				sched_trace(sched_event::timeout, *ppu);
+			}
+
 			pair.second->notify();
 			g_waiting.pop_front();
 		}
 		else
 		{
 			// The list is sorted so assume no more timeouts
-			break;
+			return pair.first;
 		}
 	}
+
+	return -1;
 }
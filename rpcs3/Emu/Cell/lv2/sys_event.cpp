@@ -31,20 +31,53 @@ std::shared_ptr<lv2_event_queue> lv2_event_queue::find(u64 ipc_key)
 
 bool lv2_event_queue::send(lv2_event event)
 {
-	semaphore_lock lock(mutex);
-
-	if (sq.empty())
+	if (!waiters)
 	{
-		if (events.size() < this->size)
+		// Fast path: nobody is waiting, store the event without locking
+		if (!events.push(event, this->size))
+		{
+			return false;
+		}
+
+		if (!waiters)
 		{
-			// Save event
-			events.emplace_back(event);
 			return true;
 		}
 
-		return false;
+		// A receiver has started waiting concurrently and may have missed the event
+		semaphore_lock lock(mutex);
+
+		while (!sq.empty() && !events.empty())
+		{
+			const lv2_event stored = events.front();
+			events.pop_front();
+			deliver(stored);
+		}
+
+		return true;
 	}
 
+	semaphore_lock lock(mutex);
+
+	// Hand over events stored by concurrent fast path senders first
+	while (!sq.empty() && !events.empty())
+	{
+		const lv2_event stored = events.front();
+		events.pop_front();
+		deliver(stored);
+	}
+
+	if (sq.empty())
+	{
+		return events.push(event, this->size);
+	}
+
+	deliver(event);
+	return true;
+}
+
+void lv2_event_queue::deliver(const lv2_event& event)
+{
 	if (type == SYS_PPU_QUEUE)
 	{
 		// Store event in registers
@@ -52,26 +85,24 @@ bool lv2_event_queue::send(lv2_event event)
 
 		std::tie(ppu.gpr[4], ppu.gpr[5], ppu.gpr[6], ppu.gpr[7]) = event;
 
+		waiters = sq.size();
 		awake(ppu);
 	}
 	else
 	{
 		// Store event in In_MBox
-		auto& spu = static_cast<SPUThread&>(*sq.front());
-
 		// TODO: use protocol?
-		sq.pop_front();
+		auto& spu = static_cast<SPUThread&>(*schedule<SPUThread>(sq, SYS_SYNC_FIFO));
 
 		const u32 data1 = static_cast<u32>(std::get<1>(event));
 		const u32 data2 = static_cast<u32>(std::get<2>(event));
 		const u32 data3 = static_cast<u32>(std::get<3>(event));
 		spu.ch_in_mbox.set_values(4, CELL_OK, data1, data2, data3);
 
+		waiters = sq.size();
 		spu.state += cpu_flag::signal;
 		spu.notify();
 	}
-
-	return true;
 }
 
 error_code sys_event_queue_create(vm::ptr<u32> equeue_id, vm::ptr<sys_event_queue_attribute_t> attr, u64 event_queue_key, s32 size)
@@ -239,6 +270,9 @@ error_code sys_event_queue_receive(ppu_thread& ppu, u32 equeue_id, vm::ptr<sys_e
 
 		semaphore_lock lock(queue.mutex);
 
+		// Announce the receiver before checking, so that lock-free senders can't miss it
+		queue.waiters = queue.sq.size() + 1;
+
 		if (queue.events.empty())
 		{
 			queue.sq.emplace_back(&ppu);
@@ -248,6 +282,7 @@ error_code sys_event_queue_receive(ppu_thread& ppu, u32 equeue_id, vm::ptr<sys_e
 
 		std::tie(ppu.gpr[4], ppu.gpr[5], ppu.gpr[6], ppu.gpr[7]) = queue.events.front();
 		queue.events.pop_front();
+		queue.waiters = queue.sq.size();
 		return {};
 	});
 
@@ -285,6 +320,7 @@ error_code sys_event_queue_receive(ppu_thread& ppu, u32 equeue_id, vm::ptr<sys_e
 					continue;
 				}
 
+				queue->waiters = queue->sq.size();
 				ppu.gpr[3] = CELL_ETIMEDOUT;
 				break;
 			}
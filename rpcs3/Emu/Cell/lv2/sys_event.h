@@ -73,6 +73,92 @@ struct sys_event_t
 // Source, data1, data2, data3
 using lv2_event = std::tuple<u64, u64, u64, u64>;
 
+// Bounded event ring: lock-free push from any thread, pop is serialized by the queue mutex
+class lv2_event_ring
+{
+	static constexpr u32 capacity = 128;
+
+	struct slot
+	{
+		atomic_t<u32> seq;
+		lv2_event data;
+	};
+
+	std::array<slot, capacity> m_slots;
+
+	atomic_t<u32> m_push{0};
+	atomic_t<u32> m_pop{0};
+
+public:
+	lv2_event_ring()
+	{
+		for (u32 i = 0; i < capacity; i++)
+		{
+			m_slots[i].seq = i;
+		}
+	}
+
+	// Fails if `limit` events are already stored
+	bool push(const lv2_event& event, u32 limit)
+	{
+		while (true)
+		{
+			const u32 pos = m_push.load();
+
+			if (pos - m_pop.load() >= limit)
+			{
+				return false;
+			}
+
+			auto& _slot = m_slots[pos % capacity];
+
+			if (_slot.seq.load() != pos)
+			{
+				// Slot is still being consumed or another producer has taken it
+				continue;
+			}
+
+			if (m_push.compare_and_swap_test(pos, pos + 1))
+			{
+				_slot.data = event;
+				_slot.seq = pos + 1;
+				return true;
+			}
+		}
+	}
+
+	bool empty()
+	{
+		const u32 pos = m_pop.load();
+		return m_slots[pos % capacity].seq.load() != pos + 1;
+	}
+
+	u32 size()
+	{
+		return m_push.load() - m_pop.load();
+	}
+
+	const lv2_event& front()
+	{
+		return m_slots[m_pop.load() % capacity].data;
+	}
+
+	void pop_front()
+	{
+		const u32 pos = m_pop.load();
+		m_slots[pos % capacity].seq = pos + capacity;
+		m_pop = pos + 1;
+	}
+
+	void clear()
+	{
+		while (!empty())
+		{
+			pop_front();
+		}
+	}
+};
+
 struct lv2_event_queue final : public lv2_obj
 {
 	static const u32 id_base = 0x8d000000;
@@ -84,8 +170,11 @@ struct lv2_event_queue final : public lv2_obj
 	const s32 size;
 
 	semaphore<> mutex;
-	std::deque<lv2_event> events;
-	std::deque<cpu_thread*> sq;
+	lv2_event_ring events;
+	lv2_sleep_queue<cpu_thread> sq;
+
+	// Number of receivers about to sleep or sleeping (published before they check the events)
+	atomic_t<u32> waiters{0};
 
 	lv2_event_queue(u32 protocol, s32 type, u64 name, u64 ipc_key, s32 size)
 		: protocol(protocol)
@@ -98,6 +187,9 @@ struct lv2_event_queue final : public lv2_obj
 
 	bool send(lv2_event);
 
+	// Give event to the next receiver (sq must not be empty, mutex must be locked)
+	void deliver(const lv2_event& event);
+
 	bool send(u64 source, u64 d1, u64 d2, u64 d3)
 	{
 		return send(std::make_tuple(source, d1, d2, d3));
@@ -43,7 +43,7 @@ struct lv2_event_flag final : lv2_obj
 	semaphore<> mutex;
 	atomic_t<u32> waiters{0};
 	atomic_t<u64> pattern;
-	std::deque<cpu_thread*> sq;
+	lv2_sleep_queue<cpu_thread> sq;
 
 	lv2_event_flag(u32 protocol, u32 shared, u64 key, s32 flags, s32 type, u64 name, u64 pattern)
 		: protocol(protocol)
@@ -8,6 +8,8 @@
 #include "Emu/VFS.h"
 #include "Emu/IdManager.h"
 #include "Utilities/StrUtil.h"
+#include "Utilities/tracing.h"
+#include "Utilities/perf_counters.h"
 
 
 
@@ -64,21 +66,216 @@ lv2_fs_mount_point* lv2_fs_object::get_mp(const char* filename)
 	return &g_mp_sys_dev_hdd0;
 }
 
+// Size of the reusable per-thread buffer for transfers that can't target guest memory directly
+constexpr u64 c_fs_bounce_size = 0x100000;
+
+// Size of the per-file read-ahead window and the largest read considered for it
+constexpr u64 c_fs_read_ahead_size = 0x40000;
+constexpr u64 c_fs_read_ahead_max = c_fs_read_ahead_size / 4;
+
+static thread_local std::unique_ptr<u8[]> s_fs_bounce_buf;
+
+static u8* get_fs_bounce_buffer()
+{
+	if (!s_fs_bounce_buf)
+	{
+		s_fs_bounce_buf.reset(new u8[c_fs_bounce_size]);
+	}
+
+	return s_fs_bounce_buf.get();
+}
+
+// Get an unprotected host view of the guest range if it's a single mapping and no page is watched by the RSX caches
+static std::shared_ptr<u8> get_fs_direct_ptr(u32 addr, u64 size)
+{
+	if (!size || addr + size > 0x100000000)
+	{
+		return nullptr;
+	}
+
+	for (u64 page = addr / 4096, last = (addr + size - 1) / 4096; page <= last; page++)
+	{
+		if (vm::get_page_owner(static_cast<u32>(page * 4096)) != vm::page_owner::none)
+		{
+			return nullptr;
+		}
+	}
+
+	return vm::get_super_ptr<u8>(addr, static_cast<u32>(size));
+}
+
+bool lv2_file::op_read_ahead(vm::ptr<void> buf, u64 size, u64& result)
+{
+	// Writable files may change under the window, large reads gain nothing from it
+	if ((flags & CELL_FS_O_ACCMODE) != CELL_FS_O_RDONLY || !size || size > c_fs_read_ahead_max)
+	{
+		return false;
+	}
+
+	// Game data is already read through a file mapping
+	if (vfs::is_read_only_data(name.data()))
+	{
+		return false;
+	}
+
+	const u64 pos = file.pos();
+
+	ra_seq = pos == ra_next ? std::min<u32>(ra_seq + 1, 2) : 0;
+
+	ra_next = pos + size;
+
+	const bool hit = pos >= ra_pos && pos + size <= ra_pos + ra_size;
+
+	// Start prefetching after a few sequential reads in a row
+	if (!hit && ra_seq < 2)
+	{
+		return false;
+	}
+
+	if (!hit)
+	{
+		if (!ra_buf)
+		{
+			ra_buf.reset(new u8[c_fs_read_ahead_size]);
+		}
+
+		// Coalesce upcoming reads into a single host read
+		ra_pos = pos;
+		ra_size = file.read(ra_buf.get(), c_fs_read_ahead_size);
+	}
+
+	const u64 offset = pos - ra_pos;
+	result = pos < ra_pos + ra_size ? std::min<u64>(size, ra_size - offset) : 0;
+
+	if (const auto ptr = get_fs_direct_ptr(buf.addr(), result))
+	{
+		std::memcpy(ptr.get(), ra_buf.get() + offset, result);
+	}
+	else
+	{
+		std::memcpy(vm::base(buf.addr()), ra_buf.get() + offset, result);
+	}
+
+	// Keep the host position where a plain read would have left it
+	file.seek(pos + result);
+	ra_next = pos + result;
+	return true;
+}
+
 u64 lv2_file::op_read(vm::ptr<void> buf, u64 size)
 {
+	u64 result = 0;
+
+	if (op_read_ahead(buf, size, result))
+	{
+		return result;
+	}
+
+	// Read straight into guest memory through its unprotected view (never faults in the host API)
+	if (const auto ptr = get_fs_direct_ptr(buf.addr(), size))
+	{
+		return file.read(ptr.get(), size);
+	}
+
 	// Copy data from intermediate buffer (avoid passing vm pointer to a native API)
-	std::unique_ptr<u8[]> local_buf(new u8[size]);
-	const u64 result = file.read(local_buf.get(), size);
-	std::memcpy(buf.get_ptr(), local_buf.get(), result);
+	const auto local_buf = get_fs_bounce_buffer();
+
+	while (result < size)
+	{
+		const u64 chunk = std::min<u64>(size - result, c_fs_bounce_size);
+		const u64 nread = file.read(local_buf, chunk);
+		std::memcpy(vm::base(buf.addr() + static_cast<u32>(result)), local_buf, nread);
+		result += nread;
+
+		if (nread < chunk)
+		{
+			break;
+		}
+	}
+
 	return result;
 }
 
 u64 lv2_file::op_write(vm::cptr<void> buf, u64 size)
 {
+	if (const auto ptr = get_fs_direct_ptr(buf.addr(), size))
+	{
+		return file.write(ptr.get(), size);
+	}
+
 	// Copy data to intermediate buffer (avoid passing vm pointer to a native API)
-	std::unique_ptr<u8[]> local_buf(new u8[size]);
-	std::memcpy(local_buf.get(), buf.get_ptr(), size);
-	return file.write(local_buf.get(), size);
+	const auto local_buf = get_fs_bounce_buffer();
+
+	u64 result = 0;
+
+	while (result < size)
+	{
+		const u64 chunk = std::min<u64>(size - result, c_fs_bounce_size);
+		std::memcpy(local_buf, vm::base(buf.addr() + static_cast<u32>(result)), chunk);
+		const u64 nwritten = file.write(local_buf, chunk);
+		result += nwritten;
+
+		if (nwritten < chunk)
+		{
+			break;
+		}
+	}
+
+	return result;
+}
+
+u64 lv2_file::op_read_at(u64 offset, vm::ptr<void> buf, u64 size)
+{
+	if (const auto ptr = get_fs_direct_ptr(buf.addr(), size))
+	{
+		return file.read_at(offset, ptr.get(), size);
+	}
+
+	const auto local_buf = get_fs_bounce_buffer();
+
+	u64 result = 0;
+
+	while (result < size)
+	{
+		const u64 chunk = std::min<u64>(size - result, c_fs_bounce_size);
+		const u64 nread = file.read_at(offset + result, local_buf, chunk);
+		std::memcpy(vm::base(buf.addr() + static_cast<u32>(result)), local_buf, nread);
+		result += nread;
+
+		if (nread < chunk)
+		{
+			break;
+		}
+	}
+
+	return result;
+}
+
+u64 lv2_file::op_write_at(u64 offset, vm::cptr<void> buf, u64 size)
+{
+	if (const auto ptr = get_fs_direct_ptr(buf.addr(), size))
+	{
+		return file.write_at(offset, ptr.get(), size);
+	}
+
+	const auto local_buf = get_fs_bounce_buffer();
+
+	u64 result = 0;
+
+	while (result < size)
+	{
+		const u64 chunk = std::min<u64>(size - result, c_fs_bounce_size);
+		std::memcpy(local_buf, vm::base(buf.addr() + static_cast<u32>(result)), chunk);
+		const u64 nwritten = file.write_at(offset + result, local_buf, chunk);
+		result += nwritten;
+
+		if (nwritten < chunk)
+		{
+			break;
+		}
+	}
+
+	return result;
 }
 
 struct lv2_file::file_view : fs::file_base
@@ -280,6 +477,12 @@ error_code sys_fs_open(vm::cptr<char> path, s32 flags, vm::ptr<u32> fd, s32 mode
 		fmt::throw_exception("sys_fs_open(%s): Invalid or unimplemented flags: %#o" HERE, path, flags);
 	}
 
+	if (!test(open_mode & fs::write) && vfs::is_read_only_data(path.get_ptr()))
+	{
+		// Serve reads of game data (including SELF/SPRX loading through views) from a file mapping
+		open_mode += fs::mapped;
+	}
+
 	fs::file file(local_path, open_mode);
 
 	if (!file)
@@ -358,7 +561,7 @@ error_code sys_fs_open(vm::cptr<char> path, s32 flags, vm::ptr<u32> fd, s32 mode
 
 error_code sys_fs_read(u32 fd, vm::ptr<void> buf, u64 nbytes, vm::ptr<u64> nread)
 {
-	sys_fs.trace("sys_fs_read(fd=%d, buf=*0x%x, nbytes=0x%llx, nread=*0x%x)", fd, buf, nbytes, nread);
+	LOG_CHANNEL_MSG(sys_fs, trace, "sys_fs_read(fd=%d, buf=*0x%x, nbytes=0x%llx, nread=*0x%x)", fd, buf, nbytes, nread);
 
 	if (!buf)
 	{
@@ -372,16 +575,20 @@ error_code sys_fs_read(u32 fd, vm::ptr<void> buf, u64 nbytes, vm::ptr<u64> nread
 		return CELL_EBADF;
 	}
 
+	tracing::scope trace(tracing::category::fs, "sys_fs_read");
+	trace.set_arg("size", nbytes);
+
 	std::lock_guard<std::mutex> lock(file->mp->mutex);
 
 	*nread = file->op_read(buf, nbytes);
+	perf::fs_read_bytes.add(*nread);
 
 	return CELL_OK;
 }
 
 error_code sys_fs_write(u32 fd, vm::cptr<void> buf, u64 nbytes, vm::ptr<u64> nwrite)
 {
-	sys_fs.trace("sys_fs_write(fd=%d, buf=*0x%x, nbytes=0x%llx, nwrite=*0x%x)", fd, buf, nbytes, nwrite);
+	LOG_CHANNEL_MSG(sys_fs, trace, "sys_fs_write(fd=%d, buf=*0x%x, nbytes=0x%llx, nwrite=*0x%x)", fd, buf, nbytes, nwrite);
 
 	const auto file = idm::get<lv2_fs_object, lv2_file>(fd);
 
@@ -398,13 +605,14 @@ error_code sys_fs_write(u32 fd, vm::cptr<void> buf, u64 nbytes, vm::ptr<u64> nwr
 	}
 
 	*nwrite = file->op_write(buf, nbytes);
+	perf::fs_write_bytes.add(*nwrite);
 
 	return CELL_OK;
 }
 
 error_code sys_fs_close(u32 fd)
 {
-	sys_fs.trace("sys_fs_close(fd=%d)", fd);
+	LOG_CHANNEL_MSG(sys_fs, trace, "sys_fs_close(fd=%d)", fd);
 
 	const auto file = idm::withdraw<lv2_fs_object, lv2_file>(fd, [](lv2_file& file) -> CellError
 	{
@@ -763,7 +971,7 @@ error_code sys_fs_access(vm::cptr<char> path, s32 mode)
 
 error_code sys_fs_fcntl(u32 fd, u32 op, vm::ptr<void> _arg, u32 _size)
 {
-	sys_fs.trace("sys_fs_fcntl(fd=%d, op=0x%x, arg=*0x%x, size=0x%x)", fd, op, _arg, _size);
+	LOG_CHANNEL_MSG(sys_fs, trace, "sys_fs_fcntl(fd=%d, op=0x%x, arg=*0x%x, size=0x%x)", fd, op, _arg, _size);
 
 	switch (op)
 	{
@@ -816,14 +1024,9 @@ error_code sys_fs_fcntl(u32 fd, u32 op, vm::ptr<void> _arg, u32 _size)
 			return CELL_EBUSY;
 		}
 
-		const u64 old_pos = file->file.pos();
-		const u64 new_pos = file->file.seek(arg->offset);
-
 		arg->out_size = op == 0x8000000a
-			? file->op_read(arg->buf, arg->size)
-			: file->op_write(arg->buf, arg->size);
-
-		verify(HERE), old_pos == file->file.seek(old_pos);
+			? file->op_read_at(arg->offset, arg->buf, arg->size)
+			: file->op_write_at(arg->offset, arg->buf, arg->size);
 
 		arg->out_code = CELL_OK;
 		return CELL_OK;
@@ -1140,7 +1343,7 @@ error_code sys_fs_fcntl(u32 fd, u32 op, vm::ptr<void> _arg, u32 _size)
 
 error_code sys_fs_lseek(u32 fd, s64 offset, s32 whence, vm::ptr<u64> pos)
 {
-	sys_fs.trace("sys_fs_lseek(fd=%d, offset=0x%llx, whence=0x%x, pos=*0x%x)", fd, offset, whence, pos);
+	LOG_CHANNEL_MSG(sys_fs, trace, "sys_fs_lseek(fd=%d, offset=0x%llx, whence=0x%x, pos=*0x%x)", fd, offset, whence, pos);
 
 	if (whence >= 3)
 	{
@@ -170,6 +170,13 @@ struct lv2_file final : lv2_fs_object
 	// Stream lock
 	atomic_t<u32> lock{0};
 
+	// Read-ahead window (only used for sequential reads, protected by the mount point mutex)
+	std::unique_ptr<u8[]> ra_buf;
+	u64 ra_pos = 0; // File offset of the window
+	u64 ra_size = 0; // Valid bytes in the window
+	u64 ra_next = -1; // Offset right after the previous read
+	u32 ra_seq = 0; // Number of consecutive sequential reads
+
 	lv2_file(const char* filename, fs::file&& file, s32 mode, s32 flags)
 		: lv2_fs_object(lv2_fs_object::get_mp(filename), filename)
 		, file(std::move(file))
@@ -189,9 +196,16 @@ struct lv2_file final : lv2_fs_object
 	// File reading with intermediate buffer
 	u64 op_read(vm::ptr<void> buf, u64 size);
 
+	// Serve a sequential read from the read-ahead window (returns false if not applicable)
+	bool op_read_ahead(vm::ptr<void> buf, u64 size, u64& result);
+
 	// File writing with intermediate buffer
 	u64 op_write(vm::cptr<void> buf, u64 size);
 
+	// Positional file reading and writing (the file position is preserved)
+	u64 op_read_at(u64 offset, vm::ptr<void> buf, u64 size);
+	u64 op_write_at(u64 offset, vm::cptr<void> buf, u64 size);
+
 	// For MSELF support
 	struct file_view;
 
@@ -29,7 +29,7 @@ struct lv2_lwcond final : lv2_obj
 
 	semaphore<> mutex;
 	atomic_t<u32> waiters{0};
-	std::deque<cpu_thread*> sq;
+	lv2_sleep_queue<cpu_thread> sq;
 
 	lv2_lwcond(u64 name, u32 lwid, vm::ptr<sys_lwcond_t> control)
 		: name(name)
@@ -59,7 +59,12 @@ struct lv2_lwmutex final : lv2_obj
 
 	semaphore<> mutex;
 	atomic_t<u32> signaled{0};
-	std::deque<cpu_thread*> sq;
+	lv2_sleep_queue<cpu_thread> sq;
+
+	// Adaptive spinning in sys_lwmutex_lock (host-side contention stats)
+	atomic_t<u32> spin_hint{10}; // Average number of spins needed to acquire
+	atomic_t<u32> spin_acquired{0}; // Contended locks acquired while spinning
+	atomic_t<u32> spin_parked{0}; // Contended locks which went to sleep
 
 	lv2_lwmutex(u32 protocol, vm::ptr<sys_lwmutex_t> control, u64 name)
 		: protocol(protocol)
@@ -67,6 +72,30 @@ struct lv2_lwmutex final : lv2_obj
 		, name(name)
 	{
 	}
+
+	// Get spin limit for the next contended lock
+	u32 get_spin_limit() const
+	{
+		return std::min<u32>(spin_hint * 2 + 10, 100);
+	}
+
+	// Update the average spin count after a contended lock
+	void update_spin(u32 spins, bool acquired)
+	{
+		const u32 hint = spin_hint;
+
+		if (acquired)
+		{
+			spin_acquired++;
+			spin_hint = hint + (static_cast<s32>(spins) - static_cast<s32>(hint)) / 8;
+		}
+		else
+		{
+			// Spinning didn't help, the lock is likely held for a long time
+			spin_parked++;
+			spin_hint = hint - hint / 8;
+		}
+	}
 };
 
 // Aux
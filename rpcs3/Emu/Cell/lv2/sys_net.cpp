@@ -32,6 +32,32 @@ static std::vector<ppu_thread*> s_to_awake;
 
 static semaphore<> s_nw_mutex;
 
+#ifdef _WIN32
+// Network Thread wakeup event (also selected for socket events)
+static HANDLE s_nw_event = nullptr;
+#else
+// Network Thread wakeup pipe
+static int s_nw_wake[2]{-1, -1};
+#endif
+
+// Wake up Network Thread after changing the set of polled events
+static void network_thread_notify()
+{
+#ifdef _WIN32
+	if (s_nw_event)
+	{
+		SetEvent(s_nw_event);
+	}
+#else
+	if (s_nw_wake[1] != -1)
+	{
+		const char c = 0;
+		const auto result = ::write(s_nw_wake[1], &c, 1);
+		static_cast<void>(result); // Pipe is already signaled if full
+	}
+#endif
+}
+
 extern u64 get_system_time();
 
 // Error helper functions
@@ -121,20 +147,35 @@ extern void network_thread_init()
 
 #ifdef _WIN32
 		HANDLE _eventh = CreateEventW(nullptr, false, false, nullptr);
+		s_nw_event = _eventh;
 
 		WSADATA wsa_data;
 		WSAStartup(MAKEWORD(2, 2), &wsa_data);
 #else
-		::pollfd fds[lv2_socket::id_count]{};
+		// Last entry is reserved for the wakeup pipe
+		::pollfd fds[lv2_socket::id_count + 1]{};
+
+		verify(HERE), ::pipe(s_nw_wake) == 0;
+		::fcntl(s_nw_wake[0], F_SETFL, ::fcntl(s_nw_wake[0], F_GETFL, 0) | O_NONBLOCK);
+		::fcntl(s_nw_wake[1], F_SETFL, ::fcntl(s_nw_wake[1], F_GETFL, 0) | O_NONBLOCK);
+
+		fds[0].fd = s_nw_wake[0];
+		fds[0].events = POLLIN;
 #endif
 
 		do
 		{
-			// Wait with 1ms timeout
+			// Wait for socket events or a wakeup (the timeout only catches emulation stop)
 #ifdef _WIN32
-			WaitForSingleObjectEx(_eventh, 1, false);
+			WaitForSingleObjectEx(_eventh, 100, false);
 #else
-			::poll(fds, socklist.size(), 1);
+			::poll(fds, socklist.size() + 1, 100);
+
+			if (fds[socklist.size()].revents & POLLIN)
+			{
+				char buf[64];
+				while (::read(s_nw_wake[0], buf, sizeof(buf)) > 0);
+			}
 #endif
 
 			semaphore_lock lock(s_nw_mutex);
@@ -234,12 +275,22 @@ extern void network_thread_init()
 				fds[i].revents = 0;
 #endif
 			}
+
+#ifndef _WIN32
+			fds[socklist.size()].fd = s_nw_wake[0];
+			fds[socklist.size()].events = POLLIN;
+			fds[socklist.size()].revents = 0;
+#endif
 		}
 		while (!Emu.IsStopped());
 
 #ifdef _WIN32
+		s_nw_event = nullptr;
 		CloseHandle(_eventh);
 		WSACleanup();
+#else
+		::close(std::exchange(s_nw_wake[1], -1));
+		::close(std::exchange(s_nw_wake[0], -1));
 #endif
 	});
 }
@@ -320,6 +371,7 @@ s32 sys_net_bnet_accept(ppu_thread& ppu, s32 s, vm::ptr<sys_net_sockaddr> addr,
 			return false;
 		});
 
+		network_thread_notify();
 		lv2_obj::sleep(ppu);
 		return false;
 	});
@@ -495,6 +547,8 @@ s32 sys_net_bnet_connect(ppu_thread& ppu, s32 s, vm::ptr<sys_net_sockaddr> addr,
 					sock.events += lv2_socket::poll::write;
 					return false;
 				});
+
+				network_thread_notify();
 			}
 
 			return false;
@@ -528,6 +582,7 @@ s32 sys_net_bnet_connect(ppu_thread& ppu, s32 s, vm::ptr<sys_net_sockaddr> addr,
 			return false;
 		});
 
+		network_thread_notify();
 		lv2_obj::sleep(ppu);
 		return false;
 	});
@@ -928,6 +983,7 @@ s32 sys_net_bnet_recvfrom(ppu_thread& ppu, s32 s, vm::ptr<void> buf, u32 len, s3
 			return false;
 		});
 
+		network_thread_notify();
 		lv2_obj::sleep(ppu);
 		return false;
 	});
@@ -1081,6 +1137,7 @@ s32 sys_net_bnet_sendto(ppu_thread& ppu, s32 s, vm::cptr<void> buf, u32 len, s32
 			return false;
 		});
 
+		network_thread_notify();
 		lv2_obj::sleep(ppu);
 		return false;
 	});
@@ -1537,6 +1594,7 @@ s32 sys_net_bnet_poll(ppu_thread& ppu, vm::ptr<sys_net_pollfd> fds, s32 nfds, s3
 			}
 		}
 
+		network_thread_notify();
 		lv2_obj::sleep(ppu, timeout);
 	}
 	else
@@ -1731,6 +1789,7 @@ s32 sys_net_bnet_select(ppu_thread& ppu, s32 nfds, vm::ptr<sys_net_fd_set> readf
 			}
 		}
 
+		network_thread_notify();
 		lv2_obj::sleep(ppu, timeout);
 	}
 	else
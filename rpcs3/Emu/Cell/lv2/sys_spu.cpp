@@ -71,8 +71,88 @@ void sys_spu_image::free()
 	}
 }
 
+// Hashes of deployed SPU images (segment table -> contents of COPY segments and the image hash)
+struct spu_image_cache
+{
+	struct entry
+	{
+		std::vector<u8> data;
+		std::string hash;
+	};
+
+	semaphore<> mutex;
+	std::unordered_map<std::string, entry> map;
+};
+
 void sys_spu_image::deploy(u32 loc, sys_spu_segment* segs, u32 nsegs)
 {
+	// Copy segments to LS
+	for (u32 i = 0; i < nsegs; i++)
+	{
+		auto& seg = segs[i];
+
+		if (seg.type == SYS_SPU_SEGMENT_TYPE_COPY)
+		{
+			std::memcpy(vm::base(loc + seg.ls), vm::base(seg.addr), seg.size);
+		}
+		else if (seg.type == SYS_SPU_SEGMENT_TYPE_FILL)
+		{
+			if ((seg.ls | seg.size) % 4)
+			{
+				LOG_ERROR(SPU, "Unaligned SPU FILL type segment (ls=0x%x, size=0x%x)", seg.ls, seg.size);
+			}
+
+			std::fill_n(vm::_ptr<u32>(loc + seg.ls), seg.size / 4, seg.addr);
+		}
+	}
+
+	// Groups restarted every frame deploy the same image again: reuse its hash if the data is unchanged
+	const auto cache = fxm::get_always<spu_image_cache>();
+
+	std::string key(reinterpret_cast<const char*>(segs), nsegs * sizeof(sys_spu_segment));
+
+	std::string hash;
+	{
+		semaphore_lock lock(cache->mutex);
+
+		const auto found = cache->map.find(key);
+
+		if (found != cache->map.end())
+		{
+			const u8* data = found->second.data.data();
+			bool match = true;
+
+			for (u32 i = 0; i < nsegs && match; i++)
+			{
+				if (segs[i].type == SYS_SPU_SEGMENT_TYPE_COPY)
+				{
+					match = std::memcmp(vm::base(loc + segs[i].ls), data, segs[i].size) == 0;
+					data += segs[i].size;
+				}
+			}
+
+			if (match)
+			{
+				hash = found->second.hash;
+			}
+		}
+	}
+
+	if (!hash.empty())
+	{
+		// Apply the patch
+		auto applied = fxm::check_unlocked<patch_engine>()->apply(hash, vm::g_base_addr + loc);
+
+		if (!Emu.GetTitleID().empty())
+		{
+			// Alternative patch
+			applied += fxm::check_unlocked<patch_engine>()->apply(Emu.GetTitleID() + '-' + hash, vm::g_base_addr + loc);
+		}
+
+		LOG_TRACE(LOADER, "Loaded SPU image: %s (<- %u, cached)", hash, applied);
+		return;
+	}
+
 	// Segment info dump
 	std::string dump;
 
@@ -81,6 +161,9 @@ void sys_spu_image::deploy(u32 loc, sys_spu_segment* segs, u32 nsegs)
 	sha1_starts(&sha);
 	u8 sha1_hash[20];
 
+	// Contents of COPY segments for the cache
+	std::vector<u8> data;
+
 	for (u32 i = 0; i < nsegs; i++)
 	{
 		auto& seg = segs[i];
@@ -92,19 +175,13 @@ void sys_spu_image::deploy(u32 loc, sys_spu_segment* segs, u32 nsegs)
 		// Hash big-endian values
 		if (seg.type == SYS_SPU_SEGMENT_TYPE_COPY)
 		{
-			std::memcpy(vm::base(loc + seg.ls), vm::base(seg.addr), seg.size);
 			sha1_update(&sha, (uchar*)&seg.size, sizeof(seg.size));
 			sha1_update(&sha, (uchar*)&seg.ls, sizeof(seg.ls));
 			sha1_update(&sha, vm::g_base_addr + seg.addr, seg.size);
+			data.insert(data.end(), vm::_ptr<u8>(loc + seg.ls), vm::_ptr<u8>(loc + seg.ls) + seg.size);
 		}
 		else if (seg.type == SYS_SPU_SEGMENT_TYPE_FILL)
 		{
-			if ((seg.ls | seg.size) % 4)
-			{
-				LOG_ERROR(SPU, "Unaligned SPU FILL type segment (ls=0x%x, size=0x%x)", seg.ls, seg.size);
-			}
-
-			std::fill_n(vm::_ptr<u32>(loc + seg.ls), seg.size / 4, seg.addr);
 			sha1_update(&sha, (uchar*)&seg.size, sizeof(seg.size));
 			sha1_update(&sha, (uchar*)&seg.ls, sizeof(seg.ls));
 			sha1_update(&sha, (uchar*)&seg.addr, sizeof(seg.addr));
@@ -119,7 +196,7 @@ void sys_spu_image::deploy(u32 loc, sys_spu_segment* segs, u32 nsegs)
 	sha1_finish(&sha, sha1_hash);
 
 	// Format patch name
-	std::string hash("SPU-0000000000000000000000000000000000000000");
+	hash = "SPU-0000000000000000000000000000000000000000";
 	for (u32 i = 0; i < sizeof(sha1_hash); i++)
 	{
 		constexpr auto pal = "0123456789abcdef";
@@ -127,6 +204,17 @@ void sys_spu_image::deploy(u32 loc, sys_spu_segment* segs, u32 nsegs)
 		hash[5 + i * 2] = pal[sha1_hash[i] & 15];
 	}
 
+	{
+		semaphore_lock lock(cache->mutex);
+
+		if (cache->map.size() >= 1024)
+		{
+			cache->map.clear();
+		}
+
+		cache->map[std::move(key)] = {std::move(data), hash};
+	}
+
 	// Apply the patch
 	auto applied = fxm::check_unlocked<patch_engine>()->apply(hash, vm::g_base_addr + loc);
 
@@ -773,6 +861,7 @@ error_code sys_spu_thread_write_ls(u32 id, u32 lsa, u64 value, u32 type)
 	default: return CELL_EINVAL;
 	}
 
+	thread->ls_written(lsa, type);
 	return CELL_OK;
 }
 
@@ -11,6 +11,7 @@
 #include "Emu/IPC.h"
 
 #include <deque>
+#include <unordered_map>
 
 // attr_protocol (waiting scheduling policy)
 enum
@@ -55,6 +56,283 @@ enum
 	SYS_SYNC_ATTR_ADAPTIVE_MASK  = 0xf000,
 };
 
+// Get the priority used to order the thread in sleep queues (0 for non-PPU threads)
+u32 lv2_sleep_prio(cpu_thread* cpu);
+
+// Queue of sleeping threads: FIFO bucket for each priority, bitmap of non-empty buckets.
+// Iteration and priority pop go in (priority, arrival) order, FIFO pop goes in arrival order.
+template <typename T>
+class lv2_sleep_queue
+{
+public:
+	// PPU priorities are 0..3071, anything beyond shares the last bucket
+	static constexpr u32 max_prio = 4096;
+
+private:
+	// Arrival order, thread
+	using bucket = std::deque<std::pair<u64, T*>>;
+
+	std::unordered_map<u32, bucket> m_buckets;
+
+	// Thread -> priority bucket it was queued in
+	std::unordered_map<T*, u32> m_prio;
+
+	std::array<u64, max_prio / 64> m_mask{};
+	u64 m_mask_words = 0;
+	u64 m_order = 0;
+
+	// Find first non-empty priority bucket starting from prio (max_prio if none)
+	u32 next_prio(u32 prio) const
+	{
+		if (prio >= max_prio)
+		{
+			return max_prio;
+		}
+
+		u32 word = prio / 64;
+
+		if (const u64 bits = m_mask[word] & (~0ull << (prio % 64)))
+		{
+			return word * 64 + static_cast<u32>(cnttz64(bits, true));
+		}
+
+		const u64 words = word + 1 < 64 ? m_mask_words & (~0ull << (word + 1)) : 0;
+
+		if (!words)
+		{
+			return max_prio;
+		}
+
+		word = static_cast<u32>(cnttz64(words, true));
+		return word * 64 + static_cast<u32>(cnttz64(m_mask[word], true));
+	}
+
+	T* take(u32 prio, typename bucket::iterator it)
+	{
+		auto& list = m_buckets[prio];
+		const auto res = it->second;
+		list.erase(it);
+		m_prio.erase(res);
+
+		if (list.empty())
+		{
+			if (!(m_mask[prio / 64] &= ~(1ull << (prio % 64))))
+			{
+				m_mask_words &= ~(1ull << (prio / 64));
+			}
+		}
+
+		return res;
+	}
+
+public:
+	class iterator
+	{
+		const lv2_sleep_queue* m_queue;
+		u32 m_prio;
+		std::size_t m_pos;
+
+	public:
+		iterator(const lv2_sleep_queue* queue, u32 prio, std::size_t pos)
+			: m_queue(queue)
+			, m_prio(prio)
+			, m_pos(pos)
+		{
+		}
+
+		T* operator*() const
+		{
+			return m_queue->m_buckets.at(m_prio)[m_pos].second;
+		}
+
+		iterator& operator++()
+		{
+			if (++m_pos >= m_queue->m_buckets.at(m_prio).size())
+			{
+				m_prio = m_queue->next_prio(m_prio + 1);
+				m_pos = 0;
+			}
+
+			return *this;
+		}
+
+		bool operator==(const iterator& rhs) const
+		{
+			return m_prio == rhs.m_prio && m_pos == rhs.m_pos;
+		}
+
+		bool operator!=(const iterator& rhs) const
+		{
+			return !(*this == rhs);
+		}
+
+		// Priority bucket of the current element
+		u32 prio() const
+		{
+			return m_prio;
+		}
+	};
+
+	iterator begin() const
+	{
+		return {this, next_prio(0), 0};
+	}
+
+	iterator end() const
+	{
+		return {this, max_prio, 0};
+	}
+
+	std::size_t size() const
+	{
+		return m_prio.size();
+	}
+
+	bool empty() const
+	{
+		return m_prio.empty();
+	}
+
+	bool contains(T* ptr) const
+	{
+		return m_prio.count(ptr) != 0;
+	}
+
+	void clear()
+	{
+		m_buckets.clear();
+		m_prio.clear();
+		m_mask = {};
+		m_mask_words = 0;
+	}
+
+	// Queue the thread after all threads of the same priority
+	void emplace_back(T* ptr, u32 prio)
+	{
+		prio = std::min<u32>(prio, max_prio - 1);
+
+		m_buckets[prio].emplace_back(m_order++, ptr);
+		m_prio.emplace(ptr, prio);
+		m_mask[prio / 64] |= 1ull << (prio % 64);
+		m_mask_words |= 1ull << (prio / 64);
+	}
+
+	void emplace_back(T* ptr)
+	{
+		emplace_back(ptr, lv2_sleep_prio(ptr));
+	}
+
+	// Remove the thread if queued
+	bool remove(T* ptr)
+	{
+		const auto found = m_prio.find(ptr);
+
+		if (found == m_prio.end())
+		{
+			return false;
+		}
+
+		const u32 prio = found->second;
+		auto& list = m_buckets[prio];
+
+		for (auto it = list.begin(); it != list.end(); it++)
+		{
+			if (it->second == ptr)
+			{
+				take(prio, it);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Remove and return the first thread by arrival (FIFO) or by priority
+	T* pop(bool fifo)
+	{
+		const u32 first = next_prio(0);
+
+		if (first == max_prio)
+		{
+			return nullptr;
+		}
+
+		u32 prio = first;
+
+		if (fifo)
+		{
+			// Find the oldest thread among bucket heads
+			u64 order = -1;
+
+			for (u32 i = first; i < max_prio; i = next_prio(i + 1))
+			{
+				const u64 _order = m_buckets[i].front().first;
+
+				if (_order < order)
+				{
+					order = _order;
+					prio = i;
+				}
+			}
+		}
+
+		return take(prio, m_buckets[prio].begin());
+	}
+
+	// Call func for each thread in arrival order (fifo) or in iteration order
+	template <typename F>
+	void for_each(bool fifo, F&& func) const
+	{
+		if (!fifo)
+		{
+			for (T* ptr : *this)
+			{
+				func(ptr);
+			}
+
+			return;
+		}
+
+		std::vector<std::pair<u64, T*>> list;
+		list.reserve(size());
+
+		for (u32 prio = next_prio(0); prio < max_prio; prio = next_prio(prio + 1))
+		{
+			const auto& queue = m_buckets.at(prio);
+			list.insert(list.end(), queue.begin(), queue.end());
+		}
+
+		std::sort(list.begin(), list.end());
+
+		for (const auto& pair : list)
+		{
+			func(pair.second);
+		}
+	}
+
+	// Remove all threads for which pred returns true, in iteration order
+	template <typename F>
+	u32 remove_if(F&& pred)
+	{
+		std::vector<T*> removed;
+
+		for (T* ptr : *this)
+		{
+			if (pred(ptr))
+			{
+				removed.emplace_back(ptr);
+			}
+		}
+
+		for (T* ptr : removed)
+		{
+			remove(ptr);
+		}
+
+		return ::size32(removed);
+	}
+};
+
 // Base class for some kernel objects (shared set of 8192 objects).
 struct lv2_obj
 {
@@ -79,6 +357,18 @@ struct lv2_obj
 		return false;
 	}
 
+	template <typename T, typename E>
+	static bool unqueue(lv2_sleep_queue<T>& queue, const E& object)
+	{
+		return queue.remove(static_cast<T*>(object));
+	}
+
+	template <typename E, typename T>
+	static T* schedule(lv2_sleep_queue<T>& queue, u32 protocol)
+	{
+		return queue.pop(protocol == SYS_SYNC_FIFO);
+	}
+
 	template <typename E, typename T>
 	static T* schedule(std::deque<T*>& queue, u32 protocol)
 	{
@@ -138,6 +428,9 @@ struct lv2_obj
 
 	static void cleanup();
 
+	// Notify threads whose timeout has expired, return the next timeout time (-1 if none)
+	static u64 check_timeouts();
+
 	template <typename T, typename F>
 	static error_code create(u32 pshared, u64 ipc_key, s32 flags, F&& make)
 	{
@@ -218,7 +511,7 @@ private:
 	static semaphore<> g_mutex;
 
 	// Scheduler queue for active PPU threads
-	static std::deque<class ppu_thread*> g_ppu;
+	static lv2_sleep_queue<class ppu_thread> g_ppu;
 
 	// Waiting for the response from
 	static std::deque<class cpu_thread*> g_pending;
@@ -227,4 +520,6 @@ private:
 	static std::deque<std::pair<u64, named_thread*>> g_waiting;
 
 	static void schedule_all();
+
+	static u64 notify_timeouts();
 };
@@ -17,57 +17,108 @@ logs::channel sys_timer("sys_timer");
 
 extern u64 get_system_time();
 
-void lv2_timer::on_task()
+// Running timer thread (set while the emulation is running)
+static atomic_t<lv2_timer_thread*> s_timer_thread{nullptr};
+
+extern void lv2_timer_thread_init()
 {
-	while (!Emu.IsStopped())
+	s_timer_thread = fxm::make_always<lv2_timer_thread>().get();
+}
+
+void lv2_timer_notify()
+{
+	if (const auto thread = s_timer_thread.load())
 	{
-		const u32 _state = state;
+		thread->notify();
+	}
+}
 
-		if (_state == SYS_TIMER_STATE_RUN)
+u64 lv2_timer::check(u64 _now)
+{
+	semaphore_lock lock(mutex);
+
+	while (state == SYS_TIMER_STATE_RUN)
+	{
+		const u64 next = expire;
+
+		if (_now < next)
 		{
-			const u64 _now = get_system_time();
-			const u64 next = expire;
+			return next;
+		}
 
-			if (_now >= next)
+		if (const auto queue = port.lock())
+		{
+			queue->send(source, data1, data2, next);
+
+			if (period)
 			{
-				semaphore_lock lock(mutex);
-
-				if (const auto queue = port.lock())
-				{
-					queue->send(source, data1, data2, next);
-
-					if (period)
-					{
-						// Set next expiration time and check again (HACK)
-						expire += period;
-						continue;
-					}
-				}
-
-				// Stop: oneshot or the event port was disconnected (TODO: is it correct?)
-				state = SYS_TIMER_STATE_STOP;
+				// Set next expiration time and check again (HACK)
+				expire += period;
 				continue;
 			}
+		}
+
+		// Stop: oneshot or the event port was disconnected (TODO: is it correct?)
+		state = SYS_TIMER_STATE_STOP;
+	}
+
+	return -1;
+}
 
-			// TODO: use single global dedicated thread for busy waiting, no timer threads
-			lv2_obj::sleep_timeout(*this, next - _now);
-			thread_ctrl::wait_for(next - _now);
+void lv2_timer_thread::on_task()
+{
+#ifdef __linux__
+	constexpr u64 host_min_quantum = 100;
+#else
+	// Host scheduler quantum for windows (worst case)
+	constexpr u64 host_min_quantum = 500;
+#endif
+
+	std::vector<std::shared_ptr<lv2_timer>> timers;
+
+	while (!Emu.IsStopped())
+	{
+		u64 next = lv2_obj::check_timeouts();
+
+		// Obtain all timers
+		idm::select<lv2_obj, lv2_timer>([&](u32 id, lv2_timer&)
+		{
+			timers.emplace_back(idm::get_unlocked<lv2_obj, lv2_timer>(id));
+		});
+
+		const u64 _now = get_system_time();
+
+		for (const auto& timer : timers)
+		{
+			next = std::min(next, timer->check(_now));
 		}
-		else if (_state == SYS_TIMER_STATE_STOP)
+
+		timers.clear();
+
+		if (next == -1)
+		{
+			thread_ctrl::wait();
+			continue;
+		}
+
+		const u64 now = get_system_time();
+
+		if (next > now + host_min_quantum)
 		{
-			thread_ctrl::wait_for(10000);
+			// Wait on the host timer until close to the deadline
+			thread_ctrl::wait_for(next - now - host_min_quantum);
 		}
-		else
+		else if (next > now)
 		{
-			break;
+			// Spin for the remaining time to get accurate expiration
+			std::this_thread::yield();
 		}
 	}
 }
 
-void lv2_timer::on_stop()
+void lv2_timer_thread::on_stop()
 {
-	// Signal thread using invalid state
-	state = -1;
+	s_timer_thread = nullptr;
 	notify();
 	join();
 }
@@ -171,7 +222,7 @@ error_code _sys_timer_start(u32 timer_id, u64 base_time, u64 period)
 		timer.expire = base_time ? base_time : start_time + period;
 		timer.period = period;
 		timer.state  = SYS_TIMER_STATE_RUN;
-		timer.notify();
+		lv2_timer_notify();
 		return {};
 	});
 
@@ -17,12 +17,12 @@ struct sys_timer_information_t
 	be_t<u32> pad;
 };
 
-struct lv2_timer final : public lv2_obj, public named_thread
+struct lv2_timer final : public lv2_obj
 {
 	static const u32 id_base = 0x11000000;
 
-	void on_task() override;
-	void on_stop() override;
+	// Send expired events, return the next expiration time (-1 if stopped)
+	u64 check(u64 _now);
 
 	semaphore<> mutex;
 	atomic_t<u32> state{SYS_TIMER_STATE_STOP};
@@ -36,6 +36,20 @@ struct lv2_timer final : public lv2_obj, public named_thread
 	atomic_t<u64> period{0}; // Period (oneshot if 0)
 };
 
+// Single thread servicing all lv2 timers and scheduler timeouts
+class lv2_timer_thread final : public named_thread
+{
+	void on_task() override;
+
+public:
+	std::string get_name() const override { return "LV2 Timer Thread"; }
+
+	void on_stop() override;
+};
+
+// Wake up the timer thread after a timer or a timeout has been registered
+void lv2_timer_notify();
+
 class ppu_thread;
 
 // Syscalls
@@ -1,10 +1,14 @@
 #include "stdafx.h"
 #include "IdManager.h"
 
-shared_mutex id_manager::g_mutex;
+static lock_class s_idm_lock_class{"idm", 20};
+shared_mutex id_manager::g_mutex{s_idm_lock_class};
+
+id_manager::slot_ref id_manager::g_slot_refs[id_manager::slot_ref_count];
 
 thread_local DECLARE(idm::g_id);
 DECLARE(idm::g_map);
+DECLARE(idm::g_map_size);
 DECLARE(fxm::g_vec);
 
 id_manager::id_map::pointer idm::allocate_id(const id_manager::id_key& info, u32 base, u32 step, u32 count)
@@ -24,6 +28,7 @@ id_manager::id_map::pointer idm::allocate_id(const id_manager::id_key& info, u32
 		{
 			g_id = _next;
 			vec.emplace_back(id_manager::id_key(_next, info.type(), info.on_stop()), nullptr);
+			g_map_size[info.value()] = ::size32(vec);
 			return &vec.back();
 		}
 	}
@@ -50,6 +55,7 @@ void idm::init()
 {
 	// Allocate
 	g_map.resize(id_manager::typeinfo::get_count());
+	g_map_size = std::make_unique<atomic_t<u32>[]>(g_map.size());
 	idm::clear();
 }
 
@@ -58,6 +64,8 @@ void idm::clear()
 	// Call recorded finalization functions for all IDs
 	for (auto& map : g_map)
 	{
+		g_map_size[&map - g_map.data()] = 0;
+
 		for (auto& pair : map)
 		{
 			if (auto ptr = pair.second.get())
@@ -9,9 +9,72 @@
 // Helper namespace
 namespace id_manager
 {
-	// Common global mutex
+	// Common global mutex (serializes creation, removal and enumeration)
 	extern shared_mutex g_mutex;
 
+	// Slot reference counters for lookups by ID, hashed by type and index
+	struct alignas(64) slot_ref
+	{
+		atomic_t<u32> refs{0};
+	};
+
+	constexpr u32 slot_ref_count = 1024;
+	constexpr u32 slot_ref_writer = 0x80000000;
+
+	extern slot_ref g_slot_refs[slot_ref_count];
+
+	inline atomic_t<u32>& get_slot_ref(u32 type, u32 index)
+	{
+		return g_slot_refs[(type * 0x9e3779b1u + index) % slot_ref_count].refs;
+	}
+
+	// Pin the slot for lookup, the object can't be assigned or removed meanwhile
+	class slot_reader
+	{
+		atomic_t<u32>& m_ref;
+
+	public:
+		slot_reader(atomic_t<u32>& ref)
+			: m_ref(ref)
+		{
+			while (UNLIKELY(m_ref.fetch_add(1) & slot_ref_writer))
+			{
+				m_ref.fetch_sub(1);
+				busy_wait(100);
+			}
+		}
+
+		slot_reader(const slot_reader&) = delete;
+
+		~slot_reader()
+		{
+			m_ref.fetch_sub(1);
+		}
+	};
+
+	// Wait for readers of the slot to leave, used with g_mutex locked
+	class slot_writer
+	{
+		atomic_t<u32>& m_ref;
+
+	public:
+		slot_writer(atomic_t<u32>& ref)
+			: m_ref(ref)
+		{
+			while (UNLIKELY(!m_ref.compare_and_swap_test(0, slot_ref_writer)))
+			{
+				busy_wait(100);
+			}
+		}
+
+		slot_writer(const slot_writer&) = delete;
+
+		~slot_writer()
+		{
+			m_ref.fetch_sub(slot_ref_writer);
+		}
+	};
+
 	// ID traits
 	template <typename T, typename = void>
 	struct id_traits
@@ -183,6 +246,9 @@ class idm
 	// Type Index -> ID -> Object. Use global since only one process is supported atm.
 	static std::vector<id_manager::id_map> g_map;
 
+	// Type Index -> Published map size, lookups without g_mutex never read beyond it
+	static std::unique_ptr<atomic_t<u32>[]> g_map_size;
+
 	template <typename T>
 	static inline u32 get_type()
 	{
@@ -195,6 +261,13 @@ class idm
 		return (id - id_manager::id_traits<T>::base) / id_manager::id_traits<T>::step;
 	}
 
+	// Get slot reference counter for the ID
+	template <typename T, typename Type>
+	static inline atomic_t<u32>& get_slot_ref(u32 id)
+	{
+		return id_manager::get_slot_ref(get_type<T>(), get_index<Type>(id));
+	}
+
 	// Helper
 	template <typename F>
 	struct function_traits;
@@ -276,7 +349,7 @@ class idm
 
 		auto& vec = g_map[get_type<T>()];
 
-		if (index >= vec.size() || index >= id_manager::id_traits<Type>::count)
+		if (index >= g_map_size[get_type<T>()].load() || index >= id_manager::id_traits<Type>::count)
 		{
 			return nullptr;
 		}
@@ -312,10 +385,12 @@ class idm
 		if (auto* place = allocate_id(info, traits::base, traits::step, traits::count))
 		{
 			// Get object, store it
-			place->second = provider();
+			std::shared_ptr<void> ptr = provider();
 
-			if (place->second)
+			if (ptr)
 			{
+				id_manager::slot_writer slot(get_slot_ref<T, Type>(place->first));
+				place->second = std::move(ptr);
 				return place;
 			}
 		}
@@ -411,7 +486,7 @@ public:
 	template <typename T, typename Get = T>
 	static inline Get* check(u32 id)
 	{
-		reader_lock lock(id_manager::g_mutex);
+		id_manager::slot_reader slot(get_slot_ref<T, Get>(id));
 
 		return check_unlocked<T, Get>(id);
 	}
@@ -420,7 +495,7 @@ public:
 	template <typename T, typename Get = T, typename F, typename FRT = std::result_of_t<F(Get&)>, typename = std::enable_if_t<std::is_void<FRT>::value>>
 	static inline Get* check(u32 id, F&& func, int = 0)
 	{
-		reader_lock lock(id_manager::g_mutex);
+		id_manager::slot_reader slot(get_slot_ref<T, Get>(id));
 
 		if (const auto ptr = check_unlocked<T, Get>(id))
 		{
@@ -435,7 +510,7 @@ public:
 	template <typename T, typename Get = T, typename F, typename FRT = std::result_of_t<F(Get&)>, typename = std::enable_if_t<!std::is_void<FRT>::value>>
 	static inline return_pair<Get*, FRT> check(u32 id, F&& func)
 	{
-		reader_lock lock(id_manager::g_mutex);
+		id_manager::slot_reader slot(get_slot_ref<T, Get>(id));
 
 		if (const auto ptr = check_unlocked<T, Get>(id))
 		{
@@ -463,7 +538,7 @@ public:
 	template <typename T, typename Get = T>
 	static inline std::shared_ptr<Get> get(u32 id)
 	{
-		reader_lock lock(id_manager::g_mutex);
+		id_manager::slot_reader slot(get_slot_ref<T, Get>(id));
 
 		const auto found = find_id<T, Get>(id);
 
@@ -481,7 +556,7 @@ public:
 	{
 		using result_type = std::shared_ptr<Get>;
 
-		reader_lock lock(id_manager::g_mutex);
+		id_manager::slot_reader slot(get_slot_ref<T, Get>(id));
 
 		const auto found = find_id<T, Get>(id);
 
@@ -503,7 +578,7 @@ public:
 	{
 		using result_type = return_pair<Get, FRT>;
 
-		reader_lock lock(id_manager::g_mutex);
+		id_manager::slot_reader slot(get_slot_ref<T, Get>(id));
 
 		const auto found = find_id<T, Get>(id);
 
@@ -542,6 +617,29 @@ public:
 		return result;
 	}
 
+	// Get references to all objects of specified type, g_mutex is only held while they are copied so the objects can be inspected without blocking the emulator
+	template <typename T, typename Get = T>
+	static inline std::vector<std::pair<u32, std::shared_ptr<Get>>> snapshot()
+	{
+		static_assert(id_manager::id_verify<T, Get>::value, "Invalid ID type combination");
+
+		std::vector<std::pair<u32, std::shared_ptr<Get>>> result;
+
+		reader_lock lock(id_manager::g_mutex);
+
+		result.reserve(g_map[get_type<T>()].size());
+
+		for (auto& id : g_map[get_type<T>()])
+		{
+			if (id.second && (std::is_same<T, Get>::value || id.first.type() == get_type<Get>()))
+			{
+				result.emplace_back(id.first, std::shared_ptr<Get>(id.second, static_cast<Get*>(id.second.get())));
+			}
+		}
+
+		return result;
+	}
+
 	// Access all objects of specified type. If function result evaluates to true, stop and return the object and the value.
 	template <typename T, typename Get = T, typename F, typename FT = decltype(&std::decay_t<F>::operator()), typename FRT = typename function_traits<FT>::result_type>
 	static inline auto select(F&& func)
@@ -577,6 +675,7 @@ public:
 		std::shared_ptr<void> ptr;
 		{
 			writer_lock lock(id_manager::g_mutex);
+			id_manager::slot_writer slot(get_slot_ref<T, Get>(id));
 
 			if (const auto found = find_id<T, Get>(id))
 			{
@@ -599,6 +698,7 @@ public:
 		std::shared_ptr<void> ptr;
 		{
 			writer_lock lock(id_manager::g_mutex);
+			id_manager::slot_writer slot(get_slot_ref<T, Get>(id));
 
 			if (const auto found = find_id<T, Get>(id))
 			{
@@ -623,6 +723,7 @@ public:
 		std::shared_ptr<void> ptr;
 		{
 			writer_lock lock(id_manager::g_mutex);
+			id_manager::slot_writer slot(get_slot_ref<T, Get>(id));
 
 			if (const auto found = find_id<T, Get>(id))
 			{
@@ -650,6 +751,7 @@ public:
 		FRT ret;
 		{
 			writer_lock lock(id_manager::g_mutex);
+			id_manager::slot_writer slot(get_slot_ref<T, Get>(id));
 
 			if (const auto found = find_id<T, Get>(id))
 			{
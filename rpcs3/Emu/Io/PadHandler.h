@@ -456,6 +456,8 @@ public:
 	virtual std::vector<std::string> ListDevices() = 0;
 	//Callback called during pad_thread::ThreadFunc
 	virtual void ThreadProc() = 0;
+	//Blocks until new input is available or timeout (in microseconds) expires, returns false if not supported
+	virtual bool WaitForEvents(u64 /*timeout*/) { return false; };
 	//Binds a Pad to a device
 	virtual bool bindPadToDevice(std::shared_ptr<Pad> /*pad*/, const std::string& /*device*/) = 0;
 	virtual void init_config(pad_config* /*cfg*/, const std::string& /*name*/) = 0;
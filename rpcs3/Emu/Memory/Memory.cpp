@@ -11,6 +11,41 @@ VirtualMemoryBlock* VirtualMemoryBlock::SetRange(const u32 start, const u32 size
 	return this;
 }
 
+void VirtualMemoryBlock::UpdateTables()
+{
+	std::array<u32, 4096> real_pages, mapped_pages;
+	real_pages.fill(-1);
+	mapped_pages.fill(-1);
+
+	m_unaligned = false;
+
+	for (const auto& info : m_mapped_memory)
+	{
+		if ((info.addr | info.realAddress | info.size) % 0x100000)
+		{
+			m_unaligned = true;
+			continue;
+		}
+
+		for (u32 i = 0; i < info.size >> 20; i++)
+		{
+			// Keep the first matching mapping, like the list scan does
+			u32& real = real_pages[(info.addr >> 20) + i & 0xfff];
+			u32& mapped = mapped_pages[(info.realAddress >> 20) + i & 0xfff];
+
+			if (real == -1) real = info.realAddress + (i << 20);
+			if (mapped == -1) mapped = info.addr + (i << 20);
+		}
+	}
+
+	// Entries are replaced one by one so that unchanged pages stay valid for concurrent readers
+	for (u32 i = 0; i < 4096; i++)
+	{
+		m_real_pages[i] = real_pages[i];
+		m_mapped_pages[i] = mapped_pages[i];
+	}
+}
+
 bool VirtualMemoryBlock::IsInMyRange(const u32 addr, const u32 size)
 {
 	return addr >= m_range_start && addr + size <= m_range_start + m_range_size - GetReservedAmount();
@@ -24,6 +59,7 @@ bool VirtualMemoryBlock::Map(u32 realaddr, u32 size, u32 addr)
 	}
 
 	m_mapped_memory.emplace_back(addr, realaddr, size);
+	UpdateTables();
 	return true;
 }
 
@@ -35,6 +71,7 @@ bool VirtualMemoryBlock::UnmapRealAddress(u32 realaddr, u32& size)
 		{
 			size = m_mapped_memory[i].size;
 			m_mapped_memory.erase(m_mapped_memory.begin() + i);
+			UpdateTables();
 			return true;
 		}
 	}
@@ -50,6 +87,7 @@ bool VirtualMemoryBlock::UnmapAddress(u32 addr, u32& size)
 		{
 			size = m_mapped_memory[i].size;
 			m_mapped_memory.erase(m_mapped_memory.begin() + i);
+			UpdateTables();
 			return true;
 		}
 	}
@@ -77,6 +115,19 @@ bool VirtualMemoryBlock::Write32(const u32 addr, const u32 value)
 
 bool VirtualMemoryBlock::getRealAddr(u32 addr, u32& result)
 {
+	if (LIKELY(!m_unaligned))
+	{
+		const u32 page = m_real_pages[addr >> 20];
+
+		if (page == -1)
+		{
+			return false;
+		}
+
+		result = page + (addr & 0xfffff);
+		return true;
+	}
+
 	for (u32 i = 0; i<m_mapped_memory.size(); ++i)
 	{
 		if (addr >= m_mapped_memory[i].addr && addr < m_mapped_memory[i].addr + m_mapped_memory[i].size)
@@ -91,6 +142,18 @@ bool VirtualMemoryBlock::getRealAddr(u32 addr, u32& result)
 
 s32 VirtualMemoryBlock::getMappedAddress(u32 realAddress)
 {
+	if (LIKELY(!m_unaligned))
+	{
+		const u32 page = m_mapped_pages[realAddress >> 20];
+
+		if (page == -1)
+		{
+			return -1;
+		}
+
+		return page + (realAddress & 0xfffff);
+	}
+
 	for (u32 i = 0; i<m_mapped_memory.size(); ++i)
 	{
 		if (realAddress >= m_mapped_memory[i].realAddress && realAddress < m_mapped_memory[i].realAddress + m_mapped_memory[i].size)
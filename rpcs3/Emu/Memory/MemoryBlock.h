@@ -42,11 +42,23 @@ class VirtualMemoryBlock
 	u32 m_range_start = 0;
 	u32 m_range_size = 0;
 
+	// Translation tables with 1 MiB pages (-1 if not mapped), rebuilt from m_mapped_memory on every change
+	std::array<u32, 4096> m_real_pages;
+	std::array<u32, 4096> m_mapped_pages;
+
+	// Set if some mapping is not 1 MiB aligned, lookups must scan m_mapped_memory then
+	bool m_unaligned = false;
+
+	void UpdateTables();
+
 public:
-	VirtualMemoryBlock() = default;
+	VirtualMemoryBlock()
+	{
+		UpdateTables();
+	}
 
 	VirtualMemoryBlock* SetRange(const u32 start, const u32 size);
-	void Clear() { m_mapped_memory.clear(); m_reserve_size = 0; m_range_start = 0; m_range_size = 0; }
+	void Clear() { m_mapped_memory.clear(); m_reserve_size = 0; m_range_start = 0; m_range_size = 0; UpdateTables(); }
 	u32 GetStartAddr() const { return m_range_start; }
 	u32 GetSize() const { return m_range_size; }
 	bool IsInMyRange(const u32 addr, const u32 size);
@@ -48,22 +48,55 @@ namespace vm
 	// Memory locations
 	std::vector<std::shared_ptr<block_t>> g_locations;
 
-	// Memory mutex core
-	shared_mutex g_mutex;
+	// Memory mutex core (held briefly, spins longer before sleeping)
+	static lock_class s_mutex_class{"vm::g_mutex", 20};
+	shared_mutex g_mutex{s_mutex_class};
 
 	// Memory mutex acknowledgement
 	thread_local atomic_t<cpu_thread*>* g_tls_locked = nullptr;
 
 	// Memory mutex: passive locks
-	std::array<atomic_t<cpu_thread*>, 32> g_locks;
+	std::array<atomic_t<cpu_thread*>, 512> g_locks;
+
+	// Upper bound of passive lock slots ever claimed, writers only scan below it
+	atomic_t<u32> g_locks_bound{0};
+
+	// Slot used by this thread last time (registration usually succeeds on the first attempt)
+	thread_local u32 g_tls_lock_slot = 0;
+
+	// Set while a full writer lock is waiting for (or holding off) passive lock holders
+	atomic_t<u32> g_full_writer{0};
+
+	// Writer lock statistics, [0] for map updates and [1] for full locks
+	struct writer_lock_stats
+	{
+		atomic_t<u64> count;
+		atomic_t<u64> wait_time; // ns
+		atomic_t<u64> hold_time; // ns
+		atomic_t<u64> max_hold_time; // ns
+	};
+
+	static std::array<writer_lock_stats, 2> s_writer_lock_stats{};
+
+	static u64 get_lock_timestamp()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(steady_clock::now().time_since_epoch()).count();
+	}
 
 	static void _register_lock(cpu_thread* _cpu)
 	{
-		for (u32 i = 0;; i = (i + 1) % g_locks.size())
+		for (u32 i = g_tls_lock_slot;; i = (i + 1) % g_locks.size())
 		{
 			if (!g_locks[i] && g_locks[i].compare_and_swap_test(nullptr, _cpu))
 			{
+				g_tls_lock_slot = i;
 				g_tls_locked = g_locks.data() + i;
+
+				// Publish the slot to writers
+				for (u32 bound = g_locks_bound; bound <= i && !g_locks_bound.compare_and_swap_test(bound, i + 1); bound = g_locks_bound)
+				{
+				}
+
 				return;
 			}
 		}
@@ -76,12 +109,14 @@ namespace vm
 			return true;
 		}
 
-		if (LIKELY(g_mutex.is_lockable()))
+		// Memory map updates (non-full writer locks) never wait for passive lock holders,
+		// so only a full writer lock has to keep new readers out
+		if (LIKELY(!g_full_writer))
 		{
-			// Optimistic path (hope that mutex is not exclusively locked)
+			// Optimistic path (hope that no full writer lock is pending)
 			_register_lock(&cpu);
 
-			if (UNLIKELY(!g_mutex.is_lockable()))
+			if (UNLIKELY(g_full_writer))
 			{
 				passive_unlock(cpu);
 
@@ -129,7 +164,7 @@ namespace vm
 			g_tls_locked = nullptr;
 		}
 
-		for (u32 i = 0; i < g_locks.size(); i++)
+		for (u32 i = 0, bound = g_locks_bound; i < bound; i++)
 		{
 			if (g_locks[i] == &cpu)
 			{
@@ -184,7 +219,10 @@ namespace vm
 
 	writer_lock::writer_lock(int full)
 		: locked(true)
+		, full(full != 0)
 	{
+		const u64 wait_start = get_lock_timestamp();
+
 		auto cpu = get_current_cpu_thread();
 
 		if (!cpu || !g_tls_locked || !g_tls_locked->compare_and_swap_test(cpu, nullptr))
@@ -196,16 +234,23 @@ namespace vm
 
 		if (full)
 		{
-			for (auto& lock : g_locks)
+			// Fence new passive locks before scanning (they recheck this flag after registering)
+			g_full_writer.exchange(1);
+
+			const u32 bound = g_locks_bound;
+
+			for (u32 i = 0; i < bound; i++)
 			{
-				if (cpu_thread* ptr = lock)
+				if (cpu_thread* ptr = g_locks[i])
 				{
 					ptr->state.test_and_set(cpu_flag::memory);
 				}
 			}
 
-			for (auto& lock : g_locks)
+			for (u32 i = 0; i < bound; i++)
 			{
+				auto& lock = g_locks[i];
+
 				while (cpu_thread* ptr = lock)
 				{
 					if (test(ptr->state, cpu_flag::dbg_global_stop + cpu_flag::exit))
@@ -223,18 +268,64 @@ namespace vm
 			_register_lock(cpu);
 			cpu->state -= cpu_flag::memory;
 		}
+
+		acquire_time = get_lock_timestamp();
+
+		auto& stats = s_writer_lock_stats[this->full];
+		stats.count++;
+		stats.wait_time += acquire_time - wait_start;
 	}
 
 	writer_lock::~writer_lock()
 	{
 		if (locked)
 		{
+			const u64 hold_time = get_lock_timestamp() - acquire_time;
+
+			auto& stats = s_writer_lock_stats[full];
+			stats.hold_time += hold_time;
+
+			for (u64 max = stats.max_hold_time; max < hold_time && !stats.max_hold_time.compare_and_swap_test(max, hold_time); max = stats.max_hold_time)
+			{
+			}
+
+			if (full)
+			{
+				g_full_writer = 0;
+			}
+
 			g_mutex.unlock();
 		}
 	}
 
-	void reservation_lock_internal(atomic_t<u64>& res)
+	static void writer_lock_stats_report()
+	{
+		static const char* const names[] = { "map update", "full" };
+
+		for (u32 i = 0; i < 2; i++)
+		{
+			auto& stats = s_writer_lock_stats[i];
+
+			if (const u64 count = stats.count.exchange(0))
+			{
+				const u64 wait_time = stats.wait_time.exchange(0);
+				const u64 hold_time = stats.hold_time.exchange(0);
+				const u64 max_hold_time = stats.max_hold_time.exchange(0);
+
+				LOG_NOTICE(MEMORY, "Writer lock statistics (%s): %llu lock(s), %.3f us avg wait, %.3f us avg hold, %.3f us max hold",
+					names[i], count, wait_time / 1000. / count, hold_time / 1000. / count, max_hold_time / 1000.);
+			}
+		}
+	}
+
+	void reservation_lock_internal(u32 addr, atomic_t<u64>& res)
 	{
+		// Hot line detection
+		if (UNLIKELY(g_cfg.core.reservation_stats))
+		{
+			reservation_stat(addr, reservation_event::contended);
+		}
+
 		for (u64 i = 0;; i++)
 		{
 			if (LIKELY(!atomic_storage<u64>::bts(res.raw(), 0)))
@@ -253,6 +344,81 @@ namespace vm
 		}
 	}
 
+	// Reservation statistics entry (open addressing, lines are never removed until vm::close)
+	struct reservation_stat_entry
+	{
+		atomic_t<u32> line; // Cache line address + 1 (0 if unused)
+		std::array<atomic_t<u64>, 4> events;
+	};
+
+	static std::array<reservation_stat_entry, 4096> s_reservation_stats{};
+
+	void reservation_stat(u32 addr, reservation_event event)
+	{
+		const u32 line = (addr & -128) + 1;
+
+		for (u32 i = 0, pos = (addr / 128 * 0x9e3779b1) >> 20; i < 16; i++, pos = (pos + 1) % 4096)
+		{
+			auto& entry = s_reservation_stats[pos];
+
+			// Claim unused entry if necessary
+			const u32 old = entry.line ? entry.line.load() : entry.line.compare_and_swap(0, line);
+
+			if (!old || old == line)
+			{
+				entry.events[static_cast<u32>(event)]++;
+				return;
+			}
+		}
+
+		// Table is too crowded, drop the event
+	}
+
+	static void reservation_stats_report()
+	{
+		std::vector<const reservation_stat_entry*> lines;
+
+		for (const auto& entry : s_reservation_stats)
+		{
+			if (entry.line)
+			{
+				lines.emplace_back(&entry);
+			}
+		}
+
+		if (lines.empty())
+		{
+			return;
+		}
+
+		const auto total = [](const reservation_stat_entry* e)
+		{
+			return e->events[0].load() + e->events[1].load() + e->events[2].load() + e->events[3].load();
+		};
+
+		std::sort(lines.begin(), lines.end(), [&](auto a, auto b) { return total(a) > total(b); });
+
+		std::string out;
+
+		for (std::size_t i = 0; i < lines.size() && i < 20; i++)
+		{
+			const auto& e = *lines[i];
+			fmt::append(out, "\n0x%08x: tx failures=%llu, lock fallbacks=%llu, failed stores=%llu, lock contention=%llu", e.line.load() - 1, e.events[0].load(), e.events[1].load(), e.events[2].load(), e.events[3].load());
+		}
+
+		LOG_NOTICE(GENERAL, "Reservation statistics (%zu lines, TSX %s):%s", lines.size(), g_use_rtm ? "on" : "off", out);
+
+		for (auto& entry : s_reservation_stats)
+		{
+			entry.line = 0;
+
+			for (auto& count : entry.events)
+			{
+				count = 0;
+			}
+		}
+	}
+
 	// Page information
 	struct memory_page
 	{
@@ -263,6 +429,70 @@ namespace vm
 	// Memory pages
 	std::array<memory_page, 0x100000000 / 4096> g_pages{};
 
+	// Host protection owners (page_owner)
+	std::array<atomic_t<u8>, 0x100000000 / 4096> g_page_owners{};
+
+	// Handled access violations per owner
+	static std::array<atomic_t<u64>, static_cast<u32>(page_owner::count)> s_owner_faults{};
+
+	void set_page_owner(u32 addr, u32 size, page_owner owner)
+	{
+		if (!size)
+		{
+			return;
+		}
+
+		for (u32 i = addr / 4096, end = (addr + size - 1) / 4096; i <= end; i++)
+		{
+			if (g_page_owners[i] != static_cast<u8>(owner))
+			{
+				g_page_owners[i] = static_cast<u8>(owner);
+			}
+		}
+	}
+
+	page_owner get_page_owner(u32 addr)
+	{
+		return static_cast<page_owner>(g_page_owners[addr / 4096].load());
+	}
+
+	void on_owner_fault(page_owner owner)
+	{
+		s_owner_faults[static_cast<u32>(owner)]++;
+	}
+
+	u64 get_owner_fault_count(page_owner owner)
+	{
+		return s_owner_faults[static_cast<u32>(owner)];
+	}
+
+	static void owner_fault_report()
+	{
+		const u64 textures = s_owner_faults[static_cast<u32>(page_owner::rsx_texture_cache)].exchange(0);
+		const u64 framebuffers = s_owner_faults[static_cast<u32>(page_owner::rsx_framebuffer)].exchange(0);
+
+		if (textures || framebuffers)
+		{
+			LOG_NOTICE(MEMORY, "Access violations handled: %llu by texture sections, %llu by framebuffer sections", textures, framebuffers);
+		}
+	}
+
+	// Memory accounting class of a guest address (see vm::init for the block layout)
+	static utils::memory_class _memory_class(u32 addr)
+	{
+		switch (addr >> 28)
+		{
+		case 0x0:
+		case 0x1:
+		case 0x3: return utils::memory_class::guest_main;
+		case 0xc: return utils::memory_class::guest_video;
+		case 0xd: return utils::memory_class::guest_stack;
+		case 0xe:
+		case 0xf: return utils::memory_class::guest_spu;
+		default: return utils::memory_class::guest_user;
+		}
+	}
+
 	static void _page_map(u32 addr, u8 flags, utils::shm& shm)
 	{
 		const u32 size = shm.size();
@@ -285,6 +515,8 @@ namespace vm
 			fmt::throw_exception("Memory mapping failed - blame Windows (addr=0x%x, size=0x%x, flags=0x%x)", addr, size, flags);
 		}
 
+		utils::memory_account(_memory_class(addr), size);
+
 		if (flags & page_executable)
 		{
 			utils::memory_commit(g_exec_addr + addr, size);
@@ -396,6 +628,8 @@ namespace vm
 
 		shm.unmap_critical(g_base_addr + addr);
 
+		utils::memory_account(_memory_class(addr), -s64{size});
+
 		if (is_exec)
 		{
 			utils::memory_decommit(g_exec_addr + addr, size);
@@ -489,22 +723,78 @@ namespace vm
 		// Map "real" memory pages
 		_page_map(addr, flags, *shm);
 
+		if (this->flags & block_huge_pages && g_cfg.core.huge_pages)
+		{
+			utils::memory_advise_huge_pages(g_base_addr + addr, size);
+		}
+
 		// Add entry
+		set_units(addr, size, true);
 		m_map[addr] = std::move(shm);
 
 		return true;
 	}
 
+	void block_t::set_units(u32 addr, u32 size, bool used)
+	{
+		const u32 first = std::max<u32>(addr / 0x10000, m_unit_base) - m_unit_base;
+		const u32 end = static_cast<u32>(std::min<u64>((u64{addr} + size + 0xffff) / 0x10000, m_unit_base + m_unit_count)) - m_unit_base;
+
+		for (u32 i = first; i < end; i++)
+		{
+			if (used)
+			{
+				m_units[i / 64] |= 1ull << (i % 64);
+			}
+			else
+			{
+				m_units[i / 64] &= ~(1ull << (i % 64));
+			}
+		}
+	}
+
+	u32 block_t::find_last_used(u32 first, u32 count) const
+	{
+		// Test whole words from the end of the range down
+		for (u32 end = first + count; end > first;)
+		{
+			const u32 word = (end - 1) / 64;
+			const u32 start = std::max(first, word * 64);
+			const u64 high = end - word * 64 == 64 ? ~0ull : (1ull << (end - word * 64)) - 1;
+			const u64 low = (1ull << (start - word * 64)) - 1;
+
+			if (const u64 bits = m_units[word] & high & ~low)
+			{
+				return word * 64 + 63 - static_cast<u32>(cntlz64(bits, true));
+			}
+
+			end = start;
+		}
+
+		return UINT32_MAX;
+	}
+
 	block_t::block_t(u32 addr, u32 size, u64 flags)
 		: addr(addr)
 		, size(size)
 		, flags(flags)
 	{
+		// Only whole units can be allocated by alloc()
+		m_unit_base = ::align(addr, 0x10000) / 0x10000;
+		m_unit_count = static_cast<u32>(std::max<s64>((u64{addr} + size) / 0x10000 - m_unit_base, 0));
+		m_units.resize((m_unit_count + 63) / 64);
+
 		// Allocate compressed reservation info area (avoid SPU MMIO area)
 		if (addr != 0xe0000000)
 		{
 			utils::memory_commit(g_reservations + addr / 16, size / 16);
 			utils::memory_commit(g_reservations2 + addr / 16, size / 16);
+
+			if (flags & block_huge_pages && g_cfg.core.huge_pages)
+			{
+				utils::memory_advise_huge_pages(g_reservations + addr / 16, size / 16);
+				utils::memory_advise_huge_pages(g_reservations2 + addr / 16, size / 16);
+			}
 		}
 		else
 		{
@@ -569,15 +859,32 @@ namespace vm
 		// Create or import shared memory object
 		std::shared_ptr<utils::shm> shm = src ? std::shared_ptr<utils::shm>(*src) : std::make_shared<utils::shm>(size);
 
-		// Search for an appropriate place (unoptimized)
-		for (u32 addr = ::align(this->addr, align); addr < this->addr + this->size - 1; addr += align)
+		const u32 units = ::align(shm->size(), 0x10000) / 0x10000;
+		const u32 step = align / 0x10000;
+
+		// Search the unit bitmap, skipping past the last used unit of each rejected candidate
+		for (u32 i = ::align(m_unit_base, step) - m_unit_base; u64{i} + units <= m_unit_count;)
 		{
-			if (try_alloc(addr, pflags, std::move(shm)))
+			const u32 last_used = find_last_used(i, units);
+
+			if (last_used == UINT32_MAX)
 			{
-				return addr;
+				const u32 addr = (m_unit_base + i) * 0x10000;
+
+				if (try_alloc(addr, pflags, std::move(shm)))
+				{
+					return addr;
+				}
+
+				// Pages mapped behind the bitmap's back (shouldn't happen)
+				i += step;
+				continue;
 			}
+
+			i = ::align(m_unit_base + last_used + 1, step) - m_unit_base;
 		}
 
+		m_alloc_failures++;
 		return 0;
 	}
 
@@ -638,6 +945,20 @@ namespace vm
 
 			// Remove entry
 			m_map.erase(found);
+			set_units(addr, result, false);
+
+			// Boundary units may still hold pages of a neighbouring allocation which isn't 64K aligned
+			for (const u32 unit : {addr / 0x10000, (addr + result - 1) / 0x10000})
+			{
+				for (u32 i = unit * 16; i < unit * 16 + 16; i++)
+				{
+					if (g_pages[i].flags)
+					{
+						set_units(unit * 0x10000, 0x10000, true);
+						break;
+					}
+				}
+			}
 		}
 
 		// Notify rsx to invalidate range (TODO)
@@ -701,6 +1022,36 @@ namespace vm
 		return imp_used(lock);
 	}
 
+	block_t::fragmentation_info block_t::get_fragmentation()
+	{
+		vm::writer_lock lock(0);
+
+		fragmentation_info result{0, 0, 0, m_alloc_failures};
+
+		for (u32 i = 0; i < m_unit_count;)
+		{
+			if (m_units[i / 64] & (1ull << (i % 64)))
+			{
+				i++;
+				continue;
+			}
+
+			u32 end = i + 1;
+
+			while (end < m_unit_count && !(m_units[end / 64] & (1ull << (end % 64))))
+			{
+				end++;
+			}
+
+			result.free += (end - i) * 0x10000;
+			result.largest_free = std::max(result.largest_free, (end - i) * 0x10000);
+			result.free_ranges++;
+			i = end;
+		}
+
+		return result;
+	}
+
 	std::shared_ptr<block_t> map(u32 addr, u32 size, u64 flags)
 	{
 		vm::writer_lock lock(0);
@@ -793,18 +1144,49 @@ namespace vm
 		{
 			g_locations =
 			{
-				std::make_shared<block_t>(0x00010000, 0x1FFF0000), // main
+				std::make_shared<block_t>(0x00010000, 0x1FFF0000, block_huge_pages), // main
 				std::make_shared<block_t>(0x20000000, 0x10000000), // user
-				std::make_shared<block_t>(0xC0000000, 0x10000000), // video
+				std::make_shared<block_t>(0xC0000000, 0x10000000, block_huge_pages), // video
 				std::make_shared<block_t>(0xD0000000, 0x10000000), // stack
 				std::make_shared<block_t>(0xE0000000, 0x20000000), // SPU reserved
-				std::make_shared<block_t>(0x30000000, 0x10000000), // main extend
+				std::make_shared<block_t>(0x30000000, 0x10000000, block_huge_pages), // main extend
 			};
 		}
 	}
 
+	static void fragmentation_report()
+	{
+		for (const auto& block : g_locations)
+		{
+			if (!block)
+			{
+				continue;
+			}
+
+			const auto info = block->get_fragmentation();
+
+			if (!info.alloc_failures && info.free_ranges <= 1)
+			{
+				continue;
+			}
+
+			// Share of the free space which can't be used by an allocation of the largest free size
+			const double fragmented = info.free ? 100. * (info.free - info.largest_free) / info.free : 0.;
+
+			LOG_NOTICE(MEMORY, "Block 0x%x: %u KB free in %u ranges (largest: %u KB, fragmented: %.1f%%), %u failed allocations",
+				block->addr, info.free / 1024, info.free_ranges, info.largest_free / 1024, fragmented, info.alloc_failures);
+		}
+	}
+
 	void close()
 	{
+		reservation_stats_report();
+		writer_lock_stats_report();
+		owner_fault_report();
+		fragmentation_report();
+
+		LOG_NOTICE(MEMORY, "Memory usage:%s", utils::format_memory_usage());
+
 		g_locations.clear();
 
 		utils::memory_decommit(g_base_addr, 0x100000000);
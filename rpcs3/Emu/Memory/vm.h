@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <vector>
 #include <functional>
 #include <memory>
 #include "Utilities/VirtualMemory.h"
@@ -44,6 +45,11 @@ namespace vm
 	};
 
 	// Address type
+	enum block_flags_t : u64
+	{
+		block_huge_pages = (1 << 0), // Back mapped memory and its reservation info with huge pages (if enabled)
+	};
+
 	enum addr_t : u32 {};
 
 	extern shared_mutex g_mutex;
@@ -77,6 +83,8 @@ namespace vm
 	struct writer_lock final
 	{
 		const bool locked;
+		const bool full;
+		u64 acquire_time;
 
 		writer_lock(const writer_lock&) = delete;
 		writer_lock(int full);
@@ -85,11 +93,19 @@ namespace vm
 		explicit operator bool() const { return locked; }
 	};
 
+	// Offset of the 128-byte line in the reservation tables (8 bytes per line).
+	// Neighbouring lines are spread over separate host cache lines (they only share one with lines 8 KiB apart),
+	// so contention on one object does not slow down the objects next to it. The mapping stays within a 4 KiB table page.
+	inline u32 reservation_offset(u32 addr)
+	{
+		return (addr / 128 * 8) ^ ((addr << 2) & 0xe00);
+	}
+
 	// Get reservation status for further atomic update: last update timestamp
 	inline atomic_t<u64>& reservation_acquire(u32 addr, u32 size)
 	{
 		// Access reservation info: stamp and the lock bit
-		return reinterpret_cast<atomic_t<u64>*>(g_reservations)[addr / 128];
+		return *reinterpret_cast<atomic_t<u64>*>(g_reservations + reservation_offset(addr));
 	}
 
 	// Update reservation status
@@ -102,10 +118,22 @@ namespace vm
 	// Get reservation sync variable
 	inline notifier& reservation_notifier(u32 addr, u32 size)
 	{
-		return *reinterpret_cast<notifier*>(g_reservations2 + addr / 128 * 8);
+		return *reinterpret_cast<notifier*>(g_reservations2 + reservation_offset(addr));
 	}
 
-	void reservation_lock_internal(atomic_t<u64>&);
+	void reservation_lock_internal(u32 addr, atomic_t<u64>&);
+
+	// Reservation contention events ("Reservation Statistics")
+	enum class reservation_event : u32
+	{
+		tx_fail, // Transaction failed (aborted or data changed)
+		lock, // Fallback to the reservation lock
+		fail, // Conditional store failed
+		contended, // Reservation lock was already taken
+	};
+
+	// Count reservation event for the cache line
+	void reservation_stat(u32 addr, reservation_event event);
 
 	inline atomic_t<u64>& reservation_lock(u32 addr, u32 size)
 	{
@@ -113,7 +141,7 @@ namespace vm
 
 		if (UNLIKELY(atomic_storage<u64>::bts(res.raw(), 0)))
 		{
-			reservation_lock_internal(res);
+			reservation_lock_internal(addr, res);
 		}
 
 		return res;
@@ -122,6 +150,28 @@ namespace vm
 	// Change memory protection of specified memory region
 	bool page_protect(u32 addr, u32 size, u8 flags_test = 0, u8 flags_set = 0, u8 flags_clear = 0);
 
+	// Subsystem that changed the host protection of a page, used to dispatch access violations
+	enum class page_owner : u8
+	{
+		none,
+		rsx_texture_cache, // Read-only sections (textures uploaded from guest memory)
+		rsx_framebuffer, // No-access sections (render targets and blit destinations awaiting readback)
+
+		count
+	};
+
+	// Record the owner of host protection for the specified range (the owner is a hint and is never cleared)
+	void set_page_owner(u32 addr, u32 size, page_owner owner);
+
+	// Get the last recorded owner of a page
+	page_owner get_page_owner(u32 addr);
+
+	// Count an access violation handled by the page owner
+	void on_owner_fault(page_owner owner);
+
+	// Number of access violations handled by the owner since vm::init
+	u64 get_owner_fault_count(page_owner owner);
+
 	// Check flags for specified memory range (unsafe)
 	bool check_addr(u32 addr, u32 size = 1, u8 flags = page_allocated);
 
@@ -143,8 +193,22 @@ namespace vm
 		// Mapped regions: addr -> shm handle
 		std::map<u32, std::shared_ptr<utils::shm>> m_map;
 
+		// Occupancy of the whole 64K units inside the block (bit set = unit holds mapped pages), first unit is m_unit_base
+		std::vector<u64> m_units;
+		u32 m_unit_base;
+		u32 m_unit_count;
+
+		// Number of alloc() calls which found no space
+		u32 m_alloc_failures = 0;
+
 		bool try_alloc(u32 addr, u8 flags, std::shared_ptr<utils::shm>&&);
 
+		// Set or clear the units overlapping the range
+		void set_units(u32 addr, u32 size, bool used);
+
+		// Find the last used unit in [first, first + count), return UINT32_MAX if all are free
+		u32 find_last_used(u32 first, u32 count) const;
+
 	public:
 		block_t(u32 addr, u32 size, u64 flags = 0);
 
@@ -153,7 +217,7 @@ namespace vm
 	public:
 		const u32 addr; // Start address
 		const u32 size; // Total size
-		const u64 flags; // Currently unused
+		const u64 flags; // block_flags_t
 
 		// Search and map memory (min alignment is 0x10000)
 		u32 alloc(u32 size, u32 align = 0x10000, const std::shared_ptr<utils::shm>* = nullptr);
@@ -172,6 +236,17 @@ namespace vm
 
 		// Get allocated memory count
 		u32 used();
+
+		struct fragmentation_info
+		{
+			u32 free;          // Free space in whole 64K units
+			u32 largest_free;  // Largest contiguous free range
+			u32 free_ranges;   // Number of contiguous free ranges
+			u32 alloc_failures;
+		};
+
+		// Get free space statistics
+		fragmentation_info get_fragmentation();
 	};
 
 	// Create new memory block with specified parameters and return it
@@ -52,12 +52,17 @@ namespace rsx
 				auto it = frame_capture.memory_data_map.find(data_hash);
 				if (it != frame_capture.memory_data_map.end())
 				{
-					if (it->second.data != data.data)
+					// contents of earlier blocks are already on disk, only the size can be compared
+					if (it->second.size != data.data.size())
 						// screw this
 						fmt::throw_exception("Memory map hash collision detected...cant capture");
 				}
 				else
+				{
+					// new contents, stream them to the capture file right away
+					frame_capture.write_block_data(data);
 					frame_capture.memory_data_map.insert(std::make_pair(data_hash, std::move(data)));
+				}
 			}
 
 			u64 block_hash = XXH64(&block, sizeof(frame_capture_data::memory_block), 0);
@@ -7,9 +7,111 @@
 #include "Emu/RSX/GSRender.h"
 
 #include <map>
+#include <sstream>
+#include <zlib.h>
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/unordered_map.hpp>
 
 namespace rsx
 {
+	bool frame_capture_data::open_for_write(const std::string& path)
+	{
+		if (!file.open(path, fs::rewrite))
+			return false;
+
+		// index_offset is filled in by finish_write
+		const file_header header{ FRAME_CAPTURE_MAGIC, FRAME_CAPTURE_VERSION, 0 };
+		file.write(header);
+		return true;
+	}
+
+	void frame_capture_data::write_block_data(memory_block_data& block)
+	{
+		block.size = ::narrow<u32>(block.data.size());
+
+		uLongf compressed_size = compressBound(block.size);
+		std::vector<u8> compressed(compressed_size);
+
+		if (compress2(compressed.data(), &compressed_size, block.data.data(), block.size, Z_BEST_SPEED) != Z_OK)
+			fmt::throw_exception("RSX Capture: Failed to compress memory block of size 0x%x" HERE, block.size);
+
+		block.file_offset = file.pos();
+		block.compressed_size = ::narrow<u32>(compressed_size);
+
+		if (file.write(compressed.data(), compressed_size) != compressed_size)
+			fmt::throw_exception("RSX Capture: Failed to write memory block to capture file" HERE);
+
+		// Contents live on disk from now on
+		block.data.clear();
+		block.data.shrink_to_fit();
+	}
+
+	bool frame_capture_data::finish_write()
+	{
+		std::stringstream os;
+		{
+			cereal::BinaryOutputArchive archive(os);
+			archive(*this);
+		}
+
+		const file_header header{ magic, version, file.pos() };
+		file.write(os.str());
+		file.seek(0);
+		file.write(header);
+		file.close();
+		return true;
+	}
+
+	bool frame_capture_data::open_for_read(const std::string& path)
+	{
+		if (!file.open(path))
+			return false;
+
+		file_header header;
+		if (!file.read(header) || header.magic != FRAME_CAPTURE_MAGIC)
+			return false;
+
+		if (header.version != FRAME_CAPTURE_VERSION)
+		{
+			LOG_ERROR(RSX, "Rsx capture file version not supported! Expected %d, found %d", FRAME_CAPTURE_VERSION, header.version);
+			return false;
+		}
+
+		if (header.index_offset < sizeof(file_header) || header.index_offset >= file.size())
+			return false;
+
+		std::string index;
+		file.seek(header.index_offset);
+		if (!file.read(index, file.size() - header.index_offset))
+			return false;
+
+		std::istringstream is(index);
+		cereal::BinaryInputArchive archive(is);
+		archive(*this);
+
+		return magic == FRAME_CAPTURE_MAGIC;
+	}
+
+	const std::vector<u8>& frame_capture_data::get_block_data(memory_block_data& block)
+	{
+		if (block.data.empty() && block.size)
+		{
+			std::vector<u8> compressed(block.compressed_size);
+			file.seek(block.file_offset);
+
+			if (!file.read(compressed))
+				fmt::throw_exception("RSX Replay: Failed to read memory block at 0x%llx" HERE, block.file_offset);
+
+			block.data.resize(block.size);
+			uLongf size = block.size;
+
+			if (uncompress(block.data.data(), &size, compressed.data(), block.compressed_size) != Z_OK || size != block.size)
+				fmt::throw_exception("RSX Replay: Corrupt memory block at 0x%llx" HERE, block.file_offset);
+		}
+
+		return block.data;
+	}
+
 	be_t<u32> rsx_replay_thread::allocate_context()
 	{
 		const u32 contextAddr = vm::alloc(sizeof(rsx_context), vm::main);
@@ -176,8 +278,8 @@ namespace rsx
 				if (it_data == frame->memory_data_map.end())
 					fmt::throw_exception("requested memory data state for command not found in memory_data_map");
 
-				const auto& data_block = it_data->second;
-				std::memcpy(vm::base(memblock.addr + memblock.offset), data_block.data.data(), data_block.data.size());
+				const auto& data = frame->get_block_data(it_data->second);
+				std::memcpy(vm::base(memblock.addr + memblock.offset), data.data(), data.size());
 			}
 		}
 
@@ -260,6 +362,43 @@ namespace rsx
 		}
 	}
 
+	void rsx_replay_thread::write_benchmark_results(const std::vector<benchmark_sample>& samples)
+	{
+		// The first iteration loads memory blocks and compiles shaders, keep it out of the summary when possible
+		const size_t first = samples.size() > 1 ? 1 : 0;
+
+		u64 min_time = UINT64_MAX, max_time = 0, total_time = 0;
+		for (size_t n = first; n < samples.size(); ++n)
+		{
+			min_time = std::min(min_time, samples[n].wall_time);
+			max_time = std::max(max_time, samples[n].wall_time);
+			total_time += samples[n].wall_time;
+		}
+
+		std::string out = fmt::format("{\n\t\"renderer\": \"%s\",\n\t\"iterations\": [\n", g_cfg.video.renderer.get());
+
+		for (size_t n = 0; n < samples.size(); ++n)
+		{
+			const auto& sample = samples[n];
+			out += fmt::format("\t\t{ \"wall_time_us\": %llu, \"rsx_busy_us\": %llu, \"draw_calls\": %llu }%s\n",
+				sample.wall_time, sample.wall_time - std::min(sample.idle_time, sample.wall_time), sample.draw_calls, (n + 1 < samples.size()) ? "," : "");
+		}
+
+		out += fmt::format("\t],\n\t\"summary\": { \"min_wall_time_us\": %llu, \"avg_wall_time_us\": %llu, \"max_wall_time_us\": %llu }\n}\n",
+			min_time, total_time / (samples.size() - first), max_time);
+
+		const std::string path = benchmark.results_path.empty() ? fs::get_config_dir() + "rsx_benchmark.json" : benchmark.results_path;
+		if (fs::file f{ path, fs::rewrite })
+		{
+			f.write(out);
+			LOG_SUCCESS(RSX, "RSX capture benchmark: %u iterations, %llu us average. Results written to %s", (u32)samples.size(), total_time / (samples.size() - first), path);
+		}
+		else
+		{
+			LOG_ERROR(RSX, "RSX capture benchmark: failed to write results to %s (%s)", path, fs::g_tls_error);
+		}
+	}
+
 	void rsx_replay_thread::cpu_task()
 	{
 		be_t<u32> context_id = allocate_context();
@@ -286,12 +425,19 @@ namespace rsx
 				fmt::throw_exception("rsx io map failed for block");
 		}
 
+		std::vector<benchmark_sample> samples;
+
 		while (!Emu.IsStopped())
 		{
+			auto renderer = fxm::get<GSRender>();
+
+			const u64 start_time = get_system_time();
+			const u64 start_idle_time = renderer->performance_counters.idle_time.load();
+			const u64 start_draw_calls = renderer->performance_counters.draw_calls.load();
+
 			// start up fifo buffer by dumping the put ptr to first stop
 			sys_rsx_context_attribute(context_id, 0x001, fifo_start_addr, fifo_stops[0], 0, 0);
 
-			auto renderer = fxm::get<GSRender>();
 			size_t stopIdx = 0;
 			for (const auto& replay_cmd : frame->replay_commands)
 			{
@@ -334,6 +480,23 @@ namespace rsx
 					std::this_thread::sleep_for(10ms);
 			}
 
+			if (benchmark.iterations && !Emu.IsStopped())
+			{
+				samples.push_back({ get_system_time() - start_time, renderer->performance_counters.idle_time.load() - start_idle_time,
+					renderer->performance_counters.draw_calls.load() - start_draw_calls });
+
+				if (samples.size() == benchmark.iterations)
+				{
+					write_benchmark_results(samples);
+					Emu.CallAfter([]()
+					{
+						Emu.Stop();
+						Emu.GetCallbacks().exit();
+					});
+					break;
+				}
+			}
+
 			// random pause to not destroy gpu
 			std::this_thread::sleep_for(10ms);
 		}
@@ -15,20 +15,35 @@
 namespace rsx
 {
 	constexpr u32 FRAME_CAPTURE_MAGIC = 0x52524300; // ascii 'RRC/0'
-	constexpr u32 FRAME_CAPTURE_VERSION = 0x1;
+	constexpr u32 FRAME_CAPTURE_VERSION = 0x2;
 	struct frame_capture_data
 	{
 
+		// memory block contents are stored compressed in the capture file, only the location is part of the index
 		struct memory_block_data
 		{
-			std::vector<u8> data;
+			std::vector<u8> data;   // uncompressed contents, resident only until written out or once loaded
+			u64 file_offset{0};     // offset of the compressed contents in the capture file
+			u32 compressed_size{0};
+			u32 size{0};
+
 			template<typename Archive>
 			void serialize(Archive& ar)
 			{
-				ar(data);
+				ar(file_offset);
+				ar(compressed_size);
+				ar(size);
 			}
 		};
 
+		// fixed size header at the start of the capture file, the serialized index follows the memory block contents
+		struct file_header
+		{
+			u32 magic;
+			u32 version;
+			u64 index_offset;
+		};
+
 		// simple block to hold ps3 address and data
 		struct memory_block
 		{
@@ -181,6 +196,9 @@ namespace rsx
 		// actual command queue to hold everything above
 		std::vector<replay_command> replay_commands;
 
+		// capture file, memory blocks are streamed into it while capturing and read back lazily on replay
+		fs::file file;
+
 		template<typename Archive>
 		void serialize(Archive & ar)
 		{
@@ -199,8 +217,25 @@ namespace rsx
 			version = FRAME_CAPTURE_VERSION;
 			tile_map.clear();
 			memory_map.clear();
+			memory_data_map.clear();
+			display_buffers_map.clear();
 			replay_commands.clear();
+			file.close();
 		}
+
+		// Creates the capture file; memory block contents are written as they are captured
+		bool open_for_write(const std::string& path);
+
+		// Compresses and appends the contents of a new memory block, then releases them
+		void write_block_data(memory_block_data& block);
+
+		// Appends the index and finalizes the header
+		bool finish_write();
+
+		// Reads the header and index, memory block contents are loaded on first use
+		bool open_for_read(const std::string& path);
+
+		const std::vector<u8>& get_block_data(memory_block_data& block);
 	};
 
 
@@ -224,12 +259,20 @@ namespace rsx
 			frame_capture_data::tile_state tile_state;
 		};
 
+		struct benchmark_sample
+		{
+			u64 wall_time;  // time to push the whole capture through the RSX, in microseconds
+			u64 idle_time;  // time the RSX thread spent waiting during that period
+			u64 draw_calls;
+		};
+
 		current_state cs;
 		std::unique_ptr<frame_capture_data> frame;
+		rsx_benchmark_options benchmark;
 
 	public:
-		rsx_replay_thread(std::unique_ptr<frame_capture_data>&& frame_data)
-			: ppu_thread("Rsx Capture Replay Thread"), frame(std::move(frame_data)) {};
+		rsx_replay_thread(std::unique_ptr<frame_capture_data>&& frame_data, const rsx_benchmark_options& benchmark_options = {})
+			: ppu_thread("Rsx Capture Replay Thread"), frame(std::move(frame_data)), benchmark(benchmark_options) {};
 
 		virtual void cpu_task() override;
 	private:
@@ -237,5 +280,6 @@ namespace rsx
 		std::tuple<u32, u32> get_usable_fifo_range();
 		std::vector<u32> alloc_write_fifo(be_t<u32> context_id, u32 fifo_start_addr, u32 fifo_size);
 		void apply_frame_state(be_t<u32> context_id, const frame_capture_data::replay_command& replay_cmd);
+		void write_benchmark_results(const std::vector<benchmark_sample>& samples);
 	};
 }
@@ -15,6 +15,24 @@ const bool s_use_ssse3 =
 #define _mm_shuffle_epi8
 #endif
 
+const bool s_use_avx2 =
+#ifdef _MSC_VER
+	utils::has_avx2();
+#elif __AVX2__
+	true;
+#else
+	false;
+#endif
+
+const bool s_use_avx512 =
+#ifdef _MSC_VER
+	utils::has_512();
+#elif __AVX512BW__
+	true;
+#else
+	false;
+#endif
+
 namespace
 {
 	// FIXME: GSL as_span break build if template parameter is non const with current revision.
@@ -45,6 +63,79 @@ namespace
 		return{ X, Y, Z, 1 };
 	}
 
+	// Shuffle continuous 16-byte blocks with AVX-512/AVX2 (streaming stores), returns the number of blocks processed
+	inline u32 stream_data_to_memory_swapped_wide(__m128i* dst, const __m128i* src, u32 blocks, __m128i mask)
+	{
+		u32 done = 0;
+
+#if defined(_MSC_VER) || defined(__AVX512BW__)
+		if (s_use_avx512 && (reinterpret_cast<u64>(dst) % 64) == 0)
+		{
+			const __m512i mask512 = _mm512_broadcast_i32x4(mask);
+
+			for (; done + 4 <= blocks; done += 4)
+			{
+				const __m512i vector = _mm512_loadu_si512(src + done);
+				_mm512_stream_si512(reinterpret_cast<__m512i*>(dst + done), _mm512_shuffle_epi8(vector, mask512));
+			}
+		}
+#endif
+
+#if defined(_MSC_VER) || defined(__AVX2__)
+		if (s_use_avx2 && (reinterpret_cast<u64>(dst + done) % 32) == 0)
+		{
+			const __m256i mask256 = _mm256_broadcastsi128_si256(mask);
+
+			for (; done + 2 <= blocks; done += 2)
+			{
+				const __m256i vector = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + done));
+				_mm256_stream_si256(reinterpret_cast<__m256i*>(dst + done), _mm256_shuffle_epi8(vector, mask256));
+			}
+		}
+
+		if (done)
+		{
+			_mm256_zeroupper();
+		}
+#endif
+
+		return done;
+	}
+
+	// Shuffle strided 16-byte blocks two at a time with AVX2, returns the number of blocks processed
+	inline u32 stream_data_to_memory_swapped_strided_wide(char* dst, const char* src, u32 blocks, u8 dst_stride, u8 src_stride, __m128i mask)
+	{
+		u32 done = 0;
+
+#if defined(_MSC_VER) || defined(__AVX2__)
+		if (s_use_avx2)
+		{
+			const __m256i mask256 = _mm256_broadcastsi128_si256(mask);
+
+			for (; done + 2 <= blocks; done += 2)
+			{
+				const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+				const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + src_stride));
+				const __m256i shuffled = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), mask256);
+
+				// Keep the store order, blocks may overlap if the stride is less than 16
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(shuffled));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + dst_stride), _mm256_extracti128_si256(shuffled, 1));
+
+				src += src_stride * 2;
+				dst += dst_stride * 2;
+			}
+
+			if (done)
+			{
+				_mm256_zeroupper();
+			}
+		}
+#endif
+
+		return done;
+	}
+
 	inline void stream_data_to_memory_swapped_u32(void *dst, const void *src, u32 vertex_count, u8 stride)
 	{
 		const __m128i mask = _mm_set_epi8(
@@ -57,9 +148,17 @@ namespace
 		__m128i* src_ptr = (__m128i*)src;
 
 		const u32 dword_count = (vertex_count * (stride >> 2));
-		const u32 iterations = dword_count >> 2;
+		u32 iterations = dword_count >> 2;
 		const u32 remaining = dword_count % 4;
 
+		if (LIKELY(s_use_ssse3))
+		{
+			const u32 done = stream_data_to_memory_swapped_wide(dst_ptr, src_ptr, iterations, mask);
+			src_ptr += done;
+			dst_ptr += done;
+			iterations -= done;
+		}
+
 		if (LIKELY(s_use_ssse3))
 		{
 			for (u32 i = 0; i < iterations; ++i)
@@ -108,9 +207,17 @@ namespace
 		__m128i* src_ptr = (__m128i*)src;
 
 		const u32 word_count = (vertex_count * (stride >> 1));
-		const u32 iterations = word_count >> 3;
+		u32 iterations = word_count >> 3;
 		const u32 remaining = word_count % 8;
 
+		if (LIKELY(s_use_ssse3))
+		{
+			const u32 done = stream_data_to_memory_swapped_wide(dst_ptr, src_ptr, iterations, mask);
+			src_ptr += done;
+			dst_ptr += done;
+			iterations -= done;
+		}
+
 		if (LIKELY(s_use_ssse3))
 		{
 			for (u32 i = 0; i < iterations; ++i)
@@ -173,6 +280,11 @@ namespace
 
 		if (LIKELY(s_use_ssse3))
 		{
+			const u32 done = stream_data_to_memory_swapped_strided_wide(dst_ptr, src_ptr, iterations, dst_stride, src_stride, mask);
+			src_ptr += done * src_stride;
+			dst_ptr += done * dst_stride;
+			iterations -= done;
+
 			for (u32 i = 0; i < iterations; ++i)
 			{
 				const __m128i vector = _mm_loadu_si128((__m128i*)src_ptr);
@@ -237,6 +349,11 @@ namespace
 
 		if (LIKELY(s_use_ssse3))
 		{
+			const u32 done = stream_data_to_memory_swapped_strided_wide(dst_ptr, src_ptr, iterations, dst_stride, src_stride, mask);
+			src_ptr += done * src_stride;
+			dst_ptr += done * dst_stride;
+			iterations -= done;
+
 			for (u32 i = 0; i < iterations; ++i)
 			{
 				const __m128i vector = _mm_loadu_si128((__m128i*)src_ptr);
@@ -3,8 +3,101 @@
 #include "Emu/System.h"
 
 #include "FragmentProgramDecompiler.h"
+#include "ProgramStateCache.h"
+#include "Utilities/mutex.h"
 
 #include <algorithm>
+#include <typeindex>
+#include <unordered_map>
+
+namespace
+{
+	// The translated body only depends on the ucode, the export width and the sampling state of the textures the ucode references.
+	// Everything else (two-sided color, depth export, alpha kill, texture scaling...) is emitted in the prologue/epilogue.
+	struct fragment_body_key
+	{
+		std::type_index backend;
+		std::vector<u32> ucode;
+		bool exports_32bit;
+		u32 texture_dimensions;
+		u16 shadow_textures;
+		u16 redirected_textures;
+
+		bool operator==(const fragment_body_key& other) const
+		{
+			return backend == other.backend && exports_32bit == other.exports_32bit &&
+				texture_dimensions == other.texture_dimensions && shadow_textures == other.shadow_textures &&
+				redirected_textures == other.redirected_textures && ucode == other.ucode;
+		}
+	};
+
+	struct fragment_body_key_hash
+	{
+		size_t operator()(const fragment_body_key& key) const
+		{
+			// FNV 64-bit
+			size_t hash = 14695981039346656037ull;
+			for (const u32 word : key.ucode)
+			{
+				hash ^= word;
+				hash *= 1099511628211ull;
+			}
+
+			return hash ^ key.backend.hash_code() ^ key.texture_dimensions ^ key.shadow_textures ^ (key.redirected_textures << 16);
+		}
+	};
+
+	struct fragment_body
+	{
+		std::string main;
+		ParamArray parr;
+		decltype(FragmentProgramDecompiler::properties) properties;
+		u32 sampled_2d_textures;
+		u32 sampled_shadow_textures;
+		u32 size;
+	};
+
+	shared_mutex g_fragment_body_mutex;
+	std::unordered_map<fragment_body_key, fragment_body, fragment_body_key_hash> g_fragment_bodies;
+
+	fragment_body_key make_body_key(const std::type_index& backend, const RSXFragmentProgram& prog)
+	{
+		using namespace program_hash_util;
+
+		fragment_body_key key{ backend, {}, !!(prog.ctrl & CELL_GCM_SHADER_CONTROL_32_BITS_EXPORTS) };
+
+		// Constants are uniforms in the generated code, only the instructions matter
+		const qword *inst_buffer = (const qword*)prog.addr;
+		for (size_t index = 0;; ++index)
+		{
+			const qword& inst = inst_buffer[index];
+			key.ucode.insert(key.ucode.end(), inst.word, inst.word + 4);
+
+			if (fragment_program_utils::is_constant(inst.word[1]) ||
+				fragment_program_utils::is_constant(inst.word[2]) ||
+				fragment_program_utils::is_constant(inst.word[3]))
+				index++;
+
+			if ((inst.word[0] >> 8) & 0x1)
+				break;
+		}
+
+		// Sampling state of textures the program never reads does not affect the body
+		const u16 textures_mask = fragment_program_utils::analyse_fragment_program(prog.addr).referenced_textures_mask;
+
+		u32 dimensions_mask = 0;
+		for (u32 i = 0; i < 16; ++i)
+		{
+			if (textures_mask & (1 << i))
+				dimensions_mask |= (3 << (i * 2));
+		}
+
+		key.texture_dimensions = prog.texture_dimensions & dimensions_mask;
+		key.shadow_textures = prog.shadow_textures & textures_mask;
+		key.redirected_textures = prog.redirected_textures & textures_mask;
+		return key;
+	}
+}
 
 FragmentProgramDecompiler::FragmentProgramDecompiler(const RSXFragmentProgram &prog, u32& size) :
 	m_prog(prog),
@@ -759,6 +852,28 @@ bool FragmentProgramDecompiler::handle_tex_srb(u32 opcode)
 
 std::string FragmentProgramDecompiler::Decompile()
 {
+	// State variants of an already translated program only need a new prologue/epilogue
+	auto body_key = make_body_key(typeid(*this), m_prog);
+	{
+		reader_lock lock(g_fragment_body_mutex);
+
+		const auto found = g_fragment_bodies.find(body_key);
+		if (found != g_fragment_bodies.end())
+		{
+			const auto& body = found->second;
+			main = body.main;
+			m_parr.CopyFrom(body.parr);
+			properties = body.properties;
+			m_2d_sampled_textures = body.sampled_2d_textures;
+			m_shadow_sampled_textures = body.sampled_shadow_textures;
+			m_size = body.size;
+
+			std::string m_shader = BuildCode();
+			main.clear();
+			return m_shader;
+		}
+	}
+
 	auto data = (be_t<u32>*) m_prog.addr;
 	m_size = 0;
 	m_location = 0;
@@ -936,6 +1051,12 @@ std::string FragmentProgramDecompiler::Decompile()
 
 	// flush m_code_level
 	m_code_level = 1;
+
+	{
+		writer_lock lock(g_fragment_body_mutex);
+		g_fragment_bodies.emplace(std::move(body_key), fragment_body{ main, m_parr, properties, m_2d_sampled_textures, m_shadow_sampled_textures, m_size });
+	}
+
 	std::string m_shader = BuildCode();
 	main.clear();
 	//	m_parr.params.clear();
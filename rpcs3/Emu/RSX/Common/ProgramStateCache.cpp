@@ -3,23 +3,42 @@
 
 using namespace program_hash_util;
 
-size_t vertex_program_utils::get_vertex_program_ucode_hash(const RSXVertexProgram &program)
+namespace
 {
-	// 64-bit Fowler/Noll/Vo FNV-1a hash code
-	size_t hash = 0xCBF29CE484222325ULL;
-	const qword *instbuffer = (const qword*)program.data.data();
-	size_t instIndex = 0;
-	bool end = false;
-	for (unsigned i = 0; i < program.data.size() / 4; i++)
+	// Multiply-rotate hashing in the style of xxhash, one independent lane per half of an instruction.
+	// Unlike the FNV chain it replaces, both lanes can be in flight at once and each step is a single multiply.
+	constexpr u64 ucode_hash_prime1 = 0x9E3779B185EBCA87ULL;
+	constexpr u64 ucode_hash_prime2 = 0xC2B2AE3D27D4EB4FULL;
+	constexpr u64 ucode_hash_prime3 = 0x165667B19E3779F9ULL;
+
+	struct ucode_hasher
 	{
-		const qword inst = instbuffer[instIndex];
-		hash ^= inst.dword[0];
-		hash += (hash << 1) + (hash << 4) + (hash << 5) + (hash << 7) + (hash << 8) + (hash << 40);
-		hash ^= inst.dword[1];
-		hash += (hash << 1) + (hash << 4) + (hash << 5) + (hash << 7) + (hash << 8) + (hash << 40);
-		instIndex++;
-	}
-	return hash;
+		u64 lane0 = ucode_hash_prime1 + ucode_hash_prime2;
+		u64 lane1 = ucode_hash_prime2;
+
+		void add(const qword& inst)
+		{
+			lane0 = rol64(lane0 + inst.dword[0] * ucode_hash_prime2, 31) * ucode_hash_prime1;
+			lane1 = rol64(lane1 + inst.dword[1] * ucode_hash_prime2, 31) * ucode_hash_prime1;
+		}
+
+		size_t finalize(u64 length) const
+		{
+			u64 hash = rol64(lane0, 1) + rol64(lane1, 7) + length;
+			hash ^= hash >> 33;
+			hash *= ucode_hash_prime2;
+			hash ^= hash >> 29;
+			hash *= ucode_hash_prime3;
+			hash ^= hash >> 32;
+			return hash;
+		}
+	};
+}
+
+size_t vertex_program_utils::get_vertex_program_ucode_hash(const RSXVertexProgram &program)
+{
+	// The ucode is contiguous, unlike fragment programs which have embedded constants to skip
+	return rpcs3::hash64(program.data.data(), program.data.size() / 4 * 16);
 }
 
 vertex_program_utils::vertex_program_metadata vertex_program_utils::analyse_vertex_program(const std::vector<u32>& data)
@@ -78,19 +97,8 @@ bool vertex_program_compare::operator()(const RSXVertexProgram &binary1, const R
 	if (!binary1.skip_vertex_input_check && !binary2.skip_vertex_input_check && binary1.rsx_vertex_inputs != binary2.rsx_vertex_inputs)
 		return false;
 
-	const qword *instBuffer1 = (const qword*)binary1.data.data();
-	const qword *instBuffer2 = (const qword*)binary2.data.data();
-	size_t instIndex = 0;
-	for (unsigned i = 0; i < binary1.data.size() / 4; i++)
-	{
-		const qword& inst1 = instBuffer1[instIndex];
-		const qword& inst2 = instBuffer2[instIndex];
-		if (inst1.dword[0] != inst2.dword[0] || inst1.dword[1] != inst2.dword[1])
-			return false;
-		instIndex++;
-	}
-
-	return true;
+	// Vertex ucode is a plain array of whole instructions
+	return std::memcmp(binary1.data.data(), binary2.data.data(), binary1.data.size() * sizeof(u32)) == 0;
 }
 
 
@@ -192,17 +200,13 @@ fragment_program_utils::fragment_program_metadata fragment_program_utils::analys
 
 size_t fragment_program_utils::get_fragment_program_ucode_hash(const RSXFragmentProgram& program)
 {
-	// 64-bit Fowler/Noll/Vo FNV-1a hash code
-	size_t hash = 0xCBF29CE484222325ULL;
 	const qword *instbuffer = (const qword*)program.addr;
 	size_t instIndex = 0;
+	ucode_hasher hasher;
 	while (true)
 	{
 		const qword& inst = instbuffer[instIndex];
-		hash ^= inst.dword[0];
-		hash += (hash << 1) + (hash << 4) + (hash << 5) + (hash << 7) + (hash << 8) + (hash << 40);
-		hash ^= inst.dword[1];
-		hash += (hash << 1) + (hash << 4) + (hash << 5) + (hash << 7) + (hash << 8) + (hash << 40);
+		hasher.add(inst);
 		instIndex++;
 		// Skip constants
 		if (fragment_program_utils::is_constant(inst.word[1]) ||
@@ -212,7 +216,7 @@ size_t fragment_program_utils::get_fragment_program_ucode_hash(const RSXFragment
 
 		bool end = (inst.word[0] >> 8) & 0x1;
 		if (end)
-			return hash;
+			return hasher.finalize(instIndex);
 	}
 	return 0;
 }
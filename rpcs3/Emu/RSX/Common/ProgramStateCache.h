@@ -6,7 +6,14 @@
 
 #include "Utilities/GSL.h"
 #include "Utilities/hash.h"
+#include "Utilities/tracing.h"
+#include "Utilities/perf_counters.h"
 #include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <unordered_set>
 
 enum class SHADER_TYPE
 {
@@ -106,7 +113,7 @@ class program_state_cache
 	using binary_to_vertex_program = std::unordered_map<RSXVertexProgram, vertex_program_type, program_hash_util::vertex_program_storage_hash, program_hash_util::vertex_program_compare> ;
 	using binary_to_fragment_program = std::unordered_map<RSXFragmentProgram, fragment_program_type, program_hash_util::fragment_program_storage_hash, program_hash_util::fragment_program_compare>;
 
-
+protected:
 	struct pipeline_key
 	{
 		u32 vertex_program_id;
@@ -134,7 +141,6 @@ class program_state_cache
 		}
 	};
 
-protected:
 	std::mutex s_mtx; // TODO: Only need to synchronize when loading cache
 	size_t m_next_id = 0;
 	bool m_cache_miss_flag;
@@ -142,27 +148,114 @@ protected:
 	binary_to_fragment_program m_fragment_shader_cache;
 	std::unordered_map <pipeline_key, pipeline_storage_type, pipeline_key_hash, pipeline_key_compare> m_storage;
 
+	// Result of the last vertex program lookup; node pointers survive rehashing
+	const vertex_program_type* m_last_vertex_program = nullptr;
+	u32 m_last_vertex_program_revision = 0;
+
+	// Result of the last fragment program lookup, the constants of a draw are filled for the program its pipeline uses
+	const fragment_program_type* m_last_fragment_program = nullptr;
+	const void* m_last_fragment_program_addr = nullptr;
+
+	// Asynchronous pipeline compilation
+	std::unordered_set<pipeline_key, pipeline_key_hash, pipeline_key_compare> m_pending_pipelines; // Protected by s_mtx
+	std::mutex m_job_mutex;
+	std::condition_variable m_job_cv;
+	std::deque<std::function<void()>> m_jobs;
+	std::vector<std::thread> m_job_workers;
+	bool m_jobs_exit = false;
+
+	void enqueue_pipeline_job(std::function<void()>&& job)
+	{
+		std::lock_guard<std::mutex> lock(m_job_mutex);
+
+		if (m_job_workers.empty())
+		{
+			// Leave half of the host threads to the emulated cores
+			const u32 worker_count = std::max(1u, std::thread::hardware_concurrency() / 2);
+			for (u32 n = 0; n < worker_count; ++n)
+			{
+				m_job_workers.emplace_back([this]()
+				{
+					while (true)
+					{
+						std::function<void()> job;
+						{
+							std::unique_lock<std::mutex> lock(m_job_mutex);
+							m_job_cv.wait(lock, [this]() { return m_jobs_exit || !m_jobs.empty(); });
+
+							if (m_jobs_exit)
+								return;
+
+							job = std::move(m_jobs.front());
+							m_jobs.pop_front();
+						}
+
+						job();
+					}
+				});
+			}
+		}
+
+		m_jobs.push_back(std::move(job));
+		m_job_cv.notify_one();
+	}
+
+	/// Drops queued pipeline jobs and waits for the running ones. Must be called before the backend resources go away.
+	void stop_pipeline_workers()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_job_mutex);
+			m_jobs_exit = true;
+			m_jobs.clear();
+		}
+
+		m_job_cv.notify_all();
+
+		for (auto &worker : m_job_workers)
+			worker.join();
+
+		m_job_workers.clear();
+		m_jobs_exit = false;
+
+		std::lock_guard<std::mutex> lock(s_mtx);
+		m_pending_pipelines.clear();
+	}
+
 	/// bool here to inform that the program was preexisting.
 	std::tuple<const vertex_program_type&, bool> search_vertex_program(const RSXVertexProgram& rsx_vp)
 	{
+		// Same program as the previous lookup, the ucode was not touched since
+		if (rsx_vp.revision && rsx_vp.revision == m_last_vertex_program_revision)
+		{
+			return std::forward_as_tuple(*m_last_vertex_program, true);
+		}
+
+		m_last_vertex_program_revision = rsx_vp.revision;
+
 		const auto& I = m_vertex_shader_cache.find(rsx_vp);
 		if (I != m_vertex_shader_cache.end())
 		{
+			m_last_vertex_program = &I->second;
 			return std::forward_as_tuple(I->second, true);
 		}
 		LOG_NOTICE(RSX, "VP not found in buffer!");
 		vertex_program_type& new_shader = m_vertex_shader_cache[rsx_vp];
+		tracing::scope trace(tracing::category::shader, "vertex program compile");
 		backend_traits::recompile_vertex_program(rsx_vp, new_shader, m_next_id++);
 
+		m_last_vertex_program = &new_shader;
 		return std::forward_as_tuple(new_shader, false);
 	}
 
 	/// bool here to inform that the program was preexisting.
 	std::tuple<const fragment_program_type&, bool> search_fragment_program(const RSXFragmentProgram& rsx_fp)
 	{
+		m_last_fragment_program_addr = rsx_fp.addr;
+
 		const auto& I = m_fragment_shader_cache.find(rsx_fp);
 		if (I != m_fragment_shader_cache.end())
 		{
+			m_last_fragment_program = &I->second;
 			return std::forward_as_tuple(I->second, true);
 		}
 		LOG_NOTICE(RSX, "FP not found in buffer!");
@@ -172,11 +265,105 @@ protected:
 		RSXFragmentProgram new_fp_key = rsx_fp;
 		new_fp_key.addr = fragment_program_ucode_copy;
 		fragment_program_type &new_shader = m_fragment_shader_cache[new_fp_key];
+		tracing::scope trace(tracing::category::shader, "fragment program compile");
 		backend_traits::recompile_fragment_program(rsx_fp, new_shader, m_next_id++);
 
+		m_last_fragment_program = &new_shader;
 		return std::forward_as_tuple(new_shader, false);
 	}
 
+	const fragment_program_type* find_fragment_program(const RSXFragmentProgram& rsx_fp) const
+	{
+		// Avoid hashing the ucode again for the program found by the pipeline lookup
+		if (m_last_fragment_program && rsx_fp.addr == m_last_fragment_program_addr)
+		{
+			return m_last_fragment_program;
+		}
+
+		const auto I = m_fragment_shader_cache.find(rsx_fp);
+		return I != m_fragment_shader_cache.end() ? &I->second : nullptr;
+	}
+
+	__m128i patch_constant(const __m128i shuffled_vector, bool sanitize) const
+	{
+		if (!patch_table.is_empty())
+		{
+			//Same as program_buffer_patch_entry::test_and_set on all lanes at once, the first matching entry wins
+			//TODO: Use fp comparison with fabsf without hurting performance
+			const __m128i masked = _mm_and_si128(shuffled_vector, _mm_set1_epi32(0x7fffffff));
+			const __m128i high_bits = _mm_and_si128(shuffled_vector, _mm_set1_epi32(~0x7FFFFFF));
+			__m128i result = shuffled_vector;
+			__m128i unpatched = _mm_set1_epi32(-1);
+
+			for (auto& e : patch_table.db)
+			{
+				const __m128i match = _mm_and_si128(unpatched, _mm_cmpeq_epi32(masked, _mm_set1_epi32(e.second.hex_key & 0x7fffffff)));
+				const __m128i patched = _mm_or_si128(high_bits, _mm_set1_epi32(e.second.hex_value));
+				result = _mm_or_si128(_mm_andnot_si128(match, result), _mm_and_si128(match, patched));
+				unpatched = _mm_andnot_si128(match, unpatched);
+
+				if (!_mm_movemask_epi8(unpatched))
+				{
+					break;
+				}
+			}
+
+			return result;
+		}
+
+		if (sanitize)
+		{
+			//Convert NaNs and Infs to 0
+			const auto masked = _mm_and_si128(shuffled_vector, _mm_set1_epi32(0x7fffffff));
+			const auto valid = _mm_cmplt_epi32(masked, _mm_set1_epi32(0x7f800000));
+			return _mm_and_si128(shuffled_vector, valid);
+		}
+
+		return shuffled_vector;
+	}
+
+	/// Thread-safe variants for preloading from several workers. Entries are inserted under the lock and compiled in place
+	/// outside of it; node references stay valid across rehashing. Only safe while no other thread looks up programs.
+	void preload_vertex_program(const RSXVertexProgram& rsx_vp)
+	{
+		vertex_program_type* new_shader;
+		size_t id;
+		{
+			std::lock_guard<std::mutex> lock(s_mtx);
+			if (m_vertex_shader_cache.find(rsx_vp) != m_vertex_shader_cache.end())
+				return;
+
+			new_shader = &m_vertex_shader_cache[rsx_vp];
+			id = m_next_id++;
+		}
+
+		tracing::scope trace(tracing::category::shader, "vertex program compile");
+		backend_traits::recompile_vertex_program(rsx_vp, *new_shader, id);
+	}
+
+	void preload_fragment_program(const RSXFragmentProgram& rsx_fp)
+	{
+		fragment_program_type* new_shader;
+		size_t id;
+		{
+			std::lock_guard<std::mutex> lock(s_mtx);
+			if (m_fragment_shader_cache.find(rsx_fp) != m_fragment_shader_cache.end())
+				return;
+
+			size_t fragment_program_size = program_hash_util::fragment_program_utils::get_fragment_program_ucode_size(rsx_fp.addr);
+			gsl::not_null<void*> fragment_program_ucode_copy = malloc(fragment_program_size);
+			std::memcpy(fragment_program_ucode_copy, rsx_fp.addr, fragment_program_size);
+			RSXFragmentProgram new_fp_key = rsx_fp;
+			new_fp_key.addr = fragment_program_ucode_copy;
+
+			new_shader = &m_fragment_shader_cache[new_fp_key];
+			id = m_next_id++;
+		}
+
+		tracing::scope trace(tracing::category::shader, "fragment program compile");
+		backend_traits::recompile_fragment_program(rsx_fp, *new_shader, id);
+	}
+
 public:
 
 	struct program_buffer_patch_entry
@@ -252,6 +439,8 @@ public:
 	program_state_cache() = default;
 	~program_state_cache()
 	{
+		stop_pipeline_workers();
+
 		for (auto& pair : m_fragment_shader_cache)
 		{
 			free(pair.first.addr);
@@ -307,7 +496,9 @@ public:
 		LOG_NOTICE(RSX, "*** vp id = %d", vertex_program.id);
 		LOG_NOTICE(RSX, "*** fp id = %d", fragment_program.id);
 
+		tracing::scope trace(tracing::category::shader, "pipeline build");
 		pipeline_storage_type pipeline = backend_traits::build_pipeline(vertex_program, fragment_program, pipelineProperties, std::forward<Args>(args)...);
+		perf::rsx_pipelines_compiled.add();
 		std::lock_guard<std::mutex> lock(s_mtx);
 		auto &rtn = m_storage[key] = std::move(pipeline);
 		m_cache_miss_flag = true;
@@ -316,74 +507,125 @@ public:
 		return rtn;
 	}
 
+	/// Like getGraphicPipelineState, but a missing pipeline is built on a worker thread and nullptr is returned until it is ready.
+	/// Programs are still decompiled on the calling thread. Args are copied into the job.
+	template<typename... Args>
+	pipeline_storage_type* getGraphicPipelineStateAsync(
+		const RSXVertexProgram& vertexShader,
+		const RSXFragmentProgram& fragmentShader,
+		pipeline_properties& pipelineProperties,
+		Args&& ...args
+		)
+	{
+		const auto &vp_search = search_vertex_program(vertexShader);
+		const auto &fp_search = search_fragment_program(fragmentShader);
+		const vertex_program_type &vertex_program = std::get<0>(vp_search);
+		const fragment_program_type &fragment_program = std::get<0>(fp_search);
+
+		backend_traits::validate_pipeline_properties(vertex_program, fragment_program, pipelineProperties);
+		pipeline_key key = { vertex_program.id, fragment_program.id, pipelineProperties };
+
+		std::lock_guard<std::mutex> lock(s_mtx);
+		m_cache_miss_flag = false;
+
+		const auto I = m_storage.find(key);
+		if (I != m_storage.end())
+		{
+			return &I->second;
+		}
+
+		if (!m_pending_pipelines.insert(key).second)
+		{
+			// Already queued
+			return nullptr;
+		}
+
+		LOG_NOTICE(RSX, "Queueing program : vp id = %d, fp id = %d", vertex_program.id, fragment_program.id);
+		m_cache_miss_flag = true;
+
+		enqueue_pipeline_job([this, key, &vertex_program, &fragment_program, args...]()
+		{
+			tracing::scope trace(tracing::category::shader, "pipeline build");
+			pipeline_storage_type pipeline = backend_traits::build_pipeline(vertex_program, fragment_program, key.properties, args...);
+			perf::rsx_pipelines_compiled.add();
+
+			std::lock_guard<std::mutex> lock(s_mtx);
+			m_storage[key] = std::move(pipeline);
+			m_pending_pipelines.erase(key);
+		});
+
+		return nullptr;
+	}
+
+	u32 get_pending_pipeline_count()
+	{
+		std::lock_guard<std::mutex> lock(s_mtx);
+		return (u32)m_pending_pipelines.size();
+	}
+
 	size_t get_fragment_constants_buffer_size(const RSXFragmentProgram &fragmentShader) const
 	{
-		const auto I = m_fragment_shader_cache.find(fragmentShader);
-		if (I != m_fragment_shader_cache.end())
-			return I->second.FragmentConstantOffsetCache.size() * 4 * sizeof(float);
+		const auto program = find_fragment_program(fragmentShader);
+		if (program)
+			return program->FragmentConstantOffsetCache.size() * 4 * sizeof(float);
 		LOG_ERROR(RSX, "Can't retrieve constant offset cache");
 		return 0;
 	}
 
 	void fill_fragment_constants_buffer(gsl::span<f32, gsl::dynamic_range> dst_buffer, const RSXFragmentProgram &fragment_program, bool sanitize = false) const
 	{
-		const auto I = m_fragment_shader_cache.find(fragment_program);
-		if (I == m_fragment_shader_cache.end())
+		const auto program = find_fragment_program(fragment_program);
+		if (!program)
 			return;
 
-		verify(HERE), (dst_buffer.size_bytes() >= ::narrow<int>(I->second.FragmentConstantOffsetCache.size()) * 16);
+		verify(HERE), (dst_buffer.size_bytes() >= ::narrow<int>(program->FragmentConstantOffsetCache.size()) * 16);
 
 		f32* dst = dst_buffer.data();
-		alignas(16) f32 tmp[4];
-		for (size_t offset_in_fragment_program : I->second.FragmentConstantOffsetCache)
+		for (size_t offset_in_fragment_program : program->FragmentConstantOffsetCache)
 		{
 			char* data = (char*)fragment_program.addr + (u32)offset_in_fragment_program;
 			const __m128i vector = _mm_loadu_si128((__m128i*)data);
 			const __m128i shuffled_vector = _mm_or_si128(_mm_slli_epi16(vector, 8), _mm_srli_epi16(vector, 8));
+			_mm_stream_si128((__m128i*)dst, patch_constant(shuffled_vector, sanitize));
 
-			if (!patch_table.is_empty())
-			{
-				_mm_store_ps(tmp, _mm_castsi128_ps(shuffled_vector));
-				bool patched;
+			dst += 4;
+		}
+	}
 
-				for (int i = 0; i < 4; ++i)
-				{
-					patched = false;
-					for (auto& e : patch_table.db)
-					{
-						//TODO: Use fp comparison with fabsf without hurting performance
-						patched = e.second.test_and_set(tmp[i], &dst[i]);
-						if (patched)
-						{
-							break;
-						}
-					}
+	/// Copies the ucode with its halfwords swapped, the embedded constants are patched like fill_fragment_constants_buffer does.
+	/// ucode_length is the length of the program in bytes.
+	void fill_fragment_program_ucode(void* dst_buffer, const RSXFragmentProgram &fragment_program, u32 ucode_length, bool sanitize = false) const
+	{
+		const auto program = find_fragment_program(fragment_program);
+		if (!program)
+			return;
 
-					if (!patched)
-					{
-						dst[i] = tmp[i];
-					}
-				}
-			}
-			else if (sanitize)
-			{
-				//Convert NaNs and Infs to 0
-				const auto masked = _mm_and_si128((__m128i&)shuffled_vector, _mm_set1_epi32(0x7fffffff));
-				const auto valid = _mm_cmplt_epi32(masked, _mm_set1_epi32(0x7f800000));
-				const auto result = _mm_and_si128((__m128i&)shuffled_vector, valid);
-				_mm_stream_si128((__m128i*)dst, (__m128i&)result);
-			}
-			else
-			{
-				_mm_stream_si128((__m128i*)dst, shuffled_vector);
-			}
+		const __m128i* src = (const __m128i*)fragment_program.addr;
+		__m128i* dst = (__m128i*)dst_buffer;
 
-			dst += 4;
+		for (u32 n = 0; n < ucode_length / 16; ++n)
+		{
+			const __m128i vector = _mm_loadu_si128(src + n);
+			_mm_storeu_si128(dst + n, _mm_or_si128(_mm_slli_epi16(vector, 8), _mm_srli_epi16(vector, 8)));
+		}
+
+		for (size_t offset_in_fragment_program : program->FragmentConstantOffsetCache)
+		{
+			if (offset_in_fragment_program >= ucode_length)
+				continue;
+
+			__m128i* data = dst + (offset_in_fragment_program / 16);
+			_mm_storeu_si128(data, patch_constant(_mm_loadu_si128(data), sanitize));
 		}
 	}
 
 	void clear()
 	{
 		m_storage.clear();
+
+		m_last_vertex_program = nullptr;
+		m_last_vertex_program_revision = 0;
+		m_last_fragment_program = nullptr;
+		m_last_fragment_program_addr = nullptr;
 	}
 };
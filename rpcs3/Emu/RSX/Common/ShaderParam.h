@@ -105,6 +105,18 @@ struct ParamArray
 {
 	std::vector<ParamType> params[PF_PARAM_COUNT];
 
+	// ParamType is not assignable, rebuild the tables from copies
+	void CopyFrom(const ParamArray& other)
+	{
+		for (u32 i = 0; i < PF_PARAM_COUNT; ++i)
+		{
+			params[i].clear();
+
+			for (const auto& param : other.params[i])
+				params[i].push_back(param);
+		}
+	}
+
 	ParamType* SearchParam(const ParamFlag &flag, const std::string& type)
 	{
 		for (u32 i = 0; i<params[flag].size(); ++i)
@@ -384,6 +384,76 @@ void upload_texture_subresource(gsl::span<gsl::byte> dst_buffer, const rsx_subre
 	}
 }
 
+void upload_texture_subresources(const std::vector<texture_subresource_upload>& uploads, int format, bool is_swizzled, bool vtc_support, size_t dst_row_pitch_multiple_of)
+{
+	// Below these sizes the dispatch costs more than the decode
+	constexpr size_t min_parallel_upload_size = 256 * 1024;
+	constexpr size_t min_band_size = 64 * 1024;
+
+	// Also rejects unknown formats on the calling thread before any work is handed out
+	const u32 block_size = get_format_block_size_in_bytes(format);
+
+	const auto get_dst_pitch = [&](const rsx_subresource_layout& layout)
+	{
+		return ::narrow<u32>(align<size_t>(layout.width_in_block * block_size, dst_row_pitch_multiple_of));
+	};
+
+	// Destination buffers may be shared scratch space larger than the level, size the work from the layout
+	size_t total_size = 0;
+	for (const auto& upload : uploads)
+	{
+		const auto& layout = upload.src_layout;
+		total_size += size_t{ get_dst_pitch(layout) } * layout.height_in_block * layout.depth;
+	}
+
+	const u32 thread_count = rsx::get_parallel_thread_count();
+
+	if (total_size < min_parallel_upload_size || thread_count <= 1)
+	{
+		for (const auto& upload : uploads)
+		{
+			upload_texture_subresource(upload.dst_buffer, upload.src_layout, format, is_swizzled, vtc_support, dst_row_pitch_multiple_of);
+		}
+
+		return;
+	}
+
+	std::vector<texture_subresource_upload> tasks;
+	tasks.reserve(uploads.size() + thread_count);
+
+	for (const auto& upload : uploads)
+	{
+		const auto& layout = upload.src_layout;
+		const u32 dst_pitch = get_dst_pitch(layout);
+		const size_t size = size_t{ dst_pitch } * layout.height_in_block * layout.depth;
+
+		// Rows of linear 2D levels are independent, swizzled and volume levels are decoded whole
+		if (is_swizzled || layout.depth != 1 || size < 2 * min_band_size || layout.width_in_block > layout.pitch_in_block)
+		{
+			tasks.push_back(upload);
+			continue;
+		}
+
+		const u32 src_pitch = layout.pitch_in_block * block_size;
+		const u32 bands = std::min<u32>({ thread_count, ::narrow<u32>(size / min_band_size), layout.height_in_block });
+		const u16 rows_per_band = ::narrow<u16>((layout.height_in_block + bands - 1) / bands);
+
+		for (u32 row = 0; row < layout.height_in_block; row += rows_per_band)
+		{
+			texture_subresource_upload band = upload;
+			band.src_layout.height_in_block = ::narrow<u16>(std::min<u32>(rows_per_band, layout.height_in_block - row));
+			band.src_layout.data = layout.data.subspan(row * src_pitch);
+			band.dst_buffer = upload.dst_buffer.subspan(row * dst_pitch, band.src_layout.height_in_block * dst_pitch);
+			tasks.push_back(band);
+		}
+	}
+
+	rsx::parallel_for(::size32(tasks), [&](u32 index)
+	{
+		upload_texture_subresource(tasks[index].dst_buffer, tasks[index].src_layout, format, is_swizzled, vtc_support, dst_row_pitch_multiple_of);
+	});
+}
+
 /**
  * A texture is stored as an array of blocks, where a block is a pixel for standard texture
  * but is a structure containing several pixels for compressed format
@@ -58,6 +58,19 @@ std::vector<rsx_subresource_layout> get_subresources_layout(const rsx::vertex_te
 
 void upload_texture_subresource(gsl::span<gsl::byte> dst_buffer, const rsx_subresource_layout &src_layout, int format, bool is_swizzled, bool vtc_support, size_t dst_row_pitch_multiple_of);
 
+struct texture_subresource_upload
+{
+	gsl::span<gsl::byte> dst_buffer;
+	rsx_subresource_layout src_layout;
+};
+
+/**
+ * Same as upload_texture_subresource for a batch of subresources.
+ * Large batches are decoded on the image worker pool, with big linear 2D levels split in row bands.
+ * Returns once every subresource has been written.
+ */
+void upload_texture_subresources(const std::vector<texture_subresource_upload>& uploads, int format, bool is_swizzled, bool vtc_support, size_t dst_row_pitch_multiple_of);
+
 u8 get_format_block_size_in_bytes(int format);
 u8 get_format_block_size_in_texel(int format);
 u8 get_format_block_size_in_bytes(rsx::surface_color_format format);
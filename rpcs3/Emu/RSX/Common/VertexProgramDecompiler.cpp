@@ -2,8 +2,52 @@
 #include "Emu/System.h"
 
 #include "VertexProgramDecompiler.h"
+#include "Utilities/mutex.h"
 
 #include <algorithm>
+#include <typeindex>
+#include <unordered_map>
+
+namespace
+{
+	// The translated body only depends on the ucode, inputs, outputs and constants are emitted around it
+	struct vertex_body_key
+	{
+		std::type_index backend;
+		std::vector<u32> ucode;
+
+		bool operator==(const vertex_body_key& other) const
+		{
+			return backend == other.backend && ucode == other.ucode;
+		}
+	};
+
+	struct vertex_body_key_hash
+	{
+		size_t operator()(const vertex_body_key& key) const
+		{
+			// FNV 64-bit
+			size_t hash = 14695981039346656037ull;
+			for (const u32 word : key.ucode)
+			{
+				hash ^= word;
+				hash *= 1099511628211ull;
+			}
+
+			return hash ^ key.backend.hash_code();
+		}
+	};
+
+	struct vertex_body
+	{
+		std::string main_body;
+		ParamArray parr;
+		decltype(VertexProgramDecompiler::properties) properties;
+	};
+
+	shared_mutex g_vertex_body_mutex;
+	std::unordered_map<vertex_body_key, vertex_body, vertex_body_key_hash> g_vertex_bodies;
+}
 
 std::string VertexProgramDecompiler::GetMask(bool is_sca)
 {
@@ -362,7 +406,7 @@ std::string VertexProgramDecompiler::NotZeroPositive(const std::string& code)
 	return "max(" + code + ", 0.0000000001)";
 }
 
-std::string VertexProgramDecompiler::BuildCode()
+std::string VertexProgramDecompiler::BuildMainBody()
 {
 	std::string main_body;
 	for (uint i = 0, lvl = 1; i < m_instr_count; i++)
@@ -391,6 +435,11 @@ std::string VertexProgramDecompiler::BuildCode()
 		lvl += m_instructions[i].open_scopes;
 	}
 
+	return main_body;
+}
+
+std::string VertexProgramDecompiler::BuildCode(const std::string& main_body)
+{
 	std::stringstream OS;
 	insertHeader(OS);
 
@@ -415,6 +464,20 @@ VertexProgramDecompiler::VertexProgramDecompiler(const RSXVertexProgram& prog) :
 
 std::string VertexProgramDecompiler::Decompile()
 {
+	// State variants of an already translated program only need new declarations
+	vertex_body_key body_key{ typeid(*this), m_data };
+	{
+		reader_lock lock(g_vertex_body_mutex);
+
+		const auto found = g_vertex_bodies.find(body_key);
+		if (found != g_vertex_bodies.end())
+		{
+			m_parr.CopyFrom(found->second.parr);
+			properties = found->second.properties;
+			return BuildCode(found->second.main_body);
+		}
+	}
+
 	for (unsigned i = 0; i < PF_PARAM_COUNT; i++)
 		m_parr.params[i].clear();
 
@@ -759,7 +822,14 @@ std::string VertexProgramDecompiler::Decompile()
 		AddCode("}");
 	}
 
-	std::string result = BuildCode();
+	const std::string main_body = BuildMainBody();
+
+	{
+		writer_lock lock(g_vertex_body_mutex);
+		g_vertex_bodies.emplace(std::move(body_key), vertex_body{ main_body, m_parr, properties });
+	}
+
+	std::string result = BuildCode(main_body);
 
 	m_jump_lvls.clear();
 	m_body.clear();
@@ -81,7 +81,8 @@ struct VertexProgramDecompiler
 	void SetDST(bool is_sca, std::string value);
 	void SetDSTVec(const std::string& code);
 	void SetDSTSca(const std::string& code);
-	std::string BuildCode();
+	std::string BuildMainBody();
+	std::string BuildCode(const std::string& main_body);
 
 protected:
 	/** returns the type name of float vectors.
@@ -49,6 +49,11 @@ struct data_heap
 
 	char* m_name;
 public:
+	// Pressure statistics, maintained by alloc() and the backend
+	size_t m_high_water_mark;        // Peak allocated size since init
+	size_t m_recent_high_water_mark; // Peak allocated size since the backend last cleared it
+	u32 m_forced_flushes;            // Times the backend had to wait on the GPU for space in this heap
+
 	data_heap() = default;
 	~data_heap() = default;
 	data_heap(const data_heap&) = delete;
@@ -68,6 +73,10 @@ public:
 		m_min_guard_size = min_guard_size;
 		m_current_allocated_size = 0;
 		m_largest_allocated_pool = 0;
+
+		m_high_water_mark = 0;
+		m_recent_high_water_mark = 0;
+		m_forced_flushes = 0;
 	}
 
 	template<int Alignment>
@@ -85,6 +94,8 @@ public:
 		const size_t block_length = (aligned_put_pos - m_put_pos) + alloc_size;
 		m_current_allocated_size += block_length;
 		m_largest_allocated_pool = std::max(m_largest_allocated_pool, block_length);
+		m_high_water_mark = std::max(m_high_water_mark, m_current_allocated_size);
+		m_recent_high_water_mark = std::max(m_recent_high_water_mark, m_current_allocated_size);
 
 		if (aligned_put_pos + alloc_size < m_size)
 		{
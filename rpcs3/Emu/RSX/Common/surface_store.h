@@ -150,6 +150,60 @@ namespace rsx
 		std::unordered_map<u32, surface_storage_type> m_render_targets_storage = {};
 		std::unordered_map<u32, surface_storage_type> m_depth_stencil_storage = {};
 
+		/**
+		 * Address-sorted view of a surface storage, rebuilt lazily whenever cache_tag changes.
+		 * max_range bounds how far below a queried address a surface can start and still overlap it.
+		 */
+		struct surface_range_index
+		{
+			std::vector<std::pair<u32, surface_type>> entries;
+			u32 max_range = 0;
+
+			void rebuild(const std::unordered_map<u32, surface_storage_type>& storage)
+			{
+				entries.clear();
+				max_range = 0;
+
+				for (auto &tex_info : storage)
+				{
+					auto surface = Traits::get(tex_info.second);
+
+					// Doubled to cover the AA read modes which span twice the rows
+					const u32 range = (surface->get_rsx_pitch() * surface->get_surface_height()) << 1;
+
+					entries.emplace_back(tex_info.first, surface);
+					max_range = std::max(max_range, range);
+				}
+
+				std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+			}
+
+			// Entries starting within [start - max_range, end), i.e every surface that may intersect [start, end)
+			std::pair<size_t, size_t> find(u32 start, u32 end) const
+			{
+				const u32 lower = (start > max_range) ? start - max_range : 0;
+				const auto cmp = [](const std::pair<u32, surface_type>& e, u32 addr) { return e.first < addr; };
+
+				const auto first = std::lower_bound(entries.begin(), entries.end(), lower, cmp);
+				const auto last = std::lower_bound(first, entries.end(), end, cmp);
+				return{ size_t(first - entries.begin()), size_t(last - entries.begin()) };
+			}
+		};
+
+		surface_range_index m_render_targets_index;
+		surface_range_index m_depth_stencil_index;
+		u64 m_surface_index_tag = UINT64_MAX;
+
+		void update_surface_index()
+		{
+			if (m_surface_index_tag == cache_tag)
+				return;
+
+			m_render_targets_index.rebuild(m_render_targets_storage);
+			m_depth_stencil_index.rebuild(m_depth_stencil_storage);
+			m_surface_index_tag = cache_tag;
+		}
+
 	public:
 		std::array<std::tuple<u32, surface_type>, 4> m_bound_render_targets = {};
 		std::tuple<u32, surface_type> m_bound_depth_stencil = {};
@@ -797,15 +851,16 @@ namespace rsx
 			u16  w;
 			u16  h;
 
+			update_surface_index();
+
 			if (!ignore_color_formats)
 			{
-				for (auto &tex_info : m_render_targets_storage)
+				// Walk down from the closest surface base below texaddr
+				const auto range = m_render_targets_index.find(texaddr, texaddr + 1);
+				for (size_t i = range.second; i-- > range.first;)
 				{
-					const u32 this_address = std::get<0>(tex_info);
-					if (texaddr < this_address)
-						continue;
-
-					surface = std::get<1>(tex_info).get();
+					const u32 this_address = m_render_targets_index.entries[i].first;
+					surface = m_render_targets_index.entries[i].second;
 					if (surface->get_rsx_pitch() != requested_pitch)
 						continue;
 
@@ -825,13 +880,11 @@ namespace rsx
 			if (!ignore_depth_formats)
 			{
 				//Check depth surfaces for overlap
-				for (auto &tex_info : m_depth_stencil_storage)
+				const auto range = m_depth_stencil_index.find(texaddr, texaddr + 1);
+				for (size_t i = range.second; i-- > range.first;)
 				{
-					const u32 this_address = std::get<0>(tex_info);
-					if (texaddr < this_address)
-						continue;
-
-					surface = std::get<1>(tex_info).get();
+					const u32 this_address = m_depth_stencil_index.entries[i].first;
+					surface = m_depth_stencil_index.entries[i].second;
 					if (surface->get_rsx_pitch() != requested_pitch)
 						continue;
 
@@ -856,15 +909,13 @@ namespace rsx
 			std::vector<surface_overlap_info> result;
 			const u32 limit = texaddr + (required_pitch * required_height);
 
-			auto process_list_function = [&](std::unordered_map<u32, surface_storage_type>& data, bool is_depth)
+			auto process_list_function = [&](const surface_range_index& index, bool is_depth)
 			{
-				for (auto &tex_info : data)
+				const auto range = index.find(texaddr, limit);
+				for (size_t i = range.first; i < range.second; ++i)
 				{
-					auto this_address = std::get<0>(tex_info);
-					if (this_address >= limit)
-						continue;
-
-					auto surface = std::get<1>(tex_info).get();
+					const auto this_address = index.entries[i].first;
+					auto surface = index.entries[i].second;
 					const auto pitch = surface->get_rsx_pitch();
 					if (pitch != required_pitch)
 						continue;
@@ -902,8 +953,10 @@ namespace rsx
 				}
 			};
 
-			process_list_function(m_render_targets_storage, false);
-			process_list_function(m_depth_stencil_storage, true);
+			update_surface_index();
+
+			process_list_function(m_render_targets_index, false);
+			process_list_function(m_depth_stencil_index, true);
 			return result;
 		}
 
@@ -3,13 +3,22 @@
 #include "../rsx_cache.h"
 #include "../rsx_utils.h"
 #include "TextureUtils.h"
+#include "Utilities/perf_counters.h"
 
 #include <atomic>
+#include <numeric>
 
 extern u64 get_system_time();
 
 namespace rsx
 {
+	// Common lock class of all texture cache instances
+	inline lock_class& get_texture_cache_lock_class()
+	{
+		static lock_class s_class{"texture_cache", 20};
+		return s_class;
+	}
+
 	enum texture_create_flags
 	{
 		default_component_order = 0,
@@ -79,6 +88,14 @@ namespace rsx
 
 		u64 cache_tag = 0;
 
+		//Texture cache frame of the last bind, orders the eviction of shader read sections
+		u64 last_use_frame = 0;
+
+		//Hashed sections are left unprotected and validated against their contents at bind time
+		bool hashed = false;
+		u64 content_hash = 0;
+		u32 stable_binds = 0;
+
 		memory_read_flags readback_behaviour = memory_read_flags::flush_once;
 		rsx::texture_create_flags view_flags = rsx::texture_create_flags::default_component_order;
 		rsx::texture_upload_context context = rsx::texture_upload_context::shader_read;
@@ -120,6 +137,39 @@ namespace rsx
 			num_writes++;
 		}
 
+		u64 compute_content_hash() const
+		{
+			return rpcs3::hash64(vm::_ptr<u8>(cpu_address_base), cpu_address_range);
+		}
+
+		void set_hashed()
+		{
+			hashed = true;
+			content_hash = compute_content_hash();
+			stable_binds = 0;
+		}
+
+		void reset_hashed()
+		{
+			hashed = false;
+			content_hash = 0;
+			stable_binds = 0;
+		}
+
+		bool is_hashed() const
+		{
+			return hashed;
+		}
+
+		bool test_content_hash()
+		{
+			if (compute_content_hash() != content_hash)
+				return false;
+
+			stable_binds++;
+			return true;
+		}
+
 		void reset_write_statistics()
 		{
 			if (read_history.size() == 16)
@@ -286,7 +336,50 @@ namespace rsx
 			u32 max_addr = 0;
 			u32 min_addr = UINT32_MAX;
 
-			void notify(u32 addr, u32 data_size)
+			//Coarse page -> slot index. Slots are reused for new addresses without removing their old entries,
+			//so lookups return a superset and callers still run their precise overlap tests
+			static constexpr u32 index_page_shift = 16;
+			std::unordered_map<u32, std::vector<u32>> page_index;
+
+			void index_section(u32 slot, u32 addr, u32 data_size)
+			{
+				const u32 first_page = addr >> index_page_shift;
+				const u32 last_page = (addr + std::max(data_size, 1u) - 1) >> index_page_shift;
+
+				for (u32 page = first_page; page <= last_page; ++page)
+				{
+					auto &slots = page_index[page];
+					if (std::find(slots.begin(), slots.end(), slot) == slots.end())
+						slots.push_back(slot);
+				}
+			}
+
+			//Returns the sorted, unique slots of all sections that may intersect [addr, addr + range)
+			void get_candidates(u32 addr, u32 range, std::vector<u32>& out) const
+			{
+				out.clear();
+
+				const u64 limit = std::min<u64>(u64{addr} + range, u64{max_addr} + max_range);
+				const u32 start = std::max(addr, min_addr);
+
+				if (range == 0 || start >= limit)
+					return;
+
+				const u32 first_page = start >> index_page_shift;
+				const u32 last_page = u32((limit - 1) >> index_page_shift);
+
+				for (u32 page = first_page; page <= last_page; ++page)
+				{
+					auto found = page_index.find(page);
+					if (found != page_index.end())
+						out.insert(out.end(), found->second.begin(), found->second.end());
+				}
+
+				std::sort(out.begin(), out.end());
+				out.erase(std::unique(out.begin(), out.end()), out.end());
+			}
+
+			void notify(const section_storage_type& section, u32 addr, u32 data_size)
 			{
 				verify(HERE), valid_count >= 0;
 
@@ -297,6 +390,8 @@ namespace rsx
 				max_addr = std::max(max_addr, addr);
 				min_addr = std::min(min_addr, addr_base);
 				valid_count++;
+
+				index_section(u32(&section - data.data()), addr_base, block_sz);
 			}
 
 			void notify()
@@ -308,7 +403,7 @@ namespace rsx
 			void add(section_storage_type& section, u32 addr, u32 data_size)
 			{
 				data.push_back(std::move(section));
-				notify(addr, data_size);
+				notify(data.back(), addr, data_size);
 			}
 
 			void remove_one()
@@ -441,7 +536,7 @@ namespace rsx
 
 	protected:
 
-		shared_mutex m_cache_mutex;
+		shared_mutex m_cache_mutex{get_texture_cache_lock_class()};
 		std::unordered_map<u32, ranged_storage> m_cache;
 		std::unordered_multimap<u32, std::pair<deferred_subresource, image_view_type>> m_temporary_subresource_cache;
 
@@ -452,6 +547,12 @@ namespace rsx
 
 		std::unordered_map<u32, framebuffer_memory_characteristics> m_cache_miss_statistics_table;
 
+		//Framebuffer memory the CPU has read back, keyed by address. Counts down the speculative copies still taken for it
+		std::unordered_map<u32, u32> m_readback_statistics_table;
+
+		//Number of times a shader read section was invalidated by CPU writes, keyed by address. Frequent offenders switch to hashing
+		std::unordered_map<u32, std::pair<u32, u32>> m_fault_statistics_table;
+
 		//Map of messages to only emit once
 		std::unordered_map<std::string, bool> m_once_only_messages_map;
 
@@ -467,8 +568,19 @@ namespace rsx
 		std::atomic<s32> m_unreleased_texture_objects = { 0 }; //Number of invalidated objects not yet freed from memory
 		std::atomic<u32> m_texture_memory_in_use = { 0 };
 
+		//Memory budget
+		const u64 m_eviction_min_age = 60; // Frames a section has to go unused before it can be evicted
+		u64 m_frame_index = 0;
+		u32 m_last_evicted_count = 0;
+		u64 m_last_evicted_bytes = 0;
+		utils::memory_gauge m_texture_memory_gauge{ utils::memory_class::texture_cache };
+
 		//Other statistics
 		const u32 m_cache_miss_threshold = 8; // How many times an address can miss speculative writing before it is considered high priority
+		const u32 m_readback_prediction_length = 16; // How many syncs a readback keeps its address copied ahead without another read
+		const u32 m_hashed_section_fault_threshold = 4; // How many times a section can be invalidated before it is validated by hashing instead of protection
+		const u32 m_hashed_section_max_size = 0x10000; // Largest section worth hashing on every bind
+		const u32 m_hashed_section_stable_binds = 64; // Unchanged binds after which a hashed section goes back to page protection
 		std::atomic<u32> m_num_flush_requests = { 0 };
 		std::atomic<u32> m_num_cache_misses = { 0 };
 		std::atomic<u32> m_num_cache_speculative_writes = { 0 };
@@ -531,22 +643,19 @@ namespace rsx
 
 		std::pair<utils::protection, section_storage_type*> get_memory_protection(u32 address)
 		{
-			auto found = m_cache.find(get_block_address(address));
-			if (found != m_cache.end())
-			{
-				for (auto &tex : found->second.data)
-				{
-					if (tex.is_locked() && tex.overlaps(address, rsx::overlap_test_bounds::protected_range))
-						return{ tex.get_protection(), &tex };
-				}
-			}
+			std::vector<u32> candidates;
 
-			//Get the preceding block and check if any hits are found
-			found = m_cache.find(get_block_address(address) - get_block_size());
-			if (found != m_cache.end())
+			//Check the owning block first, then the preceding block for sections spilling over
+			for (const u32 block : { get_block_address(address), get_block_address(address) - get_block_size() })
 			{
-				for (auto &tex : found->second.data)
+				auto found = m_cache.find(block);
+				if (found == m_cache.end())
+					continue;
+
+				found->second.get_candidates(address, 1, candidates);
+				for (const u32 slot : candidates)
 				{
+					auto &tex = found->second.data[slot];
 					if (tex.is_locked() && tex.overlaps(address, rsx::overlap_test_bounds::protected_range))
 						return{ tex.get_protection(), &tex };
 				}
@@ -584,6 +693,7 @@ namespace rsx
 		std::vector<std::pair<section_storage_type*, ranged_storage*>> get_intersecting_set(u32 address, u32 range)
 		{
 			std::vector<std::pair<section_storage_type*, ranged_storage*>> result;
+			std::vector<u32> candidates;
 			u32 last_dirty_block = UINT32_MAX;
 			const u64 cache_tag = get_system_time();
 
@@ -604,13 +714,20 @@ namespace rsx
 					//Only if a valid range, ignore empty sets
 					if (trampled_range.first >= (range_data.max_addr + range_data.max_range) || range_data.min_addr >= trampled_range.second)
 						continue;
+
+					range_data.get_candidates(trampled_range.first, trampled_range.second - trampled_range.first, candidates);
+				}
+				else
+				{
+					candidates.resize(range_data.data.size());
+					std::iota(candidates.begin(), candidates.end(), 0);
 				}
 
-				for (int i = 0; i < range_data.data.size(); i++)
+				for (int i = 0; i < candidates.size(); i++)
 				{
-					auto &tex = range_data.data[i];
+					auto &tex = range_data.data[candidates[i]];
 					if (tex.cache_tag == cache_tag) continue; //already processed
-					if (!tex.is_locked()) continue;	//flushable sections can be 'clean' but unlocked. TODO: Handle this better
+					if (!tex.is_locked() && (!tex.is_hashed() || tex.is_dirty())) continue;	//flushable sections can be 'clean' but unlocked. TODO: Handle this better
 
 					const auto bounds_test = (strict_range_check || tex.get_context() == rsx::texture_upload_context::blit_engine_dst) ?
 						rsx::overlap_test_bounds::full_range :
@@ -624,9 +741,12 @@ namespace rsx
 						if (new_range.first != trampled_range.first ||
 							new_range.second != trampled_range.second)
 						{
-							i = 0;
 							trampled_range = new_range;
 							range_reset = true;
+
+							//The grown range may pull in sections outside of the current candidate list
+							range_data.get_candidates(trampled_range.first, trampled_range.second - trampled_range.first, candidates);
+							i = -1;
 						}
 
 						tex.cache_tag = cache_tag;
@@ -743,6 +863,7 @@ namespace rsx
 									record_cache_miss(*obj.first);
 								}
 
+								record_readback(*obj.first);
 								m_num_flush_requests++;
 								result.sections_to_unprotect.push_back(obj.first);
 							}
@@ -759,6 +880,9 @@ namespace rsx
 
 					if (!obj.first->is_flushable())
 					{
+						if (obj.first->get_context() == rsx::texture_upload_context::shader_read)
+							record_section_fault(*obj.first);
+
 						obj.first->set_dirty(true);
 						m_unreleased_texture_objects++;
 					}
@@ -922,6 +1046,20 @@ namespace rsx
 			return results;
 		}
 
+		bool is_gpu_resident_blit_target(u32 rsx_address, u32 range)
+		{
+			reader_lock lock(m_cache_mutex);
+
+			for (const auto &surface : find_texture_from_range(rsx_address, range))
+			{
+				//Flushable blit targets have no valid copy in guest memory until the CPU touches them
+				if (surface->get_context() == rsx::texture_upload_context::blit_engine_dst && surface->is_flushable())
+					return true;
+			}
+
+			return false;
+		}
+
 		section_storage_type *find_texture_from_dimensions(u32 rsx_address, u16 width = 0, u16 height = 0, u16 depth = 0, u16 mipmaps = 0)
 		{
 			auto found = m_cache.find(get_block_address(rsx_address));
@@ -993,7 +1131,7 @@ namespace rsx
 						free_texture_section(*best_fit.first);
 					}
 
-					best_fit.second->notify(rsx_address, rsx_size);
+					best_fit.second->notify(*best_fit.first, rsx_address, rsx_size);
 					return *best_fit.first;
 				}
 
@@ -1010,7 +1148,7 @@ namespace rsx
 							free_texture_section(tex);
 						}
 
-						range_data.notify(rsx_address, rsx_size);
+						range_data.notify(tex, rsx_address, rsx_size);
 						return tex;
 					}
 				}
@@ -1140,7 +1278,12 @@ namespace rsx
 				return true;
 
 			if (skip_synchronized && region->is_synchronized())
-				return false;
+			{
+				//Keep the existing copy unless the surface has been rendered to since it was taken
+				//Refreshing here keeps flush_always sections from taking a hard sync in the fault handler
+				if (region->get_sync_timestamp() >= rsx::get_current_renderer()->ROP_sync_timestamp)
+					return false;
+			}
 
 			if ((allowed_types_mask & region->get_context()) == 0)
 				return true;
@@ -1191,6 +1334,7 @@ namespace rsx
 				}
 			}
 
+			std::vector<u32> candidates;
 			for (auto &address_range : m_cache)
 			{
 				if (address_range.first == address)
@@ -1205,8 +1349,10 @@ namespace rsx
 				if (address < lock_base || address >= lock_limit)
 					continue;
 
-				for (auto &tex : range_data.data)
+				range_data.get_candidates(address, 1, candidates);
+				for (const u32 slot : candidates)
 				{
+					auto &tex = range_data.data[slot];
 					if (tex.is_dirty()) continue;
 					if (!tex.is_flushable()) continue;
 
@@ -1227,6 +1373,7 @@ namespace rsx
 				return{};
 
 			writer_lock lock(m_cache_mutex);
+			protection_batch_scope batch;
 			return invalidate_range_impl_base(address, range, is_writing, false, true, allow_flush, std::forward<Args>(extras)...);
 		}
 
@@ -1238,6 +1385,7 @@ namespace rsx
 				return {};
 
 			writer_lock lock(m_cache_mutex);
+			protection_batch_scope batch;
 			return invalidate_range_impl_base(address, range, is_writing, discard, false, allow_flush, std::forward<Args>(extras)...);
 		}
 
@@ -1245,6 +1393,7 @@ namespace rsx
 		bool flush_all(thrashed_set& data, Args&&... extras)
 		{
 			writer_lock lock(m_cache_mutex);
+			protection_batch_scope batch;
 
 			if (m_cache_update_tag.load(std::memory_order_consume) == data.cache_tag)
 			{
@@ -1270,6 +1419,7 @@ namespace rsx
 							record_cache_miss(*tex);
 						}
 
+						record_readback(*tex);
 						m_num_flush_requests++;
 					}
 				}
@@ -1302,6 +1452,30 @@ namespace rsx
 			return true;
 		}
 
+		void record_readback(section_storage_type &tex)
+		{
+			if (tex.get_context() == texture_upload_context::framebuffer_storage)
+				m_readback_statistics_table[tex.get_section_base()] = m_readback_prediction_length;
+		}
+
+		/**
+		* Whether the CPU is expected to read back the framebuffer memory at this address,
+		* i.e. it has done so within the last few predictions. Each positive answer spends one prediction.
+		*/
+		bool predict_readback(u32 memory_address)
+		{
+			writer_lock lock(m_cache_mutex);
+
+			auto found = m_readback_statistics_table.find(memory_address);
+			if (found == m_readback_statistics_table.end())
+				return false;
+
+			if (--found->second == 0)
+				m_readback_statistics_table.erase(found);
+
+			return true;
+		}
+
 		void record_cache_miss(section_storage_type &tex)
 		{
 			m_num_cache_misses++;
@@ -1327,6 +1501,29 @@ namespace rsx
 			value.misses += 2;
 		}
 
+		void record_section_fault(const section_storage_type &tex)
+		{
+			auto &value = m_fault_statistics_table[tex.get_section_base()];
+			if (value.second != tex.get_section_size())
+			{
+				value = { 0, tex.get_section_size() };
+			}
+
+			value.first++;
+		}
+
+		bool should_hash_section(u32 memory_address, u32 memory_size) const
+		{
+			if (memory_size > m_hashed_section_max_size)
+				return false;
+
+			auto It = m_fault_statistics_table.find(memory_address);
+			if (It == m_fault_statistics_table.end() || It->second.second != memory_size)
+				return false;
+
+			return It->second.first >= m_hashed_section_fault_threshold;
+		}
+
 		template <typename ...Args>
 		bool flush_if_cache_miss_likely(texture_format fmt, u32 memory_address, u32 memory_size, Args&&... extras)
 		{
@@ -1408,6 +1605,61 @@ namespace rsx
 			m_unreleased_texture_objects = 0;
 		}
 
+		/**
+		 * Called once per frame by the backend with the memory it has to give back to stay within the device budget.
+		 * Shader read sections unused for a while are released, least recently used first. They are reuploaded from guest memory when bound again.
+		 * Framebuffer and blit sections may hold the only copy of their data and are never evicted.
+		 */
+		void evict_unused_sections(u64 bytes_to_free)
+		{
+			m_frame_index++;
+			m_last_evicted_count = 0;
+			m_last_evicted_bytes = 0;
+
+			if (!bytes_to_free)
+				return;
+
+			writer_lock lock(m_cache_mutex);
+
+			std::vector<std::pair<section_storage_type*, ranged_storage*>> candidates;
+			for (auto &address_range : m_cache)
+			{
+				for (auto &tex : address_range.second.data)
+				{
+					if (tex.get_context() != rsx::texture_upload_context::shader_read ||
+						!tex.exists() || tex.is_dirty() ||
+						tex.last_use_frame + m_eviction_min_age > m_frame_index)
+						continue;
+
+					candidates.emplace_back(&tex, &address_range.second);
+				}
+			}
+
+			std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b)
+			{
+				return a.first->last_use_frame < b.first->last_use_frame;
+			});
+
+			//Backends have to refresh their sampler states afterwards, they may still reference the released views
+			protection_batch_scope batch;
+			for (auto &candidate : candidates)
+			{
+				if (m_last_evicted_bytes >= bytes_to_free)
+					break;
+
+				auto &tex = *candidate.first;
+				tex.set_dirty(true);
+				tex.unprotect();
+				candidate.second->remove_one();
+
+				free_texture_section(tex);
+				m_texture_memory_in_use -= tex.get_section_size();
+
+				m_last_evicted_count++;
+				m_last_evicted_bytes += tex.get_section_size();
+			}
+		}
+
 		image_view_type create_temporary_subresource(commandbuffer_type &cmd, deferred_subresource& desc)
 		{
 			const auto found = m_temporary_subresource_cache.equal_range(desc.base_address);
@@ -1764,6 +2016,7 @@ namespace rsx
 				{
 					if (test_framebuffer(texaddr))
 					{
+						perf::rsx_texture_cache_hits.add();
 						return process_framebuffer_resource(cmd, texptr, texaddr, tex.format(), m_rtts,
 								tex_width, tex_height, depth, tex_pitch, extended_dimension, false, tex.remap(),
 								tex.decoded_remap());
@@ -1779,6 +2032,7 @@ namespace rsx
 				{
 					if (test_framebuffer(texaddr))
 					{
+						perf::rsx_texture_cache_hits.add();
 						return process_framebuffer_resource(cmd, texptr, texaddr, tex.format(), m_rtts,
 								tex_width, tex_height, depth, tex_pitch, extended_dimension, true, tex.remap(),
 								tex.decoded_remap());
@@ -1831,6 +2085,7 @@ namespace rsx
 						internal_width = rsx::apply_resolution_scale(internal_width, true);
 						internal_height = (extended_dimension == rsx::texture_dimension_extended::texture_dimension_1d)? 1: rsx::apply_resolution_scale(internal_height, true);
 
+						perf::rsx_texture_cache_hits.add();
 						return{ rsc.surface->get_surface(), deferred_request_command::copy_image_static, rsc.base_address, format,
 							rsx::apply_resolution_scale(rsc.x, false), rsx::apply_resolution_scale(rsc.y, false),
 							internal_width, internal_height, 1, texture_upload_context::framebuffer_storage, rsc.is_depth_surface, scale_x, scale_y,
@@ -1855,14 +2110,32 @@ namespace rsx
 							m_unreleased_texture_objects++;
 						}
 					}
+					else if (cached_texture->is_hashed() && !cached_texture->test_content_hash())
+					{
+						//Contents changed behind an unprotected section
+						record_section_fault(*cached_texture);
+						cached_texture->set_dirty(true);
+						m_unreleased_texture_objects++;
+					}
 					else
 					{
+						if (cached_texture->is_hashed() && cached_texture->stable_binds >= m_hashed_section_stable_binds)
+						{
+							//Writes have settled down, page protection is cheaper again
+							m_fault_statistics_table.erase(cached_texture->get_section_base());
+							cached_texture->reset_hashed();
+							cached_texture->protect(utils::protection::ro);
+						}
+
 						if (cached_texture->get_image_type() == rsx::texture_dimension_extended::texture_dimension_1d)
 							scale_y = 0.f;
 
 						if (cached_texture->get_sampler_status() != rsx::texture_sampler_status::status_ready)
 							set_up_remap_vector(*cached_texture, tex.decoded_remap());
 
+						cached_texture->last_use_frame = m_frame_index;
+
+						perf::rsx_texture_cache_hits.add();
 						return{ cached_texture->get_raw_view(), cached_texture->get_context(), cached_texture->is_depth_texture(), scale_x, scale_y, cached_texture->get_image_type() };
 					}
 				}
@@ -1902,6 +2175,7 @@ namespace rsx
 									if (surface->get_sampler_status() != rsx::texture_sampler_status::status_ready)
 										set_up_remap_vector(*surface, tex.decoded_remap());
 
+									perf::rsx_texture_cache_hits.add();
 									auto src_image = surface->get_raw_texture();
 									return{ src_image, deferred_request_command::copy_image_static, surface->get_section_base(), format, offset_x, offset_y, tex_width, tex_height, 1,
 										texture_upload_context::blit_engine_dst, surface->is_depth_texture(), scale_x, scale_y, rsx::texture_dimension_extended::texture_dimension_2d,
@@ -1914,6 +2188,7 @@ namespace rsx
 			}
 
 			//Do direct upload from CPU as the last resort
+			perf::rsx_texture_cache_misses.add();
 			writer_lock lock(m_cache_mutex);
 			const bool is_swizzled = !(tex.format() & CELL_GCM_TEXTURE_LN);
 			auto subresources_layout = get_subresources_layout(tex);
@@ -1931,13 +2206,27 @@ namespace rsx
 			}
 
 			//Invalidate with writing=false, discard=false, rebuild=false, native_flush=true
-			invalidate_range_impl_base(texaddr, tex_size, false, false, false, true, std::forward<Args>(extras)...);
+			//Protection must be settled before the upload reads guest memory
+			{
+				protection_batch_scope batch;
+				invalidate_range_impl_base(texaddr, tex_size, false, false, false, true, std::forward<Args>(extras)...);
+			}
 
 			//NOTE: SRGB correction is to be handled in the fragment shader; upload as linear RGB
 			m_texture_memory_in_use += (tex_pitch * tex_height);
-			return{ upload_image_from_cpu(cmd, texaddr, tex_width, tex_height, depth, tex.get_exact_mipmap_count(), tex_pitch, format,
-				texture_upload_context::shader_read, subresources_layout, extended_dimension, rsx::texture_colorspace::rgb_linear, is_swizzled, remap_vector)->get_raw_view(),
-				texture_upload_context::shader_read, is_depth_format, scale_x, scale_y, extended_dimension };
+			auto section = upload_image_from_cpu(cmd, texaddr, tex_width, tex_height, depth, tex.get_exact_mipmap_count(), tex_pitch, format,
+				texture_upload_context::shader_read, subresources_layout, extended_dimension, rsx::texture_colorspace::rgb_linear, is_swizzled, remap_vector);
+
+			if (should_hash_section(texaddr, section->get_section_size()))
+			{
+				//Frequently rewritten; skip the access violations and validate the contents on bind instead
+				section->unprotect();
+				section->set_hashed();
+			}
+
+			section->last_use_frame = m_frame_index;
+
+			return{ section->get_raw_view(), texture_upload_context::shader_read, is_depth_format, scale_x, scale_y, extended_dimension };
 		}
 
 		template <typename surface_store_type, typename blitter_type, typename ...Args>
@@ -2013,7 +2302,9 @@ namespace rsx
 			}
 
 			//Always use GPU blit if src or dst is in the surface store
-			if (!g_cfg.video.use_gpu_texture_scaling && !(src_is_render_target || dst_is_render_target))
+			//Also stay on the GPU if the source is the unflushed result of an earlier GPU blit, a CPU blit would force a readback
+			if (!g_cfg.video.use_gpu_texture_scaling && !(src_is_render_target || dst_is_render_target) &&
+				!is_gpu_resident_blit_target(src_address, src.pitch * src.slice_h))
 				return false;
 
 			if (src_is_render_target)
@@ -2452,6 +2743,7 @@ namespace rsx
 				if (m_cache_update_tag.load(std::memory_order_consume) != m_flush_always_update_timestamp)
 				{
 					writer_lock lock(m_cache_mutex);
+					protection_batch_scope batch;
 					bool update_tag = false;
 
 					for (const auto &It : m_flush_always_cache)
@@ -2485,6 +2777,8 @@ namespace rsx
 			m_num_cache_misses.store(0u);
 			m_num_cache_mispredictions.store(0u);
 			m_num_cache_speculative_writes.store(0u);
+
+			m_texture_memory_gauge.set(m_texture_memory_in_use);
 		}
 
 		virtual const u32 get_unreleased_textures_count() const
@@ -2497,6 +2791,16 @@ namespace rsx
 			return m_texture_memory_in_use;
 		}
 
+		virtual u32 get_num_evicted_sections() const
+		{
+			return m_last_evicted_count;
+		}
+
+		virtual u64 get_num_evicted_bytes() const
+		{
+			return m_last_evicted_bytes;
+		}
+
 		virtual u32 get_num_flush_requests() const
 		{
 			return m_num_flush_requests;
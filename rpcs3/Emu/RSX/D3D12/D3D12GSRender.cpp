@@ -132,6 +132,19 @@ namespace
 
 		return root_signature_blob;
 	}
+
+	// Pipeline library blob, stored per title (the driver rejects libraries of another device or driver version)
+	std::string get_pipeline_library_path()
+	{
+		if (g_cfg.video.disable_on_disk_shader_cache || Emu.GetCachePath() == "")
+			return{};
+
+		const std::string directory_path = Emu.GetCachePath() + "/shaders_cache/pipelines/d3d12";
+		if (!fs::is_dir(directory_path))
+			fs::create_path(directory_path);
+
+		return directory_path + "/pipeline_library.bin";
+	}
 }
 
 D3D12GSRender::D3D12GSRender()
@@ -294,10 +307,18 @@ void D3D12GSRender::on_init_thread()
 		//Init must have failed
 		fmt::throw_exception("No D3D12 device was created");
 	}
+
+	const std::string pipeline_library_path = get_pipeline_library_path();
+	if (!pipeline_library_path.empty())
+		m_pipeline_library.load(m_device.Get(), pipeline_library_path);
 }
 
 void D3D12GSRender::on_exit()
 {
+	const std::string pipeline_library_path = get_pipeline_library_path();
+	if (!pipeline_library_path.empty())
+		m_pipeline_library.save(pipeline_library_path);
+
 	return GSRender::on_exit();
 }
 
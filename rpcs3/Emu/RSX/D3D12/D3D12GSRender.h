@@ -57,10 +57,10 @@ private:
 
 	ComPtr<ID3D12RootSignature> m_shared_root_signature;
 
-	// TODO: Use a tree structure to parse more efficiently
 	data_cache m_texture_cache;
 	bool invalidate_address(u32 addr);
 
+	d3d12_pipeline_library m_pipeline_library;
 	PipelineStateObjectCache m_pso_cache;
 	std::tuple<ComPtr<ID3D12PipelineState>, size_t, size_t> m_current_pso;
 
@@ -18,7 +18,9 @@ void data_cache::protect_data(u64 key, u32 start, size_t size)
 	static const u32 memory_page_size = 4096;
 	u32 protected_range_start = start & ~(memory_page_size - 1);
 	u32 protected_range_size = (u32)align(size, memory_page_size);
-	m_protected_ranges.push_back(std::make_tuple(key, protected_range_start, protected_range_size));
+	m_protected_ranges.emplace(protected_range_start, std::make_pair(key, protected_range_size));
+	m_max_protected_range_size = std::max(m_max_protected_range_size, protected_range_size);
+	vm::set_page_owner(protected_range_start, protected_range_size, vm::page_owner::rsx_texture_cache);
 	utils::memory_protect(vm::base(protected_range_start), protected_range_size, utils::protection::ro);
 }
 
@@ -27,22 +29,30 @@ bool data_cache::invalidate_address(u32 addr)
 	// In case 2 threads write to texture memory
 	std::lock_guard<shared_mutex> lock(m_mut);
 	bool handled = false;
-	auto It = m_protected_ranges.begin(), E = m_protected_ranges.end();
+	// Only ranges starting in [addr - max size, addr] can contain addr
+	const u32 first = addr > m_max_protected_range_size ? addr - m_max_protected_range_size : 0;
+	auto It = m_protected_ranges.lower_bound(first), E = m_protected_ranges.upper_bound(addr);
 	for (; It != E;)
 	{
-		auto currentIt = It;
-		++It;
-		auto protectedTexture = *currentIt;
-		u32 protectedRangeStart = std::get<1>(protectedTexture), protectedRangeSize = std::get<2>(protectedTexture);
-		if (addr >= protectedRangeStart && addr <= protectedRangeSize + protectedRangeStart)
+		u32 protectedRangeStart = It->first, protectedRangeSize = It->second.second;
+		if (addr <= protectedRangeSize + protectedRangeStart)
 		{
-			u64 texadrr = std::get<0>(protectedTexture);
+			u64 texadrr = It->second.first;
 			m_address_to_data[texadrr].first.m_is_dirty = true;
 
 			utils::memory_protect(vm::base(protectedRangeStart), protectedRangeSize, utils::protection::rw);
-			m_protected_ranges.erase(currentIt);
+			It = m_protected_ranges.erase(It);
 			handled = true;
 		}
+		else
+		{
+			++It;
+		}
+	}
+
+	if (m_protected_ranges.empty())
+	{
+		m_max_protected_range_size = 0;
 	}
 	return handled;
 }
@@ -61,7 +71,7 @@ void data_cache::unprotect_all()
 	std::lock_guard<shared_mutex> lock(m_mut);
 	for (auto &protectedTexture : m_protected_ranges)
 	{
-		u32 protectedRangeStart = std::get<1>(protectedTexture), protectedRangeSize = std::get<2>(protectedTexture);
+		u32 protectedRangeStart = protectedTexture.first, protectedRangeSize = protectedTexture.second.second;
 		utils::memory_protect(vm::base(protectedRangeStart), protectedRangeSize, utils::protection::rw);
 	}
 }
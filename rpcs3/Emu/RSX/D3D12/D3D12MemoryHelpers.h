@@ -3,6 +3,7 @@
 #include "d3dx12.h"
 #include "../Common/ring_buffer_helper.h"
 #include <list>
+#include <map>
 #include <mutex>
 
 struct d3d12_data_heap : public data_heap
@@ -101,7 +102,8 @@ private:
 	shared_mutex m_mut;
 
 	std::unordered_map<u64, std::pair<texture_entry, ComPtr<ID3D12Resource>> > m_address_to_data; // Storage
-	std::list <std::tuple<u64, u32, u32> > m_protected_ranges; // address, start of protected range, size of protected range
+	std::multimap<u32, std::pair<u64, u32> > m_protected_ranges; // start of protected range -> address, size of protected range
+	u32 m_max_protected_range_size = 0; // Ranges containing an address start at most this far below it
 public:
 	data_cache() = default;
 	~data_cache() = default;
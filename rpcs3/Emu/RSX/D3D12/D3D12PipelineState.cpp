@@ -309,10 +309,86 @@ void D3D12GSRender::load_program()
 		}
 	}
 
-	m_current_pso = m_pso_cache.getGraphicPipelineState(current_vertex_program, current_fragment_program, prop, m_device.Get(), m_shared_root_signature.Get());
+	m_current_pso = m_pso_cache.getGraphicPipelineState(current_vertex_program, current_fragment_program, prop, m_device.Get(), m_shared_root_signature.Get(), &m_pipeline_library);
 	return;
 }
 
+void d3d12_pipeline_library::load(ID3D12Device *device, const std::string &path)
+{
+	ComPtr<ID3D12Device1> device1;
+	if (FAILED(device->QueryInterface(IID_PPV_ARGS(device1.GetAddressOf()))))
+	{
+		LOG_NOTICE(RSX, "ID3D12PipelineLibrary is not supported, pipelines are not kept across runs");
+		return;
+	}
+
+	if (fs::file f{ path })
+	{
+		m_blob = f.to_vector<u8>();
+	}
+
+	if (!m_blob.empty())
+	{
+		if (SUCCEEDED(device1->CreatePipelineLibrary(m_blob.data(), m_blob.size(), IID_PPV_ARGS(m_library.GetAddressOf()))))
+		{
+			return;
+		}
+
+		LOG_WARNING(RSX, "Discarding pipeline library '%s' created by a different device or driver", path);
+		m_blob.clear();
+	}
+
+	if (FAILED(device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(m_library.GetAddressOf()))))
+	{
+		LOG_WARNING(RSX, "Failed to create a pipeline library, pipelines are not kept across runs");
+	}
+}
+
+void d3d12_pipeline_library::save(const std::string &path)
+{
+	if (!m_library || !m_dirty)
+		return;
+
+	std::vector<u8> data(m_library->GetSerializedSize());
+	if (FAILED(m_library->Serialize(data.data(), data.size())))
+	{
+		LOG_ERROR(RSX, "Failed to serialize the pipeline library");
+		return;
+	}
+
+	fs::file(path, fs::rewrite).write(data.data(), data.size());
+	m_dirty = false;
+}
+
+ComPtr<ID3D12PipelineState> d3d12_pipeline_library::create_graphics_pipeline(ID3D12Device *device, const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc, const D3D12PipelineProperties &properties)
+{
+	ComPtr<ID3D12PipelineState> pso;
+
+	if (!m_library)
+	{
+		CHECK_HRESULT(device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(pso.GetAddressOf())));
+		return pso;
+	}
+
+	u64 hash = rpcs3::hash64(desc.VS.pShaderBytecode, desc.VS.BytecodeLength);
+	hash = rpcs3::hash64(desc.PS.pShaderBytecode, desc.PS.BytecodeLength, hash);
+	hash = rpcs3::hash64(&properties, sizeof(properties), hash);
+
+	const std::string name = fmt::format("PSO_%016llx", hash);
+	const std::wstring wide_name(name.begin(), name.end());
+
+	// Fails if the pipeline isn't stored, or if the stored one was created from another description
+	if (SUCCEEDED(m_library->LoadGraphicsPipeline(wide_name.c_str(), &desc, IID_PPV_ARGS(pso.GetAddressOf()))))
+		return pso;
+
+	CHECK_HRESULT(device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(pso.ReleaseAndGetAddressOf())));
+
+	if (SUCCEEDED(m_library->StorePipeline(wide_name.c_str(), pso.Get())))
+		m_dirty = true;
+
+	return pso;
+}
+
 std::pair<std::string, std::string> D3D12GSRender::get_programs() const
 {
 	return std::make_pair(m_pso_cache.get_transform_program(current_vertex_program).content, m_pso_cache.get_shader_program(current_fragment_program).content);
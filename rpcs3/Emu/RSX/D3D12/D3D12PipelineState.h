@@ -89,6 +89,24 @@ public:
 	void Compile(const std::string &code, enum class SHADER_TYPE st);
 };
 
+/**
+* Pipelines compiled by the driver, kept across runs in an ID3D12PipelineLibrary (requires ID3D12Device1).
+* Entries are named from the hash of shaders and properties, program ids depend on the order programs are met in.
+*/
+class d3d12_pipeline_library
+{
+	std::vector<u8> m_blob; // Referenced by m_library during its lifetime
+	ComPtr<ID3D12PipelineLibrary> m_library;
+	bool m_dirty = false;
+
+public:
+	void load(ID3D12Device *device, const std::string &path);
+	void save(const std::string &path);
+
+	// Load the pipeline from the library, or create it and add it to the library
+	ComPtr<ID3D12PipelineState> create_graphics_pipeline(ID3D12Device *device, const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc, const D3D12PipelineProperties &properties);
+};
+
 static
 bool has_attribute(size_t attribute, const std::vector<D3D12_INPUT_ELEMENT_DESC> &desc)
 {
@@ -153,7 +171,7 @@ struct D3D12Traits
 	static
 	pipeline_storage_type build_pipeline(
 		const vertex_program_type &vertexProgramData, const fragment_program_type &fragmentProgramData, const pipeline_properties &pipelineProperties,
-		ID3D12Device *device, ID3D12RootSignature* root_signatures)
+		ID3D12Device *device, ID3D12RootSignature* root_signatures, d3d12_pipeline_library *library)
 	{
 		std::tuple<ID3D12PipelineState *, std::vector<size_t>, size_t> result = {};
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicPipelineStateDesc = {};
@@ -186,8 +204,7 @@ struct D3D12Traits
 
 		graphicPipelineStateDesc.IBStripCutValue = pipelineProperties.CutValue;
 
-		ComPtr<ID3D12PipelineState> pso;
-		CHECK_HRESULT(device->CreateGraphicsPipelineState(&graphicPipelineStateDesc, IID_PPV_ARGS(pso.GetAddressOf())));
+		ComPtr<ID3D12PipelineState> pso = library->create_graphics_pipeline(device, graphicPipelineStateDesc, pipelineProperties);
 
 		std::wstring name = L"PSO_" + std::to_wstring(vertexProgramData.id) + L"_" + std::to_wstring(fragmentProgramData.id);
 		pso->SetName(name.c_str());
@@ -12,6 +12,34 @@
 using namespace Microsoft::WRL;
 extern ID3D12Device* g_d3d12_device;
 
+// Interfaces added to D3D12 after the bundled headers, declared as in newer SDKs (which take precedence)
+#ifndef __ID3D12PipelineLibrary_INTERFACE_DEFINED__
+#define __ID3D12PipelineLibrary_INTERFACE_DEFINED__
+MIDL_INTERFACE("c64226a8-9201-46af-b4cc-53fb9ff7414f")
+ID3D12PipelineLibrary : public ID3D12DeviceChild
+{
+public:
+	virtual HRESULT STDMETHODCALLTYPE StorePipeline(LPCWSTR pName, ID3D12PipelineState *pPipeline) = 0;
+	virtual HRESULT STDMETHODCALLTYPE LoadGraphicsPipeline(LPCWSTR pName, const D3D12_GRAPHICS_PIPELINE_STATE_DESC *pDesc, REFIID riid, void **ppPipelineState) = 0;
+	virtual HRESULT STDMETHODCALLTYPE LoadComputePipeline(LPCWSTR pName, const D3D12_COMPUTE_PIPELINE_STATE_DESC *pDesc, REFIID riid, void **ppPipelineState) = 0;
+	virtual SIZE_T STDMETHODCALLTYPE GetSerializedSize() = 0;
+	virtual HRESULT STDMETHODCALLTYPE Serialize(void *pData, SIZE_T DataSizeInBytes) = 0;
+};
+#endif
+
+#ifndef __ID3D12Device1_INTERFACE_DEFINED__
+#define __ID3D12Device1_INTERFACE_DEFINED__
+MIDL_INTERFACE("77acce80-638e-4e65-8895-c1f23386863e")
+ID3D12Device1 : public ID3D12Device
+{
+public:
+	virtual HRESULT STDMETHODCALLTYPE CreatePipelineLibrary(const void *pLibraryBlob, SIZE_T BlobLength, REFIID riid, void **ppPipelineLibrary) = 0;
+	// Unused, enum and structure parameters are passed as their underlying types
+	virtual HRESULT STDMETHODCALLTYPE SetEventOnMultipleFenceCompletion(ID3D12Fence *const *ppFences, const UINT64 *pFenceValues, UINT NumFences, UINT Flags, HANDLE hEvent) = 0;
+	virtual HRESULT STDMETHODCALLTYPE SetResidencyPriority(UINT NumObjects, ID3D12Pageable *const *ppObjects, const UINT *pPriorities) = 0;
+};
+#endif
+
 inline std::string get_hresult_message(HRESULT hr)
 {
 	if (hr == DXGI_ERROR_DEVICE_REMOVED)
@@ -5,6 +5,7 @@
 #include "GLFragmentProgram.h"
 #include "../Common/ProgramStateCache.h"
 #include "GLCommonDecompiler.h"
+#include "GLHelpers.h"
 #include "../GCM.h"
 
 
@@ -374,6 +375,15 @@ void GLFragmentProgram::Compile()
 	glShaderSource(id, 1, &str, &strlen);
 	glCompileShader(id);
 
+	// Querying the status would wait for the driver's compiler threads, the program cache checks it if the link fails
+	if (!gl::get_driver_caps().KHR_parallel_shader_compile_supported)
+	{
+		validate();
+	}
+}
+
+bool GLFragmentProgram::validate() const
+{
 	GLint compileStatus = GL_FALSE;
 	glGetShaderiv(id, GL_COMPILE_STATUS, &compileStatus); // Determine the result of the glCompileShader call
 	if (compileStatus != GL_TRUE) // If the shader failed to compile...
@@ -394,7 +404,10 @@ void GLFragmentProgram::Compile()
 
 		LOG_NOTICE(RSX, "%s", shader); // Log the text of the shader that failed to compile
 		Emu.Pause(); // Pause the emulator, we can't really continue from here
+		return false;
 	}
+
+	return true;
 }
 
 void GLFragmentProgram::Delete()
@@ -57,6 +57,9 @@ public:
 	/** Compile the decompiled fragment shader into a format we can use with OpenGL. */
 	void Compile();
 
+	/** Logs the compiler errors and pauses the emulator if the shader failed to compile. */
+	bool validate() const;
+
 private:
 	/** Deletes the shader and any stored information */
 	void Delete();
@@ -6,6 +6,7 @@
 #include "../rsx_methods.h"
 #include "../Common/BufferUtils.h"
 #include "../rsx_utils.h"
+#include "Utilities/tracing.h"
 
 #define DUMP_VERTEX_DATA 0
 
@@ -29,7 +30,7 @@ GLGSRender::GLGSRender() : GSRender()
 	if (g_cfg.video.disable_vertex_cache)
 		m_vertex_cache.reset(new gl::null_vertex_cache());
 	else
-		m_vertex_cache.reset(new gl::weak_vertex_cache());
+		m_vertex_cache.reset(new gl::weak_vertex_cache(256 * 0x100000 / 4));
 
 	supports_multidraw = true;
 	supports_native_ui = (bool)g_cfg.misc.use_native_interface;
@@ -37,6 +38,13 @@ GLGSRender::GLGSRender() : GSRender()
 
 extern CellGcmContextData current_context;
 
+rsx::binary_cache& gl::get_program_binary_cache()
+{
+	// Bump the version when the program setup before linking changes
+	static rsx::binary_cache s_cache("glprogram.pack", 0x4B4341504C4750ull /* "PGLPACK" */, 1);
+	return s_cache;
+}
+
 namespace
 {
 	GLenum comparison_op(rsx::comparison_function op)
@@ -366,6 +374,7 @@ void GLGSRender::end()
 
 		std::chrono::time_point<steady_clock> textures_end = steady_clock::now();
 		m_textures_upload_time += (u32)std::chrono::duration_cast<std::chrono::microseconds>(textures_end - textures_start).count();
+		add_frame_time(rsx::frame_timer::texture_upload, textures_end - textures_start);
 	}
 
 	std::chrono::time_point<steady_clock> program_start = steady_clock::now();
@@ -454,6 +463,7 @@ void GLGSRender::end()
 
 	std::chrono::time_point<steady_clock> textures_end = steady_clock::now();
 	m_textures_upload_time += (u32)std::chrono::duration_cast<std::chrono::microseconds>(textures_end - textures_start).count();
+	add_frame_time(rsx::frame_timer::texture_upload, textures_end - textures_start);
 
 	update_draw_state();
 
@@ -575,7 +585,6 @@ void GLGSRender::end()
 	m_index_ring_buffer->notify();
 	m_vertex_state_buffer->notify();
 	m_fragment_constants_buffer->notify();
-	m_transform_constants_buffer->notify();
 
 	std::chrono::time_point<steady_clock> draw_end = steady_clock::now();
 	m_draw_time += (u32)std::chrono::duration_cast<std::chrono::microseconds>(draw_end - draw_start).count();
@@ -653,6 +662,44 @@ void GLGSRender::on_init_thread()
 		LOG_WARNING(RSX, "Texture barriers are not supported by your GPU. Feedback loops will have undefined results.");
 	}
 
+	if (gl_caps.ARB_get_program_binary_supported)
+	{
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+		if (formats > 0)
+		{
+			// Binaries are only valid for the driver that produced them
+			gl::get_program_binary_cache().set_tag(rsx::binary_cache::get_key(fmt::format("%s|%s|%s",
+				(const char*)glGetString(GL_VENDOR), (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION)))[0]);
+		}
+		else
+		{
+			gl_caps.ARB_get_program_binary_supported = false;
+		}
+	}
+
+	if (gl_caps.KHR_parallel_shader_compile_supported && g_cfg.video.async_shader_compilation)
+	{
+		try
+		{
+			m_shader_interpreter.create();
+
+			// Let the driver pick the number of compiler threads
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		}
+		catch (const std::exception& e)
+		{
+			LOG_ERROR(RSX, "Failed to build the shader interpreter, shaders will be compiled synchronously: %s", e.what());
+			gl_caps.KHR_parallel_shader_compile_supported = false;
+		}
+	}
+	else
+	{
+		// Without the interpreter a draw would have to wait for the link anyway
+		gl_caps.KHR_parallel_shader_compile_supported = false;
+	}
+
 	//Use industry standard resource alignment values as defaults
 	m_uniform_buffer_offset_align = 256;
 	m_min_texbuffer_alignment = 256;
@@ -730,7 +777,6 @@ void GLGSRender::on_init_thread()
 		manually_flush_ring_buffers = true;
 
 		m_attrib_ring_buffer.reset(new gl::legacy_ring_buffer());
-		m_transform_constants_buffer.reset(new gl::legacy_ring_buffer());
 		m_fragment_constants_buffer.reset(new gl::legacy_ring_buffer());
 		m_vertex_state_buffer.reset(new gl::legacy_ring_buffer());
 		m_index_ring_buffer.reset(new gl::legacy_ring_buffer());
@@ -738,7 +784,6 @@ void GLGSRender::on_init_thread()
 	else
 	{
 		m_attrib_ring_buffer.reset(new gl::ring_buffer());
-		m_transform_constants_buffer.reset(new gl::ring_buffer());
 		m_fragment_constants_buffer.reset(new gl::ring_buffer());
 		m_vertex_state_buffer.reset(new gl::ring_buffer());
 		m_index_ring_buffer.reset(new gl::ring_buffer());
@@ -746,10 +791,13 @@ void GLGSRender::on_init_thread()
 
 	m_attrib_ring_buffer->create(gl::buffer::target::texture, 256 * 0x100000);
 	m_index_ring_buffer->create(gl::buffer::target::element_array, 64 * 0x100000);
-	m_transform_constants_buffer->create(gl::buffer::target::uniform, 64 * 0x100000);
 	m_fragment_constants_buffer->create(gl::buffer::target::uniform, 16 * 0x100000);
 	m_vertex_state_buffer->create(gl::buffer::target::uniform, 16 * 0x100000);
 
+	// Not a ring: constants are updated in place by range, the driver orders the update against pending draws
+	m_transform_constants_buffer.reset(new gl::buffer());
+	m_transform_constants_buffer->create(gl::buffer::target::uniform, 8192, nullptr, GL_DYNAMIC_DRAW);
+
 	if (gl_caps.vendor_AMD)
 	{
 		m_identity_index_buffer.reset(new gl::buffer);
@@ -893,6 +941,7 @@ void GLGSRender::on_exit()
 	zcull_ctrl.release();
 
 	m_prog_buffer.clear();
+	m_shader_interpreter.destroy();
 
 	if (draw_fbo)
 	{
@@ -1096,21 +1145,51 @@ bool GLGSRender::check_program_state()
 
 void GLGSRender::load_program(const gl::vertex_upload_info& upload_info)
 {
-	if (m_graphics_state & rsx::pipeline_state::invalidate_pipeline_bits)
+	const bool update_pipeline = !!(m_graphics_state & rsx::pipeline_state::invalidate_pipeline_bits);
+
+	// While interpreting, keep polling the link of the current pipeline
+	if (update_pipeline || m_interpreter_in_use)
 	{
-		get_current_fragment_program(fs_sampler_state);
-		verify(HERE), current_fragment_program.valid;
+		if (update_pipeline)
+		{
+			get_current_fragment_program(fs_sampler_state);
+			verify(HERE), current_fragment_program.valid;
+
+			get_current_vertex_program();
 
-		get_current_vertex_program();
+			current_vertex_program.skip_vertex_input_check = true;	//not needed for us since decoding is done server side
+			current_fragment_program.unnormalized_coords = 0; //unused
+		}
 
-		current_vertex_program.skip_vertex_input_check = true;	//not needed for us since decoding is done server side
-		current_fragment_program.unnormalized_coords = 0; //unused
 		void* pipeline_properties = nullptr;
 
-		m_program = &m_prog_buffer.getGraphicPipelineState(current_vertex_program, current_fragment_program, pipeline_properties);
+		if (gl::get_driver_caps().KHR_parallel_shader_compile_supported)
+		{
+			// Programs too long for the interpreter have to wait for their link
+			const bool can_interpret = current_fp_metadata.program_ucode_length <= gl::shader_interpreter::max_fragment_ucode_length;
+
+			m_program = m_prog_buffer.get_graphic_pipeline_state_deferred(current_vertex_program, current_fragment_program, pipeline_properties, !can_interpret);
+			m_interpreter_in_use = false;
+
+			if (!m_program)
+			{
+				m_program = m_shader_interpreter.get(current_fragment_program, current_fp_metadata.referenced_textures_mask);
+				m_interpreter_in_use = (m_program != nullptr);
+			}
+
+			if (!m_program)
+			{
+				m_program = m_prog_buffer.get_graphic_pipeline_state_deferred(current_vertex_program, current_fragment_program, pipeline_properties, true);
+			}
+		}
+		else
+		{
+			m_program = &m_prog_buffer.getGraphicPipelineState(current_vertex_program, current_fragment_program, pipeline_properties);
+		}
+
 		m_program->use();
 
-		if (m_prog_buffer.check_cache_missed())
+		if (update_pipeline && m_prog_buffer.check_cache_missed())
 		{
 			m_shaders_cache->store(pipeline_properties, current_vertex_program, current_fragment_program);
 
@@ -1136,18 +1215,28 @@ void GLGSRender::load_program(const gl::vertex_upload_info& upload_info)
 
 	u8 *buf;
 	u32 vertex_state_offset;
-	u32 vertex_constants_offset;
 	u32 fragment_constants_offset;
+	u32 vertex_program_offset = 0;
+	u32 fragment_program_offset = 0;
 
-	const u32 fragment_constants_size = (const u32)m_prog_buffer.get_fragment_constants_buffer_size(current_fragment_program);
+	// The interpreter reads the constants from the ucode
+	const u32 fragment_constants_size = m_interpreter_in_use ? 0 : (const u32)m_prog_buffer.get_fragment_constants_buffer_size(current_fragment_program);
 	const u32 fragment_buffer_size = fragment_constants_size + (18 * 4 * sizeof(float));
 	const bool update_transform_constants = !!(m_graphics_state & rsx::pipeline_state::transform_constants_dirty);
 
 	if (manually_flush_ring_buffers)
 	{
-		m_vertex_state_buffer->reserve_storage_on_heap(512);
-		m_fragment_constants_buffer->reserve_storage_on_heap(align(fragment_buffer_size, 256));
-		if (update_transform_constants) m_transform_constants_buffer->reserve_storage_on_heap(8192);
+		u32 vertex_reserve = 512;
+		u32 fragment_reserve = align(fragment_buffer_size, 256);
+
+		if (m_interpreter_in_use)
+		{
+			vertex_reserve += align<u32>(gl::shader_interpreter::vertex_program_block_size, 256);
+			fragment_reserve += gl::shader_interpreter::fragment_program_block_size;
+		}
+
+		m_vertex_state_buffer->reserve_storage_on_heap(vertex_reserve);
+		m_fragment_constants_buffer->reserve_storage_on_heap(fragment_reserve);
 	}
 
 	// Vertex state
@@ -1165,11 +1254,26 @@ void GLGSRender::load_program(const gl::vertex_upload_info& upload_info)
 
 	if (update_transform_constants)
 	{
-		// Vertex constants
-		mapping = m_transform_constants_buffer->alloc_from_heap(8192, m_uniform_buffer_offset_align);
-		buf = static_cast<u8*>(mapping.first);
-		vertex_constants_offset = mapping.second;
-		fill_vertex_program_constants_data(buf);
+		// Vertex constants, only the registers written since the last upload
+		const u32 begin = m_transform_constants_dirty_begin;
+		const u32 end = std::min(m_transform_constants_dirty_end, 468u);
+
+		if (begin < end)
+		{
+			if ((end - begin) * 4 >= 468)
+			{
+				// Large update, orphan the storage instead of waiting for it
+				m_transform_constants_buffer->data(8192, rsx::method_registers.transform_constants.data(), GL_DYNAMIC_DRAW);
+			}
+			else
+			{
+				m_transform_constants_buffer->sub_data(begin * 16, (end - begin) * 16, rsx::method_registers.transform_constants[begin]);
+			}
+		}
+
+		m_transform_constants_dirty_begin = 468;
+		m_transform_constants_dirty_end = 0;
+		m_graphics_state &= ~rsx::pipeline_state::transform_constants_dirty;
 	}
 
 	// Fragment constants
@@ -1185,17 +1289,36 @@ void GLGSRender::load_program(const gl::vertex_upload_info& upload_info)
 	// Fragment state
 	fill_fragment_state_buffer(buf + fragment_constants_size, current_fragment_program);
 
+	if (m_interpreter_in_use)
+	{
+		// Programs run by the interpreter
+		mapping = m_vertex_state_buffer->alloc_from_heap(gl::shader_interpreter::vertex_program_block_size, m_uniform_buffer_offset_align);
+		vertex_program_offset = mapping.second;
+		gl::shader_interpreter::fill_vertex_program_block(mapping.first, current_vertex_program);
+
+		const u32 ucode_length = current_fp_metadata.program_ucode_length;
+		mapping = m_fragment_constants_buffer->alloc_from_heap(gl::shader_interpreter::fragment_program_block_size, m_uniform_buffer_offset_align);
+		fragment_program_offset = mapping.second;
+		buf = static_cast<u8*>(mapping.first);
+		gl::shader_interpreter::fill_fragment_program_header(buf, current_fragment_program, ucode_length);
+		m_prog_buffer.fill_fragment_program_ucode(buf + 16, current_fragment_program, ucode_length, gl::get_driver_caps().vendor_NVIDIA);
+	}
+
 	m_vertex_state_buffer->bind_range(0, vertex_state_offset, 512);
 	m_fragment_constants_buffer->bind_range(2, fragment_constants_offset, fragment_buffer_size);
 
-	if (update_transform_constants) m_transform_constants_buffer->bind_range(1, vertex_constants_offset, 8192);
+	if (m_interpreter_in_use)
+	{
+		m_vertex_state_buffer->bind_range(gl::shader_interpreter::vertex_program_binding, vertex_program_offset, gl::shader_interpreter::vertex_program_block_size);
+		m_fragment_constants_buffer->bind_range(gl::shader_interpreter::fragment_program_binding, fragment_program_offset, gl::shader_interpreter::fragment_program_block_size);
+	}
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, 1, m_transform_constants_buffer->id());
 
 	if (manually_flush_ring_buffers)
 	{
 		m_vertex_state_buffer->unmap();
 		m_fragment_constants_buffer->unmap();
-
-		if (update_transform_constants) m_transform_constants_buffer->unmap();
 	}
 
 	m_graphics_state &= ~rsx::pipeline_state::memory_barrier_bits;
@@ -1521,8 +1644,11 @@ void GLGSRender::flip(int buffer)
 		const auto num_speculate = m_gl_texture_cache.get_num_cache_speculative_writes();
 		const auto cache_miss_ratio = (u32)ceil(m_gl_texture_cache.get_cache_miss_ratio() * 100);
 		m_text_printer.print_text(0, 126, m_frame->client_width(), m_frame->client_height(), "Unreleased textures: " + std::to_string(num_dirty_textures));
-		m_text_printer.print_text(0, 144, m_frame->client_width(), m_frame->client_height(), "Texture memory: " + std::to_string(texture_memory_size) + "M");
+		m_text_printer.print_text(0, 144, m_frame->client_width(), m_frame->client_height(), fmt::format("Texture memory: %lluM, %u eviction(s) (%lluM) last frame", (u64)texture_memory_size, m_gl_texture_cache.get_num_evicted_sections(), m_gl_texture_cache.get_num_evicted_bytes() / 0x100000));
 		m_text_printer.print_text(0, 162, m_frame->client_width(), m_frame->client_height(), fmt::format("Flush requests: %d (%d%% hard faults, %d misprediction(s), %d speculation(s))", num_flushes, cache_miss_ratio, num_mispredict, num_speculate));
+
+		const auto vertex_cache_stats = m_vertex_cache->get_stats();
+		m_text_printer.print_text(0, 180, m_frame->client_width(), m_frame->client_height(), fmt::format("Vertex cache: %u hit(s), %u miss(es), %u eviction(s), %llu KB cached", vertex_cache_stats.hits, vertex_cache_stats.misses, vertex_cache_stats.evictions, vertex_cache_stats.cached_bytes / 1024));
 	}
 
 	m_frame->flip(m_context);
@@ -1531,9 +1657,21 @@ void GLGSRender::flip(int buffer)
 	// Cleanup
 	m_gl_texture_cache.on_frame_end();
 
+	if (m_gl_texture_cache.get_num_evicted_sections())
+	{
+		//Cached sampler states may reference evicted textures
+		m_samplers_dirty.store(true);
+	}
+
 	m_rtts.free_invalidated();
 	m_vertex_cache->purge();
 
+	//Fence this frame's data in the ring buffers, waits if the GPU is too many frames behind
+	m_attrib_ring_buffer->notify_frame();
+	m_index_ring_buffer->notify_frame();
+	m_vertex_state_buffer->notify_frame();
+	m_fragment_constants_buffer->notify_frame();
+
 	//If we are skipping the next frame, do not reset perf counters
 	if (skip_frame) return;
 
@@ -1546,6 +1684,9 @@ void GLGSRender::flip(int buffer)
 
 bool GLGSRender::on_access_violation(u32 address, bool is_writing)
 {
+	tracing::scope trace(tracing::category::rsx, "flush");
+	trace.set_arg("address", address);
+
 	bool can_flush = (std::this_thread::get_id() == m_thread_id);
 	auto result = m_gl_texture_cache.invalidate_address(address, is_writing, can_flush);
 
@@ -1638,6 +1779,7 @@ work_item& GLGSRender::post_flush_request(u32 address, gl::texture_cache::thrash
 	work_item &result = work_queue.back();
 	result.address_to_flush = address;
 	result.section_data = std::move(flush_data);
+	fifo_wake();
 	return result;
 }
 
@@ -7,6 +7,7 @@
 #include "restore_new.h"
 #include "define_new_memleakdetect.h"
 #include "GLProgramBuffer.h"
+#include "GLShaderInterpreter.h"
 #include "GLTextOut.h"
 #include "GLOverlays.h"
 #include "../rsx_utils.h"
@@ -294,7 +295,7 @@ private:
 
 	std::unique_ptr<gl::ring_buffer> m_attrib_ring_buffer;
 	std::unique_ptr<gl::ring_buffer> m_fragment_constants_buffer;
-	std::unique_ptr<gl::ring_buffer> m_transform_constants_buffer;
+	std::unique_ptr<gl::buffer> m_transform_constants_buffer;
 	std::unique_ptr<gl::ring_buffer> m_vertex_state_buffer;
 	std::unique_ptr<gl::ring_buffer> m_index_ring_buffer;
 
@@ -329,6 +330,10 @@ private:
 
 	GLProgramBuffer m_prog_buffer;
 
+	// Runs the programs whose pipeline is still linking (async shader compilation)
+	gl::shader_interpreter m_shader_interpreter;
+	bool m_interpreter_in_use = false;
+
 	//buffer
 	gl::fbo draw_fbo;
 	gl::fbo m_flip_fbo;
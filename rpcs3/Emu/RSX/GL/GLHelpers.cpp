@@ -60,6 +60,35 @@ namespace gl
 		return g_driver_caps;
 	}
 
+	bool get_video_memory_info(u64& available, u64& total)
+	{
+		const auto& caps = get_driver_caps();
+
+		if (caps.NVX_gpu_memory_info_supported)
+		{
+			GLint available_kb = 0, total_kb = 0;
+			glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available_kb);
+			glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &total_kb);
+
+			available = u64(available_kb) * 1024;
+			total = u64(total_kb) * 1024;
+			return true;
+		}
+
+		if (caps.ATI_meminfo_supported)
+		{
+			//Free memory of the pool, largest free block, auxiliary free memory and its largest block
+			GLint info[4] = {};
+			glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, info);
+
+			available = u64(info[0]) * 1024;
+			total = 0;
+			return true;
+		}
+
+		return false;
+	}
+
 	void fbo::create()
 	{
 		glGenFramebuffers(1, &m_id);
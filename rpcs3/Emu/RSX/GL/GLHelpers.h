@@ -7,6 +7,7 @@
 #include <memory>
 #include <unordered_map>
 #include <algorithm>
+#include <deque>
 
 #include "OpenGL.h"
 #include "../GCM.h"
@@ -65,6 +66,9 @@ namespace gl
 
 	void enable_debugging();
 	capabilities& get_driver_caps();
+
+	//Free video memory in bytes (GL_NVX_gpu_memory_info or GL_ATI_meminfo), total is 0 if the driver doesn't tell. Returns false without either extension
+	bool get_video_memory_info(u64& available, u64& total);
 	bool is_primitive_native(rsx::primitive_type in);
 	GLenum draw_mode(rsx::primitive_type in);
 
@@ -91,6 +95,10 @@ namespace gl
 		bool ARB_depth_buffer_float_supported = false;
 		bool ARB_texture_barrier_supported = false;
 		bool NV_texture_barrier_supported = false;
+		bool ARB_get_program_binary_supported = false;
+		bool KHR_parallel_shader_compile_supported = false;
+		bool NVX_gpu_memory_info_supported = false;
+		bool ATI_meminfo_supported = false;
 		bool initialized = false;
 		bool vendor_INTEL = false;  //has broken GLSL compiler
 		bool vendor_AMD = false;    //has broken ARB_multidraw
@@ -99,7 +107,7 @@ namespace gl
 
 		void initialize()
 		{
-			int find_count = 8;
+			int find_count = 12;
 			int ext_count = 0;
 			glGetIntegerv(GL_NUM_EXTENSIONS, &ext_count);
 
@@ -165,6 +173,34 @@ namespace gl
 					find_count--;
 					continue;
 				}
+
+				if (ext_name == "GL_ARB_get_program_binary")
+				{
+					ARB_get_program_binary_supported = true;
+					find_count--;
+					continue;
+				}
+
+				if (ext_name == "GL_KHR_parallel_shader_compile")
+				{
+					KHR_parallel_shader_compile_supported = true;
+					find_count--;
+					continue;
+				}
+
+				if (ext_name == "GL_NVX_gpu_memory_info")
+				{
+					NVX_gpu_memory_info_supported = true;
+					find_count--;
+					continue;
+				}
+
+				if (ext_name == "GL_ATI_meminfo")
+				{
+					ATI_meminfo_supported = true;
+					find_count--;
+					continue;
+				}
 			}
 
 			//Workaround for intel drivers which have terrible capability reporting
@@ -863,10 +899,90 @@ namespace gl
 	{
 	protected:
 
+		//Frames the CPU may run ahead of the GPU before waiting on the oldest frame
+		static constexpr u32 max_frames_in_flight = 3;
+
+		struct fenced_range
+		{
+			fence sync;
+			u64 put_pos;
+			bool frame_end;
+		};
+
 		u32 m_data_loc = 0;
 		void *m_memory_mapping = nullptr;
 
-		fence m_fence;
+		//Positions are monotonic byte counts; everything between m_get_pos and m_put_pos may still be read by the GPU
+		u64 m_put_pos = 0;
+		u64 m_get_pos = 0;
+		u64 m_last_fence_pos = 0;
+		std::deque<fenced_range> m_fences;
+		u32 m_pending_frames = 0;
+
+		void push_fence(bool frame_end)
+		{
+			fenced_range range;
+			range.sync.create();
+			range.put_pos = m_put_pos;
+			range.frame_end = frame_end;
+
+			m_fences.push_back(range);
+			m_last_fence_pos = m_put_pos;
+
+			if (frame_end)
+				m_pending_frames++;
+		}
+
+		void retire_oldest_fence(bool wait)
+		{
+			auto &range = m_fences.front();
+
+			if (wait)
+				range.sync.wait_for_signal();
+			else
+				range.sync.destroy();
+
+			m_get_pos = range.put_pos;
+
+			if (range.frame_end)
+				m_pending_frames--;
+
+			m_fences.pop_front();
+		}
+
+		void retire_signaled_fences()
+		{
+			while (!m_fences.empty() && m_fences.front().sync.check_signaled())
+				retire_oldest_fence(false);
+		}
+
+		void wait_for_space(u64 required_put_pos)
+		{
+			if ((required_put_pos - m_get_pos) <= m_size)
+				return;
+
+			retire_signaled_fences();
+
+			while ((required_put_pos - m_get_pos) > m_size)
+			{
+				if (m_fences.empty())
+				{
+					//Everything in the buffer was written after the last fence, this should only happen with very large draws
+					LOG_WARNING(RSX, "Ring buffer exhausted without a pending fence, stalling");
+					push_fence(false);
+				}
+
+				retire_oldest_fence(true);
+			}
+		}
+
+		void release_fences()
+		{
+			while (!m_fences.empty())
+				retire_oldest_fence(true);
+
+			m_put_pos = m_get_pos = m_last_fence_pos = 0;
+		}
 
 	public:
 
@@ -874,7 +990,7 @@ namespace gl
 		{
 			if (m_id)
 			{
-				m_fence.wait_for_signal();
+				release_fences();
 				remove();
 			}
 
@@ -903,24 +1019,23 @@ namespace gl
 			u32 offset = m_data_loc;
 			if (m_data_loc) offset = align(offset, alignment);
 
+			//Align data loc to 256; allows some "guard" region so we dont trample our own data inadvertently
+			u32 next_loc = align(offset + alloc_size, 256);
+			u64 skipped = offset - m_data_loc;
+
 			if ((offset + alloc_size) > m_size)
 			{
-				if (!m_fence.is_empty())
-				{
-					m_fence.wait_for_signal();
-				}
-				else
-				{
-					LOG_ERROR(RSX, "OOM Error: Ring buffer was likely being used without notify() being called");
-					glFinish();
-				}
-
-				m_data_loc = 0;
+				//Wrap around, the tail of the buffer is left unused
+				skipped = m_size - m_data_loc;
 				offset = 0;
+				next_loc = align(alloc_size, 256);
 			}
 
-			//Align data loc to 256; allows some "guard" region so we dont trample our own data inadvertently
-			m_data_loc = align(offset + alloc_size, 256);
+			const u64 new_put_pos = m_put_pos + skipped + (next_loc - offset);
+			wait_for_space(new_put_pos);
+
+			m_put_pos = new_put_pos;
+			m_data_loc = next_loc;
 			return std::make_pair(((char*)m_memory_mapping) + offset, offset);
 		}
 
@@ -936,6 +1051,13 @@ namespace gl
 				m_size = 0;
 			}
 
+			for (auto &range : m_fences)
+				range.sync.destroy();
+
+			m_fences.clear();
+			m_pending_frames = 0;
+			m_put_pos = m_get_pos = m_last_fence_pos = 0;
+
 			glDeleteBuffers(1, &m_id);
 			m_id = 0;
 		}
@@ -952,9 +1074,22 @@ namespace gl
 		//Notification of a draw command
 		virtual void notify()
 		{
-			//Insert fence about 25% into the buffer
-			if (m_fence.is_empty() && (m_data_loc > (m_size >> 2)))
-				m_fence.reset();
+			//Fence every eighth of the buffer so a wrap never has to wait for the whole frame to drain
+			if ((m_put_pos - m_last_fence_pos) > (m_size >> 3))
+				push_fence(false);
+		}
+
+		//Notification of the end of a frame
+		virtual void notify_frame()
+		{
+			if (m_put_pos != m_last_fence_pos)
+				push_fence(true);
+
+			retire_signaled_fences();
+
+			//Keep at most max_frames_in_flight frames of data in the buffer
+			while (m_pending_frames > max_frames_in_flight)
+				retire_oldest_fence(true);
 		}
 	};
 
@@ -1069,6 +1204,7 @@ namespace gl
 		}
 
 		void notify() override {}
+		void notify_frame() override {}
 	};
 
 	class buffer_view
@@ -2603,7 +2739,24 @@ namespace gl
 			void link()
 			{
 				glLinkProgram(m_id);
+				check_link_status();
+			}
+
+			// Queues the link, with KHR_parallel_shader_compile the driver finishes it on its own threads
+			void start_link()
+			{
+				glLinkProgram(m_id);
+			}
+
+			bool is_link_complete() const
+			{
+				GLint status = GL_FALSE;
+				glGetProgramiv(m_id, GL_COMPLETION_STATUS_KHR, &status);
+				return status != GL_FALSE;
+			}
 
+			void check_link_status()
+			{
 				GLint status = GL_FALSE;
 				glGetProgramiv(m_id, GL_LINK_STATUS, &status);
 
@@ -2653,6 +2806,51 @@ namespace gl
 				link();
 			}
 
+			// Must be set before linking for get_binary to be reliable
+			program& set_binary_retrievable()
+			{
+				glProgramParameteri(m_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+				return *this;
+			}
+
+			// Blob layout is the binary format followed by the driver data, as returned by get_binary()
+			std::vector<u8> get_binary() const
+			{
+				GLint length = 0;
+				glGetProgramiv(m_id, GL_PROGRAM_BINARY_LENGTH, &length);
+
+				if (length <= 0)
+				{
+					return{};
+				}
+
+				std::vector<u8> blob(sizeof(GLenum) + length);
+				GLenum format = 0;
+				GLsizei written = 0;
+				glGetProgramBinary(m_id, length, &written, &format, blob.data() + sizeof(GLenum));
+
+				blob.resize(sizeof(GLenum) + written);
+				std::memcpy(blob.data(), &format, sizeof(GLenum));
+				return blob;
+			}
+
+			// Links the program from a blob of get_binary(), fails if the driver no longer accepts it
+			bool load_binary(const std::vector<u8>& blob)
+			{
+				if (blob.size() <= sizeof(GLenum))
+				{
+					return false;
+				}
+
+				GLenum format;
+				std::memcpy(&format, blob.data(), sizeof(GLenum));
+				glProgramBinary(m_id, format, blob.data() + sizeof(GLenum), ::narrow<GLsizei>(blob.size() - sizeof(GLenum)));
+
+				GLint status = GL_FALSE;
+				glGetProgramiv(m_id, GL_LINK_STATUS, &status);
+				return status == GL_TRUE;
+			}
+
 			uint id() const
 			{
 				return m_id;
@@ -331,23 +331,44 @@ namespace gl
 		std::unordered_map<u64, std::unique_ptr<gl::texture_view>> temp_view_cache;
 		std::unordered_map<u64, std::unique_ptr<gl::texture>> font_cache;
 		std::unordered_map<u64, std::unique_ptr<gl::texture_view>> view_cache;
-		bool is_font_draw = false;
+
+		// Quads of each overlay, uploaded again only when its contents change
+		struct instance_data
+		{
+			std::vector<rsx::overlays::compiled_resource::quad_instance> instances;
+			std::vector<rsx::overlays::compiled_resource::draw_batch> batches;
+			gl::buffer buffer;
+		};
+
+		std::unordered_map<u32, instance_data> instance_cache;
+		const rsx::overlays::compiled_resource::draw_batch* current_batch = nullptr;
 
 		ui_overlay_renderer()
 		{
+			// One instance per quad, the corner is selected by the vertex index
 			vs_src =
 			{
 				"#version 420\n\n"
-				"layout(location=0) in vec4 in_pos;\n"
+				"layout(location=0) in vec4 in_corner0;\n"
+				"layout(location=1) in vec4 in_corner1;\n"
+				"layout(location=2) in vec4 in_corner2;\n"
+				"layout(location=3) in vec4 in_corner3;\n"
+				"layout(location=4) in vec4 in_color;\n"
+				"layout(location=5) in vec4 in_clip_bounds;\n"
+				"layout(location=6) in vec4 in_parameters;\n"
 				"layout(location=0) out vec2 tc0;\n"
 				"layout(location=1) out vec4 clip_rect;\n"
+				"layout(location=2) flat out vec4 color;\n"
+				"layout(location=3) flat out vec4 parameters;\n"
 				"uniform vec4 ui_scale;\n"
-				"uniform vec4 clip_bounds;\n"
 				"\n"
 				"void main()\n"
 				"{\n"
+				"	vec4 in_pos = (gl_VertexID == 0)? in_corner0 : (gl_VertexID == 1)? in_corner1 : (gl_VertexID == 2)? in_corner2 : in_corner3;\n"
 				"	tc0.xy = in_pos.zw;\n"
-				"	clip_rect = (clip_bounds * ui_scale.zwzw);\n"
+				"	color = in_color;\n"
+				"	parameters = in_parameters;\n"
+				"	clip_rect = (in_clip_bounds * ui_scale.zwzw);\n"
 				"	clip_rect.yw = ui_scale.yy - clip_rect.wy; //invert y axis\n"
 				"	vec4 pos = vec4((in_pos.xy * ui_scale.zw) / ui_scale.xy, 0., 1.);\n"
 				"	pos.y = (1. - pos.y); //invert y axis\n"
@@ -361,16 +382,14 @@ namespace gl
 				"layout(binding=31) uniform sampler2D fs0;\n"
 				"layout(location=0) in vec2 tc0;\n"
 				"layout(location=1) in vec4 clip_rect;\n"
+				"layout(location=2) flat in vec4 color;\n"
+				"layout(location=3) flat in vec4 parameters;\n"
 				"layout(location=0) out vec4 ocol;\n"
-				"uniform vec4 color;\n"
 				"uniform float time;\n"
-				"uniform int read_texture;\n"
-				"uniform int pulse_glow;\n"
-				"uniform int clip_region;\n"
 				"\n"
 				"void main()\n"
 				"{\n"
-				"	if (clip_region != 0)\n"
+				"	if (parameters.z != 0)\n"
 				"	{"
 				"		if (gl_FragCoord.x < clip_rect.x || gl_FragCoord.x > clip_rect.z ||\n"
 				"			gl_FragCoord.y < clip_rect.y || gl_FragCoord.y > clip_rect.w)\n"
@@ -381,10 +400,10 @@ namespace gl
 				"	}\n"
 				"\n"
 				"	vec4 diff_color = color;\n"
-				"	if (pulse_glow != 0)\n"
+				"	if (parameters.x != 0)\n"
 				"		diff_color.a *= (sin(time) + 1.f) * 0.5f;\n"
 				"\n"
-				"	if (read_texture != 0)\n"
+				"	if (parameters.y != 0)\n"
 				"		ocol = texture(fs0, tc0) * diff_color;\n"
 				"	else\n"
 				"		ocol = diff_color;\n"
@@ -436,11 +455,14 @@ namespace gl
 			temp_image_cache.clear();
 			resources.clear();
 			font_cache.clear();
+			instance_cache.clear();
 			overlay_pass::destroy();
 		}
 
 		void remove_temp_resources(u64 key)
 		{
+			instance_cache.erase((u32)key);
+
 			std::vector<u64> keys_to_remove;
 			for (auto It = temp_image_cache.begin(); It != temp_image_cache.end(); ++It)
 			{
@@ -494,81 +516,86 @@ namespace gl
 
 		void emit_geometry() override
 		{
-			if (!is_font_draw)
+			int old_vao;
+			glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &old_vao);
+
+			m_vao.bind();
+			glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, current_batch->instance_count, current_batch->first_instance);
+
+			glBindVertexArray(old_vao);
+		}
+
+		void run(u16 w, u16 h, GLuint target, rsx::overlays::overlay& ui)
+		{
+			using quad_instance = rsx::overlays::compiled_resource::quad_instance;
+
+			auto& cache = instance_cache[ui.uid];
+			std::vector<quad_instance> instances;
+			std::vector<rsx::overlays::compiled_resource::draw_batch> batches;
+			ui.get_compiled().build_batches(instances, batches);
+
+			if (!cache.buffer.created())
 			{
-				overlay_pass::emit_geometry();
+				cache.buffer.create();
 			}
-			else
-			{
-				int num_quads = num_drawable_elements / 4;
-				std::vector<GLint> firsts;
-				std::vector<GLsizei> counts;
 
-				firsts.resize(num_quads);
-				counts.resize(num_quads);
+			if (instances.size() != cache.instances.size() || std::memcmp(instances.data(), cache.instances.data(), instances.size() * sizeof(quad_instance)))
+			{
+				cache.buffer.data(instances.size() * sizeof(quad_instance), instances.data(), GL_STATIC_DRAW);
+				cache.instances = std::move(instances);
+			}
 
-				for (int n = 0; n < num_quads; ++n)
-				{
-					firsts[n] = (n * 4);
-					counts[n] = 4;
-				}
+			cache.batches = std::move(batches);
 
-				int old_vao;
-				glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &old_vao);
+			// Point the attributes at the overlay's buffer, one instance per quad
+			int old_vao;
+			glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &old_vao);
 
-				m_vao.bind();
-				glMultiDrawArrays(GL_TRIANGLE_STRIP, firsts.data(), counts.data(), num_quads);
+			m_vao.array_buffer = cache.buffer;
 
-				glBindVertexArray(old_vao);
+			for (u32 n = 0; n < 7; ++n)
+			{
+				auto ptr = buffer_pointer(&m_vao, n * 16, sizeof(quad_instance));
+				m_vao[n] = ptr;
+				glVertexAttribDivisor(n, 1);
 			}
-		}
 
-		void run(u16 w, u16 h, GLuint target, rsx::overlays::overlay& ui)
-		{
+			glBindVertexArray(old_vao);
+
 			program_handle.uniforms["ui_scale"] = color4f((f32)ui.virtual_width, (f32)ui.virtual_height, 1.f, 1.f);
 			program_handle.uniforms["time"] = (f32)(get_system_time() / 1000) * 0.005f;
-			for (auto &cmd : ui.get_compiled().draw_commands)
-			{
-				upload_vertex_data((f32*)cmd.verts.data(), (u32)cmd.verts.size() * 4u);
-				num_drawable_elements = (u32)cmd.verts.size();
-				is_font_draw = false;
-				GLint texture_exists = GL_TRUE;
 
+			for (const auto& batch : cache.batches)
+			{
 				glActiveTexture(GL_TEXTURE31);
-				switch (cmd.config.texture_ref)
+				switch (batch.config.texture_ref)
 				{
 				case rsx::overlays::image_resource_id::game_icon:
 				case rsx::overlays::image_resource_id::backbuffer:
 					//TODO
 				case rsx::overlays::image_resource_id::none:
 				{
-					texture_exists = GL_FALSE;
 					glBindTexture(GL_TEXTURE_2D, GL_NONE);
 					break;
 				}
 				case rsx::overlays::image_resource_id::raw_image:
 				{
-					glBindTexture(GL_TEXTURE_2D, find_temp_image((rsx::overlays::image_info*)cmd.config.external_data_ref, ui.uid)->id());
+					glBindTexture(GL_TEXTURE_2D, find_temp_image((rsx::overlays::image_info*)batch.config.external_data_ref, ui.uid)->id());
 					break;
 				}
 				case rsx::overlays::image_resource_id::font_file:
 				{
-					is_font_draw = true;
-					glBindTexture(GL_TEXTURE_2D, find_font(cmd.config.font_ref)->id());
+					glBindTexture(GL_TEXTURE_2D, find_font(batch.config.font_ref)->id());
 					break;
 				}
 				default:
 				{
-					glBindTexture(GL_TEXTURE_2D, view_cache[cmd.config.texture_ref - 1]->id());
+					glBindTexture(GL_TEXTURE_2D, view_cache[batch.config.texture_ref - 1]->id());
 					break;
 				}
 				}
 
-				program_handle.uniforms["color"] = cmd.config.color;
-				program_handle.uniforms["read_texture"] = texture_exists;
-				program_handle.uniforms["pulse_glow"] = (s32)cmd.config.pulse_glow;
-				program_handle.uniforms["clip_region"] = (s32)cmd.config.clip_region;
-				program_handle.uniforms["clip_bounds"] = cmd.config.clip_rect;
+				current_batch = &batch;
 				overlay_pass::run(w, h, target, false, true);
 			}
 
@@ -173,6 +173,8 @@ OPENGL_PROC(PFNGLBINDBUFFERBASEPROC, BindBufferBase);
 
 OPENGL_PROC(PFNGLMULTIDRAWELEMENTSPROC, MultiDrawElements);
 OPENGL_PROC(PFNGLMULTIDRAWARRAYSPROC, MultiDrawArrays);
+OPENGL_PROC(PFNGLDRAWARRAYSINSTANCEDBASEINSTANCEPROC, DrawArraysInstancedBaseInstance);
+OPENGL_PROC(PFNGLVERTEXATTRIBDIVISORPROC, VertexAttribDivisor);
 
 OPENGL_PROC(PFNGLGETTEXTUREIMAGEEXTPROC, GetTextureImageEXT);
 OPENGL_PROC(PFNGLGETTEXTUREIMAGEPROC, GetTextureImage);
@@ -224,6 +226,14 @@ OPENGL_PROC(PFNGLTEXSTORAGE1DPROC, TexStorage1D);
 OPENGL_PROC(PFNGLTEXSTORAGE2DPROC, TexStorage2D);
 OPENGL_PROC(PFNGLTEXSTORAGE3DPROC, TexStorage3D);
 
+//ARB_get_program_binary
+OPENGL_PROC(PFNGLGETPROGRAMBINARYPROC, GetProgramBinary);
+OPENGL_PROC(PFNGLPROGRAMBINARYPROC, ProgramBinary);
+OPENGL_PROC(PFNGLPROGRAMPARAMETERIPROC, ProgramParameteri);
+
+//KHR_parallel_shader_compile
+OPENGL_PROC(PFNGLMAXSHADERCOMPILERTHREADSKHRPROC, MaxShaderCompilerThreadsKHR);
+
 //Texture_View
 OPENGL_PROC(PFNGLTEXTUREVIEWPROC, TextureView);
 
@@ -2,6 +2,13 @@
 #include "GLVertexProgram.h"
 #include "GLFragmentProgram.h"
 #include "../Common/ProgramStateCache.h"
+#include "../rsx_cache.h"
+
+namespace gl
+{
+	// Linked program binaries keyed by their GLSL sources, tagged with the driver identity
+	rsx::binary_cache& get_program_binary_cache();
+}
 
 struct GLTraits
 {
@@ -30,17 +37,63 @@ struct GLTraits
 	}
 
 	static
-	pipeline_storage_type build_pipeline(const vertex_program_type &vertexProgramData, const fragment_program_type &fragmentProgramData, const pipeline_properties&)
+	std::array<u64, 2> get_binary_key(const vertex_program_type &vertexProgramData, const fragment_program_type &fragmentProgramData)
 	{
-		pipeline_storage_type result;
-		__glcheck result.create()
+		return rsx::binary_cache::get_key(vertexProgramData.shader + fragmentProgramData.shader);
+	}
+
+	// Relinking from source is what makes shaders cache boots slow, reuse the driver binary when it is still accepted
+	static
+	bool load_binary(pipeline_storage_type& result, const std::array<u64, 2>& key)
+	{
+		std::vector<u8> blob;
+
+		if (!gl::get_program_binary_cache().load(key, blob))
+		{
+			return false;
+		}
+
+		if (!result.load_binary(blob))
+		{
+			// Rejected binary, start over from a clean program object
+			result.recreate();
+			return false;
+		}
+
+		return true;
+	}
+
+	static
+	void store_binary(const pipeline_storage_type& result, const std::array<u64, 2>& key)
+	{
+		const std::vector<u8> blob = result.get_binary();
+
+		if (!blob.empty())
+		{
+			gl::get_program_binary_cache().store(key, blob.data(), ::size32(blob));
+		}
+	}
+
+	static
+	void attach_shaders(pipeline_storage_type& result, const vertex_program_type &vertexProgramData, const fragment_program_type &fragmentProgramData)
+	{
+		__glcheck result
 			.attach(gl::glsl::shader_view(vertexProgramData.id))
 			.attach(gl::glsl::shader_view(fragmentProgramData.id))
 			.bind_fragment_data_location("ocol0", 0)
 			.bind_fragment_data_location("ocol1", 1)
 			.bind_fragment_data_location("ocol2", 2)
-			.bind_fragment_data_location("ocol3", 3)
-			.make();
+			.bind_fragment_data_location("ocol3", 3);
+
+		if (gl::get_driver_caps().ARB_get_program_binary_supported)
+		{
+			result.set_binary_retrievable();
+		}
+	}
+
+	static
+	void initialize_program_uniforms(pipeline_storage_type& result)
+	{
 		__glcheck result.use();
 
 		//Progam locations are guaranteed to not change after linking
@@ -64,6 +117,41 @@ struct GLTraits
 		//Bind locations 0 and 1 to the stream buffers
 		result.uniforms[0] = stream_buffer_start;
 		result.uniforms[1] = stream_buffer_start + 1;
+	}
+
+	static
+	pipeline_storage_type build_pipeline(const vertex_program_type &vertexProgramData, const fragment_program_type &fragmentProgramData, const pipeline_properties&)
+	{
+		pipeline_storage_type result;
+		__glcheck result.create();
+
+		const bool use_binary = gl::get_driver_caps().ARB_get_program_binary_supported;
+		std::array<u64, 2> key{};
+
+		if (use_binary)
+		{
+			key = get_binary_key(vertexProgramData, fragmentProgramData);
+		}
+
+		if (!use_binary || !load_binary(result, key))
+		{
+			if (gl::get_driver_caps().KHR_parallel_shader_compile_supported)
+			{
+				// The compile status was not checked when the shaders were submitted
+				vertexProgramData.validate();
+				fragmentProgramData.validate();
+			}
+
+			attach_shaders(result, vertexProgramData, fragmentProgramData);
+			__glcheck result.make();
+
+			if (use_binary)
+			{
+				store_binary(result, key);
+			}
+		}
+
+		initialize_program_uniforms(result);
 
 		LOG_NOTICE(RSX, "*** prog id = %d", result.id());
 		LOG_NOTICE(RSX, "*** vp id = %d", vertexProgramData.id);
@@ -112,4 +200,102 @@ public:
 	{
 		return m_cache_miss_flag;
 	}
+
+	/**
+	 * Same lookup as getGraphicPipelineState, a missing pipeline is linked in the background (KHR_parallel_shader_compile)
+	 * Returns nullptr while the link is in progress unless wait is set
+	 */
+	gl::glsl::program* get_graphic_pipeline_state_deferred(const RSXVertexProgram& vertexShader, const RSXFragmentProgram& fragmentShader, void*& pipelineProperties, bool wait)
+	{
+		const auto &vp_search = search_vertex_program(vertexShader);
+		const auto &fp_search = search_fragment_program(fragmentShader);
+		const GLVertexProgram &vertex_program = std::get<0>(vp_search);
+		const GLFragmentProgram &fragment_program = std::get<0>(fp_search);
+
+		const pipeline_key key = { vertex_program.id, fragment_program.id, pipelineProperties };
+
+		const auto found = m_storage.find(key);
+		if (found != m_storage.end())
+		{
+			m_cache_miss_flag = false;
+			return &found->second;
+		}
+
+		const bool use_binary = gl::get_driver_caps().ARB_get_program_binary_supported;
+		std::array<u64, 2> binary_key{};
+
+		if (use_binary)
+		{
+			binary_key = GLTraits::get_binary_key(vertex_program, fragment_program);
+		}
+
+		auto pending = m_linking_pipelines.find(key);
+		if (pending == m_linking_pipelines.end())
+		{
+			LOG_NOTICE(RSX, "Add program :");
+			LOG_NOTICE(RSX, "*** vp id = %d", vertex_program.id);
+			LOG_NOTICE(RSX, "*** fp id = %d", fragment_program.id);
+
+			m_cache_miss_flag = true;
+
+			gl::glsl::program program;
+			__glcheck program.create();
+
+			if (use_binary && GLTraits::load_binary(program, binary_key))
+			{
+				return &finish_pipeline(key, std::move(program));
+			}
+
+			GLTraits::attach_shaders(program, vertex_program, fragment_program);
+			program.start_link();
+
+			pending = m_linking_pipelines.emplace(key, std::move(program)).first;
+		}
+
+		if (!wait && !pending->second.is_link_complete())
+		{
+			return nullptr;
+		}
+
+		gl::glsl::program program = std::move(pending->second);
+		m_linking_pipelines.erase(pending);
+
+		try
+		{
+			program.check_link_status();
+		}
+		catch (const gl::glsl::link_exception&)
+		{
+			// Report the shader which broke the link, the compile status was not checked when they were submitted
+			vertex_program.validate();
+			fragment_program.validate();
+			throw;
+		}
+
+		if (use_binary)
+		{
+			GLTraits::store_binary(program, binary_key);
+		}
+
+		return &finish_pipeline(key, std::move(program));
+	}
+
+	void clear()
+	{
+		m_linking_pipelines.clear();
+		program_state_cache<GLTraits>::clear();
+	}
+
+private:
+	// Programs still being linked by the driver, moved to the storage once complete
+	std::unordered_map<pipeline_key, gl::glsl::program, pipeline_key_hash, pipeline_key_compare> m_linking_pipelines;
+
+	gl::glsl::program& finish_pipeline(const pipeline_key& key, gl::glsl::program&& program)
+	{
+		GLTraits::initialize_program_uniforms(program);
+		perf::rsx_pipelines_compiled.add();
+
+		std::lock_guard<std::mutex> lock(s_mtx);
+		return m_storage[key] = std::move(program);
+	}
 };
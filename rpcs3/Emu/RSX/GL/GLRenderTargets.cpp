@@ -179,6 +179,8 @@ void GLGSRender::init_buffers(rsx::framebuffer_creation_context context, bool sk
 		return;
 	}
 
+	rsx::frame_timer_scope timer(this, rsx::frame_timer::surface_setup);
+
 	//We are about to change buffers, flush any pending requests for the old buffers
 	synchronize_buffers();
 
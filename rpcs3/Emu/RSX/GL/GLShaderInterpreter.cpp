@@ -0,0 +1,1199 @@
+#include "stdafx.h"
+#include "GLShaderInterpreter.h"
+#include "GLCommonDecompiler.h"
+#include "../GCM.h"
+#include "../RSXThread.h"
+#include "GLProgramBuffer.h"
+
+namespace
+{
+	enum
+	{
+		texture_type_1d = 0,
+		texture_type_2d = 1,
+		texture_type_cube = 2,
+		texture_type_3d = 3,
+		texture_type_shadow2d = 4,
+	};
+
+	// Flags of the fragment program header
+	enum
+	{
+		fp_front_diffuse_select = 1,
+		fp_front_specular_select = 2,
+		fp_r1_referenced = 4,
+	};
+
+	const u64 depth_export_variant = 1ull << 48;
+
+	u32 swap_halfwords(u32 value)
+	{
+		return (value << 16) | (value >> 16);
+	}
+
+#define DEFINE_OPCODE(op) OS << "#define " #op " " << static_cast<u32>(op) << "u\n"
+
+	void insert_vertex_opcodes(std::ostream& OS)
+	{
+		DEFINE_OPCODE(RSX_VP_REGISTER_TYPE_TEMP);
+		DEFINE_OPCODE(RSX_VP_REGISTER_TYPE_INPUT);
+		DEFINE_OPCODE(RSX_VP_REGISTER_TYPE_CONSTANT);
+
+		DEFINE_OPCODE(RSX_VEC_OPCODE_NOP);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_MOV);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_MUL);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_ADD);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_MAD);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_DP3);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_DPH);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_DP4);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_DST);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_MIN);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_MAX);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_SLT);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_SGE);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_ARL);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_FRC);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_FLR);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_SEQ);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_SFL);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_SGT);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_SLE);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_SNE);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_STR);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_SSG);
+		DEFINE_OPCODE(RSX_VEC_OPCODE_TXL);
+
+		DEFINE_OPCODE(RSX_SCA_OPCODE_NOP);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_MOV);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_RCP);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_RCC);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_RSQ);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_EXP);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_LOG);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_LIT);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_BRA);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_BRI);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_CAL);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_CLI);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_RET);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_LG2);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_EX2);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_SIN);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_COS);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_BRB);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_CLB);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_PSH);
+		DEFINE_OPCODE(RSX_SCA_OPCODE_POP);
+		OS << "\n";
+	}
+
+	void insert_fragment_opcodes(std::ostream& OS)
+	{
+		DEFINE_OPCODE(RSX_FP_REGISTER_TYPE_TEMP);
+		DEFINE_OPCODE(RSX_FP_REGISTER_TYPE_INPUT);
+		DEFINE_OPCODE(RSX_FP_REGISTER_TYPE_CONSTANT);
+
+		DEFINE_OPCODE(RSX_FP_OPCODE_NOP);
+		DEFINE_OPCODE(RSX_FP_OPCODE_MOV);
+		DEFINE_OPCODE(RSX_FP_OPCODE_MUL);
+		DEFINE_OPCODE(RSX_FP_OPCODE_ADD);
+		DEFINE_OPCODE(RSX_FP_OPCODE_MAD);
+		DEFINE_OPCODE(RSX_FP_OPCODE_DP3);
+		DEFINE_OPCODE(RSX_FP_OPCODE_DP4);
+		DEFINE_OPCODE(RSX_FP_OPCODE_DST);
+		DEFINE_OPCODE(RSX_FP_OPCODE_MIN);
+		DEFINE_OPCODE(RSX_FP_OPCODE_MAX);
+		DEFINE_OPCODE(RSX_FP_OPCODE_SLT);
+		DEFINE_OPCODE(RSX_FP_OPCODE_SGE);
+		DEFINE_OPCODE(RSX_FP_OPCODE_SLE);
+		DEFINE_OPCODE(RSX_FP_OPCODE_SGT);
+		DEFINE_OPCODE(RSX_FP_OPCODE_SNE);
+		DEFINE_OPCODE(RSX_FP_OPCODE_SEQ);
+		DEFINE_OPCODE(RSX_FP_OPCODE_FRC);
+		DEFINE_OPCODE(RSX_FP_OPCODE_FLR);
+		DEFINE_OPCODE(RSX_FP_OPCODE_KIL);
+		DEFINE_OPCODE(RSX_FP_OPCODE_PK4);
+		DEFINE_OPCODE(RSX_FP_OPCODE_UP4);
+		DEFINE_OPCODE(RSX_FP_OPCODE_DDX);
+		DEFINE_OPCODE(RSX_FP_OPCODE_DDY);
+		DEFINE_OPCODE(RSX_FP_OPCODE_TEX);
+		DEFINE_OPCODE(RSX_FP_OPCODE_TXP);
+		DEFINE_OPCODE(RSX_FP_OPCODE_TXD);
+		DEFINE_OPCODE(RSX_FP_OPCODE_RCP);
+		DEFINE_OPCODE(RSX_FP_OPCODE_RSQ);
+		DEFINE_OPCODE(RSX_FP_OPCODE_EX2);
+		DEFINE_OPCODE(RSX_FP_OPCODE_LG2);
+		DEFINE_OPCODE(RSX_FP_OPCODE_LIT);
+		DEFINE_OPCODE(RSX_FP_OPCODE_LRP);
+		DEFINE_OPCODE(RSX_FP_OPCODE_STR);
+		DEFINE_OPCODE(RSX_FP_OPCODE_SFL);
+		DEFINE_OPCODE(RSX_FP_OPCODE_COS);
+		DEFINE_OPCODE(RSX_FP_OPCODE_SIN);
+		DEFINE_OPCODE(RSX_FP_OPCODE_PK2);
+		DEFINE_OPCODE(RSX_FP_OPCODE_UP2);
+		DEFINE_OPCODE(RSX_FP_OPCODE_PKB);
+		DEFINE_OPCODE(RSX_FP_OPCODE_UPB);
+		DEFINE_OPCODE(RSX_FP_OPCODE_PK16);
+		DEFINE_OPCODE(RSX_FP_OPCODE_UP16);
+		DEFINE_OPCODE(RSX_FP_OPCODE_BEM);
+		DEFINE_OPCODE(RSX_FP_OPCODE_PKG);
+		DEFINE_OPCODE(RSX_FP_OPCODE_UPG);
+		DEFINE_OPCODE(RSX_FP_OPCODE_DP2A);
+		DEFINE_OPCODE(RSX_FP_OPCODE_TXL);
+		DEFINE_OPCODE(RSX_FP_OPCODE_TXB);
+		DEFINE_OPCODE(RSX_FP_OPCODE_TEXBEM);
+		DEFINE_OPCODE(RSX_FP_OPCODE_TXPBEM);
+		DEFINE_OPCODE(RSX_FP_OPCODE_REFL);
+		DEFINE_OPCODE(RSX_FP_OPCODE_DP2);
+		DEFINE_OPCODE(RSX_FP_OPCODE_NRM);
+		DEFINE_OPCODE(RSX_FP_OPCODE_DIV);
+		DEFINE_OPCODE(RSX_FP_OPCODE_DIVSQ);
+		DEFINE_OPCODE(RSX_FP_OPCODE_LIF);
+		DEFINE_OPCODE(RSX_FP_OPCODE_FENCT);
+		DEFINE_OPCODE(RSX_FP_OPCODE_FENCB);
+		DEFINE_OPCODE(RSX_FP_OPCODE_BRK);
+		DEFINE_OPCODE(RSX_FP_OPCODE_CAL);
+		DEFINE_OPCODE(RSX_FP_OPCODE_IFE);
+		DEFINE_OPCODE(RSX_FP_OPCODE_LOOP);
+		DEFINE_OPCODE(RSX_FP_OPCODE_REP);
+		DEFINE_OPCODE(RSX_FP_OPCODE_RET);
+		OS << "\n";
+	}
+
+#undef DEFINE_OPCODE
+
+	void insert_masked_write(std::ostream& OS)
+	{
+		//Same as the decompilers' conditional writes, the n-th written component is gated by the n-th condition
+		OS << "vec4 masked_write(vec4 reg, vec4 value, uint mask, bvec4 pass)\n";
+		OS << "{\n";
+		OS << "	uint n = 0;\n";
+		OS << "	for (uint c = 0; c < 4; ++c)\n";
+		OS << "	{\n";
+		OS << "		if ((mask & (1u << c)) == 0) continue;\n";
+		OS << "		if (pass[n]) reg[c] = value[c];\n";
+		OS << "		n++;\n";
+		OS << "	}\n";
+		OS << "	return reg;\n";
+		OS << "}\n\n";
+	}
+
+	std::string get_vertex_source()
+	{
+		std::stringstream OS;
+		OS << "#version 430\n";
+		insert_vertex_opcodes(OS);
+
+		OS << "layout(std140, binding = 0) uniform VertexContextBuffer\n";
+		OS << "{\n";
+		OS << "	mat4 scale_offset_mat;\n";
+		OS << "	ivec4 user_clip_enabled[2];\n";
+		OS << "	vec4 user_clip_factor[2];\n";
+		OS << "	uint transform_branch_bits;\n";
+		OS << "	uint vertex_base_index;\n";
+		OS << "	float point_size;\n";
+		OS << "	float z_near;\n";
+		OS << "	float z_far;\n";
+		OS << "	ivec4 input_attributes[16];\n";
+		OS << "};\n\n";
+
+		OS << "layout(location=0) uniform usamplerBuffer persistent_input_stream;\n";
+		OS << "layout(location=1) uniform usamplerBuffer volatile_input_stream;\n\n";
+
+		OS << "layout(std140, binding = 1) uniform VertexConstantsBuffer\n";
+		OS << "{\n";
+		OS << "	vec4 vc[468];\n";
+		OS << "};\n\n";
+
+		OS << "layout(std140, binding = " << gl::shader_interpreter::vertex_program_binding << ") uniform VertexProgramBuffer\n";
+		OS << "{\n";
+		OS << "	uvec4 vp_header; //output mask, instruction count, written outputs, read inputs\n";
+		OS << "	uvec4 vp_ucode[512];\n";
+		OS << "};\n\n";
+
+		for (int i = 0; i < rsx::limits::vertex_textures_count; ++i)
+		{
+			OS << "uniform sampler2D vtex" << i << ";\n";
+		}
+
+		const std::string outputs[] =
+		{
+			"diff_color", "spec_color", "front_diff_color", "front_spec_color", "fog_c",
+			"tc0", "tc1", "tc2", "tc3", "tc4", "tc5", "tc6", "tc7", "tc8", "tc9"
+		};
+
+		for (const auto& name : outputs)
+		{
+			OS << "layout(location=" << gl::get_varying_register_location(name) << ") out vec4 " << name << ";\n";
+		}
+
+		OS << "\n";
+
+		glsl::insert_glsl_legacy_function(OS, glsl::glsl_vertex_program, true);
+		glsl::insert_vertex_input_fetch(OS, glsl::glsl_rules_opengl4, gl::get_driver_caps().vendor_INTEL == false);
+		insert_masked_write(OS);
+
+		OS << "vec4 tmp[64];\n";
+		OS << "vec4 dst_reg[16];\n";
+		OS << "vec4 cc[2];\n";
+		OS << "ivec4 a[2];\n";
+		OS << "vec4 inputs[16];\n";
+		OS << "uvec4 inst;\n\n";
+
+		OS << "vec4 vp_src(uint src, bool absolute)\n";
+		OS << "{\n";
+		OS << "	vec4 value;\n";
+		OS << "	switch (src & 3)\n";
+		OS << "	{\n";
+		OS << "	case RSX_VP_REGISTER_TYPE_TEMP:\n";
+		OS << "		value = tmp[(src >> 2) & 63];\n";
+		OS << "		break;\n";
+		OS << "	case RSX_VP_REGISTER_TYPE_INPUT:\n";
+		OS << "		value = inputs[(inst.y >> 8) & 15];\n";
+		OS << "		break;\n";
+		OS << "	default:\n";
+		OS << "	{\n";
+		OS << "		int index = int((inst.y >> 12) & 0x3ff);\n";
+		OS << "		if ((inst.w & 2) != 0) index += a[(inst.x >> 24) & 1][inst.x & 3];\n";
+		OS << "		value = vc[clamp(index, 0, 467)];\n";
+		OS << "		break;\n";
+		OS << "	}\n";
+		OS << "	}\n\n";
+		OS << "	value = vec4(value[(src >> 14) & 3], value[(src >> 12) & 3], value[(src >> 10) & 3], value[(src >> 8) & 3]);\n";
+		OS << "	if (absolute) value = abs(value);\n";
+		OS << "	return ((src >> 16) & 1) != 0 ? -value : value;\n";
+		OS << "}\n\n";
+
+		OS << "bvec4 vp_cond()\n";
+		OS << "{\n";
+		OS << "	vec4 c = cc[(inst.x >> 25) & 1];\n";
+		OS << "	c = vec4(c[(inst.x >> 8) & 3], c[(inst.x >> 6) & 3], c[(inst.x >> 4) & 3], c[(inst.x >> 2) & 3]);\n";
+		OS << "	switch ((inst.x >> 10) & 7)\n";
+		OS << "	{\n";
+		OS << "	case 0: return bvec4(false);\n";
+		OS << "	case 1: return lessThan(c, vec4(0.));\n";
+		OS << "	case 2: return equal(c, vec4(0.));\n";
+		OS << "	case 3: return lessThanEqual(c, vec4(0.));\n";
+		OS << "	case 4: return greaterThan(c, vec4(0.));\n";
+		OS << "	case 5: return notEqual(c, vec4(0.));\n";
+		OS << "	case 6: return greaterThanEqual(c, vec4(0.));\n";
+		OS << "	}\n";
+		OS << "	return bvec4(true);\n";
+		OS << "}\n\n";
+
+		OS << "uint vp_mask(uint bits)\n";
+		OS << "{\n";
+		OS << "	//Write masks are stored in wzyx order, no mask writes everything\n";
+		OS << "	uint mask = ((bits >> 3) & 1) | ((bits >> 1) & 2) | ((bits << 1) & 4) | ((bits << 3) & 8);\n";
+		OS << "	return mask == 0 ? 0xf : mask;\n";
+		OS << "}\n\n";
+
+		OS << "void vp_write(vec4 value, bool is_sca)\n";
+		OS << "{\n";
+		OS << "	if (((inst.x >> 10) & 7) == 0) return;\n\n";
+		OS << "	uint mask = vp_mask(is_sca ? (inst.w >> 17) & 0xf : (inst.w >> 13) & 0xf);\n";
+		OS << "	if ((inst.x & (1u << 26)) != 0) value = clamp(value, 0., 1.);\n";
+		OS << "	bvec4 pass = (inst.x & (1u << 13)) != 0 ? vp_cond() : bvec4(true);\n\n";
+		OS << "	if ((inst.x & ((1u << 14) | (1u << 29))) != 0)\n";
+		OS << "	{\n";
+		OS << "		uint sel = (inst.x >> 25) & 1;\n";
+		OS << "		cc[sel] = masked_write(cc[sel], value, mask, pass);\n";
+		OS << "		return;\n";
+		OS << "	}\n\n";
+		OS << "	uint dst = (inst.w >> 2) & 0x1f;\n";
+		OS << "	uint vec_tmp = (inst.x >> 15) & 0x3f;\n";
+		OS << "	uint sca_tmp = (inst.w >> 7) & 0x3f;\n\n";
+		OS << "	if ((is_sca && sca_tmp != 0x3f) || dst == 0x1f)\n";
+		OS << "	{\n";
+		OS << "		uint index = is_sca ? sca_tmp : vec_tmp;\n";
+		OS << "		if (index != 0x3f) tmp[index] = masked_write(tmp[index], value, mask, pass);\n";
+		OS << "		return;\n";
+		OS << "	}\n\n";
+		OS << "	if (dst < 16) dst_reg[dst] = masked_write(dst_reg[dst], value, mask, pass);\n";
+		OS << "	if (vec_tmp != 0x3f) tmp[vec_tmp] = masked_write(tmp[vec_tmp], value, mask, pass);\n";
+		OS << "}\n\n";
+
+		OS << "vec4 vp_fetch(uint unit, vec2 coord)\n";
+		OS << "{\n";
+		OS << "	switch (unit)\n";
+		OS << "	{\n";
+		for (int i = 0; i < rsx::limits::vertex_textures_count; ++i)
+		{
+			OS << "	case " << i << ": return textureLod(vtex" << i << ", coord, 0);\n";
+		}
+		OS << "	}\n";
+		OS << "	return vec4(0.);\n";
+		OS << "}\n\n";
+
+		OS << "void vs_main()\n";
+		OS << "{\n";
+		OS << "	for (int i = 0; i < 16; ++i)\n";
+		OS << "	{\n";
+		OS << "		inputs[i] = ((vp_header.w >> i) & 1) != 0 ? read_location(i) : vec4(0.);\n";
+		OS << "		dst_reg[i] = vec4(0.);\n";
+		OS << "	}\n\n";
+		OS << "	for (int i = 0; i < 64; ++i) tmp[i] = vec4(0.);\n";
+		OS << "	dst_reg[0] = vec4(0., 0., 0., 1.);\n";
+		OS << "	cc[0] = cc[1] = vec4(0.);\n";
+		OS << "	a[0] = a[1] = ivec4(0);\n\n";
+		OS << "	uint call_stack[8];\n";
+		OS << "	int call_depth = 0;\n";
+		OS << "	uint pc = 0;\n";
+		OS << "	uint count = min(vp_header.y, 512u);\n\n";
+		OS << "	for (uint steps = 0; steps < 0x10000 && pc < count; ++steps)\n";
+		OS << "	{\n";
+		OS << "		inst = vp_ucode[pc];\n";
+		OS << "		uint next = pc + 1;\n";
+		OS << "		uint addr = ((inst.z & 0x3f) << 3) | (inst.w >> 29);\n";
+		OS << "		bool end = (inst.w & 1) != 0;\n\n";
+		OS << "		uint src0 = (inst.z >> 23) | ((inst.y & 0xff) << 9);\n";
+		OS << "		uint src1 = (inst.z >> 6) & 0x1ffff;\n";
+		OS << "		uint src2 = (inst.w >> 21) | ((inst.z & 0x3f) << 11);\n";
+		OS << "		if ((src0 & 3) == 0 || (src1 & 3) == 0 || (src2 & 3) == 0) return;\n\n";
+		OS << "		vec4 s0 = vp_src(src0, (inst.x & (1u << 21)) != 0);\n";
+		OS << "		vec4 s1 = vp_src(src1, (inst.x & (1u << 22)) != 0);\n";
+		OS << "		vec4 s2 = vp_src(src2, (inst.x & (1u << 23)) != 0);\n\n";
+		OS << "		switch ((inst.y >> 22) & 0x1f)\n";
+		OS << "		{\n";
+		OS << "		case RSX_VEC_OPCODE_NOP: break;\n";
+		OS << "		case RSX_VEC_OPCODE_MOV: vp_write(s0, false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_MUL: vp_write(s0 * s1, false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_ADD: vp_write(s0 + s2, false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_MAD: vp_write(s0 * s1 + s2, false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_DP3: vp_write(vec4(dot(s0.xyz, s1.xyz)), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_DPH: vp_write(vec4(dot(vec4(s0.xyz, 1.0), s1)), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_DP4: vp_write(vec4(dot(s0, s1)), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_DST: vp_write(vec4(distance(s0, s1)), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_MIN: vp_write(min(s0, s1), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_MAX: vp_write(max(s0, s1), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_SLT: vp_write(vec4(lessThan(s0, s1)), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_SGE: vp_write(vec4(greaterThanEqual(s0, s1)), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_ARL:\n";
+		OS << "			if (any(vp_cond()))\n";
+		OS << "			{\n";
+		OS << "				uint sel = (inst.x >> 24) & 1;\n";
+		OS << "				a[sel] = ivec4(masked_write(vec4(a[sel]), vec4(ivec4(s0)), vp_mask((inst.w >> 13) & 0xf), bvec4(true)));\n";
+		OS << "			}\n";
+		OS << "			break;\n";
+		OS << "		case RSX_VEC_OPCODE_FRC: vp_write(fract(s0), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_FLR: vp_write(floor(s0), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_SEQ: vp_write(vec4(equal(s0, s1)), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_SFL: vp_write(vec4(0.), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_SGT: vp_write(vec4(greaterThan(s0, s1)), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_SLE: vp_write(vec4(lessThanEqual(s0, s1)), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_SNE: vp_write(vec4(notEqual(s0, s1)), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_STR: vp_write(vec4(1.), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_SSG: vp_write(sign(s0), false); break;\n";
+		OS << "		case RSX_VEC_OPCODE_TXL: vp_write(vp_fetch((inst.z >> 8) & 3, s0.xy), false); break;\n";
+		OS << "		default: end = true; break;\n";
+		OS << "		}\n\n";
+		OS << "		//The scalar unit runs after the vector unit of the same instruction\n";
+		OS << "		vec4 s = vp_src(src2, (inst.x & (1u << 23)) != 0);\n";
+		OS << "		switch (inst.y >> 27)\n";
+		OS << "		{\n";
+		OS << "		case RSX_SCA_OPCODE_NOP: break;\n";
+		OS << "		case RSX_SCA_OPCODE_MOV: vp_write(s, true); break;\n";
+		OS << "		case RSX_SCA_OPCODE_RCP: vp_write(1.0 / s, true); break;\n";
+		OS << "		case RSX_SCA_OPCODE_RCC: vp_write(clamp(1.0 / s, 5.42101e-20, 1.884467e19), true); break;\n";
+		OS << "		case RSX_SCA_OPCODE_RSQ: vp_write((1. / sqrt(max(s.x, 0.0000000001))).xxxx, true); break;\n";
+		OS << "		case RSX_SCA_OPCODE_EXP: vp_write(exp(s), true); break;\n";
+		OS << "		case RSX_SCA_OPCODE_LOG: vp_write(log(s), true); break;\n";
+		OS << "		case RSX_SCA_OPCODE_LIT: vp_write(lit_legacy(s), true); break;\n";
+		OS << "		case RSX_SCA_OPCODE_BRA: if (any(vp_cond())) next = uint(a[(inst.x >> 24) & 1][inst.x & 3]); break;\n";
+		OS << "		case RSX_SCA_OPCODE_BRI: if (any(vp_cond())) next = addr; break;\n";
+		OS << "		case RSX_SCA_OPCODE_CAL:\n";
+		OS << "		case RSX_SCA_OPCODE_CLI:\n";
+		OS << "			if (any(vp_cond()) && call_depth < 8)\n";
+		OS << "			{\n";
+		OS << "				call_stack[call_depth++] = next;\n";
+		OS << "				next = addr;\n";
+		OS << "			}\n";
+		OS << "			break;\n";
+		OS << "		case RSX_SCA_OPCODE_RET:\n";
+		OS << "			if (call_depth > 0) next = call_stack[--call_depth];\n";
+		OS << "			else if (any(vp_cond())) return;\n";
+		OS << "			break;\n";
+		OS << "		case RSX_SCA_OPCODE_LG2: vp_write(log2(max(s, 0.0000000001)), true); break;\n";
+		OS << "		case RSX_SCA_OPCODE_EX2: vp_write(exp2(s), true); break;\n";
+		OS << "		case RSX_SCA_OPCODE_SIN: vp_write(sin(s), true); break;\n";
+		OS << "		case RSX_SCA_OPCODE_COS: vp_write(cos(s), true); break;\n";
+		OS << "		case RSX_SCA_OPCODE_BRB: if (((transform_branch_bits >> ((inst.w >> 23) & 0x1f)) & 1) == ((inst.w >> 28) & 1)) next = addr; break;\n";
+		OS << "		case RSX_SCA_OPCODE_CLB:\n";
+		OS << "		case RSX_SCA_OPCODE_PSH:\n";
+		OS << "		case RSX_SCA_OPCODE_POP: break;\n";
+		OS << "		default: end = true; break;\n";
+		OS << "		}\n\n";
+		OS << "		if (end) return;\n";
+		OS << "		pc = next;\n";
+		OS << "	}\n";
+		OS << "}\n\n";
+
+		// Outputs follow GLVertexProgram, the statically written registers are scanned when the ucode is uploaded
+		OS << "bool written(int index)\n";
+		OS << "{\n";
+		OS << "	return ((vp_header.z >> index) & 1) != 0;\n";
+		OS << "}\n\n";
+
+		OS << "vec4 output_or_default(int index, uint mask)\n";
+		OS << "{\n";
+		OS << "	if (written(index)) return dst_reg[index];\n";
+		OS << "	return (vp_header.x & mask) != 0 ? vec4(1.) : vec4(0.);\n";
+		OS << "}\n\n";
+
+		OS << "void main()\n";
+		OS << "{\n";
+		OS << "	vs_main();\n\n";
+		OS << "	uint mask = vp_header.x;\n";
+		OS << "	gl_Position = dst_reg[0];\n";
+		OS << "	diff_color = output_or_default(1, " << CELL_GCM_ATTRIB_OUTPUT_MASK_FRONTDIFFUSE << "u);\n";
+		OS << "	spec_color = output_or_default(2, " << CELL_GCM_ATTRIB_OUTPUT_MASK_FRONTSPECULAR << "u);\n";
+		OS << "	front_diff_color = written(3) ? dst_reg[3] : diff_color;\n";
+		OS << "	front_spec_color = written(4) ? dst_reg[4] : spec_color;\n";
+		OS << "	fog_c = (written(5) && (mask & " << CELL_GCM_ATTRIB_OUTPUT_MASK_FOG << "u) != 0) ? dst_reg[5].xxxx : output_or_default(-1, " << CELL_GCM_ATTRIB_OUTPUT_MASK_FOG << "u);\n\n";
+
+		const u32 uc012 = CELL_GCM_ATTRIB_OUTPUT_MASK_UC0 | CELL_GCM_ATTRIB_OUTPUT_MASK_UC1 | CELL_GCM_ATTRIB_OUTPUT_MASK_UC2;
+		const u32 uc345 = CELL_GCM_ATTRIB_OUTPUT_MASK_UC3 | CELL_GCM_ATTRIB_OUTPUT_MASK_UC4 | CELL_GCM_ATTRIB_OUTPUT_MASK_UC5;
+
+		OS << "	bool clip012 = written(5) && (mask & " << uc012 << "u) != 0;\n";
+		OS << "	bool clip345 = written(6) && (mask & " << uc345 << "u) != 0;\n";
+		OS << "	gl_ClipDistance[0] = (clip012 && user_clip_enabled[0].x > 0) ? dst_reg[5].y * user_clip_factor[0].x : 0.5;\n";
+		OS << "	gl_ClipDistance[1] = (clip012 && user_clip_enabled[0].y > 0) ? dst_reg[5].z * user_clip_factor[0].y : 0.5;\n";
+		OS << "	gl_ClipDistance[2] = (clip012 && user_clip_enabled[0].z > 0) ? dst_reg[5].w * user_clip_factor[0].z : 0.5;\n";
+		OS << "	gl_ClipDistance[3] = (clip345 && user_clip_enabled[0].w > 0) ? dst_reg[6].y * user_clip_factor[0].w : 0.5;\n";
+		OS << "	gl_ClipDistance[4] = (clip345 && user_clip_enabled[1].x > 0) ? dst_reg[6].z * user_clip_factor[1].x : 0.5;\n";
+		OS << "	gl_ClipDistance[5] = (clip345 && user_clip_enabled[1].y > 0) ? dst_reg[6].w * user_clip_factor[1].y : 0.5;\n\n";
+
+		const u32 tex_masks[] =
+		{
+			CELL_GCM_ATTRIB_OUTPUT_MASK_TEX0, CELL_GCM_ATTRIB_OUTPUT_MASK_TEX1, CELL_GCM_ATTRIB_OUTPUT_MASK_TEX2,
+			CELL_GCM_ATTRIB_OUTPUT_MASK_TEX3, CELL_GCM_ATTRIB_OUTPUT_MASK_TEX4, CELL_GCM_ATTRIB_OUTPUT_MASK_TEX5,
+			CELL_GCM_ATTRIB_OUTPUT_MASK_TEX6, CELL_GCM_ATTRIB_OUTPUT_MASK_TEX7, CELL_GCM_ATTRIB_OUTPUT_MASK_TEX8
+		};
+
+		for (int i = 0; i < 9; ++i)
+		{
+			OS << "	tc" << i << " = output_or_default(" << (i + 7) << ", " << tex_masks[i] << "u);\n";
+		}
+
+		// tc9 shares dst_reg6 with the clip planes 3-5
+		OS << "	tc9 = (written(6) && (mask & " << CELL_GCM_ATTRIB_OUTPUT_MASK_TEX9 << "u) != 0) ? dst_reg[6] : output_or_default(-1, " << CELL_GCM_ATTRIB_OUTPUT_MASK_TEX9 << "u);\n\n";
+
+		OS << "	gl_PointSize = point_size;\n";
+		OS << "	gl_Position = gl_Position * scale_offset_mat;\n";
+		OS << "	gl_Position = apply_zclip_xform(gl_Position, z_near, z_far);\n";
+		OS << "	gl_Position.z = (gl_Position.z + gl_Position.z) - gl_Position.w;\n";
+		OS << "}\n";
+
+		return OS.str();
+	}
+
+	// Expression sampling a unit of the given type for one of the TEX, TXP, TXD, TXB and TXL opcodes, mirrors FragmentProgramDecompiler::handle_tex_srb
+	std::string get_texture_fetch(int type, int unit, u32 opcode)
+	{
+		const std::string i = std::to_string(unit);
+		const std::string t = "tex" + i;
+
+		switch (type)
+		{
+		case texture_type_1d:
+			switch (opcode)
+			{
+			case RSX_FP_OPCODE_TEX: return "TEX1D(" + i + ", " + t + ", c0.x)";
+			case RSX_FP_OPCODE_TXP: return "TEX1D_PROJ(" + i + ", " + t + ", c0.xy)";
+			case RSX_FP_OPCODE_TXD: return "TEX1D_GRAD(" + i + ", " + t + ", c0.x, c1.x, c2.x)";
+			case RSX_FP_OPCODE_TXB: return "TEX1D_BIAS(" + i + ", " + t + ", c0.x, c1.x)";
+			case RSX_FP_OPCODE_TXL: return "TEX1D_LOD(" + i + ", " + t + ", c0.x, c1.x)";
+			}
+			break;
+		case texture_type_2d:
+			switch (opcode)
+			{
+			case RSX_FP_OPCODE_TEX: return "(fp_header.z & " + std::to_string(1u << unit) + "u) != 0 ? TEX2D_DEPTH_RGBA8(" + i + ", " + t + ", c0.xy) : TEX2D(" + i + ", " + t + ", c0.xy)";
+			case RSX_FP_OPCODE_TXP: return "TEX2D_PROJ(" + i + ", " + t + ", c0)";
+			case RSX_FP_OPCODE_TXD: return "TEX2D_GRAD(" + i + ", " + t + ", c0.xy, c1.xy, c2.xy)";
+			case RSX_FP_OPCODE_TXB: return "TEX2D_BIAS(" + i + ", " + t + ", c0.xy, c1.x)";
+			case RSX_FP_OPCODE_TXL: return "TEX2D_LOD(" + i + ", " + t + ", c0.xy, c1.x)";
+			}
+			break;
+		case texture_type_shadow2d:
+			// Only the shadow comparisons can sample a shadow sampler
+			switch (opcode)
+			{
+			case RSX_FP_OPCODE_TEX: return "TEX2D_SHADOW(" + i + ", " + t + ", c0.xyz).xxxx";
+			case RSX_FP_OPCODE_TXP: return "TEX2D_SHADOWPROJ(" + i + ", " + t + ", c0).xxxx";
+			}
+			break;
+		case texture_type_cube:
+		case texture_type_3d:
+			switch (opcode)
+			{
+			case RSX_FP_OPCODE_TEX: return "TEX3D(" + i + ", " + t + ", c0.xyz)";
+			case RSX_FP_OPCODE_TXP: return type == texture_type_cube ? "TEX3D(" + i + ", " + t + ", (c0.xyz / c0.w))" : "TEX3D_PROJ(" + i + ", " + t + ", c0)";
+			case RSX_FP_OPCODE_TXD: return "TEX3D_GRAD(" + i + ", " + t + ", c0.xyz, c1.xyz, c2.xyz)";
+			case RSX_FP_OPCODE_TXB: return "TEX3D_BIAS(" + i + ", " + t + ", c0.xyz, c1.x)";
+			case RSX_FP_OPCODE_TXL: return "TEX3D_LOD(" + i + ", " + t + ", c0.xyz, c1.x)";
+			}
+			break;
+		}
+
+		return{};
+	}
+
+	std::string get_fragment_source(u64 key)
+	{
+		std::stringstream OS;
+		OS << "#version 430\n";
+		insert_fragment_opcodes(OS);
+
+		// Only the state part of the decompiled programs' block, the constants are read from the ucode
+		OS << "layout(std140, binding = 2) uniform FragmentStateBuffer\n";
+		OS << "{\n";
+		OS << "	float fog_param0;\n";
+		OS << "	float fog_param1;\n";
+		OS << "	uint rop_control;\n";
+		OS << "	float alpha_ref;\n";
+		OS << "	uint reserved;\n";
+		OS << "	uint fog_mode;\n";
+		OS << "	float wpos_scale;\n";
+		OS << "	float wpos_bias;\n";
+		OS << "	vec4 texture_parameters[16];\n";
+		OS << "};\n\n";
+
+		OS << "layout(std140, binding = " << gl::shader_interpreter::fragment_program_binding << ") uniform FragmentProgramBuffer\n";
+		OS << "{\n";
+		OS << "	uvec4 fp_header; //shader control, flags, redirected textures, length in qwords\n";
+		OS << "	uvec4 fp_ucode[" << (gl::shader_interpreter::max_fragment_ucode_length / 16) << "];\n";
+		OS << "};\n\n";
+
+		const std::string inputs[] =
+		{
+			"diff_color", "spec_color", "front_diff_color", "front_spec_color", "fog_c",
+			"tc0", "tc1", "tc2", "tc3", "tc4", "tc5", "tc6", "tc7", "tc8", "tc9"
+		};
+
+		for (const auto& name : inputs)
+		{
+			OS << "layout(location=" << gl::get_varying_register_location(name) << ") in vec4 " << name << ";\n";
+		}
+
+		OS << "\n";
+
+		for (int i = 0; i < 4; ++i)
+		{
+			OS << "layout(location=" << i << ") out vec4 ocol" << i << ";\n";
+		}
+
+		OS << "\n";
+
+		const char* sampler_types[] = { "sampler1D", "sampler2D", "samplerCube", "sampler3D", "sampler2DShadow" };
+		int texture_types[rsx::limits::fragment_textures_count];
+
+		for (int i = 0; i < rsx::limits::fragment_textures_count; ++i)
+		{
+			texture_types[i] = (key >> (i * 3)) & 7;
+			OS << "uniform " << sampler_types[texture_types[i]] << " tex" << i << ";\n";
+		}
+
+		OS << "\n";
+
+		glsl::insert_glsl_legacy_function(OS, glsl::glsl_fragment_program, true, true, true);
+		glsl::insert_fog_declaration(OS);
+		insert_masked_write(OS);
+
+		OS << "vec4 r[64];\n";
+		OS << "vec4 h[64];\n";
+		OS << "vec4 cc[2];\n";
+		OS << "uvec4 inst;\n";
+		OS << "uint pc;\n\n";
+
+		OS << "vec4 fp_input(uint index)\n";
+		OS << "{\n";
+		OS << "	switch (index)\n";
+		OS << "	{\n";
+		OS << "	case 0: return get_wpos();\n";
+		OS << "	case 1: return ((fp_header.y & " << fp_front_diffuse_select << "u) != 0 && gl_FrontFacing) ? front_diff_color : diff_color;\n";
+		OS << "	case 2: return ((fp_header.y & " << fp_front_specular_select << "u) != 0 && gl_FrontFacing) ? front_spec_color : spec_color;\n";
+		OS << "	case 3: return fetch_fog_value(fog_mode);\n";
+		for (int i = 0; i < 10; ++i)
+		{
+			OS << "	case " << (i + 4) << ": return tc" << i << ";\n";
+		}
+		OS << "	case 14: return gl_FrontFacing ? vec4(1.) : vec4(-1.);\n";
+		OS << "	}\n";
+		OS << "	return vec4(0.);\n";
+		OS << "}\n\n";
+
+		OS << "vec4 fp_clamp(vec4 value, uint prec)\n";
+		OS << "{\n";
+		OS << "	switch (prec)\n";
+		OS << "	{\n";
+		OS << "	case 1: return clamp(value, -65504., 65504.);\n";
+		OS << "	case 2: return clamp(value, -2., 2.);\n";
+		OS << "	case 3: return clamp(value, -1., 1.);\n";
+		OS << "	case 4: return clamp(value, 0., 1.);\n";
+		OS << "	}\n";
+		OS << "	return value;\n";
+		OS << "}\n\n";
+
+		OS << "vec4 fp_src(uint src, bool absolute)\n";
+		OS << "{\n";
+		OS << "	vec4 value;\n";
+		OS << "	bool clamped = true;\n";
+		OS << "	switch (src & 3)\n";
+		OS << "	{\n";
+		OS << "	case RSX_FP_REGISTER_TYPE_TEMP:\n";
+		OS << "		value = ((src >> 8) & 1) != 0 ? h[(src >> 2) & 63] : r[(src >> 2) & 63];\n";
+		OS << "		break;\n";
+		OS << "	case RSX_FP_REGISTER_TYPE_INPUT:\n";
+		OS << "		value = fp_input((inst.x >> 13) & 15);\n";
+		OS << "		break;\n";
+		OS << "	case RSX_FP_REGISTER_TYPE_CONSTANT:\n";
+		OS << "		value = uintBitsToFloat(fp_ucode[min(pc + 1, " << (gl::shader_interpreter::max_fragment_ucode_length / 16 - 1) << "u)]);\n";
+		OS << "		clamped = false;\n";
+		OS << "		break;\n";
+		OS << "	default:\n";
+		OS << "		value = vec4(1.);\n";
+		OS << "		clamped = false;\n";
+		OS << "		break;\n";
+		OS << "	}\n\n";
+		OS << "	//Modifier order matters, neg is applied after the precision clamp\n";
+		OS << "	value = vec4(value[(src >> 9) & 3], value[(src >> 11) & 3], value[(src >> 13) & 3], value[(src >> 15) & 3]);\n";
+		OS << "	if (absolute) value = abs(value);\n";
+		OS << "	if (clamped) value = fp_clamp(value, (inst.z >> 19) & 7);\n";
+		OS << "	return ((src >> 17) & 1) != 0 ? -value : value;\n";
+		OS << "}\n\n";
+
+		OS << "bvec4 fp_cond()\n";
+		OS << "{\n";
+		OS << "	vec4 c = cc[inst.y >> 31];\n";
+		OS << "	c = vec4(c[(inst.y >> 21) & 3], c[(inst.y >> 23) & 3], c[(inst.y >> 25) & 3], c[(inst.y >> 27) & 3]);\n";
+		OS << "	switch ((inst.y >> 18) & 7)\n";
+		OS << "	{\n";
+		OS << "	case 0: return bvec4(false);\n";
+		OS << "	case 1: return lessThan(c, vec4(0.));\n";
+		OS << "	case 2: return equal(c, vec4(0.));\n";
+		OS << "	case 3: return lessThanEqual(c, vec4(0.));\n";
+		OS << "	case 4: return greaterThan(c, vec4(0.));\n";
+		OS << "	case 5: return notEqual(c, vec4(0.));\n";
+		OS << "	case 6: return greaterThanEqual(c, vec4(0.));\n";
+		OS << "	}\n";
+		OS << "	return bvec4(true);\n";
+		OS << "}\n\n";
+
+		OS << "void fp_write(vec4 value)\n";
+		OS << "{\n";
+		OS << "	if (((inst.y >> 18) & 7) == 0) return;\n\n";
+		OS << "	switch ((inst.z >> 28) & 7)\n";
+		OS << "	{\n";
+		OS << "	case 1: value *= 2.; break;\n";
+		OS << "	case 2: value *= 4.; break;\n";
+		OS << "	case 3: value *= 8.; break;\n";
+		OS << "	case 5: value /= 2.; break;\n";
+		OS << "	case 6: value /= 4.; break;\n";
+		OS << "	case 7: value /= 8.; break;\n";
+		OS << "	}\n\n";
+		OS << "	bool no_dest = (inst.x & (1u << 30)) != 0;\n";
+		OS << "	bool fp16 = (inst.x & (1u << 7)) != 0;\n";
+		OS << "	if (!no_dest)\n";
+		OS << "	{\n";
+		OS << "		if ((inst.x & (1u << 21)) != 0) value = (value - 0.5) * 2.;\n\n";
+		OS << "		if ((inst.x & (1u << 31)) != 0)\n";
+		OS << "		{\n";
+		OS << "			value = clamp(value, 0., 1.);\n";
+		OS << "		}\n";
+		OS << "		else\n";
+		OS << "		{\n";
+		OS << "			uint prec = (inst.x >> 22) & 3;\n";
+		OS << "			bool exempt = false;\n";
+		OS << "			switch ((inst.x >> 24) & 0x3f)\n";
+		OS << "			{\n";
+		OS << "			case RSX_FP_OPCODE_NRM:\n";
+		OS << "			case RSX_FP_OPCODE_MAX:\n";
+		OS << "			case RSX_FP_OPCODE_MIN:\n";
+		OS << "			case RSX_FP_OPCODE_COS:\n";
+		OS << "			case RSX_FP_OPCODE_SIN:\n";
+		OS << "			case RSX_FP_OPCODE_REFL:\n";
+		OS << "			case RSX_FP_OPCODE_EX2:\n";
+		OS << "			case RSX_FP_OPCODE_FRC:\n";
+		OS << "			case RSX_FP_OPCODE_LIT:\n";
+		OS << "			case RSX_FP_OPCODE_LIF:\n";
+		OS << "			case RSX_FP_OPCODE_LRP:\n";
+		OS << "			case RSX_FP_OPCODE_LG2:\n";
+		OS << "				exempt = true;\n";
+		OS << "				break;\n";
+		OS << "			case RSX_FP_OPCODE_MOV:\n";
+		OS << "				//fp16 temp to fp16 moves are not clamped\n";
+		OS << "				exempt = fp16 && (inst.y & 0x103) == 0x100;\n";
+		OS << "				break;\n";
+		OS << "			}\n\n";
+		OS << "			//fp16 precision flag on a f32 register is ignored\n";
+		OS << "			if (!exempt && (prec != 1 || fp16)) value = fp_clamp(value, prec);\n";
+		OS << "		}\n";
+		OS << "	}\n\n";
+		OS << "	uint mask = (inst.x >> 9) & 0xf;\n";
+		OS << "	if (mask == 0) mask = 0xf;\n";
+		OS << "	bvec4 pass = fp_cond();\n";
+		OS << "	uint cc_mod = (inst.y >> 30) & 1;\n";
+		OS << "	bool set_cond = (inst.x & (1u << 8)) != 0;\n\n";
+		OS << "	if (no_dest)\n";
+		OS << "	{\n";
+		OS << "		if (set_cond && any(pass)) cc[cc_mod] = masked_write(cc[cc_mod], value, mask, bvec4(true));\n";
+		OS << "		return;\n";
+		OS << "	}\n\n";
+		OS << "	uint index = (inst.x >> 1) & 63;\n";
+		OS << "	vec4 result;\n";
+		OS << "	if (fp16)\n";
+		OS << "		result = h[index] = masked_write(h[index], value, mask, pass);\n";
+		OS << "	else\n";
+		OS << "		result = r[index] = masked_write(r[index], value, mask, pass);\n\n";
+		OS << "	if (set_cond) cc[cc_mod] = masked_write(cc[cc_mod], result, mask, bvec4(true));\n";
+		OS << "}\n\n";
+
+		const u32 texture_opcodes[] = { RSX_FP_OPCODE_TEX, RSX_FP_OPCODE_TXP, RSX_FP_OPCODE_TXD, RSX_FP_OPCODE_TXB, RSX_FP_OPCODE_TXL };
+
+		OS << "vec4 fp_texture(uint opcode, vec4 c0, vec4 c1, vec4 c2)\n";
+		OS << "{\n";
+		OS << "	switch ((inst.x >> 17) & 15)\n";
+		OS << "	{\n";
+		for (int i = 0; i < rsx::limits::fragment_textures_count; ++i)
+		{
+			OS << "	case " << i << ":\n";
+			OS << "		switch (opcode)\n";
+			OS << "		{\n";
+			for (const u32 opcode : texture_opcodes)
+			{
+				const std::string fetch = get_texture_fetch(texture_types[i], i, opcode);
+				if (!fetch.empty())
+				{
+					OS << "		case " << opcode << "u: return " << fetch << ";\n";
+				}
+			}
+			OS << "		}\n";
+			OS << "		break;\n";
+		}
+		OS << "	}\n";
+		OS << "	return vec4(0.);\n";
+		OS << "}\n\n";
+
+		OS << "void fs_main()\n";
+		OS << "{\n";
+		OS << "	for (int i = 0; i < 64; ++i) r[i] = h[i] = vec4(0.);\n";
+		OS << "	cc[0] = cc[1] = vec4(0.);\n\n";
+		OS << "	//Open IF and LOOP scopes, IF entries lose their else offset once the else branch is entered\n";
+		OS << "	bool flow_loop[16];\n";
+		OS << "	uint flow_start[16];\n";
+		OS << "	uint flow_else[16];\n";
+		OS << "	uint flow_end[16];\n";
+		OS << "	uint flow_count[16];\n";
+		OS << "	int flow_depth = 0;\n\n";
+		OS << "	pc = 0;\n";
+		OS << "	uint length = min(fp_header.w, " << (gl::shader_interpreter::max_fragment_ucode_length / 16) << "u);\n\n";
+		OS << "	for (uint steps = 0; steps < 0x10000 && pc < length; ++steps)\n";
+		OS << "	{\n";
+		OS << "		while (flow_depth > 0)\n";
+		OS << "		{\n";
+		OS << "			int top = flow_depth - 1;\n";
+		OS << "			if (pc == flow_end[top])\n";
+		OS << "			{\n";
+		OS << "				if (flow_loop[top] && --flow_count[top] > 0)\n";
+		OS << "				{\n";
+		OS << "					pc = flow_start[top];\n";
+		OS << "					break;\n";
+		OS << "				}\n\n";
+		OS << "				flow_depth--;\n";
+		OS << "				continue;\n";
+		OS << "			}\n\n";
+		OS << "			//End of the taken branch of an IF with an else branch\n";
+		OS << "			if (!flow_loop[top] && pc == flow_else[top])\n";
+		OS << "			{\n";
+		OS << "				pc = flow_end[top];\n";
+		OS << "				continue;\n";
+		OS << "			}\n\n";
+		OS << "			break;\n";
+		OS << "		}\n\n";
+		OS << "		if (pc >= length) return;\n\n";
+		OS << "		inst = fp_ucode[pc];\n";
+		OS << "		uint opcode = ((inst.x >> 24) & 0x3f) | ((inst.z >> 25) & 0x40);\n";
+		OS << "		bool has_constant = (inst.y & 3) == RSX_FP_REGISTER_TYPE_CONSTANT || (inst.z & 3) == RSX_FP_REGISTER_TYPE_CONSTANT || (inst.w & 3) == RSX_FP_REGISTER_TYPE_CONSTANT;\n";
+		OS << "		uint next = pc + (has_constant ? 2 : 1);\n\n";
+		OS << "		vec4 s0 = fp_src(inst.y, (inst.y & (1u << 29)) != 0);\n";
+		OS << "		vec4 s1 = fp_src(inst.z, (inst.z & (1u << 18)) != 0);\n";
+		OS << "		vec4 s2 = fp_src(inst.w, (inst.w & (1u << 18)) != 0);\n\n";
+		OS << "		switch (opcode)\n";
+		OS << "		{\n";
+		OS << "		case RSX_FP_OPCODE_NOP: break;\n";
+		OS << "		case RSX_FP_OPCODE_KIL: if (any(fp_cond())) discard; break;\n";
+		OS << "		case RSX_FP_OPCODE_BRK:\n";
+		OS << "			if (any(fp_cond()))\n";
+		OS << "			{\n";
+		OS << "				int depth = flow_depth;\n";
+		OS << "				while (depth > 0 && !flow_loop[depth - 1]) depth--;\n";
+		OS << "				if (depth > 0)\n";
+		OS << "				{\n";
+		OS << "					next = flow_end[depth - 1];\n";
+		OS << "					flow_depth = depth - 1;\n";
+		OS << "				}\n";
+		OS << "			}\n";
+		OS << "			break;\n";
+		OS << "		case RSX_FP_OPCODE_CAL:\n";
+		OS << "		case RSX_FP_OPCODE_FENCT:\n";
+		OS << "		case RSX_FP_OPCODE_FENCB: break;\n";
+		OS << "		case RSX_FP_OPCODE_IFE:\n";
+		OS << "		{\n";
+		OS << "			uint else_pc = (inst.z & 0x7fffffff) >> 2;\n";
+		OS << "			uint end_pc = inst.w >> 2;\n";
+		OS << "			bool taken = any(fp_cond());\n";
+		OS << "			if (flow_depth == 16 || (!taken && else_pc == end_pc))\n";
+		OS << "			{\n";
+		OS << "				next = taken ? next : end_pc;\n";
+		OS << "				break;\n";
+		OS << "			}\n\n";
+		OS << "			flow_loop[flow_depth] = false;\n";
+		OS << "			flow_else[flow_depth] = (taken && else_pc != end_pc) ? else_pc : 0xffffffffu;\n";
+		OS << "			flow_end[flow_depth] = end_pc;\n";
+		OS << "			flow_depth++;\n";
+		OS << "			if (!taken) next = else_pc;\n";
+		OS << "			break;\n";
+		OS << "		}\n";
+		OS << "		case RSX_FP_OPCODE_LOOP:\n";
+		OS << "		case RSX_FP_OPCODE_REP:\n";
+		OS << "		{\n";
+		OS << "			//Without any exec flag the body runs once, like in the decompiled program\n";
+		OS << "			if (((inst.y >> 18) & 7) == 0) break;\n\n";
+		OS << "			uint end_counter = (inst.z >> 2) & 0xff;\n";
+		OS << "			uint init_counter = (inst.z >> 10) & 0xff;\n";
+		OS << "			uint increment = max((inst.z >> 19) & 0xff, 1u);\n";
+		OS << "			uint count = (any(fp_cond()) && init_counter < end_counter) ? (end_counter - init_counter + increment - 1) / increment : 0;\n";
+		OS << "			if (count == 0 || flow_depth == 16)\n";
+		OS << "			{\n";
+		OS << "				next = inst.w >> 2;\n";
+		OS << "				break;\n";
+		OS << "			}\n\n";
+		OS << "			flow_loop[flow_depth] = true;\n";
+		OS << "			flow_start[flow_depth] = next;\n";
+		OS << "			flow_end[flow_depth] = inst.w >> 2;\n";
+		OS << "			flow_count[flow_depth] = count;\n";
+		OS << "			flow_depth++;\n";
+		OS << "			break;\n";
+		OS << "		}\n";
+		OS << "		case RSX_FP_OPCODE_RET: if (any(fp_cond())) return; break;\n";
+		OS << "		case RSX_FP_OPCODE_ADD: fp_write(s0 + s1); break;\n";
+		OS << "		case RSX_FP_OPCODE_DIV: fp_write(s0 / (max(abs(s1.x), 0.0000000001) * sign(s1.x))); break;\n";
+		OS << "		case RSX_FP_OPCODE_DIVSQ: fp_write(s0 / sqrt(max(abs(s1.x), 0.0000000001))); break;\n";
+		OS << "		case RSX_FP_OPCODE_DP2: fp_write(vec4(dot(s0.xy, s1.xy))); break;\n";
+		OS << "		case RSX_FP_OPCODE_DP3: fp_write(vec4(dot(s0.xyz, s1.xyz))); break;\n";
+		OS << "		case RSX_FP_OPCODE_DP4: fp_write(vec4(dot(s0, s1))); break;\n";
+		OS << "		case RSX_FP_OPCODE_DP2A: fp_write(vec4(dot(s0.xy, s1.xy) + s2.x)); break;\n";
+		OS << "		case RSX_FP_OPCODE_MAD: fp_write(s0 * s1 + s2); break;\n";
+		OS << "		case RSX_FP_OPCODE_MAX: fp_write(max(s0, s1)); break;\n";
+		OS << "		case RSX_FP_OPCODE_MIN: fp_write(min(s0, s1)); break;\n";
+		OS << "		case RSX_FP_OPCODE_MOV: fp_write(s0); break;\n";
+		OS << "		case RSX_FP_OPCODE_MUL: fp_write(s0 * s1); break;\n";
+		OS << "		case RSX_FP_OPCODE_RCP: fp_write((1. / (max(abs(s0.x), 0.0000000001) * sign(s0.x))).xxxx); break;\n";
+		OS << "		case RSX_FP_OPCODE_RSQ: fp_write((1. / sqrt(max(abs(s0.x), 0.0000000001))).xxxx); break;\n";
+		OS << "		case RSX_FP_OPCODE_SEQ: fp_write(vec4(equal(s0, s1))); break;\n";
+		OS << "		case RSX_FP_OPCODE_SFL: fp_write(vec4(0.)); break;\n";
+		OS << "		case RSX_FP_OPCODE_SGE: fp_write(vec4(greaterThanEqual(s0, s1))); break;\n";
+		OS << "		case RSX_FP_OPCODE_SGT: fp_write(vec4(greaterThan(s0, s1))); break;\n";
+		OS << "		case RSX_FP_OPCODE_SLE: fp_write(vec4(lessThanEqual(s0, s1))); break;\n";
+		OS << "		case RSX_FP_OPCODE_SLT: fp_write(vec4(lessThan(s0, s1))); break;\n";
+		OS << "		case RSX_FP_OPCODE_SNE: fp_write(vec4(notEqual(s0, s1))); break;\n";
+		OS << "		case RSX_FP_OPCODE_STR: fp_write(vec4(1.)); break;\n";
+		OS << "		case RSX_FP_OPCODE_COS: fp_write(cos(s0.xxxx)); break;\n";
+		OS << "		case RSX_FP_OPCODE_SIN: fp_write(sin(s0.xxxx)); break;\n";
+		OS << "		case RSX_FP_OPCODE_DST: fp_write(vec4(distance(s0, s1))); break;\n";
+		OS << "		case RSX_FP_OPCODE_REFL: fp_write(s0 - 2.0 * (dot(s0, s1)) * s1); break;\n";
+		OS << "		case RSX_FP_OPCODE_EX2: fp_write(exp2(s0.xxxx)); break;\n";
+		OS << "		case RSX_FP_OPCODE_FLR: fp_write(floor(s0)); break;\n";
+		OS << "		case RSX_FP_OPCODE_FRC: fp_write(fract(s0)); break;\n";
+		OS << "		case RSX_FP_OPCODE_LIT: fp_write(lit_legacy(s0)); break;\n";
+		OS << "		case RSX_FP_OPCODE_LIF: fp_write(vec4(1.0, s0.y, (s0.y > 0 ? pow(2.0, s0.w) : 0.0), 1.0)); break;\n";
+		OS << "		case RSX_FP_OPCODE_LRP: fp_write(s2 * (1 - s0) + s1 * s0); break;\n";
+		OS << "		case RSX_FP_OPCODE_LG2: fp_write(log2(max(abs(s0.x), 0.0000000001)).xxxx); break;\n";
+		OS << "		case RSX_FP_OPCODE_PK2: fp_write(vec4(uintBitsToFloat(packHalf2x16(s0.xy)))); break;\n";
+		OS << "		case RSX_FP_OPCODE_PK4: fp_write(vec4(uintBitsToFloat(packSnorm4x8(s0)))); break;\n";
+		OS << "		case RSX_FP_OPCODE_PK16: fp_write(vec4(uintBitsToFloat(packSnorm2x16(s0.xy)))); break;\n";
+		OS << "		case RSX_FP_OPCODE_PKG:\n";
+		OS << "		case RSX_FP_OPCODE_PKB: fp_write(vec4(uintBitsToFloat(packUnorm4x8(s0)))); break;\n";
+		OS << "		case RSX_FP_OPCODE_UP2: fp_write(unpackHalf2x16(floatBitsToUint(s0.x)).xyxy); break;\n";
+		OS << "		case RSX_FP_OPCODE_UP4: fp_write(unpackSnorm4x8(floatBitsToUint(s0.x))); break;\n";
+		OS << "		case RSX_FP_OPCODE_UP16: fp_write(unpackSnorm2x16(floatBitsToUint(s0.x)).xyxy); break;\n";
+		OS << "		case RSX_FP_OPCODE_UPG:\n";
+		OS << "		case RSX_FP_OPCODE_UPB: fp_write(unpackUnorm4x8(floatBitsToUint(s0.x))); break;\n";
+		OS << "		case RSX_FP_OPCODE_DDX: fp_write(dFdx(s0)); break;\n";
+		OS << "		case RSX_FP_OPCODE_DDY: fp_write(dFdy(s0)); break;\n";
+		OS << "		case RSX_FP_OPCODE_NRM: fp_write(vec4(normalize(s0.xyz), 0.)); break;\n";
+		OS << "		case RSX_FP_OPCODE_BEM: fp_write(s0.xyxy + s1.xxxx * s2.xzxz + s1.yyyy * s2.ywyw); break;\n";
+		OS << "		case RSX_FP_OPCODE_TEXBEM: fp_write(fp_texture(RSX_FP_OPCODE_TEX, s0.xyxy + s1.xxxx * s2.xzxz + s1.yyyy * s2.ywyw, s1, s2)); break;\n";
+		OS << "		case RSX_FP_OPCODE_TXPBEM: fp_write(fp_texture(RSX_FP_OPCODE_TXP, s0.xyxy + s1.xxxx * s2.xzxz + s1.yyyy * s2.ywyw, s1, s2)); break;\n";
+		OS << "		case RSX_FP_OPCODE_TEX:\n";
+		OS << "		case RSX_FP_OPCODE_TXP:\n";
+		OS << "		case RSX_FP_OPCODE_TXD:\n";
+		OS << "		case RSX_FP_OPCODE_TXB:\n";
+		OS << "		case RSX_FP_OPCODE_TXL: fp_write(fp_texture(opcode, s0, s1, s2)); break;\n";
+		OS << "		}\n\n";
+		OS << "		if ((inst.x & 1) != 0) return;\n";
+		OS << "		pc = next;\n";
+		OS << "	}\n";
+		OS << "}\n\n";
+
+		OS << "void main()\n";
+		OS << "{\n";
+		OS << "	fs_main();\n\n";
+		OS << "	vec4 r0 = r[0], r2 = r[2], r3 = r[3], r4 = r[4];\n";
+		OS << "	vec4 h0 = h[0], h4 = h[4], h6 = h[6], h8 = h[8];\n\n";
+		OS << "	if ((fp_header.x & " << CELL_GCM_SHADER_CONTROL_32_BITS_EXPORTS << "u) != 0)\n";
+		OS << "	{\n";
+		glsl::insert_rop(OS, true);
+		OS << "	}\n";
+		OS << "	else\n";
+		OS << "	{\n";
+		glsl::insert_rop(OS, false);
+		OS << "	}\n";
+
+		if (key & depth_export_variant)
+		{
+			//Depth writes are always from a fp32 register
+			OS << "\n	gl_FragDepth = (fp_header.y & " << fp_r1_referenced << "u) != 0 ? r[1].z : gl_FragCoord.z;\n";
+		}
+
+		OS << "}\n";
+
+		return OS.str();
+	}
+}
+
+namespace gl
+{
+	u64 shader_interpreter::get_program_key(const RSXFragmentProgram& fp, u16 referenced_textures)
+	{
+		u64 key = 0;
+
+		for (u32 i = 0; i < rsx::limits::fragment_textures_count; ++i)
+		{
+			// Units the program doesn't sample keep a 2D sampler
+			u64 type = texture_type_2d;
+
+			if (referenced_textures & (1 << i))
+			{
+				type = static_cast<u64>(fp.get_texture_dimension(i));
+
+				if (type == texture_type_2d && (fp.shadow_textures & (1 << i)))
+				{
+					type = texture_type_shadow2d;
+				}
+			}
+
+			key |= type << (i * 3);
+		}
+
+		if (fp.ctrl & CELL_GCM_SHADER_CONTROL_DEPTH_EXPORT)
+		{
+			key |= depth_export_variant;
+		}
+
+		return key;
+	}
+
+	glsl::program& shader_interpreter::build_program(u64 key)
+	{
+		LOG_NOTICE(RSX, "Building shader interpreter variant 0x%llx", key);
+
+		// The shader object is only flagged for deletion while the program holds it
+		glsl::shader fragment_shader(glsl::shader::type::fragment, get_fragment_source(key));
+		fragment_shader.compile();
+
+		glsl::program result;
+		result.create()
+			.attach(m_vertex_shader)
+			.attach(fragment_shader)
+			.bind_fragment_data_location("ocol0", 0)
+			.bind_fragment_data_location("ocol1", 1)
+			.bind_fragment_data_location("ocol2", 2)
+			.bind_fragment_data_location("ocol3", 3)
+			.make();
+
+		GLTraits::initialize_program_uniforms(result);
+		return m_programs[key] = std::move(result);
+	}
+
+	void shader_interpreter::create()
+	{
+		m_vertex_shader.create(glsl::shader::type::vertex);
+		m_vertex_shader.source(get_vertex_source());
+		m_vertex_shader.compile();
+
+		// Programs sampling 2D textures only are the most common
+		build_program(get_program_key({}, 0));
+	}
+
+	void shader_interpreter::destroy()
+	{
+		m_programs.clear();
+
+		if (m_vertex_shader.created())
+		{
+			m_vertex_shader.remove();
+		}
+	}
+
+	glsl::program* shader_interpreter::get(const RSXFragmentProgram& fp, u16 referenced_textures)
+	{
+		const u64 key = get_program_key(fp, referenced_textures);
+
+		const auto found = m_programs.find(key);
+		if (found != m_programs.end())
+		{
+			return &found->second;
+		}
+
+		try
+		{
+			return &build_program(key);
+		}
+		catch (const std::exception& e)
+		{
+			LOG_ERROR(RSX, "Failed to build shader interpreter variant 0x%llx: %s", key, e.what());
+			return nullptr;
+		}
+	}
+
+	void shader_interpreter::fill_vertex_program_block(void* dst, const RSXVertexProgram& vp)
+	{
+		const u32 count = std::min<u32>(::size32(vp.data) / 4, 512);
+		u32 written_outputs = 0;
+		u32 read_inputs = 0;
+
+		for (u32 i = 0; i < count; ++i)
+		{
+			D0 d0;
+			D1 d1;
+			D2 d2;
+			D3 d3;
+			d0.HEX = vp.data[i * 4 + 0];
+			d1.HEX = vp.data[i * 4 + 1];
+			d2.HEX = vp.data[i * 4 + 2];
+			d3.HEX = vp.data[i * 4 + 3];
+
+			SRC src[3];
+			src[0].src0l = d2.src0l;
+			src[0].src0h = d1.src0h;
+			src[1].src1 = d2.src1;
+			src[2].src2l = d3.src2l;
+			src[2].src2h = d2.src2h;
+
+			// The interpreter aborts on the same instruction
+			if (!src[0].reg_type || !src[1].reg_type || !src[2].reg_type)
+			{
+				break;
+			}
+
+			for (const auto& s : src)
+			{
+				if (s.reg_type == RSX_VP_REGISTER_TYPE_INPUT)
+				{
+					read_inputs |= (1 << d1.input_src);
+				}
+			}
+
+			// Registers the decompiler would have declared, an output which is never written keeps its default value
+			const bool writes_output = d0.cond != 0 && !d0.cond_update_enable_0 && !d0.cond_update_enable_1 && d3.dst < 16;
+
+			if (writes_output && d1.vec_opcode != RSX_VEC_OPCODE_NOP && d1.vec_opcode != RSX_VEC_OPCODE_ARL)
+			{
+				written_outputs |= (1 << d3.dst);
+			}
+
+			if (writes_output && d3.sca_dst_tmp == 0x3f)
+			{
+				switch (d1.sca_opcode)
+				{
+				case RSX_SCA_OPCODE_MOV:
+				case RSX_SCA_OPCODE_RCP:
+				case RSX_SCA_OPCODE_RCC:
+				case RSX_SCA_OPCODE_RSQ:
+				case RSX_SCA_OPCODE_EXP:
+				case RSX_SCA_OPCODE_LOG:
+				case RSX_SCA_OPCODE_LIT:
+				case RSX_SCA_OPCODE_LG2:
+				case RSX_SCA_OPCODE_EX2:
+				case RSX_SCA_OPCODE_SIN:
+				case RSX_SCA_OPCODE_COS:
+					written_outputs |= (1 << d3.dst);
+					break;
+				}
+			}
+
+			if (d3.end)
+			{
+				break;
+			}
+		}
+
+		u32* header = static_cast<u32*>(dst);
+		header[0] = vp.output_mask;
+		header[1] = count;
+		header[2] = written_outputs;
+		header[3] = read_inputs;
+		std::memcpy(header + 4, vp.data.data(), count * 16);
+	}
+
+	void shader_interpreter::fill_fragment_program_header(void* dst, const RSXFragmentProgram& fp, u32 ucode_length)
+	{
+		u32 flags = 0;
+
+		const bool two_sided = fp.front_back_color_enabled && (fp.back_color_diffuse_output || fp.back_color_specular_output);
+
+		if (two_sided && fp.back_color_diffuse_output && fp.front_color_diffuse_output)
+		{
+			flags |= fp_front_diffuse_select;
+		}
+
+		if (two_sided && fp.back_color_specular_output && fp.front_color_specular_output)
+		{
+			flags |= fp_front_specular_select;
+		}
+
+		if (fp.ctrl & CELL_GCM_SHADER_CONTROL_DEPTH_EXPORT)
+		{
+			// Without any reference to r1 the decompiled program leaves the depth untouched
+			const auto data = static_cast<const be_t<u32>*>(fp.addr);
+
+			for (u32 n = 0; n < ucode_length / 16; ++n)
+			{
+				OPDEST dst;
+				SRC0 src0;
+				SRC1 src1;
+				SRC2 src2;
+				dst.HEX = swap_halfwords(data[n * 4 + 0]);
+				src0.HEX = swap_halfwords(data[n * 4 + 1]);
+				src1.HEX = swap_halfwords(data[n * 4 + 2]);
+				src2.HEX = swap_halfwords(data[n * 4 + 3]);
+
+				const bool is_r1 = (src0.reg_type == RSX_FP_REGISTER_TYPE_TEMP && src0.tmp_reg_index == 1 && !src0.fp16) ||
+					(src1.reg_type == RSX_FP_REGISTER_TYPE_TEMP && src1.tmp_reg_index == 1 && !src1.fp16) ||
+					(src2.reg_type == RSX_FP_REGISTER_TYPE_TEMP && src2.tmp_reg_index == 1 && !src2.fp16) ||
+					(!dst.no_dest && dst.dest_reg == 1 && !dst.fp16 && (src0.exec_if_lt || src0.exec_if_eq || src0.exec_if_gr));
+
+				if (is_r1 && !src1.opcode_is_branch)
+				{
+					flags |= fp_r1_referenced;
+					break;
+				}
+
+				if (src0.reg_type == RSX_FP_REGISTER_TYPE_CONSTANT || src1.reg_type == RSX_FP_REGISTER_TYPE_CONSTANT || src2.reg_type == RSX_FP_REGISTER_TYPE_CONSTANT)
+				{
+					// Skip the embedded constant
+					n++;
+				}
+			}
+		}
+
+		u32* header = static_cast<u32*>(dst);
+		header[0] = fp.ctrl;
+		header[1] = flags;
+		header[2] = fp.redirected_textures;
+		header[3] = ucode_length / 16;
+	}
+}
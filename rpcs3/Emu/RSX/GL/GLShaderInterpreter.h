@@ -0,0 +1,48 @@
+#pragma once
+#include "GLHelpers.h"
+#include "../RSXFragmentProgram.h"
+#include "../RSXVertexProgram.h"
+
+#include <unordered_map>
+
+namespace gl
+{
+	// Generic programs executing the RSX ucode read from uniform blocks. They stand in for the decompiled programs
+	// while those are linked in the background, so a new shader never stalls the draw that introduces it.
+	class shader_interpreter
+	{
+		glsl::shader m_vertex_shader;
+
+		// Variants by sampler types and depth export, the only state a program can't pick at runtime
+		std::unordered_map<u64, glsl::program> m_programs;
+
+		static u64 get_program_key(const RSXFragmentProgram& fp, u16 referenced_textures);
+		glsl::program& build_program(u64 key);
+
+	public:
+		enum
+		{
+			// Next to the blocks 0-2 of the decompiled programs
+			vertex_program_binding = 3,
+			fragment_program_binding = 4,
+
+			// uvec4 header followed by the ucode
+			vertex_program_block_size = 16 + 512 * 16,
+			fragment_program_block_size = 16384,
+
+			// Longer fragment programs don't fit the block and are linked as usual
+			max_fragment_ucode_length = fragment_program_block_size - 16,
+		};
+
+		void create();
+		void destroy();
+
+		// Variant able to run the current fragment program, built on first use. nullptr if it doesn't build.
+		glsl::program* get(const RSXFragmentProgram& fp, u16 referenced_textures);
+
+		static void fill_vertex_program_block(void* dst, const RSXVertexProgram& vp);
+
+		// Only fills the header, the ucode is copied by the program cache which patches its constants
+		static void fill_fragment_program_header(void* dst, const RSXFragmentProgram& fp, u32 ucode_length);
+	};
+}
@@ -427,7 +427,7 @@ namespace gl
 			{
 				for (const rsx_subresource_layout &layout : input_layouts)
 				{
-					upload_texture_subresource(staging_buffer, layout, format, is_swizzled, vtc_support, 4);
+					upload_texture_subresources({ { staging_buffer, layout } }, format, is_swizzled, vtc_support, 4);
 					glTexSubImage1D(GL_TEXTURE_1D, mip_level++, 0, layout.width_in_block, gl_format, gl_type, staging_buffer.data());
 				}
 			}
@@ -436,7 +436,7 @@ namespace gl
 				for (const rsx_subresource_layout &layout : input_layouts)
 				{
 					u32 size = layout.width_in_block * ((format == CELL_GCM_TEXTURE_COMPRESSED_DXT1) ? 8 : 16);
-					upload_texture_subresource(staging_buffer, layout, format, is_swizzled, vtc_support, 4);
+					upload_texture_subresources({ { staging_buffer, layout } }, format, is_swizzled, vtc_support, 4);
 					glCompressedTexSubImage1D(GL_TEXTURE_1D, mip_level++, 0, layout.width_in_block * 4, gl_format, size, staging_buffer.data());
 				}
 			}
@@ -449,7 +449,7 @@ namespace gl
 			{
 				for (const rsx_subresource_layout &layout : input_layouts)
 				{
-					upload_texture_subresource(staging_buffer, layout, format, is_swizzled, vtc_support, 4);
+					upload_texture_subresources({ { staging_buffer, layout } }, format, is_swizzled, vtc_support, 4);
 					glTexSubImage2D(GL_TEXTURE_2D, mip_level++, 0, 0, layout.width_in_block, layout.height_in_block, gl_format, gl_type, staging_buffer.data());
 				}
 			}
@@ -458,7 +458,7 @@ namespace gl
 				for (const rsx_subresource_layout &layout : input_layouts)
 				{
 					u32 size = layout.width_in_block * layout.height_in_block * ((format == CELL_GCM_TEXTURE_COMPRESSED_DXT1) ? 8 : 16);
-					upload_texture_subresource(staging_buffer, layout, format, is_swizzled, vtc_support, 4);
+					upload_texture_subresources({ { staging_buffer, layout } }, format, is_swizzled, vtc_support, 4);
 					glCompressedTexSubImage2D(GL_TEXTURE_2D, mip_level++, 0, 0, layout.width_in_block * 4, layout.height_in_block * 4, gl_format, size, staging_buffer.data());
 				}
 			}
@@ -474,7 +474,7 @@ namespace gl
 			{
 				for (const rsx_subresource_layout &layout : input_layouts)
 				{
-					upload_texture_subresource(staging_buffer, layout, format, is_swizzled, vtc_support, 4);
+					upload_texture_subresources({ { staging_buffer, layout } }, format, is_swizzled, vtc_support, 4);
 					glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + mip_level / mipmap_count, mip_level % mipmap_count, 0, 0, layout.width_in_block, layout.height_in_block, gl_format, gl_type, staging_buffer.data());
 					mip_level++;
 				}
@@ -484,7 +484,7 @@ namespace gl
 				for (const rsx_subresource_layout &layout : input_layouts)
 				{
 					u32 size = layout.width_in_block * layout.height_in_block * ((format == CELL_GCM_TEXTURE_COMPRESSED_DXT1) ? 8 : 16);
-					upload_texture_subresource(staging_buffer, layout, format, is_swizzled, vtc_support, 4);
+					upload_texture_subresources({ { staging_buffer, layout } }, format, is_swizzled, vtc_support, 4);
 					glCompressedTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + mip_level / mipmap_count, mip_level % mipmap_count, 0, 0, layout.width_in_block * 4, layout.height_in_block * 4, gl_format, size, staging_buffer.data());
 					mip_level++;
 				}
@@ -498,7 +498,7 @@ namespace gl
 			{
 				for (const rsx_subresource_layout &layout : input_layouts)
 				{
-					upload_texture_subresource(staging_buffer, layout, format, is_swizzled, vtc_support, 4);
+					upload_texture_subresources({ { staging_buffer, layout } }, format, is_swizzled, vtc_support, 4);
 					glTexSubImage3D(GL_TEXTURE_3D, mip_level++, 0, 0, 0, layout.width_in_block, layout.height_in_block, depth, gl_format, gl_type, staging_buffer.data());
 				}
 			}
@@ -507,7 +507,7 @@ namespace gl
 				for (const rsx_subresource_layout &layout : input_layouts)
 				{
 					u32 size = layout.width_in_block * layout.height_in_block * layout.depth * ((format == CELL_GCM_TEXTURE_COMPRESSED_DXT1) ? 8 : 16);
-					upload_texture_subresource(staging_buffer, layout, format, is_swizzled, vtc_support, 4);
+					upload_texture_subresources({ { staging_buffer, layout } }, format, is_swizzled, vtc_support, 4);
 					glCompressedTexSubImage3D(GL_TEXTURE_3D, mip_level++, 0, 0, 0, layout.width_in_block * 4, layout.height_in_block * 4, layout.depth, gl_format, size, staging_buffer.data());
 				}
 			}
@@ -257,6 +257,7 @@ namespace gl
 		{
 			rsx::protection_policy policy = g_cfg.video.strict_rendering_mode ? rsx::protection_policy::protect_policy_full_range : rsx::protection_policy::protect_policy_conservative;
 			rsx::buffered_section::reset(base, size, policy);
+			reset_hashed();
 
 			flushed = false;
 			synchronized = false;
@@ -1184,6 +1185,18 @@ namespace gl
 
 		void on_frame_end() override
 		{
+			u64 bytes_to_free = 0;
+			u64 available, total;
+			if (gl::get_video_memory_info(available, total))
+			{
+				//Keep a tenth of the video memory free, or 256M if the driver only reports free memory
+				const u64 reserve = total ? total / 10 : 0x10000000;
+				if (available < reserve)
+					bytes_to_free = reserve - available;
+			}
+
+			evict_unused_sections(bytes_to_free);
+
 			if (m_unreleased_texture_objects >= m_max_zombie_objects)
 			{
 				purge_dirty();
@@ -268,6 +268,7 @@ gl::vertex_upload_info GLGSRender::set_vertex_buffer()
 
 	std::chrono::time_point<steady_clock> now = steady_clock::now();
 	m_vertex_upload_time += std::chrono::duration_cast<std::chrono::microseconds>(now - then).count();
+	add_frame_time(rsx::frame_timer::vertex_upload, now - then);
 	return upload_info;
 }
 
@@ -357,6 +357,15 @@ void GLVertexProgram::Compile()
 	glShaderSource(id, 1, &str, &strlen);
 	glCompileShader(id);
 
+	// Querying the status would wait for the driver's compiler threads, the program cache checks it if the link fails
+	if (!gl::get_driver_caps().KHR_parallel_shader_compile_supported)
+	{
+		validate();
+	}
+}
+
+bool GLVertexProgram::validate() const
+{
 	GLint r = GL_FALSE;
 	glGetShaderiv(id, GL_COMPILE_STATUS, &r);
 	if (r != GL_TRUE)
@@ -374,7 +383,10 @@ void GLVertexProgram::Compile()
 
 		LOG_NOTICE(RSX, "%s", shader.c_str());
 		Emu.Pause();
+		return false;
 	}
+
+	return true;
 }
 
 void GLVertexProgram::Delete()
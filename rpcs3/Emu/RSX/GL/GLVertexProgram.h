@@ -56,6 +56,9 @@ public:
 	void Decompile(const RSXVertexProgram& prog);
 	void Compile();
 
+	/** Logs the compiler errors and pauses the emulator if the shader failed to compile. */
+	bool validate() const;
+
 private:
 	void Delete();
 };
@@ -586,8 +586,92 @@ namespace rsx
 				std::vector<vertex> verts;
 			};
 
+			// One quad of an instanced draw, corners in triangle strip order followed by the state of its command
+			struct quad_instance
+			{
+				vertex corners[4];
+				f32 color[4];
+				f32 clip_rect[4];  // x1, y1, x2, y2
+				f32 parameters[4]; // pulse glow, read texture, clip region, unused
+			};
+
+			// Instanced draw of consecutive commands, only the texture of the config is relevant
+			struct draw_batch
+			{
+				command_config config;
+				u32 first_instance;
+				u32 instance_count;
+			};
+
 			std::vector<command> draw_commands;
 
+			static bool is_textured(const command_config& config)
+			{
+				switch (config.texture_ref)
+				{
+				case image_resource_id::none:
+				case image_resource_id::game_icon:
+				case image_resource_id::backbuffer:
+					//TODO
+					return false;
+				default:
+					return true;
+				}
+			}
+
+			//! Flatten the commands to one instance per quad. Consecutive commands share a batch unless they sample different textures
+			void build_batches(std::vector<quad_instance>& instances, std::vector<draw_batch>& batches) const
+			{
+				instances.clear();
+				batches.clear();
+
+				for (const auto& cmd : draw_commands)
+				{
+					const u32 num_quads = ::size32(cmd.verts) / 4;
+
+					if (!num_quads)
+						continue;
+
+					const bool textured = is_textured(cmd.config);
+
+					if (batches.empty() || (textured && is_textured(batches.back().config) &&
+						(batches.back().config.texture_ref != cmd.config.texture_ref ||
+						batches.back().config.font_ref != cmd.config.font_ref ||
+						batches.back().config.external_data_ref != cmd.config.external_data_ref)))
+					{
+						batches.push_back({ {}, ::size32(instances), 0 });
+					}
+
+					auto& batch = batches.back();
+
+					if (textured)
+						batch.config = cmd.config;
+
+					for (u32 n = 0; n < num_quads; ++n)
+					{
+						quad_instance quad;
+						std::copy(cmd.verts.begin() + n * 4, cmd.verts.begin() + n * 4 + 4, quad.corners);
+
+						quad.color[0] = cmd.config.color.r;
+						quad.color[1] = cmd.config.color.g;
+						quad.color[2] = cmd.config.color.b;
+						quad.color[3] = cmd.config.color.a;
+						quad.clip_rect[0] = cmd.config.clip_rect.x1;
+						quad.clip_rect[1] = cmd.config.clip_rect.y1;
+						quad.clip_rect[2] = cmd.config.clip_rect.x2;
+						quad.clip_rect[3] = cmd.config.clip_rect.y2;
+						quad.parameters[0] = cmd.config.pulse_glow ? 1.f : 0.f;
+						quad.parameters[1] = textured ? 1.f : 0.f;
+						quad.parameters[2] = cmd.config.clip_region ? 1.f : 0.f;
+						quad.parameters[3] = 0.f;
+
+						instances.push_back(quad);
+					}
+
+					batch.instance_count += num_quads;
+				}
+			}
+
 			void add(const compiled_resource& other)
 			{
 				auto old_size = draw_commands.size();
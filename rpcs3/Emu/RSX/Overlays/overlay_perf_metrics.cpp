@@ -79,6 +79,7 @@ namespace rsx
 			case detail_level::low: m_titles.text = ""; break;
 			case detail_level::medium: m_titles.text = fmt::format("\n\n%s", title1_medium); break;
 			case detail_level::high: m_titles.text = fmt::format("\n\n%s\n\n\n\n\n\n%s", title1_high, title2); break;
+			case detail_level::extreme: m_titles.text = fmt::format("\n\n%s\n\n\n\n\n\n%s\n\n\n\n\n\n\n%s", title1_high, title2, title3); break;
 			}
 			m_titles.auto_resize();
 			m_titles.refresh();
@@ -202,6 +203,20 @@ namespace rsx
 				f32 rsx_usage{0};
 				u32 rsx_load{0};
 
+				f32 draw_calls{0};
+				f32 merged_draw_calls{0};
+				f32 skipped_draw_calls{0};
+				u32 pending_pipelines{0};
+
+				u32 heap_size{0};
+				u32 heap_high_water{0};
+				u64 heap_forced_flushes{0};
+
+				f32 cpu_blits{0};
+				f32 cpu_blit_time{0};
+
+				std::array<f32, (u32)frame_timer::count> frame_times{};
+
 				std::shared_ptr<GSRender> rsx_thread;
 
 				std::string perf_text;
@@ -209,13 +224,62 @@ namespace rsx
 				// 1. Fetch/calculate metrics we'll need
 				switch (m_detail)
 				{
+				case detail_level::extreme:
+				{
+					rsx_thread = fxm::get<GSRender>();
+
+					// Latched by the RSX thread at the end of every frame
+					for (u32 i = 0; i < (u32)frame_timer::count; ++i)
+					{
+						frame_times[i] = rsx_thread->performance_counters.last_frame_time[i] / 1000000.f;
+					}
+
+					// fallthrough
+				}
 				case detail_level::high:
 				{
 					frametime = m_force_update ? 0 : std::max(0.0, elapsed / m_frames);
 
-					rsx_thread = fxm::get<GSRender>();
+					if (!rsx_thread)
+						rsx_thread = fxm::get<GSRender>();
+
 					rsx_load = rsx_thread->get_load();
 
+					// Draw calls per frame (issued to the backend, merged by FIFO reordering and skipped while shaders compile)
+					const u64 draws = rsx_thread->performance_counters.draw_calls;
+					const u64 guest_draws = rsx_thread->performance_counters.guest_draw_calls;
+					const u64 skipped_draws = rsx_thread->performance_counters.skipped_draw_calls;
+
+					if (!m_force_update && m_frames)
+					{
+						draw_calls = static_cast<f32>(draws - m_last_draw_calls) / m_frames;
+						merged_draw_calls = std::max(0.f, static_cast<f32>(s64(guest_draws - m_last_guest_draw_calls) - s64(draws - m_last_draw_calls)) / m_frames);
+						skipped_draw_calls = static_cast<f32>(skipped_draws - m_last_skipped_draw_calls) / m_frames;
+					}
+
+					m_last_draw_calls = draws;
+					m_last_guest_draw_calls = guest_draws;
+					m_last_skipped_draw_calls = skipped_draws;
+					pending_pipelines = rsx_thread->performance_counters.pending_pipelines;
+
+					// Upload heap sizing
+					heap_size = static_cast<u32>(rsx_thread->performance_counters.heap_size / 0x100000);
+					heap_high_water = static_cast<u32>(rsx_thread->performance_counters.heap_high_water / 0x100000);
+					heap_forced_flushes = rsx_thread->performance_counters.heap_forced_flushes;
+
+					// Blit engine transfers that had to run on the CPU, per frame
+					const u64 blits = rsx_thread->performance_counters.cpu_blits;
+					const u64 blit_time = rsx_thread->performance_counters.cpu_blit_time;
+
+					if (!m_force_update && m_frames)
+					{
+						cpu_blits = static_cast<f32>(blits - m_last_cpu_blits) / m_frames;
+						cpu_blit_time = static_cast<f32>(blit_time - m_last_cpu_blit_time) / (m_frames * 1000.f);
+					}
+
+					m_last_cpu_blits = blits;
+					m_last_cpu_blit_time = blit_time;
+
 					total_threads = CPUStats::get_thread_count();
 
 					// fallthrough
@@ -282,6 +346,7 @@ namespace rsx
 					break;
 				}
 				case detail_level::high:
+				case detail_level::extreme:
 				{
 					perf_text += fmt::format("FPS : %05.2f (%03.1fms)\n\n"
 					                         "%s\n"
@@ -290,8 +355,31 @@ namespace rsx
 					                         " RSX   : %04.1f %% ( 1)\n"
 					                         " Total : %04.1f %% (%2u)\n\n"
 					                         "%s\n"
-					                         " RSX   : %02u %%",
-					    fps, frametime, std::string(title1_high.size(), ' '), ppu_usage, ppus, spu_usage, spus + rawspus, rsx_usage, cpu_usage, total_threads, std::string(title2.size(), ' '), rsx_load);
+					                         " RSX   : %02u %%\n"
+					                         " Draws : %.0f (%.0f merged)\n"
+					                         " Shaders : %u compiling (%.0f draws skipped)\n"
+					                         " Heaps : %u MB (%u MB peak, %llu forced flushes)\n"
+					                         " CPU blits : %.0f (%.2fms)",
+					    fps, frametime, std::string(title1_high.size(), ' '), ppu_usage, ppus, spu_usage, spus + rawspus, rsx_usage, cpu_usage, total_threads, std::string(title2.size(), ' '), rsx_load, draw_calls, merged_draw_calls,
+					    pending_pipelines, skipped_draw_calls, heap_size, heap_high_water, heap_forced_flushes, cpu_blits, cpu_blit_time);
+
+					if (m_detail == detail_level::extreme)
+					{
+						const auto time = [&](frame_timer timer) { return frame_times[(u32)timer]; };
+
+						perf_text += fmt::format("\n\n"
+						                         "%s\n"
+						                         " FIFO     : %.2f\n"
+						                         " Programs : %.2f\n"
+						                         " Vertices : %.2f\n"
+						                         " Textures : %.2f\n"
+						                         " Surfaces : %.2f\n"
+						                         " Submit   : %.2f\n"
+						                         " Flip     : %.2f\n"
+						                         " Tasks    : %.2f",
+						    std::string(title3.size(), ' '), time(frame_timer::fifo), time(frame_timer::programs), time(frame_timer::vertex_upload), time(frame_timer::texture_upload),
+						    time(frame_timer::surface_setup), time(frame_timer::submit), time(frame_timer::flip), time(frame_timer::local_task));
+					}
 					break;
 				}
 				}
@@ -1,6 +1,9 @@
 #include "stdafx.h"
 #include "overlays.h"
 #include "../GSRender.h"
+#include "Utilities/hash.h"
+
+#include <unordered_map>
 
 namespace rsx
 {
@@ -28,11 +31,38 @@ namespace rsx
 				on_close(return_code);
 		}
 
+		std::shared_ptr<image_info> trophy_notification::get_icon(const std::vector<u8>& png)
+		{
+			static std::mutex s_mutex;
+			static std::unordered_map<u64, std::shared_ptr<image_info>> s_icons;
+
+			const u64 key = rpcs3::hash64(png.data(), png.size());
+
+			std::lock_guard<std::mutex> lock(s_mutex);
+
+			auto& icon = s_icons[key];
+
+			if (!icon)
+			{
+				// A trophy set has a few dozen icons at most, drop them all if something goes wrong
+				if (s_icons.size() > 256)
+				{
+					s_icons.clear();
+					return std::make_shared<image_info>(png);
+				}
+
+				icon = std::make_shared<image_info>(png);
+			}
+
+			return icon;
+		}
+
 		void overlay::refresh()
 		{
 			if (auto rsxthr = rsx::get_current_renderer())
 			{
 				rsxthr->native_ui_flip_request.store(true);
+				rsxthr->fifo_wake();
 			}
 		}
 	} // namespace overlays
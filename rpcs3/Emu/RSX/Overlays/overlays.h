@@ -414,7 +414,8 @@ namespace rsx
 			   minimal - fps
 			   low - fps, total cpu usage
 			   medium  - fps, detailed cpu usage
-			   high - fps, frametime, detailed cpu usage, thread number, rsx load
+			   high - fps, frametime, detailed cpu usage, thread number, rsx load, draw calls per frame
+			   extreme - high + per-subsystem rsx frame time breakdown
 			 */
 			detail_level m_detail;
 
@@ -428,6 +429,11 @@ namespace rsx
 			Timer m_update_timer;
 			u32 m_update_interval; // in ms
 			u32 m_frames{ 0 };
+			u64 m_last_draw_calls{ 0 };
+			u64 m_last_guest_draw_calls{ 0 };
+			u64 m_last_skipped_draw_calls{ 0 };
+			u64 m_last_cpu_blits{ 0 };
+			u64 m_last_cpu_blit_time{ 0 };
 			std::string m_font;
 			u32 m_font_size;
 			u32 m_margin; // distance to screen borders in px
@@ -439,6 +445,7 @@ namespace rsx
 			const std::string title1_medium{"CPU Utilization:"};
 			const std::string title1_high{"Host Utilization (CPU):"};
 			const std::string title2{"Guest Utilization (PS3):"};
+			const std::string title3{"RSX Frame Breakdown (ms):"};
 
 			void reset_transform(label& elm) const;
 			void reset_transforms();
@@ -1007,7 +1014,10 @@ namespace rsx
 			label text_view;
 
 			u64 creation_time = 0;
-			std::unique_ptr<image_info> icon_info;
+			std::shared_ptr<image_info> icon_info;
+
+			// Get the decoded icon, icons are kept decoded for the next notifications
+			static std::shared_ptr<image_info> get_icon(const std::vector<u8>& png);
 
 		public:
 			trophy_notification()
@@ -1047,7 +1057,7 @@ namespace rsx
 			{
 				if (trophy_icon_buffer.size())
 				{
-					icon_info = std::make_unique<image_info>(trophy_icon_buffer);
+					icon_info = get_icon(trophy_icon_buffer);
 					image.set_raw_image(icon_info.get());
 				}
 
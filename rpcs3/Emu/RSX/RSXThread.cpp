@@ -10,6 +10,7 @@
 #include "Common/texture_cache.h"
 #include "Capture/rsx_capture.h"
 #include "rsx_methods.h"
+#include "Utilities/perf_counters.h"
 #include "rsx_utils.h"
 #include "Emu/Cell/lv2/sys_event.h"
 #include "Emu/Cell/Modules/cellGcmSys.h"
@@ -38,6 +39,10 @@ namespace rsx
 
 	//TODO: Restore a working shaders cache
 
+	// Time an empty FIFO is polled before the RSX thread sleeps, and the longest sleep (us)
+	constexpr u64 fifo_idle_spin_time = 500;
+	constexpr u64 fifo_idle_wait_time = 100;
+
 	u32 get_address(u32 offset, u32 location)
 	{
 
@@ -329,6 +334,8 @@ namespace rsx
 			capture::capture_draw_memory(this);
 
 		in_begin_end = false;
+		performance_counters.draw_calls++;
+		perf::rsx_draw_calls.add();
 
 		m_graphics_state |= rsx::pipeline_state::framebuffer_reads_dirty;
 		ROP_sync_timestamp = get_system_time();
@@ -375,6 +382,23 @@ namespace rsx
 			}
 		}
 
+		if (g_cfg.video.perf_overlay.frame_timing_log)
+		{
+			const std::string log_path = fs::get_config_dir() + "rsx_frame_timings.csv";
+
+			if (frame_timing_log.open(log_path, fs::rewrite))
+			{
+				frame_timing_log.write("fifo_ms,programs_ms,vertex_upload_ms,texture_upload_ms,surface_setup_ms,submit_ms,flip_ms,local_task_ms\n"s);
+			}
+			else
+			{
+				LOG_ERROR(RSX, "Failed to open frame timing log '%s' (%s)", log_path, fs::g_tls_error);
+			}
+		}
+
+		frame_timers_enabled = frame_timing_log ||
+			(supports_native_ui && g_cfg.video.perf_overlay.perf_overlay_enabled && g_cfg.video.perf_overlay.level == detail_level::extreme);
+
 		on_init_thread();
 
 		reset();
@@ -521,7 +545,10 @@ namespace rsx
 			}
 
 			//Execute backend-local tasks first
-			do_local_task(performance_counters.state);
+			{
+				frame_timer_scope timer(this, frame_timer::local_task);
+				do_local_task(performance_counters.state);
+			}
 
 			//Update sub-units
 			zcull_ctrl->update(this);
@@ -572,10 +599,19 @@ namespace rsx
 					performance_counters.FIFO_idle_timestamp = get_system_time();
 					performance_counters.state = FIFO_state::empty;
 				}
+				else if (g_cfg.video.fifo_idle_sleep && performance_counters.state != FIFO_state::spinning && !has_deferred_call && !zcull_ctrl->has_pending() &&
+					get_system_time() - performance_counters.FIFO_idle_timestamp >= fifo_idle_spin_time)
+				{
+					// Short gaps between flushes are still caught by spinning. After that, sleep until fifo_wake().
+					// Guest code storing to put directly can't be observed, it's picked up when the wait times out.
+					thread_ctrl::wait_for(fifo_idle_wait_time);
+				}
 
 				continue;
 			}
 
+			frame_timer_scope fifo_timer(this, frame_timer::fifo);
+
 			// Validate put and get registers before reading the command
 			// TODO: Who should handle graphics exceptions??
 			u32 cmd;
@@ -735,13 +771,62 @@ namespace rsx
 				performance_counters.state = FIFO_state::running;
 			}
 
+			const bool non_increment = (cmd & RSX_METHOD_NON_INCREMENT_CMD_MASK) == RSX_METHOD_NON_INCREMENT_CMD;
+
+			// Runs of pure register writes (no method handlers) are applied in bulk when nothing needs to observe them one by one
+			if (count && !capture_current_frame && !(has_deferred_call && supports_multidraw && !g_cfg.video.disable_FIFO_reordering))
+			{
+				const u32 span = non_increment ? 1 : count;
+
+				if (first_cmd + span <= methods.size() && std::none_of(methods.begin() + first_cmd, methods.begin() + first_cmd + span, [](rsx_method_t method) { return method != nullptr; }))
+				{
+					if (non_increment)
+					{
+						method_registers.decode(first_cmd, args[count - 1]);
+					}
+					else
+					{
+						method_registers.decode(first_cmd, args.get_ptr(), count);
+					}
+
+					internal_get += (count + 1) * 4;
+					continue;
+				}
+
+				// Inline vertex data is appended in one block, already in the layout copied to the attribute heap at draw time
+				if (first_cmd == NV4097_INLINE_ARRAY && non_increment)
+				{
+					auto& inline_array = method_registers.current_draw_clause.inline_vertex_array;
+					const std::size_t start = inline_array.size();
+					inline_array.resize(start + count);
+
+					const be_t<u32>* src = args.get_ptr();
+
+					for (u32 i = 0; i < count; i++)
+					{
+						inline_array[start + i] = src[i];
+					}
+
+					method_registers.decode(first_cmd, args[count - 1]);
+					method_registers.current_draw_clause.command = rsx::draw_command::inlined_array;
+
+					internal_get += (count + 1) * 4;
+					continue;
+				}
+			}
+
 			for (u32 i = 0; i < count; i++)
 			{
-				u32 reg = ((cmd & RSX_METHOD_NON_INCREMENT_CMD_MASK) == RSX_METHOD_NON_INCREMENT_CMD) ? first_cmd : first_cmd + i;
+				u32 reg = non_increment ? first_cmd : first_cmd + i;
 				u32 value = args[i];
 
 				bool execute_method_call = true;
 
+				if (reg == NV4097_SET_BEGIN_END && !value)
+				{
+					performance_counters.guest_draw_calls++;
+				}
+
 				//TODO: Flatten draw calls when multidraw is not supported to simplify checking in the end() methods
 				if (supports_multidraw && !g_cfg.video.disable_FIFO_reordering)
 				{
@@ -959,6 +1044,8 @@ namespace rsx
 
 	void thread::on_exit()
 	{
+		LOG_NOTICE(RSX, "Draw calls: %llu submitted, %llu issued to the backend", performance_counters.guest_draw_calls.load(), performance_counters.draw_calls.load());
+
 		m_rsx_thread_exiting = true;
 		if (m_vblank_thread)
 		{
@@ -1398,7 +1485,14 @@ namespace rsx
 		if (!(m_graphics_state & rsx::pipeline_state::vertex_program_dirty))
 			return;
 
+		frame_timer_scope timer(this, frame_timer::programs);
+
 		m_graphics_state &= ~(rsx::pipeline_state::vertex_program_dirty);
+
+		// Lets the program caches skip hashing while the transform program registers are untouched
+		if (++current_vertex_program.revision == 0)
+			current_vertex_program.revision = 1;
+
 		const u32 transform_program_start = rsx::method_registers.transform_program_start();
 		current_vertex_program.output_mask = rsx::method_registers.vertex_attrib_output_mask();
 		current_vertex_program.skip_vertex_input_check = false;
@@ -1613,6 +1707,8 @@ namespace rsx
 		if (!(m_graphics_state & rsx::pipeline_state::fragment_program_dirty))
 			return;
 
+		frame_timer_scope timer(this, frame_timer::programs);
+
 		m_graphics_state &= ~(rsx::pipeline_state::fragment_program_dirty);
 		auto &result = current_fragment_program = {};
 
@@ -1859,6 +1955,10 @@ namespace rsx
 	void thread::reset()
 	{
 		rsx::method_registers.reset();
+
+		m_graphics_state |= rsx::pipeline_state::transform_constants_dirty;
+		m_transform_constants_dirty_begin = 0;
+		m_transform_constants_dirty_end = 468;
 	}
 
 	void thread::init(u32 ioAddress, u32 ioSize, u32 ctrlAddress, u32 localAddress)
@@ -2267,6 +2367,30 @@ namespace rsx
 		performance_counters.sampled_frames++;
 	}
 
+	void thread::end_frame_timers()
+	{
+		if (!frame_timers_enabled)
+			return;
+
+		auto& counters = performance_counters;
+		for (u32 i = 0; i < (u32)frame_timer::count; ++i)
+		{
+			counters.last_frame_time[i] = counters.frame_time[i].exchange(0);
+		}
+
+		if (frame_timing_log)
+		{
+			std::string line;
+			for (const u64 time : counters.last_frame_time)
+			{
+				fmt::append(line, "%s%.3f", line.empty() ? "" : ",", time / 1000000.);
+			}
+
+			line += '\n';
+			frame_timing_log.write(line);
+		}
+	}
+
 	void thread::check_zcull_status(bool framebuffer_swap)
 	{
 		if (g_cfg.video.disable_zcull_queries)
@@ -2380,14 +2504,19 @@ namespace rsx
 			}
 		}
 
-		writer_lock lock(m_mtx_task);
-		m_invalidated_memory_ranges.push_back({ base_address, size });
+		{
+			writer_lock lock(m_mtx_task);
+			m_invalidated_memory_ranges.push_back({ base_address, size });
+		}
+
+		fifo_wake();
 	}
 
 	//Pause/cont wrappers for FIFO ctrl. Never call this from rsx thread itself!
 	void thread::pause()
 	{
 		external_interrupt_lock.store(true);
+		fifo_wake();
 		while (!external_interrupt_ack.load())
 		{
 			if (Emu.IsStopped())
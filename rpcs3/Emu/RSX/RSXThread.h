@@ -149,7 +149,8 @@ namespace rsx
 
 	struct draw_inlined_array
 	{
-		std::vector<u32> inline_vertex_array;
+		// Refers to the current draw clause, valid until the next draw
+		gsl::span<const u32> inline_vertex_array;
 	};
 
 	struct interleaved_range_info
@@ -272,6 +273,21 @@ namespace rsx
 
 	struct sampled_image_descriptor_base;
 
+	// Subsystems timed per frame for the extreme perf overlay level and the frame timing log
+	enum class frame_timer : u32
+	{
+		fifo,           // FIFO processing, inclusive of everything dispatched from it
+		programs,       // Vertex and fragment program lookup
+		vertex_upload,
+		texture_upload,
+		surface_setup,
+		submit,
+		flip,
+		local_task,
+
+		count
+	};
+
 	class thread : public named_thread
 	{
 		std::shared_ptr<thread_ctrl> m_vblank_thread;
@@ -319,9 +335,27 @@ namespace rsx
 			FIFO_state state = FIFO_state::running;
 			u32 approximate_load = 0;
 			u32 sampled_frames = 0;
+			atomic_t<u64> draw_calls{ 0 };       // Draw calls issued to the backend
+			atomic_t<u64> guest_draw_calls{ 0 }; // Draw calls submitted by the guest (before FIFO reordering merges them)
+			atomic_t<u64> skipped_draw_calls{ 0 }; // Draw calls dropped while their pipeline was compiling asynchronously
+			atomic_t<u32> pending_pipelines{ 0 }; // Pipelines currently queued for asynchronous compilation
+			atomic_t<u64> heap_size{ 0 };          // Combined size of the backend upload heaps in bytes
+			atomic_t<u64> heap_high_water{ 0 };    // Combined peak usage of the backend upload heaps in bytes
+			atomic_t<u64> heap_forced_flushes{ 0 }; // GPU waits forced by a full upload heap
+			atomic_t<u64> cpu_blits{ 0 };          // Blit engine transfers processed on the CPU
+			atomic_t<u64> cpu_blit_time{ 0 };      // Time spent in CPU blits in microseconds
+			atomic_t<u64> flips{ 0 };              // Frames flipped since the renderer started
+			atomic_t<u64> last_flip_timestamp{ 0 }; // Host time of the last flip in microseconds (set before flips is incremented)
+			u64 last_flip_draw_calls = 0;           // Value of draw_calls at the last flip
+			std::array<atomic_t<u64>, (u32)frame_timer::count> frame_time{};      // Per-subsystem time of the current frame in nanoseconds
+			std::array<u64, (u32)frame_timer::count> last_frame_time{};           // Per-subsystem time of the last completed frame in nanoseconds
 		}
 		performance_counters;
 
+		// Frame timers are only sampled when something consumes them
+		bool frame_timers_enabled = false;
+		fs::file frame_timing_log;
+
 		// Native UI interrupts
 		atomic_t<bool> native_ui_flip_request{ false };
 
@@ -360,6 +394,9 @@ namespace rsx
 		bool m_vertex_textures_dirty[4];
 		bool m_framebuffer_state_contested = false;
 		u32  m_graphics_state = 0;
+		// Transform constant registers [begin, end) written since the backend last uploaded them
+		u32  m_transform_constants_dirty_begin = 0;
+		u32  m_transform_constants_dirty_end = 468;
 		u64  ROP_sync_timestamp = 0;
 
 	protected:
@@ -394,6 +431,7 @@ namespace rsx
 		u64 start_rsx_time = 0;
 		u64 int_flip_index = 0;
 		u64 last_flip_time;
+		u64 last_memory_log_time = 0;
 		vm::ptr<void(u32)> flip_handler = vm::null;
 		vm::ptr<void(u32)> user_handler = vm::null;
 		vm::ptr<void(u32)> vblank_handler = vm::null;
@@ -586,7 +624,48 @@ namespace rsx
 		void pause();
 		void unpause();
 
+		// Wake the RSX thread if it sleeps on an empty FIFO (put update or a request for the backend, any thread)
+		void fifo_wake()
+		{
+			if (const auto thread = get())
+			{
+				thread->notify();
+			}
+		}
+
 		//Get RSX approximate load in %
 		u32 get_load();
+
+		void add_frame_time(frame_timer timer, steady_clock::duration duration)
+		{
+			if (frame_timers_enabled)
+				performance_counters.frame_time[(u32)timer] += std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+		}
+
+		// Latch the current frame timers and append them to the frame timing log
+		void end_frame_timers();
+	};
+
+	// Adds the lifetime of the scope to a frame timer
+	class frame_timer_scope
+	{
+		thread* m_rsx;
+		frame_timer m_timer;
+		steady_clock::time_point m_start;
+
+	public:
+		frame_timer_scope(thread* rsx, frame_timer timer)
+			: m_rsx(rsx->frame_timers_enabled ? rsx : nullptr)
+			, m_timer(timer)
+		{
+			if (m_rsx)
+				m_start = steady_clock::now();
+		}
+
+		~frame_timer_scope()
+		{
+			if (m_rsx)
+				m_rsx->add_frame_time(m_timer, steady_clock::now() - m_start);
+		}
 	};
 }
@@ -229,4 +229,7 @@ struct RSXVertexProgram
 	std::vector<rsx_vertex_input> rsx_vertex_inputs;
 	u32 output_mask;
 	bool skip_vertex_input_check;
+
+	// Bumped by the RSX thread whenever it rebuilds the program. 0 means untracked. Not part of the key.
+	u32 revision = 0;
 };
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "VKCommonDecompiler.h"
+#include "Emu/RSX/rsx_cache.h"
 #include "restore_new.h"
 #include "SPIRV/GlslangToSpv.h"
 #include "define_new_memleakdetect.h"
@@ -138,8 +139,22 @@ namespace vk
 		fmt::throw_exception("Unknown register name: %s" HERE, name);
 	}
 
+	// Compiled SPIR-V keyed by the GLSL source, shaders cache boots skip glslang entirely (bump the version when the glslang options change)
+	static rsx::binary_cache g_spirv_cache("spirv.pack", 0x4B434150565053ull /* "SPVPACK" */, 2);
+
 	bool compile_glsl_to_spv(std::string& shader, program_domain domain, std::vector<u32>& spv)
 	{
+		// glslang is thread-safe after initialize_compiler_context, the shaders cache compiles on several workers
+		const auto key = rsx::binary_cache::get_key(shader, domain * 2);
+
+		std::vector<u8> blob;
+		if (g_spirv_cache.load(key, blob))
+		{
+			spv.resize(blob.size() / 4);
+			std::memcpy(spv.data(), blob.data(), spv.size() * 4);
+			return true;
+		}
+
 		EShLanguage lang = (domain == glsl_fragment_program) ? EShLangFragment :
 			(domain == glsl_vertex_program)? EShLangVertex : EShLangCompute;
 
@@ -166,6 +181,7 @@ namespace vk
 				options.disableOptimizer = false;
 				options.optimizeSize = true;
 				glslang::GlslangToSpv(*program.getIntermediate(lang), spv, &options);
+				g_spirv_cache.store(key, spv.data(), ::size32(spv) * 4);
 			}
 		}
 		else
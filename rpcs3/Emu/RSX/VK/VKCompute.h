@@ -95,6 +95,11 @@ namespace vk
 			}
 		}
 
+		bool has_free_descriptors() const
+		{
+			return m_used_descriptors < 120;
+		}
+
 		void free_resources()
 		{
 			if (m_used_descriptors == 0)
@@ -337,6 +342,246 @@ namespace vk
 		}
 	};
 
+	struct cs_expand_index_base : compute_task
+	{
+		vk::buffer* m_data;
+		u32 m_data_offset = 0;
+		u32 m_data_length = 0;
+
+		// Writes one u32 index per invocation; the expression is evaluated with 'index' as the output slot
+		void build(const char* expression)
+		{
+			create();
+
+			m_src =
+			{
+				"#version 430\n"
+				"layout(local_size_x=%ws, local_size_y=1, local_size_z=1) in;\n"
+				"layout(std430, set=0, binding=0) buffer ssbo{ uint data[]; };\n"
+				"\n"
+				"void main()\n"
+				"{\n"
+				"	uint index = gl_GlobalInvocationID.x;\n"
+				"	if (index >= data.length()) return;\n"
+				"	data[index] = %f;\n"
+				"}\n"
+			};
+
+			const std::pair<std::string, std::string> syntax_replace[] =
+			{
+				{ "%ws", std::to_string(optimal_group_size) },
+				{ "%f", expression }
+			};
+
+			m_src = fmt::replace_all(m_src, syntax_replace);
+		}
+
+		void bind_resources() override
+		{
+			m_program->bind_buffer({ m_data->value, m_data_offset, m_data_length }, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_descriptor_set);
+		}
+
+		void run(VkCommandBuffer cmd, vk::buffer* data, u32 index_count, u32 data_offset = 0)
+		{
+			m_data = data;
+			m_data_offset = data_offset;
+			m_data_length = index_count * 4;
+
+			const auto num_invocations = align(index_count, optimal_group_size) / optimal_group_size;
+			compute_task::run(cmd, num_invocations);
+		}
+	};
+
+	struct cs_expand_line_loop : cs_expand_index_base
+	{
+		// 0, 1, ..., n-1, 0
+		cs_expand_line_loop()
+		{
+			cs_expand_index_base::build("(index == data.length() - 1)? 0 : index");
+		}
+	};
+
+	struct cs_expand_triangle_fan : cs_expand_index_base
+	{
+		// Triangle fans and polygons: (0, i+1, i+2)
+		cs_expand_triangle_fan()
+		{
+			cs_expand_index_base::build("((index % 3) == 0)? 0 : (index / 3) + (index % 3)");
+		}
+	};
+
+	struct cs_expand_quads : cs_expand_index_base
+	{
+		// (4i, 4i+1, 4i+2, 4i+2, 4i+3, 4i); 0x3A4 packs the 2-bit offsets {0, 1, 2, 2, 3, 0}
+		cs_expand_quads()
+		{
+			cs_expand_index_base::build("(index / 6) * 4 + ((0x3A4 >> ((index % 6) * 2)) & 3)");
+		}
+	};
+
+	struct cs_deswizzle_base : compute_task
+	{
+		vk::buffer* m_data;
+		u32 m_data_offset = 0;
+		u32 m_data_length = 0;
+
+		// Expects a header of 8 words at the start of the bound range:
+		// { words per row, row count, log2 of the smaller dimension, dst offset in words, dst pitch in words }
+		// followed by the raw swizzled guest data. Each invocation writes one word of linear output.
+		void build(const char* function_name, u32 texel_shift)
+		{
+			create();
+
+			m_src =
+			{
+				"#version 430\n"
+				"layout(local_size_x=%ws, local_size_y=1, local_size_z=1) in;\n"
+				"layout(std430, set=0, binding=0) buffer ssbo{ uint data[]; };\n"
+				"\n"
+				"#define TEXEL_SHIFT %ts\n"
+				"#define bswap_u16(bits) (bits & 0xFF) << 8 | (bits & 0xFF00) >> 8 | (bits & 0xFF0000) << 8 | (bits & 0xFF000000) >> 8\n"
+				"#define passthrough(bits) bits\n"
+				"\n"
+				"uint spread_bits(uint x)\n"
+				"{\n"
+				"	x = (x | (x << 8)) & 0x00FF00FF;\n"
+				"	x = (x | (x << 4)) & 0x0F0F0F0F;\n"
+				"	x = (x | (x << 2)) & 0x33333333;\n"
+				"	x = (x | (x << 1)) & 0x55555555;\n"
+				"	return x;\n"
+				"}\n"
+				"\n"
+				"uint get_swizzled_offset(uint x, uint y, uint limit)\n"
+				"{\n"
+				"	// Bits of both axes interleave up to the smaller dimension, the rest of the larger one is appended above\n"
+				"	uint mask = (1 << limit) - 1;\n"
+				"	uint low = spread_bits(x & mask) | (spread_bits(y & mask) << 1);\n"
+				"	uint high = (x >> limit) | (y >> limit);\n"
+				"	return low | (high << (limit << 1));\n"
+				"}\n"
+				"\n"
+				"void main()\n"
+				"{\n"
+				"	uint words_per_row = data[0];\n"
+				"	uint index = gl_GlobalInvocationID.x;\n"
+				"	if (index >= words_per_row * data[1]) return;\n"
+				"\n"
+				"	uint y = index / words_per_row;\n"
+				"	uint x = index % words_per_row;\n"
+				"\n"
+				"	// Horizontally adjacent texel pairs are contiguous in the swizzled layout, so sub-word texels move as whole words\n"
+				"	uint src = get_swizzled_offset(x << TEXEL_SHIFT, y, data[2]) >> TEXEL_SHIFT;\n"
+				"	uint value = data[8 + src];\n"
+				"	data[data[3] + y * data[4] + x] = %f(value);\n"
+				"}\n"
+			};
+
+			const std::pair<std::string, std::string> syntax_replace[] =
+			{
+				{ "%ws", std::to_string(optimal_group_size) },
+				{ "%ts", std::to_string(texel_shift) },
+				{ "%f", function_name }
+			};
+
+			m_src = fmt::replace_all(m_src, syntax_replace);
+		}
+
+		void bind_resources() override
+		{
+			m_program->bind_buffer({ m_data->value, m_data_offset, m_data_length }, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_descriptor_set);
+		}
+
+		void run(VkCommandBuffer cmd, vk::buffer* data, u32 data_length, u32 word_count, u32 data_offset = 0)
+		{
+			m_data = data;
+			m_data_offset = data_offset;
+			m_data_length = data_length;
+
+			const auto num_invocations = align(word_count, optimal_group_size) / optimal_group_size;
+			compute_task::run(cmd, num_invocations);
+		}
+	};
+
+	struct cs_deswizzle_32 : cs_deswizzle_base
+	{
+		// 32-bit texels stored in host order
+		cs_deswizzle_32()
+		{
+			cs_deswizzle_base::build("passthrough", 0);
+		}
+	};
+
+	struct cs_deswizzle_16 : cs_deswizzle_base
+	{
+		// Big-endian 16-bit texels
+		cs_deswizzle_16()
+		{
+			cs_deswizzle_base::build("bswap_u16", 1);
+		}
+	};
+
+	struct cs_tile_32 : compute_task
+	{
+		vk::buffer* m_data;
+		u32 m_data_offset = 0;
+		u32 m_data_length = 0;
+
+		// Expects a header of 8 words at the start of the bound range:
+		// { texels per row, row count, src offset in words, dst offset in words, dst pitch in words, repeat, dst length in words }
+		// followed by the linear 32-bit image. Each invocation writes one texel of the tiled layout, where compressed tiles
+		// store every texel repeated over a square block (see rsx::tiled_region::write).
+		cs_tile_32()
+		{
+			create();
+
+			m_src =
+			{
+				"#version 430\n"
+				"layout(local_size_x=%ws, local_size_y=1, local_size_z=1) in;\n"
+				"layout(std430, set=0, binding=0) buffer ssbo{ uint data[]; };\n"
+				"\n"
+				"void main()\n"
+				"{\n"
+				"	uint repeat = data[5];\n"
+				"	uint words_per_row = data[0] * repeat;\n"
+				"	uint index = gl_GlobalInvocationID.x;\n"
+				"	if (index >= words_per_row * data[1] * repeat) return;\n"
+				"\n"
+				"	uint y = index / words_per_row;\n"
+				"	uint x = index % words_per_row;\n"
+				"\n"
+				"	// Rows past the end of the section are dropped\n"
+				"	uint dst = y * data[4] + x;\n"
+				"	if (dst >= data[6]) return;\n"
+				"\n"
+				"	data[data[3] + dst] = data[data[2] + (y / repeat) * data[0] + (x / repeat)];\n"
+				"}\n"
+			};
+
+			const std::pair<std::string, std::string> syntax_replace[] =
+			{
+				{ "%ws", std::to_string(optimal_group_size) }
+			};
+
+			m_src = fmt::replace_all(m_src, syntax_replace);
+		}
+
+		void bind_resources() override
+		{
+			m_program->bind_buffer({ m_data->value, m_data_offset, m_data_length }, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_descriptor_set);
+		}
+
+		void run(VkCommandBuffer cmd, vk::buffer* data, u32 data_length, u32 texel_count, u32 data_offset = 0)
+		{
+			m_data = data;
+			m_data_offset = data_offset;
+			m_data_length = data_length;
+
+			const auto num_invocations = align(texel_count, optimal_group_size) / optimal_group_size;
+			compute_task::run(cmd, num_invocations);
+		}
+	};
+
 	// TODO: Replace with a proper manager
 	extern std::unordered_map<u32, std::unique_ptr<vk::compute_task>> g_compute_tasks;
 
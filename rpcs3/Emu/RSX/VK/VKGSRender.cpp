@@ -4,6 +4,7 @@
 #include "VKGSRender.h"
 #include "../rsx_methods.h"
 #include "../rsx_utils.h"
+#include "Utilities/tracing.h"
 #include "../Common/BufferUtils.h"
 #include "VKFormats.h"
 #include "VKCommonDecompiler.h"
@@ -29,6 +30,23 @@ namespace
 		}
 		fmt::throw_exception("Unknown depth format" HERE);
 	}
+
+	// Driver pipeline cache blob, stored per title and keyed by the driver's cache UUID
+	std::string get_pipeline_cache_path(const vk::physical_device& gpu)
+	{
+		if (g_cfg.video.disable_on_disk_shader_cache || Emu.GetCachePath() == "")
+			return{};
+
+		std::string uuid;
+		for (const u8 byte : gpu.get_properties().pipelineCacheUUID)
+			uuid += fmt::format("%02x", byte);
+
+		const std::string directory_path = Emu.GetCachePath() + "/shaders_cache/pipelines/vulkan";
+		if (!fs::is_dir(directory_path))
+			fs::create_path(directory_path);
+
+		return directory_path + "/driver_cache_" + uuid + ".bin";
+	}
 }
 
 namespace vk
@@ -329,7 +347,9 @@ namespace vk
 
 namespace
 {
-	VkRenderPass precompute_render_pass(VkDevice dev, VkFormat color_format, u8 number_of_color_surface, VkFormat depth_format)
+	//Bits 0-3 of clear_mask clear the color attachments on load, bits 4 and 5 the depth and stencil aspects
+	//Load and store ops don't take part in render pass compatibility, so all variants work with the same pipelines and framebuffers
+	VkRenderPass precompute_render_pass(VkDevice dev, VkFormat color_format, u8 number_of_color_surface, VkFormat depth_format, u32 clear_mask = 0)
 	{
 		// Some driver crashes when using empty render pass
 		if (number_of_color_surface == 0 && depth_format == VK_FORMAT_UNDEFINED)
@@ -350,6 +370,7 @@ namespace
 
 		for (u32 i = 0; i < number_of_color_surface; ++i)
 		{
+			color_attachment_description.loadOp = (clear_mask & (1u << i)) ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
 			attachments.push_back(color_attachment_description);
 			attachment_references.push_back({ i, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
 		}
@@ -359,10 +380,20 @@ namespace
 			VkAttachmentDescription depth_attachment_description = {};
 			depth_attachment_description.format = depth_format;
 			depth_attachment_description.samples = VK_SAMPLE_COUNT_1_BIT;
-			depth_attachment_description.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			depth_attachment_description.loadOp = (clear_mask & 0x10) ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
 			depth_attachment_description.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-			depth_attachment_description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
-			depth_attachment_description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+			if (vk::get_aspect_flags(depth_format) & VK_IMAGE_ASPECT_STENCIL_BIT)
+			{
+				depth_attachment_description.stencilLoadOp = (clear_mask & 0x20) ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+				depth_attachment_description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+			}
+			else
+			{
+				//No stencil to preserve
+				depth_attachment_description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				depth_attachment_description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			}
 			depth_attachment_description.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 			depth_attachment_description.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 			attachments.push_back(depth_attachment_description);
@@ -572,11 +603,21 @@ VKGSRender::VKGSRender() : GSRender()
 	m_render_passes = get_precomputed_render_passes(*m_device, m_device->get_formats_support());
 	std::tie(pipeline_layout, descriptor_layouts) = get_shared_pipeline_layout(*m_device);
 
+	if (g_cfg.video.vk.multithreaded_recording)
+	{
+		const u32 worker_count = std::clamp(std::thread::hardware_concurrency() / 4, 2u, 4u);
+		m_draw_recorder = std::make_unique<parallel_draw_recorder>();
+		m_draw_recorder->create(*m_device, pipeline_layout, worker_count);
+	}
+
 	//Occlusion
 	m_occlusion_query_pool.create((*m_device), DESCRIPTOR_MAX_DRAW_CALLS); //Enough for 4k draw calls per pass
 	for (int n = 0; n < 128; ++n)
 		m_occlusion_query_data[n].driver_handle = n;
 
+	//One pair of timestamps per primary command buffer
+	m_gpu_timer.create(*m_device, VK_MAX_ASYNC_CB_COUNT);
+
 	//Generate frame contexts
 	VkDescriptorPoolSize uniform_buffer_pool = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER , 3 * DESCRIPTOR_MAX_DRAW_CALLS };
 	VkDescriptorPoolSize uniform_texel_pool = { VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER , 16 * DESCRIPTOR_MAX_DRAW_CALLS };
@@ -591,7 +632,7 @@ VKGSRender::VKGSRender() : GSRender()
 	m_attrib_ring_info.create(VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT, VK_ATTRIB_RING_BUFFER_SIZE_M * 0x100000, "attrib buffer", 0x400000);
 	m_uniform_buffer_ring_info.create(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_UBO_RING_BUFFER_SIZE_M * 0x100000, "uniform buffer");
 	m_transform_constants_ring_info.create(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_TRANSFORM_CONSTANTS_BUFFER_SIZE_M * 0x100000, "transform constants buffer");
-	m_index_buffer_ring_info.create(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_INDEX_RING_BUFFER_SIZE_M * 0x100000, "index buffer");
+	m_index_buffer_ring_info.create(VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_INDEX_RING_BUFFER_SIZE_M * 0x100000, "index buffer");
 	m_texture_upload_buffer_ring_info.create(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_TEXTURE_UPLOAD_RING_BUFFER_SIZE_M * 0x100000, "texture upload buffer", 32 * 0x100000);
 
 	for (auto &ctx : frame_context_storage)
@@ -624,7 +665,7 @@ VKGSRender::VKGSRender() : GSRender()
 	if (g_cfg.video.disable_vertex_cache)
 		m_vertex_cache.reset(new vk::null_vertex_cache());
 	else
-		m_vertex_cache.reset(new vk::weak_vertex_cache());
+		m_vertex_cache.reset(new vk::weak_vertex_cache(VK_ATTRIB_RING_BUFFER_SIZE_M * 0x100000 / 4));
 
 	m_shaders_cache.reset(new vk::shader_cache(*m_prog_buffer.get(), "vulkan", "v1.3"));
 
@@ -637,19 +678,28 @@ VKGSRender::VKGSRender() : GSRender()
 		VkClearColorValue clear_color{};
 		VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
 
-		vk::change_image_layout(*m_current_command_buffer, target_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, range);
-		vkCmdClearColorImage(*m_current_command_buffer, target_image, VK_IMAGE_LAYOUT_GENERAL, &clear_color, 1, &range);
-		vk::change_image_layout(*m_current_command_buffer, target_image, VK_IMAGE_LAYOUT_GENERAL, target_layout, range);
+		vk::change_image_layout(get_primary_command_buffer(), target_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, range);
+		vkCmdClearColorImage(get_primary_command_buffer(), target_image, VK_IMAGE_LAYOUT_GENERAL, &clear_color, 1, &range);
+		vk::change_image_layout(get_primary_command_buffer(), target_image, VK_IMAGE_LAYOUT_GENERAL, target_layout, range);
 
 	}
 
 	m_current_frame = &frame_context_storage[0];
 
+	if (m_swapchain->get_transfer_queue() != VK_NULL_HANDLE)
+	{
+		m_transfer_queue = std::make_unique<vk::async_transfer_queue>();
+		m_transfer_queue->create(*m_device, m_swapchain->get_transfer_queue());
+	}
+
 	m_texture_cache.initialize((*m_device), m_swapchain->get_graphics_queue(),
-			m_texture_upload_buffer_ring_info);
+			m_texture_upload_buffer_ring_info, m_transfer_queue.get());
 
 	m_ui_renderer.reset(new vk::ui_overlay_renderer());
-	m_ui_renderer->create(*m_current_command_buffer, m_texture_upload_buffer_ring_info);
+	m_ui_renderer->create(get_primary_command_buffer(), m_texture_upload_buffer_ring_info);
+
+	//Created ahead, its first use would otherwise record a layout change inside a render pass
+	vk::null_image_view(get_primary_command_buffer());
 
 	supports_multidraw = true;
 	supports_native_ui = (bool)g_cfg.misc.use_native_interface;
@@ -671,6 +721,11 @@ VKGSRender::~VKGSRender()
 
 	//Shaders
 	vk::finalize_compiler_context();
+
+	const std::string pipeline_cache_path = get_pipeline_cache_path(m_device->gpu());
+	if (!pipeline_cache_path.empty())
+		m_prog_buffer->save_pipeline_cache(pipeline_cache_path);
+
 	m_prog_buffer->clear();
 
 	m_persistent_attribute_storage.reset();
@@ -716,11 +771,19 @@ VKGSRender::~VKGSRender()
 
 	m_draw_fbo.reset();
 
+	//Imported local memory, all views referencing it are gone by now
+	m_local_memory_buffer.reset();
+
 	//Render passes
 	for (auto &render_pass : m_render_passes)
 		if (render_pass)
 			vkDestroyRenderPass(*m_device, render_pass, nullptr);
 
+	for (auto &render_pass : m_clear_render_passes)
+		vkDestroyRenderPass(*m_device, render_pass.second, nullptr);
+
+	m_clear_render_passes.clear();
+
 	//Textures
 	m_rtts.destroy();
 	m_texture_cache.destroy();
@@ -753,6 +816,7 @@ VKGSRender::~VKGSRender()
 
 	//Queries
 	m_occlusion_query_pool.destroy();
+	m_gpu_timer.destroy();
 
 	//Command buffer
 	for (auto &cb : m_primary_cb_list)
@@ -763,6 +827,18 @@ VKGSRender::~VKGSRender()
 	m_secondary_command_buffer.destroy();
 	m_secondary_command_buffer_pool.destroy();
 
+	if (m_draw_recorder)
+	{
+		m_draw_recorder->destroy();
+		m_draw_recorder.reset();
+	}
+
+	if (m_transfer_queue)
+	{
+		m_transfer_queue->destroy();
+		m_transfer_queue.reset();
+	}
+
 	//Device handles/contexts
 	m_swapchain->destroy();
 	m_thread_context.close();
@@ -775,6 +851,9 @@ VKGSRender::~VKGSRender()
 
 bool VKGSRender::on_access_violation(u32 address, bool is_writing)
 {
+	tracing::scope trace(tracing::category::rsx, "flush");
+	trace.set_arg("address", address);
+
 	vk::texture_cache::thrashed_set result;
 	{
 		std::lock_guard<shared_mutex> lock(m_secondary_cb_guard);
@@ -807,6 +886,7 @@ bool VKGSRender::on_access_violation(u32 address, bool is_writing)
 
 			m_flush_requests.post(sync_timestamp == 0ull);
 			has_queue_ref = true;
+			fifo_wake();
 		}
 		else
 		{
@@ -876,26 +956,49 @@ void VKGSRender::notify_tile_unbound(u32 tile)
 	}
 }
 
+std::array<vk::vk_data_heap*, 5> VKGSRender::get_upload_heaps()
+{
+	return{ &m_attrib_ring_info, &m_texture_upload_buffer_ring_info, &m_uniform_buffer_ring_info, &m_transform_constants_ring_info, &m_index_buffer_ring_info };
+}
+
 void VKGSRender::check_heap_status()
 {
-	if (m_attrib_ring_info.is_critical() ||
-		m_texture_upload_buffer_ring_info.is_critical() ||
-		m_uniform_buffer_ring_info.is_critical() ||
-		m_transform_constants_ring_info.is_critical() ||
-		m_index_buffer_ring_info.is_critical())
+	const auto heaps = get_upload_heaps();
+
+	u32 critical_mask = 0;
+	u32 grow_mask = 0;
+	for (u32 index = 0; index < heaps.size(); ++index)
+	{
+		auto heap = heaps[index];
+		if (heap->is_critical())
+		{
+			heap->m_forced_flushes++;
+			critical_mask |= (1u << index);
+
+			if (heap->size() < heap->initial_size * VK_HEAP_MAX_GROWTH_FACTOR)
+				grow_mask |= (1u << index);
+		}
+	}
+
+	if (critical_mask || m_heap_shrink_pending)
 	{
 		std::chrono::time_point<steady_clock> submit_start = steady_clock::now();
 
 		frame_context_t *target_frame = nullptr;
 		u64 earliest_sync_time = UINT64_MAX;
-		for (s32 i = 0; i < VK_MAX_ASYNC_FRAMES; ++i)
+
+		// Resizing needs every heap drained, which only the full flush below guarantees
+		if (!grow_mask && !m_heap_shrink_pending)
 		{
-			auto ctx = &frame_context_storage[i];
-			if (ctx->swap_command_buffer)
+			for (s32 i = 0; i < VK_MAX_ASYNC_FRAMES; ++i)
 			{
-				if (ctx->last_frame_sync_time > m_last_heap_sync_time &&
-					ctx->last_frame_sync_time < earliest_sync_time)
-					target_frame = ctx;
+				auto ctx = &frame_context_storage[i];
+				if (ctx->swap_command_buffer)
+				{
+					if (ctx->last_frame_sync_time > m_last_heap_sync_time &&
+						ctx->last_frame_sync_time < earliest_sync_time)
+						target_frame = ctx;
+				}
 			}
 		}
 
@@ -911,6 +1014,9 @@ void VKGSRender::check_heap_status()
 			m_texture_upload_buffer_ring_info.reset_allocation_stats();
 			m_current_frame->reset_heap_ptrs();
 			m_last_heap_sync_time = get_system_time();
+			m_graphics_state |= rsx::pipeline_state::transform_constants_dirty;
+
+			resize_upload_heaps(grow_mask);
 		}
 		else
 		{
@@ -929,6 +1035,91 @@ void VKGSRender::check_heap_status()
 	}
 }
 
+void VKGSRender::resize_upload_heaps(u32 grow_mask)
+{
+	// NOTE: Only called right after a hard sync with all heaps reset, nothing in flight references the old buffers
+	const auto heaps = get_upload_heaps();
+	bool resized = false;
+
+	for (u32 index = 0; index < heaps.size(); ++index)
+	{
+		auto heap = heaps[index];
+		const size_t old_size = heap->size();
+		size_t new_size = old_size;
+
+		if (grow_mask & (1u << index))
+		{
+			new_size = std::min(old_size * 2, heap->initial_size * VK_HEAP_MAX_GROWTH_FACTOR);
+		}
+		else if (m_heap_shrink_pending && old_size > heap->initial_size && heap->m_recent_high_water_mark < old_size / 4)
+		{
+			new_size = std::max(old_size / 2, heap->initial_size);
+		}
+
+		heap->m_recent_high_water_mark = 0;
+
+		if (new_size != old_size)
+		{
+			LOG_NOTICE(RSX, "Resizing %s from %lluM to %lluM", heap->m_name, (u64)old_size / 0x100000, (u64)new_size / 0x100000);
+			heap->resize(new_size);
+			resized = true;
+		}
+	}
+
+	m_heap_shrink_pending = false;
+	m_heap_shrink_check_frames = 0;
+
+	if (resized)
+	{
+		// Cached views and descriptor info still point at the old buffers
+		if (m_persistent_attribute_storage)
+			m_current_frame->buffer_views_to_clean.push_back(std::move(m_persistent_attribute_storage));
+
+		if (m_volatile_attribute_storage)
+			m_current_frame->buffer_views_to_clean.push_back(std::move(m_volatile_attribute_storage));
+
+		m_graphics_state |= (rsx::pipeline_state::fragment_state_dirty | rsx::pipeline_state::vertex_state_dirty | rsx::pipeline_state::transform_constants_dirty);
+	}
+}
+
+void VKGSRender::update_heap_statistics()
+{
+	u64 total_size = 0;
+	u64 total_high_water = 0;
+	u64 total_forced_flushes = 0;
+	bool oversized_heaps = false;
+
+	for (const auto heap : get_upload_heaps())
+	{
+		total_size += heap->size();
+		total_high_water += heap->m_high_water_mark;
+		total_forced_flushes += heap->m_forced_flushes;
+
+		oversized_heaps |= (heap->size() > heap->initial_size && heap->m_recent_high_water_mark < heap->size() / 4);
+	}
+
+	performance_counters.heap_size = total_size;
+	performance_counters.heap_high_water = total_high_water;
+	performance_counters.heap_forced_flushes = total_forced_flushes;
+	m_heap_memory_gauge.set(total_size);
+
+	// Grown heaps that stayed mostly empty for a while are shrunk at the next heap check
+	if (++m_heap_shrink_check_frames >= VK_HEAP_SHRINK_CHECK_FRAMES)
+	{
+		m_heap_shrink_check_frames = 0;
+
+		if (oversized_heaps)
+		{
+			m_heap_shrink_pending = true;
+		}
+		else
+		{
+			for (auto heap : get_upload_heaps())
+				heap->m_recent_high_water_mark = 0;
+		}
+	}
+}
+
 void VKGSRender::begin()
 {
 	rsx::thread::begin();
@@ -949,79 +1140,92 @@ void VKGSRender::begin()
 		flush_command_queue();
 
 		CHECK_RESULT(vkResetDescriptorPool(*m_device, m_current_frame->descriptor_pool, 0));
+		m_current_frame->descriptor_cache.clear();
 		m_current_frame->used_descriptors = 0;
 	}
 
 	check_heap_status();
+}
 
-	VkDescriptorSetAllocateInfo alloc_info = {};
-	alloc_info.descriptorPool = m_current_frame->descriptor_pool;
-	alloc_info.descriptorSetCount = 1;
-	alloc_info.pSetLayouts = &descriptor_layouts;
-	alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+void VKGSRender::commit_descriptors()
+{
+	//Draws that do not change any binding reuse the set written earlier from the same pool
+	const u64 hash = m_descriptor_builder.get_hash();
+	VkDescriptorSet descriptor_set = m_current_frame->descriptor_cache.find(m_descriptor_builder, hash);
+
+	if (!descriptor_set)
+	{
+		VkDescriptorSetAllocateInfo alloc_info = {};
+		alloc_info.descriptorPool = m_current_frame->descriptor_pool;
+		alloc_info.descriptorSetCount = 1;
+		alloc_info.pSetLayouts = &descriptor_layouts;
+		alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
 
-	VkDescriptorSet new_descriptor_set;
-	CHECK_RESULT(vkAllocateDescriptorSets(*m_device, &alloc_info, &new_descriptor_set));
+		CHECK_RESULT(vkAllocateDescriptorSets(*m_device, &alloc_info, &descriptor_set));
+		m_current_frame->used_descriptors++;
 
-	m_current_frame->descriptor_set = new_descriptor_set;
-	m_current_frame->used_descriptors++;
+		m_descriptor_builder.update(*m_device, descriptor_set);
+		m_current_frame->descriptor_cache.insert(m_descriptor_builder, hash, descriptor_set);
+	}
+
+	m_current_frame->descriptor_set = descriptor_set;
 }
 
-void VKGSRender::update_draw_state()
+void VKGSRender::update_draw_state(draw_packet& packet)
 {
 	std::chrono::time_point<steady_clock> start = steady_clock::now();
 
-	float actual_line_width = rsx::method_registers.line_width();
-	vkCmdSetLineWidth(*m_current_command_buffer, actual_line_width);
+	packet.line_width = rsx::method_registers.line_width();
 
 	if (rsx::method_registers.poly_offset_fill_enabled())
 	{
 		//offset_bias is the constant factor, multiplied by the implementation factor R
 		//offst_scale is the slope factor, multiplied by the triangle slope factor M
-		vkCmdSetDepthBias(*m_current_command_buffer, rsx::method_registers.poly_offset_bias(), 0.f, rsx::method_registers.poly_offset_scale());
+		packet.depth_bias_constant = rsx::method_registers.poly_offset_bias();
+		packet.depth_bias_slope = rsx::method_registers.poly_offset_scale();
 	}
 	else
 	{
 		//Zero bias value - disables depth bias
-		vkCmdSetDepthBias(*m_current_command_buffer, 0.f, 0.f, 0.f);
+		packet.depth_bias_constant = 0.f;
+		packet.depth_bias_slope = 0.f;
 	}
 
 	//Update dynamic state
 	if (rsx::method_registers.blend_enabled())
 	{
 		//Update blend constants
-		auto blend_colors = rsx::get_constant_blend_colors();
-		vkCmdSetBlendConstants(*m_current_command_buffer, blend_colors.data());
+		packet.blend_constants = rsx::get_constant_blend_colors();
 	}
 
 	if (rsx::method_registers.stencil_test_enabled())
 	{
-		const bool two_sided_stencil = rsx::method_registers.two_sided_stencil_test_enabled();
-		VkStencilFaceFlags face_flag = (two_sided_stencil) ? VK_STENCIL_FACE_FRONT_BIT : VK_STENCIL_FRONT_AND_BACK;
-
-		vkCmdSetStencilWriteMask(*m_current_command_buffer, face_flag, rsx::method_registers.stencil_mask());
-		vkCmdSetStencilCompareMask(*m_current_command_buffer, face_flag, rsx::method_registers.stencil_func_mask());
-		vkCmdSetStencilReference(*m_current_command_buffer, face_flag, rsx::method_registers.stencil_func_ref());
+		packet.stencil_write_mask[0] = rsx::method_registers.stencil_mask();
+		packet.stencil_compare_mask[0] = rsx::method_registers.stencil_func_mask();
+		packet.stencil_reference[0] = rsx::method_registers.stencil_func_ref();
 
-		if (two_sided_stencil)
+		if (rsx::method_registers.two_sided_stencil_test_enabled())
+		{
+			packet.stencil_write_mask[1] = rsx::method_registers.back_stencil_mask();
+			packet.stencil_compare_mask[1] = rsx::method_registers.back_stencil_func_mask();
+			packet.stencil_reference[1] = rsx::method_registers.back_stencil_func_ref();
+		}
+		else
 		{
-			vkCmdSetStencilWriteMask(*m_current_command_buffer, VK_STENCIL_FACE_BACK_BIT, rsx::method_registers.back_stencil_mask());
-			vkCmdSetStencilCompareMask(*m_current_command_buffer, VK_STENCIL_FACE_BACK_BIT, rsx::method_registers.back_stencil_func_mask());
-			vkCmdSetStencilReference(*m_current_command_buffer, VK_STENCIL_FACE_BACK_BIT, rsx::method_registers.back_stencil_func_ref());
+			packet.stencil_write_mask[1] = packet.stencil_write_mask[0];
+			packet.stencil_compare_mask[1] = packet.stencil_compare_mask[0];
+			packet.stencil_reference[1] = packet.stencil_reference[0];
 		}
 	}
 
 	if (rsx::method_registers.depth_bounds_test_enabled())
 	{
 		//Update depth bounds min/max
-		vkCmdSetDepthBounds(*m_current_command_buffer, rsx::method_registers.depth_bounds_min(), rsx::method_registers.depth_bounds_max());
-	}
-	else
-	{
-		vkCmdSetDepthBounds(*m_current_command_buffer, 0.f, 1.f);
+		packet.depth_bounds_min = rsx::method_registers.depth_bounds_min();
+		packet.depth_bounds_max = rsx::method_registers.depth_bounds_max();
 	}
 
-	set_viewport();
+	set_viewport(packet);
 
 	//TODO: Set up other render-state parameters into the program pipeline
 
@@ -1032,18 +1236,68 @@ void VKGSRender::update_draw_state()
 void VKGSRender::begin_render_pass()
 {
 	if (render_pass_open)
-		return;
+	{
+		//Same attachments as the last draw, only bound and dynamic state changed since
+		if (m_render_pass_framebuffer == m_draw_fbo->value)
+			return;
+
+		close_render_pass();
+	}
+
+	//A clear pending on this framebuffer is folded into the pass, the batch is empty in that case
+	if (m_pending_clear_target != m_draw_fbo.get())
+		flush_draw_batch();
+
+	open_render_pass(*m_draw_fbo);
+}
+
+void VKGSRender::open_render_pass(vk::framebuffer_holder& fbo)
+{
+	verify(HERE), !render_pass_open;
 
 	VkRenderPassBeginInfo rp_begin = {};
 	rp_begin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	rp_begin.renderPass = m_draw_fbo->info.renderPass;
-	rp_begin.framebuffer = m_draw_fbo->value;
+	rp_begin.renderPass = fbo.info.renderPass;
+	rp_begin.framebuffer = fbo.value;
 	rp_begin.renderArea.offset.x = 0;
 	rp_begin.renderArea.offset.y = 0;
-	rp_begin.renderArea.extent.width = m_draw_fbo->width();
-	rp_begin.renderArea.extent.height = m_draw_fbo->height();
+	rp_begin.renderArea.extent.width = fbo.width();
+	rp_begin.renderArea.extent.height = fbo.height();
+
+	std::array<VkClearValue, 5> clear_values;
+
+	if (m_pending_clear_target == &fbo)
+	{
+		VkFormat color_format = VK_FORMAT_UNDEFINED;
+		VkFormat depth_format = VK_FORMAT_UNDEFINED;
+		u8 color_count = 0;
+
+		for (const auto &view : fbo.attachments)
+		{
+			if (vk::get_aspect_flags(view->info.format) & VK_IMAGE_ASPECT_COLOR_BIT)
+			{
+				color_format = view->info.format;
+				clear_values[color_count] = m_pending_clear_values[color_count];
+				color_count++;
+			}
+			else
+			{
+				depth_format = view->info.format;
+			}
+		}
+
+		clear_values[color_count] = m_pending_clear_values[4];
+
+		rp_begin.renderPass = get_clear_render_pass(color_format, color_count, depth_format, m_pending_clear_mask);
+		rp_begin.clearValueCount = (u32)fbo.attachments.size();
+		rp_begin.pClearValues = clear_values.data();
+
+		m_pending_clear_target = nullptr;
+		m_pending_clear_mask = 0;
+	}
 
 	vkCmdBeginRenderPass(*m_current_command_buffer, &rp_begin, VK_SUBPASS_CONTENTS_INLINE);
+	m_render_pass_framebuffer = fbo.value;
 	render_pass_open = true;
 }
 
@@ -1053,9 +1307,89 @@ void VKGSRender::close_render_pass()
 		return;
 
 	vkCmdEndRenderPass(*m_current_command_buffer);
+	m_render_pass_framebuffer = VK_NULL_HANDLE;
 	render_pass_open = false;
 }
 
+VkRenderPass VKGSRender::get_clear_render_pass(VkFormat color_format, u8 color_count, VkFormat depth_format, u32 clear_mask)
+{
+	const u64 key = ((u64)vk::get_render_pass_location(color_format, depth_format, color_count) << 8) | clear_mask;
+
+	auto found = m_clear_render_passes.find(key);
+	if (found != m_clear_render_passes.end())
+		return found->second;
+
+	VkRenderPass result = precompute_render_pass(*m_device, color_format, color_count, depth_format, clear_mask);
+	m_clear_render_passes[key] = result;
+	return result;
+}
+
+void VKGSRender::clear_attachments(const std::vector<VkClearAttachment>& clears, const VkClearRect& region)
+{
+	const bool full_area = region.rect.offset.x == 0 && region.rect.offset.y == 0 &&
+		region.rect.extent.width == m_draw_fbo->width() && region.rect.extent.height == m_draw_fbo->height();
+
+	if (!full_area || (render_pass_open && m_render_pass_framebuffer == m_draw_fbo->value))
+	{
+		//Partial clears and clears between draws of one pass are recorded as is, the pass stays open for the next draw
+		begin_render_pass();
+		vkCmdClearAttachments(*m_current_command_buffer, (u32)clears.size(), clears.data(), 1, &region);
+		return;
+	}
+
+	if (m_pending_clear_target != m_draw_fbo.get())
+	{
+		//The batch and a clear pending on another framebuffer come first
+		close_render_pass();
+		flush_draw_batch();
+
+		m_pending_clear_target = m_draw_fbo.get();
+	}
+
+	for (const auto &clear : clears)
+	{
+		if (clear.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT)
+		{
+			m_pending_clear_mask |= (1u << clear.colorAttachment);
+			m_pending_clear_values[clear.colorAttachment] = clear.clearValue;
+			continue;
+		}
+
+		if (clear.aspectMask & VK_IMAGE_ASPECT_DEPTH_BIT)
+		{
+			m_pending_clear_mask |= 0x10;
+			m_pending_clear_values[4].depthStencil.depth = clear.clearValue.depthStencil.depth;
+		}
+
+		if (clear.aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT)
+		{
+			m_pending_clear_mask |= 0x20;
+			m_pending_clear_values[4].depthStencil.stencil = clear.clearValue.depthStencil.stencil;
+		}
+	}
+}
+
+void VKGSRender::flush_pending_clear()
+{
+	if (!m_pending_clear_target)
+		return;
+
+	//Nothing was drawn after the clear, an empty pass still applies the load ops
+	open_render_pass(*m_pending_clear_target);
+	close_render_pass();
+}
+
+void VKGSRender::flush_draw_batch()
+{
+	flush_pending_clear();
+
+	if (m_draw_recorder && !m_draw_recorder->empty())
+	{
+		verify(HERE), !render_pass_open;
+		m_draw_recorder->flush(*m_current_command_buffer);
+	}
+}
+
 void VKGSRender::end()
 {
 	if (skip_frame || !framebuffer_status_valid || renderer_unavailable ||
@@ -1071,6 +1405,7 @@ void VKGSRender::end()
 	auto upload_info = upload_vertex_data();
 	std::chrono::time_point<steady_clock> vertex_end = steady_clock::now();
 	m_vertex_upload_time += std::chrono::duration_cast<std::chrono::microseconds>(vertex_end - vertex_start).count();
+	add_frame_time(rsx::frame_timer::vertex_upload, vertex_end - vertex_start);
 
 	std::chrono::time_point<steady_clock> textures_start = vertex_end;
 
@@ -1102,13 +1437,8 @@ void VKGSRender::end()
 
 	if (buffers_to_clear.size() > 0)
 	{
-		begin_render_pass();
-
 		VkClearRect rect = { {{0, 0}, {m_draw_fbo->width(), m_draw_fbo->height()}}, 0, 1 };
-		vkCmdClearAttachments(*m_current_command_buffer, (u32)buffers_to_clear.size(),
-			buffers_to_clear.data(), 1, &rect);
-
-		close_render_pass();
+		clear_attachments(buffers_to_clear, rect);
 	}
 
 	//Check for data casts
@@ -1119,7 +1449,7 @@ void VKGSRender::end()
 			// TODO: Partial memory transfer
 			auto rp = vk::get_render_pass_location(VK_FORMAT_UNDEFINED, ds->info.format, 0);
 			auto render_pass = m_render_passes[rp];
-			m_depth_converter->run(*m_current_command_buffer, ds->width(), ds->height(), ds,
+			m_depth_converter->run(get_primary_command_buffer(), ds->width(), ds->height(), ds,
 				static_cast<vk::render_target*>(ds->old_contents)->get_view(0xAAE4, rsx::default_remap_vector),
 				render_pass, m_framebuffers_to_clean);
 
@@ -1141,7 +1471,7 @@ void VKGSRender::end()
 
 				const VkImageAspectFlags aspect = surface->attachment_aspect_flag;
 
-				vk::copy_scaled_image(*m_current_command_buffer, surface->old_contents->value, surface->value,
+				vk::copy_scaled_image(get_primary_command_buffer(), surface->old_contents->value, surface->value,
 					surface->old_contents->current_layout, surface->current_layout, 0, 0, src_w, src_h,
 					0, 0, dst_w, dst_h, 1, aspect, true, VK_FILTER_LINEAR, surface->info.format, surface->old_contents->info.format);
 
@@ -1190,7 +1520,7 @@ void VKGSRender::end()
 
 				if (rsx::method_registers.fragment_textures[i].enabled())
 				{
-					*sampler_state = m_texture_cache._upload_texture(*m_current_command_buffer, rsx::method_registers.fragment_textures[i], m_rtts);
+					*sampler_state = m_texture_cache._upload_texture(get_primary_command_buffer(), rsx::method_registers.fragment_textures[i], m_rtts);
 
 					const u32 texture_format = rsx::method_registers.fragment_textures[i].format() & ~(CELL_GCM_TEXTURE_UN | CELL_GCM_TEXTURE_LN);
 					const VkBool32 compare_enabled = (texture_format == CELL_GCM_TEXTURE_DEPTH16 || texture_format == CELL_GCM_TEXTURE_DEPTH24_D8 ||
@@ -1262,7 +1592,7 @@ void VKGSRender::end()
 
 				if (rsx::method_registers.vertex_textures[i].enabled())
 				{
-					*sampler_state = m_texture_cache._upload_texture(*m_current_command_buffer, rsx::method_registers.vertex_textures[i], m_rtts);
+					*sampler_state = m_texture_cache._upload_texture(get_primary_command_buffer(), rsx::method_registers.vertex_textures[i], m_rtts);
 
 					bool replace = !vs_sampler_handles[i];
 					const VkBool32 unnormalized_coords = !!(rsx::method_registers.vertex_textures[i].format() & CELL_GCM_TEXTURE_UN);
@@ -1302,15 +1632,23 @@ void VKGSRender::end()
 
 	std::chrono::time_point<steady_clock> textures_end = steady_clock::now();
 	m_textures_upload_time += (u32)std::chrono::duration_cast<std::chrono::microseconds>(textures_end - textures_start).count();
+	add_frame_time(rsx::frame_timer::texture_upload, textures_end - textures_start);
 
 	//Load program
 	std::chrono::time_point<steady_clock> program_start = textures_end;
-	load_program(upload_info);
+	m_descriptor_builder.reset();
+
+	if (!load_program(upload_info))
+	{
+		performance_counters.skipped_draw_calls++;
+		rsx::thread::end();
+		return;
+	}
 
 	VkBufferView persistent_buffer = m_persistent_attribute_storage ? m_persistent_attribute_storage->value : null_buffer_view->value;
 	VkBufferView volatile_buffer = m_volatile_attribute_storage ? m_volatile_attribute_storage->value : null_buffer_view->value;
-	m_program->bind_uniform(persistent_buffer, "persistent_input_stream", m_current_frame->descriptor_set);
-	m_program->bind_uniform(volatile_buffer, "volatile_input_stream", m_current_frame->descriptor_set);
+	m_program->bind_uniform(persistent_buffer, "persistent_input_stream", m_descriptor_builder);
+	m_program->bind_uniform(volatile_buffer, "volatile_input_stream", m_descriptor_builder);
 
 	std::chrono::time_point<steady_clock> program_stop = steady_clock::now();
 	m_setup_time += std::chrono::duration_cast<std::chrono::microseconds>(program_stop - program_start).count();
@@ -1323,7 +1661,7 @@ void VKGSRender::end()
 		{
 			if (!rsx::method_registers.fragment_textures[i].enabled())
 			{
-				m_program->bind_uniform({ vk::null_sampler(), vk::null_image_view(*m_current_command_buffer), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, rsx::constants::fragment_texture_names[i], m_current_frame->descriptor_set);
+				m_program->bind_uniform({ vk::null_sampler(), vk::null_image_view(*m_current_command_buffer), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, rsx::constants::fragment_texture_names[i], m_descriptor_builder);
 				continue;
 			}
 
@@ -1333,17 +1671,17 @@ void VKGSRender::end()
 			if (!image_ptr && sampler_state->external_subresource_desc.external_handle)
 			{
 				//Requires update, copy subresource
-				image_ptr = m_texture_cache.create_temporary_subresource(*m_current_command_buffer, sampler_state->external_subresource_desc);
+				image_ptr = m_texture_cache.create_temporary_subresource(get_primary_command_buffer(), sampler_state->external_subresource_desc);
 			}
 
 			if (!image_ptr)
 			{
 				LOG_ERROR(RSX, "Texture upload failed to texture index %d. Binding null sampler.", i);
-				m_program->bind_uniform({ vk::null_sampler(), vk::null_image_view(*m_current_command_buffer), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, rsx::constants::fragment_texture_names[i], m_current_frame->descriptor_set);
+				m_program->bind_uniform({ vk::null_sampler(), vk::null_image_view(*m_current_command_buffer), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, rsx::constants::fragment_texture_names[i], m_descriptor_builder);
 				continue;
 			}
 
-			m_program->bind_uniform({ fs_sampler_handles[i]->value, image_ptr->value, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, rsx::constants::fragment_texture_names[i], m_current_frame->descriptor_set);
+			m_program->bind_uniform({ fs_sampler_handles[i]->value, image_ptr->value, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, rsx::constants::fragment_texture_names[i], m_descriptor_builder);
 		}
 	}
 
@@ -1353,7 +1691,7 @@ void VKGSRender::end()
 		{
 			if (!rsx::method_registers.vertex_textures[i].enabled())
 			{
-				m_program->bind_uniform({ vk::null_sampler(), vk::null_image_view(*m_current_command_buffer), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, rsx::constants::vertex_texture_names[i], m_current_frame->descriptor_set);
+				m_program->bind_uniform({ vk::null_sampler(), vk::null_image_view(*m_current_command_buffer), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, rsx::constants::vertex_texture_names[i], m_descriptor_builder);
 				continue;
 			}
 
@@ -1362,23 +1700,24 @@ void VKGSRender::end()
 
 			if (!image_ptr && sampler_state->external_subresource_desc.external_handle)
 			{
-				image_ptr = m_texture_cache.create_temporary_subresource(*m_current_command_buffer, sampler_state->external_subresource_desc);
+				image_ptr = m_texture_cache.create_temporary_subresource(get_primary_command_buffer(), sampler_state->external_subresource_desc);
 				m_vertex_textures_dirty[i] = true;
 			}
 
 			if (!image_ptr)
 			{
 				LOG_ERROR(RSX, "Texture upload failed to vtexture index %d. Binding null sampler.", i);
-				m_program->bind_uniform({ vk::null_sampler(), vk::null_image_view(*m_current_command_buffer), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, rsx::constants::vertex_texture_names[i], m_current_frame->descriptor_set);
+				m_program->bind_uniform({ vk::null_sampler(), vk::null_image_view(*m_current_command_buffer), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, rsx::constants::vertex_texture_names[i], m_descriptor_builder);
 				continue;
 			}
 
-			m_program->bind_uniform({ vs_sampler_handles[i]->value, image_ptr->value, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, rsx::constants::vertex_texture_names[i], m_current_frame->descriptor_set);
+			m_program->bind_uniform({ vs_sampler_handles[i]->value, image_ptr->value, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }, rsx::constants::vertex_texture_names[i], m_descriptor_builder);
 		}
 	}
 
 	textures_end = steady_clock::now();
 	m_textures_upload_time += std::chrono::duration_cast<std::chrono::microseconds>(textures_end - textures_start).count();
+	add_frame_time(rsx::frame_timer::texture_upload, textures_end - textures_start);
 
 	//While vertex upload is an interruptible process, if we made it this far, there's no need to sync anything that occurs past this point
 	//Only textures are synchronized tightly with the GPU and they have been read back above
@@ -1402,12 +1741,13 @@ void VKGSRender::end()
 		}
 	}
 
-	vkCmdBindPipeline(*m_current_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_program->pipeline);
-	vkCmdBindDescriptorSets(*m_current_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &m_current_frame->descriptor_set, 0, nullptr);
+	commit_descriptors();
 
-	update_draw_state();
+	draw_packet packet;
+	packet.pipeline = m_program->pipeline;
+	packet.descriptor_set = m_current_frame->descriptor_set;
 
-	begin_render_pass();
+	update_draw_state(packet);
 
 	bool primitive_emulated = false;
 	vk::get_appropriate_topology(rsx::method_registers.current_draw_clause.primitive, primitive_emulated);
@@ -1417,41 +1757,29 @@ void VKGSRender::end()
 		rsx::method_registers.current_draw_clause.first_count_commands.size() <= 1 ||
 		rsx::method_registers.current_draw_clause.is_disjoint_primitive);
 
-	if (m_occlusion_query_active && (occlusion_id != UINT32_MAX))
-	{
-		//Begin query
-		m_occlusion_query_pool.begin_query(*m_current_command_buffer, occlusion_id);
-		m_occlusion_map[m_active_query_info->driver_handle].indices.push_back(occlusion_id);
-		m_occlusion_map[m_active_query_info->driver_handle].command_buffer_to_wait = m_current_command_buffer;
-	}
-
 	if (!upload_info.index_info)
 	{
 		if (single_draw)
 		{
-			vkCmdDraw(*m_current_command_buffer, upload_info.vertex_draw_count, 1, 0, 0);
+			packet.draws.push_back({ upload_info.vertex_draw_count, 0 });
 		}
 		else
 		{
 			const auto base_vertex = rsx::method_registers.current_draw_clause.first_count_commands.front().first;
 			for (const auto &range : rsx::method_registers.current_draw_clause.first_count_commands)
 			{
-				vkCmdDraw(*m_current_command_buffer, range.second, 1, range.first - base_vertex, 0);
+				packet.draws.push_back({ range.second, range.first - base_vertex });
 			}
 		}
 	}
 	else
 	{
-		VkIndexType index_type;
-		const u32 index_count = upload_info.vertex_draw_count;
-		VkDeviceSize offset;
-
-		std::tie(offset, index_type) = upload_info.index_info.value();
-		vkCmdBindIndexBuffer(*m_current_command_buffer, m_index_buffer_ring_info.heap->value, offset, index_type);
+		std::tie(packet.index_offset, packet.index_type) = upload_info.index_info.value();
+		packet.index_buffer = m_index_buffer_ring_info.heap->value;
 
 		if (single_draw)
 		{
-			vkCmdDrawIndexed(*m_current_command_buffer, index_count, 1, 0, 0, 0);
+			packet.draws.push_back({ upload_info.vertex_draw_count, 0 });
 		}
 		else
 		{
@@ -1459,19 +1787,49 @@ void VKGSRender::end()
 			for (const auto &range : rsx::method_registers.current_draw_clause.first_count_commands)
 			{
 				const auto verts = get_index_count(rsx::method_registers.current_draw_clause.primitive, range.second);
-				vkCmdDrawIndexed(*m_current_command_buffer, verts, 1, first_vertex, 0, 0);
+				packet.draws.push_back({ verts, first_vertex });
 				first_vertex += verts;
 			}
 		}
 	}
 
-	if (m_occlusion_query_active && (occlusion_id != UINT32_MAX))
+	const bool query_active = m_occlusion_query_active && (occlusion_id != UINT32_MAX);
+	if (m_draw_recorder && !query_active)
 	{
-		//End query
-		m_occlusion_query_pool.end_query(*m_current_command_buffer, occlusion_id);
+		//Queries have to be recorded in the primary command buffer, everything else can be batched
+		//Batches begin their own render pass, a clear pending on this framebuffer has to land before them
+		close_render_pass();
+		flush_pending_clear();
+
+		if (!m_draw_recorder->can_append(m_draw_fbo->info.renderPass, m_draw_fbo->value))
+			flush_draw_batch();
+
+		m_draw_recorder->append(std::move(packet), m_draw_fbo->info.renderPass, m_draw_fbo->value, { m_draw_fbo->width(), m_draw_fbo->height() });
+	}
+	else
+	{
+		//Bound state survives the render pass boundaries, so it is recorded once the pass is open
+		begin_render_pass();
+
+		packet.record_state(*m_current_command_buffer, pipeline_layout);
+
+		if (query_active)
+		{
+			//Begin query
+			m_occlusion_query_pool.begin_query(*m_current_command_buffer, occlusion_id);
+			m_occlusion_map[m_active_query_info->driver_handle].indices.push_back(occlusion_id);
+			m_occlusion_map[m_active_query_info->driver_handle].command_buffer_to_wait = m_current_command_buffer;
+		}
+
+		packet.record_draws(*m_current_command_buffer);
+
+		if (query_active)
+		{
+			//End query
+			m_occlusion_query_pool.end_query(*m_current_command_buffer, occlusion_id);
+		}
 	}
 
-	close_render_pass();
 	vk::leave_uninterruptible();
 
 	m_rtts.on_write();
@@ -1485,7 +1843,7 @@ void VKGSRender::end()
 	rsx::thread::end();
 }
 
-void VKGSRender::set_viewport()
+void VKGSRender::set_viewport(draw_packet& packet)
 {
 	const auto clip_width = rsx::apply_resolution_scale(rsx::method_registers.surface_clip_width(), true);
 	const auto clip_height = rsx::apply_resolution_scale(rsx::method_registers.surface_clip_height(), true);
@@ -1495,7 +1853,7 @@ void VKGSRender::set_viewport()
 	u16 scissor_h = rsx::apply_resolution_scale(rsx::method_registers.scissor_height(), true);
 
 	//NOTE: The scale_offset matrix already has viewport matrix factored in
-	VkViewport viewport = {};
+	VkViewport &viewport = packet.viewport;
 	viewport.x = 0;
 	viewport.y = 0;
 	viewport.width = clip_width;
@@ -1503,16 +1861,12 @@ void VKGSRender::set_viewport()
 	viewport.minDepth = 0.f;
 	viewport.maxDepth = 1.f;
 
-	vkCmdSetViewport(*m_current_command_buffer, 0, 1, &viewport);
-
-	VkRect2D scissor = {};
+	VkRect2D &scissor = packet.scissor;
 	scissor.extent.height = scissor_h;
 	scissor.extent.width = scissor_w;
 	scissor.offset.x = scissor_x;
 	scissor.offset.y = scissor_y;
 
-	vkCmdSetScissor(*m_current_command_buffer, 0, 1, &scissor);
-
 	if (scissor_x >= viewport.width || scissor_y >= viewport.height || scissor_w == 0 || scissor_h == 0)
 	{
 		if (!g_cfg.video.strict_rendering_mode)
@@ -1534,11 +1888,16 @@ void VKGSRender::on_init_thread()
 	rsx_thread = std::this_thread::get_id();
 	zcull_ctrl.reset(static_cast<::rsx::reports::ZCULL_control*>(this));
 
+	const std::string pipeline_cache_path = get_pipeline_cache_path(m_device->gpu());
+	if (!pipeline_cache_path.empty())
+		m_prog_buffer->load_pipeline_cache(*m_device, pipeline_cache_path);
+
 	if (!supports_native_ui)
 	{
 		m_frame->disable_wm_event_queue();
 		m_frame->hide();
 		m_shaders_cache->load(nullptr, *m_device, pipeline_layout);
+		m_prog_buffer->merge_pipeline_caches();
 		m_frame->enable_wm_event_queue();
 		m_frame->show();
 	}
@@ -1602,6 +1961,7 @@ void VKGSRender::on_init_thread()
 		//TODO: Handle window resize messages during loading on GPUs without OUT_OF_DATE_KHR support
 		m_frame->disable_wm_event_queue();
 		m_shaders_cache->load(&helper, *m_device, pipeline_layout);
+		m_prog_buffer->merge_pipeline_caches();
 		m_frame->enable_wm_event_queue();
 	}
 }
@@ -1609,6 +1969,9 @@ void VKGSRender::on_init_thread()
 void VKGSRender::on_exit()
 {
 	zcull_ctrl.release();
+
+	//The next title starts at the configured scale
+	m_dynamic_resolution.reset();
 	return GSRender::on_exit();
 }
 
@@ -1740,8 +2103,8 @@ void VKGSRender::clear_surface(u32 mask)
 					{
 						if (auto rtt = std::get<1>(m_rtts.m_bound_render_targets[index]))
 						{
-							vk::insert_texture_barrier(*m_current_command_buffer, rtt);
-							m_attachment_clear_pass->run(*m_current_command_buffer, rtt,
+							vk::insert_texture_barrier(get_primary_command_buffer(), rtt);
+							m_attachment_clear_pass->run(get_primary_command_buffer(), rtt,
 								region.rect, renderpass, m_framebuffers_to_clean);
 						}
 						else
@@ -1775,9 +2138,7 @@ void VKGSRender::clear_surface(u32 mask)
 
 	if (clear_descriptors.size() > 0)
 	{
-		begin_render_pass();
-		vkCmdClearAttachments(*m_current_command_buffer, (u32)clear_descriptors.size(), clear_descriptors.data(), 1, &region);
-		close_render_pass();
+		clear_attachments(clear_descriptors, region);
 	}
 }
 
@@ -1794,9 +2155,10 @@ void VKGSRender::copy_render_targets_to_dma_location()
 	if (!g_cfg.video.write_color_buffers && !g_cfg.video.write_depth_buffer)
 		return;
 
-	//TODO: Make this asynchronous. Should be similar to a glFlush() but in this case its similar to glFinish
-	//This is due to all the hard waits for fences
-	//TODO: Use a command buffer array to allow explicit draw command tracking
+	//Only surfaces the CPU has been reading back are copied ahead, the others are left to the fault handler
+	//The copies are submitted without waiting, a later fault only waits for the command buffer holding its copy
+	m_flush_draw_buffers = false;
+	bool copies_recorded = false;
 
 	vk::enter_uninterruptible();
 
@@ -1804,28 +2166,29 @@ void VKGSRender::copy_render_targets_to_dma_location()
 	{
 		for (u8 index = 0; index < rsx::limits::color_buffers_count; index++)
 		{
-			if (!m_surface_info[index].pitch)
+			if (!m_surface_info[index].pitch || !m_texture_cache.predict_readback(m_surface_info[index].address))
 				continue;
 
-			m_texture_cache.flush_memory_to_cache(m_surface_info[index].address, m_surface_info[index].pitch * m_surface_info[index].height, true, 0xFF,
-					*m_current_command_buffer, m_swapchain->get_graphics_queue());
+			copies_recorded |= m_texture_cache.flush_memory_to_cache(m_surface_info[index].address, m_surface_info[index].pitch * m_surface_info[index].height, true, 0xFF,
+					get_primary_command_buffer(), m_swapchain->get_graphics_queue());
 		}
 	}
 
 	if (g_cfg.video.write_depth_buffer)
 	{
-		if (m_depth_surface_info.pitch)
+		if (m_depth_surface_info.pitch && m_texture_cache.predict_readback(m_depth_surface_info.address))
 		{
-			m_texture_cache.flush_memory_to_cache(m_depth_surface_info.address, m_depth_surface_info.pitch * m_depth_surface_info.height, true, 0xFF,
-				*m_current_command_buffer, m_swapchain->get_graphics_queue());
+			copies_recorded |= m_texture_cache.flush_memory_to_cache(m_depth_surface_info.address, m_depth_surface_info.pitch * m_depth_surface_info.height, true, 0xFF,
+				get_primary_command_buffer(), m_swapchain->get_graphics_queue());
 		}
 	}
 
 	vk::leave_uninterruptible();
 
-	flush_command_queue();
-
-	m_flush_draw_buffers = false;
+	if (copies_recorded)
+	{
+		flush_command_queue();
+	}
 }
 
 void VKGSRender::flush_command_queue(bool hard_sync)
@@ -1883,7 +2246,9 @@ void VKGSRender::advance_queued_frames()
 		if (ctx.swap_command_buffer)
 		{
 			ctx.swap_command_buffer->poke();
-			if (ctx.swap_command_buffer->pending)
+
+			//Low latency mode keeps a single frame in flight; wait for the previous one instead of deferring it
+			if (ctx.swap_command_buffer->pending && !g_cfg.video.vk.low_latency)
 				continue;
 
 			//Present the bound image
@@ -1907,6 +2272,11 @@ void VKGSRender::advance_queued_frames()
 	});
 
 	m_vertex_cache->purge();
+
+	//Bound views and samplers may be released once this frame retires, cached sets must not outlive it
+	m_current_frame->descriptor_cache.clear();
+	m_current_frame->descriptor_cache.m_hits = m_current_frame->descriptor_cache.m_misses = 0;
+
 	m_current_frame->tag_frame_end(m_attrib_ring_info.get_current_put_pos_minus_one(),
 		m_uniform_buffer_ring_info.get_current_put_pos_minus_one(),
 		m_transform_constants_ring_info.get_current_put_pos_minus_one(),
@@ -1925,6 +2295,17 @@ void VKGSRender::present(frame_context_t *ctx)
 
 	if (!present_surface_dirty_flag)
 	{
+		if (g_cfg.video.vk.frame_pacing)
+		{
+			const u64 gpu_ready_time = ctx->swap_submit_time ? m_present_scheduler.predict_gpu_completion(ctx->swap_submit_time) : 0;
+			if (const u64 delay = m_present_scheduler.get_present_delay(get_system_time(), gpu_ready_time))
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(delay));
+			}
+		}
+
+		m_present_scheduler.on_present(get_system_time());
+
 		switch (VkResult error = m_swapchain->present(ctx->present_image))
 		{
 		case VK_SUCCESS:
@@ -1940,8 +2321,6 @@ void VKGSRender::present(frame_context_t *ctx)
 
 	//Presentation image released; reset value
 	ctx->present_image = UINT32_MAX;
-
-	vk::advance_completed_frame_counter();
 }
 
 void VKGSRender::queue_swap_request()
@@ -1955,15 +2334,22 @@ void VKGSRender::queue_swap_request()
 	}
 
 	m_current_frame->swap_command_buffer = m_current_command_buffer;
+	m_current_frame->swap_submit_time = get_system_time();
 
 	if (m_swapchain->is_headless())
 	{
-		m_swapchain->end_frame(*m_current_command_buffer, m_current_frame->present_image);
+		m_swapchain->end_frame(get_primary_command_buffer(), m_current_frame->present_image);
 		close_and_submit_command_buffer({}, m_current_command_buffer->submit_fence);
 	}
 	else
 	{
 		close_and_submit_command_buffer({ m_current_frame->present_semaphore }, m_current_command_buffer->submit_fence);
+
+		if (g_cfg.video.vk.low_latency)
+		{
+			//The present waits on the submit semaphore, queue it right away instead of on the next flip
+			present(m_current_frame);
+		}
 	}
 
 	m_current_frame->swap_command_buffer->pending = true;
@@ -1990,8 +2376,16 @@ void VKGSRender::process_swap_request(frame_context_t *ctx, bool free_resources)
 		free_resources = true;
 	}
 
-	//Always present
-	present(ctx);
+	m_present_scheduler.on_gpu_complete(ctx->swap_submit_time, get_system_time());
+	ctx->swap_submit_time = 0;
+
+	//Always present, unless low latency mode already did so at submit time
+	if (ctx->present_image != UINT32_MAX)
+	{
+		present(ctx);
+	}
+
+	vk::advance_completed_frame_counter();
 
 	if (free_resources)
 	{
@@ -2044,6 +2438,9 @@ void VKGSRender::process_swap_request(frame_context_t *ctx, bool free_resources)
 			m_transform_constants_ring_info.notify();
 			m_index_buffer_ring_info.notify();
 			m_texture_upload_buffer_ring_info.notify();
+
+			//The current transform constants may live in the released range
+			m_graphics_state |= rsx::pipeline_state::transform_constants_dirty;
 		}
 	}
 
@@ -2193,7 +2590,7 @@ bool VKGSRender::check_program_status()
 	return (rsx::method_registers.shader_program_address() != 0);
 }
 
-void VKGSRender::load_program(const vk::vertex_upload_info& vertex_info)
+bool VKGSRender::load_program(const vk::vertex_upload_info& vertex_info)
 {
 	if (m_graphics_state & rsx::pipeline_state::invalidate_pipeline_bits)
 	{
@@ -2335,7 +2732,16 @@ void VKGSRender::load_program(const vk::vertex_upload_info& vertex_info)
 	//Load current program from buffer
 	vertex_program.skip_vertex_input_check = true;
 	fragment_program.unnormalized_coords = 0;
-	m_program = m_prog_buffer->getGraphicPipelineState(vertex_program, fragment_program, properties, *m_device, pipeline_layout).get();
+	if (g_cfg.video.async_shader_compilation)
+	{
+		auto pipeline = m_prog_buffer->getGraphicPipelineStateAsync(vertex_program, fragment_program, properties, (VkDevice)*m_device, pipeline_layout, m_prog_buffer->get_pipeline_cache(*m_device));
+		m_program = pipeline ? pipeline->get() : nullptr;
+		performance_counters.pending_pipelines = m_prog_buffer->get_pending_pipeline_count();
+	}
+	else
+	{
+		m_program = m_prog_buffer->getGraphicPipelineState(vertex_program, fragment_program, properties, *m_device, pipeline_layout, m_prog_buffer->get_pipeline_cache(*m_device)).get();
+	}
 
 	if (m_prog_buffer->check_cache_missed())
 	{
@@ -2362,6 +2768,12 @@ void VKGSRender::load_program(const vk::vertex_upload_info& vertex_info)
 
 	vk::leave_uninterruptible();
 
+	if (!m_program)
+	{
+		// Pipeline is still being compiled
+		return false;
+	}
+
 	if (1)//m_graphics_state & (rsx::pipeline_state::fragment_state_dirty | rsx::pipeline_state::vertex_state_dirty))
 	{
 		const size_t fragment_constants_sz = m_prog_buffer->get_fragment_constants_buffer_size(fragment_program);
@@ -2411,17 +2823,23 @@ void VKGSRender::load_program(const vk::vertex_upload_info& vertex_info)
 		fill_vertex_program_constants_data(buf);
 		m_transform_constants_ring_info.unmap();
 		m_vertex_constants_buffer_info = { m_transform_constants_ring_info.heap->value, vertex_constants_offset, 8192 };
+
+		// The ring allocation is reused by later draws until the constants change or the heap reclaims it
+		m_transform_constants_dirty_begin = 468;
+		m_transform_constants_dirty_end = 0;
+		m_graphics_state &= ~rsx::pipeline_state::transform_constants_dirty;
 	}
 
 	if (1)//m_graphics_state || old_program != m_program)
 	{
-		m_program->bind_uniform(m_vertex_state_buffer_info, SCALE_OFFSET_BIND_SLOT, m_current_frame->descriptor_set);
-		m_program->bind_uniform(m_vertex_constants_buffer_info, VERTEX_CONSTANT_BUFFERS_BIND_SLOT, m_current_frame->descriptor_set);
-		m_program->bind_uniform(m_fragment_state_buffer_info, FRAGMENT_CONSTANT_BUFFERS_BIND_SLOT, m_current_frame->descriptor_set);
+		m_program->bind_uniform(m_vertex_state_buffer_info, SCALE_OFFSET_BIND_SLOT, m_descriptor_builder);
+		m_program->bind_uniform(m_vertex_constants_buffer_info, VERTEX_CONSTANT_BUFFERS_BIND_SLOT, m_descriptor_builder);
+		m_program->bind_uniform(m_fragment_state_buffer_info, FRAGMENT_CONSTANT_BUFFERS_BIND_SLOT, m_descriptor_builder);
 	}
 
 	//Clear flags
 	m_graphics_state &= ~rsx::pipeline_state::memory_barrier_bits;
+	return true;
 }
 
 static const u32 mr_color_offset[rsx::limits::color_buffers_count] =
@@ -2495,6 +2913,13 @@ void VKGSRender::write_buffers()
 
 void VKGSRender::close_and_submit_command_buffer(const std::vector<VkSemaphore> &semaphores, VkFence fence, VkPipelineStageFlags pipeline_stage_flags)
 {
+	rsx::frame_timer_scope timer(this, rsx::frame_timer::submit);
+
+	close_render_pass();
+	flush_draw_batch();
+
+	m_gpu_timer.end(*m_current_command_buffer, m_current_cb_index);
+
 	m_current_command_buffer->end();
 	m_current_command_buffer->tag();
 	m_current_command_buffer->submit(m_swapchain->get_graphics_queue(), semaphores, fence, pipeline_stage_flags);
@@ -2503,6 +2928,7 @@ void VKGSRender::close_and_submit_command_buffer(const std::vector<VkSemaphore>
 void VKGSRender::open_command_buffer()
 {
 	m_current_command_buffer->begin();
+	m_gpu_timer.begin(*m_current_command_buffer, m_current_cb_index);
 }
 
 
@@ -2511,6 +2937,8 @@ void VKGSRender::prepare_rtts(rsx::framebuffer_creation_context context)
 	if (m_draw_fbo && !m_rtts_dirty)
 		return;
 
+	rsx::frame_timer_scope timer(this, rsx::frame_timer::surface_setup);
+
 	copy_render_targets_to_dma_location();
 	m_rtts_dirty = false;
 
@@ -2726,12 +3154,12 @@ void VKGSRender::prepare_rtts(rsx::framebuffer_creation_context context)
 		}
 	}
 
-	m_rtts.prepare_render_target(&*m_current_command_buffer,
+	m_rtts.prepare_render_target(&get_primary_command_buffer(),
 		color_fmt, depth_fmt,
 		clip_width, clip_height,
 		target,
 		surface_addresses, zeta_address,
-		(*m_device), &*m_current_command_buffer);
+		(*m_device), &get_primary_command_buffer());
 
 	//Reset framebuffer information
 	VkFormat old_format = VK_FORMAT_UNDEFINED;
@@ -2745,7 +3173,7 @@ void VKGSRender::prepare_rtts(rsx::framebuffer_creation_context context)
 
 			m_texture_cache.set_memory_read_flags(m_surface_info[i].address, m_surface_info[i].pitch * m_surface_info[i].height, rsx::memory_read_flags::flush_once);
 			m_texture_cache.flush_if_cache_miss_likely(old_format, m_surface_info[i].address, m_surface_info[i].pitch * m_surface_info[i].height,
-				*m_current_command_buffer, m_swapchain->get_graphics_queue());
+				get_primary_command_buffer(), m_swapchain->get_graphics_queue());
 		}
 
 		m_surface_info[i].address = m_surface_info[i].pitch = 0;
@@ -2761,7 +3189,7 @@ void VKGSRender::prepare_rtts(rsx::framebuffer_creation_context context)
 			auto old_format = vk::get_compatible_depth_surface_format(m_device->get_formats_support(), m_depth_surface_info.depth_format);
 			m_texture_cache.set_memory_read_flags(m_depth_surface_info.address, m_depth_surface_info.pitch * m_depth_surface_info.height, rsx::memory_read_flags::flush_once);
 			m_texture_cache.flush_if_cache_miss_likely(old_format, m_depth_surface_info.address, m_depth_surface_info.pitch * m_depth_surface_info.height,
-				*m_current_command_buffer, m_swapchain->get_graphics_queue());
+				get_primary_command_buffer(), m_swapchain->get_graphics_queue());
 		}
 
 		m_depth_surface_info.address = m_depth_surface_info.pitch = 0;
@@ -2777,6 +3205,22 @@ void VKGSRender::prepare_rtts(rsx::framebuffer_creation_context context)
 	std::vector<vk::image*> bound_images;
 	bound_images.reserve(5);
 
+	const u32 color_offsets[] =
+	{
+		rsx::method_registers.surface_a_offset(),
+		rsx::method_registers.surface_b_offset(),
+		rsx::method_registers.surface_c_offset(),
+		rsx::method_registers.surface_d_offset()
+	};
+
+	const u32 color_locations[] =
+	{
+		rsx::method_registers.surface_a_dma(),
+		rsx::method_registers.surface_b_dma(),
+		rsx::method_registers.surface_c_dma(),
+		rsx::method_registers.surface_d_dma()
+	};
+
 	for (u8 index : draw_buffers)
 	{
 		if (auto surface = std::get<1>(m_rtts.m_bound_render_targets[index]))
@@ -2787,6 +3231,8 @@ void VKGSRender::prepare_rtts(rsx::framebuffer_creation_context context)
 			m_surface_info[index].pitch = std::max(surface_pitchs[index], required_color_pitch);
 			surface->rsx_pitch = surface_pitchs[index];
 
+			// Picked up when the surface is written back to guest memory
+			surface->tile = find_tile(color_offsets[index], color_locations[index]);
 			surface->write_aa_mode = aa_mode;
 			m_texture_cache.notify_surface_changed(surface_addresses[index]);
 
@@ -2926,6 +3372,7 @@ void VKGSRender::reinitialize_swapchain()
 		ctx.swap_command_buffer->wait();
 		ctx.swap_command_buffer = nullptr;
 		present(&ctx);
+		vk::advance_completed_frame_counter();
 	}
 
 	//Wait for completion
@@ -2957,9 +3404,9 @@ void VKGSRender::reinitialize_swapchain()
 		VkClearColorValue clear_color{};
 		VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
 
-		vk::change_image_layout(*m_current_command_buffer, target_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, range);
-		vkCmdClearColorImage(*m_current_command_buffer, target_image, VK_IMAGE_LAYOUT_GENERAL, &clear_color, 1, &range);
-		vk::change_image_layout(*m_current_command_buffer, target_image, VK_IMAGE_LAYOUT_GENERAL, target_layout, range);
+		vk::change_image_layout(get_primary_command_buffer(), target_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, range);
+		vkCmdClearColorImage(get_primary_command_buffer(), target_image, VK_IMAGE_LAYOUT_GENERAL, &clear_color, 1, &range);
+		vk::change_image_layout(get_primary_command_buffer(), target_image, VK_IMAGE_LAYOUT_GENERAL, target_layout, range);
 	}
 
 	//Will have to block until rendering is completed
@@ -3134,7 +3581,7 @@ void VKGSRender::flip(int buffer)
 		else
 		{
 			//Read from cell
-			image_to_flip = m_texture_cache.upload_image_simple(*m_current_command_buffer, absolute_address, buffer_width, buffer_height);
+			image_to_flip = m_texture_cache.upload_image_simple(get_primary_command_buffer(), absolute_address, buffer_width, buffer_height);
 		}
 	}
 
@@ -3149,18 +3596,18 @@ void VKGSRender::flip(int buffer)
 		if (aspect_ratio.x || aspect_ratio.y)
 		{
 			VkClearColorValue clear_black {};
-			vk::change_image_layout(*m_current_command_buffer, target_image, present_layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range);
-			vkCmdClearColorImage(*m_current_command_buffer, target_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear_black, 1, &range);
+			vk::change_image_layout(get_primary_command_buffer(), target_image, present_layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range);
+			vkCmdClearColorImage(get_primary_command_buffer(), target_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear_black, 1, &range);
 
 			target_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 		}
 
-		vk::copy_scaled_image(*m_current_command_buffer, image_to_flip->value, target_image, image_to_flip->current_layout, target_layout,
+		vk::copy_scaled_image(get_primary_command_buffer(), image_to_flip->value, target_image, image_to_flip->current_layout, target_layout,
 			0, 0, image_to_flip->width(), image_to_flip->height(), aspect_ratio.x, aspect_ratio.y, aspect_ratio.width, aspect_ratio.height, 1, VK_IMAGE_ASPECT_COLOR_BIT, false);
 
 		if (target_layout != present_layout)
 		{
-			vk::change_image_layout(*m_current_command_buffer, target_image, target_layout, present_layout, range);
+			vk::change_image_layout(get_primary_command_buffer(), target_image, target_layout, present_layout, range);
 		}
 	}
 	else
@@ -3169,9 +3616,9 @@ void VKGSRender::flip(int buffer)
 		//TODO: Upload raw bytes from cpu for rendering
 		VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
 		VkClearColorValue clear_black {};
-		vk::change_image_layout(*m_current_command_buffer, m_swapchain->get_image(m_current_frame->present_image), present_layout, VK_IMAGE_LAYOUT_GENERAL, range);
-		vkCmdClearColorImage(*m_current_command_buffer, m_swapchain->get_image(m_current_frame->present_image), VK_IMAGE_LAYOUT_GENERAL, &clear_black, 1, &range);
-		vk::change_image_layout(*m_current_command_buffer, m_swapchain->get_image(m_current_frame->present_image), VK_IMAGE_LAYOUT_GENERAL, present_layout, range);
+		vk::change_image_layout(get_primary_command_buffer(), m_swapchain->get_image(m_current_frame->present_image), present_layout, VK_IMAGE_LAYOUT_GENERAL, range);
+		vkCmdClearColorImage(get_primary_command_buffer(), m_swapchain->get_image(m_current_frame->present_image), VK_IMAGE_LAYOUT_GENERAL, &clear_black, 1, &range);
+		vk::change_image_layout(get_primary_command_buffer(), m_swapchain->get_image(m_current_frame->present_image), VK_IMAGE_LAYOUT_GENERAL, present_layout, range);
 	}
 
 	std::unique_ptr<vk::framebuffer_holder> direct_fbo;
@@ -3192,7 +3639,7 @@ void VKGSRender::flip(int buffer)
 		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 		barrier.subresourceRange = subres;
 
-		vkCmdPipelineBarrier(*m_current_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_DEPENDENCY_BY_REGION_BIT, 0, nullptr, 0, nullptr, 1, &barrier);
+		vkCmdPipelineBarrier(get_primary_command_buffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_DEPENDENCY_BY_REGION_BIT, 0, nullptr, 0, nullptr, 1, &barrier);
 
 		size_t idx = vk::get_render_pass_location(m_swapchain->get_surface_format(), VK_FORMAT_UNDEFINED, 1);
 		VkRenderPass single_target_pass = m_render_passes[idx];
@@ -3222,19 +3669,24 @@ void VKGSRender::flip(int buffer)
 
 			for (const auto& view : m_overlay_manager->get_views())
 			{
-				m_ui_renderer->run(*m_current_command_buffer, direct_fbo->width(), direct_fbo->height(), direct_fbo.get(), single_target_pass, m_texture_upload_buffer_ring_info, *view.get());
+				m_ui_renderer->run(get_primary_command_buffer(), direct_fbo->width(), direct_fbo->height(), direct_fbo.get(), single_target_pass, m_texture_upload_buffer_ring_info, *view.get());
 			}
 		}
 
 		if (g_cfg.video.overlay)
 		{
-			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 0, direct_fbo->width(), direct_fbo->height(), "RSX Load: " + std::to_string(get_load()) + "%");
-			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 18, direct_fbo->width(), direct_fbo->height(), "draw calls: " + std::to_string(m_draw_calls));
-			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 36, direct_fbo->width(), direct_fbo->height(), "draw call setup: " + std::to_string(m_setup_time) + "us");
-			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 54, direct_fbo->width(), direct_fbo->height(), "vertex upload time: " + std::to_string(m_vertex_upload_time) + "us");
-			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 72, direct_fbo->width(), direct_fbo->height(), "texture upload time: " + std::to_string(m_textures_upload_time) + "us");
-			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 90, direct_fbo->width(), direct_fbo->height(), "draw call execution: " + std::to_string(m_draw_time) + "us");
-			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 108, direct_fbo->width(), direct_fbo->height(), "submit and flip: " + std::to_string(m_flip_time) + "us");
+			m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, 0, direct_fbo->width(), direct_fbo->height(), "RSX Load: " + std::to_string(get_load()) + "%");
+			m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, 18, direct_fbo->width(), direct_fbo->height(), "draw calls: " + std::to_string(m_draw_calls));
+			m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, 36, direct_fbo->width(), direct_fbo->height(), "draw call setup: " + std::to_string(m_setup_time) + "us");
+			m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, 54, direct_fbo->width(), direct_fbo->height(), "vertex upload time: " + std::to_string(m_vertex_upload_time) + "us");
+			m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, 72, direct_fbo->width(), direct_fbo->height(), "texture upload time: " + std::to_string(m_textures_upload_time) + "us");
+			m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, 90, direct_fbo->width(), direct_fbo->height(), "draw call execution: " + std::to_string(m_draw_time) + "us");
+			m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, 108, direct_fbo->width(), direct_fbo->height(), "submit and flip: " + std::to_string(m_flip_time) + "us");
+
+			if (g_cfg.video.dynamic_resolution)
+			{
+				m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, 126, direct_fbo->width(), direct_fbo->height(), fmt::format("GPU frame time: %lluus, resolution scale: %d%%", m_dynamic_resolution.get_gpu_frame_time(), rsx::get_resolution_scale_percent()));
+			}
 
 			const  auto num_dirty_textures = m_texture_cache.get_unreleased_textures_count();
 			const auto texture_memory_size = m_texture_cache.get_texture_memory_in_use() / (1024 * 1024);
@@ -3243,18 +3695,52 @@ void VKGSRender::flip(int buffer)
 			const auto num_mispredict = m_texture_cache.get_num_cache_mispredictions();
 			const auto num_speculate = m_texture_cache.get_num_cache_speculative_writes();
 			const auto cache_miss_ratio = (u32)ceil(m_texture_cache.get_cache_miss_ratio() * 100);
-			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 144, direct_fbo->width(), direct_fbo->height(), "Unreleased textures: " + std::to_string(num_dirty_textures));
-			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 162, direct_fbo->width(), direct_fbo->height(), "Texture cache memory: " + std::to_string(texture_memory_size) + "M");
-			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 180, direct_fbo->width(), direct_fbo->height(), "Temporary texture memory: " + std::to_string(tmp_texture_memory_size) + "M");
-			m_text_writer->print_text(*m_current_command_buffer, *direct_fbo, 0, 198, direct_fbo->width(), direct_fbo->height(), fmt::format("Flush requests: %d (%d%% hard faults, %d misprediction(s), %d speculation(s))", num_flushes, cache_miss_ratio, num_mispredict, num_speculate));
+			m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, 144, direct_fbo->width(), direct_fbo->height(), "Unreleased textures: " + std::to_string(num_dirty_textures));
+			m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, 162, direct_fbo->width(), direct_fbo->height(), fmt::format("Texture cache memory: %lluM, %u eviction(s) (%lluM) last frame", (u64)texture_memory_size, m_texture_cache.get_num_evicted_sections(), m_texture_cache.get_num_evicted_bytes() / 0x100000));
+			m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, 180, direct_fbo->width(), direct_fbo->height(), "Temporary texture memory: " + std::to_string(tmp_texture_memory_size) + "M");
+			m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, 198, direct_fbo->width(), direct_fbo->height(), fmt::format("Flush requests: %d (%d%% hard faults, %d misprediction(s), %d speculation(s))", num_flushes, cache_miss_ratio, num_mispredict, num_speculate));
+
+			const auto vertex_cache_stats = m_vertex_cache->get_stats();
+			m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, 216, direct_fbo->width(), direct_fbo->height(), fmt::format("Vertex cache: %u hit(s), %u miss(es), %u eviction(s), %llu KB cached", vertex_cache_stats.hits, vertex_cache_stats.misses, vertex_cache_stats.evictions, vertex_cache_stats.cached_bytes / 1024));
+
+			u32 heap_text_offset = 234;
+			for (const auto heap : get_upload_heaps())
+			{
+				m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, heap_text_offset, direct_fbo->width(), direct_fbo->height(), fmt::format("%s: %lluM, %lluM peak, %u forced flush(es)", heap->m_name, (u64)heap->size() / 0x100000, (u64)heap->m_high_water_mark / 0x100000, heap->m_forced_flushes));
+				heap_text_offset += 18;
+			}
+
+			const auto &descriptor_cache = m_current_frame->descriptor_cache;
+			m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, heap_text_offset, direct_fbo->width(), direct_fbo->height(), fmt::format("Descriptor sets: %u written, %u reused", descriptor_cache.m_misses, descriptor_cache.m_hits));
+			heap_text_offset += 18;
+
+			const auto mem_stats = m_device->get_allocator()->get_stats();
+			if (mem_stats.allocations)
+			{
+				const u32 fragmentation = mem_stats.reserved_bytes ? (u32)(100 - (mem_stats.used_bytes * 100) / mem_stats.reserved_bytes) : 0;
+				m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, heap_text_offset, direct_fbo->width(), direct_fbo->height(), fmt::format("Device memory: %lluM in %llu block(s), %u%% unused, %llu alloc(s), %llu free(s) per frame",
+					mem_stats.reserved_bytes / 0x100000, mem_stats.device_allocations, fragmentation, mem_stats.allocations - m_last_allocator_stats.allocations, mem_stats.frees - m_last_allocator_stats.frees));
+				heap_text_offset += 18;
+			}
+
+			u64 budget, usage;
+			if (m_device->get_device_local_budget(budget, usage))
+			{
+				m_text_writer->print_text(get_primary_command_buffer(), *direct_fbo, 0, heap_text_offset, direct_fbo->width(), direct_fbo->height(), fmt::format("Device local budget: %lluM of %lluM used", usage / 0x100000, budget / 0x100000));
+			}
+
+			m_last_allocator_stats = mem_stats;
 		}
 
-		vk::change_image_layout(*m_current_command_buffer, target_image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, present_layout, subres);
+		vk::change_image_layout(get_primary_command_buffer(), target_image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, present_layout, subres);
 		m_framebuffers_to_clean.push_back(std::move(direct_fbo));
 	}
 
 	queue_swap_request();
 
+	//Surfaces are only rebuilt between frames
+	update_dynamic_resolution();
+
 	std::chrono::time_point<steady_clock> flip_end = steady_clock::now();
 	m_flip_time = std::chrono::duration_cast<std::chrono::microseconds>(flip_end - flip_start).count();
 
@@ -3263,6 +3749,8 @@ void VKGSRender::flip(int buffer)
 	m_frame->flip(m_context);
 	rsx::thread::flip(buffer);
 
+	update_heap_statistics();
+
 	//Do not reset perf counters if we are skipping the next frame
 	if (skip_frame) return;
 
@@ -3273,6 +3761,28 @@ void VKGSRender::flip(int buffer)
 	m_textures_upload_time = 0;
 }
 
+void VKGSRender::update_dynamic_resolution()
+{
+	const u64 gpu_time = m_gpu_timer.get_busy_time();
+	const bool changed = (g_cfg.video.dynamic_resolution && m_gpu_timer.is_supported()) ?
+		m_dynamic_resolution.update(gpu_time) : m_dynamic_resolution.reset();
+
+	if (!changed)
+		return;
+
+	const auto rescaled = m_rtts.rescale_surfaces(*m_device, get_primary_command_buffer());
+
+	//Sections of the texture cache still point at the replaced images. The surfaces hold the data, sections are rebuilt when they are bound again
+	for (const auto &range : rescaled)
+	{
+		m_texture_cache.invalidate_range(range.first, range.second, true, true, false, *m_current_command_buffer, m_swapchain->get_graphics_queue());
+	}
+
+	m_texture_cache.purge_dirty();
+	m_samplers_dirty.store(true);
+	m_rtts_dirty = true;
+}
+
 bool VKGSRender::scaled_image_from_memory(rsx::blit_src_info& src, rsx::blit_dst_info& dst, bool interpolate)
 {
 	if (renderer_unavailable)
@@ -3284,7 +3794,7 @@ bool VKGSRender::scaled_image_from_memory(rsx::blit_src_info& src, rsx::blit_dst
 	//Stop all parallel operations until this is finished
 	std::lock_guard<shared_mutex> lock(m_secondary_cb_guard);
 
-	if (m_texture_cache.blit(src, dst, interpolate, m_rtts, *m_current_command_buffer))
+	if (m_texture_cache.blit(src, dst, interpolate, m_rtts, get_primary_command_buffer()))
 	{
 		m_samplers_dirty.store(true);
 		return true;
@@ -3374,19 +3884,12 @@ void VKGSRender::get_occlusion_query_result(rsx::reports::occlusion_query_info*
 		if (data.command_buffer_to_wait->pending)
 			data.command_buffer_to_wait->wait();
 
-		//Gather data
-		for (const auto occlusion_id : data.indices)
-		{
-			//We only need one hit
-			if (auto value = m_occlusion_query_pool.get_query_result(occlusion_id))
-			{
-				query->result = 1;
-				break;
-			}
-		}
+		//Gather data, we only need one hit
+		if (m_occlusion_query_pool.get_query_result(data.indices))
+			query->result = 1;
 	}
 
-	m_occlusion_query_pool.reset_queries(*m_current_command_buffer, data.indices);
+	m_occlusion_query_pool.reset_queries(get_primary_command_buffer(), data.indices);
 	m_occlusion_map.erase(query->driver_handle);
 }
 
@@ -3406,6 +3909,6 @@ void VKGSRender::discard_occlusion_query(rsx::reports::occlusion_query_info* que
 	if (data.indices.size() == 0)
 		return;
 
-	m_occlusion_query_pool.reset_queries(*m_current_command_buffer, data.indices);
+	m_occlusion_query_pool.reset_queries(get_primary_command_buffer(), data.indices);
 	m_occlusion_map.erase(query->driver_handle);
 }
\ No newline at end of file
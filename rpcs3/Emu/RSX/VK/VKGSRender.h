@@ -13,6 +13,7 @@
 #include "../rsx_utils.h"
 #include <thread>
 #include <atomic>
+#include <condition_variable>
 
 namespace vk
 {
@@ -42,6 +43,10 @@ namespace vk
 #define VK_TRANSFORM_CONSTANTS_BUFFER_SIZE_M 64
 #define VK_INDEX_RING_BUFFER_SIZE_M 64
 
+//Heaps under pressure grow up to this factor of their initial size, and give the memory back once mostly idle
+#define VK_HEAP_MAX_GROWTH_FACTOR 4
+#define VK_HEAP_SHRINK_CHECK_FRAMES 600
+
 #define VK_MAX_ASYNC_CB_COUNT 64
 #define VK_MAX_ASYNC_FRAMES 2
 
@@ -147,6 +152,7 @@ struct frame_context_t
 	VkSemaphore present_semaphore = VK_NULL_HANDLE;
 	VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
 	vk::descriptor_pool descriptor_pool;
+	vk::descriptor_set_cache descriptor_cache;
 	u32 used_descriptors = 0;
 
 	std::vector<std::unique_ptr<vk::buffer_view>> buffer_views_to_clean;
@@ -154,6 +160,7 @@ struct frame_context_t
 
 	u32 present_image = UINT32_MAX;
 	command_buffer_chunk* swap_command_buffer = nullptr;
+	u64 swap_submit_time = 0;
 
 	//Heap pointers
 	s64 attrib_heap_ptr = 0;
@@ -172,6 +179,9 @@ struct frame_context_t
 		descriptor_pool = other.descriptor_pool;
 		used_descriptors = other.used_descriptors;
 
+		//Sets cached by the other context may be recycled once the shared pool is reset
+		descriptor_cache.clear();
+
 		attrib_heap_ptr = other.attrib_heap_ptr;
 		ubo_heap_ptr = other.attrib_heap_ptr;
 		vtxconst_heap_ptr = other.vtxconst_heap_ptr;
@@ -203,6 +213,81 @@ struct frame_context_t
 	}
 };
 
+//Tracks the present cadence and GPU frame latency so flips can be spread out evenly
+struct present_scheduler
+{
+	static constexpr u32 history_length = 16;
+
+	std::array<u64, history_length> present_intervals = {};
+	u32 history_index = 0;
+	u32 history_count = 0;
+	u64 last_present_time = 0;
+
+	//Smoothed time from submitting a swap command buffer to observing its completion
+	u64 gpu_frame_time = 0;
+
+	void on_gpu_complete(u64 submit_time, u64 complete_time)
+	{
+		if (!submit_time || complete_time < submit_time)
+			return;
+
+		const u64 latency = complete_time - submit_time;
+		gpu_frame_time = gpu_frame_time ? (gpu_frame_time * 7 + latency) / 8 : latency;
+	}
+
+	u64 predict_gpu_completion(u64 submit_time) const
+	{
+		return submit_time + gpu_frame_time;
+	}
+
+	u64 get_target_interval() const
+	{
+		if (history_count < history_length / 2)
+			return 0;
+
+		u64 sum = 0;
+		for (u32 n = 0; n < history_count; ++n)
+			sum += present_intervals[n];
+
+		return sum / history_count;
+	}
+
+	//Time to hold a present back so it lands on the average cadence instead of early
+	u64 get_present_delay(u64 now, u64 gpu_ready_time) const
+	{
+		const u64 target = get_target_interval();
+		if (!target || !last_present_time)
+			return 0;
+
+		//Frames that are already late, or will only be ready late, are not held back
+		const u64 slot = last_present_time + target;
+		const u64 ready = std::max(now, gpu_ready_time);
+		if (ready >= slot)
+			return 0;
+
+		//Only smooth out jitter; large gaps are real frame time changes
+		return std::min(slot - ready, target / 4);
+	}
+
+	void on_present(u64 now)
+	{
+		if (last_present_time)
+		{
+			const u64 interval = now - last_present_time;
+
+			//Ignore stalls (loading screens, pauses) so they do not skew the cadence
+			if (interval < 200000)
+			{
+				present_intervals[history_index] = interval;
+				history_index = (history_index + 1) % history_length;
+				history_count = std::min(history_count + 1, history_length);
+			}
+		}
+
+		last_present_time = now;
+	}
+};
+
 struct flush_request_task
 {
 	atomic_t<bool> pending_state{ false };  //Flush request status; true if rsx::thread is yet to service this request
@@ -227,6 +312,7 @@ struct flush_request_task
 	{
 		hard_sync = false;
 		pending_state.store(false);
+		pending_state.notify_all();
 	}
 
 	bool pending() const
@@ -247,10 +333,324 @@ struct flush_request_task
 	{
 		while (pending_state.load())
 		{
-			_mm_lfence();
-			std::this_thread::yield();
+			pending_state.wait(true);
+		}
+	}
+};
+
+//Everything needed to encode one draw, captured on the RSX thread so it can be recorded anywhere
+struct draw_packet
+{
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+
+	VkViewport viewport = {};
+	VkRect2D scissor = {};
+	f32 line_width = 1.f;
+	f32 depth_bias_constant = 0.f;
+	f32 depth_bias_slope = 0.f;
+	f32 depth_bounds_min = 0.f;
+	f32 depth_bounds_max = 1.f;
+	std::array<f32, 4> blend_constants = {};
+
+	//Front and back face values
+	u32 stencil_write_mask[2] = {};
+	u32 stencil_compare_mask[2] = {};
+	u32 stencil_reference[2] = {};
+
+	VkBuffer index_buffer = VK_NULL_HANDLE;
+	VkDeviceSize index_offset = 0;
+	VkIndexType index_type = VK_INDEX_TYPE_UINT16;
+
+	//{count, first vertex or first index}
+	std::vector<std::pair<u32, u32>> draws;
+
+	//All dynamic state is written, secondary command buffers do not inherit any of it
+	void record_state(VkCommandBuffer cmd, VkPipelineLayout layout) const
+	{
+		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &descriptor_set, 0, nullptr);
+
+		vkCmdSetLineWidth(cmd, line_width);
+		vkCmdSetDepthBias(cmd, depth_bias_constant, 0.f, depth_bias_slope);
+		vkCmdSetBlendConstants(cmd, blend_constants.data());
+
+		vkCmdSetStencilWriteMask(cmd, VK_STENCIL_FACE_FRONT_BIT, stencil_write_mask[0]);
+		vkCmdSetStencilCompareMask(cmd, VK_STENCIL_FACE_FRONT_BIT, stencil_compare_mask[0]);
+		vkCmdSetStencilReference(cmd, VK_STENCIL_FACE_FRONT_BIT, stencil_reference[0]);
+		vkCmdSetStencilWriteMask(cmd, VK_STENCIL_FACE_BACK_BIT, stencil_write_mask[1]);
+		vkCmdSetStencilCompareMask(cmd, VK_STENCIL_FACE_BACK_BIT, stencil_compare_mask[1]);
+		vkCmdSetStencilReference(cmd, VK_STENCIL_FACE_BACK_BIT, stencil_reference[1]);
+
+		vkCmdSetDepthBounds(cmd, depth_bounds_min, depth_bounds_max);
+		vkCmdSetViewport(cmd, 0, 1, &viewport);
+		vkCmdSetScissor(cmd, 0, 1, &scissor);
+	}
+
+	void record_draws(VkCommandBuffer cmd) const
+	{
+		if (index_buffer)
+		{
+			vkCmdBindIndexBuffer(cmd, index_buffer, index_offset, index_type);
+
+			for (const auto &draw : draws)
+				vkCmdDrawIndexed(cmd, draw.first, 1, draw.second, 0, 0);
+		}
+		else
+		{
+			for (const auto &draw : draws)
+				vkCmdDraw(cmd, draw.first, 1, draw.second, 0);
+		}
+	}
+};
+
+//Batches consecutive draws into one render pass and encodes them into secondary command buffers on a small worker pool.
+//Workers only run inside flush(), every other access to the pools happens on the RSX thread while they are idle.
+class parallel_draw_recorder
+{
+	struct secondary_buffer
+	{
+		VkCommandBuffer handle;
+		command_buffer_chunk* owner;
+		u64 owner_sync; //Last submission of the owner at the time of use
+	};
+
+	struct worker_context
+	{
+		vk::command_pool pool;
+		std::vector<secondary_buffer> in_flight;
+		std::vector<VkCommandBuffer> available;
+
+		VkCommandBuffer target = VK_NULL_HANDLE;
+		size_t first_packet = 0;
+		size_t last_packet = 0;
+	};
+
+	static constexpr size_t min_packets_per_worker = 32;
+	static constexpr size_t max_batch_size = 1024;
+
+	VkDevice m_device = VK_NULL_HANDLE;
+	VkPipelineLayout m_pipeline_layout = VK_NULL_HANDLE;
+
+	std::vector<worker_context> m_contexts;
+	std::vector<std::thread> m_workers;
+
+	std::mutex m_mutex;
+	std::condition_variable m_work_cv;
+	std::condition_variable m_done_cv;
+	u64 m_generation = 0;
+	u32 m_busy_workers = 0;
+	bool m_exit = false;
+
+	std::vector<draw_packet> m_packets;
+	VkRenderPass m_render_pass = VK_NULL_HANDLE;
+	VkFramebuffer m_framebuffer = VK_NULL_HANDLE;
+	VkExtent2D m_extent = {};
+
+	void record(worker_context &ctx)
+	{
+		VkCommandBufferInheritanceInfo inheritance_info = {};
+		inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritance_info.renderPass = m_render_pass;
+		inheritance_info.subpass = 0;
+		inheritance_info.framebuffer = m_framebuffer;
+
+		VkCommandBufferBeginInfo begin_info = {};
+		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		begin_info.pInheritanceInfo = &inheritance_info;
+
+		CHECK_RESULT(vkBeginCommandBuffer(ctx.target, &begin_info));
+
+		for (size_t n = ctx.first_packet; n < ctx.last_packet; ++n)
+		{
+			m_packets[n].record_state(ctx.target, m_pipeline_layout);
+			m_packets[n].record_draws(ctx.target);
+		}
+
+		CHECK_RESULT(vkEndCommandBuffer(ctx.target));
+	}
+
+	VkCommandBuffer get_secondary_buffer(worker_context &ctx, command_buffer_chunk &owner)
+	{
+		//Buffers can be reused once their primary has been submitted again and retired
+		for (auto It = ctx.in_flight.begin(); It != ctx.in_flight.end();)
+		{
+			if (It->owner->last_sync != It->owner_sync && It->owner->poke())
+			{
+				ctx.available.push_back(It->handle);
+				It = ctx.in_flight.erase(It);
+			}
+			else
+				++It;
+		}
+
+		VkCommandBuffer result;
+		if (!ctx.available.empty())
+		{
+			result = ctx.available.back();
+			ctx.available.pop_back();
+		}
+		else
+		{
+			VkCommandBufferAllocateInfo infos = {};
+			infos.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			infos.commandBufferCount = 1;
+			infos.commandPool = ctx.pool;
+			infos.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			CHECK_RESULT(vkAllocateCommandBuffers(m_device, &infos, &result));
+		}
+
+		ctx.in_flight.push_back({ result, &owner, owner.last_sync });
+		return result;
+	}
+
+public:
+	parallel_draw_recorder() = default;
+	parallel_draw_recorder(const parallel_draw_recorder&) = delete;
+
+	void create(vk::render_device &dev, VkPipelineLayout layout, u32 worker_count)
+	{
+		m_device = dev;
+		m_pipeline_layout = layout;
+		m_contexts.resize(worker_count);
+
+		for (u32 n = 0; n < worker_count; ++n)
+		{
+			m_contexts[n].pool.create(dev);
+			m_workers.emplace_back([this, n]()
+			{
+				u64 last_generation = 0;
+				while (true)
+				{
+					{
+						std::unique_lock<std::mutex> lock(m_mutex);
+						m_work_cv.wait(lock, [&]() { return m_exit || m_generation != last_generation; });
+
+						if (m_exit)
+							return;
+
+						last_generation = m_generation;
+					}
+
+					auto &ctx = m_contexts[n];
+					if (ctx.target)
+						record(ctx);
+
+					std::lock_guard<std::mutex> lock(m_mutex);
+					if (--m_busy_workers == 0)
+						m_done_cv.notify_one();
+				}
+			});
 		}
 	}
+
+	void destroy()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_exit = true;
+		}
+
+		m_work_cv.notify_all();
+
+		for (auto &worker : m_workers)
+			worker.join();
+
+		//Command buffers are released with their pools
+		for (auto &ctx : m_contexts)
+			ctx.pool.destroy();
+
+		m_workers.clear();
+		m_contexts.clear();
+		m_packets.clear();
+	}
+
+	bool empty() const
+	{
+		return m_packets.empty();
+	}
+
+	//False if the draw would have to start a new render pass instance
+	bool can_append(VkRenderPass render_pass, VkFramebuffer framebuffer) const
+	{
+		if (m_packets.empty())
+			return true;
+
+		return render_pass == m_render_pass && framebuffer == m_framebuffer && m_packets.size() < max_batch_size;
+	}
+
+	void append(draw_packet &&packet, VkRenderPass render_pass, VkFramebuffer framebuffer, VkExtent2D extent)
+	{
+		m_render_pass = render_pass;
+		m_framebuffer = framebuffer;
+		m_extent = extent;
+		m_packets.push_back(std::move(packet));
+	}
+
+	//Encodes the batch into the primary command buffer inside a single render pass instance
+	void flush(command_buffer_chunk &primary)
+	{
+		if (m_packets.empty())
+			return;
+
+		const size_t worker_count = std::min(m_contexts.size(), m_packets.size() / min_packets_per_worker);
+
+		VkRenderPassBeginInfo rp_begin = {};
+		rp_begin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		rp_begin.renderPass = m_render_pass;
+		rp_begin.framebuffer = m_framebuffer;
+		rp_begin.renderArea.extent = m_extent;
+
+		if (worker_count < 2)
+		{
+			//Not worth the handoff
+			vkCmdBeginRenderPass(primary, &rp_begin, VK_SUBPASS_CONTENTS_INLINE);
+
+			for (const auto &packet : m_packets)
+			{
+				packet.record_state(primary, m_pipeline_layout);
+				packet.record_draws(primary);
+			}
+
+			vkCmdEndRenderPass(primary);
+			m_packets.clear();
+			return;
+		}
+
+		std::vector<VkCommandBuffer> secondaries(worker_count);
+		const size_t packets_per_worker = (m_packets.size() + worker_count - 1) / worker_count;
+
+		for (size_t n = 0; n < m_contexts.size(); ++n)
+		{
+			auto &ctx = m_contexts[n];
+			if (n < worker_count)
+			{
+				ctx.target = secondaries[n] = get_secondary_buffer(ctx, primary);
+				ctx.first_packet = n * packets_per_worker;
+				ctx.last_packet = std::min(m_packets.size(), ctx.first_packet + packets_per_worker);
+			}
+			else
+			{
+				ctx.target = VK_NULL_HANDLE;
+			}
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_busy_workers = (u32)m_contexts.size();
+			m_generation++;
+			m_work_cv.notify_all();
+
+			m_done_cv.wait(lock, [this]() { return m_busy_workers == 0; });
+		}
+
+		vkCmdBeginRenderPass(primary, &rp_begin, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		vkCmdExecuteCommands(primary, (u32)secondaries.size(), secondaries.data());
+		vkCmdEndRenderPass(primary);
+
+		m_packets.clear();
+	}
 };
 
 class VKGSRender : public GSRender, public ::rsx::reports::ZCULL_control
@@ -282,6 +682,9 @@ private:
 	std::unique_ptr<vk::buffer_view> m_persistent_attribute_storage;
 	std::unique_ptr<vk::buffer_view> m_volatile_attribute_storage;
 
+	std::unique_ptr<vk::host_buffer> m_local_memory_buffer;
+	bool m_local_memory_import_checked = false;
+
 public:
 	//vk::fbo draw_fbo;
 	std::unique_ptr<vk::vertex_cache> m_vertex_cache;
@@ -309,10 +712,20 @@ private:
 	std::array<command_buffer_chunk, VK_MAX_ASYNC_CB_COUNT> m_primary_cb_list;
 	command_buffer_chunk* m_current_command_buffer = nullptr;
 
+	//Only created when multithreaded recording is enabled
+	std::unique_ptr<parallel_draw_recorder> m_draw_recorder;
+
+	//Only created when the device exposes a dedicated transfer queue and async transfers are enabled
+	std::unique_ptr<vk::async_transfer_queue> m_transfer_queue;
+
 	std::array<VkRenderPass, 120> m_render_passes;
 
+	//Variants of the passes above which clear some of their attachments on load, keyed by pass location and clear mask
+	std::unordered_map<u64, VkRenderPass> m_clear_render_passes;
+
 	VkDescriptorSetLayout descriptor_layouts;
 	VkPipelineLayout pipeline_layout;
+	vk::descriptor_set_builder m_descriptor_builder;
 
 	std::unique_ptr<vk::framebuffer_holder> m_draw_fbo;
 
@@ -320,6 +733,9 @@ private:
 	bool renderer_unavailable = false;
 
 	u64 m_last_heap_sync_time = 0;
+	u32 m_heap_shrink_check_frames = 0;
+	bool m_heap_shrink_pending = false;
+	vk::mem_allocator_stats m_last_allocator_stats;
 	vk::vk_data_heap m_attrib_ring_info;
 	vk::vk_data_heap m_uniform_buffer_ring_info;
 	vk::vk_data_heap m_transform_constants_ring_info;
@@ -340,6 +756,13 @@ private:
 	u32 m_current_queue_index = 0;
 	frame_context_t* m_current_frame = nullptr;
 
+	present_scheduler m_present_scheduler;
+
+	//Dynamic resolution
+	vk::gpu_timer_pool m_gpu_timer;
+	rsx::dynamic_resolution_controller m_dynamic_resolution;
+	utils::memory_gauge m_heap_memory_gauge{ utils::memory_class::gpu_heaps };
+
 	u32 m_client_width = 0;
 	u32 m_client_height = 0;
 
@@ -363,8 +786,15 @@ private:
 	std::atomic<u64> m_last_sync_event = { 0 };
 
 	bool render_pass_open = false;
+	VkFramebuffer m_render_pass_framebuffer = VK_NULL_HANDLE;
 	size_t m_current_renderpass_id = 0;
 
+	//Full surface clears not recorded yet, folded into the load ops of the next render pass over the same framebuffer
+	//Bits 0-3 select the color attachments, the depth and stencil bits follow
+	vk::framebuffer_holder* m_pending_clear_target = nullptr;
+	u32 m_pending_clear_mask = 0;
+	std::array<VkClearValue, 5> m_pending_clear_values;
+
 	//Vertex layout
 	rsx::vertex_input_layout m_vertex_layout;
 
@@ -391,22 +821,44 @@ private:
 	void present(frame_context_t *ctx);
 	void reinitialize_swapchain();
 
+	//Render passes stay open across draws to the same framebuffer and are closed by any recording outside of them
 	void begin_render_pass();
 	void close_render_pass();
+	void open_render_pass(vk::framebuffer_holder& fbo);
+	VkRenderPass get_clear_render_pass(VkFormat color_format, u8 color_count, VkFormat depth_format, u32 clear_mask);
 
-	void update_draw_state();
+	//Full area clears are deferred, anything else is recorded into the current render pass
+	void clear_attachments(const std::vector<VkClearAttachment>& clears, const VkClearRect& region);
+	void flush_pending_clear();
+
+	void update_draw_state(draw_packet& packet);
+	void commit_descriptors();
+
+	//Retires pending clears and batched draws so that anything recorded afterwards stays in submission order
+	void flush_draw_batch();
+	command_buffer_chunk& get_primary_command_buffer()
+	{
+		close_render_pass();
+		flush_draw_batch();
+		return *m_current_command_buffer;
+	}
 
+	std::array<vk::vk_data_heap*, 5> get_upload_heaps();
 	void check_heap_status();
+	void resize_upload_heaps(u32 grow_mask);
+	void update_heap_statistics();
+	void update_dynamic_resolution();
 
 	vk::vertex_upload_info upload_vertex_data();
+	bool get_local_memory_window(u32 address, u32 size, u32& window_offset);
 
 public:
 	bool check_program_status();
-	void load_program(const vk::vertex_upload_info& vertex_info);
+	bool load_program(const vk::vertex_upload_info& vertex_info);
 	void init_buffers(rsx::framebuffer_creation_context context, bool skip_reading = false);
 	void read_buffers();
 	void write_buffers();
-	void set_viewport();
+	void set_viewport(draw_packet& packet);
 
 	void begin_occlusion_query(rsx::reports::occlusion_query_info* query) override;
 	void end_occlusion_query(rsx::reports::occlusion_query_info* query) override;
@@ -152,6 +152,10 @@ namespace vk
 	void insert_buffer_memory_barrier(VkCommandBuffer cmd, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize length,
 			VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage, VkAccessFlags src_mask, VkAccessFlags dst_mask);
 
+	//Queue family ownership transfer, must be issued with matching arguments on both the releasing and the acquiring queue
+	void insert_image_ownership_barrier(VkCommandBuffer cmd, VkImage image, VkImageLayout current_layout, VkImageLayout new_layout, VkImageSubresourceRange range,
+			u32 src_queue_family, u32 dst_queue_family, VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage, VkAccessFlags src_mask, VkAccessFlags dst_mask);
+
 	//Manage 'uininterruptible' state where secondary operations (e.g violation handlers) will have to wait
 	void enter_uninterruptible();
 	void leave_uninterruptible();
@@ -179,6 +183,15 @@ namespace vk
 		bool d32_sfloat_s8;
 	};
 
+	struct mem_allocator_stats
+	{
+		u64 allocations = 0;        //Total number of resource allocations
+		u64 frees = 0;              //Total number of resource frees
+		u64 device_allocations = 0; //Live vkAllocateMemory blocks
+		u64 used_bytes = 0;         //Memory handed out to resources
+		u64 reserved_bytes = 0;     //Memory allocated from the driver
+	};
+
 	// Memory Allocator - base class
 
 	class mem_allocator_base
@@ -198,6 +211,9 @@ namespace vk
 		virtual VkDeviceMemory get_vk_device_memory(mem_handle_t mem_handle) = 0;
 		virtual u64 get_vk_device_memory_offset(mem_handle_t mem_handle) = 0;
 
+		//Not every backend keeps track of its usage
+		virtual mem_allocator_stats get_stats() { return{}; }
+
 	protected:
 		VkDevice m_device;
 	private:
@@ -332,6 +348,263 @@ namespace vk
 	private:
 	};
 
+	// Memory Allocator - size class suballocator
+	// Resources up to max_pooled_size share device memory blocks split into equally sized slots, larger ones get a dedicated allocation.
+	// Keeps the number of driver allocations low with the constant texture cache churn
+
+	class mem_allocator_pool : public mem_allocator_base
+	{
+		static constexpr u64 min_slot_size = 0x1000;
+		static constexpr u64 max_pooled_size = 0x1000000;
+		static constexpr u64 target_chunk_size = 0x1000000;
+
+		struct chunk
+		{
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			u64 slot_size = 0;
+			u32 slot_count = 0;
+			std::vector<u32> free_slots;
+
+			u8* mapped = nullptr;
+			u32 map_count = 0;
+		};
+
+		struct allocation
+		{
+			chunk* owner;           //nullptr for dedicated allocations
+			VkDeviceMemory memory;
+			u64 offset;
+			u64 size;
+			u64 key;
+		};
+
+		std::mutex m_mutex;
+		std::unordered_map<u64, std::vector<std::unique_ptr<chunk>>> m_pools;
+		mem_allocator_stats m_stats;
+
+		u64 m_granularity = 1;
+		u32 m_allocation_limit = UINT32_MAX;
+		bool m_limit_reported = false;
+
+		static u64 get_size_class(u64 size)
+		{
+			//Four classes per power of two keeps the slot waste under 25%
+			u64 base = min_slot_size;
+			while ((base * 2) < size)
+				base *= 2;
+
+			return align(size, std::max(base / 4, min_slot_size));
+		}
+
+		VkDeviceMemory allocate_device_memory(u64 size, uint32_t memory_type_index)
+		{
+			VkDeviceMemory memory;
+			VkMemoryAllocateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			info.allocationSize = size;
+			info.memoryTypeIndex = memory_type_index;
+
+			CHECK_RESULT(vkAllocateMemory(m_device, &info, nullptr, &memory));
+
+			m_stats.device_allocations++;
+			m_stats.reserved_bytes += size;
+
+			if (!m_limit_reported && m_stats.device_allocations >= (m_allocation_limit - m_allocation_limit / 8))
+			{
+				LOG_WARNING(RSX, "Approaching the driver memory allocation limit (%llu/%u)", m_stats.device_allocations, m_allocation_limit);
+				m_limit_reported = true;
+			}
+
+			return memory;
+		}
+
+		void free_device_memory(VkDeviceMemory memory, u64 size)
+		{
+			vkFreeMemory(m_device, memory, nullptr);
+
+			m_stats.device_allocations--;
+			m_stats.reserved_bytes -= size;
+		}
+
+	public:
+		mem_allocator_pool(VkDevice dev, VkPhysicalDevice pdev) : mem_allocator_base(dev, pdev)
+		{
+			VkPhysicalDeviceProperties props;
+			vkGetPhysicalDeviceProperties(pdev, &props);
+
+			//Keeping slots granularity aligned allows linear and optimal resources to share a block
+			m_granularity = std::max<u64>(props.limits.bufferImageGranularity, 1);
+			m_allocation_limit = props.limits.maxMemoryAllocationCount;
+		}
+
+		~mem_allocator_pool() {};
+
+		void destroy() override
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			for (auto &pool : m_pools)
+			{
+				for (auto &block : pool.second)
+				{
+					if (block->free_slots.size() != block->slot_count)
+						LOG_ERROR(RSX, "Memory pool destroyed with %u live allocation(s)", block->slot_count - (u32)block->free_slots.size());
+
+					free_device_memory(block->memory, block->slot_size * block->slot_count);
+				}
+			}
+
+			m_pools.clear();
+		}
+
+		mem_handle_t alloc(u64 block_sz, u64 alignment, uint32_t memory_type_index) override
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_stats.allocations++;
+			m_stats.used_bytes += block_sz;
+
+			if (block_sz > max_pooled_size)
+			{
+				const VkDeviceMemory memory = allocate_device_memory(block_sz, memory_type_index);
+				return new allocation{ nullptr, memory, 0, block_sz, 0 };
+			}
+
+			const u64 slot_size = align(get_size_class(block_sz), std::max(alignment, m_granularity));
+			const u64 key = (slot_size << 5) | memory_type_index;
+			auto &chunks = m_pools[key];
+
+			chunk *target = nullptr;
+			for (auto It = chunks.rbegin(); It != chunks.rend(); ++It)
+			{
+				if (!(*It)->free_slots.empty())
+				{
+					target = It->get();
+					break;
+				}
+			}
+
+			if (!target)
+			{
+				auto block = std::make_unique<chunk>();
+				block->slot_size = slot_size;
+				block->slot_count = (u32)std::clamp<u64>(target_chunk_size / slot_size, 4, 256);
+				block->memory = allocate_device_memory(slot_size * block->slot_count, memory_type_index);
+
+				block->free_slots.resize(block->slot_count);
+				for (u32 n = 0; n < block->slot_count; ++n)
+					block->free_slots[n] = block->slot_count - n - 1;
+
+				target = block.get();
+				chunks.push_back(std::move(block));
+			}
+
+			const u32 slot = target->free_slots.back();
+			target->free_slots.pop_back();
+
+			return new allocation{ target, target->memory, slot * slot_size, block_sz, key };
+		}
+
+		void free(mem_handle_t mem_handle) override
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			auto alloc = static_cast<allocation*>(mem_handle);
+			m_stats.frees++;
+			m_stats.used_bytes -= alloc->size;
+
+			if (!alloc->owner)
+			{
+				free_device_memory(alloc->memory, alloc->size);
+				delete alloc;
+				return;
+			}
+
+			auto block = alloc->owner;
+			block->free_slots.push_back((u32)(alloc->offset / block->slot_size));
+
+			if (block->free_slots.size() == block->slot_count && block->map_count == 0)
+			{
+				//Keep a single empty block around per class to absorb churn
+				auto &chunks = m_pools[alloc->key];
+				const auto empty_blocks = std::count_if(chunks.begin(), chunks.end(), [](const std::unique_ptr<chunk>& c)
+				{
+					return c->free_slots.size() == c->slot_count;
+				});
+
+				if (empty_blocks > 1)
+				{
+					free_device_memory(block->memory, block->slot_size * block->slot_count);
+					chunks.erase(std::find_if(chunks.begin(), chunks.end(), [block](const std::unique_ptr<chunk>& c) { return c.get() == block; }));
+				}
+			}
+
+			delete alloc;
+		}
+
+		void *map(mem_handle_t mem_handle, u64 offset, u64 size) override
+		{
+			auto alloc = static_cast<allocation*>(mem_handle);
+			void *data = nullptr;
+
+			if (!alloc->owner)
+			{
+				CHECK_RESULT(vkMapMemory(m_device, alloc->memory, offset, std::max<u64>(size, 1u), 0, &data));
+				return data;
+			}
+
+			//A block can only be mapped once, slots share the mapping
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			auto block = alloc->owner;
+			if (block->map_count++ == 0)
+			{
+				CHECK_RESULT(vkMapMemory(m_device, block->memory, 0, VK_WHOLE_SIZE, 0, &data));
+				block->mapped = static_cast<u8*>(data);
+			}
+
+			return block->mapped + alloc->offset + offset;
+		}
+
+		void unmap(mem_handle_t mem_handle) override
+		{
+			auto alloc = static_cast<allocation*>(mem_handle);
+
+			if (!alloc->owner)
+			{
+				vkUnmapMemory(m_device, alloc->memory);
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			auto block = alloc->owner;
+			verify(HERE), block->map_count;
+
+			if (--block->map_count == 0)
+			{
+				vkUnmapMemory(m_device, block->memory);
+				block->mapped = nullptr;
+			}
+		}
+
+		VkDeviceMemory get_vk_device_memory(mem_handle_t mem_handle) override
+		{
+			return static_cast<allocation*>(mem_handle)->memory;
+		}
+
+		u64 get_vk_device_memory_offset(mem_handle_t mem_handle) override
+		{
+			return static_cast<allocation*>(mem_handle)->offset;
+		}
+
+		mem_allocator_stats get_stats() override
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_stats;
+		}
+	};
+
 	struct memory_block
 	{
 		memory_block(VkDevice dev, u64 block_sz, u64 alignment, uint32_t memory_type_index) : m_device(dev)
@@ -381,6 +654,11 @@ namespace vk
 		VkPhysicalDeviceMemoryProperties memory_properties;
 		std::vector<VkQueueFamilyProperties> queue_props;
 
+#ifdef VK_EXT_memory_budget
+		//Only loaded if the instance enabled VK_KHR_get_physical_device_properties2
+		PFN_vkGetPhysicalDeviceMemoryProperties2KHR get_memory_properties2 = nullptr;
+#endif
+
 	public:
 
 		physical_device() {}
@@ -398,6 +676,11 @@ namespace vk
 			return props.deviceName;
 		}
 
+		const VkPhysicalDeviceProperties& get_properties() const
+		{
+			return props;
+		}
+
 		uint32_t get_queue_count() const
 		{
 			if (queue_props.size())
@@ -429,6 +712,32 @@ namespace vk
 			return memory_properties;
 		}
 
+#ifdef VK_EXT_memory_budget
+		void set_memory_properties2_proc(PFN_vkGetPhysicalDeviceMemoryProperties2KHR proc)
+		{
+			get_memory_properties2 = proc;
+		}
+
+		bool has_memory_properties2() const
+		{
+			return get_memory_properties2 != nullptr;
+		}
+
+		//Current per heap budget and usage of this process, the device has to expose VK_EXT_memory_budget
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT get_memory_budget() const
+		{
+			VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+			budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+			VkPhysicalDeviceMemoryProperties2KHR properties = {};
+			properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+			properties.pNext = &budget;
+
+			get_memory_properties2(dev, &properties);
+			return budget;
+		}
+#endif
+
 		operator VkPhysicalDevice() const
 		{
 			return dev;
@@ -443,6 +752,12 @@ namespace vk
 		std::unique_ptr<mem_allocator_base> m_allocator;
 		VkDevice dev = VK_NULL_HANDLE;
 
+		uint32_t m_graphics_queue_family = UINT32_MAX;
+		uint32_t m_transfer_queue_family = UINT32_MAX;
+
+		bool m_external_memory_host_support = false;
+		bool m_memory_budget_support = false;
+
 	public:
 		render_device()
 		{}
@@ -455,19 +770,106 @@ namespace vk
 			float queue_priorities[1] = { 0.f };
 			pgpu = &pdev;
 
-			VkDeviceQueueCreateInfo queue = {};
-			queue.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-			queue.pNext = NULL;
-			queue.queueFamilyIndex = graphics_queue_idx;
-			queue.queueCount = 1;
-			queue.pQueuePriorities = queue_priorities;
+			VkDeviceQueueCreateInfo queues[2] = {};
+			u32 queue_count = 1;
+
+			queues[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queues[0].pNext = NULL;
+			queues[0].queueFamilyIndex = graphics_queue_idx;
+			queues[0].queueCount = 1;
+			queues[0].pQueuePriorities = queue_priorities;
+
+			m_graphics_queue_family = graphics_queue_idx;
+			m_transfer_queue_family = UINT32_MAX;
+
+			if (g_cfg.video.vk.async_transfer && graphics_queue_idx != UINT32_MAX)
+			{
+				//Look for a dedicated DMA queue family, graphics capable families share the same hardware queue anyway
+				for (u32 i = 0; i < pdev.get_queue_count(); ++i)
+				{
+					const auto flags = pdev.get_queue_properties(i).queueFlags;
+					if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+					{
+						m_transfer_queue_family = i;
+						break;
+					}
+				}
+
+				if (m_transfer_queue_family != UINT32_MAX)
+				{
+					queues[1] = queues[0];
+					queues[1].queueFamilyIndex = m_transfer_queue_family;
+					queue_count++;
+				}
+				else
+				{
+					LOG_NOTICE(RSX, "No dedicated transfer queue found, uploads will use the graphics queue");
+				}
+			}
 
 			//Set up instance information
-			const char *requested_extensions[] =
+			std::vector<const char*> requested_extensions =
 			{
 				VK_KHR_SWAPCHAIN_EXTENSION_NAME
 			};
 
+			m_external_memory_host_support = false;
+#ifdef VK_EXT_external_memory_host
+			if (g_cfg.video.vk.import_local_memory)
+			{
+				u32 extension_count = 0;
+				vkEnumerateDeviceExtensionProperties(*pgpu, nullptr, &extension_count, nullptr);
+
+				std::vector<VkExtensionProperties> extensions(extension_count);
+				vkEnumerateDeviceExtensionProperties(*pgpu, nullptr, &extension_count, extensions.data());
+
+				bool external_memory = false, external_memory_host = false;
+				for (const auto& ext : extensions)
+				{
+					if (!strcmp(ext.extensionName, VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME)) external_memory = true;
+					if (!strcmp(ext.extensionName, VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME)) external_memory_host = true;
+				}
+
+				if (external_memory && external_memory_host)
+				{
+					requested_extensions.push_back(VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME);
+					requested_extensions.push_back(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME);
+					m_external_memory_host_support = true;
+				}
+				else
+				{
+					LOG_NOTICE(RSX, "VK_EXT_external_memory_host is not supported, local memory will be uploaded through the staging heaps");
+				}
+			}
+#endif
+
+			m_memory_budget_support = false;
+#ifdef VK_EXT_memory_budget
+			if (pdev.has_memory_properties2())
+			{
+				u32 extension_count = 0;
+				vkEnumerateDeviceExtensionProperties(*pgpu, nullptr, &extension_count, nullptr);
+
+				std::vector<VkExtensionProperties> extensions(extension_count);
+				vkEnumerateDeviceExtensionProperties(*pgpu, nullptr, &extension_count, extensions.data());
+
+				for (const auto& ext : extensions)
+				{
+					if (!strcmp(ext.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME))
+					{
+						requested_extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+						m_memory_budget_support = true;
+						break;
+					}
+				}
+			}
+
+			if (!m_memory_budget_support)
+			{
+				LOG_NOTICE(RSX, "VK_EXT_memory_budget is not supported, the texture cache will not be trimmed to the device memory budget");
+			}
+#endif
+
 			//Enable hardware features manually
 			//Currently we require:
 			//1. Anisotropic sampling
@@ -483,12 +885,12 @@ namespace vk
 			VkDeviceCreateInfo device = {};
 			device.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 			device.pNext = NULL;
-			device.queueCreateInfoCount = 1;
-			device.pQueueCreateInfos = &queue;
+			device.queueCreateInfoCount = queue_count;
+			device.pQueueCreateInfos = queues;
 			device.enabledLayerCount = 0;
 			device.ppEnabledLayerNames = nullptr; // Deprecated
-			device.enabledExtensionCount = 1;
-			device.ppEnabledExtensionNames = requested_extensions;
+			device.enabledExtensionCount = (u32)requested_extensions.size();
+			device.ppEnabledExtensionNames = requested_extensions.data();
 			device.pEnabledFeatures = &available_features;
 
 			CHECK_RESULT(vkCreateDevice(*pgpu, &device, nullptr, &dev));
@@ -496,7 +898,9 @@ namespace vk
 			memory_map = vk::get_memory_mapping(pdev);
 			m_formats_support = vk::get_optimal_tiling_supported_formats(pdev);
 
-			if (g_cfg.video.disable_vulkan_mem_allocator)
+			if (g_cfg.video.vk.size_class_allocator)
+				m_allocator = std::make_unique<vk::mem_allocator_pool>(dev, pdev);
+			else if (g_cfg.video.disable_vulkan_mem_allocator)
 				m_allocator = std::make_unique<vk::mem_allocator_vk>(dev, pdev);
 			else
 				m_allocator = std::make_unique<vk::mem_allocator_vma>(dev, pdev);
@@ -560,6 +964,40 @@ namespace vk
 			return m_allocator.get();
 		}
 
+		uint32_t get_graphics_queue_family() const
+		{
+			return m_graphics_queue_family;
+		}
+
+		//Returns UINT32_MAX if no dedicated transfer queue was created
+		uint32_t get_transfer_queue_family() const
+		{
+			return m_transfer_queue_family;
+		}
+
+		//True if host allocations can be imported as device memory (VK_EXT_external_memory_host)
+		bool get_external_memory_host_support() const
+		{
+			return m_external_memory_host_support;
+		}
+
+		//Budget and current usage of the device local heap in bytes (VK_EXT_memory_budget). Returns false if the driver can't tell
+		bool get_device_local_budget(u64& budget, u64& usage) const
+		{
+#ifdef VK_EXT_memory_budget
+			if (m_memory_budget_support)
+			{
+				const auto heap = pgpu->get_memory_properties().memoryTypes[memory_map.device_local].heapIndex;
+				const auto properties = pgpu->get_memory_budget();
+
+				budget = properties.heapBudget[heap];
+				usage = properties.heapUsage[heap];
+				return true;
+			}
+#endif
+			return false;
+		}
+
 		operator VkDevice() const
 		{
 			return dev;
@@ -766,8 +1204,119 @@ namespace vk
 		buffer(const buffer&) = delete;
 		buffer(buffer&&) = delete;
 
-	private:
-		VkDevice m_device;
+	private:
+		VkDevice m_device;
+	};
+
+	//Buffer aliasing existing host memory, the memory is owned by the caller and must outlive the buffer
+	struct host_buffer
+	{
+		VkBuffer value = VK_NULL_HANDLE;
+		VkBufferCreateInfo info = {};
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+
+		host_buffer(const vk::render_device& dev, void* host_address, u64 size, VkBufferUsageFlags usage)
+			: m_device(dev)
+		{
+#ifdef VK_EXT_external_memory_host
+			if (!dev.get_external_memory_host_support())
+				return;
+
+			auto getMemoryHostPointerProperties = (PFN_vkGetMemoryHostPointerPropertiesEXT)vkGetDeviceProcAddr(dev, "vkGetMemoryHostPointerPropertiesEXT");
+			if (!getMemoryHostPointerProperties)
+				return;
+
+			VkMemoryHostPointerPropertiesEXT host_properties = {};
+			host_properties.sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT;
+
+			if (getMemoryHostPointerProperties(dev, VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT, host_address, &host_properties) != VK_SUCCESS)
+			{
+				LOG_WARNING(RSX, "Host address 0x%llx cannot be imported", (u64)host_address);
+				return;
+			}
+
+			VkExternalMemoryBufferCreateInfoKHR external_info = {};
+			external_info.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO_KHR;
+			external_info.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+
+			info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			info.pNext = &external_info;
+			info.size = size;
+			info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			info.usage = usage;
+
+			CHECK_RESULT(vkCreateBuffer(m_device, &info, nullptr, &value));
+			info.pNext = nullptr;
+
+			VkMemoryRequirements memory_reqs;
+			vkGetBufferMemoryRequirements(m_device, value, &memory_reqs);
+
+			u32 memory_type_index;
+			if (!dev.get_compatible_memory_type(memory_reqs.memoryTypeBits & host_properties.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &memory_type_index))
+			{
+				LOG_WARNING(RSX, "No compatible memory type found for imported host memory");
+				destroy();
+				return;
+			}
+
+			VkImportMemoryHostPointerInfoEXT import_info = {};
+			import_info.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT;
+			import_info.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+			import_info.pHostPointer = host_address;
+
+			VkMemoryAllocateInfo alloc_info = {};
+			alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			alloc_info.pNext = &import_info;
+			alloc_info.allocationSize = size;
+			alloc_info.memoryTypeIndex = memory_type_index;
+
+			if (vkAllocateMemory(m_device, &alloc_info, nullptr, &memory) != VK_SUCCESS)
+			{
+				LOG_WARNING(RSX, "Failed to import host memory (0x%llx bytes)", size);
+				memory = VK_NULL_HANDLE;
+				destroy();
+				return;
+			}
+
+			vkBindBufferMemory(m_device, value, memory, 0);
+#endif
+		}
+
+		~host_buffer()
+		{
+			destroy();
+		}
+
+		bool valid() const
+		{
+			return memory != VK_NULL_HANDLE;
+		}
+
+		u32 size() const
+		{
+			return (u32)info.size;
+		}
+
+		host_buffer(const host_buffer&) = delete;
+		host_buffer(host_buffer&&) = delete;
+
+	private:
+		VkDevice m_device;
+
+		void destroy()
+		{
+			if (value)
+			{
+				vkDestroyBuffer(m_device, value, nullptr);
+				value = VK_NULL_HANDLE;
+			}
+
+			if (memory)
+			{
+				vkFreeMemory(m_device, memory, nullptr);
+				memory = VK_NULL_HANDLE;
+			}
+		}
 	};
 
 	struct buffer_view
@@ -957,12 +1506,13 @@ namespace vk
 		command_pool() {}
 		~command_pool() {}
 
-		void create(vk::render_device &dev)
+		void create(vk::render_device &dev, uint32_t queue_family = 0)
 		{
 			owner = &dev;
 			VkCommandPoolCreateInfo infos = {};
 			infos.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 			infos.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			infos.queueFamilyIndex = queue_family;
 
 			CHECK_RESULT(vkCreateCommandPool(dev, &infos, nullptr, &pool));
 		}
@@ -996,6 +1546,10 @@ namespace vk
 		vk::command_pool *pool = nullptr;
 		VkCommandBuffer commands = nullptr;
 
+		//Extra semaphores the next submission has to wait on, e.g async transfers consumed by this command buffer
+		std::vector<VkSemaphore> m_wait_semaphores;
+		std::vector<VkPipelineStageFlags> m_wait_stages;
+
 	public:
 		enum access_type_hint
 		{
@@ -1063,6 +1617,12 @@ namespace vk
 			is_open = false;
 		}
 
+		void add_wait_semaphore(VkSemaphore semaphore, VkPipelineStageFlags stage)
+		{
+			m_wait_semaphores.push_back(semaphore);
+			m_wait_stages.push_back(stage);
+		}
+
 		void submit(VkQueue queue, const std::vector<VkSemaphore> &semaphores, VkFence fence, VkPipelineStageFlags pipeline_stage_flags)
 		{
 			if (is_open)
@@ -1071,12 +1631,21 @@ namespace vk
 				return;
 			}
 
+			//One stage mask is required per wait semaphore
+			std::vector<VkSemaphore> wait_semaphores = semaphores;
+			std::vector<VkPipelineStageFlags> wait_stages(semaphores.size(), pipeline_stage_flags);
+
+			wait_semaphores.insert(wait_semaphores.end(), m_wait_semaphores.begin(), m_wait_semaphores.end());
+			wait_stages.insert(wait_stages.end(), m_wait_stages.begin(), m_wait_stages.end());
+			m_wait_semaphores.clear();
+			m_wait_stages.clear();
+
 			VkSubmitInfo infos = {};
 			infos.commandBufferCount = 1;
 			infos.pCommandBuffers = &commands;
-			infos.pWaitDstStageMask = &pipeline_stage_flags;
-			infos.pWaitSemaphores = semaphores.data();
-			infos.waitSemaphoreCount = static_cast<uint32_t>(semaphores.size());
+			infos.pWaitDstStageMask = wait_stages.data();
+			infos.pWaitSemaphores = wait_semaphores.data();
+			infos.waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size());
 			infos.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
 			acquire_global_submit_lock();
@@ -1085,6 +1654,135 @@ namespace vk
 		}
 	};
 
+	//Records uploads on a dedicated transfer queue so they can overlap work already queued on the graphics queue.
+	//Each upload is submitted on its own and signals a semaphore the consuming graphics command buffer waits on.
+	class async_transfer_queue
+	{
+		struct submission
+		{
+			command_buffer cmd;
+			VkFence fence = VK_NULL_HANDLE;
+			VkSemaphore semaphore = VK_NULL_HANDLE;
+			u64 frame_tag = 0;
+			bool pending = false;
+		};
+
+		vk::render_device *m_device = nullptr;
+		VkQueue m_queue = VK_NULL_HANDLE;
+		command_pool m_command_pool;
+
+		std::array<submission, 16> m_submissions;
+		u32 m_current = 0;
+		bool m_recording = false;
+
+		bool is_free(submission &sub) const
+		{
+			if (!sub.pending)
+				return true;
+
+			//The semaphore can only be signaled again once the graphics side wait has executed
+			if (sub.frame_tag >= vk::get_last_completed_frame_id())
+				return false;
+
+			return vkGetFenceStatus(*m_device, sub.fence) == VK_SUCCESS;
+		}
+
+	public:
+		void create(vk::render_device &dev, VkQueue queue)
+		{
+			m_device = &dev;
+			m_queue = queue;
+			m_command_pool.create(dev, dev.get_transfer_queue_family());
+
+			VkFenceCreateInfo fence_info = {};
+			fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+			VkSemaphoreCreateInfo semaphore_info = {};
+			semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+			for (auto &sub : m_submissions)
+			{
+				sub.cmd.create(m_command_pool);
+				CHECK_RESULT(vkCreateFence(dev, &fence_info, nullptr, &sub.fence));
+				CHECK_RESULT(vkCreateSemaphore(dev, &semaphore_info, nullptr, &sub.semaphore));
+			}
+		}
+
+		void destroy()
+		{
+			if (!m_device)
+				return;
+
+			for (auto &sub : m_submissions)
+			{
+				if (sub.pending)
+					CHECK_RESULT(vkWaitForFences(*m_device, 1, &sub.fence, VK_TRUE, UINT64_MAX));
+
+				sub.cmd.destroy();
+				vkDestroyFence(*m_device, sub.fence, nullptr);
+				vkDestroySemaphore(*m_device, sub.semaphore, nullptr);
+				sub.pending = false;
+			}
+
+			m_command_pool.destroy();
+			m_device = nullptr;
+		}
+
+		u32 get_queue_family() const
+		{
+			return m_device->get_transfer_queue_family();
+		}
+
+		//Returns an open command buffer, or nullptr if all slots are still in flight and the caller should use the graphics queue
+		command_buffer* begin()
+		{
+			verify(HERE), !m_recording;
+
+			auto &sub = m_submissions[m_current];
+			if (!is_free(sub))
+				return nullptr;
+
+			if (sub.pending)
+			{
+				vk::reset_fence(&sub.fence);
+				sub.pending = false;
+			}
+
+			CHECK_RESULT(vkResetCommandBuffer(sub.cmd, 0));
+			sub.cmd.begin();
+			m_recording = true;
+			return &sub.cmd;
+		}
+
+		//Submits the open command buffer; consumer must be submitted on the graphics queue within the current frame
+		void submit(command_buffer &consumer, VkPipelineStageFlags wait_stage)
+		{
+			verify(HERE), m_recording;
+
+			auto &sub = m_submissions[m_current];
+			sub.cmd.end();
+
+			VkCommandBuffer cmd = sub.cmd;
+			VkSubmitInfo infos = {};
+			infos.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			infos.commandBufferCount = 1;
+			infos.pCommandBuffers = &cmd;
+			infos.signalSemaphoreCount = 1;
+			infos.pSignalSemaphores = &sub.semaphore;
+
+			acquire_global_submit_lock();
+			CHECK_RESULT(vkQueueSubmit(m_queue, 1, &infos, sub.fence));
+			release_global_submit_lock();
+
+			consumer.add_wait_semaphore(sub.semaphore, wait_stage);
+
+			sub.frame_tag = vk::get_current_frame_id();
+			sub.pending = true;
+			m_recording = false;
+			m_current = (m_current + 1) % m_submissions.size();
+		}
+	};
+
 	class swapchain_image_WSI
 	{
 		VkImageView view = nullptr;
@@ -1200,6 +1898,7 @@ public:
 		uint32_t m_graphics_queue = UINT32_MAX;
 		VkQueue vk_graphics_queue = VK_NULL_HANDLE;
 		VkQueue vk_present_queue = VK_NULL_HANDLE;
+		VkQueue vk_transfer_queue = VK_NULL_HANDLE;
 
 		display_handle_t window_handle{};
 		u32 m_width = 0;
@@ -1215,6 +1914,7 @@ public:
 
 			if (_graphics_queue < UINT32_MAX) vkGetDeviceQueue(dev, _graphics_queue, 0, &vk_graphics_queue);
 			if (_present_queue < UINT32_MAX) vkGetDeviceQueue(dev, _present_queue, 0, &vk_present_queue);
+			if (dev.get_transfer_queue_family() < UINT32_MAX) vkGetDeviceQueue(dev, dev.get_transfer_queue_family(), 0, &vk_transfer_queue);
 
 			m_present_queue = _present_queue;
 			m_graphics_queue = _graphics_queue;
@@ -1256,6 +1956,12 @@ public:
 			return vk_graphics_queue;
 		}
 
+		//VK_NULL_HANDLE if the device has no dedicated transfer queue
+		const VkQueue& get_transfer_queue()
+		{
+			return vk_transfer_queue;
+		}
+
 		const VkFormat get_surface_format()
 		{
 			return m_surface_format;
@@ -1777,6 +2483,9 @@ public:
 		std::vector<VkInstance> m_vk_instances;
 		VkInstance m_instance;
 
+		//Instances created with VK_KHR_get_physical_device_properties2
+		std::vector<VkInstance> m_properties2_instances;
+
 		PFN_vkDestroyDebugReportCallbackEXT destroyDebugReportCallback = nullptr;
 		PFN_vkCreateDebugReportCallbackEXT createDebugReportCallback = nullptr;
 		VkDebugReportCallbackEXT m_debugger = nullptr;
@@ -1814,6 +2523,8 @@ public:
 				vkDestroyInstance(inst, nullptr);
 			}
 
+			m_properties2_instances.clear();
+
 			m_instance = nullptr;
 			m_vk_instances.resize(0);
 		}
@@ -1887,6 +2598,13 @@ public:
 			}
 #endif //(!APPLE)
 
+#ifdef VK_EXT_memory_budget
+			//Needed to query the device memory budget
+			const bool properties2 = !fast && supported_extensions().is_supported(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+			if (properties2)
+				extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+#endif
+
 			VkInstanceCreateInfo instance_info = {};
 			instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 			instance_info.pApplicationInfo = &app;
@@ -1900,6 +2618,12 @@ public:
 				return 0;
 
 			m_vk_instances.push_back(instance);
+
+#ifdef VK_EXT_memory_budget
+			if (properties2)
+				m_properties2_instances.push_back(instance);
+#endif
+
 			return (u32)m_vk_instances.size();
 		}
 
@@ -1949,8 +2673,19 @@ public:
 
 				CHECK_RESULT(vkEnumeratePhysicalDevices(m_instance, &num_gpus, pdevs.data()));
 
+#ifdef VK_EXT_memory_budget
+				PFN_vkGetPhysicalDeviceMemoryProperties2KHR get_memory_properties2 = nullptr;
+				if (std::find(m_properties2_instances.begin(), m_properties2_instances.end(), m_instance) != m_properties2_instances.end())
+					get_memory_properties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)vkGetInstanceProcAddr(m_instance, "vkGetPhysicalDeviceMemoryProperties2KHR");
+#endif
+
 				for (u32 i = 0; i < num_gpus; ++i)
+				{
 					gpus[i].set_device(pdevs[i]);
+#ifdef VK_EXT_memory_budget
+					gpus[i].set_memory_properties2_proc(get_memory_properties2);
+#endif
+				}
 			}
 
 			return gpus;
@@ -2164,12 +2899,193 @@ public:
 		}
 	};
 
+	//Collects the descriptor writes of a draw so they can be issued in one call, or skipped if an identical set already exists
+	class descriptor_set_builder
+	{
+	public:
+		struct binding_info
+		{
+			u32 binding;
+			VkDescriptorType type;
+
+			union
+			{
+				VkDescriptorImageInfo image;
+				VkDescriptorBufferInfo buffer;
+				VkBufferView texel_buffer;
+			};
+		};
+
+	private:
+		std::vector<binding_info> m_bindings;
+
+		binding_info& get_binding(u32 binding, VkDescriptorType type)
+		{
+			for (auto &info : m_bindings)
+			{
+				if (info.binding == binding)
+				{
+					info.type = type;
+					return info;
+				}
+			}
+
+			//Zero the whole entry so unused union bytes do not affect hashing and comparison
+			binding_info info;
+			std::memset(&info, 0, sizeof(binding_info));
+			info.binding = binding;
+			info.type = type;
+
+			m_bindings.push_back(info);
+			return m_bindings.back();
+		}
+
+	public:
+		void reset()
+		{
+			m_bindings.clear();
+		}
+
+		void set_image(u32 binding, const VkDescriptorImageInfo &image)
+		{
+			get_binding(binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER).image = image;
+		}
+
+		void set_buffer(u32 binding, const VkDescriptorBufferInfo &buffer, VkDescriptorType type)
+		{
+			get_binding(binding, type).buffer = buffer;
+		}
+
+		void set_texel_buffer(u32 binding, VkBufferView view)
+		{
+			get_binding(binding, VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER).texel_buffer = view;
+		}
+
+		u64 get_hash() const
+		{
+			static_assert(sizeof(binding_info) % 8 == 0, "Unexpected binding_info layout");
+
+			u64 hash = 0xCBF29CE484222325ull;
+			for (const auto &info : m_bindings)
+			{
+				const u64 *data = reinterpret_cast<const u64*>(&info);
+				for (u32 n = 0; n < sizeof(binding_info) / 8; ++n)
+				{
+					hash ^= data[n];
+					hash *= 0x100000001B3ull;
+					hash = rol64(hash, 29);
+				}
+			}
+
+			return hash;
+		}
+
+		bool operator == (const descriptor_set_builder &other) const
+		{
+			return m_bindings.size() == other.m_bindings.size() &&
+				std::memcmp(m_bindings.data(), other.m_bindings.data(), m_bindings.size() * sizeof(binding_info)) == 0;
+		}
+
+		void update(VkDevice dev, VkDescriptorSet set) const
+		{
+			std::vector<VkWriteDescriptorSet> writes(m_bindings.size());
+
+			for (size_t n = 0; n < m_bindings.size(); ++n)
+			{
+				const auto &info = m_bindings[n];
+				auto &writer = writes[n];
+
+				writer = {};
+				writer.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				writer.dstSet = set;
+				writer.descriptorCount = 1;
+				writer.descriptorType = info.type;
+				writer.dstArrayElement = 0;
+				writer.dstBinding = info.binding;
+
+				switch (info.type)
+				{
+				case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+					writer.pImageInfo = &info.image;
+					break;
+				case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+					writer.pTexelBufferView = &info.texel_buffer;
+					break;
+				default:
+					writer.pBufferInfo = &info.buffer;
+					break;
+				}
+			}
+
+			vkUpdateDescriptorSets(dev, (u32)writes.size(), writes.data(), 0, nullptr);
+		}
+	};
+
+	//Descriptor sets written from a given pool, only valid until that pool is reset
+	class descriptor_set_cache
+	{
+		std::unordered_multimap<u64, std::pair<descriptor_set_builder, VkDescriptorSet>> m_sets;
+
+	public:
+		u32 m_hits = 0;
+		u32 m_misses = 0;
+
+		VkDescriptorSet find(const descriptor_set_builder &bindings, u64 hash)
+		{
+			const auto range = m_sets.equal_range(hash);
+			for (auto It = range.first; It != range.second; ++It)
+			{
+				if (It->second.first == bindings)
+				{
+					m_hits++;
+					return It->second.second;
+				}
+			}
+
+			m_misses++;
+			return VK_NULL_HANDLE;
+		}
+
+		void insert(const descriptor_set_builder &bindings, u64 hash, VkDescriptorSet set)
+		{
+			m_sets.emplace(hash, std::make_pair(bindings, set));
+		}
+
+		void clear()
+		{
+			m_sets.clear();
+		}
+	};
+
 	class occlusion_query_pool
 	{
 		VkQueryPool query_pool = VK_NULL_HANDLE;
 		vk::render_device* owner = nullptr;
 
 		std::vector<bool> query_active_status;
+		std::vector<u32> query_results;
+
+		//Slots are handed out round-robin so that queries issued together occupy contiguous ranges
+		u32 next_free_slot = 0;
+
+		//Calls func(first, count) for every run of consecutive indices in the list
+		template <typename F>
+		void for_each_range(const std::vector<u32> &list, F&& func)
+		{
+			for (size_t n = 0; n < list.size();)
+			{
+				const u32 first = list[n];
+				u32 count = 1;
+
+				while ((n + count) < list.size() && list[n + count] == (first + count))
+					count++;
+
+				if (func(first, count))
+					return;
+
+				n += count;
+			}
+		}
 
 	public:
 
@@ -2184,6 +3100,8 @@ public:
 			owner = &dev;
 
 			query_active_status.resize(num_entries, false);
+			query_results.resize(num_entries);
+			next_free_slot = 0;
 		}
 
 		void destroy()
@@ -2207,6 +3125,8 @@ public:
 
 			vkCmdBeginQuery(cmd, query_pool, index, 0);//VK_QUERY_CONTROL_PRECISE_BIT);
 			query_active_status[index] = true;
+
+			next_free_slot = (index + 1) % (u32)query_active_status.size();
 		}
 
 		void end_query(vk::command_buffer &cmd, u32 index)
@@ -2238,6 +3158,29 @@ public:
 			return result == 0u? 0u: 1u;
 		}
 
+		//Returns 1 if any query in the list passed samples. Contiguous indices are read back with a single call
+		u32 get_query_result(const std::vector<u32> &list)
+		{
+			u32 result = 0;
+			for_each_range(list, [&](u32 first, u32 count)
+			{
+				CHECK_RESULT(vkGetQueryPoolResults(*owner, query_pool, first, count, count * 4, query_results.data(), 4, VK_QUERY_RESULT_WAIT_BIT));
+
+				for (u32 n = 0; n < count; ++n)
+				{
+					if (query_results[n])
+					{
+						result = 1;
+						return true;
+					}
+				}
+
+				return false;
+			});
+
+			return result;
+		}
+
 		void reset_query(vk::command_buffer &cmd, u32 index)
 		{
 			vkCmdResetQueryPool(cmd, query_pool, index, 1);
@@ -2246,8 +3189,12 @@ public:
 
 		void reset_queries(vk::command_buffer &cmd, std::vector<u32> &list)
 		{
-			for (const auto index : list)
-				reset_query(cmd, index);
+			for_each_range(list, [&](u32 first, u32 count)
+			{
+				vkCmdResetQueryPool(cmd, query_pool, first, count);
+				std::fill_n(query_active_status.begin() + first, count, false);
+				return false;
+			});
 		}
 
 		void reset_all(vk::command_buffer &cmd)
@@ -2261,16 +3208,118 @@ public:
 
 		u32 find_free_slot()
 		{
-			for (u32 n = 0; n < query_active_status.size(); n++)
+			const u32 count = (u32)query_active_status.size();
+			for (u32 n = 0, index = next_free_slot; n < count; n++, index = (index + 1) % count)
 			{
-				if (query_active_status[n] == false)
-					return n;
+				if (query_active_status[index] == false)
+					return index;
 			}
 
 			return UINT32_MAX;
 		}
 	};
 
+	//Timestamps around every primary command buffer, summed up into the time the GPU actually spent on them.
+	//Gaps between submissions are left out so a CPU bound title does not read as GPU bound.
+	class gpu_timer_pool
+	{
+		VkQueryPool query_pool = VK_NULL_HANDLE;
+		vk::render_device* owner = nullptr;
+
+		f64 timestamp_period = 0.; //Nanoseconds per tick
+		u64 timestamp_mask = 0;
+
+		std::vector<bool> slot_written;
+		u64 busy_time_ns = 0;
+
+		void collect(u32 slot)
+		{
+			if (!slot_written[slot])
+				return;
+
+			slot_written[slot] = false;
+
+			//Slots are only reused once their command buffer retired, the results are ready unless the device lost them
+			u64 ticks[2];
+			if (vkGetQueryPoolResults(*owner, query_pool, slot * 2, 2, sizeof(ticks), ticks, sizeof(u64), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+				return;
+
+			const u64 elapsed = (ticks[1] - ticks[0]) & timestamp_mask;
+			busy_time_ns += u64(elapsed * timestamp_period);
+		}
+
+	public:
+
+		void create(vk::render_device &dev, u32 num_slots)
+		{
+			const u32 valid_bits = const_cast<vk::physical_device&>(dev.gpu()).get_queue_properties(dev.get_graphics_queue_family()).timestampValidBits;
+			timestamp_period = dev.gpu().get_properties().limits.timestampPeriod;
+
+			if (!valid_bits || timestamp_period <= 0.)
+			{
+				LOG_WARNING(RSX, "GPU timestamps are not supported on the graphics queue");
+				return;
+			}
+
+			timestamp_mask = (valid_bits >= 64) ? UINT64_MAX : ((1ull << valid_bits) - 1);
+
+			VkQueryPoolCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			info.queryCount = num_slots * 2;
+
+			CHECK_RESULT(vkCreateQueryPool(dev, &info, nullptr, &query_pool));
+			owner = &dev;
+
+			slot_written.resize(num_slots, false);
+		}
+
+		void destroy()
+		{
+			if (query_pool)
+			{
+				vkDestroyQueryPool(*owner, query_pool, nullptr);
+
+				owner = nullptr;
+				query_pool = VK_NULL_HANDLE;
+			}
+		}
+
+		bool is_supported() const
+		{
+			return query_pool != VK_NULL_HANDLE;
+		}
+
+		//Called right after the command buffer of the slot began recording, which implies its previous use retired
+		void begin(vk::command_buffer &cmd, u32 slot)
+		{
+			if (!query_pool)
+				return;
+
+			collect(slot);
+
+			vkCmdResetQueryPool(cmd, query_pool, slot * 2, 2);
+			vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, query_pool, slot * 2);
+		}
+
+		void end(vk::command_buffer &cmd, u32 slot)
+		{
+			if (!query_pool)
+				return;
+
+			vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query_pool, slot * 2 + 1);
+			slot_written[slot] = true;
+		}
+
+		//GPU time of the command buffers collected since the last call, in microseconds
+		u64 get_busy_time()
+		{
+			const u64 result = busy_time_ns / 1000;
+			busy_time_ns = 0;
+			return result;
+		}
+	};
+
 	class graphics_pipeline_state
 	{
 	public:
@@ -2563,6 +3612,11 @@ public:
 
 			void bind_buffer(const VkDescriptorBufferInfo &buffer_descriptor, uint32_t binding_point, VkDescriptorType type, VkDescriptorSet &descriptor_set);
 
+			//Deferred variants, written to a descriptor set by the builder
+			void bind_uniform(const VkDescriptorImageInfo &image_descriptor, const std::string &uniform_name, descriptor_set_builder &builder);
+			void bind_uniform(const VkDescriptorBufferInfo &buffer_descriptor, uint32_t binding_point, descriptor_set_builder &builder);
+			void bind_uniform(const VkBufferView &buffer_view, const std::string &binding_name, descriptor_set_builder &builder);
+
 			u64 get_vertex_input_attributes_mask();
 		};
 	}
@@ -2573,6 +3627,9 @@ public:
 		bool mapped = false;
 		void *_ptr = nullptr;
 
+		VkBufferUsageFlags usage_flags = 0;
+		size_t initial_size = 0;
+
 		// NOTE: Some drivers (RADV) use heavyweight OS map/unmap routines that are insanely slow
 		// Avoid mapping/unmapping to keep these drivers from stalling
 		// NOTE2: HOST_CACHED flag does not keep the mapped ptr around in the driver either
@@ -2583,10 +3640,30 @@ public:
 			const auto memory_map = device->get_memory_mapping();
 			const VkFlags memory_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
+			usage_flags = usage;
+			initial_size = size;
+
 			data_heap::init(size, name, guard);
 			heap.reset(new buffer(*device, size, memory_map.host_visible_coherent, memory_flags, usage, 0));
 		}
 
+		// Swaps in a backing buffer of another size and empties the heap. The GPU must not reference the old buffer anymore
+		void resize(size_t new_size)
+		{
+			const size_t original_size = initial_size;
+			const size_t high_water_mark = m_high_water_mark;
+			const u32 forced_flushes = m_forced_flushes;
+
+			destroy();
+			_ptr = nullptr;
+
+			create(usage_flags, new_size, m_name, m_min_guard_size);
+
+			initial_size = original_size;
+			m_high_water_mark = high_water_mark;
+			m_forced_flushes = forced_flushes;
+		}
+
 		void destroy()
 		{
 			if (mapped)
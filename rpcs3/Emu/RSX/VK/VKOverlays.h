@@ -115,6 +115,12 @@ namespace vk
 		{
 		}
 
+		virtual void get_vertex_input_layout(std::vector<VkVertexInputBindingDescription>& bindings, std::vector<VkVertexInputAttributeDescription>& attributes)
+		{
+			bindings.push_back({ 0, 16, VK_VERTEX_INPUT_RATE_VERTEX });
+			attributes.push_back({ 0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, 0 });
+		}
+
 		virtual std::vector<vk::glsl::program_input> get_vertex_inputs()
 		{
 			check_heap();
@@ -176,14 +182,16 @@ namespace vk
 			dynamic_state_descriptors[dynamic_state_info.dynamicStateCount++] = VK_DYNAMIC_STATE_SCISSOR;
 			dynamic_state_info.pDynamicStates = dynamic_state_descriptors;
 
-			VkVertexInputBindingDescription vb = { 0, 16, VK_VERTEX_INPUT_RATE_VERTEX };
-			VkVertexInputAttributeDescription via = { 0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, 0 };
+			std::vector<VkVertexInputBindingDescription> vb;
+			std::vector<VkVertexInputAttributeDescription> via;
+			get_vertex_input_layout(vb, via);
+
 			VkPipelineVertexInputStateCreateInfo vi = {};
 			vi.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-			vi.vertexBindingDescriptionCount = 1;
-			vi.pVertexBindingDescriptions = &vb;
-			vi.vertexAttributeDescriptionCount = 1;
-			vi.pVertexAttributeDescriptions = &via;
+			vi.vertexBindingDescriptionCount = (u32)vb.size();
+			vi.pVertexBindingDescriptions = vb.data();
+			vi.vertexAttributeDescriptionCount = (u32)via.size();
+			vi.pVertexAttributeDescriptions = via.data();
 
 			VkPipelineViewportStateCreateInfo vp = {};
 			vp.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
@@ -443,11 +451,11 @@ namespace vk
 	{
 		f32 m_time = 0.f;
 		color4f m_scale_offset;
-		color4f m_color;
-		bool m_pulse_glow = false;
-		bool m_skip_texture_read = false;
-		bool m_clip_enabled;
-		areaf m_clip_region;
+
+		// Quads of the overlay being drawn and the batch of the current pass
+		std::vector<rsx::overlays::compiled_resource::quad_instance> m_instances;
+		std::vector<rsx::overlays::compiled_resource::draw_batch> m_batches;
+		const rsx::overlays::compiled_resource::draw_batch* m_current_batch = nullptr;
 
 		std::vector<std::unique_ptr<vk::image>> resources;
 		std::unordered_map<u64, std::unique_ptr<vk::image>> font_cache;
@@ -461,7 +469,13 @@ namespace vk
 			{
 				"#version 450\n"
 				"#extension GL_ARB_separate_shader_objects : enable\n"
-				"layout(location=0) in vec4 in_pos;\n"
+				"layout(location=0) in vec4 in_corner0;\n"
+				"layout(location=1) in vec4 in_corner1;\n"
+				"layout(location=2) in vec4 in_corner2;\n"
+				"layout(location=3) in vec4 in_corner3;\n"
+				"layout(location=4) in vec4 in_color;\n"
+				"layout(location=5) in vec4 in_clip_rect;\n"
+				"layout(location=6) in vec4 in_parameters;\n"
 				"layout(std140, set=0, binding=0) uniform static_data{ vec4 regs[8]; };\n"
 				"layout(location=0) out vec2 tc0;\n"
 				"layout(location=1) out vec4 color;\n"
@@ -470,10 +484,12 @@ namespace vk
 				"\n"
 				"void main()\n"
 				"{\n"
+				"	// One instance per quad, the corner is selected by the vertex index\n"
+				"	vec4 in_pos = (gl_VertexIndex == 0)? in_corner0 : (gl_VertexIndex == 1)? in_corner1 : (gl_VertexIndex == 2)? in_corner2 : in_corner3;\n"
 				"	tc0.xy = in_pos.zw;\n"
-				"	color = regs[1];\n"
-				"	parameters = regs[2];\n"
-				"	clip_rect = regs[3] * regs[0].zwzw;\n"
+				"	color = in_color;\n"
+				"	parameters = vec4(regs[1].x, in_parameters.xyz);\n"
+				"	clip_rect = in_clip_rect * regs[0].zwzw;\n"
 				"	vec4 pos = vec4((in_pos.xy * regs[0].zw) / regs[0].xy, 0.5, 1.);\n"
 				"	gl_Position = (pos + pos) - 1.;\n"
 				"}\n"
@@ -650,6 +666,16 @@ namespace vk
 					false, true, desc->data, owner_uid);
 		}
 
+		void get_vertex_input_layout(std::vector<VkVertexInputBindingDescription>& bindings, std::vector<VkVertexInputAttributeDescription>& attributes) override
+		{
+			bindings.push_back({ 0, sizeof(rsx::overlays::compiled_resource::quad_instance), VK_VERTEX_INPUT_RATE_INSTANCE });
+
+			for (u32 n = 0; n < 7; ++n)
+			{
+				attributes.push_back({ n, 0, VK_FORMAT_R32G32B32A32_SFLOAT, n * 16 });
+			}
+		}
+
 		void update_uniforms(vk::glsl::program* /*program*/) override
 		{
 			m_ubo_offset = (u32)m_ubo.alloc<256>(128);
@@ -658,32 +684,13 @@ namespace vk
 			dst[1] = m_scale_offset.g;
 			dst[2] = m_scale_offset.b;
 			dst[3] = m_scale_offset.a;
-			dst[4] = m_color.r;
-			dst[5] = m_color.g;
-			dst[6] = m_color.b;
-			dst[7] = m_color.a;
-			dst[8] = m_time;
-			dst[9] = m_pulse_glow? 1.f : 0.f;
-			dst[10] = m_skip_texture_read? 0.f : 1.f;
-			dst[11] = m_clip_enabled ? 1.f : 0.f;
-			dst[12] = m_clip_region.x1;
-			dst[13] = m_clip_region.y1;
-			dst[14] = m_clip_region.x2;
-			dst[15] = m_clip_region.y2;
+			dst[4] = m_time;
 			m_ubo.unmap();
 		}
 
 		void emit_geometry(vk::command_buffer &cmd) override
 		{
-			//Split into groups of 4
-			u32 first = 0;
-			u32 num_quads = num_drawable_elements / 4;
-
-			for (u32 n = 0; n < num_quads; ++n)
-			{
-				vkCmdDraw(cmd, 4, 1, first, 0);
-				first += 4;
-			}
+			vkCmdDraw(cmd, 4, m_current_batch->instance_count, 0, m_current_batch->first_instance);
 		}
 
 		void run(vk::command_buffer &cmd, u16 w, u16 h, vk::framebuffer* target, VkRenderPass render_pass,
@@ -692,40 +699,46 @@ namespace vk
 			m_scale_offset = color4f((f32)ui.virtual_width, (f32)ui.virtual_height, 1.f, 1.f);
 			m_time = (f32)(get_system_time() / 1000) * 0.005f;
 
-			for (auto &command : ui.get_compiled().draw_commands)
-			{
-				num_drawable_elements = (u32)command.verts.size();
-				const u32 value_count = num_drawable_elements * 4;
+			ui.get_compiled().build_batches(m_instances, m_batches);
 
-				upload_vertex_data((f32*)command.verts.data(), value_count);
+			if (!m_instances.empty())
+			{
+				// All batches source the same upload
+				upload_vertex_data((f32*)m_instances.data(), (u32)(m_instances.size() * sizeof(m_instances[0]) / sizeof(f32)));
+			}
 
-				m_skip_texture_read = false;
-				m_color = command.config.color;
-				m_pulse_glow = command.config.pulse_glow;
-				m_clip_enabled = command.config.clip_region;
-				m_clip_region = command.config.clip_rect;
+			// Resolve the textures first, uploads can't be recorded in the render pass
+			std::vector<VkImageView> sources;
+			sources.reserve(m_batches.size());
 
+			for (const auto& batch : m_batches)
+			{
 				auto src = vk::null_image_view(cmd);
-				switch (command.config.texture_ref)
+				switch (batch.config.texture_ref)
 				{
 				case rsx::overlays::image_resource_id::game_icon:
 				case rsx::overlays::image_resource_id::backbuffer:
 					//TODO
 				case rsx::overlays::image_resource_id::none:
-					m_skip_texture_read = true;
 					break;
 				case rsx::overlays::image_resource_id::font_file:
-					src = find_font(command.config.font_ref, cmd, upload_heap)->value;
+					src = find_font(batch.config.font_ref, cmd, upload_heap)->value;
 					break;
 				case rsx::overlays::image_resource_id::raw_image:
-					src = find_temp_image((rsx::overlays::image_info*)command.config.external_data_ref, cmd, upload_heap, ui.uid)->value;
+					src = find_temp_image((rsx::overlays::image_info*)batch.config.external_data_ref, cmd, upload_heap, ui.uid)->value;
 					break;
 				default:
-					src = view_cache[command.config.texture_ref]->value;
+					src = view_cache[batch.config.texture_ref]->value;
 					break;
 				}
 
-				overlay_pass::run(cmd, w, h, target, { src }, render_pass);
+				sources.push_back(src);
+			}
+
+			for (u32 n = 0; n < m_batches.size(); ++n)
+			{
+				m_current_batch = &m_batches[n];
+				overlay_pass::run(cmd, w, h, target, { sources[n] }, render_pass);
 			}
 
 			ui.update();
@@ -103,7 +103,7 @@ struct VKTraits
 
 	static
 	pipeline_storage_type build_pipeline(const vertex_program_type &vertexProgramData, const fragment_program_type &fragmentProgramData,
-			const vk::pipeline_props &pipelineProperties, VkDevice dev, VkPipelineLayout common_pipeline_layout)
+			const vk::pipeline_props &pipelineProperties, VkDevice dev, VkPipelineLayout common_pipeline_layout, VkPipelineCache pipeline_cache = VK_NULL_HANDLE)
 	{
 		VkPipelineShaderStageCreateInfo shader_stages[2] = {};
 		shader_stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -142,13 +142,17 @@ struct VKTraits
 		ms.pSampleMask = NULL;
 		ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 
+		// Point at this copy's blend attachments, the properties may have been copied for an asynchronous build
+		VkPipelineColorBlendStateCreateInfo cs = pipelineProperties.state.cs;
+		cs.pAttachments = pipelineProperties.state.att_state;
+
 		VkPipeline pipeline;
 		VkGraphicsPipelineCreateInfo info = {};
 		info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 		info.pVertexInputState = &vi;
 		info.pInputAssemblyState = &pipelineProperties.state.ia;
 		info.pRasterizationState = &pipelineProperties.state.rs;
-		info.pColorBlendState = &pipelineProperties.state.cs;
+		info.pColorBlendState = &cs;
 		info.pMultisampleState = &ms;
 		info.pViewportState = &vp;
 		info.pDepthStencilState = &pipelineProperties.state.ds;
@@ -160,7 +164,7 @@ struct VKTraits
 		info.basePipelineHandle = VK_NULL_HANDLE;
 		info.renderPass = pipelineProperties.render_pass;
 
-		CHECK_RESULT(vkCreateGraphicsPipelines(dev, nullptr, 1, &info, NULL, &pipeline));
+		CHECK_RESULT(vkCreateGraphicsPipelines(dev, pipeline_cache, 1, &info, NULL, &pipeline));
 		pipeline_storage_type result = std::make_unique<vk::glsl::program>(dev, pipeline, vertexProgramData.uniforms, fragmentProgramData.uniforms);
 
 		return result;
@@ -171,6 +175,37 @@ class VKProgramBuffer : public program_state_cache<VKTraits>
 {
 	const VkRenderPass *m_render_pass_data;
 
+	VkDevice m_device = VK_NULL_HANDLE;
+	VkPipelineCache m_pipeline_cache = VK_NULL_HANDLE;
+
+	// Shader cache workers each get their own VkPipelineCache to avoid contending on the driver's cache lock
+	std::mutex m_worker_cache_mutex;
+	std::unordered_map<std::thread::id, VkPipelineCache> m_worker_pipeline_caches;
+
+	static VkPipelineCache create_pipeline_cache(VkDevice dev)
+	{
+		VkPipelineCacheCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+		VkPipelineCache cache;
+		CHECK_RESULT(vkCreatePipelineCache(dev, &info, nullptr, &cache));
+		return cache;
+	}
+
+	VkPipelineCache get_worker_pipeline_cache(VkDevice dev)
+	{
+		std::lock_guard<std::mutex> lock(m_worker_cache_mutex);
+		m_device = dev;
+
+		auto &cache = m_worker_pipeline_caches[std::this_thread::get_id()];
+		if (!cache)
+		{
+			cache = create_pipeline_cache(dev);
+		}
+
+		return cache;
+	}
+
 public:
 	VKProgramBuffer(VkRenderPass *renderpass_list)
 		: m_render_pass_data(renderpass_list)
@@ -178,9 +213,116 @@ public:
 
 	void clear()
 	{
+		stop_pipeline_workers();
+
 		program_state_cache<VKTraits>::clear();
 		m_vertex_shader_cache.clear();
 		m_fragment_shader_cache.clear();
+
+		merge_pipeline_caches();
+
+		if (m_pipeline_cache)
+		{
+			vkDestroyPipelineCache(m_device, m_pipeline_cache, nullptr);
+			m_pipeline_cache = VK_NULL_HANDLE;
+		}
+	}
+
+	VkPipelineCache get_pipeline_cache(VkDevice dev)
+	{
+		if (!m_pipeline_cache)
+		{
+			m_device = dev;
+			m_pipeline_cache = create_pipeline_cache(dev);
+		}
+
+		return m_pipeline_cache;
+	}
+
+	// Folds the per-worker caches into the main cache used at runtime and releases them
+	void merge_pipeline_caches()
+	{
+		std::lock_guard<std::mutex> lock(m_worker_cache_mutex);
+		if (m_worker_pipeline_caches.empty())
+			return;
+
+		std::vector<VkPipelineCache> sources;
+		for (const auto &p : m_worker_pipeline_caches)
+			sources.push_back(p.second);
+
+		CHECK_RESULT(vkMergePipelineCaches(m_device, get_pipeline_cache(m_device), (u32)sources.size(), sources.data()));
+
+		for (const auto &cache : sources)
+			vkDestroyPipelineCache(m_device, cache, nullptr);
+
+		m_worker_pipeline_caches.clear();
+	}
+
+	// Seeds the main pipeline cache with a blob saved by save_pipeline_cache. Blobs from another device or driver are ignored.
+	void load_pipeline_cache(const vk::render_device &dev, const std::string &path)
+	{
+		fs::file f(path);
+		if (!f)
+			return;
+
+		const auto data = f.to_vector<u8>();
+		const auto &props = dev.gpu().get_properties();
+
+		// VK_PIPELINE_CACHE_HEADER_VERSION_ONE layout: length, version, vendor id, device id, cache uuid
+		u32 header[4];
+		if (data.size() < sizeof(header) + VK_UUID_SIZE)
+			return;
+
+		std::memcpy(header, data.data(), sizeof(header));
+		if (header[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || header[2] != props.vendorID || header[3] != props.deviceID ||
+			std::memcmp(data.data() + sizeof(header), props.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			LOG_WARNING(RSX, "Discarding pipeline cache '%s' created by a different device or driver", path);
+			return;
+		}
+
+		VkPipelineCacheCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		info.initialDataSize = data.size();
+		info.pInitialData = data.data();
+
+		VkPipelineCache cache;
+		if (vkCreatePipelineCache(dev, &info, nullptr, &cache) != VK_SUCCESS)
+		{
+			LOG_WARNING(RSX, "Pipeline cache '%s' was rejected by the driver", path);
+			return;
+		}
+
+		if (m_pipeline_cache)
+		{
+			CHECK_RESULT(vkMergePipelineCaches(dev, m_pipeline_cache, 1, &cache));
+			vkDestroyPipelineCache(dev, cache, nullptr);
+		}
+		else
+		{
+			m_device = dev;
+			m_pipeline_cache = cache;
+		}
+
+		LOG_NOTICE(RSX, "Loaded %llu bytes of pipeline cache from '%s'", (u64)data.size(), path);
+	}
+
+	// Writes the driver pipeline cache out so the next boot can skip most driver compilation
+	void save_pipeline_cache(const std::string &path)
+	{
+		stop_pipeline_workers();
+		merge_pipeline_caches();
+
+		if (!m_pipeline_cache)
+			return;
+
+		size_t size = 0;
+		CHECK_RESULT(vkGetPipelineCacheData(m_device, m_pipeline_cache, &size, nullptr));
+
+		std::vector<u8> data(size);
+		CHECK_RESULT(vkGetPipelineCacheData(m_device, m_pipeline_cache, &size, data.data()));
+
+		fs::file(path, fs::rewrite).write(data.data(), size);
 	}
 
 	u64 get_hash(vk::pipeline_props &props)
@@ -198,22 +340,22 @@ public:
 		return program_hash_util::fragment_program_utils::get_fragment_program_ucode_hash(prog);
 	}
 
-	template <typename... Args>
-	void add_pipeline_entry(RSXVertexProgram &vp, RSXFragmentProgram &fp, vk::pipeline_props &props, Args&& ...args)
+	void add_pipeline_entry(RSXVertexProgram &vp, RSXFragmentProgram &fp, vk::pipeline_props &props, VkDevice dev, VkPipelineLayout common_pipeline_layout)
 	{
 		//Extract pointers from pipeline props
 		props.render_pass = m_render_pass_data[props.render_pass_location];
 		props.state.cs.pAttachments = props.state.att_state;
 		vp.skip_vertex_input_check = true;
-		getGraphicPipelineState(vp, fp, props, std::forward<Args>(args)...);
+		getGraphicPipelineState(vp, fp, props, dev, common_pipeline_layout, get_worker_pipeline_cache(dev));
 	}
 
-    void preload_programs(RSXVertexProgram &vp, RSXFragmentProgram &fp)
-    {
-        vp.skip_vertex_input_check = true;
-        search_vertex_program(vp);
-        search_fragment_program(fp);
-    }
+	// Called concurrently from the shader cache loader
+	void preload_programs(RSXVertexProgram &vp, RSXFragmentProgram &fp)
+	{
+		vp.skip_vertex_input_check = true;
+		preload_vertex_program(vp);
+		preload_fragment_program(fp);
+	}
 
 	bool check_cache_missed() const
 	{
@@ -116,6 +116,42 @@ namespace vk
 			attribute_location_mask |= (1ull << binding_point);
 		}
 
+		void program::bind_uniform(const VkDescriptorImageInfo &image_descriptor, const std::string &uniform_name, descriptor_set_builder &builder)
+		{
+			for (auto &uniform : uniforms)
+			{
+				if (uniform.name == uniform_name)
+				{
+					builder.set_image(uniform.location, image_descriptor);
+					attribute_location_mask |= (1ull << uniform.location);
+					return;
+				}
+			}
+
+			LOG_NOTICE(RSX, "texture not found in program: %s", uniform_name.c_str());
+		}
+
+		void program::bind_uniform(const VkDescriptorBufferInfo &buffer_descriptor, uint32_t binding_point, descriptor_set_builder &builder)
+		{
+			builder.set_buffer(binding_point, buffer_descriptor, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+			attribute_location_mask |= (1ull << binding_point);
+		}
+
+		void program::bind_uniform(const VkBufferView &buffer_view, const std::string &binding_name, descriptor_set_builder &builder)
+		{
+			for (auto &uniform : uniforms)
+			{
+				if (uniform.name == binding_name)
+				{
+					builder.set_texel_buffer(uniform.location, buffer_view);
+					attribute_location_mask |= (1ull << uniform.location);
+					return;
+				}
+			}
+
+			LOG_NOTICE(RSX, "vertex buffer not found in program: %s", binding_name.c_str());
+		}
+
 		u64 program::get_vertex_input_attributes_mask()
 		{
 			if (vertex_attributes_mask)
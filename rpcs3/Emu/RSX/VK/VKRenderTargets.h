@@ -335,6 +335,85 @@ namespace rsx
 			m_render_targets_storage.clear();
 			m_depth_stencil_storage.clear();
 			invalidated_resources.clear();
+			cache_tag++;
+		}
+
+		//Recreates every surface at the active resolution scale, keeping the contents through a scaled blit.
+		//Replaced surfaces retire like invalidated ones since bound framebuffers may still reference them.
+		//Returns the memory ranges of the replaced surfaces.
+		std::vector<std::pair<u32, u32>> rescale_surfaces(vk::render_device &dev, vk::command_buffer &cmd)
+		{
+			std::vector<std::pair<u32, u32>> result;
+
+			auto rescale = [&](std::unordered_map<u32, std::unique_ptr<vk::render_target>> &storage, std::tuple<u32, vk::render_target*>* bindings, u32 binding_count)
+			{
+				for (auto &e : storage)
+				{
+					vk::render_target* old_surface = e.second.get();
+					if (old_surface->matches_dimensions(old_surface->surface_width, old_surface->surface_height))
+						continue;
+
+					const u32 new_width = rsx::apply_resolution_scale(old_surface->surface_width, true);
+					const u32 new_height = rsx::apply_resolution_scale(old_surface->surface_height, true);
+
+					std::unique_ptr<vk::render_target> surface(new vk::render_target(dev, dev.get_memory_mapping().device_local,
+						VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+						VK_IMAGE_TYPE_2D,
+						old_surface->info.format,
+						new_width, new_height, 1, 1, 1,
+						VK_SAMPLE_COUNT_1_BIT,
+						VK_IMAGE_LAYOUT_UNDEFINED,
+						VK_IMAGE_TILING_OPTIMAL,
+						old_surface->info.usage,
+						0));
+
+					surface->native_component_map = old_surface->native_component_map;
+					surface->native_pitch = old_surface->native_pitch;
+					surface->rsx_pitch = old_surface->rsx_pitch;
+					surface->surface_width = old_surface->surface_width;
+					surface->surface_height = old_surface->surface_height;
+					surface->attachment_aspect_flag = old_surface->attachment_aspect_flag;
+					surface->tile = old_surface->tile;
+					surface->read_aa_mode = old_surface->read_aa_mode;
+					surface->write_aa_mode = old_surface->write_aa_mode;
+					surface->dirty = old_surface->dirty;
+
+					const VkImageLayout layout = old_surface->current_layout;
+					if (layout != VK_IMAGE_LAYOUT_UNDEFINED)
+					{
+						const bool is_depth = (old_surface->attachment_aspect_flag & VK_IMAGE_ASPECT_DEPTH_BIT) != 0;
+						change_image_layout(cmd, surface.get(), layout, vk::get_image_subresource_range(0, 0, 1, 1, surface->attachment_aspect_flag));
+
+						vk::copy_scaled_image(cmd, old_surface->value, surface->value, layout, layout,
+							0, 0, old_surface->width(), old_surface->height(), 0, 0, new_width, new_height, 1, surface->attachment_aspect_flag, true,
+							is_depth ? VK_FILTER_NEAREST : VK_FILTER_LINEAR, old_surface->info.format, surface->info.format);
+					}
+					else
+					{
+						surface->dirty = true;
+					}
+
+					for (u32 n = 0; n < binding_count; ++n)
+					{
+						if (std::get<1>(bindings[n]) == old_surface)
+							std::get<1>(bindings[n]) = surface.get();
+					}
+
+					result.emplace_back(e.first, old_surface->rsx_pitch * old_surface->surface_height);
+
+					rsx::vk_render_target_traits::notify_surface_invalidated(e.second);
+					invalidated_resources.push_back(std::move(e.second));
+					e.second = std::move(surface);
+				}
+			};
+
+			rescale(m_render_targets_storage, m_bound_render_targets.data(), (u32)m_bound_render_targets.size());
+			rescale(m_depth_stencil_storage, &m_bound_depth_stencil, 1);
+
+			if (!result.empty())
+				cache_tag++;
+
+			return result;
 		}
 
 		void free_invalidated()
@@ -425,6 +425,45 @@ namespace vk
 			change_image_layout(cmd, dst, preferred_dst_format, dstLayout, vk::get_image_subresource_range(0, 0, 1, 1, aspect));
 	}
 
+	// Smaller swizzled textures are cheaper to deswizzle on the CPU than to round-trip through a compute pass
+	constexpr u32 min_gpu_deswizzle_texel_count = 128 * 128;
+
+	static vk::cs_deswizzle_base* get_deswizzle_task(int format, const rsx_subresource_layout& layout, u8 block_size_in_bytes)
+	{
+		const u16 width = layout.width_in_block;
+		const u16 height = layout.height_in_block;
+
+		// The compute path only handles power of two 2D levels, which is all the CPU path handles correctly anyway
+		if (layout.depth != 1 || (width & (width - 1)) || (height & (height - 1)) ||
+			u32(width * height) < min_gpu_deswizzle_texel_count || (width * block_size_in_bytes) % 4)
+		{
+			return nullptr;
+		}
+
+		switch (format)
+		{
+		case CELL_GCM_TEXTURE_A8R8G8B8:
+		case CELL_GCM_TEXTURE_D8R8G8B8:
+			return vk::get_compute_task<vk::cs_deswizzle_32>();
+		case ~(CELL_GCM_TEXTURE_LN | CELL_GCM_TEXTURE_UN) & CELL_GCM_TEXTURE_COMPRESSED_B8R8_G8R8:
+		case ~(CELL_GCM_TEXTURE_LN | CELL_GCM_TEXTURE_UN) & CELL_GCM_TEXTURE_COMPRESSED_R8B8_R8G8:
+		case CELL_GCM_TEXTURE_COMPRESSED_HILO8:
+		case CELL_GCM_TEXTURE_COMPRESSED_HILO_S8:
+		case CELL_GCM_TEXTURE_D1R5G5B5:
+		case CELL_GCM_TEXTURE_A1R5G5B5:
+		case CELL_GCM_TEXTURE_A4R4G4B4:
+		case CELL_GCM_TEXTURE_R5G5B5A1:
+		case CELL_GCM_TEXTURE_R5G6B5:
+		case CELL_GCM_TEXTURE_R6G5B5:
+		case CELL_GCM_TEXTURE_G8B8:
+		case CELL_GCM_TEXTURE_X16:
+			return vk::get_compute_task<vk::cs_deswizzle_16>();
+		default:
+			// Depth formats need extra repacking handled below
+			return nullptr;
+		}
+	}
+
 	void copy_mipmaped_image_using_buffer(VkCommandBuffer cmd, vk::image* dst_image,
 		const std::vector<rsx_subresource_layout>& subresource_layout, int format, bool is_swizzled, u16 mipmap_count,
 		VkImageAspectFlags flags, vk::vk_data_heap &upload_heap)
@@ -436,57 +475,117 @@ namespace vk
 		//TODO: Depth and stencil transfer together
 		flags &= ~(VK_IMAGE_ASPECT_STENCIL_BIT);
 
+		// CPU decodes are collected and run together once all transfers are recorded.
+		// The heap stays mapped and nothing recorded here executes before submission.
+		std::vector<texture_subresource_upload> cpu_uploads;
+
 		for (const rsx_subresource_layout &layout : subresource_layout)
 		{
 			u32 row_pitch = align(layout.width_in_block * block_size_in_bytes, 256);
 			u32 image_linear_size = row_pitch * layout.height_in_block * layout.depth;
 
-			//Map with extra padding bytes in case of realignment
-			size_t offset_in_buffer = upload_heap.alloc<512>(image_linear_size + 8);
-			void *mapped_buffer = upload_heap.map(offset_in_buffer, image_linear_size + 8);
-			void *dst = mapped_buffer;
-			VkBuffer buffer_handle = upload_heap.heap->value;
+			vk::cs_deswizzle_base* deswizzle_kernel = is_swizzled ? get_deswizzle_task(format, layout, block_size_in_bytes) : nullptr;
 
-			if (dst_image->info.format == VK_FORMAT_D24_UNORM_S8_UINT)
-			{
-				//Misalign intentionally to skip the first stencil byte in D24S8 data
-				//Ensures the real depth data is dword aligned
+			const u32 swizzled_length = layout.width_in_block * layout.height_in_block * block_size_in_bytes;
+			const u32 deswizzle_dst_offset = align(32 + swizzled_length, 256);
+			auto scratch_buf = vk::get_scratch_buffer();
 
-				//Skip leading dword when writing to texture
-				offset_in_buffer += 4;
-				dst = (char*)(mapped_buffer) + 4 - 1;
+			if (deswizzle_kernel && (deswizzle_dst_offset + image_linear_size) > scratch_buf->size())
+			{
+				deswizzle_kernel = nullptr;
 			}
 
-			gsl::span<gsl::byte> mapped{ (gsl::byte*)dst, ::narrow<int>(image_linear_size) };
-			upload_texture_subresource(mapped, layout, format, is_swizzled, false, 256);
-			upload_heap.unmap();
+			size_t offset_in_buffer;
+			VkBuffer buffer_handle;
 
-			if (dst_image->info.format == VK_FORMAT_D32_SFLOAT_S8_UINT)
+			if (deswizzle_kernel)
 			{
-				// Run GPU compute task to convert the D24x8 to FP32
-				// NOTE: On commandbuffer submission, the HOST_WRITE to ALL_COMMANDS barrier is implicitly inserted according to spec
-				// No need to add another explicit barrier unless a driver bug is found
+				// Upload the raw guest data behind a parameter header, the compute task writes the linear image after it
+				const u32 upload_length = 32 + swizzled_length;
+				const u32 scratch_length = deswizzle_dst_offset + image_linear_size;
+				const u32 words_per_row = (layout.width_in_block * block_size_in_bytes) / 4;
 
-				// Executing GPU tasks on host_visible RAM is awful, copy to device-local buffer instead
-				auto scratch_buf = vk::get_scratch_buffer();
+				const size_t offset_in_upload = upload_heap.alloc<512>(upload_length);
+				u32* header = static_cast<u32*>(upload_heap.map(offset_in_upload, upload_length));
+
+				header[0] = words_per_row;
+				header[1] = layout.height_in_block;
+				header[2] = std::min(rsx::ceil_log2(layout.width_in_block), rsx::ceil_log2(layout.height_in_block));
+				header[3] = deswizzle_dst_offset / 4;
+				header[4] = row_pitch / 4;
+				header[5] = header[6] = header[7] = 0;
+
+				std::memcpy(header + 8, layout.data.data(), swizzled_length);
+				upload_heap.unmap();
+
+				// The scratch buffer may still be read by an earlier transfer in this command buffer
+				insert_buffer_memory_barrier(cmd, scratch_buf->value, 0, scratch_length, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+					VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
 
 				VkBufferCopy copy = {};
-				copy.srcOffset = offset_in_buffer;
+				copy.srcOffset = offset_in_upload;
 				copy.dstOffset = 0;
-				copy.size = image_linear_size;
+				copy.size = upload_length;
 
-				vkCmdCopyBuffer(cmd, buffer_handle, scratch_buf->value, 1, &copy);
+				vkCmdCopyBuffer(cmd, upload_heap.heap->value, scratch_buf->value, 1, &copy);
 
-				insert_buffer_memory_barrier(cmd, scratch_buf->value, 0, image_linear_size, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				insert_buffer_memory_barrier(cmd, scratch_buf->value, 0, upload_length, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
 					VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
 
-				vk::get_compute_task<vk::cs_shuffle_d24x8_f32>()->run(cmd, upload_heap.heap.get(), image_linear_size, offset_in_buffer);
+				deswizzle_kernel->run(cmd, scratch_buf, scratch_length, words_per_row * layout.height_in_block);
 
-				insert_buffer_memory_barrier(cmd, scratch_buf->value, 0, image_linear_size, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				insert_buffer_memory_barrier(cmd, scratch_buf->value, deswizzle_dst_offset, image_linear_size, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
 					VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
 
 				buffer_handle = scratch_buf->value;
-				offset_in_buffer = 0;
+				offset_in_buffer = deswizzle_dst_offset;
+			}
+			else
+			{
+				//Map with extra padding bytes in case of realignment
+				offset_in_buffer = upload_heap.alloc<512>(image_linear_size + 8);
+				void *mapped_buffer = upload_heap.map(offset_in_buffer, image_linear_size + 8);
+				void *dst = mapped_buffer;
+				buffer_handle = upload_heap.heap->value;
+
+				if (dst_image->info.format == VK_FORMAT_D24_UNORM_S8_UINT)
+				{
+					//Misalign intentionally to skip the first stencil byte in D24S8 data
+					//Ensures the real depth data is dword aligned
+
+					//Skip leading dword when writing to texture
+					offset_in_buffer += 4;
+					dst = (char*)(mapped_buffer) + 4 - 1;
+				}
+
+				gsl::span<gsl::byte> mapped{ (gsl::byte*)dst, ::narrow<int>(image_linear_size) };
+				cpu_uploads.push_back({ mapped, layout });
+
+				if (dst_image->info.format == VK_FORMAT_D32_SFLOAT_S8_UINT)
+				{
+					// Run GPU compute task to convert the D24x8 to FP32
+					// NOTE: On commandbuffer submission, the HOST_WRITE to ALL_COMMANDS barrier is implicitly inserted according to spec
+					// No need to add another explicit barrier unless a driver bug is found
+
+					// Executing GPU tasks on host_visible RAM is awful, copy to device-local buffer instead
+					VkBufferCopy copy = {};
+					copy.srcOffset = offset_in_buffer;
+					copy.dstOffset = 0;
+					copy.size = image_linear_size;
+
+					vkCmdCopyBuffer(cmd, buffer_handle, scratch_buf->value, 1, &copy);
+
+					insert_buffer_memory_barrier(cmd, scratch_buf->value, 0, image_linear_size, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+						VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+					vk::get_compute_task<vk::cs_shuffle_d24x8_f32>()->run(cmd, upload_heap.heap.get(), image_linear_size, offset_in_buffer);
+
+					insert_buffer_memory_barrier(cmd, scratch_buf->value, 0, image_linear_size, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+						VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+					buffer_handle = scratch_buf->value;
+					offset_in_buffer = 0;
+				}
 			}
 
 			VkBufferImageCopy copy_info = {};
@@ -503,6 +602,12 @@ namespace vk
 			vkCmdCopyBufferToImage(cmd, buffer_handle, dst_image->value, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy_info);
 			mipmap_level++;
 		}
+
+		if (!cpu_uploads.empty())
+		{
+			upload_texture_subresources(cpu_uploads, format, is_swizzled, false, 256);
+			upload_heap.unmap();
+		}
 	}
 
 	VkComponentMapping apply_swizzle_remap(const std::array<VkComponentSwizzle, 4>& base_remap, const std::pair<std::array<u8, 4>, std::array<u8, 4>>& remap_vector)
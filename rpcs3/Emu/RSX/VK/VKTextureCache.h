@@ -24,6 +24,9 @@ namespace vk
 		vk::image *vram_texture = nullptr;
 		std::unique_ptr<vk::buffer> dma_buffer;
 
+		// Set when the DMA buffer already holds the rows at the guest pitch
+		bool dma_rows_pitched = false;
+
 	public:
 	
 		cached_texture_section() {}
@@ -35,6 +38,7 @@ namespace vk
 
 			rsx::protection_policy policy = g_cfg.video.strict_rendering_mode ? rsx::protection_policy::protect_policy_full_range : rsx::protection_policy::protect_policy_conservative;
 			rsx::buffered_section::reset(base, length, policy);
+			reset_hashed();
 		}
 
 		void create(u16 w, u16 h, u16 depth, u16 mipmaps, vk::image_view *view, vk::image *image, u32 rsx_pitch, bool managed, u32 gcm_format, bool pack_swap_bytes = false)
@@ -237,33 +241,81 @@ namespace vk
 				}
 			}
 
+			// Compressed tiles hold every texel of a single sampled surface repeated over a 2x2 block.
+			// The layout is built by a compute pass, multisampled surfaces already come out expanded from the scaled copy above.
+			const u32 texel_width = vk::get_format_texel_width(vram_texture->info.format);
+			const u32 packed_length = texel_width * transfer_width * transfer_height;
+			const u32 tile_src_offset = 256;
+			const u32 tile_dst_offset = align(tile_src_offset + packed_length, 256);
+			u32 tile_repeat = 1;
+
+			if (context == rsx::texture_upload_context::framebuffer_storage && texel_width == 4)
+			{
+				auto surface = static_cast<vk::render_target*>(vram_texture);
+				if (surface->tile && surface->tile->comp == CELL_GCM_COMPMODE_C32_2X2 &&
+					surface->read_aa_mode == rsx::surface_antialiasing::center_1_sample &&
+					rsx_pitch >= (packed_length / transfer_height) * 2 &&
+					(tile_dst_offset + cpu_address_range) <= vk::get_scratch_buffer()->size())
+				{
+					tile_repeat = 2;
+				}
+			}
+
 			// Do not run the compute task on host visible memory
-			vk::buffer* mem_target = shuffle_kernel ? vk::get_scratch_buffer() : dma_buffer.get();
+			const bool use_scratch = shuffle_kernel || tile_repeat > 1;
+			vk::buffer* mem_target = use_scratch ? vk::get_scratch_buffer() : dma_buffer.get();
+			const u32 mem_offset = (tile_repeat > 1) ? tile_src_offset : 0;
+			const u32 mem_length = (tile_repeat > 1) ? packed_length : cpu_address_range;
 
 			// TODO: Read back stencil values (is this really necessary?)
 			VkBufferImageCopy region = {};
+			region.bufferOffset = mem_offset;
 			region.imageSubresource = {aspect_flag & ~(VK_IMAGE_ASPECT_STENCIL_BIT), 0, 0, 1};
 			region.imageExtent = {transfer_width, transfer_height, 1};
 			vkCmdCopyImageToBuffer(cmd, target->value, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, mem_target->value, 1, &region);
 
 			change_image_layout(cmd, vram_texture, old_layout, subresource_range);
-			real_pitch = vk::get_format_texel_width(vram_texture->info.format) * transfer_width;
+			real_pitch = texel_width * transfer_width;
+			dma_rows_pitched = false;
 
 			if (shuffle_kernel)
 			{
 				verify (HERE), mem_target->value != dma_buffer->value;
 
-				vk::insert_buffer_memory_barrier(cmd, mem_target->value, 0, cpu_address_range,
+				vk::insert_buffer_memory_barrier(cmd, mem_target->value, mem_offset, mem_length,
 					VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
 					VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
 
-				shuffle_kernel->run(cmd, mem_target, cpu_address_range);
+				shuffle_kernel->run(cmd, mem_target, mem_length, mem_offset);
+			}
+
+			if (tile_repeat > 1)
+			{
+				const u32 header[8] = { transfer_width, transfer_height, tile_src_offset / 4, tile_dst_offset / 4, rsx_pitch / 4u, tile_repeat, cpu_address_range / 4, 0 };
+				vkCmdUpdateBuffer(cmd, mem_target->value, 0, sizeof(header), header);
+
+				vk::insert_buffer_memory_barrier(cmd, mem_target->value, 0, tile_dst_offset,
+					VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+				const u32 texel_count = transfer_width * transfer_height * tile_repeat * tile_repeat;
+				vk::get_compute_task<vk::cs_tile_32>()->run(cmd, mem_target, tile_dst_offset + cpu_address_range, texel_count);
+
+				// The rows now sit at the guest pitch, only the texels inside each row are copied out on flush
+				real_pitch *= tile_repeat;
+				dma_rows_pitched = true;
+			}
 
-				vk::insert_buffer_memory_barrier(cmd, mem_target->value, 0, cpu_address_range,
+			if (use_scratch)
+			{
+				const u32 src_offset = (tile_repeat > 1) ? tile_dst_offset : 0;
+
+				vk::insert_buffer_memory_barrier(cmd, mem_target->value, src_offset, cpu_address_range,
 					VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
 					VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
 
 				VkBufferCopy copy = {};
+				copy.srcOffset = src_offset;
 				copy.size = cpu_address_range;
 				vkCmdCopyBuffer(cmd, mem_target->value, dma_buffer->value, 1, &copy);
 			}
@@ -324,14 +376,15 @@ namespace vk
 				}
 
 				const u32 num_rows = valid_range.second / rsx_pitch;
+				const u32 src_pitch = dma_rows_pitched ? rsx_pitch : real_pitch;
 				auto _src = (u8*)pixels_src;
 				auto _dst = (u8*)pixels_dst;
 
 				for (u32 y = 0; y < num_rows; ++y)
 				{
 					memcpy(_dst, _src, real_pitch);
-					_src += real_pitch;
-					_dst += real_pitch;
+					_src += src_pitch;
+					_dst += rsx_pitch;
 				}
 			}
 
@@ -421,6 +474,10 @@ namespace vk
 		vk::gpu_formats_support m_formats_support;
 		VkQueue m_submit_queue;
 		vk_data_heap* m_texture_upload_heap;
+		vk::async_transfer_queue* m_transfer_queue = nullptr;
+
+		//Smaller uploads are not worth the extra submission
+		static constexpr u32 min_async_upload_size = 0x40000;
 
 		//Stuff that has been dereferenced goes into these
 		std::list<discarded_storage> m_discardable_storage;
@@ -892,7 +949,28 @@ namespace vk
 			rsx::texture_upload_context context, const std::vector<rsx_subresource_layout>& subresource_layout, rsx::texture_dimension_extended type,
 			rsx::texture_colorspace colorspace, bool swizzled, const texture_channel_remap_t& remap_vector) override
 		{
-			auto section = create_new_texture(cmd, rsx_address, pitch * height, width, height, depth, mipmaps, gcm_format, context, type,
+			//Bypass to the transfer queue for plain copies only, conversion kernels need a compute capable queue.
+			//Only command buffers flushed by the renderer are eligible as they are guaranteed to be submitted before the frame ends
+			vk::command_buffer* transfer_cmd = nullptr;
+			if (m_transfer_queue && !swizzled && cmd.access_hint == vk::command_buffer::access_type_hint::flush_only &&
+				(u32)pitch * height * depth >= min_async_upload_size)
+			{
+				switch (gcm_format)
+				{
+				case CELL_GCM_TEXTURE_DEPTH24_D8:
+				case CELL_GCM_TEXTURE_DEPTH24_D8_FLOAT:
+				case CELL_GCM_TEXTURE_DEPTH16:
+				case CELL_GCM_TEXTURE_DEPTH16_FLOAT:
+					break;
+				default:
+					transfer_cmd = m_transfer_queue->begin();
+					break;
+				}
+			}
+
+			vk::command_buffer& upload_cmd = transfer_cmd ? *transfer_cmd : cmd;
+
+			auto section = create_new_texture(upload_cmd, rsx_address, pitch * height, width, height, depth, mipmaps, gcm_format, context, type,
 					rsx::texture_create_flags::default_component_order, colorspace, remap_vector);
 
 			auto image = section->get_raw_texture();
@@ -906,7 +984,7 @@ namespace vk
 				break;
 			}
 
-			change_image_layout(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subres_range);
+			change_image_layout(upload_cmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subres_range);
 
 			vk::enter_uninterruptible();
 
@@ -923,12 +1001,31 @@ namespace vk
 				section->set_sampler_status(rsx::texture_sampler_status::status_ready);
 			}
 
-			vk::copy_mipmaped_image_using_buffer(cmd, image, subresource_layout, gcm_format, input_swizzled, mipmaps, subres_range.aspectMask,
+			vk::copy_mipmaped_image_using_buffer(upload_cmd, image, subresource_layout, gcm_format, input_swizzled, mipmaps, subres_range.aspectMask,
 				*m_texture_upload_heap);
 
 			vk::leave_uninterruptible();
 
-			change_image_layout(cmd, image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subres_range);
+			if (transfer_cmd)
+			{
+				//Hand the image over to the graphics queue; shader stages of the consumer wait for the copy to finish
+				const VkPipelineStageFlags consumer_stages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+				const u32 src_family = m_transfer_queue->get_queue_family();
+				const u32 dst_family = m_device->get_graphics_queue_family();
+
+				vk::insert_image_ownership_barrier(*transfer_cmd, image->value, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subres_range,
+					src_family, dst_family, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, 0);
+
+				vk::insert_image_ownership_barrier(cmd, image->value, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subres_range,
+					src_family, dst_family, consumer_stages, consumer_stages, 0, VK_ACCESS_SHADER_READ_BIT);
+
+				image->current_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				m_transfer_queue->submit(cmd, consumer_stages);
+			}
+			else
+			{
+				change_image_layout(cmd, image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subres_range);
+			}
 
 			return section;
 		}
@@ -1018,13 +1115,14 @@ namespace vk
 
 	public:
 
-		void initialize(vk::render_device& device, VkQueue submit_queue, vk::vk_data_heap& upload_heap)
+		void initialize(vk::render_device& device, VkQueue submit_queue, vk::vk_data_heap& upload_heap, vk::async_transfer_queue* transfer_queue = nullptr)
 		{
 			m_device = &device;
 			m_memory_types = device.get_memory_mapping();
 			m_formats_support = device.get_formats_support();
 			m_submit_queue = submit_queue;
 			m_texture_upload_heap = &upload_heap;
+			m_transfer_queue = transfer_queue;
 		}
 
 		void destroy() override
@@ -1071,6 +1169,18 @@ namespace vk
 
 		void on_frame_end() override
 		{
+			u64 bytes_to_free = 0;
+			u64 budget, usage;
+			if (m_device->get_device_local_budget(budget, usage))
+			{
+				//Leave a tenth of the budget to render targets and the driver
+				const u64 limit = budget - budget / 10;
+				if (usage > limit)
+					bytes_to_free = usage - limit;
+			}
+
+			evict_unused_sections(bytes_to_free);
+
 			if (m_unreleased_texture_objects >= m_max_zombie_objects ||
 				m_discarded_memory_size > 0x4000000) //If already holding over 64M in discardable memory, be frugal with memory resources
 			{
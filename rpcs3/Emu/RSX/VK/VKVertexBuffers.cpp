@@ -2,6 +2,7 @@
 #include "Emu/Memory/Memory.h"
 #include "Emu/System.h"
 #include "VKGSRender.h"
+#include "VKCompute.h"
 #include "../rsx_methods.h"
 #include "../Common/BufferUtils.h"
 
@@ -61,11 +62,52 @@ namespace vk
 namespace
 {
 
+	// Below this many indices the dispatch and barrier cost more than writing the indices on the CPU
+	constexpr u32 min_gpu_index_expansion_count = 4096;
+
+	vk::cs_expand_index_base* get_index_expansion_task(rsx::primitive_type primitive)
+	{
+		switch (primitive)
+		{
+		case rsx::primitive_type::line_loop:
+			return vk::get_compute_task<vk::cs_expand_line_loop>();
+		case rsx::primitive_type::polygon:
+		case rsx::primitive_type::triangle_fan:
+			return vk::get_compute_task<vk::cs_expand_triangle_fan>();
+		case rsx::primitive_type::quads:
+			return vk::get_compute_task<vk::cs_expand_quads>();
+		default:
+			return nullptr;
+		}
+	}
+
 	std::tuple<u32, std::tuple<VkDeviceSize, VkIndexType>> generate_emulating_index_buffer(
 		const rsx::draw_clause& clause, u32 vertex_count,
-		vk::vk_data_heap& m_index_buffer_ring_info)
+		vk::vk_data_heap& m_index_buffer_ring_info, const std::function<VkCommandBuffer()>& get_cmd)
 	{
 		u32 index_count = get_index_count(clause.primitive, vertex_count);
+
+		if (index_count >= min_gpu_index_expansion_count)
+		{
+			auto kernel = get_index_expansion_task(clause.primitive);
+			if (kernel && kernel->has_free_descriptors())
+			{
+				// Generated indices never leave the GPU, so use 32-bit indices and skip the u16 limit of the CPU path
+				const u32 upload_size = index_count * sizeof(u32);
+				VkDeviceSize offset_in_index_buffer = m_index_buffer_ring_info.alloc<256>(upload_size);
+				const VkCommandBuffer cmd = get_cmd();
+
+				kernel->run(cmd, m_index_buffer_ring_info.heap.get(), index_count, (u32)offset_in_index_buffer);
+
+				vk::insert_buffer_memory_barrier(cmd, m_index_buffer_ring_info.heap->value, offset_in_index_buffer, upload_size,
+					VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+					VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDEX_READ_BIT);
+
+				return std::make_tuple(
+					index_count, std::make_tuple(offset_in_index_buffer, VK_INDEX_TYPE_UINT32));
+			}
+		}
+
 		u32 upload_size = index_count * sizeof(u16);
 
 		VkDeviceSize offset_in_index_buffer = m_index_buffer_ring_info.alloc<256>(upload_size);
@@ -91,9 +133,10 @@ namespace
 
 	struct draw_command_visitor
 	{
-		draw_command_visitor(vk::vk_data_heap& index_buffer_ring_info, rsx::vertex_input_layout& layout)
+		draw_command_visitor(vk::vk_data_heap& index_buffer_ring_info, rsx::vertex_input_layout& layout, std::function<VkCommandBuffer()> get_cmd)
 			: m_index_buffer_ring_info(index_buffer_ring_info)
 			, m_vertex_layout(layout)
+			, m_get_cmd(std::move(get_cmd))
 		{
 		}
 
@@ -113,7 +156,7 @@ namespace
 
 				std::tie(index_count, index_info) =
 					generate_emulating_index_buffer(rsx::method_registers.current_draw_clause,
-						vertex_count, m_index_buffer_ring_info);
+						vertex_count, m_index_buffer_ring_info, m_get_cmd);
 
 				return{ prims, index_count, vertex_count, min_index, 0, index_info };
 			}
@@ -221,21 +264,78 @@ namespace
 
 			u32 index_count;
 			std::optional<std::tuple<VkDeviceSize, VkIndexType>> index_info;
-			std::tie(index_count, index_info) = generate_emulating_index_buffer(draw_clause, vertex_count, m_index_buffer_ring_info);
+			std::tie(index_count, index_info) = generate_emulating_index_buffer(draw_clause, vertex_count, m_index_buffer_ring_info, m_get_cmd);
 			return{ prims, index_count, vertex_count, 0, 0, index_info };
 		}
 
 	private:
 		vk::vk_data_heap& m_index_buffer_ring_info;
 		rsx::vertex_input_layout& m_vertex_layout;
+		std::function<VkCommandBuffer()> m_get_cmd;
 	};
 }
 
+bool VKGSRender::get_local_memory_window(u32 address, u32 size, u32& window_offset)
+{
+	if (!m_local_memory_import_checked)
+	{
+		m_local_memory_import_checked = true;
+
+		if (m_device->get_external_memory_host_support())
+		{
+			//Local memory is allocated in one piece from the start of the video block
+			const auto block = vm::get(vm::video);
+			const u32 import_size = block ? block->used() & ~0xffffu : 0;
+
+			if (import_size)
+			{
+				auto buffer = std::make_unique<vk::host_buffer>(*m_device, vm::base(local_mem_addr), import_size, VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+
+				if (buffer->valid())
+				{
+					LOG_NOTICE(RSX, "Imported 0x%x bytes of RSX local memory", import_size);
+					m_local_memory_buffer = std::move(buffer);
+				}
+			}
+		}
+	}
+
+	if (!m_local_memory_buffer || address < local_mem_addr || (u64{address - local_mem_addr} + size) > m_local_memory_buffer->size())
+	{
+		return false;
+	}
+
+	const u32 local_offset = address - local_mem_addr;
+
+	if (m_persistent_attribute_storage && m_persistent_attribute_storage->info.buffer == m_local_memory_buffer->value &&
+		m_persistent_attribute_storage->in_range(local_offset, size, window_offset))
+	{
+		return true;
+	}
+
+	if (m_persistent_attribute_storage)
+		m_current_frame->buffer_views_to_clean.push_back(std::move(m_persistent_attribute_storage));
+
+	//minTexelBufferOffsetAlignment is at most 256 bytes
+	const u32 view_base = local_offset & ~0xffu;
+	const u32 view_size = std::min<u32>(0x4000000, m_local_memory_buffer->size() - view_base);
+
+	m_persistent_attribute_storage = std::make_unique<vk::buffer_view>(*m_device, m_local_memory_buffer->value, VK_FORMAT_R8_UINT, view_base, view_size);
+	window_offset = local_offset - view_base;
+	return true;
+}
+
 vk::vertex_upload_info VKGSRender::upload_vertex_data()
 {
 	m_vertex_layout = analyse_inputs_interleaved();
 
-	draw_command_visitor visitor(m_index_buffer_ring_info, m_vertex_layout);
+	//NOTE: Index expansion only writes to freshly allocated index ring space, so it can be recorded ahead of any batched draws
+	//Dispatches can't be recorded inside a render pass, the open one is only closed once a draw actually expands on the GPU
+	draw_command_visitor visitor(m_index_buffer_ring_info, m_vertex_layout, [this]() -> VkCommandBuffer
+	{
+		close_render_pass();
+		return *m_current_command_buffer;
+	});
 	auto result = std::apply_visitor(visitor, get_draw_command(rsx::method_registers));
 
 	auto &vertex_count = result.allocated_vertex_count;
@@ -245,8 +345,22 @@ vk::vertex_upload_info VKGSRender::upload_vertex_data()
 	auto required = calculate_memory_requirements(m_vertex_layout, vertex_count);
 	u32 persistent_range_base = UINT32_MAX, volatile_range_base = UINT32_MAX;
 	size_t persistent_offset = UINT64_MAX, volatile_offset = UINT64_MAX;
+	bool persistent_in_place = false;
+
+	if (required.first > 0 && m_vertex_layout.interleaved_blocks.size() == 1 &&
+		rsx::method_registers.current_draw_clause.command != rsx::draw_command::inlined_array)
+	{
+		//A single block living in imported local memory is read by the shaders without a staging copy
+		const auto &block = m_vertex_layout.interleaved_blocks[0];
+		const u32 data_offset = (block.single_vertex || block.min_divisor > 1) ? 0 : vertex_base * block.attribute_stride;
+
+		if (get_local_memory_window(block.real_offset_address + data_offset, required.first, persistent_range_base))
+		{
+			persistent_in_place = true;
+		}
+	}
 
-	if (required.first > 0)
+	if (required.first > 0 && !persistent_in_place)
 	{
 		//Check if cacheable
 		//Only data in the 'persistent' block may be cached
@@ -318,9 +432,10 @@ vk::vertex_upload_info VKGSRender::upload_vertex_data()
 		}
 	}
 
-	if (persistent_range_base != UINT32_MAX)
+	if (persistent_range_base != UINT32_MAX && !persistent_in_place)
 	{
-		if (!m_persistent_attribute_storage || !m_persistent_attribute_storage->in_range(persistent_range_base, required.first, persistent_range_base))
+		if (!m_persistent_attribute_storage || m_persistent_attribute_storage->info.buffer != m_attrib_ring_info.heap->value ||
+			!m_persistent_attribute_storage->in_range(persistent_range_base, required.first, persistent_range_base))
 		{
 			if (m_persistent_attribute_storage)
 				m_current_frame->buffer_views_to_clean.push_back(std::move(m_persistent_attribute_storage));
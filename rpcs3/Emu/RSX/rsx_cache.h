@@ -8,7 +8,11 @@
 #include "Emu/System.h"
 
 #include "rsx_utils.h"
+#include "xxhash.h"
 #include <thread>
+#include <list>
+#include <map>
+#include <set>
 
 namespace rsx
 {
@@ -26,6 +30,44 @@ namespace rsx
 		confirmed_range
 	};
 
+	//Batch collecting section protection changes on this thread, if one is open
+	static inline utils::protection_batch*& get_protection_batch()
+	{
+		static thread_local utils::protection_batch* batch = nullptr;
+		return batch;
+	}
+
+	/**
+	* Defers page protection changes made by sections until the scope closes, coalescing them into as few host calls as possible.
+	* Must not span code that touches the affected guest memory through vm::base. Nested scopes join the outermost one.
+	*/
+	class protection_batch_scope
+	{
+		utils::protection_batch m_batch;
+		bool m_owner;
+
+	public:
+		protection_batch_scope()
+			: m_owner(get_protection_batch() == nullptr)
+		{
+			if (m_owner)
+			{
+				get_protection_batch() = &m_batch;
+			}
+		}
+
+		protection_batch_scope(const protection_batch_scope&) = delete;
+
+		~protection_batch_scope()
+		{
+			if (m_owner)
+			{
+				get_protection_batch() = nullptr;
+				m_batch.apply();
+			}
+		}
+	};
+
 	class buffered_section
 	{
 	private:
@@ -120,7 +162,16 @@ namespace rsx
 			if (prot == protection) return;
 
 			verify(HERE), locked_address_range > 0;
-			utils::memory_protect(vm::base(locked_address_base), locked_address_range, prot);
+
+			if (prot != utils::protection::rw)
+			{
+				vm::set_page_owner(locked_address_base, locked_address_range, prot == utils::protection::no ? vm::page_owner::rsx_framebuffer : vm::page_owner::rsx_texture_cache);
+			}
+
+			if (auto batch = get_protection_batch())
+				batch->add(vm::base(locked_address_base), locked_address_range, prot);
+			else
+				utils::memory_protect(vm::base(locked_address_base), locked_address_range, prot);
 			protection = prot;
 			locked = prot != utils::protection::rw;
 
@@ -368,6 +419,173 @@ namespace rsx
 		}
 	};
 
+	/**
+	* Append-only pack of compiled shader blobs (SPIR-V, GL program binaries) of the running title, next to the shaders cache.
+	* Blobs are keyed by a hash of their source, the header tag invalidates the whole pack (e.g. when the driver changes).
+	* The pack is indexed on first use and reopened when the title changes. Safe to use from several threads.
+	*/
+	class binary_cache
+	{
+		struct pack_header
+		{
+			u64 magic;
+			u32 version;
+			u32 reserved;
+			u64 tag;
+		};
+
+		struct pack_record
+		{
+			std::array<u64, 2> key;
+			u32 size;
+			u32 reserved;
+		};
+
+		const std::string m_name;
+		const u64 m_magic;
+		const u32 m_version;
+		u64 m_tag = 0;
+
+		std::mutex m_mutex;
+		fs::file m_pack;
+		std::string m_pack_path;
+		std::map<std::array<u64, 2>, std::vector<u8>> m_blobs;
+
+		// Must be called with m_mutex held
+		bool open()
+		{
+			if (g_cfg.video.disable_on_disk_shader_cache || Emu.GetCachePath().empty())
+			{
+				return false;
+			}
+
+			const std::string path = Emu.GetCachePath() + "/shaders_cache/" + m_name;
+
+			if (m_pack && m_pack_path == path)
+			{
+				return true;
+			}
+
+			m_pack.close();
+			m_blobs.clear();
+			m_pack_path = path;
+
+			fs::create_path(Emu.GetCachePath() + "/shaders_cache");
+
+			if (!m_pack.open(path, fs::read + fs::write + fs::create))
+			{
+				LOG_ERROR(RSX, "%s: failed to open '%s' (%s)", m_name, path, fs::g_tls_error);
+				return false;
+			}
+
+			pack_header header{};
+			if (m_pack.size() < sizeof(pack_header) || !m_pack.read(&header, sizeof(pack_header)) ||
+				header.magic != m_magic || header.version != m_version || header.tag != m_tag)
+			{
+				if (m_pack.size())
+				{
+					LOG_NOTICE(RSX, "%s: blobs were built for another version or driver, the pack was reset", m_name);
+				}
+
+				header = { m_magic, m_version, 0, m_tag };
+				m_pack.trunc(0);
+				m_pack.seek(0);
+				m_pack.write(header);
+				return true;
+			}
+
+			auto contents = m_pack.map(0, m_pack.size());
+
+			const u64 size = contents.size();
+			u64 pos = sizeof(pack_header);
+
+			while (pos + sizeof(pack_record) <= size)
+			{
+				pack_record record;
+				std::memcpy(&record, contents.data() + pos, sizeof(pack_record));
+
+				if (pos + sizeof(pack_record) + record.size > size)
+					break;
+
+				const u8* payload = contents.data() + pos + sizeof(pack_record);
+				pos += sizeof(pack_record) + record.size;
+
+				m_blobs[record.key].assign(payload, payload + record.size);
+			}
+
+			contents = {};
+
+			if (pos != size)
+			{
+				// Interrupted append, drop the partial record so new ones stay reachable
+				LOG_WARNING(RSX, "%s: discarding %llu bytes of truncated data", m_name, size - pos);
+				m_pack.trunc(pos);
+			}
+
+			m_pack.seek(0, fs::seek_end);
+			return true;
+		}
+
+	public:
+		// Bump the version when the way blobs are built changes
+		binary_cache(std::string name, u64 magic, u32 version)
+			: m_name(std::move(name))
+			, m_magic(magic)
+			, m_version(version)
+		{
+		}
+
+		static std::array<u64, 2> get_key(const std::string& source, u64 seed = 0)
+		{
+			return{ XXH64(source.data(), source.size(), seed), XXH64(source.data(), source.size(), seed + 1) ^ source.size() };
+		}
+
+		// Identifies what the blobs are valid for, a pack with another tag is discarded when opened
+		void set_tag(u64 tag)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (m_tag != tag)
+			{
+				m_tag = tag;
+				m_pack.close();
+			}
+		}
+
+		bool load(const std::array<u64, 2>& key, std::vector<u8>& blob)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (!open())
+			{
+				return false;
+			}
+
+			const auto found = m_blobs.find(key);
+			if (found == m_blobs.end())
+			{
+				return false;
+			}
+
+			blob = found->second;
+			return true;
+		}
+
+		void store(const std::array<u64, 2>& key, const void* data, u32 size)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (!open() || !m_blobs.emplace(key, std::vector<u8>((const u8*)data, (const u8*)data + size)).second)
+			{
+				return;
+			}
+
+			const pack_record record{ key, size };
+			m_pack.write(record);
+			m_pack.write(data, size);
+		}
+	};
+
 	template <typename pipeline_storage_type, typename backend_storage>
 	class shaders_cache
 	{
@@ -393,13 +611,267 @@ namespace rsx
 			pipeline_storage_type pipeline_properties;
 		};
 
+		// All programs and pipelines of a pipeline class live in a single append-only archive.
+		// Every record carries its own header, so the index is rebuilt with one pass over the file at load.
+		enum archive_record_type : u32
+		{
+			archive_vertex_program = 1,
+			archive_fragment_program,
+			archive_pipeline,
+		};
+
+		struct archive_header
+		{
+			u64 magic;
+			u32 version;
+			u32 reserved;
+		};
+
+		struct archive_record
+		{
+			u32 type;
+			u32 size;
+			std::array<u64, 4> key; // programs: hash in key[0], pipelines: vp hash, fp hash, storage hash, state hash
+		};
+
+		static constexpr u64 archive_magic = 0x4B434150435352ull; // "RSCPACK"
+		static constexpr u32 archive_version = 1;
+
 		std::string version_prefix;
 		std::string root_path;
 		std::string pipeline_class_name;
 		std::unordered_map<u64, std::vector<u8>> fragment_program_data;
+		std::unordered_map<u64, std::vector<u32>> vertex_program_data;
+		std::mutex program_data_mutex;
+
+		fs::file archive;
+		std::set<std::array<u64, 4>> stored_pipelines;
+		std::mutex archive_mutex;
 
 		backend_storage& m_storage;
 
+		std::string get_legacy_directory_path() const
+		{
+			return root_path + "/pipelines/" + pipeline_class_name + "/" + version_prefix;
+		}
+
+		std::string get_archive_path() const
+		{
+			return root_path + "/pipelines/" + pipeline_class_name + "/" + version_prefix + ".pack";
+		}
+
+		static u64 get_state_hash(const pipeline_data& data)
+		{
+			u64 state_hash = 0;
+			state_hash ^= rpcs3::hash_base<u32>(data.vp_ctrl);
+			state_hash ^= rpcs3::hash_base<u32>(data.fp_ctrl);
+			state_hash ^= rpcs3::hash_base<u32>(data.fp_texture_dimensions);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_unnormalized_coords);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_height);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_pixel_layout);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_lighting_flags);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_shadow_textures);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_redirected_textures);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_alphakill_mask);
+			state_hash ^= rpcs3::hash_base<u64>(data.fp_zfunc_mask);
+			return state_hash;
+		}
+
+		static std::array<u64, 4> get_pipeline_key(const pipeline_data& data)
+		{
+			return{ data.vertex_program_hash, data.fragment_program_hash, data.pipeline_storage_hash, get_state_hash(data) };
+		}
+
+		// Must be called with archive_mutex held
+		void append_record(archive_record_type type, const std::array<u64, 4>& key, const void* data, u32 size)
+		{
+			const archive_record record{ type, size, key };
+			archive.write(record);
+			archive.write(data, size);
+		}
+
+		// Must be called with archive_mutex held
+		bool open_archive()
+		{
+			if (archive)
+			{
+				return true;
+			}
+
+			const std::string archive_path = get_archive_path();
+			const bool migrate = !fs::is_file(archive_path);
+
+			fs::create_path(root_path + "/pipelines/" + pipeline_class_name);
+
+			if (!archive.open(archive_path, fs::read + fs::write + fs::create))
+			{
+				LOG_ERROR(RSX, "shader cache: failed to open archive '%s' (%s)", archive_path, fs::g_tls_error);
+				return false;
+			}
+
+			archive_header header{};
+			if (archive.size() < sizeof(archive_header) || !archive.read(&header, sizeof(archive_header)) ||
+				header.magic != archive_magic || header.version != archive_version)
+			{
+				if (archive.size())
+				{
+					LOG_WARNING(RSX, "shader cache: archive '%s' is not compatible with the current shader cache and was reset", archive_path);
+				}
+
+				header = { archive_magic, archive_version };
+				archive.trunc(0);
+				archive.seek(0);
+				archive.write(header);
+			}
+
+			if (migrate)
+			{
+				import_legacy_directory();
+			}
+
+			archive.seek(0, fs::seek_end);
+			return true;
+		}
+
+		// One-time import of the per-file layout used before the archive existed. The old files are left untouched.
+		void import_legacy_directory()
+		{
+			const std::string directory_path = get_legacy_directory_path();
+			if (!fs::is_dir(directory_path))
+			{
+				return;
+			}
+
+			archive.seek(0, fs::seek_end);
+
+			u32 imported = 0;
+			for (const auto& entry : fs::dir(directory_path))
+			{
+				if (entry.is_directory)
+					continue;
+
+				pipeline_data data;
+				fs::file f(directory_path + "/" + entry.name);
+				if (!f || f.size() != sizeof(pipeline_data) || f.read(&data, sizeof(pipeline_data)) != sizeof(pipeline_data))
+					continue;
+
+				const auto key = get_pipeline_key(data);
+				if (stored_pipelines.count(key))
+					continue;
+
+				std::lock_guard<std::mutex> lock(program_data_mutex);
+
+				auto& vp = vertex_program_data[data.vertex_program_hash];
+				if (vp.empty())
+				{
+					const fs::file vp_file(root_path + "/raw/" + fmt::format("%llX.vp", data.vertex_program_hash));
+					if (!vp_file || !vp_file.read(vp, vp_file.size() / sizeof(u32)) || vp.empty())
+					{
+						vertex_program_data.erase(data.vertex_program_hash);
+						continue;
+					}
+
+					append_record(archive_vertex_program, { data.vertex_program_hash }, vp.data(), ::size32(vp) * sizeof(u32));
+				}
+
+				auto& fp = fragment_program_data[data.fragment_program_hash];
+				if (fp.empty())
+				{
+					const fs::file fp_file(root_path + "/raw/" + fmt::format("%llX.fp", data.fragment_program_hash));
+					if (!fp_file || !fp_file.read(fp, fp_file.size()) || fp.empty())
+					{
+						fragment_program_data.erase(data.fragment_program_hash);
+						continue;
+					}
+
+					append_record(archive_fragment_program, { data.fragment_program_hash }, fp.data(), ::size32(fp));
+				}
+
+				stored_pipelines.insert(key);
+				append_record(archive_pipeline, key, &data, sizeof(pipeline_data));
+				imported++;
+			}
+
+			LOG_NOTICE(RSX, "shader cache: imported %u pipeline entries from '%s'", imported, directory_path);
+		}
+
+		// Must be called with archive_mutex held
+		void read_archive(std::vector<pipeline_data>& pipelines)
+		{
+			// Map the whole archive, entries are sliced out of the view (released before truncation)
+			auto contents = archive.map(0, archive.size());
+
+			const u64 size = contents.size();
+			u64 pos = sizeof(archive_header);
+			u32 incompatible = 0;
+
+			std::lock_guard<std::mutex> lock(program_data_mutex);
+
+			while (pos + sizeof(archive_record) <= size)
+			{
+				archive_record record;
+				std::memcpy(&record, contents.data() + pos, sizeof(archive_record));
+
+				if (pos + sizeof(archive_record) + record.size > size)
+					break;
+
+				const u8* payload = contents.data() + pos + sizeof(archive_record);
+				pos += sizeof(archive_record) + record.size;
+
+				switch (record.type)
+				{
+				case archive_vertex_program:
+				{
+					auto& vp = vertex_program_data[record.key[0]];
+					if (vp.empty())
+						vp.assign((const u32*)payload, (const u32*)(payload + (record.size & ~3)));
+					break;
+				}
+				case archive_fragment_program:
+				{
+					auto& fp = fragment_program_data[record.key[0]];
+					if (fp.empty())
+						fp.assign(payload, payload + record.size);
+					break;
+				}
+				case archive_pipeline:
+				{
+					if (record.size != sizeof(pipeline_data))
+					{
+						incompatible++;
+						break;
+					}
+
+					if (stored_pipelines.insert(record.key).second)
+					{
+						pipelines.emplace_back();
+						std::memcpy(&pipelines.back(), payload, sizeof(pipeline_data));
+					}
+					break;
+				}
+				default:
+					incompatible++;
+					break;
+				}
+			}
+
+			contents = {};
+
+			if (pos != size)
+			{
+				// Interrupted append, drop the partial record so new ones stay reachable
+				LOG_WARNING(RSX, "shader cache: discarding %llu bytes of truncated data at the end of the archive", size - pos);
+				archive.trunc(pos);
+			}
+
+			if (incompatible)
+			{
+				LOG_ERROR(RSX, "shader cache: %u archive entries are not binary compatible with the current shader cache", incompatible);
+			}
+
+			archive.seek(0, fs::seek_end);
+		}
+
 	public:
 
 		struct progress_dialog_helper
@@ -482,37 +954,22 @@ namespace rsx
 				return;
 			}
 
-			std::string directory_path = root_path + "/pipelines/" + pipeline_class_name + "/" + version_prefix;
-
-			if (!fs::is_dir(directory_path))
+			std::vector<pipeline_data> pipelines;
 			{
-				fs::create_path(directory_path);
-				fs::create_path(root_path + "/raw");
+				std::lock_guard<std::mutex> lock(archive_mutex);
 
-				return;
-			}
+				if (!open_archive())
+					return;
 
-			fs::dir root = fs::dir(directory_path);
-
-			u32 entry_count = 0;
-			std::vector<fs::dir_entry> entries;
-			for (auto It = root.begin(); It != root.end(); ++It, entry_count++)
-			{
-				fs::dir_entry tmp = *It;
-
-				if (tmp.name == "." || tmp.name == "..")
-					continue;
-
-				entries.push_back(tmp);
+				read_archive(pipelines);
 			}
 
-			if ((entry_count = (u32)entries.size()) <= 2)
+			const u32 entry_count = ::size32(pipelines);
+			if (!entry_count)
 				return;
 
-			root.rewind();
-
-			// Invalid pipeline entries to be removed
-			std::vector<std::string> invalid_entries;
+			// Pipelines referencing programs missing from the archive
+			atomic_t<u32> invalid_entries{ 0 };
 
 			// Progress dialog
 			std::unique_ptr<progress_dialog_helper> fallback_dlg;
@@ -532,60 +989,52 @@ namespace rsx
 			unsigned nb_threads = std::thread::hardware_concurrency();
 			std::vector<std::thread> worker_threads(nb_threads);
 
-			// Preload everything needed to compile the shaders
-			// Can probably be parallelized too, but since it's mostly reading files it's probably not worth it
-			std::vector<std::tuple<pipeline_storage_type, RSXVertexProgram, RSXFragmentProgram>> unpackeds;
+			// Programs and pipelines are built on worker threads when the backend supports it (GL needs its context)
+			const bool multithreaded = (g_cfg.video.renderer == video_renderer::vulkan);
+
+			std::vector<std::tuple<pipeline_storage_type, RSXVertexProgram, RSXFragmentProgram>> unpackeds(entry_count);
+			std::vector<u8> entry_valid(entry_count, 0);
+
 			std::chrono::time_point<steady_clock> last_update;
 			u32 processed_since_last_update = 0;
 
-			for (u32 i = 0; (i < entry_count) && !Emu.IsStopped(); i++)
+			// Unpacks and decompiles a single entry
+			auto preload_entry = [&](u32 index)
 			{
-				fs::dir_entry tmp = entries[i];
-
-				const auto filename = directory_path + "/" + tmp.name;
-				std::vector<u8> bytes;
-				fs::file f(filename);
-				if (f.size() != sizeof(pipeline_data))
+				if (!has_programs(pipelines[index]))
 				{
-					LOG_ERROR(RSX, "Cached pipeline object %s is not binary compatible with the current shader cache", tmp.name.c_str());
-					invalid_entries.push_back(filename);
-					continue;
+					invalid_entries++;
+					return;
 				}
-				f.read<u8>(bytes, f.size());
-
-				auto unpacked = unpack(*(pipeline_data*)bytes.data());
-				m_storage.preload_programs(std::get<1>(unpacked), std::get<2>(unpacked));
-				unpackeds.push_back(unpacked);
 
-				// Only update the screen at about 10fps since updating it everytime slows down the process
-				std::chrono::time_point<steady_clock> now = std::chrono::steady_clock::now();
-				processed_since_last_update++;
-				if ((std::chrono::duration_cast<std::chrono::milliseconds>(now - last_update) > 100ms) || (i == entry_count - 1))
-				{
-					dlg->update_msg(0, i + 1, entry_count);
-					dlg->inc_value(0, processed_since_last_update);
-					last_update = now;
-					processed_since_last_update = 0;
-				}
-			}
+				unpackeds[index] = unpack(pipelines[index]);
+				m_storage.preload_programs(std::get<1>(unpackeds[index]), std::get<2>(unpackeds[index]));
+				entry_valid[index] = 1;
+			};
 
-			atomic_t<u32> processed(0);
-			std::function<void(u32)> shader_comp_worker = [&](u32 index)
+			auto compile_entry = [&](u32 index)
 			{
-				u32 pos;
-				while (((pos = processed++) < entry_count) && !Emu.IsStopped())
-				{
-					auto unpacked = unpackeds[pos];
-					m_storage.add_pipeline_entry(std::get<1>(unpacked), std::get<2>(unpacked), std::get<0>(unpacked), std::forward<Args>(args)...);
-				}
+				if (!entry_valid[index])
+					return;
+
+				auto &unpacked = unpackeds[index];
+				m_storage.add_pipeline_entry(std::get<1>(unpacked), std::get<2>(unpacked), std::get<0>(unpacked), std::forward<Args>(args)...);
 			};
 
-			if (g_cfg.video.renderer == video_renderer::vulkan)
+			// Runs func over all entries on the workers while updating progress bar 'stage' from this thread
+			auto run_parallel = [&](u32 stage, auto&& func)
 			{
-				// Start workers
+				atomic_t<u32> processed(0);
 				for (u32 i = 0; i < nb_threads; i++)
 				{
-					worker_threads[i] = std::thread(shader_comp_worker, i);
+					worker_threads[i] = std::thread([&]()
+					{
+						u32 pos;
+						while (((pos = processed++) < entry_count) && !Emu.IsStopped())
+						{
+							func(pos);
+						}
+					});
 				}
 
 				// Wait for the workers to finish their task while updating UI
@@ -602,44 +1051,50 @@ namespace rsx
 
 					if (processed_since_last_update > 0)
 					{
-						dlg->update_msg(1, current_progress, entry_count);
-						dlg->inc_value(1, processed_since_last_update);
+						dlg->update_msg(stage, current_progress, entry_count);
+						dlg->inc_value(stage, processed_since_last_update);
 					}
 				}
 
-				// Need to join the threads to be absolutely sure shader compilation is done.
+				// Need to join the threads to be absolutely sure all work is done.
 				for (std::thread& worker_thread : worker_threads)
 					worker_thread.join();
-			}
-			else
+			};
+
+			auto run_serial = [&](u32 stage, auto&& func)
 			{
-				u32 pos;
-				while (((pos = processed++) < entry_count) && !Emu.IsStopped())
+				processed_since_last_update = 0;
+				for (u32 pos = 0; (pos < entry_count) && !Emu.IsStopped(); pos++)
 				{
-					auto unpacked = unpackeds[pos];
-					m_storage.add_pipeline_entry(std::get<1>(unpacked), std::get<2>(unpacked), std::get<0>(unpacked), std::forward<Args>(args)...);
+					func(pos);
 
-					// Update screen at about 10fps
+					// Only update the screen at about 10fps since updating it everytime slows down the process
 					std::chrono::time_point<steady_clock> now = std::chrono::steady_clock::now();
 					processed_since_last_update++;
 					if ((std::chrono::duration_cast<std::chrono::milliseconds>(now - last_update) > 100ms) || (pos == entry_count - 1))
 					{
-						dlg->update_msg(1, pos + 1, entry_count);
-						dlg->inc_value(1, processed_since_last_update);
+						dlg->update_msg(stage, pos + 1, entry_count);
+						dlg->inc_value(stage, processed_since_last_update);
 						last_update = now;
 						processed_since_last_update = 0;
 					}
 				}
-			}
+			};
 
-			if (!invalid_entries.empty())
+			if (multithreaded)
 			{
-				for (const auto &filename : invalid_entries)
-				{
-					fs::remove_file(filename);
-				}
+				run_parallel(0, preload_entry);
+				run_parallel(1, compile_entry);
+			}
+			else
+			{
+				run_serial(0, preload_entry);
+				run_serial(1, compile_entry);
+			}
 
-				LOG_NOTICE(RSX, "shader cache: %d entries were marked as invalid and removed", invalid_entries.size());
+			if (const u32 count = invalid_entries.load())
+			{
+				LOG_NOTICE(RSX, "shader cache: %u entries reference missing programs and were skipped", count);
 			}
 
 			dlg->refresh();
@@ -654,48 +1109,52 @@ namespace rsx
 			}
 
 			pipeline_data data = pack(pipeline, vp, fp);
-			std::string fp_name = root_path + "/raw/" + fmt::format("%llX.fp", data.fragment_program_hash);
-			std::string vp_name = root_path + "/raw/" + fmt::format("%llX.vp", data.vertex_program_hash);
+			const auto key = get_pipeline_key(data);
+
+			std::lock_guard<std::mutex> lock(archive_mutex);
 
-			if (!fs::is_file(fp_name))
+			if (!open_archive() || !stored_pipelines.insert(key).second)
 			{
-				const auto size = program_hash_util::fragment_program_utils::get_fragment_program_ucode_size(fp.addr);
-				fs::file(fp_name, fs::rewrite).write(fp.addr, size);
+				return;
 			}
 
-			if (!fs::is_file(vp_name))
 			{
-				fs::file(vp_name, fs::rewrite).write<u32>(vp.data);
+				std::lock_guard<std::mutex> lock(program_data_mutex);
+
+				auto& stored_fp = fragment_program_data[data.fragment_program_hash];
+				if (stored_fp.empty())
+				{
+					const auto size = program_hash_util::fragment_program_utils::get_fragment_program_ucode_size(fp.addr);
+					stored_fp.assign((const u8*)fp.addr, (const u8*)fp.addr + size);
+					append_record(archive_fragment_program, { data.fragment_program_hash }, stored_fp.data(), ::size32(stored_fp));
+				}
+
+				auto& stored_vp = vertex_program_data[data.vertex_program_hash];
+				if (stored_vp.empty())
+				{
+					stored_vp = vp.data;
+					append_record(archive_vertex_program, { data.vertex_program_hash }, stored_vp.data(), ::size32(stored_vp) * sizeof(u32));
+				}
 			}
 
-			u64 state_hash = 0;
-			state_hash ^= rpcs3::hash_base<u32>(data.vp_ctrl);
-			state_hash ^= rpcs3::hash_base<u32>(data.fp_ctrl);
-			state_hash ^= rpcs3::hash_base<u32>(data.fp_texture_dimensions);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_unnormalized_coords);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_height);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_pixel_layout);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_lighting_flags);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_shadow_textures);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_redirected_textures);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_alphakill_mask);
-			state_hash ^= rpcs3::hash_base<u64>(data.fp_zfunc_mask);
+			append_record(archive_pipeline, key, &data, sizeof(pipeline_data));
+		}
 
-			std::string pipeline_file_name = fmt::format("%llX+%llX+%llX+%llX.bin", data.vertex_program_hash, data.fragment_program_hash, data.pipeline_storage_hash, state_hash);
-			std::string pipeline_path = root_path + "/pipelines/" + pipeline_class_name + "/" + version_prefix + "/" + pipeline_file_name;
-			fs::file(pipeline_path, fs::rewrite).write(&data, sizeof(pipeline_data));
+		bool has_programs(const pipeline_data& data)
+		{
+			std::lock_guard<std::mutex> lock(program_data_mutex);
+			return vertex_program_data.count(data.vertex_program_hash) && fragment_program_data.count(data.fragment_program_hash);
 		}
 
 		RSXVertexProgram load_vp_raw(u64 program_hash)
 		{
-			std::vector<u32> data;
-			std::string filename = fmt::format("%llX.vp", program_hash);
+			RSXVertexProgram vp = {};
 
-			fs::file f(root_path + "/raw/" + filename);
-			f.read<u32>(data, f.size() / sizeof(u32));
+			{
+				std::lock_guard<std::mutex> lock(program_data_mutex);
+				vp.data = vertex_program_data.at(program_hash);
+			}
 
-			RSXVertexProgram vp = {};
-			vp.data = data;
 			vp.skip_vertex_input_check = true;
 
 			return vp;
@@ -703,15 +1162,11 @@ namespace rsx
 
 		RSXFragmentProgram load_fp_raw(u64 program_hash)
 		{
-			std::vector<u8> data;
-			std::string filename = fmt::format("%llX.fp", program_hash);
-
-			fs::file f(root_path + "/raw/" + filename);
-			f.read<u8>(data, f.size());
-
 			RSXFragmentProgram fp = {};
-			fragment_program_data[program_hash] = data;
-			fp.addr = fragment_program_data[program_hash].data();
+
+			// Entries are never replaced, earlier programs keep pointing into them
+			std::lock_guard<std::mutex> lock(program_data_mutex);
+			fp.addr = fragment_program_data.at(program_hash).data();
 
 			return fp;
 		}
@@ -774,6 +1229,15 @@ namespace rsx
 
 	namespace vertex_cache
 	{
+		struct cache_stats
+		{
+			u32 hits;
+			u32 misses;
+			u32 evictions;
+			u32 entries;
+			u64 cached_bytes;
+		};
+
 		// A null vertex cache
 		template <typename storage_type, typename upload_format>
 		class default_vertex_cache
@@ -782,6 +1246,9 @@ namespace rsx
 			virtual storage_type* find_vertex_range(uintptr_t /*local_addr*/, upload_format, u32 /*data_length*/) { return nullptr; }
 			virtual void store_range(uintptr_t /*local_addr*/, upload_format, u32 /*data_length*/, u32 /*offset_in_heap*/) {}
 			virtual void purge() {}
+
+			// Counters of the last purged (finished) frame
+			virtual cache_stats get_stats() const { return {}; }
 		};
 
 		// A weak vertex cache with no data checks or memory range locks
@@ -800,20 +1267,57 @@ namespace rsx
 		class weak_vertex_cache : public default_vertex_cache<uploaded_range<upload_format>, upload_format>
 		{
 			using storage_type = uploaded_range<upload_format>;
+			using lru_list = std::list<storage_type>;
 
 		private:
-			std::unordered_map<uintptr_t, std::vector<storage_type>> vertex_ranges;
+			// Most recently used first. Nodes are stable, so the address index refers to them directly
+			lru_list lru;
+			std::unordered_map<uintptr_t, std::vector<typename lru_list::iterator>> vertex_ranges;
+
+			u64 cached_bytes = 0;
+			u64 max_cached_bytes;
+
+			cache_stats current_stats = {};
+			cache_stats last_frame_stats = {};
+
+			void evict_oldest()
+			{
+				auto &victim = lru.back();
+				auto found = vertex_ranges.find(victim.local_address);
+				auto &bucket = found->second;
+
+				bucket.erase(std::find(bucket.begin(), bucket.end(), std::prev(lru.end())));
+				if (bucket.empty())
+					vertex_ranges.erase(found);
+
+				cached_bytes -= victim.data_length;
+				current_stats.evictions++;
+				lru.pop_back();
+			}
 
 		public:
+			// memory_budget bounds the amount of heap data referenced by the cache, 0 for no limit
+			weak_vertex_cache(u64 memory_budget = 0)
+				: max_cached_bytes(memory_budget)
+			{}
 
 			storage_type* find_vertex_range(uintptr_t local_addr, upload_format fmt, u32 data_length) override
 			{
-				for (auto &v : vertex_ranges[local_addr])
+				const auto found = vertex_ranges.find(local_addr);
+				if (found != vertex_ranges.end())
 				{
-					if (v.buffer_format == fmt && v.data_length == data_length)
-						return &v;
+					for (auto &it : found->second)
+					{
+						if (it->buffer_format == fmt && it->data_length == data_length)
+						{
+							lru.splice(lru.begin(), lru, it);
+							current_stats.hits++;
+							return &*it;
+						}
+					}
 				}
 
+				current_stats.misses++;
 				return nullptr;
 			}
 
@@ -825,12 +1329,32 @@ namespace rsx
 				v.local_address = local_addr;
 				v.offset_in_heap = offset_in_heap;
 
-				vertex_ranges[local_addr].push_back(v);
+				lru.push_front(v);
+				vertex_ranges[local_addr].push_back(lru.begin());
+				cached_bytes += data_length;
+
+				while (max_cached_bytes && cached_bytes > max_cached_bytes && lru.size() > 1)
+				{
+					evict_oldest();
+				}
 			}
 
 			void purge() override
 			{
+				// Heap space is recycled after the frame ends, cached ranges cannot outlive it
+				current_stats.entries = (u32)lru.size();
+				current_stats.cached_bytes = cached_bytes;
+				last_frame_stats = current_stats;
+				current_stats = {};
+
 				vertex_ranges.clear();
+				lru.clear();
+				cached_bytes = 0;
+			}
+
+			cache_stats get_stats() const override
+			{
+				return last_frame_stats;
 			}
 		};
 	}
@@ -8,6 +8,8 @@
 #include "Emu/Cell/PPUCallback.h"
 #include "Emu/Cell/lv2/sys_rsx.h"
 #include "Capture/rsx_capture.h"
+#include "Utilities/tracing.h"
+#include "Utilities/perf_counters.h"
 
 #include <sstream>
 #include <cereal/archives/binary.hpp>
@@ -350,9 +352,11 @@ namespace rsx
 				auto &value = rsx::method_registers.transform_constants[load + reg][subreg];
 				if (value != arg)
 				{
-					//Transform constants invalidation is expensive (~8k bytes per update)
+					//Only the written registers are uploaded again where the backend supports it
 					value = arg;
 					rsxthr->m_graphics_state |= rsx::pipeline_state::transform_constants_dirty;
+					rsxthr->m_transform_constants_dirty_begin = std::min(rsxthr->m_transform_constants_dirty_begin, load + reg);
+					rsxthr->m_transform_constants_dirty_end = std::max(rsxthr->m_transform_constants_dirty_end, load + reg + 1);
 				}
 			}
 		};
@@ -414,6 +418,7 @@ namespace rsx
 			if (!(rsx::method_registers.current_draw_clause.first_count_commands.empty() &&
 			        rsx::method_registers.current_draw_clause.inline_vertex_array.empty()))
 			{
+				tracing::scope trace(tracing::category::rsx, "draw");
 				rsxthr->end();
 			}
 		}
@@ -813,6 +818,7 @@ namespace rsx
 					return;
 			}
 
+			const u64 cpu_blit_start = get_system_time();
 			std::unique_ptr<u8[]> temp1, temp2, sw_temp;
 
 			const AVPixelFormat in_format = (src_color_format == rsx::blit_engine::transfer_source_format::r5g6b5) ? AV_PIX_FMT_RGB565BE : AV_PIX_FMT_ARGB;
@@ -952,6 +958,9 @@ namespace rsx
 
 				std::memcpy(pixels_dst, swizzled_pixels, out_bpp * sw_width * sw_height);
 			}
+
+			rsx->performance_counters.cpu_blits++;
+			rsx->performance_counters.cpu_blit_time += get_system_time() - cpu_blit_start;
 		}
 	}
 
@@ -1024,34 +1033,38 @@ namespace rsx
 		}
 		else if (user_asked_for_frame_capture && !rsx->capture_current_frame)
 		{
-			rsx->capture_current_frame = true;
 			user_asked_for_frame_capture = false;
 			frame_debug.reset();
 			frame_capture.reset();
 
-			// random number just to jumpstart the size
-			frame_capture.replay_commands.reserve(8000);
+			// todo: 'dynamicly' create capture filename
+			const std::string& filePath = fs::get_config_dir() + "capture.rrc";
+			if (!frame_capture.open_for_write(filePath))
+			{
+				LOG_ERROR(RSX, "RSX Capture: Failed to create capture file %s (%s)", filePath, fs::g_tls_error);
+			}
+			else
+			{
+				rsx->capture_current_frame = true;
+
+				// random number just to jumpstart the size
+				frame_capture.replay_commands.reserve(8000);
 
-			// capture first tile state with nop cmd
-			rsx::frame_capture_data::replay_command replay_cmd;
-			replay_cmd.rsx_command = std::make_pair(NV4097_NO_OPERATION, 0);
-			frame_capture.replay_commands.push_back(replay_cmd);
-			capture::capture_display_tile_state(rsx, frame_capture.replay_commands.back());
+				// capture first tile state with nop cmd
+				rsx::frame_capture_data::replay_command replay_cmd;
+				replay_cmd.rsx_command = std::make_pair(NV4097_NO_OPERATION, 0);
+				frame_capture.replay_commands.push_back(replay_cmd);
+				capture::capture_display_tile_state(rsx, frame_capture.replay_commands.back());
+			}
 		}
 		else if (rsx->capture_current_frame)
 		{
 			rsx->capture_current_frame = false;
-			std::stringstream os;
-			cereal::BinaryOutputArchive archive(os);
-			const std::string& filePath = fs::get_config_dir() + "capture.rrc";
-			archive(frame_capture);
-			{
-				// todo: 'dynamicly' create capture filename, also may want to compress this data?
-				fs::file f(filePath, fs::rewrite);
-				f.write(os.str());
-			}
 
-			LOG_SUCCESS(RSX, "capture successful: %s", filePath.c_str());
+			// memory blocks were streamed out during the capture, only the index is left to write
+			frame_capture.finish_write();
+
+			LOG_SUCCESS(RSX, "capture successful: %s", fs::get_config_dir() + "capture.rrc");
 
 			frame_capture.reset();
 			Emu.Pause();
@@ -1097,7 +1110,41 @@ namespace rsx
 
 		rsx->int_flip_index++;
 		rsx->current_display_buffer = arg;
-		rsx->flip(arg);
+
+		{
+			frame_timer_scope timer(rsx, frame_timer::flip);
+			tracing::scope trace(tracing::category::rsx, "flip");
+			trace.set_arg("buffer", arg);
+			rsx->flip(arg);
+		}
+
+		rsx->end_frame_timers();
+
+		const u64 flip_time = get_system_time();
+		const u64 draw_calls = rsx->performance_counters.draw_calls;
+
+		if (const u64 last_flip = rsx->performance_counters.last_flip_timestamp)
+		{
+			perf::rsx_frame_time_us.observe(flip_time - last_flip);
+		}
+
+		perf::rsx_draws_per_frame.observe(draw_calls - rsx->performance_counters.last_flip_draw_calls);
+		perf::rsx_flips.add();
+
+		rsx->performance_counters.last_flip_draw_calls = draw_calls;
+		rsx->performance_counters.last_flip_timestamp = flip_time;
+		rsx->performance_counters.flips++;
+
+		if (const u64 interval = g_cfg.core.memory_log_interval)
+		{
+			const u64 now = get_system_time();
+			if (now - rsx->last_memory_log_time >= interval * 1000000)
+			{
+				rsx->last_memory_log_time = now;
+				LOG_NOTICE(GENERAL, "Memory usage:%s", utils::format_memory_usage());
+			}
+		}
+
 		// After each flip PS3 system is executing a routine that changes registers value to some default.
 		// Some game use this default state (SH3).
 		if (rsx->isHLE)
@@ -1256,6 +1303,14 @@ namespace rsx
 		registers[reg] = value;
 	}
 
+	void rsx_state::decode(u32 reg, const be_t<u32>* values, u32 count)
+	{
+		for (u32 i = 0; i < count; i++)
+		{
+			registers[reg + i] = values[i];
+		}
+	}
+
 	bool rsx_state::test(u32 reg, u32 value) const
 	{
 		return registers[reg] == value;
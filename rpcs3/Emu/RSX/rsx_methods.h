@@ -192,6 +192,9 @@ namespace rsx
 
 		void decode(u32 reg, u32 value);
 
+		// Bulk register write from FIFO arguments (no side effects)
+		void decode(u32 reg, const be_t<u32>* values, u32 count);
+
 		bool test(u32 reg, u32 value) const;
 
 		void reset();
@@ -7,6 +7,8 @@
 #include "Overlays/overlays.h"
 #include "Utilities/sysinfo.h"
 
+#include <thread>
+
 extern "C"
 {
 #include "libswscale/swscale.h"
@@ -14,13 +16,130 @@ extern "C"
 
 namespace rsx
 {
+	namespace
+	{
+		// Blits and texture decodes are short lived, a few helpers are enough to hide most of the cost
+		u32 get_image_thread_count()
+		{
+			static const u32 count = std::min(std::clamp(std::thread::hardware_concurrency() / 4, 1u, 3u) + 1, thread_pool::get_thread_count());
+			return count;
+		}
+
+		void convert_scale_image_band(u8 *dst, AVPixelFormat dst_format, int dst_width, int dst_height, int dst_pitch,
+			const u8 *src, AVPixelFormat src_format, int src_width, int src_height, int src_pitch, int src_slice_h, bool bilinear)
+		{
+			std::unique_ptr<SwsContext, void(*)(SwsContext*)> sws(sws_getContext(src_width, src_height, src_format,
+				dst_width, dst_height, dst_format, bilinear ? SWS_FAST_BILINEAR : SWS_POINT, NULL, NULL, NULL), sws_freeContext);
+
+			sws_scale(sws.get(), &src, &src_pitch, 0, src_slice_h, &dst, &dst_pitch);
+		}
+	}
+
+	std::atomic<int> g_dynamic_resolution_scale_percent{ 0 };
+
+	bool dynamic_resolution_controller::update(u64 gpu_frame_time_us)
+	{
+		// Ignore stalls (loading screens, shader compilation) so they do not drag the average
+		if (gpu_frame_time_us > 500000)
+			return false;
+
+		m_gpu_frame_time = m_gpu_frame_time ? (m_gpu_frame_time * 7 + gpu_frame_time_us) / 8 : gpu_frame_time_us;
+
+		// Let the average settle on the new surfaces before judging them
+		if (++m_frames_since_change < 30)
+			return false;
+
+		const int max_scale = g_cfg.video.resolution_scale_percent;
+		const int min_scale = std::min<int>(g_cfg.video.minimum_resolution_scale_percent, max_scale);
+		const int current = get_resolution_scale_percent();
+		const u64 target = g_cfg.video.dynamic_resolution_target_frame_time;
+
+		int scale = current;
+
+		if (m_gpu_frame_time > target + target / 20)
+		{
+			// GPU time follows the pixel count, which goes with the square of the scale
+			scale = int(current * std::sqrt(f64(target) / m_gpu_frame_time));
+			scale -= scale % 5;
+		}
+		else if (m_gpu_frame_time < (target * 3) / 4)
+		{
+			// Step up slowly, a lower scale which holds the target beats oscillating around it
+			scale = current + 5;
+		}
+
+		scale = std::clamp(scale, min_scale, max_scale);
+		if (scale == current)
+			return false;
+
+		g_dynamic_resolution_scale_percent = (scale == max_scale) ? 0 : scale;
+		m_frames_since_change = 0;
+
+		LOG_NOTICE(RSX, "Dynamic resolution: scale %d%% -> %d%% (GPU frame time %lluus, target %lluus)", current, scale, m_gpu_frame_time, target);
+		return true;
+	}
+
+	bool dynamic_resolution_controller::reset()
+	{
+		m_gpu_frame_time = 0;
+		m_frames_since_change = 0;
+
+		return g_dynamic_resolution_scale_percent.exchange(0) != 0;
+	}
+
+	void parallel_for(u32 num_tasks, const std::function<void(u32)>& func)
+	{
+		thread_pool::parallel_for(num_tasks, func, thread_class::rsx, get_image_thread_count());
+	}
+
+	u32 get_parallel_thread_count()
+	{
+		return get_image_thread_count();
+	}
+
 	void convert_scale_image(u8 *dst, AVPixelFormat dst_format, int dst_width, int dst_height, int dst_pitch,
 		const u8 *src, AVPixelFormat src_format, int src_width, int src_height, int src_pitch, int src_slice_h, bool bilinear)
 	{
-		std::unique_ptr<SwsContext, void(*)(SwsContext*)> sws(sws_getContext(src_width, src_height, src_format,
-			dst_width, dst_height, dst_format, bilinear ? SWS_FAST_BILINEAR : SWS_POINT, NULL, NULL, NULL), sws_freeContext);
+		// Only point sampling can be split into bands without visible seams, and only if the whole source is provided
+		if (bilinear || src_slice_h != src_height || (dst_width * dst_height) < 0x10000)
+		{
+			convert_scale_image_band(dst, dst_format, dst_width, dst_height, dst_pitch,
+				src, src_format, src_width, src_height, src_pitch, src_slice_h, bilinear);
+			return;
+		}
+
+		// Band edges must land on rows where source and destination line up exactly
+		int units = src_height, other = dst_height;
+		while (other)
+		{
+			const int tmp = units % other;
+			units = other;
+			other = tmp;
+		}
+
+		const int dst_rows_per_unit = dst_height / units;
+		const int src_rows_per_unit = src_height / units;
+
+		const u32 num_bands = (u32)std::min({ (int)get_image_thread_count(), units, dst_height / 32 });
+
+		if (num_bands <= 1)
+		{
+			convert_scale_image_band(dst, dst_format, dst_width, dst_height, dst_pitch,
+				src, src_format, src_width, src_height, src_pitch, src_slice_h, false);
+			return;
+		}
+
+		const std::function<void(u32)> job = [&](u32 band)
+		{
+			const int first_unit = (units * band) / num_bands;
+			const int last_unit = (units * (band + 1)) / num_bands;
+			const int band_src_rows = (last_unit - first_unit) * src_rows_per_unit;
+
+			convert_scale_image_band(dst + first_unit * dst_rows_per_unit * dst_pitch, dst_format, dst_width, (last_unit - first_unit) * dst_rows_per_unit, dst_pitch,
+				src + first_unit * src_rows_per_unit * src_pitch, src_format, src_width, band_src_rows, src_pitch, band_src_rows, false);
+		};
 
-		sws_scale(sws.get(), &src, &src_pitch, 0, src_slice_h, &dst, &dst_pitch);
+		parallel_for(num_bands, job);
 	}
 
 	void convert_scale_image(std::unique_ptr<u8[]>& dst, AVPixelFormat dst_format, int dst_width, int dst_height, int dst_pitch,
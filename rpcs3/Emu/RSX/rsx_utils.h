@@ -448,6 +448,14 @@ namespace rsx
 	void convert_scale_image(std::unique_ptr<u8[]>& dst, AVPixelFormat dst_format, int dst_width, int dst_height, int dst_pitch,
 		const u8 *src, AVPixelFormat src_format, int src_width, int src_height, int src_pitch, int src_slice_h, bool bilinear);
 
+	/**
+	 * Runs func(0) .. func(num_tasks - 1) on a few threads of the shared thread pool, the calling thread helps. Returns once all tasks are done.
+	 */
+	void parallel_for(u32 num_tasks, const std::function<void(u32)>& func);
+
+	// Number of threads parallel_for spreads tasks over, including the caller
+	u32 get_parallel_thread_count();
+
 	void clip_image(u8 *dst, const u8 *src, int clip_x, int clip_y, int clip_w, int clip_h, int bpp, int src_pitch, int dst_pitch);
 	void clip_image(std::unique_ptr<u8[]>& dst, const u8 *src, int clip_x, int clip_y, int clip_w, int clip_h, int bpp, int src_pitch, int dst_pitch);
 
@@ -553,16 +561,45 @@ namespace rsx
 		return std::make_tuple(x, y, width, height);
 	}
 
-	static inline const f32 get_resolution_scale()
+	// Scale picked by dynamic resolution, 0 while the configured scale applies
+	extern std::atomic<int> g_dynamic_resolution_scale_percent;
+
+	static inline const int get_resolution_scale_percent()
 	{
-		return g_cfg.video.strict_rendering_mode? 1.f : ((f32)g_cfg.video.resolution_scale_percent / 100.f);
+		if (g_cfg.video.strict_rendering_mode)
+			return 100;
+
+		const int dynamic_scale = g_dynamic_resolution_scale_percent.load(std::memory_order_relaxed);
+		return dynamic_scale ? dynamic_scale : g_cfg.video.resolution_scale_percent;
 	}
 
-	static inline const int get_resolution_scale_percent()
+	static inline const f32 get_resolution_scale()
 	{
-		return g_cfg.video.strict_rendering_mode ? 100 : g_cfg.video.resolution_scale_percent;
+		return (f32)get_resolution_scale_percent() / 100.f;
 	}
 
+	/**
+	 * Moves the resolution scale between the configured minimum and the configured scale to hold the target GPU frame time.
+	 * Fed once per frame; the backend has to rebuild its surfaces whenever update() reports a new scale.
+	 */
+	class dynamic_resolution_controller
+	{
+		u64 m_gpu_frame_time = 0;
+		u32 m_frames_since_change = 0;
+
+	public:
+		// Returns true if the active scale changed
+		bool update(u64 gpu_frame_time_us);
+
+		// Drops back to the configured scale, returns true if that changed the active scale
+		bool reset();
+
+		u64 get_gpu_frame_time() const
+		{
+			return m_gpu_frame_time;
+		}
+	};
+
 	static inline const u16 apply_resolution_scale(u16 value, bool clamp)
 	{
 		if (value <= g_cfg.video.min_scalable_dimension)
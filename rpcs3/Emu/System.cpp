@@ -23,6 +23,10 @@
 
 #include "Utilities/StrUtil.h"
 #include "Utilities/sysinfo.h"
+#include "Utilities/tracing.h"
+#include "Utilities/Timer.h"
+#include "Utilities/CPUStats.h"
+#include "Utilities/perf_counters.h"
 
 #include "../Crypto/unself.h"
 #include "../Crypto/unpkg.h"
@@ -39,6 +43,7 @@
 #include "Utilities/GDBDebugServer.h"
 
 #include "Utilities/sysinfo.h"
+#include "Utilities/tracing.h"
 
 #if defined(_WIN32) || defined(HAVE_VULKAN)
 #include "Emu/RSX/VK/VulkanAPI.h"
@@ -61,6 +66,7 @@ extern void ppu_unload_prx(const lv2_prx&);
 extern std::shared_ptr<lv2_prx> ppu_load_prx(const ppu_prx_object&, const std::string&);
 
 extern void network_thread_init();
+extern void lv2_timer_thread_init();
 
 fs::file g_tty;
 atomic_t<s64> g_tty_size{0};
@@ -218,6 +224,7 @@ inline void fmt_class_string<detail_level>::format(std::string& out, u64 arg)
 		case detail_level::low: return "Low";
 		case detail_level::medium: return "Medium";
 		case detail_level::high: return "High";
+		case detail_level::extreme: return "Extreme";
 		}
 
 		return unknown;
@@ -257,6 +264,23 @@ void fmt_class_string<tsx_usage>::format(std::string& out, u64 arg)
 	});
 }
 
+template <>
+void fmt_class_string<llvm_opt_tier>::format(std::string& out, u64 arg)
+{
+	format_enum(out, arg, [](llvm_opt_tier value)
+	{
+		switch (value)
+		{
+		case llvm_opt_tier::fast: return "Fast";
+		case llvm_opt_tier::normal: return "Normal";
+		case llvm_opt_tier::full: return "Full";
+		case llvm_opt_tier::upgrade: return "Upgrade";
+		}
+
+		return unknown;
+	});
+}
+
 void Emulator::Init()
 {
 	if (!g_tty)
@@ -305,6 +329,9 @@ void Emulator::Init()
 	LOG_SUCCESS(GENERAL, "GDB debug server will be started and listening on %d upon emulator boot", (int) g_cfg.misc.gdb_server_port);
 #endif
 
+	// Serve the runtime counters for external dashboards
+	perf::start_server(static_cast<u16>(g_cfg.misc.perf_counters_port));
+
 	// Initialize patch engine
 	fxm::make_always<patch_engine>()->append(fs::get_config_dir() + "/patch.yml");
 
@@ -403,31 +430,28 @@ void Emulator::Init()
 	}
 }
 
-bool Emulator::BootRsxCapture(const std::string& path)
+bool Emulator::BootRsxCapture(const std::string& path, const rsx_benchmark_options& benchmark)
 {
 	if (!fs::is_file(path))
 		return false;
 
-	std::fstream f(path, std::ios::in | std::ios::binary);
-
-	cereal::BinaryInputArchive archive(f);
+	// Only the index is read here, memory block contents are loaded by the replay thread as needed
 	std::unique_ptr<rsx::frame_capture_data> frame = std::make_unique<rsx::frame_capture_data>();
-	archive(*frame);
 
-	if (frame->magic != rsx::FRAME_CAPTURE_MAGIC)
+	if (!frame->open_for_read(path))
 	{
 		LOG_ERROR(LOADER, "Invalid rsx capture file!");
 		return false;
 	}
 
-	if (frame->version != rsx::FRAME_CAPTURE_VERSION)
+	Init();
+
+	if (!benchmark.renderer.empty() && !g_cfg.video.renderer.from_string(benchmark.renderer))
 	{
-		LOG_ERROR(LOADER, "Rsx capture file version not supported! Expected %d, found %d", rsx::FRAME_CAPTURE_VERSION, frame->version);
+		LOG_ERROR(LOADER, "Unknown renderer '%s' requested for rsx capture benchmark", benchmark.renderer);
 		return false;
 	}
 
-	Init();
-
 	vm::init();
 
 	// PS3 'executable'
@@ -441,12 +465,503 @@ bool Emulator::BootRsxCapture(const std::string& path)
 	GetCallbacks().on_run();
 	m_state = system_state::running;
 
-	auto&& rsxcapture = idm::make_ptr<ppu_thread, rsx::rsx_replay_thread>(std::move(frame));
+	auto&& rsxcapture = idm::make_ptr<ppu_thread, rsx::rsx_replay_thread>(std::move(frame), benchmark);
 	rsxcapture->run();
 
 	return true;
 }
 
+struct boot_tuning
+{
+	struct param
+	{
+		const char* section;
+		const char* name;
+		cfg::_base* node;
+		std::vector<std::string> values;
+		std::string initial; // Value of the configs the tuning started with
+		std::string best;
+	};
+
+	std::string path;
+	boot_benchmark_options benchmark;
+	std::vector<param> params;
+
+	std::size_t pos = 0;  // Parameter varied by the current run
+	std::size_t value = 0;
+	bool warmup = true;   // The first run only fills the caches and isn't scored
+	bool baseline = true; // The second run measures the initial configs
+
+	f64 best_fps = 0.;
+	f64 best_cpu = 0.;
+	u32 runs = 0;
+	std::string results;
+
+	// Config overrides of the current run as YAML: the best values so far and the tried one
+	std::string get_overrides() const
+	{
+		std::map<std::string, std::string> sections;
+
+		for (std::size_t i = 0; i < params.size(); i++)
+		{
+			const std::string& value = !baseline && i == pos ? params[i].values[this->value] : params[i].best;
+
+			if (!value.empty())
+			{
+				fmt::append(sections[params[i].section], "  %s: %s\n", params[i].name, value);
+			}
+		}
+
+		std::string out;
+
+		for (const auto& section : sections)
+		{
+			fmt::append(out, "%s:\n%s", section.first, section.second);
+		}
+
+		return out;
+	}
+
+	// Move to the next value differing from the best one of its parameter, false after the last one
+	bool advance()
+	{
+		std::size_t p = baseline ? 0 : pos;
+		std::size_t v = baseline ? 0 : value + 1;
+		baseline = false;
+
+		for (; p < params.size(); p++, v = 0)
+		{
+			for (; v < params[p].values.size(); v++)
+			{
+				if (params[p].values[v] != params[p].best)
+				{
+					pos = p;
+					value = v;
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+};
+
+bool Emulator::BootTuning(const std::string& path, const boot_benchmark_options& benchmark)
+{
+	m_tuning = std::make_shared<boot_tuning>();
+	m_tuning->path = path;
+	m_tuning->benchmark = benchmark;
+	m_tuning->benchmark.frames = 0;
+	m_tuning->benchmark.seconds = std::max(benchmark.seconds, 10u);
+
+	// Settings tried one at a time, each keeping the best values of the previous ones
+	m_tuning->params =
+	{
+		{"Core", "SPU Block Size", &g_cfg.core.spu_block_size, {"safe", "mega", "giga"}},
+		{"Core", "Preferred SPU Threads", &g_cfg.core.preferred_spu_threads, {"0", "1", "2"}},
+		{"Core", "SPU loop detection", &g_cfg.core.spu_loop_detection, {"true", "false"}},
+		{"Core", "PPU Threads", &g_cfg.core.ppu_threads, {"1", "2"}},
+		{"Video", "Asynchronous Shader Compilation", &g_cfg.video.async_shader_compilation, {"false", "true"}},
+		{"Video", "Disable Vertex Cache", &g_cfg.video.disable_vertex_cache, {"false", "true"}},
+		{"Video", "Sleep On Empty FIFO", &g_cfg.video.fifo_idle_sleep, {"true", "false"}},
+	};
+
+	u32 runs = 2;
+	for (const auto& param : m_tuning->params)
+	{
+		runs += ::size32(param.values) - 1;
+	}
+
+	LOG_SUCCESS(GENERAL, "Tuning: up to %u runs of %u seconds", runs, m_tuning->benchmark.seconds);
+
+	if (!BootBenchmark(path, m_tuning->benchmark))
+	{
+		m_tuning.reset();
+		return false;
+	}
+
+	return true;
+}
+
+void Emulator::TuningNext(bool completed, f64 fps, f64 cpu_usage)
+{
+	auto& tuning = *m_tuning;
+	const std::string title_id = m_title_id;
+	const bool stopped = !completed && IsStopped();
+	const bool warmup = tuning.warmup;
+
+	if (warmup)
+	{
+		tuning.warmup = false;
+		LOG_NOTICE(GENERAL, "Tuning: warm-up run finished (%.2f fps)", fps);
+	}
+	else
+	{
+		const std::string overrides = tuning.get_overrides();
+		const char* name = tuning.baseline ? "initial config" : tuning.params[tuning.pos].name;
+		const std::string value = tuning.baseline ? "" : tuning.params[tuning.pos].values[tuning.value];
+
+		fmt::append(tuning.results, "%s\t\t{ \"setting\": \"%s\", \"value\": \"%s\", \"completed\": %s, \"fps\": %.2f, \"process_cpu_percent\": %.1f }",
+			tuning.runs++ ? ",\n" : "", name, value, completed ? "true" : "false", fps, cpu_usage);
+
+		LOG_NOTICE(GENERAL, "Tuning: %s %s: %.2f fps, %.1f%% CPU\n%s", name, value, fps, cpu_usage, overrides);
+
+		// Within 2% the run using less CPU time wins
+		if (completed && (tuning.baseline || fps > tuning.best_fps * 1.02 || (fps >= tuning.best_fps * 0.98 && cpu_usage < tuning.best_cpu)))
+		{
+			if (!tuning.baseline)
+			{
+				tuning.params[tuning.pos].best = value;
+			}
+
+			tuning.best_fps = std::max(tuning.best_fps, fps);
+			tuning.best_cpu = cpu_usage;
+		}
+		else if (tuning.baseline)
+		{
+			LOG_ERROR(GENERAL, "Tuning: the initial config didn't run to the end, nothing to compare with");
+			tuning.params.clear();
+		}
+	}
+
+	// Keep the emulator open between runs
+	SetForceBoot(true);
+	Stop();
+
+	// The warm-up run is followed by the baseline run with the same configs
+	if (!stopped && (warmup || tuning.advance()))
+	{
+		if (BootBenchmark(tuning.path, tuning.benchmark))
+		{
+			return;
+		}
+
+		LOG_ERROR(GENERAL, "Tuning: failed to boot %s", tuning.path);
+	}
+
+	Stop();
+
+	std::string changed;
+
+	for (const auto& param : tuning.params)
+	{
+		if (param.best != param.initial)
+		{
+			fmt::append(changed, "%s%s: %s", changed.empty() ? "" : ", ", param.name, param.best);
+		}
+	}
+
+	if (changed.empty())
+	{
+		LOG_SUCCESS(GENERAL, "Tuning: no setting made %s faster (%.2f fps)", title_id, tuning.best_fps);
+	}
+	else
+	{
+		// Saved as a complete custom config, the way the settings dialog saves them
+		const std::string dir = fs::get_config_dir() + "data/" + title_id;
+		const auto config = std::make_unique<cfg_root>();
+		config->from_string(fs::file(fs::get_config_dir() + "/config.yml", fs::read + fs::create).to_string());
+
+		if (fs::file custom{dir + "/config.yml"})
+		{
+			config->from_string(custom.to_string());
+		}
+
+		config->from_string(tuning.get_overrides());
+
+		if (fs::create_path(dir) && fs::write_file(dir + "/config.yml", fs::rewrite, config->to_string()))
+		{
+			LOG_SUCCESS(GENERAL, "Tuning: %s runs at %.2f fps with %s. Written to data/%s/config.yml", title_id, tuning.best_fps, changed, title_id);
+		}
+		else
+		{
+			LOG_ERROR(GENERAL, "Tuning: failed to write data/%s/config.yml (%s)", title_id, fs::g_tls_error);
+		}
+	}
+
+	const std::string results_path = tuning.benchmark.results_path.empty() ? fs::get_config_dir() + "tuning.json" : tuning.benchmark.results_path;
+
+	fs::write_file(results_path, fs::rewrite, fmt::format("{\n\t\"title_id\": \"%s\",\n\t\"seconds\": %u,\n\t\"best_fps\": %.2f,\n\t\"runs\": [\n%s\n\t]\n}\n",
+		title_id, tuning.benchmark.seconds, tuning.best_fps, tuning.results));
+
+	m_tuning.reset();
+	GetCallbacks().exit();
+}
+
+bool Emulator::BootBenchmark(const std::string& path, const boot_benchmark_options& benchmark)
+{
+	m_boot_benchmark = benchmark;
+	SetForceBoot(true);
+
+	const u64 start_time = get_system_time();
+	const u64 start_compiled[3] = {perf::ppu_objects_compiled.get(), perf::spu_functions_compiled.get(), perf::rsx_pipelines_compiled.get()};
+
+	if (!BootGame(path, true) || !IsRunning())
+	{
+		return false;
+	}
+
+	const u64 load_time = get_system_time() - start_time;
+
+	thread_ctrl::spawn("Boot Benchmark", [=]()
+	{
+		// Frame times are taken from the flip timestamps, several flips between two samples share their average
+		std::vector<u64> frame_times;
+		u64 first_frame_time = 0;
+		u64 flips = 0;
+		u64 last_flip = 0;
+
+		// Thread usage is sampled every second the way the performance overlay does it (both consume the same cycle counters)
+		CPUStats cpu_stats;
+		f64 usage[4]{};
+		u32 usage_samples = 0;
+		u64 next_sample = start_time + 1000000;
+
+		bool completed = false;
+
+		while (!Emu.IsStopped())
+		{
+			const u64 now = get_system_time();
+
+			if ((benchmark.frames && frame_times.size() >= benchmark.frames) || (benchmark.seconds && now - start_time >= benchmark.seconds * 1000000ull))
+			{
+				completed = flips != 0;
+				break;
+			}
+
+			if (const auto render = fxm::get<GSRender>())
+			{
+				const u64 count = render->performance_counters.flips;
+
+				if (count > flips)
+				{
+					const u64 timestamp = render->performance_counters.last_flip_timestamp;
+
+					if (!flips)
+					{
+						first_frame_time = timestamp - start_time;
+					}
+					else
+					{
+						frame_times.insert(frame_times.end(), count - flips, (timestamp - last_flip) / (count - flips));
+					}
+
+					flips = count;
+					last_flip = timestamp;
+				}
+
+				if (now >= next_sample)
+				{
+					u64 ppu_cycles = 0;
+					u64 spu_cycles = 0;
+
+					idm::select<ppu_thread>([&](u32, ppu_thread& ppu) { ppu_cycles += ppu.get()->get_cycles(); });
+					idm::select<SPUThread>([&](u32, SPUThread& spu) { spu_cycles += spu.get()->get_cycles(); });
+					idm::select<RawSPUThread>([&](u32, RawSPUThread& spu) { spu_cycles += spu.get()->get_cycles(); });
+
+					const u64 rsx_cycles = render->get()->get_cycles();
+					const u64 total_cycles = ppu_cycles + spu_cycles + rsx_cycles;
+					const f64 cpu_usage = cpu_stats.get_usage();
+
+					if (total_cycles && cpu_usage >= 0.)
+					{
+						usage[0] += cpu_usage;
+						usage[1] += cpu_usage * ppu_cycles / total_cycles;
+						usage[2] += cpu_usage * spu_cycles / total_cycles;
+						usage[3] += cpu_usage * rsx_cycles / total_cycles;
+						usage_samples++;
+					}
+
+					next_sample = now + 1000000;
+				}
+			}
+
+			std::this_thread::sleep_for(1ms);
+		}
+
+		if (benchmark.frames)
+		{
+			frame_times.resize(std::min<std::size_t>(frame_times.size(), benchmark.frames));
+		}
+
+		std::vector<u64> sorted = frame_times;
+		std::sort(sorted.begin(), sorted.end());
+
+		u64 total_time = 0;
+		for (const u64 time : sorted)
+		{
+			total_time += time;
+		}
+
+		// Nearest-rank percentile
+		const auto percentile = [&](u32 p) -> u64
+		{
+			return sorted.empty() ? 0 : sorted[std::max<std::size_t>((sorted.size() * p + 99) / 100, 1) - 1];
+		};
+
+		for (auto& value : usage)
+		{
+			value = usage_samples ? value / usage_samples : 0.;
+		}
+
+		std::string out = fmt::format("{\n\t\"title_id\": \"%s\",\n\t\"renderer\": \"%s\",\n\t\"completed\": %s,\n\t\"load_time_us\": %llu,\n\t\"first_frame_us\": %llu,\n",
+			Emu.GetTitleID(), g_cfg.video.renderer.get(), completed ? "true" : "false", load_time, first_frame_time);
+
+		const f64 fps = total_time ? sorted.size() * 1000000. / total_time : 0.;
+
+		if (Emu.m_tuning)
+		{
+			Emu.CallAfter([=]()
+			{
+				Emu.TuningNext(completed, fps, usage[0]);
+			});
+
+			return;
+		}
+
+		fmt::append(out, "\t\"frames\": %u,\n\t\"fps\": %.2f,\n", ::size32(sorted), fps);
+
+		fmt::append(out, "\t\"frame_time_us\": { \"min\": %llu, \"avg\": %llu, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"max\": %llu },\n",
+			sorted.empty() ? 0 : sorted.front(), sorted.empty() ? 0 : total_time / sorted.size(), percentile(50), percentile(90), percentile(99), sorted.empty() ? 0 : sorted.back());
+
+		fmt::append(out, "\t\"thread_usage_percent\": { \"process\": %.1f, \"ppu\": %.1f, \"spu\": %.1f, \"rsx\": %.1f },\n", usage[0], usage[1], usage[2], usage[3]);
+
+		fmt::append(out, "\t\"compiled\": { \"ppu_objects\": %llu, \"spu_functions\": %llu, \"rsx_pipelines\": %llu },\n",
+			perf::ppu_objects_compiled.get() - start_compiled[0], perf::spu_functions_compiled.get() - start_compiled[1], perf::rsx_pipelines_compiled.get() - start_compiled[2]);
+
+		out += "\t\"frame_times_us\": [";
+
+		for (std::size_t n = 0; n < frame_times.size(); n++)
+		{
+			fmt::append(out, "%s%llu", n ? ", " : "", frame_times[n]);
+		}
+
+		out += "]\n}\n";
+
+		const std::string results_path = benchmark.results_path.empty() ? fs::get_config_dir() + "boot_benchmark.json" : benchmark.results_path;
+
+		if (fs::file f{results_path, fs::rewrite})
+		{
+			f.write(out);
+			LOG_SUCCESS(GENERAL, "Boot benchmark: first frame after %llu us, %u frames measured. Results written to %s", first_frame_time, ::size32(frame_times), results_path);
+		}
+		else
+		{
+			LOG_ERROR(GENERAL, "Boot benchmark: failed to write results to %s (%s)", results_path, fs::g_tls_error);
+		}
+
+		if (!completed)
+		{
+			LOG_ERROR(GENERAL, "Boot benchmark: the emulator stopped after %u frames", ::size32(frame_times));
+		}
+
+		Emu.CallAfter([]()
+		{
+			Emu.Stop();
+			Emu.GetCallbacks().exit();
+		});
+	});
+
+	return true;
+}
+
+bool Emulator::BootPrecompile(std::vector<std::string> paths, bool exit_after)
+{
+	if (paths.empty())
+	{
+		// Same sources as the game list
+		const std::string hdd = GetHddDir();
+
+		for (const std::string& dir : {hdd + "game/", hdd + "disc/"})
+		{
+			for (auto&& entry : fs::dir(dir))
+			{
+				if (entry.is_directory && entry.name != "." && entry.name != "..")
+				{
+					paths.emplace_back(dir + entry.name);
+				}
+			}
+		}
+
+		for (auto&& pair : YAML::Load(fs::file{fs::get_config_dir() + "/games.yml", fs::read + fs::create}.to_string()))
+		{
+			paths.emplace_back(pair.second.Scalar());
+			paths.back().resize(paths.back().find_last_not_of('/') + 1);
+		}
+	}
+
+	if (paths.empty())
+	{
+		LOG_ERROR(GENERAL, "Precompilation: no titles found");
+		return false;
+	}
+
+	m_precompile_queue.clear();
+
+	// The executable first (main module and preloaded libraries, SPU cache), then the libraries loaded at run time
+	for (const std::string& path : paths)
+	{
+		m_precompile_queue.emplace_back(path, false);
+		m_precompile_queue.emplace_back(path, true);
+	}
+
+	LOG_SUCCESS(GENERAL, "Precompiling %u titles", paths.size());
+
+	m_precompile_pos = 0;
+	m_precompile_failed = 0;
+	m_precompile = true;
+	m_precompile_exit = exit_after;
+
+	PrecompileBoot();
+	return true;
+}
+
+void Emulator::PrecompileNext()
+{
+	m_precompile_stop = true;
+	Stop();
+	m_precompile_stop = false;
+
+	PrecompileBoot();
+}
+
+void Emulator::PrecompileBoot()
+{
+	while (m_precompile_pos < m_precompile_queue.size())
+	{
+		const auto& entry = m_precompile_queue[m_precompile_pos++];
+
+		LOG_SUCCESS(GENERAL, "Precompiling (%u/%u) %s: %s", (m_precompile_pos + 1) / 2, m_precompile_queue.size() / 2, entry.second ? "libraries" : "executable", entry.first);
+
+		SetForceBoot(true);
+
+		// A failing boot may stop the emulator by itself, which must not cancel the batch
+		m_precompile_stop = true;
+
+		if (BootGame(entry.first, entry.second) && IsRunning())
+		{
+			m_precompile_stop = false;
+			return;
+		}
+
+		LOG_ERROR(GENERAL, "Precompilation failed to boot %s", entry.first);
+		m_precompile_failed++;
+
+		Stop();
+		m_precompile_stop = false;
+	}
+
+	LOG_SUCCESS(GENERAL, "Precompilation finished: %u titles, %u failed boots", m_precompile_queue.size() / 2, m_precompile_failed);
+
+	m_precompile = false;
+	m_precompile_queue.clear();
+
+	if (m_precompile_exit)
+	{
+		GetCallbacks().exit();
+	}
+}
+
 bool Emulator::BootGame(const std::string& path, bool direct, bool add_only)
 {
 	static const char* boot_list[] =
@@ -550,6 +1065,16 @@ void Emulator::Load(bool add_only)
 	{
 		Init();
 
+		// Boot stage timings, logged to track boot time
+		Timer stage_timer;
+		stage_timer.Start();
+
+		const auto log_stage = [&](const char* stage)
+		{
+			LOG_NOTICE(LOADER, "Boot stage: %s in %.3f ms", stage, stage_timer.GetElapsedTimeInMilliSec());
+			stage_timer.Start();
+		};
+
 		// Load game list (maps ABCD12345 IDs to /dev_bdvd/ locations)
 		YAML::Node games = YAML::Load(fs::file{fs::get_config_dir() + "/games.yml", fs::read + fs::create}.to_string());
 
@@ -660,8 +1185,55 @@ void Emulator::Load(bool add_only)
 		}
 #endif
 
+		// Tuning candidate, the first run records the values of the custom configs
+		if (m_tuning)
+		{
+			for (auto& param : m_tuning->params)
+			{
+				if (param.initial.empty())
+				{
+					param.initial = param.node->to_string();
+					param.best = param.initial;
+				}
+			}
+
+			g_cfg.from_string(m_tuning->get_overrides());
+		}
+
+		// Boot benchmark overrides, applied after the custom configs
+		if (!m_boot_benchmark.renderer.empty() && !g_cfg.video.renderer.from_string(m_boot_benchmark.renderer))
+		{
+			LOG_ERROR(LOADER, "Unknown renderer '%s' requested for boot benchmark", m_boot_benchmark.renderer);
+		}
+
+		if (m_boot_benchmark.headless)
+		{
+			if (m_boot_benchmark.renderer.empty())
+			{
+				g_cfg.video.renderer.from_string(fmt::format("%s", video_renderer::null));
+			}
+
+			g_cfg.audio.renderer.from_string(fmt::format("%s", audio_renderer::null));
+		}
+
+		// Batch precompilation compiles everything before the title starts and never shows it
+		if (m_precompile)
+		{
+			g_cfg.core.ppu_decoder.from_default();
+			g_cfg.core.llvm_background.set(false);
+			g_cfg.video.renderer.from_string(fmt::format("%s", video_renderer::null));
+			g_cfg.audio.renderer.from_string(fmt::format("%s", audio_renderer::null));
+		}
+
 		LOG_NOTICE(LOADER, "Used configuration:\n%s\n", g_cfg.to_string());
 
+		lock_class::enable_stats(g_cfg.core.lock_stats.get());
+		tracing::set_enabled(g_cfg.core.event_trace.get());
+
+		// Apply log file settings
+		logs::set_deferred(g_cfg.misc.log_deferred.get());
+		logs::set_compression(g_cfg.misc.log_compression);
+
 		// Set RTM usage
 		g_use_rtm = utils::has_rtm() && ((utils::has_mpx() && g_cfg.core.enable_TSX == tsx_usage::enabled) || g_cfg.core.enable_TSX == tsx_usage::forced);
 		if (g_use_rtm && !utils::has_mpx())
@@ -669,10 +1241,17 @@ void Emulator::Load(bool add_only)
 			LOG_WARNING(GENERAL, "TSX forced by User");
 		}
 
+#ifdef LLVM_AVAILABLE
+		extern void jit_set_object_compression(bool);
+		jit_set_object_compression(g_cfg.core.llvm_compress_cache);
+#endif
+
 		// Load patches from different locations
 		fxm::check_unlocked<patch_engine>()->append(fs::get_config_dir() + "data/" + m_title_id + "/patch.yml");
 		fxm::check_unlocked<patch_engine>()->append(m_cache_path + "/patch.yml");
 
+		log_stage("configuration loaded");
+
 		// Mount all devices
 		const std::string emu_dir = GetEmuDir();
 		const std::string home_dir = g_cfg.vfs.app_home;
@@ -773,7 +1352,7 @@ void Emulator::Load(bool add_only)
 						src = decrypt_self(std::move(src));
 					}
 
-					const ppu_prx_object obj = src;
+					const ppu_prx_object obj = std::move(src);
 
 					if (obj == elf_error::ok)
 					{
@@ -819,6 +1398,11 @@ void Emulator::Load(bool add_only)
 				// Exit "process"
 				Emu.CallAfter([]
 				{
+					if (Emu.IsPrecompiling())
+					{
+						return Emu.PrecompileNext();
+					}
+
 					Emu.Stop();
 				});
 			});
@@ -1039,6 +1623,8 @@ void Emulator::Load(bool add_only)
 			vfs::mount("host_root", {});
 		}
 
+		log_stage("VFS mounted");
+
 		// Open SELF or ELF
 		std::string elf_path = m_path;
 
@@ -1087,16 +1673,19 @@ void Emulator::Load(bool add_only)
 			}
 		}
 
+		log_stage("executable decrypted");
+
 		ppu_exec_object ppu_exec;
 		ppu_prx_object ppu_prx;
 		spu_exec_object spu_exec;
 
+		// The stream is only taken by the object which accepts it, segments are then copied from it directly into the guest memory
 		if (!elf_file)
 		{
 			LOG_ERROR(LOADER, "Failed to decrypt SELF: %s", elf_path);
 			return;
 		}
-		else if (ppu_exec.open(elf_file) == elf_error::ok)
+		else if (ppu_exec.open(std::move(elf_file)) == elf_error::ok)
 		{
 			// PS3 executable
 			m_state = system_state::ready;
@@ -1144,8 +1733,9 @@ void Emulator::Load(bool add_only)
 
 			fxm::import<GSRender>(Emu.GetCallbacks().get_gs_render); // TODO: must be created in appropriate sys_rsx syscall
 			network_thread_init();
+			lv2_timer_thread_init();
 		}
-		else if (ppu_prx.open(elf_file) == elf_error::ok)
+		else if (ppu_prx.open(std::move(elf_file)) == elf_error::ok)
 		{
 			// PPU PRX (experimental)
 			m_state = system_state::ready;
@@ -1153,7 +1743,7 @@ void Emulator::Load(bool add_only)
 			vm::init();
 			ppu_load_prx(ppu_prx, m_path);
 		}
-		else if (spu_exec.open(elf_file) == elf_error::ok)
+		else if (spu_exec.open(std::move(elf_file)) == elf_error::ok)
 		{
 			// SPU executable (experimental)
 			m_state = system_state::ready;
@@ -1171,6 +1761,8 @@ void Emulator::Load(bool add_only)
 			return;
 		}
 
+		log_stage("executable loaded");
+
 		if ((m_force_boot || g_cfg.misc.autostart) && IsReady())
 		{
 			Run();
@@ -1328,10 +1920,23 @@ void Emulator::Stop(bool restart)
 		return;
 	}
 
-	const bool do_exit = !restart && !m_force_boot && g_cfg.misc.autoexit;
+	if (m_precompile && !m_precompile_stop)
+	{
+		// Stopped by the user: cancel the batch
+		LOG_WARNING(GENERAL, "Precompilation cancelled after %u of %u titles", m_precompile_pos / 2, m_precompile_queue.size() / 2);
+		m_precompile = false;
+		m_precompile_queue.clear();
+	}
+
+	const bool do_exit = !restart && !m_force_boot && (g_cfg.misc.autoexit || m_precompile_exit) && !m_precompile;
 
 	LOG_NOTICE(GENERAL, "Stopping emulator...");
 
+	if (g_cfg.core.lock_stats)
+	{
+		lock_class::report(m_cache_path.empty() ? "" : m_cache_path + "locks.log");
+	}
+
 	GetCallbacks().on_stop();
 
 #ifdef WITH_GDB_DEBUGGER
@@ -1367,6 +1972,23 @@ void Emulator::Stop(bool restart)
 
 	LOG_NOTICE(GENERAL, "All threads stopped...");
 
+	if (tracing::g_enabled)
+	{
+		tracing::set_enabled(false);
+
+		idm::select<ppu_thread>([](u32 id, ppu_thread& ppu)
+		{
+			tracing::set_guest_thread_name(id, ppu.get_name());
+		});
+
+		const std::string path = m_cache_path + "trace.json";
+
+		if (const u64 count = tracing::export_json(path))
+		{
+			LOG_SUCCESS(GENERAL, "Event trace: %llu events written to %s", count, path);
+		}
+	}
+
 	lv2_obj::cleanup();
 	idm::clear();
 	fxm::clear();
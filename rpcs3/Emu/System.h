@@ -153,6 +153,7 @@ enum class detail_level
 	low,
 	medium,
 	high,
+	extreme,
 };
 
 enum class screen_quadrant
@@ -170,9 +171,35 @@ enum class tsx_usage
 	forced,
 };
 
+enum class llvm_opt_tier
+{
+	fast, // Minimal passes, fast first boot
+	normal,
+	full, // All passes including vectorizers
+	upgrade, // Fast first, hot modules are recompiled with all passes in background
+};
+
 enum CellNetCtlState : s32;
 enum CellSysutilLang : s32;
 
+// Replays an RSX capture a fixed number of times and records its timings
+struct rsx_benchmark_options
+{
+	u32 iterations = 0;       // 0 replays the capture until the emulator is stopped
+	std::string renderer;     // Overrides the configured renderer when set
+	std::string results_path; // Timings are written here as JSON
+};
+
+// Boots an executable, runs it for a fixed number of frames and records the boot and frame timings
+struct boot_benchmark_options
+{
+	u32 frames = 0;           // Frames measured after the first one, 0 for no limit
+	u32 seconds = 0;          // Time measured after the first frame, 0 for no limit
+	bool headless = false;    // Null audio, and the Null renderer unless another one is set
+	std::string renderer;     // Overrides the configured renderer when set
+	std::string results_path; // Statistics are written here as JSON
+};
+
 struct EmuCallbacks
 {
 	std::function<void(std::function<void()>)> call_after;
@@ -212,6 +239,25 @@ class Emulator final
 
 	bool m_force_boot = false;
 
+	// Options of the running boot benchmark
+	boot_benchmark_options m_boot_benchmark;
+
+	// Batch precompilation state: titles to boot (path and directory scan flag), position and results
+	std::vector<std::pair<std::string, bool>> m_precompile_queue;
+	std::size_t m_precompile_pos = 0;
+	u32 m_precompile_failed = 0;
+	bool m_precompile = false;
+	bool m_precompile_exit = false;
+	bool m_precompile_stop = false; // Set while the batch stops a title itself
+
+	void PrecompileBoot();
+
+	// Per-title tuning state: candidate values, the value tried by the current run and the best scores (defined in System.cpp)
+	std::shared_ptr<struct boot_tuning> m_tuning;
+
+	// Score the finished run, then boot the next candidate or save the fastest config
+	void TuningNext(bool completed, f64 fps, f64 cpu_usage);
+
 public:
 	Emulator() = default;
 
@@ -283,7 +329,20 @@ public:
 	}
 
 	bool BootGame(const std::string& path, bool direct = false, bool add_only = false);
-	bool BootRsxCapture(const std::string& path);
+	bool BootRsxCapture(const std::string& path, const rsx_benchmark_options& benchmark = {});
+	bool BootBenchmark(const std::string& path, const boot_benchmark_options& benchmark);
+
+	// Run the boot benchmark once per candidate value of the main performance settings, one setting at a time,
+	// and write the fastest combination as the title's custom config (benchmark.seconds is the length of each run)
+	bool BootTuning(const std::string& path, const boot_benchmark_options& benchmark);
+
+	// Boot the titles one after another only to build their PPU and SPU caches (the whole game library if the list is empty)
+	bool BootPrecompile(std::vector<std::string> paths, bool exit_after);
+
+	// Stop the current title of the batch and boot the next one (called once its caches are built)
+	void PrecompileNext();
+
+	bool IsPrecompiling() const { return m_precompile; }
 	bool InstallPkg(const std::string& path);
 
 private:
@@ -325,23 +384,40 @@ struct cfg_root : cfg::node
 		cfg::_enum<ppu_decoder_type> ppu_decoder{this, "PPU Decoder", ppu_decoder_type::llvm};
 		cfg::_int<1, 16> ppu_threads{this, "PPU Threads", 2}; // Amount of PPU threads running simultaneously (must be 2)
 		cfg::_bool ppu_debug{this, "PPU Debug"};
+		cfg::_bool ppu_block_cache{this, "PPU Interpreter Block Cache", true}; // Run the interpreters from pre-decoded blocks (opcodes are read once)
+		cfg::_int<0, 10000> ppu_profiler{this, "PPU Profiler", 0}; // Sampling frequency in Hz (0: disabled)
 		cfg::_bool llvm_logs{this, "Save LLVM logs"};
 		cfg::string llvm_cpu{this, "Use LLVM CPU"};
 		cfg::_int<0, INT32_MAX> llvm_threads{this, "Max LLVM Compile Threads", 0};
+		cfg::_bool llvm_background{this, "PPU LLVM Background Compilation", false}; // Start on the interpreter while PPU modules are compiled
+		cfg::_enum<llvm_opt_tier> llvm_tier{this, "LLVM Optimization Tier", llvm_opt_tier::normal};
+		cfg::_bool llvm_compress_cache{this, "Compress LLVM Object Cache", false}; // Deflate newly written PPU/SPU objects (uncompressed objects are memory-mapped)
+		cfg::_bool self_cache{this, "Cache Decrypted SELF", false}; // Store decrypted EBOOT/SPRX images in the title cache (keyed by SHA-1 of the file and klic)
 		cfg::_bool thread_scheduler_enabled{this, "Enable thread scheduler", thread_scheduler_enabled_def};
+		cfg::_bool event_trace{this, "Event Trace", false}; // Record JIT, RSX, lv2 scheduling and file events, written as Chrome trace JSON on stop
+		cfg::_bool lock_stats{this, "Lock Contention Statistics", false}; // Count contended acquisitions of named locks, logged on stop
 		cfg::_bool set_daz_and_ftz{this, "Set DAZ and FTZ", false};
 		cfg::_enum<spu_decoder_type> spu_decoder{this, "SPU Decoder", spu_decoder_type::asmjit};
 		cfg::_bool lower_spu_priority{this, "Lower SPU thread priority"};
 		cfg::_bool spu_debug{this, "SPU Debug"};
 		cfg::_int<0, 6> preferred_spu_threads{this, "Preferred SPU Threads", 0}; //Numnber of hardware threads dedicated to heavy simultaneous spu tasks
 		cfg::_int<0, 16> spu_delay_penalty{this, "SPU delay penalty", 3}; //Number of milliseconds to block a thread if a virtual 'core' isn't free
+		cfg::_int<0, 16> spu_host_threads{this, "SPU Host Threads", 0}; // Number of SPU threads allowed to run simultaneously (0: unlimited)
 		cfg::_bool spu_loop_detection{this, "SPU loop detection", true}; //Try to detect wait loops and trigger thread yield
 		cfg::_bool spu_shared_runtime{this, "SPU Shared Runtime", true}; // Share compiled SPU functions between all threads
 		cfg::_enum<spu_block_size_type> spu_block_size{this, "SPU Block Size", spu_block_size_type::safe};
 		cfg::_bool spu_accurate_getllar{this, "Accurate GETLLAR", false};
 		cfg::_bool spu_accurate_putlluc{this, "Accurate PUTLLUC", false};
 		cfg::_bool spu_verification{this, "SPU Verification", true}; // Should be enabled
+		cfg::_bool spu_write_tracking{this, "SPU Write Tracking", false}; // Verify SPU code only after LS writes (requires SPU Verification)
 		cfg::_bool spu_cache{this, "SPU Cache", true};
+		cfg::_bool spu_global_cache{this, "SPU Global Cache", false}; // Share compiled SPU objects between titles (content-addressed)
+		cfg::_bool spu_tiered{this, "SPU Tiered Compilation", false}; // Start with ASMJIT, recompile hot functions with LLVM (requires shared runtime)
+		cfg::_int<1, INT32_MAX> spu_tier_threshold{this, "SPU Tier-up Threshold", 1000}; // Number of function executions before LLVM recompilation
+		cfg::_bool spu_profiler{this, "SPU Profiler", false}; // Count executions and cycles of each SPU function (report is written next to spu.log)
+		cfg::_bool reservation_stats{this, "Reservation Statistics", false}; // Count reservation contention per cache line (reported on stop)
+		cfg::_bool huge_pages{this, "Use Huge Pages", false}; // Back main/video memory and reservation tables with 2 MiB pages where the host allows it
+		cfg::_int<0, 3600> memory_log_interval{this, "Memory Usage Log Interval", 0}; // Seconds between host memory usage dumps to the log (0 = disabled)
 		cfg::_enum<tsx_usage> enable_TSX{this, "Enable TSX", tsx_usage::enabled}; // Enable TSX. Forcing this on Haswell/Broadwell CPUs should be used carefully
 
 		cfg::_enum<lib_loading_type> lib_loading{this, "Lib Loader", lib_loading_type::liblv2only};
@@ -399,14 +475,19 @@ struct cfg_root : cfg::node
 		cfg::_bool disable_zcull_queries{this, "Disable ZCull Occlusion Queries", false};
 		cfg::_bool disable_vertex_cache{this, "Disable Vertex Cache", false};
 		cfg::_bool disable_FIFO_reordering{this, "Disable FIFO Reordering", false};
+		cfg::_bool fifo_idle_sleep{this, "Sleep On Empty FIFO", true}; // Idle RSX thread waits for put updates instead of spinning
 		cfg::_bool frame_skip_enabled{this, "Enable Frame Skip", false};
 		cfg::_bool force_cpu_blit_processing{this, "Force CPU Blit", false}; // Debugging option
 		cfg::_bool disable_on_disk_shader_cache{this, "Disable On-Disk Shader Cache", false};
+		cfg::_bool async_shader_compilation{this, "Asynchronous Shader Compilation", false}; // Skip (Vulkan) or interpret (OpenGL) draws until their pipeline is built
 		cfg::_bool disable_vulkan_mem_allocator{ this, "Disable Vulkan Memory Allocator", false };
 		cfg::_bool full_rgb_range_output{this, "Use full RGB output range", true}; // Video out dynamic range
 		cfg::_int<1, 8> consequtive_frames_to_draw{this, "Consecutive Frames To Draw", 1};
 		cfg::_int<1, 8> consequtive_frames_to_skip{this, "Consecutive Frames To Skip", 1};
 		cfg::_int<50, 800> resolution_scale_percent{this, "Resolution Scale", 100};
+		cfg::_bool dynamic_resolution{this, "Dynamic Resolution", false}; // Lowers the resolution scale (Vulkan) while the GPU misses the target frame time
+		cfg::_int<50, 800> minimum_resolution_scale_percent{this, "Minimum Resolution Scale", 50};
+		cfg::_int<1000, 100000> dynamic_resolution_target_frame_time{this, "Dynamic Resolution Target Frame Time", 16666}; // GPU time per frame in microseconds
 		cfg::_int<0, 16> anisotropic_level_override{this, "Anisotropic Filter Override", 0};
 		cfg::_int<1, 1024> min_scalable_dimension{this, "Minimum Scalable Dimension", 16};
 		cfg::_int<0, 30000000> driver_recovery_timeout{this, "Driver Recovery Timeout", 1000000};
@@ -426,6 +507,12 @@ struct cfg_root : cfg::node
 			cfg::string adapter{this, "Adapter"};
 			cfg::_bool force_fifo{this, "Force FIFO present mode"};
 			cfg::_bool force_primitive_restart{this, "Force primitive restart flag"};
+			cfg::_bool multithreaded_recording{this, "Multithreaded Command Recording", false};
+			cfg::_bool async_transfer{this, "Asynchronous Transfer Queue", false};
+			cfg::_bool size_class_allocator{this, "Use Size Class Memory Allocator", false};
+			cfg::_bool frame_pacing{this, "Frame Pacing", false};
+			cfg::_bool low_latency{this, "Low Latency Presentation", false};
+			cfg::_bool import_local_memory{this, "Import Local Memory", false};
 
 		} vk{this};
 
@@ -441,6 +528,7 @@ struct cfg_root : cfg::node
 			cfg::string font{this, "Font", "n023055ms.ttf"};
 			cfg::_int<0, 500> margin{this, "Margin (px)", 50};
 			cfg::_int<0, 100> opacity{this, "Opacity (%)", 70};
+			cfg::_bool frame_timing_log{this, "Log frame timings", false};
 
 		} perf_overlay{this};
 
@@ -453,6 +541,7 @@ struct cfg_root : cfg::node
 		cfg::_enum<audio_renderer> renderer{this, "Renderer", static_cast<audio_renderer>(1)};
 
 		cfg::_bool dump_to_file{this, "Dump to file"};
+		cfg::_bool dump_to_flac{this, "Compress dump to FLAC"};
 		cfg::_bool convert_to_u16{this, "Convert to 16 bit"};
 		cfg::_bool downmix_to_2ch{this, "Downmix to Stereo", true};
 		cfg::_int<2, 128> frames{this, "Buffer Count", 32};
@@ -467,6 +556,7 @@ struct cfg_root : cfg::node
 		cfg::_enum<keyboard_handler> keyboard{this, "Keyboard", keyboard_handler::null};
 		cfg::_enum<mouse_handler> mouse{this, "Mouse", mouse_handler::basic};
 		cfg::_enum<pad_handler> pad{this, "Pad", pad_handler::keyboard};
+		cfg::_int<10, 1000> pad_poll_rate{this, "Pad polling rate", 1000}; // Handler polling frequency in Hz
 		cfg::_enum<camera_handler> camera{this, "Camera", camera_handler::null};
 		cfg::_enum<fake_camera_type> camera_type{this, "Camera type", fake_camera_type::unknown};
 		cfg::_enum<move_handler> move{this, "Move", move_handler::null};
@@ -502,6 +592,9 @@ struct cfg_root : cfg::node
 		cfg::_bool show_shader_compilation_hint{ this, "Show shader compilation hint", true };
 		cfg::_bool use_native_interface{ this, "Use native user interface", true };
 		cfg::_int<1, 65535> gdb_server_port{this, "Port", 2345};
+		cfg::_int<0, 65535> perf_counters_port{this, "Performance counters port", 0}; // Local HTTP port serving the runtime counters (0 = disabled), read at startup
+		cfg::_bool log_deferred{this, "Deferred log formatting", false}; // Format messages with plain arguments on the log writer thread
+		cfg::_int<0, 9> log_compression{this, "Log compression level", 6}; // zlib level of the compressed log file
 
 	} misc{this};
 
@@ -2,7 +2,8 @@
 #include "IdManager.h"
 #include "VFS.h"
 
-#include <regex>
+#include <list>
+#include <mutex>
 
 struct vfs_manager
 {
@@ -10,9 +11,15 @@ struct vfs_manager
 
 	// Device name -> Real path
 	std::unordered_map<std::string, std::string> mounted;
+
+	// Recently resolved paths (VFS path -> fs path), most recently used first; cleared on mount
+	std::mutex cache_mutex;
+	std::list<std::pair<std::string, std::string>> cache;
+	std::unordered_map<std::string, std::list<std::pair<std::string, std::string>>::iterator> cache_map;
 };
 
-const std::regex s_regex_ps3("^/+(.*?)(?:$|/)(.*)", std::regex::optimize);
+// Max number of cached path resolutions
+constexpr std::size_t s_vfs_cache_size = 4096;
 
 bool vfs::mount(const std::string& dev_name, const std::string& path)
 {
@@ -20,22 +27,25 @@ bool vfs::mount(const std::string& dev_name, const std::string& path)
 
 	safe_writer_lock lock(table->mutex);
 
-	return table->mounted.emplace(dev_name, path).second;
+	if (!table->mounted.emplace(dev_name, path).second)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> cache_lock(table->cache_mutex);
+	table->cache.clear();
+	table->cache_map.clear();
+	return true;
 }
 
-std::string vfs::get(const std::string& vpath, const std::string* prev, std::size_t pos)
+// Match the path against the mount table, one path component at a time (the first mounted prefix wins)
+static std::string vfs_resolve(const vfs_manager& table, const std::string& vpath)
 {
-	const auto table = fxm::get_always<vfs_manager>();
-
-	safe_reader_lock lock(table->mutex);
-
-	std::smatch match;
-
-	if (!std::regex_match(vpath.begin() + pos, vpath.end(), match, s_regex_ps3))
+	if (vpath.empty() || vpath[0] != '/')
 	{
-		const auto found = table->mounted.find("");
+		const auto found = table.mounted.find("");
 
-		if (found == table->mounted.end())
+		if (found == table.mounted.end())
 		{
 			LOG_WARNING(GENERAL, "vfs::get(): no default directory: %s", vpath);
 			return {};
@@ -44,44 +54,106 @@ std::string vfs::get(const std::string& vpath, const std::string* prev, std::siz
 		return found->second + vfs::escape(vpath);
 	}
 
-	if (match.length(1) + pos == 0)
-	{
-		return "/";
-	}
-
 	std::string dev;
 
-	if (prev)
+	for (std::size_t pos = 0;;)
 	{
-		dev += *prev;
-		dev += '/';
+		// Skip separators, the component ends at the next one
+		const std::size_t first = std::min(vpath.find_first_not_of('/', pos), vpath.size());
+		const std::size_t last = std::min(vpath.find_first_of('/', first), vpath.size());
+
+		if (pos == 0 && first == last)
+		{
+			return "/";
+		}
+
+		if (pos)
+		{
+			dev += '/';
+		}
+
+		dev.append(vpath, first, last - first);
+
+		const auto found = table.mounted.find(dev);
+
+		if (found == table.mounted.end())
+		{
+			if (last + 1 < vpath.size())
+			{
+				pos = last;
+				continue;
+			}
+
+			LOG_WARNING(GENERAL, "vfs::get(): device not found: %s", vpath);
+			return {};
+		}
+
+		const std::string rest = last < vpath.size() ? vpath.substr(last + 1) : std::string{};
+
+		if (found->second.empty())
+		{
+			// Don't escape /host_root (TODO)
+			return rest;
+		}
+
+		// Escape and concatenate
+		return found->second + vfs::escape(rest);
 	}
+}
 
-	dev += match.str(1);
+std::string vfs::get(const std::string& vpath)
+{
+	const auto table = fxm::get_always<vfs_manager>();
 
-	const auto found = table->mounted.find(dev);
+	safe_reader_lock lock(table->mutex);
 
-	if (found == table->mounted.end())
 	{
-		if (match.length(2))
+		std::lock_guard<std::mutex> cache_lock(table->cache_mutex);
+
+		const auto found = table->cache_map.find(vpath);
+
+		if (found != table->cache_map.end())
 		{
-			return vfs::get(vpath, &dev, pos + match.position(1) + match.length(1));
+			table->cache.splice(table->cache.begin(), table->cache, found->second);
+			return found->second->second;
 		}
-
-		LOG_WARNING(GENERAL, "vfs::get(): device not found: %s", vpath);
-		return {};
 	}
 
-	if (found->second.empty())
+	std::string result = vfs_resolve(*table, vpath);
+
+	// Failures are not cached so that they keep being reported
+	if (!result.empty())
 	{
-		// Don't escape /host_root (TODO)
-		return match.str(2);
+		std::lock_guard<std::mutex> cache_lock(table->cache_mutex);
+
+		if (!table->cache_map.count(vpath))
+		{
+			if (table->cache.size() >= s_vfs_cache_size)
+			{
+				table->cache_map.erase(table->cache.back().first);
+				table->cache.pop_back();
+			}
+
+			table->cache.emplace_front(vpath, result);
+			table->cache_map.emplace(vpath, table->cache.begin());
+		}
 	}
 
-	// Escape and concatenate
-	return found->second + vfs::escape(match.str(2));
+	return result;
 }
 
+bool vfs::is_read_only_data(const std::string& vpath)
+{
+	for (const char* prefix : {"/dev_bdvd/", "/app_home/", "/dev_hdd0/game/"})
+	{
+		if (vpath.compare(0, std::strlen(prefix), prefix) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
 
 std::string vfs::escape(const std::string& path)
 {
@@ -0,0 +1,176 @@
+#include "stdafx.h"
+#include "benchmark.h"
+#include "Emu/RSX/Common/BufferUtils.h"
+#include "Emu/RSX/Common/TextureUtils.h"
+#include "Emu/RSX/rsx_utils.h"
+#include "Emu/RSX/gcm_enums.h"
+#include "Crypto/aes.h"
+
+#include <chrono>
+
+namespace
+{
+	struct kernel_result
+	{
+		std::string name;
+		u64 bytes;      // Bytes read by one iteration
+		u32 iterations;
+		u64 min_ns;
+		u64 avg_ns;
+	};
+
+	// Runs the kernel once to warm up caches, then repeats it for about 200 ms (at least 5 times)
+	template <typename F>
+	kernel_result measure(std::string name, u64 bytes, F&& func)
+	{
+		using clock = std::chrono::steady_clock;
+
+		func();
+
+		u64 min_ns = UINT64_MAX;
+		u64 total_ns = 0;
+		u32 iterations = 0;
+
+		while (iterations < 5 || (total_ns < 200000000 && iterations < 100000))
+		{
+			const auto start = clock::now();
+			func();
+			const u64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+
+			min_ns = std::min(min_ns, ns);
+			total_ns += ns;
+			iterations++;
+		}
+
+		LOG_NOTICE(GENERAL, "Benchmark %s: %.3f us min, %.3f us avg (%u iterations)", name, min_ns / 1000., total_ns / 1000. / iterations, iterations);
+
+		return {std::move(name), bytes, iterations, min_ns, total_ns / iterations};
+	}
+
+	gsl::span<gsl::byte> as_dst(std::vector<u8>& data)
+	{
+		return {reinterpret_cast<gsl::byte*>(data.data()), ::narrow<int>(data.size())};
+	}
+
+	gsl::span<const gsl::byte> as_src(const std::vector<u8>& data, std::size_t size)
+	{
+		return {reinterpret_cast<const gsl::byte*>(data.data()), ::narrow<int>(size)};
+	}
+
+	// Deterministic data so that runs are comparable
+	std::vector<u8> make_data(std::size_t size)
+	{
+		std::vector<u8> data(size);
+		u32 seed = 0x12345678;
+
+		for (auto& byte : data)
+		{
+			seed = seed * 1103515245 + 12345;
+			byte = static_cast<u8>(seed >> 16);
+		}
+
+		return data;
+	}
+}
+
+bool run_kernel_benchmarks(const std::string& results_path)
+{
+	std::vector<kernel_result> results;
+
+	// Vertex streaming: packed float4 positions (straight copy with byte swap) and strided short4 attributes
+	{
+		constexpr u32 count = 0x10000;
+		const auto src = make_data(count * 32);
+		std::vector<u8> dst(count * 16);
+
+		results.emplace_back(measure("write_vertex_array_data_to_buffer/f32x4", count * 16, [&]()
+		{
+			write_vertex_array_data_to_buffer(as_dst(dst), as_src(src, count * 16), count, rsx::vertex_base_type::f, 4, 16, 16);
+		}));
+
+		results.emplace_back(measure("write_vertex_array_data_to_buffer/s1x4_strided", count * 8, [&]()
+		{
+			write_vertex_array_data_to_buffer(as_dst(dst), as_src(src, src.size()), count, rsx::vertex_base_type::s1, 4, 32, 8);
+		}));
+	}
+
+	// Texture swizzling and upload of a 1024x1024 ARGB8 texture, and of a DXT1 texture of the same size
+	{
+		constexpr u16 size = 1024;
+		auto src = make_data(size * size * 4);
+		std::vector<u8> dst(size * size * 4);
+
+		results.emplace_back(measure("convert_linear_swizzle/u32_deswizzle", size * size * 4, [&]()
+		{
+			rsx::convert_linear_swizzle<u32>(src.data(), dst.data(), size, size, size * 4, true);
+		}));
+
+		results.emplace_back(measure("convert_linear_swizzle/u32_swizzle", size * size * 4, [&]()
+		{
+			rsx::convert_linear_swizzle<u32>(src.data(), dst.data(), size, size, size * 4, false);
+		}));
+
+		const rsx_subresource_layout argb8{as_src(src, src.size()), size, size, 1, size};
+
+		results.emplace_back(measure("upload_texture_subresource/a8r8g8b8_linear", size * size * 4, [&]()
+		{
+			upload_texture_subresource(as_dst(dst), argb8, CELL_GCM_TEXTURE_A8R8G8B8, false, false, 256);
+		}));
+
+		results.emplace_back(measure("upload_texture_subresource/a8r8g8b8_swizzled", size * size * 4, [&]()
+		{
+			upload_texture_subresource(as_dst(dst), argb8, CELL_GCM_TEXTURE_A8R8G8B8, true, false, 256);
+		}));
+
+		// 4x4 blocks of 8 bytes, copied as they are
+		const rsx_subresource_layout dxt1{as_src(src, size * size / 2), size / 4, size / 4, 1, size / 4};
+
+		results.emplace_back(measure("upload_texture_subresource/dxt1_linear", size * size / 2, [&]()
+		{
+			upload_texture_subresource(as_dst(dst), dxt1, CELL_GCM_TEXTURE_COMPRESSED_DXT1, false, false, 256);
+		}));
+	}
+
+	// AES-CTR as used for NPDRM and PKG decryption
+	{
+		constexpr u32 size = 0x400000;
+		const auto src = make_data(size);
+		std::vector<u8> dst(size);
+
+		u8 key[16]{};
+		aes_context ctx;
+		aes_setkey_enc(&ctx, key, 128);
+
+		results.emplace_back(measure("aes_crypt_ctr", size, [&]()
+		{
+			u8 counter[16]{};
+			u8 stream_block[16]{};
+			size_t offset = 0;
+			aes_crypt_ctr(&ctx, size, &offset, counter, stream_block, src.data(), dst.data());
+		}));
+	}
+
+	std::string out = "{\n\t\"kernels\": [\n";
+
+	for (std::size_t i = 0; i < results.size(); i++)
+	{
+		const auto& result = results[i];
+
+		fmt::append(out, "\t\t{ \"name\": \"%s\", \"bytes\": %llu, \"iterations\": %u, \"min_ns\": %llu, \"avg_ns\": %llu, \"max_mb_per_s\": %.1f }%s\n",
+			result.name, result.bytes, result.iterations, result.min_ns, result.avg_ns, result.bytes * 1000. / std::max<u64>(result.min_ns, 1), i + 1 < results.size() ? "," : "");
+	}
+
+	out += "\t]\n}\n";
+
+	const std::string path = results_path.empty() ? fs::get_config_dir() + "kernel_benchmark.json" : results_path;
+
+	if (fs::file f{path, fs::rewrite})
+	{
+		f.write(out);
+		LOG_SUCCESS(GENERAL, "Kernel benchmarks: %u kernels measured. Results written to %s", results.size(), path);
+		return true;
+	}
+
+	LOG_ERROR(GENERAL, "Kernel benchmarks: failed to write results to %s (%s)", path, fs::g_tls_error);
+	return false;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <string>
+
+// Runs microbenchmarks of hot emulator kernels on synthetic data and writes the timings as JSON, returns false if nothing could be written
+bool run_kernel_benchmarks(const std::string& results_path);
@@ -101,6 +101,9 @@ struct elf_prog final : elf_phdr<en_t, sz_t>
 {
 	std::vector<uchar> bin;
 
+	// Data viewed in place in the source stream (elf_object opened from an owned stream)
+	fs::file_view view;
+
 	using base = elf_phdr<en_t, sz_t>;
 
 	elf_prog() = default;
@@ -113,10 +116,16 @@ struct elf_prog final : elf_phdr<en_t, sz_t>
 		base::p_vaddr = vaddr;
 		base::p_memsz = memsz;
 		base::p_align = align;
-		base::p_filesz = static_cast<sz_t>(bin.size());
+		base::p_filesz = static_cast<sz_t>(this->bin.size());
 		base::p_paddr = 0;
 		base::p_offset = -1;
 	}
+
+	// Program data (p_filesz bytes unless the object was opened with elf_opt::no_data)
+	const uchar* data() const
+	{
+		return view ? view.data() : bin.data();
+	}
 };
 
 template<template<typename T> class en_t, typename sz_t>
@@ -172,6 +181,9 @@ class elf_object
 {
 	elf_error m_error{};
 
+	// Source stream kept for the program data views
+	fs::file m_stream;
+
 	elf_error set_error(elf_error e)
 	{
 		return m_error = e;
@@ -196,8 +208,16 @@ public:
 		open(stream, offset, opts);
 	}
 
+	elf_object(fs::file&& stream, u64 offset = 0, bs_t<elf_opt> opts = {})
+	{
+		open(std::move(stream), offset, opts);
+	}
+
+	// Load the program data into memory (copied to prog.bin)
 	elf_error open(const fs::file& stream, u64 offset = 0, bs_t<elf_opt> opts = {})
 	{
+		m_stream.close();
+
 		// Check stream
 		if (!stream)
 			return set_error(elf_error::stream);
@@ -283,6 +303,34 @@ public:
 		return m_error = elf_error::ok;
 	}
 
+	// Keep the stream and view the program data in place (borrowed from in-memory files, memory-mapped
+	// from regular files, so pages which are never accessed aren't read). The stream is only taken on success.
+	elf_error open(fs::file&& stream, u64 offset = 0, bs_t<elf_opt> opts = {})
+	{
+		if (open(stream, offset, opts + elf_opt::no_data) != elf_error::ok)
+			return m_error;
+
+		if (!test(opts, elf_opt::no_data))
+		{
+			for (auto& prog : progs)
+			{
+				if (!prog.p_filesz)
+					continue;
+
+				prog.view = stream.map(offset + prog.p_offset, prog.p_filesz);
+
+				if (prog.view.size() != prog.p_filesz)
+				{
+					progs.clear();
+					return set_error(elf_error::stream_data);
+				}
+			}
+		}
+
+		m_stream = std::move(stream);
+		return m_error;
+	}
+
 	void save(const fs::file& stream) const
 	{
 		// Write header
@@ -325,7 +373,10 @@ public:
 		// Write data
 		for (const auto& prog : progs)
 		{
-			stream.write(prog.bin);
+			if (prog.view)
+				stream.write(prog.view.data(), prog.view.size());
+			else
+				stream.write(prog.bin);
 		}
 	}
 
@@ -1,6 +1,9 @@
 #include "stdafx.h"
 #include "PSF.h"
 
+#include <mutex>
+#include <unordered_map>
+
 template<>
 void fmt_class_string<psf::format>::format(std::string& out, u64 arg)
 {
@@ -288,4 +291,59 @@ namespace psf
 
 		return found->second.as_integer();
 	}
+	struct cache_entry
+	{
+		s64 mtime;
+		u64 size;
+		registry psf;
+	};
+
+	static std::mutex s_cache_mutex;
+	static std::unordered_map<std::string, cache_entry> s_cache;
+
+	registry load_cached(const std::string& path)
+	{
+		fs::stat_t info{};
+
+		if (!fs::stat(path, info) || info.is_directory)
+		{
+			std::lock_guard<std::mutex> lock(s_cache_mutex);
+			s_cache.erase(path);
+			return {};
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(s_cache_mutex);
+
+			const auto found = s_cache.find(path);
+
+			if (found != s_cache.end() && found->second.mtime == info.mtime && found->second.size == info.size)
+			{
+				return found->second.psf;
+			}
+		}
+
+		registry result = load_object(fs::file(path));
+
+		std::lock_guard<std::mutex> lock(s_cache_mutex);
+		s_cache[path] = {info.mtime, info.size, result};
+		return result;
+	}
+
+	void save_cached(const std::string& path, const registry& psf)
+	{
+		save_object(fs::file(path, fs::rewrite), psf);
+
+		fs::stat_t info{};
+		std::lock_guard<std::mutex> lock(s_cache_mutex);
+
+		if (fs::stat(path, info))
+		{
+			s_cache[path] = {info.mtime, info.size, psf};
+		}
+		else
+		{
+			s_cache.erase(path);
+		}
+	}
 }
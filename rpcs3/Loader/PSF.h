@@ -47,6 +47,12 @@ namespace psf
 	// Convert PSF registry to SFO binary format
 	void save_object(const fs::file&, const registry&);
 
+	// Load PSF registry from file, memoized until the file's size or modification time changes
+	registry load_cached(const std::string& path);
+
+	// Save PSF registry to file and update the memoized registry
+	void save_cached(const std::string& path, const registry&);
+
 	// Get string value or default value
 	std::string get_string(const registry& psf, const std::string& key, const std::string& def = {});
 
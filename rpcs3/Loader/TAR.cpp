@@ -112,14 +112,32 @@ bool tar_object::extract(std::string path, std::string ignore)
 		{
 		case '0':
 		{
+			// The file data directly follows its header
+			std::vector<u8> buf(octalToDecimal(atoi(header.size)));
+			m_file.read(buf, buf.size());
+
 			fs::file file(result, fs::rewrite);
-			file.write(get_file(header.name).to_vector<u8>());
+
+			if (!file)
+			{
+				// The parent directory may belong to another archive
+				fs::create_path(fs::get_parent_dir(result));
+				file.open(result, fs::rewrite);
+			}
+
+			if (!file)
+			{
+				LOG_ERROR(GENERAL, "TAR Loader: failed to create %s (%s)", result, fs::g_tls_error);
+				return false;
+			}
+
+			file.write(buf);
 			break;
 		}
 
 		case '5':
 		{
-			fs::create_dir(result);
+			fs::create_path(result);
 			break;
 		}
 
@@ -2,13 +2,14 @@
 #include "Emu/System.h"
 #include "TRP.h"
 #include "Crypto/sha1.h"
+#include "Utilities/Thread.h"
 
 TRPLoader::TRPLoader(const fs::file& f)
 	: trp_f(f)
 {
 }
 
-bool TRPLoader::Install(const std::string& dest, bool show)
+bool TRPLoader::Install(const std::string& dest, bool show, const std::function<bool(const TRPEntry&)>& filter) const
 {
 	if (!trp_f)
 	{
@@ -22,14 +23,44 @@ bool TRPLoader::Install(const std::string& dest, bool show)
 		return false;
 	}
 
-	std::vector<char> buffer(65536);
+	std::vector<const TRPEntry*> entries;
 
 	for (const TRPEntry& entry : m_entries)
 	{
-		trp_f.seek(entry.offset);
-		buffer.resize(entry.size);
-		if (!trp_f.read(buffer)) continue; // ???
-		fs::file(local_path + '/' + entry.name, fs::rewrite).write(buffer);
+		if (!filter || filter(entry))
+		{
+			entries.emplace_back(&entry);
+		}
+	}
+
+	const auto install = [&](u32 index)
+	{
+		const TRPEntry& entry = *entries[index];
+
+		std::vector<u8> buffer(entry.size);
+
+		if (trp_f.read_at(entry.offset, buffer.data(), buffer.size()) != buffer.size())
+		{
+			return; // ???
+		}
+
+		if (!fs::write_file(local_path + '/' + entry.name, fs::rewrite, buffer))
+		{
+			LOG_ERROR(LOADER, "TRP: failed to write %s (%s)", entry.name, fs::g_tls_error);
+		}
+	};
+
+	// Entries are small, the time is mostly spent creating the files
+	if (trp_f.is_positional())
+	{
+		thread_pool::parallel_for(::size32(entries), install);
+	}
+	else
+	{
+		for (u32 i = 0; i < entries.size(); i++)
+		{
+			install(i);
+		}
 	}
 
 	return true;
@@ -30,7 +30,8 @@ class TRPLoader final
 public:
 	TRPLoader(const fs::file& f);
 
-	bool Install(const std::string& dest, bool show = false);
+	// Write the entries to dest (only the entries accepted by the filter if it's set)
+	bool Install(const std::string& dest, bool show = false, const std::function<bool(const TRPEntry&)>& filter = nullptr) const;
 	bool LoadHeader(bool show = false);
 	u64 GetRequiredSpace() const;
 
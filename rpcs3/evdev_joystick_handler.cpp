@@ -12,6 +12,7 @@
 #include <algorithm>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <errno.h>
 #include <cstring>
 #include <cstdio>
@@ -661,6 +662,28 @@ int evdev_joystick_handler::add_device(const std::string& device, bool in_settin
 	return -1;
 }
 
+bool evdev_joystick_handler::WaitForEvents(u64 timeout)
+{
+	std::vector<pollfd> fds;
+
+	for (const auto& device : devices)
+	{
+		if (device.device != nullptr)
+		{
+			fds.push_back({ libevdev_get_fd(device.device), POLLIN, 0 });
+		}
+	}
+
+	if (fds.empty())
+	{
+		return false;
+	}
+
+	// Wake up on the first event from any device
+	poll(fds.data(), fds.size(), static_cast<int>((timeout + 999) / 1000));
+	return true;
+}
+
 void evdev_joystick_handler::ThreadProc()
 {
 	update_devs();
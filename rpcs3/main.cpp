@@ -7,8 +7,12 @@
 #include <QTimer>
 #include <QObject>
 
+#include <algorithm>
+#include <cstring>
+
 #include "rpcs3_app.h"
 #include "Utilities/sema.h"
+#include "Emu/benchmark.h"
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -91,6 +95,14 @@ int main(int argc, char** argv)
 		std::fprintf(stderr, "Failed to set max open file limit (4096).");
 #endif
 
+	// Headless runs don't need a display, game windows are created off screen (checked before the parser exists)
+	const bool headless = std::any_of(argv + 1, argv + argc, [](const char* arg) { return std::strcmp(arg, "--headless") == 0; });
+
+	if (headless && qgetenv("QT_QPA_PLATFORM").isEmpty())
+	{
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+
 	QCoreApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
 	QCoreApplication::setAttribute(Qt::AA_DisableWindowContextHelpButton);
 
@@ -104,13 +116,121 @@ int main(int argc, char** argv)
 	parser.addPositionalArgument("(S)ELF", "Path for directly executing a (S)ELF");
 	parser.addPositionalArgument("[Args...]", "Optional args for the executable");
 	parser.addHelpOption();
+
+	const QCommandLineOption rsx_benchmark_option("rsx-benchmark", "Replay the RSX capture given as path the specified number of times, write the timings and exit", "iterations");
+	const QCommandLineOption rsx_benchmark_renderer_option("rsx-benchmark-renderer", "Renderer used for --rsx-benchmark instead of the configured one", "renderer");
+	const QCommandLineOption rsx_benchmark_output_option("rsx-benchmark-output", "JSON file the --rsx-benchmark timings are written to", "path");
+	parser.addOption(rsx_benchmark_option);
+	parser.addOption(rsx_benchmark_renderer_option);
+	parser.addOption(rsx_benchmark_output_option);
+
+	const QCommandLineOption headless_option("headless", "Run without the main window or a display, for --benchmark, --tune, --benchmark-kernels and --precompile. Uses Null audio, and the Null renderer unless --benchmark-renderer is set");
+	const QCommandLineOption benchmark_option("benchmark", "Boot the (S)ELF given as path, run it for the specified number of frames, write the statistics and exit", "frames");
+	const QCommandLineOption benchmark_time_option("benchmark-time", "Stop --benchmark after the specified number of seconds since boot, even if not all frames were rendered", "seconds");
+	const QCommandLineOption tune_option("tune", "Boot the (S)ELF given as path once per candidate value of the main CPU and RSX performance settings, run it for the specified number of seconds each time and save the fastest settings as its custom config", "seconds");
+	const QCommandLineOption benchmark_renderer_option("benchmark-renderer", "Renderer used for --benchmark and --tune instead of the configured one, Null runs headless", "renderer");
+	const QCommandLineOption benchmark_kernels_option("benchmark-kernels", "Run the microbenchmarks of the emulator's hot kernels, write the timings and exit");
+	const QCommandLineOption benchmark_output_option("benchmark-output", "JSON file the --benchmark, --tune or --benchmark-kernels timings are written to", "path");
+	parser.addOption(headless_option);
+	parser.addOption(benchmark_option);
+	parser.addOption(benchmark_time_option);
+	parser.addOption(tune_option);
+	parser.addOption(benchmark_renderer_option);
+	parser.addOption(benchmark_kernels_option);
+	parser.addOption(benchmark_output_option);
+
+	const QCommandLineOption precompile_option("precompile", "Build the PPU and SPU caches of the titles given as paths, or of the whole game library if none is given, and exit");
+	parser.addOption(precompile_option);
 	parser.parse(QCoreApplication::arguments());
 
-	app.Init();
+	app.Init(headless);
 
 	QStringList args = parser.positionalArguments();
 
-	if (args.length() > 0)
+	if (parser.isSet(benchmark_kernels_option))
+	{
+		QTimer::singleShot(2, [path = sstr(parser.value(benchmark_output_option))]()
+		{
+			run_kernel_benchmarks(path);
+			Emu.GetCallbacks().exit();
+		});
+	}
+	else if ((parser.isSet(benchmark_option) || parser.isSet(benchmark_time_option)) && args.length() > 0)
+	{
+		boot_benchmark_options benchmark;
+		benchmark.seconds = parser.value(benchmark_time_option).toUInt();
+		benchmark.frames = benchmark.seconds ? parser.value(benchmark_option).toUInt() : std::max(1u, parser.value(benchmark_option).toUInt());
+		benchmark.headless = headless;
+		benchmark.renderer = sstr(parser.value(benchmark_renderer_option));
+		benchmark.results_path = sstr(parser.value(benchmark_output_option));
+
+		QTimer::singleShot(2, [path = sstr(QFileInfo(args.at(0)).canonicalFilePath()), benchmark = std::move(benchmark)]()
+		{
+			if (!Emu.BootBenchmark(path, benchmark))
+			{
+				LOG_FATAL(GENERAL, "Boot benchmark failed to boot %s", path);
+				Emu.GetCallbacks().exit();
+			}
+		});
+	}
+	else if (parser.isSet(tune_option) && args.length() > 0)
+	{
+		boot_benchmark_options benchmark;
+		benchmark.seconds = parser.value(tune_option).toUInt();
+		benchmark.headless = headless;
+		benchmark.renderer = sstr(parser.value(benchmark_renderer_option));
+		benchmark.results_path = sstr(parser.value(benchmark_output_option));
+
+		QTimer::singleShot(2, [path = sstr(QFileInfo(args.at(0)).canonicalFilePath()), benchmark = std::move(benchmark)]()
+		{
+			if (!Emu.BootTuning(path, benchmark))
+			{
+				LOG_FATAL(GENERAL, "Tuning failed to boot %s", path);
+				Emu.GetCallbacks().exit();
+			}
+		});
+	}
+	else if (parser.isSet(rsx_benchmark_option) && args.length() > 0)
+	{
+		rsx_benchmark_options benchmark;
+		benchmark.iterations = std::max(1u, parser.value(rsx_benchmark_option).toUInt());
+		benchmark.renderer = sstr(parser.value(rsx_benchmark_renderer_option));
+		benchmark.results_path = sstr(parser.value(rsx_benchmark_output_option));
+
+		QTimer::singleShot(2, [path = sstr(QFileInfo(args.at(0)).canonicalFilePath()), benchmark = std::move(benchmark)]()
+		{
+			Emu.SetForceBoot(true);
+
+			if (!Emu.BootRsxCapture(path, benchmark))
+			{
+				LOG_FATAL(GENERAL, "RSX capture benchmark failed to boot %s", path);
+				Emu.GetCallbacks().exit();
+			}
+		});
+	}
+	else if (parser.isSet(precompile_option))
+	{
+		std::vector<std::string> paths;
+
+		for (const QString& arg : args)
+		{
+			paths.emplace_back(sstr(QFileInfo(arg).canonicalFilePath()));
+		}
+
+		QTimer::singleShot(2, [paths = std::move(paths)]() mutable
+		{
+			if (!Emu.BootPrecompile(std::move(paths), true))
+			{
+				Emu.GetCallbacks().exit();
+			}
+		});
+	}
+	else if (headless)
+	{
+		LOG_FATAL(GENERAL, "--headless needs --benchmark, --benchmark-time, --tune, --benchmark-kernels, --rsx-benchmark or --precompile");
+		QTimer::singleShot(2, []() { Emu.GetCallbacks().exit(); });
+	}
+	else if (args.length() > 0)
 	{
 		// Propagate command line arguments
 		std::vector<std::string> argv;
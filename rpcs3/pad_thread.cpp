@@ -97,6 +97,17 @@ void pad_thread::Init(const u32 max_connect)
 		}
 	}
 
+	if (handlers.size() == 2)
+	{
+		for (const auto& handler : handlers)
+		{
+			if (handler.first != pad_handler::null)
+			{
+				m_event_handler = handler.second;
+			}
+		}
+	}
+
 	thread = std::make_shared<std::thread>(&pad_thread::ThreadFunc, this);
 }
 
@@ -124,6 +135,14 @@ void pad_thread::ThreadFunc()
 			connected += cur_pad_handler.second->connected;
 		}
 		m_info.now_connect = connected;
-		std::this_thread::sleep_for(1ms);
+
+		// Only hotplug has to be noticed while nothing is connected
+		const u64 interval = connected ? 1000000 / g_cfg.io.pad_poll_rate : 100000;
+
+		// Event based handlers still wake up at least every 10ms for rumble and disconnection updates
+		if (!connected || !m_event_handler || !m_event_handler->WaitForEvents(std::max<u64>(interval, 10000)))
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(interval));
+		}
 	}
 }
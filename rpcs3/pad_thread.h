@@ -37,6 +37,9 @@ protected:
 	PadInfo m_info;
 	std::vector<std::shared_ptr<Pad>> m_pads;
 
+	//Only non-null handler, if there is exactly one (can wait for its events instead of sleeping)
+	std::shared_ptr<PadHandlerBase> m_event_handler;
+
 	bool active;
 	std::shared_ptr<std::thread> thread;
 };
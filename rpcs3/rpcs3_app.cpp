@@ -67,7 +67,7 @@ rpcs3_app::rpcs3_app(int& argc, char** argv) : QApplication(argc, argv)
 {
 }
 
-void rpcs3_app::Init()
+void rpcs3_app::Init(bool headless)
 {
 	setApplicationName("RPCS3");
 	setWindowIcon(QIcon(":/rpcs3.ico"));
@@ -78,7 +78,10 @@ void rpcs3_app::Init()
 	emuSettings.reset(new emu_settings());
 
 	// Create the main window
-	RPCS3MainWin = new main_window(guiSettings, emuSettings, nullptr);
+	if (!headless)
+	{
+		RPCS3MainWin = new main_window(guiSettings, emuSettings, nullptr);
+	}
 
 	// Create callbacks from the emulator, which reference the handlers.
 	InitializeCallbacks();
@@ -86,9 +89,12 @@ void rpcs3_app::Init()
 	// Create connects to propagate events throughout Gui.
 	InitializeConnects();
 
-	RPCS3MainWin->Init();
+	if (RPCS3MainWin)
+	{
+		RPCS3MainWin->Init();
+	}
 
-	if (guiSettings->GetValue(gui::ib_show_welcome).toBool())
+	if (!headless && guiSettings->GetValue(gui::ib_show_welcome).toBool())
 	{
 		welcome_dialog* welcome = new welcome_dialog();
 		welcome->exec();
@@ -180,7 +186,8 @@ void rpcs3_app::InitializeCallbacks()
 		}
 
 		bool disableMouse = guiSettings->GetValue(gui::gs_disableMouse).toBool();
-		auto frame_geometry = gui::utils::create_centered_window_geometry(RPCS3MainWin->geometry(), w, h);
+		auto frame_geometry = RPCS3MainWin ? gui::utils::create_centered_window_geometry(RPCS3MainWin->geometry(), w, h) : QRect(0, 0, w, h);
+		const QIcon app_icon = RPCS3MainWin ? RPCS3MainWin->GetAppIcon() : windowIcon();
 
 		gs_frame* frame;
 
@@ -188,23 +195,23 @@ void rpcs3_app::InitializeCallbacks()
 		{
 		case video_renderer::null:
 		{
-			frame = new gs_frame("Null", frame_geometry, RPCS3MainWin->GetAppIcon(), disableMouse);
+			frame = new gs_frame("Null", frame_geometry, app_icon, disableMouse);
 			break;
 		}
 		case video_renderer::opengl:
 		{
-			frame = new gl_gs_frame(frame_geometry, RPCS3MainWin->GetAppIcon(), disableMouse);
+			frame = new gl_gs_frame(frame_geometry, app_icon, disableMouse);
 			break;
 		}
 		case video_renderer::vulkan:
 		{
-			frame = new gs_frame("Vulkan", frame_geometry, RPCS3MainWin->GetAppIcon(), disableMouse);
+			frame = new gs_frame("Vulkan", frame_geometry, app_icon, disableMouse);
 			break;
 		}
 #ifdef _MSC_VER
 		case video_renderer::dx12:
 		{
-			frame = new gs_frame("DirectX 12", frame_geometry, RPCS3MainWin->GetAppIcon(), disableMouse);
+			frame = new gs_frame("DirectX 12", frame_geometry, app_icon, disableMouse);
 			break;
 		}
 #endif
@@ -254,7 +261,7 @@ void rpcs3_app::InitializeCallbacks()
 
 	callbacks.get_msg_dialog = [=]() -> std::shared_ptr<MsgDialogBase>
 	{
-		return std::make_shared<msg_dialog_frame>(RPCS3MainWin->windowHandle());
+		return std::make_shared<msg_dialog_frame>(RPCS3MainWin ? RPCS3MainWin->windowHandle() : nullptr);
 	};
 
 	callbacks.get_save_dialog = [=]() -> std::unique_ptr<SaveDialogBase>
@@ -303,11 +310,16 @@ void rpcs3_app::InitializeCallbacks()
  */
 void rpcs3_app::InitializeConnects()
 {
-	connect(RPCS3MainWin, &main_window::RequestGlobalStylesheetChange, this, &rpcs3_app::OnChangeStyleSheetRequest);
-
 	qRegisterMetaType <std::function<void()>>("std::function<void()>");
 	connect(this, &rpcs3_app::RequestCallAfter, this, &rpcs3_app::HandleCallAfter);
 
+	if (!RPCS3MainWin)
+	{
+		return;
+	}
+
+	connect(RPCS3MainWin, &main_window::RequestGlobalStylesheetChange, this, &rpcs3_app::OnChangeStyleSheetRequest);
+
 	connect(this, &rpcs3_app::OnEmulatorRun, RPCS3MainWin, &main_window::OnEmuRun);
 	connect(this, &rpcs3_app::OnEmulatorStop, RPCS3MainWin, &main_window::OnEmuStop);
 	connect(this, &rpcs3_app::OnEmulatorPause, RPCS3MainWin, &main_window::OnEmuPause);
@@ -32,8 +32,9 @@ class rpcs3_app : public QApplication
 public:
 	rpcs3_app(int& argc, char** argv);
 	/** Call this method before calling app.exec
+	* Headless mode skips the main window and dialogs, for command line benchmark runs
 	*/
-	void Init();
+	void Init(bool headless = false);
 Q_SIGNALS:
 	void OnEmulatorRun();
 	void OnEmulatorPause();
@@ -48,7 +49,7 @@ private:
 	void InitializeCallbacks();
 	void InitializeConnects();
 
-	main_window* RPCS3MainWin;
+	main_window* RPCS3MainWin = nullptr;
 
 	std::shared_ptr<gui_settings> guiSettings;
 	std::shared_ptr<emu_settings> emuSettings;
@@ -1,16 +1,57 @@
 #include "debugger_list.h"
 
 #include "Emu/Cell/SPUThread.h"
+#include "Emu/Cell/PPUDisAsm.h"
+#include "Emu/Cell/SPUDisAsm.h"
 #include "Emu/System.h"
+#include "Utilities/Thread.h"
 
 #include <QApplication>
 #include <QMouseEvent>
 #include <QWheelEvent>
 
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 
 constexpr auto qstr = QString::fromStdString;
 
+// Disassembled lines of one thread keyed by address. A line is only reused while the opcode at its address is unchanged, so patches and memory writes invalidate it.
+struct debugger_list_cache
+{
+	struct line
+	{
+		u32 opcode;
+		u32 size;
+		QString text;
+	};
+
+	// Number of lines kept before the cache is flushed
+	static constexpr std::size_t max_lines = 0x40000;
+
+	// Distance in bytes disassembled ahead of the view on both sides
+	static constexpr u32 prefetch_size = 0x2000;
+
+	std::mutex mutex;
+	std::unordered_map<u32, line> lines;
+
+	atomic_t<bool> prefetching{false};
+
+	// Region covered by the last prefetch (only used by the GUI thread)
+	u32 prefetch_begin = 0;
+	u32 prefetch_end = 0;
+
+	void insert(u32 pc, line&& data)
+	{
+		if (lines.size() >= max_lines)
+		{
+			lines.clear();
+		}
+
+		lines[pc] = std::move(data);
+	}
+};
+
 debugger_list::debugger_list(QWidget* parent, std::shared_ptr<gui_settings> settings, breakpoint_handler* handler) : QListWidget(parent), m_breakpoint_handler(handler),
 	xgui_settings(settings), m_pc(0), m_item_count(30)
 {
@@ -26,6 +67,9 @@ void debugger_list::UpdateCPUData(std::weak_ptr<cpu_thread> cpu, std::shared_ptr
 {
 	this->cpu = cpu;
 	m_disasm = disasm;
+
+	// A running prefetch keeps filling the cache of the previous thread
+	m_cache = std::make_shared<debugger_list_cache>();
 }
 
 u32 debugger_list::GetPc() const
@@ -45,6 +89,92 @@ u32 debugger_list::GetCenteredAddress(u32 address) const
 	return address - ((m_item_count / 2) * 4);
 }
 
+u32 debugger_list::Disassemble(u32 pc, u32 cpu_offset, QString& text)
+{
+	const u32 opcode = vm::read32(cpu_offset + pc);
+
+	std::lock_guard<std::mutex> lock(m_cache->mutex);
+
+	const auto found = m_cache->lines.find(pc);
+
+	if (found != m_cache->lines.end() && found->second.opcode == opcode)
+	{
+		text = found->second.text;
+		return found->second.size;
+	}
+
+	const u32 size = m_disasm->disasm(m_disasm->dump_pc = pc);
+	text = qstr(m_disasm->last_opcode);
+	m_cache->insert(pc, {opcode, size, text});
+	return size;
+}
+
+void debugger_list::Prefetch(u32 begin, u32 end, u32 cpu_offset, u32 address_limits, bool is_spu)
+{
+	const auto cache = m_cache;
+
+	if (cache->prefetching || (begin >= cache->prefetch_begin && end <= cache->prefetch_end && cache->prefetch_begin < cache->prefetch_end))
+	{
+		return;
+	}
+
+	// Stay inside the address space (the view itself may wrap around, which is simply not prefetched)
+	const u32 size = debugger_list_cache::prefetch_size;
+	begin = begin > size ? (begin - size) & ~3 : 0;
+	end = static_cast<u32>(std::min<u64>(u64{end} + size, address_limits & ~3u));
+
+	if (begin >= end)
+	{
+		return;
+	}
+
+	cache->prefetch_begin = begin;
+	cache->prefetch_end = end;
+	cache->prefetching = true;
+
+	thread_pool::push([cache, begin, end, cpu_offset, is_spu]()
+	{
+		// The disassembler of the view isn't thread safe, use one of the same kind
+		std::unique_ptr<CPUDisAsm> disasm;
+
+		if (is_spu)
+		{
+			disasm = std::make_unique<SPUDisAsm>(CPUDisAsm_InterpreterMode);
+		}
+		else
+		{
+			disasm = std::make_unique<PPUDisAsm>(CPUDisAsm_InterpreterMode);
+		}
+
+		disasm->offset = static_cast<u8*>(vm::base(cpu_offset));
+
+		std::vector<std::pair<u32, debugger_list_cache::line>> lines;
+
+		for (u64 pc = begin; pc < end; pc += 4)
+		{
+			if (!vm::check_addr(cpu_offset + static_cast<u32>(pc), 4))
+			{
+				continue;
+			}
+
+			const u32 opcode = vm::read32(cpu_offset + static_cast<u32>(pc));
+			const u32 size = disasm->disasm(disasm->dump_pc = static_cast<u32>(pc));
+			lines.emplace_back(static_cast<u32>(pc), debugger_list_cache::line{opcode, size, qstr(disasm->last_opcode)});
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(cache->mutex);
+
+			for (auto& line : lines)
+			{
+				cache->insert(line.first, std::move(line.second));
+			}
+		}
+
+		cache->prefetching = false;
+	}, thread_class::general);
+}
+
 void debugger_list::ShowAddress(u32 addr)
 {
 	auto IsBreakpoint = [this](u32 pc)
@@ -77,6 +207,14 @@ void debugger_list::ShowAddress(u32 addr)
 		const u32 address_limits = is_spu ? 0x3ffff : ~0;
 		m_pc &= address_limits;
 		m_disasm->offset = (u8*)vm::base(cpu_offset);
+
+		if (!m_cache)
+		{
+			m_cache = std::make_shared<debugger_list_cache>();
+		}
+
+		const u32 start_pc = m_pc;
+
 		for (uint i = 0, count = 4; i<m_item_count; ++i, m_pc = (m_pc + count) & address_limits)
 		{
 			if (!vm::check_addr(cpu_offset + m_pc, 4))
@@ -86,9 +224,10 @@ void debugger_list::ShowAddress(u32 addr)
 				continue;
 			}
 
-			count = m_disasm->disasm(m_disasm->dump_pc = m_pc);
+			QString text;
+			count = Disassemble(m_pc, cpu_offset, text);
 
-			item(i)->setText((IsBreakpoint(m_pc) ? ">>> " : "    ") + qstr(m_disasm->last_opcode));
+			item(i)->setText((IsBreakpoint(m_pc) ? ">>> " : "    ") + text);
 
 			if (test(cpu->state & cpu_state_pause) && m_pc == GetPc())
 			{
@@ -106,6 +245,12 @@ void debugger_list::ShowAddress(u32 addr)
 				item(i)->setBackgroundColor(palette().color(backgroundRole()));
 			}
 		}
+
+		// Disassemble ahead so that scrolling hits the cache
+		if (start_pc <= m_pc)
+		{
+			Prefetch(start_pc, m_pc, cpu_offset, address_limits, is_spu);
+		}
 	}
 
 	setLineWidth(-1);
@@ -8,6 +8,8 @@
 
 #include <QListWidget>
 
+struct debugger_list_cache;
+
 class debugger_list : public QListWidget
 {
 	Q_OBJECT
@@ -40,9 +42,16 @@ private:
 	u32 GetPc() const;
 	u32 GetCenteredAddress(u32 address) const;
 
+	/** Disassembles the line at pc (reusing the cached text if the opcode is unchanged), returns the instruction size */
+	u32 Disassemble(u32 pc, u32 cpu_offset, QString& text);
+
+	/** Disassembles the region around [begin, end) in the background if it isn't cached yet */
+	void Prefetch(u32 begin, u32 end, u32 cpu_offset, u32 address_limits, bool is_spu);
+
 	std::shared_ptr<gui_settings> xgui_settings;
 
 	breakpoint_handler* m_breakpoint_handler;
 	std::weak_ptr<cpu_thread> cpu;
 	std::shared_ptr<CPUDisAsm> m_disasm;
+	std::shared_ptr<debugger_list_cache> m_cache;
 };
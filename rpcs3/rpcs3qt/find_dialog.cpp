@@ -3,6 +3,16 @@
 #include <QVBoxLayout>
 
 find_dialog::find_dialog(QTextEdit* edit, QWidget *parent, Qt::WindowFlags f) : QDialog(parent, f), m_text_edit(edit)
+{
+	init();
+}
+
+find_dialog::find_dialog(QListView* view, QWidget *parent, Qt::WindowFlags f) : QDialog(parent, f), m_list_view(view)
+{
+	init();
+}
+
+void find_dialog::init()
 {
 	setWindowTitle(tr("Find string"));
 
@@ -45,17 +55,61 @@ find_dialog::~find_dialog()
 {
 }
 
+int find_dialog::find_row(int from, bool backward) const
+{
+	const QAbstractItemModel* model = m_list_view->model();
+
+	for (int row = from; row >= 0 && row < model->rowCount(); backward ? row-- : row++)
+	{
+		if (model->index(row, 0).data().toString().contains(m_find_bar->text(), Qt::CaseInsensitive))
+		{
+			return row;
+		}
+	}
+
+	return -1;
+}
+
+void find_dialog::select_row(int row)
+{
+	if (row < 0)
+	{
+		return;
+	}
+
+	const QModelIndex index = m_list_view->model()->index(row, 0);
+	m_list_view->setCurrentIndex(index);
+	m_list_view->scrollTo(index);
+}
+
 int find_dialog::count_all()
 {
 	m_count_lines = 0;
 	m_count_total = 0;
 
-	if (!m_text_edit || m_find_bar->text().isEmpty())
+	if ((!m_text_edit && !m_list_view) || m_find_bar->text().isEmpty())
 	{
 		show_count();
 		return 0;
 	}
 
+	if (m_list_view)
+	{
+		const QAbstractItemModel* model = m_list_view->model();
+
+		for (int row = 0; row < model->rowCount(); row++)
+		{
+			if (const int count = model->index(row, 0).data().toString().count(m_find_bar->text(), Qt::CaseInsensitive))
+			{
+				m_count_lines++;
+				m_count_total += count;
+			}
+		}
+
+		show_count();
+		return m_count_total;
+	}
+
 	QTextCursor old_cursor = m_text_edit->textCursor();
 	m_text_edit->moveCursor(QTextCursor::Start);
 
@@ -84,6 +138,9 @@ void find_dialog::find_first()
 	if (count_all() <= 0)
 		return;
 
+	if (m_list_view)
+		return select_row(find_row(0, false));
+
 	m_text_edit->moveCursor(QTextCursor::Start);
 	m_text_edit->find(m_find_bar->text());
 }
@@ -93,6 +150,9 @@ void find_dialog::find_last()
 	if (count_all() <= 0)
 		return;
 
+	if (m_list_view)
+		return select_row(find_row(m_list_view->model()->rowCount() - 1, true));
+
 	m_text_edit->moveCursor(QTextCursor::End);
 	m_text_edit->find(m_find_bar->text(), QTextDocument::FindBackward);
 }
@@ -102,6 +162,9 @@ void find_dialog::find_next()
 	if (count_all() <= 0)
 		return;
 
+	if (m_list_view)
+		return select_row(find_row(m_list_view->currentIndex().row() + 1, false));
+
 	m_text_edit->find(m_find_bar->text());
 }
 
@@ -110,6 +173,9 @@ void find_dialog::find_previous()
 	if (count_all() <= 0)
 		return;
 
+	if (m_list_view)
+		return select_row(find_row((m_list_view->currentIndex().isValid() ? m_list_view->currentIndex().row() : m_list_view->model()->rowCount()) - 1, true));
+
 	m_text_edit->find(m_find_bar->text(), QTextDocument::FindBackward);
 }
 
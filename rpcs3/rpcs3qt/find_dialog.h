@@ -2,6 +2,7 @@
 
 #include <QDialog>
 #include <QTextEdit>
+#include <QListView>
 #include <QLineEdit>
 #include <QPushButton>
 #include <QLabel>
@@ -10,14 +11,22 @@ class find_dialog : public QDialog
 {
 public:
 	find_dialog(QTextEdit* edit, QWidget *parent = Q_NULLPTR, Qt::WindowFlags f = Qt::WindowFlags());
+	find_dialog(QListView* view, QWidget *parent = Q_NULLPTR, Qt::WindowFlags f = Qt::WindowFlags());
 	~find_dialog();
 
 private:
+	void init();
+
+	/** Searches the rows of the list view starting at the given row, returns -1 if nothing was found */
+	int find_row(int from, bool backward) const;
+	void select_row(int row);
+
 	int m_count_lines = 0;
 	int m_count_total = 0;
 	QLabel* m_label_count_lines;
 	QLabel* m_label_count_total;
-	QTextEdit* m_text_edit;
+	QTextEdit* m_text_edit = nullptr;
+	QListView* m_list_view = nullptr;
 	QLineEdit* m_find_bar;
 	QPushButton* m_find_first;
 	QPushButton* m_find_last;
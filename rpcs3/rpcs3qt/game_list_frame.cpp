@@ -8,11 +8,15 @@
 #include "Emu/System.h"
 #include "Loader/PSF.h"
 #include "Utilities/types.h"
+#include "Utilities/Thread.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <set>
+#include <unordered_map>
 
 #include <QDesktopServices>
 #include <QHeaderView>
@@ -26,6 +30,352 @@
 
 inline std::string sstr(const QString& _in) { return _in.toStdString(); }
 
+// Game directory scanned by a worker thread
+struct game_list_scan_result
+{
+	atomic_t<bool> done{false};
+	bool valid = false;
+	u64 sfo_size = 0;
+	s64 sfo_mtime = 0;
+	u64 icon_size = 0;
+	s64 icon_mtime = 0;
+	std::string sfo_category;
+	GameInfo info;
+	QImage icon;
+	QImage thumbnail;
+	bool hasCustomConfig = false;
+};
+
+// State shared by the GUI thread and the scan job of a game list refresh
+struct game_list_scan
+{
+	std::vector<std::string> paths;
+	std::vector<game_list_scan_result> games;
+	QSize icon_size;
+	atomic_t<bool> cancel{false};
+
+	// Only used by the GUI thread: results are taken in path order, so duplicates resolve the same way as in a serial scan
+	std::size_t next = 0;
+	bool scroll_after = true;
+	std::map<std::string, std::set<std::string>> serial_cat;
+	QSet<QString> serials;
+};
+
+namespace
+{
+	// Persistent game list cache: parsed PARAM.SFO and the scaled icon of every game directory, invalid once PARAM.SFO or ICON0.PNG changes size or mtime
+	struct game_list_cache_entry
+	{
+		u64 sfo_size;
+		s64 sfo_mtime;
+		u64 icon_size;
+		s64 icon_mtime;
+		std::string sfo_category;
+		GameInfo info;
+		QImage thumbnail;
+	};
+
+	constexpr u32 s_cache_magic = "RGLC"_u32;
+	constexpr u32 s_cache_version = 1;
+
+	std::mutex s_cache_mutex;
+
+	std::string get_cache_path()
+	{
+		return fs::get_config_dir() + "GuiConfigs/game_list.bin";
+	}
+
+	// Sequential reader of the cache file, any out-of-bounds access invalidates the whole file
+	struct cache_reader
+	{
+		const std::string& data;
+		std::size_t pos = 0;
+		bool ok = true;
+
+		template <typename T>
+		T read()
+		{
+			T result{};
+
+			if (ok && data.size() - pos >= sizeof(T))
+			{
+				std::memcpy(&result, data.data() + pos, sizeof(T));
+				pos += sizeof(T);
+			}
+			else
+			{
+				ok = false;
+			}
+
+			return result;
+		}
+
+		std::string read_string()
+		{
+			const u32 size = read<u32>();
+
+			if (!ok || data.size() - pos < size)
+			{
+				ok = false;
+				return {};
+			}
+
+			pos += size;
+			return data.substr(pos - size, size);
+		}
+	};
+
+	template <typename T>
+	void cache_write(std::string& out, const T& value)
+	{
+		out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	void cache_write(std::string& out, const std::string& str)
+	{
+		cache_write(out, ::narrow<u32>(str.size()));
+		out += str;
+	}
+
+	std::unordered_map<std::string, game_list_cache_entry> load_cache()
+	{
+		std::unordered_map<std::string, game_list_cache_entry> result;
+
+		std::string data;
+		{
+			std::lock_guard<std::mutex> lock(s_cache_mutex);
+
+			if (fs::file file{get_cache_path()})
+			{
+				data = file.to_string();
+			}
+		}
+
+		cache_reader reader{data};
+
+		if (reader.read<u32>() != s_cache_magic || reader.read<u32>() != s_cache_version)
+		{
+			return result;
+		}
+
+		for (u32 i = 0, count = reader.read<u32>(); reader.ok && i < count; i++)
+		{
+			const std::string path = reader.read_string();
+
+			game_list_cache_entry entry;
+			entry.sfo_size          = reader.read<u64>();
+			entry.sfo_mtime         = reader.read<s64>();
+			entry.icon_size         = reader.read<u64>();
+			entry.icon_mtime        = reader.read<s64>();
+			entry.sfo_category      = reader.read_string();
+			entry.info.path         = path;
+			entry.info.icon_path    = reader.read_string();
+			entry.info.name         = reader.read_string();
+			entry.info.serial       = reader.read_string();
+			entry.info.app_ver      = reader.read_string();
+			entry.info.category     = reader.read_string();
+			entry.info.fw           = reader.read_string();
+			entry.info.attr         = reader.read<u32>();
+			entry.info.bootable     = reader.read<u32>();
+			entry.info.parental_lvl = reader.read<u32>();
+			entry.info.sound_format = reader.read<u32>();
+			entry.info.resolution   = reader.read<u32>();
+
+			const u32 width = reader.read<u32>();
+			const u32 height = reader.read<u32>();
+
+			if (!reader.ok || width > 0x1000 || height > 0x1000 || (data.size() - reader.pos) / 4 < u64{width} * height)
+			{
+				return {};
+			}
+
+			if (width && height)
+			{
+				entry.thumbnail = QImage(width, height, QImage::Format_ARGB32);
+
+				for (u32 y = 0; y < height; y++)
+				{
+					std::memcpy(entry.thumbnail.scanLine(y), data.data() + reader.pos, width * 4);
+					reader.pos += width * 4;
+				}
+			}
+
+			result.emplace(path, std::move(entry));
+		}
+
+		if (!reader.ok)
+		{
+			return {};
+		}
+
+		return result;
+	}
+
+	void save_cache(const std::vector<game_list_scan_result>& games)
+	{
+		std::string out;
+		cache_write(out, s_cache_magic);
+		cache_write(out, s_cache_version);
+		cache_write(out, u32{0});
+
+		u32 count = 0;
+
+		for (const auto& game : games)
+		{
+			if (!game.valid)
+			{
+				continue;
+			}
+
+			cache_write(out, game.info.path);
+			cache_write(out, game.sfo_size);
+			cache_write(out, game.sfo_mtime);
+			cache_write(out, game.icon_size);
+			cache_write(out, game.icon_mtime);
+			cache_write(out, game.sfo_category);
+			cache_write(out, game.info.icon_path);
+			cache_write(out, game.info.name);
+			cache_write(out, game.info.serial);
+			cache_write(out, game.info.app_ver);
+			cache_write(out, game.info.category);
+			cache_write(out, game.info.fw);
+			cache_write(out, game.info.attr);
+			cache_write(out, game.info.bootable);
+			cache_write(out, game.info.parental_lvl);
+			cache_write(out, game.info.sound_format);
+			cache_write(out, game.info.resolution);
+			cache_write(out, ::narrow<u32>(game.thumbnail.width()));
+			cache_write(out, ::narrow<u32>(game.thumbnail.height()));
+
+			for (int y = 0; y < game.thumbnail.height(); y++)
+			{
+				out.append(reinterpret_cast<const char*>(game.thumbnail.constScanLine(y)), game.thumbnail.width() * 4);
+			}
+
+			count++;
+		}
+
+		std::memcpy(&out[8], &count, sizeof(count));
+
+		std::lock_guard<std::mutex> lock(s_cache_mutex);
+
+		if (!fs::write_file(get_cache_path(), fs::rewrite, out))
+		{
+			LOG_ERROR(GENERAL, "Failed to write the game list cache %s (%s)", get_cache_path(), fs::g_tls_error);
+		}
+	}
+
+	// Check if the thumbnail is already scaled to the icon size
+	bool thumbnail_fits(const QImage& thumbnail, const QSize& size)
+	{
+		return !thumbnail.isNull() && thumbnail.size() == thumbnail.size().scaled(size, Qt::KeepAspectRatio);
+	}
+
+	QImage scale_icon(const QImage& icon, const QSize& size)
+	{
+		return icon.scaled(size, Qt::KeepAspectRatio, Qt::TransformationMode::SmoothTransformation).convertToFormat(QImage::Format_ARGB32);
+	}
+
+	void scan_game(game_list_scan_result& result, const std::string& dir, const QSize& icon_size, const std::unordered_map<std::string, game_list_cache_entry>& cache)
+	{
+		const std::string sfb = dir + "/PS3_DISC.SFB";
+		const std::string sfo = dir + (fs::is_file(sfb) ? "/PS3_GAME/PARAM.SFO" : "/PARAM.SFO");
+
+		fs::stat_t sfo_stat;
+
+		if (!fs::stat(sfo, sfo_stat) || sfo_stat.is_directory)
+		{
+			return;
+		}
+
+		result.sfo_size = sfo_stat.size;
+		result.sfo_mtime = sfo_stat.mtime;
+
+		auto& game = result.info;
+
+		const auto found = cache.find(dir);
+		const game_list_cache_entry* cached = found != cache.end() && found->second.sfo_size == sfo_stat.size && found->second.sfo_mtime == sfo_stat.mtime ? &found->second : nullptr;
+
+		if (cached)
+		{
+			game = cached->info;
+			result.sfo_category = cached->sfo_category;
+		}
+		else
+		{
+			const auto psf = psf::load_cached(sfo);
+
+			game.path         = dir;
+			game.serial       = psf::get_string(psf, "TITLE_ID", "");
+			game.name         = psf::get_string(psf, "TITLE", sstr(category::unknown));
+			game.app_ver      = psf::get_string(psf, "APP_VER", sstr(category::unknown));
+			game.category     = psf::get_string(psf, "CATEGORY", sstr(category::unknown));
+			game.fw           = psf::get_string(psf, "PS3_SYSTEM_VER", sstr(category::unknown));
+			game.parental_lvl = psf::get_integer(psf, "PARENTAL_LEVEL");
+			game.resolution   = psf::get_integer(psf, "RESOLUTION");
+			game.sound_format = psf::get_integer(psf, "SOUND_FORMAT");
+			game.bootable     = psf::get_integer(psf, "BOOTABLE", 0);
+			game.attr         = psf::get_integer(psf, "ATTRIBUTE", 0);
+
+			result.sfo_category = game.category;
+
+			auto cat = category::cat_boot.find(game.category);
+			if (cat != category::cat_boot.end())
+			{
+				if (game.category == "DG")
+				{
+					game.icon_path = dir + "/PS3_GAME/ICON0.PNG";
+				}
+				else
+				{
+					game.icon_path = dir + "/ICON0.PNG";
+				}
+
+				game.category = sstr(cat->second);
+			}
+			else if ((cat = category::cat_data.find(game.category)) != category::cat_data.end())
+			{
+				game.icon_path = dir + "/ICON0.PNG";
+				game.category = sstr(cat->second);
+			}
+			else if (game.category == sstr(category::unknown))
+			{
+				game.icon_path = dir + "/ICON0.PNG";
+			}
+			else
+			{
+				game.icon_path = dir + "/ICON0.PNG";
+				game.category = sstr(category::other);
+			}
+		}
+
+		fs::stat_t icon_stat{};
+
+		if (fs::stat(game.icon_path, icon_stat))
+		{
+			result.icon_size = icon_stat.size;
+			result.icon_mtime = icon_stat.mtime;
+		}
+
+		// Only decode the icon if the cached thumbnail is outdated or has another size
+		if (cached && cached->icon_size == result.icon_size && cached->icon_mtime == result.icon_mtime && (thumbnail_fits(cached->thumbnail, icon_size) || !result.icon_size))
+		{
+			result.thumbnail = cached->thumbnail;
+		}
+		else if (game.icon_path.empty() || !result.icon.load(qstr(game.icon_path)))
+		{
+			LOG_WARNING(GENERAL, "Could not load image from path %s", sstr(QDir(qstr(game.icon_path)).absolutePath()));
+		}
+		else
+		{
+			result.thumbnail = scale_icon(result.icon, icon_size);
+		}
+
+		result.hasCustomConfig = fs::is_file(fs::get_config_dir() + "data/" + game.serial + "/config.yml");
+		result.valid = true;
+	}
+}
+
 game_list_frame::game_list_frame(std::shared_ptr<gui_settings> guiSettings, std::shared_ptr<emu_settings> emuSettings, QWidget *parent)
 	: custom_dock_widget(tr("Game List"), parent), m_gui_settings(guiSettings), m_emu_settings(emuSettings)
 {
@@ -76,6 +426,10 @@ game_list_frame::game_list_frame(std::shared_ptr<gui_settings> guiSettings, std:
 
 	m_game_compat = std::make_unique<game_compatibility>(m_gui_settings);
 
+	m_scan_timer = new QTimer(this);
+	m_scan_timer->setInterval(100);
+	connect(m_scan_timer, &QTimer::timeout, this, &game_list_frame::UpdateScan);
+
 	m_Central_Widget = new QStackedWidget(this);
 	m_Central_Widget->addWidget(m_gameList);
 	m_Central_Widget->addWidget(m_xgrid);
@@ -204,6 +558,11 @@ void game_list_frame::LoadSettings()
 
 game_list_frame::~game_list_frame()
 {
+	if (m_scan)
+	{
+		m_scan->cancel = true;
+	}
+
 	SaveSettings();
 }
 
@@ -228,9 +587,9 @@ void game_list_frame::FixNarrowColumns()
 
 void game_list_frame::ResizeColumnsToContents(int spacing)
 {
-	if (!m_gameList)
-	{
-		return;
+	if (!m_gameList)
+	{
+		return;
 	}
 
 	m_gameList->verticalHeader()->resizeSections(QHeaderView::ResizeMode::ResizeToContents);
@@ -239,9 +598,9 @@ void game_list_frame::ResizeColumnsToContents(int spacing)
 	// Make non-icon columns slighty bigger for better visuals
 	for (int i = 1; i < m_gameList->columnCount(); i++)
 	{
-		if (m_gameList->isColumnHidden(i))
-		{
-			continue;
+		if (m_gameList->isColumnHidden(i))
+		{
+			continue;
 		}
 
 		int size = m_gameList->horizontalHeader()->sectionSize(i) + spacing;
@@ -292,42 +651,42 @@ void game_list_frame::SortGameList()
 	int old_row_count = m_gameList->rowCount();
 	int old_game_count = m_game_data.count();
 
-	for (int i = 0; i < m_gameList->columnCount(); i++)
-	{
-		column_widths.append(m_gameList->columnWidth(i));
+	for (int i = 0; i < m_gameList->columnCount(); i++)
+	{
+		column_widths.append(m_gameList->columnWidth(i));
 	}
 
 	// Sorting resizes hidden columns, so unhide them as a workaround
 	QList<int> columns_to_hide;
 
-	for (int i = 0; i < m_gameList->columnCount(); i++)
-	{
-		if (m_gameList->isColumnHidden(i))
-		{
-			m_gameList->setColumnHidden(i, false);
-			columns_to_hide << i;
-		}
+	for (int i = 0; i < m_gameList->columnCount(); i++)
+	{
+		if (m_gameList->isColumnHidden(i))
+		{
+			m_gameList->setColumnHidden(i, false);
+			columns_to_hide << i;
+		}
 	}
 
 	// Sort the list by column and sort order
 	m_gameList->sortByColumn(m_sortColumn, m_colSortOrder);
 
 	// Hide columns again
-	for (auto i : columns_to_hide)
-	{
-		m_gameList->setColumnHidden(i, true);
+	for (auto i : columns_to_hide)
+	{
+		m_gameList->setColumnHidden(i, true);
 	}
 
 	// Don't resize the columns if no game is shown to preserve the header settings
-	if (!m_gameList->rowCount())
-	{
-		for (int i = 0; i < m_gameList->columnCount(); i++)
-		{
-			m_gameList->setColumnWidth(i, column_widths[i]);
+	if (!m_gameList->rowCount())
+	{
+		for (int i = 0; i < m_gameList->columnCount(); i++)
+		{
+			m_gameList->setColumnWidth(i, column_widths[i]);
 		}
 
-		m_gameList->horizontalHeader()->setSectionResizeMode(gui::column_icon, QHeaderView::Fixed);
-		return;
+		m_gameList->horizontalHeader()->setSectionResizeMode(gui::column_icon, QHeaderView::Fixed);
+		return;
 	}
 
 	// Fixate vertical header and row height
@@ -336,13 +695,13 @@ void game_list_frame::SortGameList()
 	m_gameList->resizeRowsToContents();
 
 	// Resize columns if the game list was empty before
-	if (!old_row_count && !old_game_count)
-	{
-		ResizeColumnsToContents();
+	if (!old_row_count && !old_game_count)
+	{
+		ResizeColumnsToContents();
 	}
-	else
-	{
-		m_gameList->resizeColumnToContents(gui::column_icon);
+	else
+	{
+		m_gameList->resizeColumnToContents(gui::column_icon);
 	}
 
 	// Fixate icon column
@@ -356,11 +715,6 @@ void game_list_frame::Refresh(const bool fromDrive, const bool scrollAfter)
 {
 	if (fromDrive)
 	{
-		// Load PSF
-
-		m_game_data.clear();
-		m_notes.clear();
-
 		const std::string _hdd = Emu.GetHddDir();
 
 		std::vector<std::string> path_list;
@@ -385,108 +739,49 @@ void game_list_frame::Refresh(const bool fromDrive, const bool scrollAfter)
 			path_list.back().resize(path_list.back().find_last_not_of('/') + 1);
 		}
 
-		// Used to remove duplications from the list (serial -> set of cats)
-		std::map<std::string, std::set<std::string>> serial_cat;
-
-		QSet<QString> serials;
-
-		for (const auto& dir : path_list) { try
+		// Cancel the previous scan, its remaining results are discarded
+		if (m_scan)
 		{
-			const std::string sfb = dir + "/PS3_DISC.SFB";
-			const std::string sfo = dir + (fs::is_file(sfb) ? "/PS3_GAME/PARAM.SFO" : "/PARAM.SFO");
-
-			const fs::file sfo_file(sfo);
-			if (!sfo_file)
-			{
-				continue;
-			}
-
-			const auto psf = psf::load_object(sfo_file);
-
-			GameInfo game;
-			game.path         = dir;
-			game.serial       = psf::get_string(psf, "TITLE_ID", "");
-			game.name         = psf::get_string(psf, "TITLE", sstr(category::unknown));
-			game.app_ver      = psf::get_string(psf, "APP_VER", sstr(category::unknown));
-			game.category     = psf::get_string(psf, "CATEGORY", sstr(category::unknown));
-			game.fw           = psf::get_string(psf, "PS3_SYSTEM_VER", sstr(category::unknown));
-			game.parental_lvl = psf::get_integer(psf, "PARENTAL_LEVEL");
-			game.resolution   = psf::get_integer(psf, "RESOLUTION");
-			game.sound_format = psf::get_integer(psf, "SOUND_FORMAT");
-			game.bootable     = psf::get_integer(psf, "BOOTABLE", 0);
-			game.attr         = psf::get_integer(psf, "ATTRIBUTE", 0);
+			m_scan->cancel = true;
+		}
 
-			// Detect duplication
-			if (!serial_cat[game.serial].emplace(game.category).second)
-			{
-				continue;
-			}
+		// Scan the directories on the thread pool, the results are added to the list by UpdateScan as they become ready
+		const auto scan = std::make_shared<game_list_scan>();
+		scan->games = std::vector<game_list_scan_result>(path_list.size());
+		scan->paths = std::move(path_list);
+		scan->icon_size = m_Icon_Size;
+		scan->scroll_after = scrollAfter;
+		m_scan = scan;
 
-			QString serial = qstr(game.serial);
-			m_notes[serial] = m_gui_settings->GetValue(gui::notes, serial, "").toString();
-			serials.insert(serial);
+		thread_pool::push([scan]()
+		{
+			const auto cache = load_cache();
 
-			auto cat = category::cat_boot.find(game.category);
-			if (cat != category::cat_boot.end())
+			thread_pool::parallel_for(::size32(scan->games), [&](u32 i)
 			{
-				if (game.category == "DG")
+				try
 				{
-					game.icon_path = dir + "/PS3_GAME/ICON0.PNG";
+					if (!scan->cancel)
+					{
+						scan_game(scan->games[i], scan->paths[i], scan->icon_size, cache);
+					}
 				}
-				else
+				catch (const std::exception& e)
 				{
-					game.icon_path = dir + "/ICON0.PNG";
+					LOG_FATAL(GENERAL, "Failed to update game list at %s\n%s thrown: %s", scan->paths[i], typeid(e).name(), e.what());
 				}
 
-				game.category = sstr(cat->second);
-			}
-			else if ((cat = category::cat_data.find(game.category)) != category::cat_data.end())
-			{
-				game.icon_path = dir + "/ICON0.PNG";
-				game.category = sstr(cat->second);
-			}
-			else if (game.category == sstr(category::unknown))
-			{
-				game.icon_path = dir + "/ICON0.PNG";
-			}
-			else
-			{
-				game.icon_path = dir + "/ICON0.PNG";
-				game.category = sstr(category::other);
-			}
-
-			// Load Image
-			QImage img;
+				scan->games[i].done = true;
+			});
 
-			if (game.icon_path.empty() || !img.load(qstr(game.icon_path)))
+			if (!scan->cancel)
 			{
-				LOG_WARNING(GENERAL, "Could not load image from path %s", sstr(QDir(qstr(game.icon_path)).absolutePath()));
+				save_cache(scan->games);
 			}
+		});
 
-			bool hasCustomConfig = fs::is_file(fs::get_config_dir() + "data/" + game.serial + "/config.yml");
-
-			QPixmap pxmap = PaintedPixmap(img, hasCustomConfig);
-
-			m_game_data.push_back(game_info(new gui_game_info{ game, m_game_compat->GetCompatibility(game.serial), img, pxmap, hasCustomConfig }));
-		}
-		catch (const std::exception& e)
-		{
-			LOG_FATAL(GENERAL, "Failed to update game list at %s\n%s thrown: %s", dir, typeid(e).name(), e.what());
-			continue;
-			// Blame MSVC for double }}
-		}}
-
-		auto op = [](const game_info& game1, const game_info& game2)
-		{
-			return qstr(game1->info.name).toLower() < qstr(game2->info.name).toLower();
-		};
-
-		// Sort by name at the very least.
-		std::sort(m_game_data.begin(), m_game_data.end(), op);
-
-		// clean up hidden games list
-		m_hidden_list.intersect(serials);
-		m_gui_settings->SetValue(gui::gl_hidden_list, QStringList(m_hidden_list.toList()));
+		m_scan_timer->start();
+		return;
 	}
 
 	// Fill Game List / Game Grid
@@ -526,6 +821,86 @@ void game_list_frame::Refresh(const bool fromDrive, const bool scrollAfter)
 	}
 }
 
+void game_list_frame::UpdateScan()
+{
+	if (!m_scan)
+	{
+		m_scan_timer->stop();
+		return;
+	}
+
+	game_list_scan& scan = *m_scan;
+
+	if (scan.next == 0)
+	{
+		m_game_data.clear();
+		m_notes.clear();
+	}
+
+	bool added = false;
+
+	for (; scan.next < scan.games.size() && scan.games[scan.next].done; scan.next++)
+	{
+		auto& result = scan.games[scan.next];
+
+		if (!result.valid)
+		{
+			continue;
+		}
+
+		// Detect duplication
+		if (!scan.serial_cat[result.info.serial].emplace(result.sfo_category).second)
+		{
+			continue;
+		}
+
+		QString serial = qstr(result.info.serial);
+		m_notes[serial] = m_gui_settings->GetValue(gui::notes, serial, "").toString();
+		scan.serials.insert(serial);
+
+		const compat_status compat = m_game_compat->GetCompatibility(result.info.serial);
+
+		game_info game(new gui_game_info{ std::move(result.info), compat, std::move(result.icon), std::move(result.thumbnail), QPixmap(), result.hasCustomConfig });
+		game->pxmap = PaintedPixmap(game);
+		m_game_data.push_back(game);
+		added = true;
+	}
+
+	const bool finished = scan.next == scan.games.size();
+
+	if (added)
+	{
+		auto op = [](const game_info& game1, const game_info& game2)
+		{
+			return qstr(game1->info.name).toLower() < qstr(game2->info.name).toLower();
+		};
+
+		// Sort by name at the very least.
+		std::stable_sort(m_game_data.begin(), m_game_data.end(), op);
+	}
+
+	if (!finished)
+	{
+		if (added)
+		{
+			Refresh(false, false);
+		}
+
+		return;
+	}
+
+	// clean up hidden games list
+	m_hidden_list.intersect(scan.serials);
+	m_gui_settings->SetValue(gui::gl_hidden_list, QStringList(m_hidden_list.toList()));
+
+	m_scan_timer->stop();
+
+	const bool scroll_after = scan.scroll_after;
+	m_scan.reset();
+
+	Refresh(false, scroll_after);
+}
+
 void game_list_frame::ToggleCategoryFilter(const QStringList& categories, bool show)
 {
 	if (show)
@@ -681,10 +1056,10 @@ void game_list_frame::ShowContextMenu(const QPoint &pos)
 	});
 	connect(removeGame, &QAction::triggered, [=]
 	{
-		if (currGame.path.empty())
-		{
-			LOG_FATAL(GENERAL, "Cannot delete game. Path is empty");
-			return;
+		if (currGame.path.empty())
+		{
+			LOG_FATAL(GENERAL, "Cannot delete game. Path is empty");
+			return;
 		}
 
 		QMessageBox* mb = new QMessageBox(QMessageBox::Question, tr("Confirm %1 Removal").arg(qstr(currGame.category)), tr("Permanently remove %0 from drive?\nPath: %1").arg(name).arg(qstr(currGame.path)), QMessageBox::Yes | QMessageBox::No, this);
@@ -751,14 +1126,14 @@ void game_list_frame::ShowContextMenu(const QPoint &pos)
 	connect(editNotes, &QAction::triggered, [=]
 	{
 		bool accepted;
-		const QString old_notes = m_gui_settings->GetValue(gui::notes, serial, "").toString();
-		const QString new_notes = QInputDialog::getMultiLineText(this, tr("Edit Tooltip Notes"), QString("%0\n%1").arg(name).arg(serial), old_notes, &accepted);
-
-		if (accepted)
-		{
-			m_notes[serial] = new_notes;
-			m_gui_settings->SetValue(gui::notes, serial, new_notes);
-			Refresh();
+		const QString old_notes = m_gui_settings->GetValue(gui::notes, serial, "").toString();
+		const QString new_notes = QInputDialog::getMultiLineText(this, tr("Edit Tooltip Notes"), QString("%0\n%1").arg(name).arg(serial), old_notes, &accepted);
+
+		if (accepted)
+		{
+			m_notes[serial] = new_notes;
+			m_gui_settings->SetValue(gui::notes, serial, new_notes);
+			Refresh();
 		}
 	});
 	connect(copy_info, &QAction::triggered, [=]
@@ -839,18 +1214,18 @@ bool game_list_frame::DeleteShadersCache(const std::string& base_dir, bool is_in
 	if (is_interactive && QMessageBox::question(this, tr("Confirm Delete"), tr("Delete shaders cache?")) != QMessageBox::Yes)
 		return false;
 
-	QDirIterator dir_iter(qstr(base_dir), QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
-	while (dir_iter.hasNext())
-	{
-		const QString filepath = dir_iter.next();
-
+	QDirIterator dir_iter(qstr(base_dir), QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+	while (dir_iter.hasNext())
+	{
+		const QString filepath = dir_iter.next();
+
 		if (dir_iter.fileName() == "shaders_cache")
 		{
 			if (QDir(filepath).removeRecursively())
 				LOG_NOTICE(GENERAL, "Removed shaders cache dir: %s", sstr(filepath));
-			else
+			else
 				LOG_WARNING(GENERAL, "Could not remove shaders cache file: %s", sstr(filepath));
-		}
+		}
 	}
 
 	LOG_SUCCESS(GENERAL, "Removed shaders cache in %s", base_dir);
@@ -865,18 +1240,18 @@ bool game_list_frame::DeleteLLVMCache(const std::string& base_dir, bool is_inter
 	if (is_interactive && QMessageBox::question(this, tr("Confirm Delete"), tr("Delete LLVM cache?")) != QMessageBox::Yes)
 		return false;
 
-	QDirIterator dir_iter(qstr(base_dir), QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
-	while (dir_iter.hasNext())
-	{
-		const QString filepath = dir_iter.next();
-
+	QDirIterator dir_iter(qstr(base_dir), QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+	while (dir_iter.hasNext())
+	{
+		const QString filepath = dir_iter.next();
+
 		if (dir_iter.fileInfo().absoluteFilePath().endsWith(".obj", Qt::CaseInsensitive))
-		{
+		{
 			if (QFile::remove(filepath))
 				LOG_NOTICE(GENERAL, "Removed LLVM cache file: %s", sstr(filepath));
-			else
-				LOG_WARNING(GENERAL, "Could not remove LLVM cache file: %s", sstr(filepath));
-		}
+			else
+				LOG_WARNING(GENERAL, "Could not remove LLVM cache file: %s", sstr(filepath));
+		}
 	}
 
 	LOG_SUCCESS(GENERAL, "Removed LLVM cache in %s", base_dir);
@@ -891,37 +1266,48 @@ bool game_list_frame::DeleteSPUCache(const std::string& base_dir, bool is_intera
 	if (is_interactive && QMessageBox::question(this, tr("Confirm Delete"), tr("Delete SPU cache?")) != QMessageBox::Yes)
 		return false;
 
-	QDirIterator dir_iter(qstr(base_dir), QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
-	while (dir_iter.hasNext())
-	{
-		const QString filepath = dir_iter.next();
-
+	QDirIterator dir_iter(qstr(base_dir), QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+	while (dir_iter.hasNext())
+	{
+		const QString filepath = dir_iter.next();
+
 		if (dir_iter.fileInfo().absoluteFilePath().endsWith(".dat", Qt::CaseInsensitive))
 		{
 			if (QFile::remove(filepath))
 				LOG_NOTICE(GENERAL, "Removed SPU cache file: %s", sstr(filepath));
-			else
+			else
 				LOG_WARNING(GENERAL, "Could not remove SPU cache file: %s", sstr(filepath));
-		}
+		}
 	}
 
 	LOG_SUCCESS(GENERAL, "Removed SPU cache in %s", base_dir);
 	return true;
 }
 
-QPixmap game_list_frame::PaintedPixmap(const QImage& img, bool paintConfigIcon)
+QPixmap game_list_frame::PaintedPixmap(const game_info& game)
 {
+	// Rescale the icon if the icon size changed since the thumbnail was made, the full icon is only loaded then
+	if (!thumbnail_fits(game->thumbnail, m_Icon_Size))
+	{
+		if (game->icon.isNull() && !game->info.icon_path.empty())
+		{
+			game->icon.load(qstr(game->info.icon_path));
+		}
+
+		game->thumbnail = game->icon.isNull() ? QImage() : scale_icon(game->icon, m_Icon_Size);
+	}
+
 	QImage scaled = QImage(m_Icon_Size, QImage::Format_ARGB32);
 	scaled.fill(m_Icon_Color);
 
 	QPainter painter(&scaled);
 
-	if (!img.isNull())
+	if (!game->thumbnail.isNull())
 	{
-		painter.drawImage(QPoint(0, 0), img.scaled(m_Icon_Size, Qt::KeepAspectRatio, Qt::TransformationMode::SmoothTransformation));
+		painter.drawImage(QPoint(0, 0), game->thumbnail);
 	}
 
-	if (paintConfigIcon && !m_isListLayout)
+	if (game->hasCustomConfig && !m_isListLayout)
 	{
 		int width = m_Icon_Size.width() * 0.2;
 		QPoint origin = QPoint(m_Icon_Size.width() - width, 0);
@@ -942,7 +1328,7 @@ void game_list_frame::ShowCustomConfigIcon(QTableWidgetItem* item, bool enabled)
 	}
 
 	game->hasCustomConfig = enabled;
-	game->pxmap = PaintedPixmap(game->icon, enabled);
+	game->pxmap = PaintedPixmap(game);
 
 	if (!m_isListLayout)
 	{
@@ -984,7 +1370,7 @@ void game_list_frame::RepaintIcons(const bool& fromSettings)
 
 	for (auto& game : m_game_data)
 	{
-		game->pxmap = PaintedPixmap(game->icon, game->hasCustomConfig);
+		game->pxmap = PaintedPixmap(game);
 	}
 
 	Refresh();
@@ -1060,57 +1446,57 @@ bool game_list_frame::eventFilter(QObject *object, QEvent *event)
 				return true;
 			}
 		}
-		else
-		{
-			if (keyEvent->key() == Qt::Key_Enter || keyEvent->key() == Qt::Key_Return)
-			{
-				QTableWidgetItem* item;
-
-				if (object == m_gameList)
-					item = m_gameList->item(m_gameList->currentRow(), gui::column_icon);
-				else
-					item = m_xgrid->currentItem();
-
-				if (!item || !item->isSelected())
-					return false;
-
+		else
+		{
+			if (keyEvent->key() == Qt::Key_Enter || keyEvent->key() == Qt::Key_Return)
+			{
+				QTableWidgetItem* item;
+
+				if (object == m_gameList)
+					item = m_gameList->item(m_gameList->currentRow(), gui::column_icon);
+				else
+					item = m_xgrid->currentItem();
+
+				if (!item || !item->isSelected())
+					return false;
+
 				game_info gameinfo = GetGameInfoFromItem(item);
 
 				if (gameinfo.get() == nullptr)
-					return false;
-
+					return false;
+
 				LOG_NOTICE(LOADER, "Booting from gamelist by pressing %s...", keyEvent->key() == Qt::Key_Enter ? "Enter" : "Return");
-				Q_EMIT RequestBoot(gameinfo->info.path);
-
-				return true;
-			}
-		}
-	}
-	else if (event->type() == QEvent::ToolTip)
-	{
-		QHelpEvent *helpEvent = static_cast<QHelpEvent *>(event);
-		QTableWidgetItem* item;
-
-		if (m_isListLayout)
-		{
-			item = m_gameList->itemAt(helpEvent->globalPos());
-		}
-		else
-		{
-			item = m_xgrid->itemAt(helpEvent->globalPos());
-		}
-
-		if (item && !item->toolTip().isEmpty() && (!m_isListLayout || item->column() == gui::column_name || item->column() == gui::column_serial))
-		{
-			QToolTip::showText(helpEvent->globalPos(), item->toolTip());
-		}
-		else
-		{
-			QToolTip::hideText();
-			event->ignore();
-		}
-
-		return true;
+				Q_EMIT RequestBoot(gameinfo->info.path);
+
+				return true;
+			}
+		}
+	}
+	else if (event->type() == QEvent::ToolTip)
+	{
+		QHelpEvent *helpEvent = static_cast<QHelpEvent *>(event);
+		QTableWidgetItem* item;
+
+		if (m_isListLayout)
+		{
+			item = m_gameList->itemAt(helpEvent->globalPos());
+		}
+		else
+		{
+			item = m_xgrid->itemAt(helpEvent->globalPos());
+		}
+
+		if (item && !item->toolTip().isEmpty() && (!m_isListLayout || item->column() == gui::column_name || item->column() == gui::column_serial))
+		{
+			QToolTip::showText(helpEvent->globalPos(), item->toolTip());
+		}
+		else
+		{
+			QToolTip::hideText();
+			event->ignore();
+		}
+
+		return true;
 	}
 
 	return QDockWidget::eventFilter(object, event);
@@ -1156,11 +1542,11 @@ int game_list_frame::PopulateGameList()
 		// Serial
 		custom_table_widget_item* serial_item = new custom_table_widget_item(game->info.serial);
 
-		if (!notes.isEmpty())
-		{
-			const QString tool_tip = tr("%0 [%1]\n\nNotes:\n%2").arg(name).arg(serial).arg(notes);
-			title_item->setToolTip(tool_tip);
-			serial_item->setToolTip(tool_tip);
+		if (!notes.isEmpty())
+		{
+			const QString tool_tip = tr("%0 [%1]\n\nNotes:\n%2").arg(name).arg(serial).arg(notes);
+			title_item->setToolTip(tool_tip);
+			serial_item->setToolTip(tool_tip);
 		}
 
 		// Move Support (http://www.psdevwiki.com/ps3/PARAM.SFO#ATTRIBUTE)
@@ -1259,13 +1645,13 @@ void game_list_frame::PopulateGameGrid(int maxCols, const QSize& image_size, con
 		m_xgrid->addItem(app->pxmap, title,  r, c);
 		m_xgrid->item(r, c)->setData(gui::game_role, QVariant::fromValue(app));
 
-		if (!notes.isEmpty())
-		{
-			m_xgrid->item(r, c)->setToolTip(tr("%0 [%1]\n\nNotes:\n%2").arg(title).arg(serial).arg(notes));
+		if (!notes.isEmpty())
+		{
+			m_xgrid->item(r, c)->setToolTip(tr("%0 [%1]\n\nNotes:\n%2").arg(title).arg(serial).arg(notes));
 		}
-		else
-		{
-			m_xgrid->item(r, c)->setToolTip(tr("%0 [%1]").arg(title).arg(serial));
+		else
+		{
+			m_xgrid->item(r, c)->setToolTip(tr("%0 [%1]").arg(title).arg(serial));
 		}
 
 		if (selected_item == app->info.icon_path)
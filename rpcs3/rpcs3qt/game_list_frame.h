@@ -14,6 +14,7 @@
 #include <QLineEdit>
 #include <QStackedWidget>
 #include <QSet>
+#include <QTimer>
 
 #include <memory>
 
@@ -164,7 +165,8 @@ struct gui_game_info
 {
 	GameInfo info;
 	compat_status compat;
-	QImage icon;
+	QImage icon;      // Full size icon, may stay unloaded if the thumbnail came from the game list cache
+	QImage thumbnail; // Icon scaled to the icon size
 	QPixmap pxmap;
 	bool hasCustomConfig;
 };
@@ -172,6 +174,8 @@ struct gui_game_info
 typedef std::shared_ptr<gui_game_info> game_info;
 Q_DECLARE_METATYPE(game_info)
 
+struct game_list_scan;
+
 class game_list_frame : public custom_dock_widget
 {
 	Q_OBJECT
@@ -228,11 +232,12 @@ protected:
 	void resizeEvent(QResizeEvent *event) override;
 	bool eventFilter(QObject *object, QEvent *event) override;
 private:
-	QPixmap PaintedPixmap(const QImage& img, bool paintConfigIcon = false);
+	QPixmap PaintedPixmap(const game_info& game);
 	void ShowCustomConfigIcon(QTableWidgetItem* item, bool enabled);
 	void PopulateGameGrid(int maxCols, const QSize& image_size, const QColor& image_color);
 	bool IsEntryVisible(const game_info& game);
 	void SortGameList();
+	void UpdateScan();
 
 	int PopulateGameList();
 	bool SearchMatchesApp(const std::string& name, const std::string& serial);
@@ -268,6 +273,8 @@ private:
 	std::shared_ptr<gui_settings> m_gui_settings;
 	std::shared_ptr<emu_settings> m_emu_settings;
 	QList<game_info> m_game_data;
+	std::shared_ptr<game_list_scan> m_scan;
+	QTimer* m_scan_timer;
 	QSet<QString> m_hidden_list;
 	bool m_show_hidden{false};
 
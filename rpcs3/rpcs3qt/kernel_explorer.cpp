@@ -25,6 +25,76 @@
 
 #include "kernel_explorer.h"
 
+namespace
+{
+	union name64
+	{
+		u64 u64_data;
+		char string[8];
+
+		name64(u64 data)
+			: u64_data(data & 0x00ffffffffffffffull)
+		{
+		}
+
+		const char* operator+() const
+		{
+			return string;
+		}
+	};
+
+	// lv2 object types shown (ID >> 24), in display order
+	const std::pair<u32, const char*> s_lv2_types[] =
+	{
+		{ SYS_MEM_OBJECT,                 "Memory" },
+		{ SYS_MUTEX_OBJECT,               "Mutexes" },
+		{ SYS_COND_OBJECT,                "Condition Variables" },
+		{ SYS_RWLOCK_OBJECT,              "Reader Writer Locks" },
+		{ SYS_INTR_TAG_OBJECT,            "Interrupt Tags" },
+		{ SYS_INTR_SERVICE_HANDLE_OBJECT, "Interrupt Service Handles" },
+		{ SYS_EVENT_QUEUE_OBJECT,         "Event Queues" },
+		{ SYS_EVENT_PORT_OBJECT,          "Event Ports" },
+		{ SYS_TRACE_OBJECT,               "Traces" },
+		{ SYS_SPUIMAGE_OBJECT,            "SPU Images" },
+		{ SYS_PRX_OBJECT,                 "Modules" },
+		{ SYS_SPUPORT_OBJECT,             "SPU Ports" },
+		{ SYS_LWMUTEX_OBJECT,             "Light Weight Mutexes" },
+		{ SYS_TIMER_OBJECT,               "Timers" },
+		{ SYS_SEMAPHORE_OBJECT,           "Semaphores" },
+		{ SYS_LWCOND_OBJECT,              "Light Weight Condition Variables" },
+		{ SYS_EVENT_FLAG_OBJECT,          "Event Flags" },
+	};
+
+	// Categories following the lv2 object types
+	enum : u32
+	{
+		cat_memory_containers = ::size32(s_lv2_types),
+		cat_ppu_threads,
+		cat_spu_threads,
+		cat_spu_groups,
+		cat_fds,
+		cat_host_memory,
+		cat_host_locks,
+		cat_count,
+	};
+
+	const char* const s_extra_categories[] =
+	{
+		"Memory Containers",
+		"PPU Threads",
+		"SPU Threads",
+		"SPU Thread Groups",
+		"File Descriptors",
+		"Host Memory Usage",
+		"Host Lock Contention",
+	};
+
+	// Interval of the live view
+	constexpr int s_live_interval = 500;
+}
+
+constexpr auto qstr = QString::fromStdString;
+
 kernel_explorer::kernel_explorer(QWidget* parent) : QDialog(parent)
 {
 	setWindowTitle(tr("Kernel Explorer"));
@@ -35,7 +105,10 @@ kernel_explorer::kernel_explorer(QWidget* parent) : QDialog(parent)
 	QVBoxLayout* vbox_panel = new QVBoxLayout();
 	QHBoxLayout* hbox_buttons = new QHBoxLayout();
 	QPushButton* button_refresh = new QPushButton(tr("Refresh"), this);
+	QCheckBox* check_live = new QCheckBox(tr("Live"), this);
+	check_live->setToolTip(tr("Refresh every %0 ms").arg(s_live_interval));
 	hbox_buttons->addWidget(button_refresh);
+	hbox_buttons->addWidget(check_live);
 	hbox_buttons->addStretch();
 
 	m_tree = new QTreeWidget(this);
@@ -43,6 +116,19 @@ kernel_explorer::kernel_explorer(QWidget* parent) : QDialog(parent)
 	m_tree->setWindowTitle(tr("Kernel"));
 	m_tree->header()->close();
 
+	m_timer = new QTimer(this);
+	m_timer->setInterval(s_live_interval);
+
+	for (const auto& type : s_lv2_types)
+	{
+		m_category_names.emplace_back(type.second);
+	}
+
+	for (const char* name : s_extra_categories)
+	{
+		m_category_names.emplace_back(name);
+	}
+
 	// Merge and display everything
 	vbox_panel->addSpacing(10);
 	vbox_panel->addLayout(hbox_buttons);
@@ -53,259 +139,313 @@ kernel_explorer::kernel_explorer(QWidget* parent) : QDialog(parent)
 
 	// Events
 	connect(button_refresh, &QAbstractButton::clicked, this, &kernel_explorer::Update);
+	connect(m_timer, &QTimer::timeout, this, &kernel_explorer::Update);
+	connect(check_live, &QCheckBox::toggled, [this](bool checked)
+	{
+		checked ? m_timer->start() : m_timer->stop();
+	});
 
 	Update();
 };
 
-constexpr auto qstr = QString::fromStdString;
+void kernel_explorer::UpdateChildren(QTreeWidgetItem* node, const std::vector<node_state>& state)
+{
+	for (int i = 0; i < static_cast<int>(state.size()); i++)
+	{
+		const node_state& entry = state[i];
+		QTreeWidgetItem* item = nullptr;
+
+		// Objects keep their order, so items in front of the matching one belong to objects that are gone
+		for (int j = i; j < node->childCount(); j++)
+		{
+			if (node->child(j)->data(0, Qt::UserRole).toULongLong() == entry.key)
+			{
+				for (; j > i; j--)
+				{
+					delete node->child(i);
+				}
+
+				item = node->child(i);
+				break;
+			}
+		}
+
+		if (!item)
+		{
+			item = new QTreeWidgetItem();
+			item->setData(0, Qt::UserRole, entry.key);
+			node->insertChild(i, item);
+		}
+
+		const QString text = qstr(entry.text);
+
+		if (item->text(0) != text)
+		{
+			item->setText(0, text);
+		}
+
+		for (int c = 0; c < static_cast<int>(entry.children.size()); c++)
+		{
+			QTreeWidgetItem* child = c < item->childCount() ? item->child(c) : new QTreeWidgetItem(item);
+			const QString child_text = qstr(entry.children[c]);
+
+			if (child->text(0) != child_text)
+			{
+				child->setText(0, child_text);
+			}
+		}
+
+		while (item->childCount() > static_cast<int>(entry.children.size()))
+		{
+			delete item->child(item->childCount() - 1);
+		}
+	}
+
+	while (node->childCount() > static_cast<int>(state.size()))
+	{
+		delete node->child(node->childCount() - 1);
+	}
+}
 
 void kernel_explorer::Update()
 {
-	m_tree->clear();
-
 	const auto vm_block = vm::get(vm::user_space);
 
 	if (!vm_block)
 	{
+		m_tree->clear();
+		m_root = nullptr;
+		m_categories.clear();
 		return;
 	}
 
 	const u32 total_memory_usage = vm_block->used();
 
-	QTreeWidgetItem* root = new QTreeWidgetItem();
-	root->setText(0, qstr(fmt::format("Process, ID = 0x00000001, Total Memory Usage = 0x%x (%0.2f MB)", total_memory_usage, (float)total_memory_usage / (1024 * 1024))));
-	m_tree->addTopLevelItem(root);
+	// Take the state of all objects first, the tree is only touched afterwards
+	std::vector<std::vector<node_state>> state(cat_count);
 
-	union name64
+	const auto add = [&](u32 category, quint64 key, std::string text)
 	{
-		u64 u64_data;
-		char string[8];
-
-		name64(u64 data)
-			: u64_data(data & 0x00ffffffffffffffull)
-		{
-		}
-
-		const char* operator+() const
-		{
-			return string;
-		}
+		state[category].push_back({key, std::move(text)});
+		return &state[category].back();
 	};
 
 	// TODO: FileSystem
 
-	struct lv2_obj_rec
+	for (const auto& pair : idm::snapshot<lv2_obj>())
 	{
-		QTreeWidgetItem* node;
-		u32 count{ 0 };
+		const u32 id = pair.first;
+		lv2_obj& obj = *pair.second;
+
+		u32 category = cat_count;
 
-		lv2_obj_rec() = default;
-		lv2_obj_rec(QTreeWidgetItem* node)
-			: node(node)
+		for (u32 i = 0; i < ::size32(s_lv2_types); i++)
 		{
+			if (s_lv2_types[i].first == id >> 24)
+			{
+				category = i;
+				break;
+			}
 		}
-	};
-
-	auto l_addTreeChild = [=](QTreeWidgetItem *parent, QString text)
-	{
-		QTreeWidgetItem *treeItem = new QTreeWidgetItem();
-		treeItem->setText(0, text);
-		parent->addChild(treeItem);
-		return treeItem;
-	};
 
-	std::vector<lv2_obj_rec> lv2_types(256);
-	lv2_types[SYS_MEM_OBJECT] =									l_addTreeChild(root, "Memory");
-	lv2_types[SYS_MUTEX_OBJECT] =								l_addTreeChild(root, "Mutexes");
-	lv2_types[SYS_COND_OBJECT] =								l_addTreeChild(root, "Condition Variables");
-	lv2_types[SYS_RWLOCK_OBJECT] =							l_addTreeChild(root, "Reader Writer Locks");
-	lv2_types[SYS_INTR_TAG_OBJECT] =						l_addTreeChild(root, "Interrupt Tags");
-	lv2_types[SYS_INTR_SERVICE_HANDLE_OBJECT] = l_addTreeChild(root, "Interrupt Service Handles");
-	lv2_types[SYS_EVENT_QUEUE_OBJECT] =					l_addTreeChild(root, "Event Queues");
-	lv2_types[SYS_EVENT_PORT_OBJECT] =					l_addTreeChild(root, "Event Ports");
-	lv2_types[SYS_TRACE_OBJECT] =								l_addTreeChild(root, "Traces");
-	lv2_types[SYS_SPUIMAGE_OBJECT] =						l_addTreeChild(root, "SPU Images");
-	lv2_types[SYS_PRX_OBJECT] =									l_addTreeChild(root, "Modules");
-	lv2_types[SYS_SPUPORT_OBJECT] =							l_addTreeChild(root, "SPU Ports");
-	lv2_types[SYS_LWMUTEX_OBJECT] =							l_addTreeChild(root, "Light Weight Mutexes");
-	lv2_types[SYS_TIMER_OBJECT] =								l_addTreeChild(root, "Timers");
-	lv2_types[SYS_SEMAPHORE_OBJECT] =						l_addTreeChild(root, "Semaphores");
-	lv2_types[SYS_LWCOND_OBJECT] =							l_addTreeChild(root, "Light Weight Condition Variables");
-	lv2_types[SYS_EVENT_FLAG_OBJECT] =					l_addTreeChild(root, "Event Flags");
-
-	idm::select<lv2_obj>([&](u32 id, lv2_obj& obj)
-	{
-		lv2_types[id >> 24].count++;
+		if (category == cat_count)
+		{
+			continue;
+		}
 
-		if (auto& node = lv2_types[id >> 24].node) switch (id >> 24)
+		switch (id >> 24)
 		{
 		case SYS_MEM_OBJECT:
 		{
 			// auto& mem = static_cast<lv2_memory&>(obj);
-			l_addTreeChild(node, qstr(fmt::format("Memory: ID = 0x%08x", id)));
+			add(category, id, fmt::format("Memory: ID = 0x%08x", id));
 			break;
 		}
 		case SYS_MUTEX_OBJECT:
 		{
 			auto& mutex = static_cast<lv2_mutex&>(obj);
-			l_addTreeChild(node, qstr(fmt::format("Mutex: ID = 0x%08x \"%s\",%s Owner = 0x%x, Locks = %u, Conds = %u, Wq = %zu", id, +name64(mutex.name),
-				mutex.recursive == SYS_SYNC_RECURSIVE ? " Recursive," : "", mutex.owner >> 1, +mutex.lock_count, +mutex.cond_count, mutex.sq.size())));
+			add(category, id, fmt::format("Mutex: ID = 0x%08x \"%s\",%s Owner = 0x%x, Locks = %u, Conds = %u, Wq = %zu", id, +name64(mutex.name),
+				mutex.recursive == SYS_SYNC_RECURSIVE ? " Recursive," : "", mutex.owner >> 1, +mutex.lock_count, +mutex.cond_count, mutex.sq.size()));
 			break;
 		}
 		case SYS_COND_OBJECT:
 		{
 			auto& cond = static_cast<lv2_cond&>(obj);
-			l_addTreeChild(node, qstr(fmt::format("Cond: ID = 0x%08x \"%s\", Waiters = %u", id, +name64(cond.name), +cond.waiters)));
+			add(category, id, fmt::format("Cond: ID = 0x%08x \"%s\", Waiters = %u", id, +name64(cond.name), +cond.waiters));
 			break;
 		}
 		case SYS_RWLOCK_OBJECT:
 		{
 			auto& rw = static_cast<lv2_rwlock&>(obj);
 			const s64 val = rw.owner;
-			l_addTreeChild(node, qstr(fmt::format("RW Lock: ID = 0x%08x \"%s\", Owner = 0x%x(%d), Rq = %zu, Wq = %zu", id, +name64(rw.name),
-				std::max<s64>(0, val >> 1), -std::min<s64>(0, val >> 1), rw.rq.size(), rw.wq.size())));
+			add(category, id, fmt::format("RW Lock: ID = 0x%08x \"%s\", Owner = 0x%x(%d), Rq = %zu, Wq = %zu", id, +name64(rw.name),
+				std::max<s64>(0, val >> 1), -std::min<s64>(0, val >> 1), rw.rq.size(), rw.wq.size()));
 			break;
 		}
 		case SYS_INTR_TAG_OBJECT:
 		{
 			// auto& tag = static_cast<lv2_int_tag&>(obj);
-			l_addTreeChild(node, qstr(fmt::format("Intr Tag: ID = 0x%08x", id)));
+			add(category, id, fmt::format("Intr Tag: ID = 0x%08x", id));
 			break;
 		}
 		case SYS_INTR_SERVICE_HANDLE_OBJECT:
 		{
 			// auto& serv = static_cast<lv2_int_serv&>(obj);
-			l_addTreeChild(node, qstr(fmt::format("Intr Svc: ID = 0x%08x", id)));
+			add(category, id, fmt::format("Intr Svc: ID = 0x%08x", id));
 			break;
 		}
 		case SYS_EVENT_QUEUE_OBJECT:
 		{
 			auto& eq = static_cast<lv2_event_queue&>(obj);
-			l_addTreeChild(node, qstr(fmt::format("Event Queue: ID = 0x%08x \"%s\", %s, Key = %#llx, Events = %zu/%d, Waiters = %zu", id, +name64(eq.name),
-				eq.type == SYS_SPU_QUEUE ? "SPU" : "PPU", eq.key, eq.events.size(), eq.size, eq.sq.size())));
+			add(category, id, fmt::format("Event Queue: ID = 0x%08x \"%s\", %s, Key = %#llx, Events = %zu/%d, Waiters = %zu", id, +name64(eq.name),
+				eq.type == SYS_SPU_QUEUE ? "SPU" : "PPU", eq.key, eq.events.size(), eq.size, eq.sq.size()));
 			break;
 		}
 		case SYS_EVENT_PORT_OBJECT:
 		{
 			auto& ep = static_cast<lv2_event_port&>(obj);
-			l_addTreeChild(node, qstr(fmt::format("Event Port: ID = 0x%08x, Name = %#llx", id, ep.name)));
+			add(category, id, fmt::format("Event Port: ID = 0x%08x, Name = %#llx", id, ep.name));
 			break;
 		}
 		case SYS_TRACE_OBJECT:
 		{
-			l_addTreeChild(node, qstr(fmt::format("Trace: ID = 0x%08x", id)));
+			add(category, id, fmt::format("Trace: ID = 0x%08x", id));
 			break;
 		}
 		case SYS_SPUIMAGE_OBJECT:
 		{
-			l_addTreeChild(node, qstr(fmt::format("SPU Image: ID = 0x%08x", id)));
+			add(category, id, fmt::format("SPU Image: ID = 0x%08x", id));
 			break;
 		}
 		case SYS_PRX_OBJECT:
 		{
 			auto& prx = static_cast<lv2_prx&>(obj);
-			l_addTreeChild(node, qstr(fmt::format("PRX: ID = 0x%08x '%s'", id, prx.name)));
+			add(category, id, fmt::format("PRX: ID = 0x%08x '%s'", id, prx.name));
 			break;
 		}
 		case SYS_SPUPORT_OBJECT:
 		{
-			l_addTreeChild(node, qstr(fmt::format("SPU Port: ID = 0x%08x", id)));
+			add(category, id, fmt::format("SPU Port: ID = 0x%08x", id));
 			break;
 		}
 		case SYS_LWMUTEX_OBJECT:
 		{
 			auto& lwm = static_cast<lv2_lwmutex&>(obj);
-			l_addTreeChild(node, qstr(fmt::format("LWMutex: ID = 0x%08x \"%s\", Wq = %zu", id, +name64(lwm.name), lwm.sq.size())));
+			add(category, id, fmt::format("LWMutex: ID = 0x%08x \"%s\", Wq = %zu, Spin = %u (acquired %u, parked %u)", id, +name64(lwm.name), lwm.sq.size(),
+				lwm.spin_hint.load(), lwm.spin_acquired.load(), lwm.spin_parked.load()));
 			break;
 		}
 		case SYS_TIMER_OBJECT:
 		{
 			// auto& timer = static_cast<lv2_timer&>(obj);
-			l_addTreeChild(node, qstr(fmt::format("Timer: ID = 0x%08x", id)));
+			add(category, id, fmt::format("Timer: ID = 0x%08x", id));
 			break;
 		}
 		case SYS_SEMAPHORE_OBJECT:
 		{
 			auto& sema = static_cast<lv2_sema&>(obj);
-			l_addTreeChild(node, qstr(fmt::format("Semaphore: ID = 0x%08x \"%s\", Count = %d, Max Count = %d, Waiters = %#zu", id, +name64(sema.name),
-				sema.val.load(), sema.max, sema.sq.size())));
+			add(category, id, fmt::format("Semaphore: ID = 0x%08x \"%s\", Count = %d, Max Count = %d, Waiters = %#zu", id, +name64(sema.name),
+				sema.val.load(), sema.max, sema.sq.size()));
 			break;
 		}
 		case SYS_LWCOND_OBJECT:
 		{
 			auto& lwc = static_cast<lv2_cond&>(obj);
-			l_addTreeChild(node, qstr(fmt::format("LWCond: ID = 0x%08x \"%s\", Waiters = %zu", id, +name64(lwc.name), +lwc.waiters)));
+			add(category, id, fmt::format("LWCond: ID = 0x%08x \"%s\", Waiters = %zu", id, +name64(lwc.name), +lwc.waiters));
 			break;
 		}
 		case SYS_EVENT_FLAG_OBJECT:
 		{
 			auto& ef = static_cast<lv2_event_flag&>(obj);
-			l_addTreeChild(node, qstr(fmt::format("Event Flag: ID = 0x%08x \"%s\", Type = 0x%x, Pattern = 0x%llx, Wq = %zu", id, +name64(ef.name),
-				ef.type, ef.pattern.load(), +ef.waiters)));
+			add(category, id, fmt::format("Event Flag: ID = 0x%08x \"%s\", Type = 0x%x, Pattern = 0x%llx, Wq = %zu", id, +name64(ef.name),
+				ef.type, ef.pattern.load(), +ef.waiters));
 			break;
 		}
 		default:
 		{
-			l_addTreeChild(node, qstr(fmt::format("Unknown object: ID = 0x%08x", id)));
+			add(category, id, fmt::format("Unknown object: ID = 0x%08x", id));
 		}
 		}
-	});
-
-	lv2_types.emplace_back(l_addTreeChild(root, "Memory Containers"));
+	}
 
-	idm::select<lv2_memory_container>([&](u32 id, lv2_memory_container&)
+	for (const auto& pair : idm::snapshot<lv2_memory_container>())
 	{
-		lv2_types.back().count++;
-		l_addTreeChild(lv2_types.back().node, qstr(fmt::format("Memory Container: ID = 0x%08x", id)));
-	});
-
-	lv2_types.emplace_back(l_addTreeChild(root, "PPU Threads"));
+		add(cat_memory_containers, pair.first, fmt::format("Memory Container: ID = 0x%08x", pair.first));
+	}
 
-	idm::select<ppu_thread>([&](u32 id, ppu_thread& ppu)
+	for (const auto& pair : idm::snapshot<ppu_thread>())
 	{
-		lv2_types.back().count++;
-		l_addTreeChild(lv2_types.back().node, qstr(fmt::format("PPU Thread: ID = 0x%08x '%s'", id, ppu.get_name())));
-	});
+		add(cat_ppu_threads, pair.first, fmt::format("PPU Thread: ID = 0x%08x '%s'", pair.first, pair.second->get_name()));
+	}
 
-	lv2_types.emplace_back(l_addTreeChild(root, "SPU Threads"));
+	for (const auto& pair : idm::snapshot<SPUThread>())
+	{
+		add(cat_spu_threads, pair.first, fmt::format("SPU Thread: ID = 0x%08x '%s'", pair.first, pair.second->get_name()));
+	}
 
-	idm::select<SPUThread>([&](u32 id, SPUThread& spu)
+	for (const auto& pair : idm::snapshot<lv2_spu_group>())
 	{
-		lv2_types.back().count++;
-		l_addTreeChild(lv2_types.back().node, qstr(fmt::format("SPU Thread: ID = 0x%08x '%s'", id, spu.get_name())));
-	});
+		add(cat_spu_groups, pair.first, fmt::format("SPU Thread Group: ID = 0x%08x '%s'", pair.first, pair.second->name));
+	}
 
-	lv2_types.emplace_back(l_addTreeChild(root, "SPU Thread Groups"));
+	for (const auto& pair : idm::snapshot<lv2_fs_object>())
+	{
+		add(cat_fds, pair.first, fmt::format("FD: ID = 0x%08x '%s'", pair.first, pair.second->name.data()));
+	}
 
-	idm::select<lv2_spu_group>([&](u32 id, lv2_spu_group& tg)
+	for (u32 i = 0; i < static_cast<u32>(utils::memory_class::count); i++)
 	{
-		lv2_types.back().count++;
-		l_addTreeChild(lv2_types.back().node, qstr(fmt::format("SPU Thread Group: ID = 0x%08x '%s'", id, tg.name)));
-	});
+		const auto type = static_cast<utils::memory_class>(i);
+		const auto usage = utils::get_memory_usage(type);
 
-	lv2_types.emplace_back(l_addTreeChild(root, "File Descriptors"));
+		if (usage.first || usage.second)
+		{
+			add(cat_host_memory, i, fmt::format("%s: %0.2f MB (peak %0.2f MB)", utils::get_memory_class_name(type),
+				(float)usage.first / (1024 * 1024), (float)usage.second / (1024 * 1024)));
+		}
+	}
 
-	idm::select<lv2_fs_object>([&](u32 id, lv2_fs_object& fo)
-	{
-		lv2_types.back().count++;
-		l_addTreeChild(lv2_types.back().node, qstr(fmt::format("FD: ID = 0x%08x '%s'", id, fo.name.data())));
-	});
+	u32 lock_index = 0;
 
-	for (auto&& entry : lv2_types)
+	for (lock_class* cls = lock_class::get_first(); cls; cls = cls->next)
 	{
-		if (entry.node && entry.count)
+		const auto node = add(cat_host_locks, lock_index++, fmt::format("%s: %u contended, %u slept, %0.3f ms waited", cls->name, +cls->waits, +cls->sleeps, cls->wait_time / 1000000.));
+
+		for (u32 i = 0; i < 16; i++)
 		{
-			// Append object count
-			entry.node->setText(0, entry.node->text(0) + qstr(fmt::format(" (%zu)", entry.count)));
+			if (const u64 count = cls->hist[i])
+			{
+				node->children.emplace_back(fmt::format("%s%u ns: %u", i == 15 ? ">= " : "< ", i == 15 ? 256u << 14 : 256u << i, count));
+			}
 		}
-		else if (entry.node)
+	}
+
+	// Apply the differences to the tree
+	if (!m_root)
+	{
+		m_root = new QTreeWidgetItem();
+		m_tree->addTopLevelItem(m_root);
+
+		for (const auto& name : m_category_names)
 		{
-			// Delete node otherwise
-			delete entry.node;
+			m_categories.push_back(new QTreeWidgetItem(m_root, QStringList(name)));
 		}
+
+		m_root->setExpanded(true);
 	}
 
-	// RawSPU Threads (TODO)
+	m_root->setText(0, qstr(fmt::format("Process, ID = 0x00000001, Total Memory Usage = 0x%x (%0.2f MB)", total_memory_usage, (float)total_memory_usage / (1024 * 1024))));
+
+	for (u32 i = 0; i < cat_count; i++)
+	{
+		const auto node = m_categories[i];
+
+		UpdateChildren(node, state[i]);
 
-	root->setExpanded(true);
+		// Empty categories are hidden, others show the object count
+		node->setHidden(state[i].empty());
+		node->setText(0, m_category_names[i] + qstr(fmt::format(" (%zu)", state[i].size())));
+	}
+
+	// RawSPU Threads (TODO)
 }
@@ -3,14 +3,36 @@
 #include <QDialog>
 #include <QVBoxLayout>
 #include <QPushButton>
+#include <QCheckBox>
+#include <QTimer>
 #include <QTreeWidget>
 #include <QHeaderView>
 
+#include <string>
+#include <vector>
+
 class kernel_explorer : public QDialog
 {
 	Q_OBJECT
 
 	QTreeWidget* m_tree;
+	QTimer* m_timer;
+
+	// Display state of one object, children are matched by position
+	struct node_state
+	{
+		quint64 key;
+		std::string text;
+		std::vector<std::string> children;
+	};
+
+	// Category nodes below the process node, created once and hidden while empty
+	QTreeWidgetItem* m_root = nullptr;
+	std::vector<QTreeWidgetItem*> m_categories;
+	std::vector<QString> m_category_names;
+
+	/** Brings the children of the node in line with the new state, keeping unchanged items (and their expansion and selection) */
+	static void UpdateChildren(QTreeWidgetItem* node, const std::vector<node_state>& state);
 
 public:
 	kernel_explorer(QWidget* parent);
@@ -9,6 +9,12 @@
 #include <QActionGroup>
 #include <QScrollBar>
 #include <QTabBar>
+#include <QApplication>
+#include <QClipboard>
+#include <QAbstractListModel>
+
+#include <deque>
+#include <mutex>
 
 extern atomic_t<s64> g_tty_size;
 
@@ -20,35 +26,27 @@ struct gui_listener : logs::listener
 
 	struct packet
 	{
-		atomic_t<packet*> next{};
-
-		logs::level sev{};
+		logs::level sev;
 		std::string msg;
-
-		~packet()
-		{
-			for (auto ptr = next.raw(); UNLIKELY(ptr);)
-			{
-				delete std::exchange(ptr, std::exchange(ptr->next.raw(), nullptr));
-			}
-		}
 	};
 
-	atomic_t<packet*> last; // Packet for writing another packet
-	atomic_t<packet*> read; // Packet for reading
+	// Messages not yet taken by the GUI thread, the oldest are dropped if it falls behind
+	static constexpr std::size_t max_pending = 0x20000;
+
+	std::mutex mutex;
+	std::deque<packet> packets;
+	u64 dropped = 0;
 
 	gui_listener()
 		: logs::listener()
-		, last(new packet)
-		, read(+last)
 	{
 		// Self-registration
 		logs::listener::add(this);
 	}
 
-	~gui_listener()
+	bool accepts(const logs::message& msg) const override
 	{
-		delete read;
+		return msg.sev <= enabled;
 	}
 
 	void log(u64 stamp, const logs::message& msg, const std::string& prefix, const std::string& text)
@@ -57,48 +55,257 @@ struct gui_listener : logs::listener
 
 		if (msg.sev <= enabled)
 		{
-			const auto _new = new packet;
-			_new->sev = msg.sev;
+			packet _new{msg.sev};
 
 			if (prefix.size() > 0)
 			{
-				_new->msg += "{";
-				_new->msg += prefix;
-				_new->msg += "} ";
+				_new.msg += "{";
+				_new.msg += prefix;
+				_new.msg += "} ";
 			}
 
 			if (msg.ch && '\0' != *msg.ch->name)
 			{
-				_new->msg += msg.ch->name;
-				_new->msg += msg.sev == logs::level::todo ? " TODO: " : ": ";
+				_new.msg += msg.ch->name;
+				_new.msg += msg.sev == logs::level::todo ? " TODO: " : ": ";
 			}
 			else if (msg.sev == logs::level::todo)
 			{
-				_new->msg += "TODO: ";
+				_new.msg += "TODO: ";
 			}
 
-			_new->msg += text;
-			_new->msg += '\n';
+			_new.msg += text;
 
-			last.exchange(_new)->next = _new;
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (packets.size() >= max_pending)
+			{
+				packets.pop_front();
+				dropped++;
+			}
+
+			packets.emplace_back(std::move(_new));
 		}
 	}
 
-	void pop()
+	// Take all pending messages at once
+	u64 take(std::deque<packet>& out)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		out.swap(packets);
+		return std::exchange(dropped, 0);
+	}
+
+	void clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		packets.clear();
+	}
+};
+
+// Virtualized log storage: messages live in a ring buffer, the view only formats and paints the visible rows
+class log_model final : public QAbstractListModel
+{
+public:
+	struct entry
+	{
+		logs::level sev{};
+		QString text;
+		u32 count = 1;
+	};
+
+	// Number of kept messages, older ones are overwritten
+	static constexpr u64 capacity = 0x20000;
+
+	explicit log_model(QObject* parent)
+		: QAbstractListModel(parent)
+		, m_ring(capacity)
+	{
+	}
+
+	int rowCount(const QModelIndex& parent = QModelIndex()) const override
+	{
+		return parent.isValid() ? 0 : ::size32(m_rows);
+	}
+
+	QVariant data(const QModelIndex& index, int role) const override
 	{
-		if (const auto head = read->next.exchange(nullptr))
+		if (!index.isValid() || index.row() >= rowCount())
 		{
-			delete read.exchange(head);
+			return {};
+		}
+
+		const entry& e = at(m_rows[index.row()]);
+
+		switch (role)
+		{
+		case Qt::DisplayRole:
+		{
+			return e.count > 1 ? e.text + QString(" x%1").arg(e.count) : e.text;
+		}
+		case Qt::ForegroundRole:
+		{
+			const int sev = static_cast<int>(e.sev);
+			return sev < m_colors.count() ? QVariant(QBrush(m_colors[sev])) : QVariant();
+		}
+		default:
+		{
+			return {};
+		}
 		}
 	}
 
-	void clear()
+	// Add a batch of messages, identical consecutive messages are counted instead of repeated in stack mode
+	void push(std::vector<entry>& batch, bool stack)
 	{
-		while (read->next)
+		std::size_t first = 0;
+
+		if (stack)
+		{
+			std::size_t out = 0;
+
+			for (std::size_t i = 0; i < batch.size(); i++)
+			{
+				if (out && batch[out - 1].sev == batch[i].sev && batch[out - 1].text == batch[i].text)
+				{
+					batch[out - 1].count += batch[i].count;
+				}
+				else
+				{
+					batch[out++] = std::move(batch[i]);
+				}
+			}
+
+			batch.erase(batch.begin() + out, batch.end());
+
+			if (!batch.empty() && m_count)
+			{
+				entry& last = at(m_count - 1);
+
+				if (last.sev == batch[0].sev && last.text == batch[0].text)
+				{
+					last.count += batch[0].count;
+					first = 1;
+
+					if (!m_rows.empty() && m_rows.back() == m_count - 1)
+					{
+						const QModelIndex changed = index(rowCount() - 1);
+						Q_EMIT dataChanged(changed, changed, { Qt::DisplayRole });
+					}
+				}
+			}
+		}
+
+		if (first >= batch.size())
+		{
+			return;
+		}
+
+		// Messages of a batch larger than the ring would be overwritten right away
+		if (batch.size() - first > capacity)
 		{
-			pop();
+			m_count += batch.size() - first - capacity;
+			first = batch.size() - capacity;
+		}
+
+		const u64 end = m_count + (batch.size() - first);
+
+		// Remove the rows of the messages that are about to be overwritten
+		if (end > capacity)
+		{
+			std::size_t removed = 0;
+
+			while (removed < m_rows.size() && m_rows[removed] < end - capacity)
+			{
+				removed++;
+			}
+
+			if (removed)
+			{
+				beginRemoveRows(QModelIndex(), 0, ::narrow<int>(removed - 1));
+				m_rows.erase(m_rows.begin(), m_rows.begin() + removed);
+				endRemoveRows();
+			}
+		}
+
+		std::vector<u64> rows;
+
+		for (std::size_t i = first; i < batch.size(); i++)
+		{
+			if (batch[i].sev <= m_filter)
+			{
+				rows.push_back(m_count);
+			}
+
+			at(m_count++) = std::move(batch[i]);
+		}
+
+		if (!rows.empty())
+		{
+			beginInsertRows(QModelIndex(), rowCount(), rowCount() + ::size32(rows) - 1);
+			m_rows.insert(m_rows.end(), rows.begin(), rows.end());
+			endInsertRows();
 		}
 	}
+
+	// Only show messages up to the given level, the stored messages stay untouched
+	void set_filter(logs::level filter)
+	{
+		if (filter == m_filter)
+		{
+			return;
+		}
+
+		beginResetModel();
+		m_filter = filter;
+		m_rows.clear();
+
+		for (u64 seq = m_count > capacity ? m_count - capacity : 0; seq < m_count; seq++)
+		{
+			if (at(seq).sev <= m_filter)
+			{
+				m_rows.push_back(seq);
+			}
+		}
+
+		endResetModel();
+	}
+
+	void set_colors(const QList<QColor>& colors)
+	{
+		m_colors = colors;
+
+		if (rowCount())
+		{
+			Q_EMIT dataChanged(index(0), index(rowCount() - 1), { Qt::ForegroundRole });
+		}
+	}
+
+	void clear()
+	{
+		beginResetModel();
+		m_rows.clear();
+		std::fill(m_ring.begin(), m_ring.end(), entry{});
+		m_count = 0;
+		endResetModel();
+	}
+
+private:
+	entry& at(u64 seq)
+	{
+		return m_ring[seq % capacity];
+	}
+
+	const entry& at(u64 seq) const
+	{
+		return m_ring[seq % capacity];
+	}
+
+	std::vector<entry> m_ring;
+	u64 m_count = 0; // Number of messages ever pushed
+	std::deque<u64> m_rows; // Message numbers of the rows passing the filter
+	logs::level m_filter = logs::level::trace;
+	QList<QColor> m_colors;
 };
 
 // GUI Listener instance
@@ -111,9 +318,14 @@ log_frame::log_frame(std::shared_ptr<gui_settings> guiSettings, QWidget *parent)
 	m_tabWidget->setObjectName("tab_widget_log");
 	m_tabWidget->tabBar()->setObjectName("tab_bar_log");
 
-	m_log = new QTextEdit(m_tabWidget);
+	m_log_model = new log_model(this);
+
+	m_log = new QListView(m_tabWidget);
 	m_log->setObjectName("log_frame");
-	m_log->setReadOnly(true);
+	m_log->setModel(m_log_model);
+	m_log->setUniformItemSizes(true);
+	m_log->setSelectionMode(QAbstractItemView::ExtendedSelection);
+	m_log->setEditTriggers(QAbstractItemView::NoEditTriggers);
 	m_log->setContextMenuPolicy(Qt::CustomContextMenu);
 	m_log->installEventFilter(this);
 
@@ -202,12 +414,29 @@ void log_frame::CreateAndConnectActions()
 		connect(act, &QAction::triggered, [this, logLevel]()
 		{
 			s_gui_listener.enabled = std::max(logLevel, logs::level::fatal);
+			m_log_model->set_filter(std::max(logLevel, logs::level::fatal));
 			xgui_settings->SetValue(gui::l_level, static_cast<uint>(logLevel));
 		});
 	};
 
 	m_clearAct = new QAction(tr("Clear"), this);
-	connect(m_clearAct, &QAction::triggered, m_log, &QTextEdit::clear);
+	connect(m_clearAct, &QAction::triggered, [this]()
+	{
+		s_gui_listener.clear();
+		m_log_model->clear();
+	});
+
+	m_copyAct = new QAction(tr("Copy"), this);
+	m_copyAct->setShortcut(QKeySequence::Copy);
+	connect(m_copyAct, &QAction::triggered, this, &log_frame::CopySelection);
+
+	m_selectAllAct = new QAction(tr("Select All"), this);
+	m_selectAllAct->setShortcut(QKeySequence::SelectAll);
+	connect(m_selectAllAct, &QAction::triggered, m_log, &QListView::selectAll);
+
+	m_copyAct->setShortcutContext(Qt::WidgetShortcut);
+	m_selectAllAct->setShortcutContext(Qt::WidgetShortcut);
+	m_log->addActions({ m_copyAct, m_selectAllAct });
 
 	m_clearTTYAct = new QAction(tr("Clear"), this);
 	connect(m_clearTTYAct, &QAction::triggered, m_tty, &QTextEdit::clear);
@@ -250,7 +479,10 @@ void log_frame::CreateAndConnectActions()
 
 	connect(m_log, &QWidget::customContextMenuRequested, [=](const QPoint& pos)
 	{
-		QMenu* menu = m_log->createStandardContextMenu();
+		QMenu* menu = new QMenu(m_log);
+		menu->addAction(m_copyAct);
+		menu->addAction(m_selectAllAct);
+		menu->addSeparator();
 		menu->addAction(m_clearAct);
 		menu->addSeparator();
 		menu->addActions({ m_nothingAct, m_fatalAct, m_errorAct, m_todoAct, m_successAct, m_warningAct, m_noticeAct, m_traceAct });
@@ -258,7 +490,7 @@ void log_frame::CreateAndConnectActions()
 		menu->addAction(m_stackAct);
 		menu->addSeparator();
 		menu->addAction(m_TTYAct);
-		menu->exec(mapToGlobal(pos));
+		menu->exec(m_log->viewport()->mapToGlobal(pos));
 	});
 
 	connect(m_tty, &QWidget::customContextMenuRequested, [=](const QPoint& pos)
@@ -287,10 +519,6 @@ void log_frame::LoadSettings()
 
 void log_frame::RepaintTextColors()
 {
-	// Backup old colors
-	QColor old_color_stack{ m_color_stack };
-	QList<QColor> old_color{ m_color };
-
 	// Get text color. Do this once to prevent possible slowdown
 	m_color.clear();
 	m_color.append(gui::utils::get_label_color("log_level_always"));
@@ -302,59 +530,34 @@ void log_frame::RepaintTextColors()
 	m_color.append(gui::utils::get_label_color("log_level_notice"));
 	m_color.append(gui::utils::get_label_color("log_level_trace"));
 
-	m_color_stack = gui::utils::get_label_color("log_stack");
+	m_log_model->set_colors(m_color);
 
 	// Repaint TTY with new colors
 	m_tty->setTextColor(gui::utils::get_label_color("tty_text"));
+}
 
-	// Repaint log with new colors
-	QTextCursor text_cursor{ m_log->document() };
-	text_cursor.movePosition(QTextCursor::Start);
+void log_frame::CopySelection()
+{
+	QModelIndexList selection = m_log->selectionModel()->selectedRows();
 
-	// Go through each line
-	while (!text_cursor.atEnd())
+	if (selection.isEmpty())
 	{
-		// Jump to the next line, unless this is the first one
-		if (!text_cursor.atStart())
-			text_cursor.movePosition(QTextCursor::NextBlock);
-
-		// Go through each word in the current line
-		while (!text_cursor.atBlockEnd())
-		{
-			// Remove old selection and select a new character (NextWord has proven to be glitchy here)
-			text_cursor.movePosition(QTextCursor::NoMove);
-			text_cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor);
+		return;
+	}
 
-			// Skip if no color needed
-			if (text_cursor.selectedText() == " ")
-				continue;
+	std::sort(selection.begin(), selection.end(), [](const QModelIndex& a, const QModelIndex& b)
+	{
+		return a.row() < b.row();
+	});
 
-			// Get current chars color
-			QTextCharFormat text_format = text_cursor.charFormat();
-			QColor col = text_format.foreground().color();
+	QStringList lines;
 
-			// Get the new color for this word
-			if (col == old_color_stack)
-			{
-				text_format.setForeground(m_color_stack);
-			}
-			else
-			{
-				for (int i = 0; i < old_color.count(); i++)
-				{
-					if (col == old_color[i])
-					{
-						text_format.setForeground(m_color[i]);
-						break;
-					}
-				}
-			}
-
-			// Reinsert the same text with the new color
-			text_cursor.movePosition(QTextCursor::EndOfWord, QTextCursor::KeepAnchor);
-			text_cursor.insertText(text_cursor.selectedText(), text_format);
-		}
+	for (const auto& index : selection)
+	{
+		lines.append(index.data().toString());
 	}
+
+	QApplication::clipboard()->setText(lines.join('\n'));
 }
 
 void log_frame::UpdateUI()
@@ -385,99 +588,62 @@ void log_frame::UpdateUI()
 		if (steady_clock::now() >= start + 4ms || buf.empty()) break;
 	}
 
-	// Check main logs
-	while (const auto packet = s_gui_listener.read->next.load())
-	{
-		// Confirm log level
-		if (packet->sev <= s_gui_listener.enabled)
-		{
-			QString text;
-			switch (packet->sev)
-			{
-			case logs::level::always: break;
-			case logs::level::fatal: text = "F "; break;
-			case logs::level::error: text = "E "; break;
-			case logs::level::todo: text = "U "; break;
-			case logs::level::success: text = "S "; break;
-			case logs::level::warning: text = "W "; break;
-			case logs::level::notice: text = "! "; break;
-			case logs::level::trace: text = "T "; break;
-			default: continue;
-			}
-
-			// Print UTF-8 text.
-			text += qstr(packet->msg);
+	// Check main logs, all pending messages are taken and added to the model as a single batch
+	std::deque<gui_listener::packet> packets;
+	const u64 dropped = s_gui_listener.take(packets);
 
-			// save old log state
-			QScrollBar *sb = m_log->verticalScrollBar();
-			bool isMax = sb->value() == sb->maximum();
-			int sb_pos = sb->value();
-			int sel_pos = m_log->textCursor().position();
-			int sel_start = m_log->textCursor().selectionStart();
-			int sel_end = m_log->textCursor().selectionEnd();
+	std::vector<log_model::entry> batch;
 
-			// clear selection or else it will get colorized as well
-			QTextCursor c = m_log->textCursor();
-			c.clearSelection();
-			m_log->setTextCursor(c);
-
-			// remove the new line because Qt's append adds a new line already.
-			text.chop(1);
-
-			QString suffix;
-			bool isSame = text == m_old_text;
+	if (dropped)
+	{
+		batch.push_back({logs::level::warning, tr("W %0 log messages were dropped").arg(dropped)});
+	}
 
-			// create counter suffix and remove recurring line if needed
-			if (m_stack_log)
-			{
-				if (isSame)
-				{
-					m_log_counter++;
-					suffix = QString(" x%1").arg(m_log_counter);
-					m_log->moveCursor(QTextCursor::End, QTextCursor::MoveAnchor);
-					m_log->moveCursor(QTextCursor::StartOfBlock, QTextCursor::MoveAnchor);
-					m_log->moveCursor(QTextCursor::End, QTextCursor::KeepAnchor);
-					m_log->textCursor().removeSelectedText();
-					m_log->textCursor().deletePreviousChar();
-				}
-				else
-				{
-					m_log_counter = 1;
-					m_old_text = text;
-				}
-			}
+	for (const auto& packet : packets)
+	{
+		// Confirm log level
+		if (packet.sev > s_gui_listener.enabled)
+		{
+			continue;
+		}
 
-			// add actual log message
-			m_log->setTextColor(m_color[static_cast<int>(packet->sev)]);
-			m_log->append(text);
+		QString text;
+		switch (packet.sev)
+		{
+		case logs::level::always: break;
+		case logs::level::fatal: text = "F "; break;
+		case logs::level::error: text = "E "; break;
+		case logs::level::todo: text = "U "; break;
+		case logs::level::success: text = "S "; break;
+		case logs::level::warning: text = "W "; break;
+		case logs::level::notice: text = "! "; break;
+		case logs::level::trace: text = "T "; break;
+		default: continue;
+		}
 
-			// add counter suffix if needed
-			if (m_stack_log && isSame)
-			{
-				m_log->setTextColor(m_color_stack);
-				m_log->insertPlainText(suffix);
-			}
+		// Print UTF-8 text, one row per line
+		const QStringList lines = qstr(packet.msg).split('\n', QString::SkipEmptyParts);
 
-			// if we mark text from right to left we need to swap sides (start is always smaller than end)
-			if (sel_pos < sel_end)
-			{
-				std::swap(sel_start, sel_end);
-			}
+		for (int i = 0; i < lines.count(); i++)
+		{
+			batch.push_back({packet.sev, (i ? QString("  ") : text) + lines[i]});
+		}
+	}
 
-			// reset old text cursor and selection
-			c.setPosition(sel_start);
-			c.setPosition(sel_end, QTextCursor::KeepAnchor);
-			m_log->setTextCursor(c);
+	if (batch.empty())
+	{
+		return;
+	}
 
-			// set scrollbar to max means auto-scroll
-			sb->setValue(isMax ? sb->maximum() : sb_pos);
-		}
+	// Keep scrolling with the log if the scrollbar is at the bottom
+	QScrollBar* sb = m_log->verticalScrollBar();
+	const bool is_max = sb->value() == sb->maximum();
 
-		// Drop packet
-		s_gui_listener.pop();
+	m_log_model->push(batch, m_stack_log);
 
-		// Limit processing time
-		if (steady_clock::now() >= start + 7ms) break;
+	if (is_max)
+	{
+		m_log->scrollToBottom();
 	}
 }
 
@@ -502,7 +668,10 @@ bool log_frame::eventFilter(QObject* object, QEvent* event)
 			if (m_find_dialog && m_find_dialog->isVisible())
 				m_find_dialog->close();
 
-			m_find_dialog = std::make_unique<find_dialog>((QTextEdit*)object, this);
+			if (object == m_log)
+				m_find_dialog = std::make_unique<find_dialog>(m_log, this);
+			else
+				m_find_dialog = std::make_unique<find_dialog>(m_tty, this);
 		}
 	}
 
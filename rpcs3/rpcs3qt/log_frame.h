@@ -11,10 +11,13 @@
 
 #include <QTabWidget>
 #include <QTextEdit>
+#include <QListView>
 #include <QActionGroup>
 #include <QTimer>
 #include <QKeyEvent>
 
+class log_model;
+
 class log_frame : public custom_dock_widget
 {
 	Q_OBJECT
@@ -42,21 +45,24 @@ private:
 
 	void CreateAndConnectActions();
 
+	/** Copies the selected log lines to the clipboard */
+	void CopySelection();
+
 	QTabWidget* m_tabWidget;
 
 	std::unique_ptr<find_dialog> m_find_dialog;
 
 	QList<QColor> m_color;
-	QColor m_color_stack;
-	QTextEdit* m_log;
+	QListView* m_log;
+	log_model* m_log_model;
 	QTextEdit* m_tty;
-	QString m_old_text;
-	ullong m_log_counter;
 	bool m_stack_log;
 
 	fs::file m_tty_file;
 
 	QAction* m_clearAct;
+	QAction* m_copyAct;
+	QAction* m_selectAllAct;
 	QAction* m_clearTTYAct;
 
 	QActionGroup* m_logLevels;
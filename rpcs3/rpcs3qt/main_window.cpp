@@ -393,6 +393,23 @@ void main_window::BootRsxCapture()
 		LOG_SUCCESS(LOADER, "Capture Boot Success");
 }
 
+void main_window::BootPrecompile()
+{
+	if (QMessageBox::question(this, tr("Precompile Game Library"), tr("Build the PPU and SPU caches of every game in the game list?\nThe running game is stopped, this may take a long time."),
+		QMessageBox::Yes | QMessageBox::No, QMessageBox::No) != QMessageBox::Yes)
+	{
+		return;
+	}
+
+	Emu.SetForceBoot(true);
+	Emu.Stop();
+
+	if (!Emu.BootPrecompile({}, false))
+	{
+		LOG_ERROR(GENERAL, "Precompilation found no games");
+	}
+}
+
 void main_window::InstallPkg(const QString& dropPath)
 {
 	QString filePath = dropPath;
@@ -542,15 +559,26 @@ void main_window::InstallPup(const QString& dropPath)
 
 	// Synchronization variable
 	atomic_t<int> progress(0);
+
+	// Error code set by the first failing package (1: invalid PUP contents, 2: invalid TAR contents)
+	atomic_t<u32> error{0};
 	{
 		// Run asynchronously
 		scope_thread worker("Firmware Installer", [&]
 		{
-			for (const auto& updatefilename : updatefilenames)
+			// The update TAR shares one stream, so only the lookups are serialized
+			std::mutex tar_mutex;
+
+			// Decrypt and extract the packages in parallel, writes of one package overlap the decryption of others
+			thread_pool::parallel_for(::size32(updatefilenames), [&](u32 index)
 			{
-				if (progress == -1) break;
+				if (progress < 0) return;
 
-				fs::file updatefile = update_files.get_file(updatefilename);
+				fs::file updatefile;
+				{
+					std::lock_guard<std::mutex> lock(tar_mutex);
+					updatefile = update_files.get_file(updatefilenames[index]);
+				}
 
 				SCEDecrypter self_dec(updatefile);
 				self_dec.LoadHeaders();
@@ -560,26 +588,28 @@ void main_window::InstallPup(const QString& dropPath)
 				auto dev_flash_tar_f = self_dec.MakeFile();
 				if (dev_flash_tar_f.size() < 3)
 				{
-					LOG_ERROR(GENERAL, "Error while installing firmware: PUP contents are invalid.");
-					QMessageBox::critical(this, tr("Failure!"), tr("Error while installing firmware: PUP contents are invalid."));
+					error.compare_and_swap(0, 1);
 					progress = -1;
+					return;
 				}
 
 				tar_object dev_flash_tar(dev_flash_tar_f[2]);
 				if (!dev_flash_tar.extract(g_cfg.vfs.get_dev_flash(), "dev_flash/"))
 				{
-					LOG_ERROR(GENERAL, "Error while installing firmware: TAR contents are invalid.");
-					QMessageBox::critical(this, tr("Failure!"), tr("Error while installing firmware: TAR contents are invalid."));
+					error.compare_and_swap(0, 2);
 					progress = -1;
+					return;
 				}
 
-				if (progress >= 0)
-					progress += 1;
-			}
+				progress.atomic_op([](int& value)
+				{
+					if (value >= 0) value++;
+				});
+			});
 		});
 
 		// Wait for the completion
-		while (std::this_thread::sleep_for(5ms), std::abs(progress) < pdlg.maximum())
+		while (std::this_thread::sleep_for(5ms), progress >= 0 && progress < pdlg.maximum())
 		{
 			if (pdlg.wasCanceled())
 			{
@@ -591,9 +621,6 @@ void main_window::InstallPup(const QString& dropPath)
 			QCoreApplication::processEvents();
 		}
 
-		update_files_f.close();
-		pup_f.close();
-
 		if (progress > 0)
 		{
 			pdlg.SetValue(pdlg.maximum());
@@ -601,6 +628,21 @@ void main_window::InstallPup(const QString& dropPath)
 		}
 	}
 
+	update_files_f.close();
+	pup_f.close();
+
+	switch (error)
+	{
+	case 1:
+		LOG_ERROR(GENERAL, "Error while installing firmware: PUP contents are invalid.");
+		QMessageBox::critical(this, tr("Failure!"), tr("Error while installing firmware: PUP contents are invalid."));
+		break;
+	case 2:
+		LOG_ERROR(GENERAL, "Error while installing firmware: TAR contents are invalid.");
+		QMessageBox::critical(this, tr("Failure!"), tr("Error while installing firmware: TAR contents are invalid."));
+		break;
+	}
+
 	if (progress > 0)
 	{
 		LOG_SUCCESS(GENERAL, "Successfully installed PS3 firmware version %s.", version_string);
@@ -1132,6 +1174,7 @@ void main_window::CreateConnects()
 	connect(ui->bootElfAct, &QAction::triggered, this, &main_window::BootElf);
 	connect(ui->bootGameAct, &QAction::triggered, this, &main_window::BootGame);
 	connect(ui->actionopen_rsx_capture, &QAction::triggered, this, &main_window::BootRsxCapture);
+	connect(ui->bootPrecompileAct, &QAction::triggered, this, &main_window::BootPrecompile);
 
 	connect(ui->bootRecentMenu, &QMenu::aboutToShow, [=]
 	{
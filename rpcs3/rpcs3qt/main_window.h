@@ -91,6 +91,7 @@ private Q_SLOTS:
 	void BootElf();
 	void BootGame();
 	void BootRsxCapture();
+	void BootPrecompile();
 	void DecryptSPRXLibraries();
 
 	void SaveWindowState();
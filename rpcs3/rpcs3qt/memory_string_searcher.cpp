@@ -1,7 +1,58 @@
-
 #include "memory_string_searcher.h"
 
-#include <QLabel>
+#include "Utilities/Thread.h"
+
+#include <QVBoxLayout>
+
+#include <cstring>
+#include <limits>
+
+enum search_mode : int
+{
+	search_string,
+	search_utf16,
+	search_hex,
+	search_u8,
+	search_u16,
+	search_u32,
+	search_u64,
+	search_f32,
+	search_f64,
+};
+
+// Memory is searched in chunks of this size, each chunk is one parallel task
+constexpr u32 s_chunk_size = 0x100000;
+
+// Find all occurrences of the pattern starting in [addr, addr + size), reading at most read_size bytes (the memory must be readable)
+static void search_range(u32 addr, u32 size, u32 read_size, const std::string& pattern, u32 align, std::vector<u32>& out)
+{
+	if (read_size < pattern.size())
+	{
+		return;
+	}
+
+	const u8* const base = static_cast<const u8*>(vm::base(addr));
+	const u8* const end = base + std::min<u32>(size, read_size - ::size32(pattern) + 1);
+	const u8 first = pattern[0];
+
+	for (const u8* ptr = base; ptr < end; ptr++)
+	{
+		// memchr is vectorized, so candidates for the first byte are found quickly
+		ptr = static_cast<const u8*>(std::memchr(ptr, first, end - ptr));
+
+		if (!ptr)
+		{
+			break;
+		}
+
+		const u32 found = addr + static_cast<u32>(ptr - base);
+
+		if (found % align == 0 && std::memcmp(ptr + 1, pattern.data() + 1, pattern.size() - 1) == 0)
+		{
+			out.push_back(found);
+		}
+	}
+}
 
 memory_string_searcher::memory_string_searcher(QWidget* parent)
 	: QDialog(parent)
@@ -14,63 +65,267 @@ memory_string_searcher::memory_string_searcher(QWidget* parent)
 	m_addr_line->setFixedWidth(QLabel("This is the very length of the lineedit due to hidpi reasons.").sizeHint().width());
 	m_addr_line->setPlaceholderText(tr("Search..."));
 
+	m_mode_box = new QComboBox(this);
+	m_mode_box->addItem(tr("String"), search_string);
+	m_mode_box->addItem(tr("UTF-16 String"), search_utf16);
+	m_mode_box->addItem(tr("Hex Bytes"), search_hex);
+	m_mode_box->addItem(tr("u8"), search_u8);
+	m_mode_box->addItem(tr("u16 (BE)"), search_u16);
+	m_mode_box->addItem(tr("u32 (BE)"), search_u32);
+	m_mode_box->addItem(tr("u64 (BE)"), search_u64);
+	m_mode_box->addItem(tr("f32 (BE)"), search_f32);
+	m_mode_box->addItem(tr("f64 (BE)"), search_f64);
+
 	QPushButton* button_search = new QPushButton(tr("&Search"), this);
 
+	m_button_narrow = new QPushButton(tr("&Narrow"), this);
+	m_button_narrow->setToolTip(tr("Only keep the results of the last search that now match the input"));
+	m_button_narrow->setEnabled(false);
+
+	m_status = new QLabel(this);
+
 	QHBoxLayout* hbox_panel = new QHBoxLayout();
 	hbox_panel->addWidget(m_addr_line);
+	hbox_panel->addWidget(m_mode_box);
 	hbox_panel->addWidget(button_search);
+	hbox_panel->addWidget(m_button_narrow);
 
-	setLayout(hbox_panel);
+	QVBoxLayout* vbox_panel = new QVBoxLayout();
+	vbox_panel->addLayout(hbox_panel);
+	vbox_panel->addWidget(m_status);
+
+	setLayout(vbox_panel);
 
 	connect(button_search, &QAbstractButton::clicked, this, &memory_string_searcher::OnSearch);
+	connect(m_button_narrow, &QAbstractButton::clicked, this, &memory_string_searcher::OnNarrow);
 
 	layout()->setSizeConstraint(QLayout::SetFixedSize);
 };
 
-void memory_string_searcher::OnSearch()
+bool memory_string_searcher::GetPattern(std::string& pattern, u32& align)
 {
-	const QString wstr = m_addr_line->text();
-	const char *str = wstr.toStdString().c_str();
-	const u32 len = wstr.length();
+	const QString text = m_addr_line->text();
 
-	LOG_NOTICE(GENERAL, "Searching for string %s", str);
+	bool ok = true;
 
-	// Search the address space for the string
-	u32 strIndex = 0;
-	u32 numFound = 0;
-	const auto area = vm::get(vm::main);
-	for (u32 addr = area->addr; addr < area->addr + area->size; addr++)
+	// Store a value as the guest sees it
+	const auto set_be = [&](auto value)
 	{
-		if (!vm::check_addr(addr))
+		const be_t<decltype(value)> data = value;
+		pattern.assign(reinterpret_cast<const char*>(&data), sizeof(data));
+		align = sizeof(data);
+	};
+
+	// Accept both unsigned and signed input for integers
+	const auto set_int = [&](auto type)
+	{
+		using T = decltype(type);
+
+		const qulonglong value = text.toULongLong(&ok, 0);
+
+		if (ok && value <= std::numeric_limits<T>::max())
 		{
-			strIndex = 0;
-			continue;
+			return set_be(static_cast<T>(value));
 		}
 
-		u8 byte = vm::read8(addr);
-		if (byte == str[strIndex])
+		const qlonglong svalue = text.toLongLong(&ok, 0);
+
+		if (ok && svalue < 0 && svalue >= std::numeric_limits<std::make_signed_t<T>>::min())
 		{
-			if (strIndex == len)
-			{
-				// Found it
-				LOG_NOTICE(GENERAL, "Found @ %04x", addr - len);
-				numFound++;
-				strIndex = 0;
-				continue;
-			}
+			return set_be(static_cast<T>(svalue));
+		}
+
+		ok = false;
+	};
+
+	pattern.clear();
+	align = 1;
 
-			strIndex++;
+	switch (m_mode_box->currentData().toInt())
+	{
+	case search_string:
+	{
+		pattern = text.toStdString();
+		break;
+	}
+	case search_utf16:
+	{
+		for (const QChar ch : text)
+		{
+			const be_t<u16> data = ch.unicode();
+			pattern.append(reinterpret_cast<const char*>(&data), sizeof(data));
 		}
-		else
+
+		break;
+	}
+	case search_hex:
+	{
+		QString hex = text;
+		hex.remove(' ');
+
+		if (hex.startsWith("0x", Qt::CaseInsensitive))
 		{
-			strIndex = 0;
+			hex.remove(0, 2);
 		}
 
-		if (addr % (1024 * 1024 * 64) == 0) // Log every 64mb
+		const QByteArray bytes = QByteArray::fromHex(hex.toLatin1());
+
+		// fromHex skips invalid characters, so reject anything that doesn't map to whole bytes
+		ok = hex.size() % 2 == 0 && bytes.size() * 2 == hex.size();
+		pattern.assign(bytes.constData(), bytes.size());
+		break;
+	}
+	case search_u8: set_int(u8{}); break;
+	case search_u16: set_int(u16{}); break;
+	case search_u32: set_int(u32{}); break;
+	case search_u64: set_int(u64{}); break;
+	case search_f32:
+	{
+		const float value = text.toFloat(&ok);
+		set_be(value);
+		break;
+	}
+	case search_f64:
+	{
+		const double value = text.toDouble(&ok);
+		set_be(value);
+		break;
+	}
+	default:
+	{
+		ok = false;
+	}
+	}
+
+	if (!ok || pattern.empty())
+	{
+		m_status->setText(tr("Invalid input for %0").arg(m_mode_box->currentText()));
+		return false;
+	}
+
+	return true;
+}
+
+void memory_string_searcher::ShowResults()
+{
+	// Don't flood the log with cheat-style searches for common values
+	const std::size_t shown = std::min<std::size_t>(m_results.size(), 256);
+
+	for (std::size_t i = 0; i < shown; i++)
+	{
+		LOG_NOTICE(GENERAL, "Found @ 0x%x", m_results[i]);
+	}
+
+	if (shown < m_results.size())
+	{
+		LOG_NOTICE(GENERAL, "... and %u more", m_results.size() - shown);
+	}
+
+	LOG_NOTICE(GENERAL, "Search completed (found %u matches)", m_results.size());
+
+	m_status->setText(tr("Found %0 matches").arg(m_results.size()));
+	m_button_narrow->setEnabled(!m_results.empty());
+}
+
+void memory_string_searcher::OnSearch()
+{
+	std::string pattern;
+	u32 align;
+
+	if (!GetPattern(pattern, align))
+	{
+		return;
+	}
+
+	LOG_NOTICE(GENERAL, "Searching for %s: %s", m_mode_box->currentText().toStdString(), m_addr_line->text().toStdString());
+
+	m_results.clear();
+
+	std::vector<std::shared_ptr<vm::block_t>> blocks;
+
+	for (u32 location = vm::main; location < vm::memory_location_max; location++)
+	{
+		if (const auto block = vm::get(static_cast<vm::memory_location_t>(location)))
+		{
+			blocks.emplace_back(block);
+		}
+	}
+
+	// Keep the mappings stable while the memory is read
+	vm::reader_lock lock;
+
+	// Collect the allocated ranges of all memory locations and split them into chunks
+	struct chunk
+	{
+		u32 addr;
+		u32 size;
+		u32 read_size;
+	};
+
+	std::vector<chunk> chunks;
+
+	for (const auto& block : blocks)
+	{
+		for (u64 addr = block->addr, block_end = u64{block->addr} + block->size; addr < block_end;)
 		{
-			LOG_NOTICE(GENERAL, "Searching %04x ...", addr);
+			if (!vm::check_addr(static_cast<u32>(addr), 4096))
+			{
+				addr += 4096;
+				continue;
+			}
+
+			u64 end = addr + 4096;
+
+			while (end < block_end && vm::check_addr(static_cast<u32>(end), 4096))
+			{
+				end += 4096;
+			}
+
+			// A chunk reads past its end so that matches crossing into the next chunk are found
+			for (u64 pos = addr; pos < end; pos += s_chunk_size)
+			{
+				const u32 size = static_cast<u32>(std::min<u64>(s_chunk_size, end - pos));
+				const u32 read_size = static_cast<u32>(std::min<u64>(u64{size} + pattern.size() - 1, end - pos));
+				chunks.push_back({static_cast<u32>(pos), size, read_size});
+			}
+
+			addr = end;
 		}
 	}
 
-	LOG_NOTICE(GENERAL, "Search completed (found %d matches)", numFound);
+	std::vector<std::vector<u32>> results(chunks.size());
+
+	thread_pool::parallel_for(::size32(chunks), [&](u32 i)
+	{
+		search_range(chunks[i].addr, chunks[i].size, chunks[i].read_size, pattern, align, results[i]);
+	});
+
+	for (const auto& result : results)
+	{
+		m_results.insert(m_results.end(), result.begin(), result.end());
+	}
+
+	ShowResults();
+}
+
+void memory_string_searcher::OnNarrow()
+{
+	std::string pattern;
+	u32 align;
+
+	if (!GetPattern(pattern, align))
+	{
+		return;
+	}
+
+	LOG_NOTICE(GENERAL, "Narrowing %u results to %s: %s", m_results.size(), m_mode_box->currentText().toStdString(), m_addr_line->text().toStdString());
+
+	vm::reader_lock lock;
+
+	m_results.erase(std::remove_if(m_results.begin(), m_results.end(), [&](u32 addr)
+	{
+		return addr % align || !vm::check_addr(addr, ::size32(pattern)) || std::memcmp(vm::base(addr), pattern.data(), pattern.size()) != 0;
+	}), m_results.end());
+
+	ShowResults();
 }
@@ -7,6 +7,8 @@
 #include <QDialog>
 #include <QLineEdit>
 #include <QPushButton>
+#include <QComboBox>
+#include <QLabel>
 #include <QHBoxLayout>
 
 class memory_string_searcher : public QDialog
@@ -14,10 +16,22 @@ class memory_string_searcher : public QDialog
 	Q_OBJECT
 
 	QLineEdit* m_addr_line;
+	QComboBox* m_mode_box;
+	QPushButton* m_button_narrow;
+	QLabel* m_status;
+
+	// Addresses found by the last search, used to narrow the results down
+	std::vector<u32> m_results;
+
+	/** Converts the input to the searched bytes for the selected mode, returns false if the input is invalid */
+	bool GetPattern(std::string& pattern, u32& align);
+
+	void ShowResults();
 
 public:
 	memory_string_searcher(QWidget* parent);
 
 private Q_SLOTS:
 	void OnSearch();
+	void OnNarrow();
 };
@@ -2,6 +2,8 @@
 #include "rsx_debugger.h"
 #include "qt_utils.h"
 
+#include "Utilities/Thread.h"
+
 enum GCMEnumTypes
 {
 	CELL_GCM_ENUM,
@@ -412,78 +414,140 @@ void Buffer::ShowWindowed()
 
 namespace
 {
-	std::array<u8, 3> get_value(gsl::span<const gsl::byte> orig_buffer, rsx::surface_color_format format, size_t idx)
+	// Converts a preview in bands of rows on the thread pool, func(row, dst) writes one row of RGB32 pixels
+	template <typename F>
+	QImage convert_rows(u32 width, u32 height, F&& func)
 	{
-		switch (format)
-		{
-		case rsx::surface_color_format::b8:
+		QImage image(static_cast<int>(width), static_cast<int>(height), QImage::Format_RGB32);
+
+		if (image.isNull())
 		{
-			u8 value = gsl::as_span<const u8>(orig_buffer)[idx];
-			return{ value, value, value };
+			return image;
 		}
-		case rsx::surface_color_format::x32:
+
+		// Row pointers are taken here, scanLine() would detach the image concurrently
+		uchar* const bits = image.bits();
+		const int stride = image.bytesPerLine();
+		const u32 bands = std::min<u32>(height, thread_pool::get_thread_count() * 4);
+
+		thread_pool::parallel_for(bands, [&](u32 band)
 		{
-			be_t<u32> stored_val = gsl::as_span<const be_t<u32>>(orig_buffer)[idx];
-			u32 swapped_val = stored_val;
-			f32 float_val = (f32&)swapped_val;
-			u8 val = float_val * 255.f;
-			return{ val, val, val };
-		}
+			for (u32 row = height * band / bands, end = height * (band + 1) / bands; row < end; row++)
+			{
+				func(row, reinterpret_cast<u32*>(bits + std::size_t{row} * stride));
+			}
+		});
+
+		return image;
+	}
+
+	constexpr u32 to_gray(u8 value)
+	{
+		return 0xff000000 | value * 0x010101u;
+	}
+
+	constexpr u8 to_unorm8(f32 value)
+	{
+		return value <= 0.f ? 0 : value >= 1.f ? 255 : static_cast<u8>(value * 255.f);
+	}
+
+	/**
+	 * Return a QImage of the captured color buffer, or a null image if the format can't be displayed.
+	 * The format is dispatched once per row so that the pixel loops stay simple enough to be vectorized.
+	 */
+	QImage convert_to_QImage(rsx::surface_color_format format, gsl::span<const gsl::byte> orig_buffer, u32 width, u32 height)
+	{
+		u32 bpp;
+
+		switch (format)
+		{
+		case rsx::surface_color_format::b8: bpp = 1; break;
+		case rsx::surface_color_format::x32:
 		case rsx::surface_color_format::a8b8g8r8:
 		case rsx::surface_color_format::x8b8g8r8_o8b8g8r8:
 		case rsx::surface_color_format::x8b8g8r8_z8b8g8r8:
-		{
-			auto ptr = gsl::as_span<const u8>(orig_buffer);
-			return{ ptr[1 + idx * 4], ptr[2 + idx * 4], ptr[3 + idx * 4] };
-		}
 		case rsx::surface_color_format::a8r8g8b8:
 		case rsx::surface_color_format::x8r8g8b8_o8r8g8b8:
-		case rsx::surface_color_format::x8r8g8b8_z8r8g8b8:
-		{
-			auto ptr = gsl::as_span<const u8>(orig_buffer);
-			return{ ptr[3 + idx * 4], ptr[2 + idx * 4], ptr[1 + idx * 4] };
+		case rsx::surface_color_format::x8r8g8b8_z8r8g8b8: bpp = 4; break;
+		case rsx::surface_color_format::w16z16y16x16: bpp = 8; break;
+		default: return {};
 		}
-		case rsx::surface_color_format::w16z16y16x16:
+
+		if (static_cast<std::size_t>(orig_buffer.size_bytes()) < std::size_t{width} * height * bpp)
 		{
-			auto ptr = gsl::as_span<const u16>(orig_buffer);
-			f16 h0 = f16(ptr[4 * idx]);
-			f16 h1 = f16(ptr[4 * idx + 1]);
-			f16 h2 = f16(ptr[4 * idx + 2]);
-			f32 f0 = float(h0);
-			f32 f1 = float(h1);
-			f32 f2 = float(h2);
-
-			u8 val0 = f0 * 255.;
-			u8 val1 = f1 * 255.;
-			u8 val2 = f2 * 255.;
-			return{ val0, val1, val2 };
-		}
-		case rsx::surface_color_format::g8b8:
-		case rsx::surface_color_format::r5g6b5:
-		case rsx::surface_color_format::x1r5g5b5_o1r5g5b5:
-		case rsx::surface_color_format::x1r5g5b5_z1r5g5b5:
-		case rsx::surface_color_format::w32z32y32x32:
-		default:
-			fmt::throw_exception("Unsupported format for display" HERE);
+			return {};
 		}
-	}
 
-	/**
-	 * Return a new buffer that can be passed to QImage.
-	 */
-	u8* convert_to_QImage_buffer(rsx::surface_color_format format, gsl::span<const gsl::byte> orig_buffer, size_t width, size_t height) noexcept
-	{
-		unsigned char* buffer = (unsigned char*)malloc(width * height * 4);
-		for (u32 i = 0; i < width * height; i++)
+		const u8* const data = reinterpret_cast<const u8*>(orig_buffer.data());
+
+		return convert_rows(width, height, [&](u32 row, u32* dst)
 		{
-			// depending on original buffer, the colors may need to be reversed
-			const auto &colors = get_value(orig_buffer, format, i);
-			buffer[0 + i * 4] = colors[0];
-			buffer[1 + i * 4] = colors[1];
-			buffer[2 + i * 4] = colors[2];
-			buffer[3 + i * 4] = 255;
-		}
-		return buffer;
+			const u8* const line = data + std::size_t{row} * width * bpp;
+
+			switch (format)
+			{
+			case rsx::surface_color_format::b8:
+			{
+				for (u32 x = 0; x < width; x++)
+				{
+					dst[x] = to_gray(line[x]);
+				}
+				break;
+			}
+			case rsx::surface_color_format::x32:
+			{
+				const auto src = reinterpret_cast<const be_t<f32>*>(line);
+
+				for (u32 x = 0; x < width; x++)
+				{
+					dst[x] = to_gray(to_unorm8(src[x]));
+				}
+				break;
+			}
+			case rsx::surface_color_format::a8b8g8r8:
+			case rsx::surface_color_format::x8b8g8r8_o8b8g8r8:
+			case rsx::surface_color_format::x8b8g8r8_z8b8g8r8:
+			{
+				// Bytes A, B, G, R become B, G, R in the low bytes of the pixel
+				const auto src = reinterpret_cast<const u32*>(line);
+
+				for (u32 x = 0; x < width; x++)
+				{
+					dst[x] = 0xff000000 | src[x] >> 8;
+				}
+				break;
+			}
+			case rsx::surface_color_format::a8r8g8b8:
+			case rsx::surface_color_format::x8r8g8b8_o8r8g8b8:
+			case rsx::surface_color_format::x8r8g8b8_z8r8g8b8:
+			{
+				const auto src = reinterpret_cast<const be_t<u32>*>(line);
+
+				for (u32 x = 0; x < width; x++)
+				{
+					dst[x] = 0xff000000 | src[x];
+				}
+				break;
+			}
+			case rsx::surface_color_format::w16z16y16x16:
+			{
+				const auto src = reinterpret_cast<const u16*>(line);
+
+				for (u32 x = 0; x < width; x++)
+				{
+					const u8 val0 = to_unorm8(float(f16(src[x * 4 + 0])));
+					const u8 val1 = to_unorm8(float(f16(src[x * 4 + 1])));
+					const u8 val2 = to_unorm8(float(f16(src[x * 4 + 2])));
+					dst[x] = 0xff000000 | val2 << 16 | val1 << 8 | val0;
+				}
+				break;
+			}
+			default:
+			{
+				break;
+			}
+			}
+		});
 	}
 };
 
@@ -508,8 +572,7 @@ void rsx_debugger::OnClickDrawCalls()
 	{
 		if (width && height && !draw_call.color_buffer[i].empty())
 		{
-			unsigned char* buffer = convert_to_QImage_buffer(draw_call.state.surface_color(), draw_call.color_buffer[i], width, height);
-			buffers[i]->showImage(QImage(buffer, (int)width, (int)height, QImage::Format_RGB32));
+			buffers[i]->showImage(convert_to_QImage(draw_call.state.surface_color(), draw_call.color_buffer[i], width, height));
 		}
 	}
 
@@ -517,40 +580,32 @@ void rsx_debugger::OnClickDrawCalls()
 	{
 		if (width && height && !draw_call.depth_stencil[0].empty())
 		{
-			gsl::span<const gsl::byte> orig_buffer = draw_call.depth_stencil[0];
-			unsigned char *buffer = (unsigned char *)malloc(width * height * 4);
+			const auto data = reinterpret_cast<const u8*>(draw_call.depth_stencil[0].data());
 
 			if (draw_call.state.surface_depth_fmt() == rsx::surface_depth_format::z24s8)
 			{
-				for (u32 row = 0; row < height; row++)
+				m_buffer_depth->showImage(convert_rows(width, height, [&](u32 row, u32* dst)
 				{
+					const auto src = reinterpret_cast<const u32*>(data) + std::size_t{row} * width;
+
 					for (u32 col = 0; col < width; col++)
 					{
-						u32 depth_val = gsl::as_span<const u32>(orig_buffer)[row * width + col];
-						u8 displayed_depth_val = 255 * depth_val / 0xFFFFFF;
-						buffer[4 * col + 0 + width * row * 4] = displayed_depth_val;
-						buffer[4 * col + 1 + width * row * 4] = displayed_depth_val;
-						buffer[4 * col + 2 + width * row * 4] = displayed_depth_val;
-						buffer[4 * col + 3 + width * row * 4] = 255;
+						dst[col] = to_gray(255 * src[col] / 0xFFFFFF);
 					}
-				}
+				}));
 			}
 			else
 			{
-				for (u32 row = 0; row < height; row++)
+				m_buffer_depth->showImage(convert_rows(width, height, [&](u32 row, u32* dst)
 				{
+					const auto src = reinterpret_cast<const u16*>(data) + std::size_t{row} * width;
+
 					for (u32 col = 0; col < width; col++)
 					{
-						u16 depth_val = gsl::as_span<const u16>(orig_buffer)[row * width + col];
-						u8 displayed_depth_val = 255 * depth_val / 0xFFFF;
-						buffer[4 * col + 0 + width * row * 4] = displayed_depth_val;
-						buffer[4 * col + 1 + width * row * 4] = displayed_depth_val;
-						buffer[4 * col + 2 + width * row * 4] = displayed_depth_val;
-						buffer[4 * col + 3 + width * row * 4] = 255;
+						dst[col] = to_gray(255 * src[col] / 0xFFFF);
 					}
-				}
+				}));
 			}
-			m_buffer_depth->showImage(QImage(buffer, (int)width, (int)height, QImage::Format_RGB32));
 		}
 	}
 
@@ -558,21 +613,17 @@ void rsx_debugger::OnClickDrawCalls()
 	{
 		if (width && height && !draw_call.depth_stencil[1].empty())
 		{
-			gsl::span<const gsl::byte> orig_buffer = draw_call.depth_stencil[1];
-			unsigned char *buffer = (unsigned char *)malloc(width * height * 4);
+			const auto data = reinterpret_cast<const u8*>(draw_call.depth_stencil[1].data());
 
-			for (u32 row = 0; row < height; row++)
+			m_buffer_stencil->showImage(convert_rows(width, height, [&](u32 row, u32* dst)
 			{
+				const u8* src = data + std::size_t{row} * width;
+
 				for (u32 col = 0; col < width; col++)
 				{
-					u8 stencil_val = gsl::as_span<const u8>(orig_buffer)[row * width + col];
-					buffer[4 * col + 0 + width * row * 4] = stencil_val;
-					buffer[4 * col + 1 + width * row * 4] = stencil_val;
-					buffer[4 * col + 2 + width * row * 4] = stencil_val;
-					buffer[4 * col + 3 + width * row * 4] = 255;
+					dst[col] = to_gray(src[col]);
 				}
-			}
-			m_buffer_stencil->showImage(QImage(buffer, (int)width, (int)height, QImage::Format_RGB32));
+			}));
 		}
 	}
 
@@ -680,26 +731,24 @@ void rsx_debugger::GetBuffers()
 		auto buffers = render->display_buffers;
 		u32 RSXbuffer_addr = render->local_mem_addr + buffers[bufferId].offset;
 
-		if(!vm::check_addr(RSXbuffer_addr))
-			continue;
-
-		auto RSXbuffer = vm::_ptr<u8>(RSXbuffer_addr);
-
 		u32 width  = buffers[bufferId].width;
 		u32 height = buffers[bufferId].height;
-		unsigned char* buffer = (unsigned char*)malloc(width * height * 4);
+
+		if (!width || !height || !vm::check_addr(RSXbuffer_addr, width * height * 4))
+			continue;
+
+		auto RSXbuffer = vm::_ptr<const u32>(RSXbuffer_addr);
 
 		// ABGR to ARGB and flip vertically
-		for (u32 y=0; y<height; y++)
+		QImage image = convert_rows(width, height, [&](u32 y, u32* dst)
 		{
-			for (u32 i=0, j=0; j<width*4; i+=4, j+=4)
+			const u32* src = RSXbuffer + std::size_t{height - y - 1} * width;
+
+			for (u32 x = 0; x < width; x++)
 			{
-				buffer[i+0 + y*width*4] = RSXbuffer[j+1 + (height-y-1)*width*4];	//B
-				buffer[i+1 + y*width*4] = RSXbuffer[j+2 + (height-y-1)*width*4];	//G
-				buffer[i+2 + y*width*4] = RSXbuffer[j+3 + (height-y-1)*width*4];	//R
-				buffer[i+3 + y*width*4] = RSXbuffer[j+0 + (height-y-1)*width*4];	//A
+				dst[x] = src[x] >> 8 | src[x] << 24;
 			}
-		}
+		});
 
 		// TODO: Is there any better way to clasify the color buffers? How can we include the depth and stencil buffers?
 		Buffer* pnl;
@@ -710,7 +759,7 @@ void rsx_debugger::GetBuffers()
 		case 2:  pnl = m_buffer_colorC; break;
 		default: pnl = m_buffer_colorD; break;
 		}
-		pnl->showImage(QImage(buffer, width, height, QImage::Format_RGB32));
+		pnl->showImage(image);
 	}
 
 	// Draw Texture